@@ -3,6 +3,9 @@ def add_file_downloads(confs : dict) -> list:
         @param confs kconfig vars, dict type
         @return list type, items is dict type
     '''
+    # linux use local onnxruntime, version configs only have defaults for MaixCAM and MaixCAM2
+    if not confs.get('PLATFORM_MAIXCAM', None) and not confs.get('PLATFORM_MAIXCAM2', None):
+        return []
     version = f"{confs['CONFIG_ONNXRUNTIME_VERSION_MAJOR']}.{confs['CONFIG_ONNXRUNTIME_VERSION_MINOR']}.{confs['CONFIG_ONNXRUNTIME_VERSION_PATCH']}"
     if confs.get('PLATFORM_MAIXCAM', None):
         url = f"https://github.com/sipeed/MaixCDK/releases/download/v0.0.0/sg2002_onnxruntime_v{version}.tar.xz"
@@ -58,4 +61,4 @@ def add_file_downloads(confs : dict) -> list:
                 'rename': rename
             }
         ]
-
+    return []
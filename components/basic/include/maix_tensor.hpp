@@ -18,6 +18,8 @@
 #include <tuple>
 #include <map>
 #include <valarray>
+#include <functional>
+#include <memory>
 #include "maix_log.hpp"
 #include "maix_err.hpp"
 
@@ -162,6 +164,24 @@ namespace maix
                 // log::info("new tensor: %p", this);
             }
 
+            /**
+             * Tensor constructor, wrap external data(e.g. image pixels, numpy array) without copy and share its ownership.
+             * @param shape tensor shape, a int list
+             * @param dtype tensor element data type, see DType of this module
+             * @param data pointer to data content, must be valid until release is called.
+             * @param release called once when this tensor and all its copies are destroyed, can capture the data owner to keep data alive.
+             * @maixcdk maix.tensor.Tensor.Tensor
+             */
+            Tensor(std::vector<int> shape, tensor::DType dtype, void *data, const std::function<void()> &release)
+            {
+                _shape = shape;
+                _dtype = dtype;
+                _data = data;
+                _is_alloc = false;
+                if (release)
+                    _owner = std::shared_ptr<void>(nullptr, [release](void *) { release(); });
+            }
+
             ~Tensor()
             {
                 // log::info("free tensor: %p", this);
@@ -420,6 +440,7 @@ namespace maix
             DType _dtype;
             void *_data;
             bool _is_alloc;
+            std::shared_ptr<void> _owner; // keep external data alive, nullptr if data not wrapped with owner
 
         private:
             template <typename T>
@@ -401,9 +401,34 @@ namespace maix::nn
          */
         tensor::Tensors *forward_image(image::Image &img, std::vector<float> mean = std::vector<float>(), std::vector<float> scale = std::vector<float>(), image::Fit fit = image::Fit::FIT_FILL, bool copy_result = true, bool dual_buff_wait = false, bool chw = true);
 
+        /**
+         * forward model with multiple images or multiple ROIs of one image, e.g. all faces or hands detected in one frame.
+         * Crop and resize of all images run in multiple threads.
+         * If model have dynamic or fixed batch dimension(like ONNX model on Linux), images are forwarded in one batch(or batches of fixed batch size),
+         * else images are forwarded one by one, if dual buff enabled, they are pipelined: next image's input is prepared while current image is running.
+         * In dual buff mode, result of the input forwarded before this call is dropped, and the last image is run once more in background to get its result,
+         * so the next forward not waiting result after this call returns nullptr(not ready).
+         * @param imgs input images.
+         * @param mean mean value, same as forward_image.
+         * @param scale scale value, same as forward_image.
+         * @param fit fit mode, same as forward_image, default image.Fit.FIT_FILL.
+         * @param rois region of interest list, [x0, y0, w0, h0, x1, y1, w1, h1, ...], default empty means whole image.
+         *             If imgs only have one image, every ROI is cropped from it, else ROI number should equal to images number, one ROI for one image.
+         * @param copy_result same as forward_image, if false, result of the last image may use internal memory, valid until next forward,
+         *                    results of other images are always copied as internal memory is reused by every forward.
+         * @param chw same as forward_image.
+         * @return output tensors list, one for every image or ROI, in input order. In C++, you should manually delete every element in return value.
+         * @throw If error occurs, like arg error or alloc memory failed, will raise err.Exception.
+         * @maixpy maix.nn.NN.forward_batch
+         */
+        std::vector<tensor::Tensors *> forward_batch(std::vector<image::Image *> &imgs, std::vector<float> mean = std::vector<float>(), std::vector<float> scale = std::vector<float>(), image::Fit fit = image::Fit::FIT_FILL, std::vector<int> rois = std::vector<int>(), bool copy_result = true, bool chw = true);
+
     private:
         MUD _mud;
         NNBase *_impl;
+        bool _dual_buff;
+        bool _drop_pending; // result of the next not waiting forward is the extra run of forward_batch, should be dropped
+        bool _drop_result(bool dual_buff_wait);
     };
 
 }; // namespace maix::nn
@@ -242,47 +242,23 @@ namespace maix::nn
             {
                 throw err::Exception("output tensor dtype only support float32 now");
             }
-            // convert to rgb
-            auto convert_image_with_cmap = [](float *data, int w, int h, image::CMap cmap){
-                auto &colors = image::cmap_colors_rgb(cmap);
-                image::Image *result = new image::Image(w, h, image::Format::FMT_RGB888);
-                float max_v = data[0];
-                float min_v = data[0];
-                for(int i = 1; i < w * h; ++i)
-                {
-                    if (data[i] > max_v)
-                        max_v = data[i];
-                    else if (data[i] < min_v)
-                        min_v = data[i];
-                }
-                if(min_v == max_v)
-                {
-                    memset(result->data(), 127, w * h * 3);
-                }
-                else
+            // convert to rgb, FIT_FILL resize in the same pass
+            image::Image *result;
+            if(fit == image::FIT_FILL)
+            {
+                result = image::from_float((float*)tensor->data(), input_width(), input_height(), 0, 0, cmap, image::Size(img.width(), img.height()));
+            }
+            else
+            {
+                result = image::from_float((float*)tensor->data(), input_width(), input_height(), 0, 0, cmap);
+                // check need resize
+                if(img.width() * img.height() != tensor->size_int())
                 {
-                    float scale = 255.0f / (max_v - min_v);
-                    uint8_t *img_data = (uint8_t*)result->data();
-                    #pragma omp parallel for
-                    for(int i = 0; i < w * h; ++i)
-                    {
-                        uint8_t gray = static_cast<uint8_t>(std::clamp((data[i] - min_v) * scale, 0.0f, 255.0f));
-                        auto &rgb = colors[gray];
-                        img_data[3 * i] = rgb[0];
-                        img_data[3 * i + 1] = rgb[1];
-                        img_data[3 * i + 2] = rgb[2];
-                    }
+                    image::Fit fit_r = fit == image::FIT_CONTAIN ? image::FIT_COVER : image::FIT_CONTAIN;
+                    image::Image *result2 = result->resize(img.width(), img.height(), fit_r);
+                    delete result;
+                    result = result2;
                 }
-                return result;
-            };
-            image::Image *result = convert_image_with_cmap((float*)tensor->data(), input_width(), input_height(), cmap);
-            // check need resize
-            if(img.width() * img.height() != tensor->size_int())
-            {
-                image::Fit fit_r = (fit == image::FIT_FILL) ? fit : (fit == image::FIT_CONTAIN ? image::FIT_COVER : image::FIT_CONTAIN);
-                image::Image *result2 = result->resize(img.width(), img.height(), fit_r);
-                delete result;
-                result = result2;
             }
             delete outputs;
             return result;
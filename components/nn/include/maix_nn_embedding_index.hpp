@@ -0,0 +1,165 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add EmbeddingIndex, normalized contiguous float32/float16/int8 embeddings, SIMD cosine top-k search,
+ *                     IVF approximate search and mmap-able file format.
+ */
+
+#pragma once
+
+#include "maix_basic.hpp"
+#include <vector>
+#include <string>
+
+namespace maix::nn
+{
+    /**
+     * Storage data type of embeddings in EmbeddingIndex
+     * @maixpy maix.nn.EmbeddingDType
+     */
+    enum EmbeddingDType
+    {
+        EMBEDDING_FLOAT32 = 0, // 4 bytes every element, exact
+        EMBEDDING_FLOAT16 = 1, // 2 bytes every element, half of memory, cosine error about 1e-4
+        EMBEDDING_INT8 = 2,    // 1 byte every element, scaled by max abs value of every embedding, cosine error about 1e-3
+    };
+
+    /**
+     * Index of embeddings(feature vectors) for cosine similarity search, e.g. face features of FaceRecognizer.
+     * Embeddings are L2 normalized when added and stored in one contiguous matrix, so cosine is only a dot product
+     * calculated with SIMD, rows are split to blocks searched in multiple threads.
+     * Optional IVF(inverted file) index clusters embeddings, search only scans the nearest nprobe clusters.
+     * Index can be saved to file and loaded with mmap, so large index is not read to memory.
+     * Search uses internal buffers, don't search the same index in multiple threads at the same time.
+     * @maixpy maix.nn.EmbeddingIndex
+     */
+    class EmbeddingIndex
+    {
+    public:
+        /**
+         * EmbeddingIndex constructor
+         * @param dim embedding dimension, 0 means set by the first added embedding, default 0.
+         * @param dtype storage data type, default nn.EmbeddingDType.EMBEDDING_FLOAT32.
+         * @maixpy maix.nn.EmbeddingIndex.__init__
+         * @maixcdk maix.nn.EmbeddingIndex.EmbeddingIndex
+         */
+        EmbeddingIndex(int dim = 0, nn::EmbeddingDType dtype = nn::EmbeddingDType::EMBEDDING_FLOAT32);
+
+        ~EmbeddingIndex();
+
+        /**
+         * Add embedding, it's normalized and converted to storage data type, and added to the nearest cluster if IVF built.
+         * @param embedding embedding, length must be dim.
+         * @return index of added embedding, the same as size() - 1.
+         * @throw err::Exception if length is not equal to dim.
+         * @maixpy maix.nn.EmbeddingIndex.add
+         */
+        int add(const std::vector<float> &embedding);
+
+        /**
+         * Add embedding, same as add of vector.
+         * @maixcdk maix.nn.EmbeddingIndex.add
+         */
+        int add(const float *embedding, int dim);
+
+        /**
+         * Remove embedding, indexes of embeddings after it decrease by 1, order is kept.
+         * @param idx index of embedding, [0, size()).
+         * @return err.Err, ERR_ARGS if idx invalid.
+         * @maixpy maix.nn.EmbeddingIndex.remove
+         */
+        err::Err remove(int idx);
+
+        /**
+         * Remove all embeddings and IVF index.
+         * @maixpy maix.nn.EmbeddingIndex.clear
+         */
+        void clear();
+
+        /**
+         * Number of embeddings
+         * @maixpy maix.nn.EmbeddingIndex.size
+         */
+        int size();
+
+        /**
+         * Embedding dimension, 0 if not set
+         * @maixpy maix.nn.EmbeddingIndex.dim
+         */
+        int dim();
+
+        /**
+         * Storage data type
+         * @maixpy maix.nn.EmbeddingIndex.dtype
+         */
+        nn::EmbeddingDType dtype();
+
+        /**
+         * Get normalized embedding, converted back to float.
+         * @param idx index of embedding, [0, size()).
+         * @throw err::Exception if idx invalid.
+         * @maixpy maix.nn.EmbeddingIndex.get
+         */
+        std::vector<float> get(int idx);
+
+        /**
+         * Build IVF index by spherical k-means, embeddings added later are put to the nearest cluster,
+         * rebuild it after many embeddings added or removed.
+         * @param nlist cluster number, 0 means sqrt(size()), <= size(), default 0.
+         * @param iters k-means iterations, default 10.
+         * @return err.Err, ERR_NOT_READY if index empty.
+         * @maixpy maix.nn.EmbeddingIndex.build_ivf
+         */
+        err::Err build_ivf(int nlist = 0, int iters = 10);
+
+        /**
+         * IVF cluster number, 0 if IVF not built.
+         * @maixpy maix.nn.EmbeddingIndex.nlist
+         */
+        int nlist();
+
+        /**
+         * Search the most similar embeddings of query.
+         * @param query query embedding, length must be dim, not need to be normalized.
+         * @param k max result number, default 1.
+         * @param nprobe search nprobe nearest IVF clusters, 0 or IVF not built means search all embeddings(exact), default 0.
+         * @return list of (index, cosine similarity), sorted by similarity from high to low, index ascending if similarity equal.
+         * @throw err::Exception if length of query is not equal to dim.
+         * @maixpy maix.nn.EmbeddingIndex.search
+         */
+        std::vector<std::pair<int, float>> search(const std::vector<float> &query, int k = 1, int nprobe = 0);
+
+        /**
+         * Search the most similar embeddings of query, same as search of vector.
+         * @param idxes output indexes, k ints at least.
+         * @param scores output cosine similarities, k floats at least.
+         * @return result number, <= k.
+         * @maixcdk maix.nn.EmbeddingIndex.search
+         */
+        int search(const float *query, int dim, int k, int *idxes, float *scores, int nprobe = 0);
+
+        /**
+         * Save index to file, file is header, embedding matrix, int8 scales, IVF clusters,
+         * every part is aligned and stored as in memory, so it can be loaded with mmap.
+         * @param path file path.
+         * @return err.Err
+         * @maixpy maix.nn.EmbeddingIndex.save
+         */
+        err::Err save(const std::string &path);
+
+        /**
+         * Load index from file saved by save.
+         * @param path file path.
+         * @param mmap map embedding matrix of file to memory instead of reading, pages are loaded when searched,
+         *             matrix is copied to memory when index modified. Default true.
+         * @return err.Err
+         * @maixpy maix.nn.EmbeddingIndex.load
+         */
+        err::Err load(const std::string &path, bool mmap = true);
+
+    private:
+        void *_handle;
+    };
+
+} // namespace maix::nn
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2024.5.17: Create this file.
+ * @update 2026.10.19: Search features with EmbeddingIndex, load and save faces file in one read and write.
  */
 
 #pragma once
@@ -15,6 +16,7 @@
 #include "maix_nn_face_detector.hpp"
 #include "maix_nn_retinaface.hpp"
 #include "maix_nn_yolov8.hpp"
+#include "maix_nn_embedding_index.hpp"
 
 #include <fstream>
 #include <sstream>
@@ -280,6 +282,7 @@ namespace maix::nn
             _facedetector_retina = nullptr;
             _facedetector_yolov8 = nullptr;
             _dual_buff = dual_buff;
+            _index = new nn::EmbeddingIndex();
             if (!detect_model.empty() && !feature_model.empty())
             {
                 err::Err e = load(detect_model, feature_model);
@@ -312,6 +315,8 @@ namespace maix::nn
                 delete _model_feature;
                 _model_feature = nullptr;
             }
+            delete _index;
+            _index = nullptr;
         }
 
         /**
@@ -532,34 +537,63 @@ namespace maix::nn
             else if (_facedetector_yolov8)
                 objs2 = _facedetector_yolov8->detect(img, _conf_th, _iou_th, fit);
             FaceObjects *faces = new nn::FaceObjects();
-            size_t size = objs2 ? objs2->size() : objs->size();
-            for (size_t i = 0; i < size; ++i)
+            int size = objs2 ? (int)objs2->size() : (int)objs->size();
+            _sync_index();
+            if (size == 0)
+                return faces;
+            // get std faces of all faces, then get features in one batch
+            std::vector<image::Image *> std_imgs(size, nullptr);
+            // exception can't leave omp parallel region, count failures and throw after loop
+            int failed = 0;
+            #pragma omp parallel for reduction(+:failed)
+            for (int i = 0; i < size; ++i)
             {
                 nn::Object *obj = objs2 ? &objs2->at(i) : &objs->at(i);
-                // get std face
-                image::Image *std_img = img.affine(obj->points, _std_points, _feature_input_size, _feature_input_size);
-                // img.save("/root/test0.jpg");
-                // std_img->save("/root/test.jpg");
-                tensor::Tensors *outputs = _model_feature->forward_image(*std_img, this->mean_feature, this->scale_feature, fit, false, true);
-                if (!outputs) // not ready for dual_buff mode
+                try
                 {
-                    delete std_img;
-                    return new FaceObjects();
+                    std_imgs[i] = img.affine(obj->points, _std_points, _feature_input_size, _feature_input_size);
+                }
+                catch (const std::exception &e)
+                {
+                    log::error("get std face %d failed: %s", i, e.what());
+                    ++failed;
                 }
+            }
+            std::vector<tensor::Tensors *> outputs_list;
+            try
+            {
+                if (failed)
+                    throw err::Exception(err::ERR_RUNTIME, "get std face failed");
+                outputs_list = _model_feature->forward_batch(std_imgs, this->mean_feature, this->scale_feature, fit, std::vector<int>(), false);
+            }
+            catch (...)
+            {
+                for (auto std_img : std_imgs)
+                    delete std_img;
+                delete faces;
+                throw;
+            }
+            for (int i = 0; i < size; ++i)
+            {
+                nn::Object *obj = objs2 ? &objs2->at(i) : &objs->at(i);
+                image::Image *std_img = std_imgs[i];
+                tensor::Tensors *outputs = outputs_list[i];
                 tensor::Tensor *out = outputs->tensors[outputs->keys()[0]];
                 int fea_len = out->size_int();
                 float *feature = (float *)out->data();
-                // compare feature from DB
+                // compare feature from DB, score is cosine similarity mapped to [0, 1]
                 float max_score = 0;
                 int max_i = -1;
-                for (size_t i = 0; i < features.size(); ++i)
+                int idx;
+                float cos_score;
+                if (_index->size() > 0 && _index->search(feature, fea_len, 1, &idx, &cos_score, _nprobe) > 0)
                 {
-                    float score = _feature_compare(feature, features[i].data(), fea_len);
+                    float score = 0.5 + 0.5 * cos_score;
                     if (score > max_score)
                     {
                         max_score = score;
                         if(score > compare_th)
-                            max_i = i;
+                            max_i = idx;
                     }
                 }
                 {
@@ -594,6 +628,8 @@ namespace maix::nn
                 log::error("face no feature");
                 return err::ERR_ARGS;
             }
+            _sync_index();
+            _index->add(face->feature);
             labels.push_back(label);
             features.push_back(face->feature);
             return err::ERR_NONE;
@@ -627,6 +663,8 @@ namespace maix::nn
             }
             if (idx >= 0 && (size_t)idx < features.size())
             {
+                _sync_index();
+                _index->remove(idx);
                 features.erase(features.begin() + idx);
                 labels.erase(labels.begin() + idx + 1);
                 return err::ERR_NONE;
@@ -654,19 +692,24 @@ namespace maix::nn
             {
                 return err::ERR_IO;
             }
+            // name + \0 + fea_len(2B) + feature of every face, packed to one buffer and written at once
+            std::vector<uint8_t> buf;
             for (size_t i = 0; i < features.size(); ++i)
             {
-                // name + \0 + fea_len(2B) + feature
-                f->write(labels[i + 1].c_str(), (int)labels[i + 1].size());
-                f->write("\0", 1);
+                const std::string &name = labels[i + 1];
                 uint16_t len = (uint16_t)features[i].size();
-                f->write(&len, 2);
-                f->write(features[i].data(), features[i].size() * sizeof(float));
-            }
+                size_t pos = buf.size();
+                buf.resize(pos + name.size() + 1 + 2 + len * sizeof(float));
+                memcpy(buf.data() + pos, name.c_str(), name.size() + 1);
+                pos += name.size() + 1;
+                memcpy(buf.data() + pos, &len, 2);
+                memcpy(buf.data() + pos + 2, features[i].data(), len * sizeof(float));
+            }
+            int n = buf.empty() ? 0 : f->write(buf.data(), (int)buf.size());
             f->flush();
             f->close();
             delete f;
-            return err::ERR_NONE;
+            return n == (int)buf.size() ? err::ERR_NONE : err::ERR_IO;
         }
 
         /**
@@ -684,53 +727,83 @@ namespace maix::nn
                 return err::ERR_IO;
             }
 
+            // read whole file at once, then parse name + \0 + fea_len(2B) + feature of every face
+            int size = fs::getsize(path);
+            std::vector<uint8_t> buf(size > 0 ? size : 0);
+            int n = buf.empty() ? 0 : f->read(buf.data(), (int)buf.size());
+            f->close();
+            delete f;
+            if (size < 0 || n != (int)buf.size())
+                return err::ERR_IO;
+
             // Clear current data
             features.clear();
             labels.clear();
             labels.push_back("unknown");
-
-            // Read from the file
-            while (!f->eof())
+            _index->clear();
+            _index_dirty = true;
+            size_t pos = 0;
+            while (pos < buf.size())
             {
-                std::string label;
-                char ch;
-                // Read label until '\0'
-                while (f->read(&ch, 1) && ch != '\0')
-                {
-                    label += ch;
-                }
-
-                // Read the length of the feature vector
+                const uint8_t *end = (const uint8_t *)memchr(buf.data() + pos, '\0', buf.size() - pos);
+                if (!end)
+                    return err::ERR_IO;
+                std::string label((const char *)buf.data() + pos, end - (buf.data() + pos));
+                pos = end - buf.data() + 1;
                 uint16_t len;
-                if (f->read(&len, 2) != 2)
-                {
-                    // Error handling if we cannot read length
-                    f->close();
-                    delete f;
+                if (pos + 2 > buf.size())
                     return err::ERR_IO;
-                }
-
-                // Read the feature vector
-                std::vector<float> feature(len);
-                if (f->read(feature.data(), len * sizeof(float)) != (int)(len * sizeof(float)))
-                {
-                    // Error handling if we cannot read feature data
-                    f->close();
-                    delete f;
+                memcpy(&len, buf.data() + pos, 2);
+                pos += 2;
+                if (pos + len * sizeof(float) > buf.size())
                     return err::ERR_IO;
-                }
-
-                // Add the data to the vectors
+                std::vector<float> feature(len);
+                memcpy(feature.data(), buf.data() + pos, len * sizeof(float));
+                pos += len * sizeof(float);
                 labels.push_back(label);
                 features.push_back(feature);
             }
+            _sync_index();
+            return err::ERR_NONE;
+        }
 
-            // Close the file and clean up
-            f->close();
-            delete f;
+        /**
+         * Set feature index of faces library, useful for large library, e.g. thousands of faces.
+         * @param dtype storage data type of features, nn.EmbeddingDType.EMBEDDING_FLOAT16 or EMBEDDING_INT8 to save memory and be faster,
+         *              default nn.EmbeddingDType.EMBEDDING_FLOAT32.
+         * @param nlist > 0 build IVF index with nlist clusters, recognize only compare with faces of nprobe nearest clusters,
+         *              index is built with current faces, call again after many faces added. Default 0 means not use IVF.
+         * @param nprobe cluster number searched, only valid when nlist > 0, default 8.
+         * @return err.Err
+         * @maixpy maix.nn.FaceRecognizer.set_index
+         */
+        err::Err set_index(nn::EmbeddingDType dtype = nn::EmbeddingDType::EMBEDDING_FLOAT32, int nlist = 0, int nprobe = 8)
+        {
+            if (nlist < 0 || (nlist > 0 && nprobe <= 0))
+            {
+                log::error("nlist should >= 0 and nprobe should > 0");
+                return err::ERR_ARGS;
+            }
+            delete _index;
+            _index = new nn::EmbeddingIndex(0, dtype);
+            _index_nlist = nlist;
+            _nprobe = nlist > 0 ? nprobe : 0;
+            _index_dirty = true;
+            _sync_index();
             return err::ERR_NONE;
         }
 
+        /**
+         * Rebuild search index from features, call it after features modified directly(not by add_face, remove_face or load_faces),
+         * e.g. assigned with new list of the same length or feature values changed.
+         * @maixpy maix.nn.FaceRecognizer.update_index
+         */
+        void update_index()
+        {
+            _index_dirty = true;
+            _sync_index();
+        }
+
         /**
          * Get model input size
          * @return model input size
@@ -803,7 +876,8 @@ namespace maix::nn
         std::vector<std::string> labels;
 
         /**
-         * features
+         * features, same order as labels[1:], search index is built from it,
+         * modify it by add_face, remove_face and load_faces, or call update_index after modified directly.
          * @maixpy maix.nn.FaceRecognizer.features
          */
         std::vector<std::vector<float>> features;
@@ -824,21 +898,23 @@ namespace maix::nn
         int _feature_input_size;
         bool _dual_buff;
         std::vector<int> _std_points;
+        nn::EmbeddingIndex *_index; // normalized features, same order as features
+        int _index_nlist = 0;
+        int _nprobe = 0;
+        bool _index_dirty = false; // features changed without updating _index
 
     private:
-        float _feature_compare(float *ftr0, float *ftr1, int len)
+        // rebuild index if features marked changed, or appended or removed outside
+        void _sync_index()
         {
-            double sumcorr = 0;
-            double sumftr0 = 0;
-            double sumftr1 = 0;
-
-            for (int i = 0; i < len; i++)
-            {
-                sumftr0 += ftr0[i] * ftr0[i];
-                sumftr1 += ftr1[i] * ftr1[i];
-                sumcorr += ftr0[i] * ftr1[i];
-            }
-            return (0.5 + 0.5 * sumcorr / sqrt(sumftr0 * sumftr1));
+            if (!_index_dirty && _index->size() == (int)features.size())
+                return;
+            _index_dirty = false;
+            _index->clear();
+            for (auto &feature : features)
+                _index->add(feature);
+            if (_index_nlist > 0 && _index->size() > 0)
+                _index->build_ivf(_index_nlist);
         }
 
         static void split0(std::vector<std::string> &items, const std::string &s, const std::string &delimiter)
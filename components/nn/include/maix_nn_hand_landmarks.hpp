@@ -294,20 +294,33 @@ namespace maix::nn
                 int y=0;
             #endif
             bool have_invalid = false;
-            for(size_t i=0; i<landmarks_input.size(); ++i)
-            {
-                #if DRAW_STD_IMG
+            #if DRAW_STD_IMG
+                for(size_t i=0; i<landmarks_input.size(); ++i)
+                {
                     img.draw_image(0, y, *landmarks_input[i]);
                     y += landmarks_input[i]->height();
-                #endif
-                outputs = _model->forward_image(*landmarks_input[i], this->mean, this->scale, fit, false, true, false);
-                delete landmarks_input[i];
-                if (!outputs) // not ready, return empty result.
+                }
+            #endif
+            std::vector<tensor::Tensors *> outputs_list;
+            if (!landmarks_input.empty())
+            {
+                try
+                {
+                    outputs_list = _model->forward_batch(landmarks_input, this->mean, this->scale, fit, std::vector<int>(), false, false);
+                }
+                catch (...)
                 {
-                    return objs;
+                    for (auto input : landmarks_input)
+                        delete input;
+                    delete objs;
+                    throw;
                 }
-                have_invalid |= _decode_landmarks(*objs, i, outputs, conf_th2, M_inverse, _input_size.width(), _input_size.height(), img.width(), img.height(), landmarks_rel);
-                delete outputs;
+            }
+            for(size_t i=0; i<landmarks_input.size(); ++i)
+            {
+                delete landmarks_input[i];
+                have_invalid |= _decode_landmarks(*objs, i, outputs_list[i], conf_th2, M_inverse, _input_size.width(), _input_size.height(), img.width(), img.height(), landmarks_rel);
+                delete outputs_list[i];
             }
             if(have_invalid)
             {
@@ -0,0 +1,114 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add NMS, per class grid bucketed hard NMS, soft-NMS and Matrix NMS, support rotated boxes.
+ */
+
+#pragma once
+
+#include "maix_basic.hpp"
+#include "maix_nn_object.hpp"
+#include <vector>
+
+namespace maix::nn
+{
+    /**
+     * NMS method
+     * @maixpy maix.nn.NMSMethod
+     */
+    enum NMSMethod
+    {
+        NMS_HARD = 0,   // greedy NMS, remove box whose IoU with a kept higher score box > iou_th
+        NMS_SOFT = 1,   // Gaussian soft-NMS, score of overlapped box is decayed by exp(-iou^2 / sigma) instead of removed
+        NMS_MATRIX = 2, // Matrix NMS, decay all scores at once by the max IoU with higher score boxes, no sequential dependency
+    };
+
+    /**
+     * Non-maximum suppression of detection boxes.
+     * Boxes are copied to structure of arrays and split to buckets of class(unless class_agnostic), buckets run in multiple threads.
+     * In every bucket, boxes are put into a spatial grid, IoU is only calculated between boxes share grid cells,
+     * so thousands of candidates cost near linear time instead of O(n^2).
+     * Buffers are reused, so keep one NMS object and call run for every frame.
+     * @maixpy maix.nn.NMS
+     */
+    class NMS
+    {
+    public:
+        /**
+         * NMS constructor
+         * @param method NMS method, default nn.NMSMethod.NMS_HARD.
+         * @param sigma Gaussian decay parameter of NMS_SOFT and NMS_MATRIX, smaller value decays more, default 0.5.
+         * @param class_agnostic true: boxes of different classes suppress each other, false: only suppress boxes of the same class, default false.
+         * @maixpy maix.nn.NMS.__init__
+         * @maixcdk maix.nn.NMS.NMS
+         */
+        NMS(nn::NMSMethod method = nn::NMSMethod::NMS_HARD, float sigma = 0.5, bool class_agnostic = false);
+
+        ~NMS();
+
+        /**
+         * Run NMS on objects, objects are not changed except score updated by NMS_SOFT and NMS_MATRIX.
+         * @param objs objects.
+         * @param iou_th IoU threshold, only for NMS_HARD.
+         * @param score_th only for NMS_SOFT and NMS_MATRIX, boxes whose decayed score < score_th are removed, default 0.
+         * @param rotated use rotated IoU of oriented boxes(object's angle), default false.
+         * @return indexes of kept objects, sorted by score from high to low.
+         * @maixpy maix.nn.NMS.run
+         */
+        std::vector<int> run(nn::Objects &objs, float iou_th, float score_th = 0, bool rotated = false);
+
+        /**
+         * Run NMS on objects vector, same as run of nn::Objects.
+         * @maixcdk maix.nn.NMS.run
+         */
+        std::vector<int> run(std::vector<nn::Object> &objs, float iou_th, float score_th = 0, bool rotated = false);
+
+        /**
+         * Run NMS on boxes in structure of arrays.
+         * @param n box number.
+         * @param x left top x of boxes, rotated boxes are rotated around center of (x, y, w, h).
+         * @param y left top y of boxes.
+         * @param w width of boxes.
+         * @param h height of boxes.
+         * @param scores scores of boxes, decayed scores are written back for NMS_SOFT and NMS_MATRIX.
+         * @param class_ids class id of boxes, can be nullptr if class_agnostic.
+         * @param angles angle of boxes, radian = angle * PI, nullptr if not rotated.
+         * @param iou_th same as run of nn::Objects.
+         * @param score_th same as run of nn::Objects.
+         * @return indexes of kept boxes, sorted by score from high to low.
+         * @maixcdk maix.nn.NMS.run
+         */
+        std::vector<int> run(int n, const float *x, const float *y, const float *w, const float *h, float *scores,
+                             const int *class_ids, const float *angles, float iou_th, float score_th = 0);
+
+        /**
+         * Run NMS on objects, same as run but indexes of kept objects are written to keep,
+         * keep is cleared first and its memory is reused, so pass the same vector for every frame to avoid memory allocation.
+         * @param keep output indexes of kept objects, sorted by score from high to low.
+         * @maixcdk maix.nn.NMS.run
+         */
+        void run(nn::Objects &objs, std::vector<int> &keep, float iou_th, float score_th = 0, bool rotated = false);
+
+        /**
+         * Run NMS on objects vector, same as run of nn::Objects with keep.
+         * @maixcdk maix.nn.NMS.run
+         */
+        void run(std::vector<nn::Object> &objs, std::vector<int> &keep, float iou_th, float score_th = 0, bool rotated = false);
+
+        /**
+         * Run NMS on boxes in structure of arrays, same as run of boxes but indexes of kept boxes are written to keep.
+         * @param keep output indexes of kept boxes, cleared first, sorted by score from high to low.
+         * @maixcdk maix.nn.NMS.run
+         */
+        void run(int n, const float *x, const float *y, const float *w, const float *h, float *scores,
+                 const int *class_ids, const float *angles, std::vector<int> &keep, float iou_th, float score_th = 0);
+
+    private:
+        void *_handle;
+        nn::NMSMethod _method;
+        float _sigma;
+        bool _class_agnostic;
+    };
+
+} // namespace maix::nn
@@ -3,12 +3,14 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.19: Objects use pooled storage, add clear and new_mask.
  */
 
 #pragma once
 
 #include <string>
 #include <vector>
+#include <algorithm>
 #include "maix_image.hpp"
 
 namespace maix::nn
@@ -257,7 +259,10 @@ namespace maix::nn
     };
 
     /**
-     * Objects Class for detect result
+     * Objects Class for detect result.
+     * Objects are allocated in chunks and kept in a free list when removed or cleared,
+     * keypoint buffers of reused objects keep their capacity and segmentation masks are allocated in a mask buffer,
+     * so clear and reuse one Objects every frame allocates no memory in steady state.
      * @maixpy maix.nn.Objects
      */
     class Objects
@@ -270,6 +275,7 @@ namespace maix::nn
          */
         Objects()
         {
+            _mask_used = 0;
         }
 
         ~Objects()
@@ -281,8 +287,11 @@ namespace maix::nn
                     delete obj->seg_mask;
                     obj->seg_mask = NULL;
                 }
-                delete obj;
             }
+            for (image::Image *img : _mask_free)
+                delete img;
+            for (Object *chunk : _chunks)
+                delete[] chunk;
         }
 
         /**
@@ -292,11 +301,15 @@ namespace maix::nn
          */
         nn::Object &add(int x = 0, int y = 0, int w = 0, int h = 0, int class_id = 0, float score = 0, std::vector<int> points = std::vector<int>(), float angle = -1)
         {
-            Object *obj = new Object(x, y, w, h, class_id, score, points, angle);
-            if(!obj)
-                throw err::Exception(err::ERR_NO_MEM);
-            obj->seg_mask = NULL;
-            objs.push_back(obj);
+            Object *obj = _alloc();
+            obj->x = x;
+            obj->y = y;
+            obj->w = w;
+            obj->h = h;
+            obj->class_id = class_id;
+            obj->score = score;
+            obj->points.assign(points.begin(), points.end());
+            obj->angle = angle;
             return *obj;
         }
 
@@ -307,11 +320,15 @@ namespace maix::nn
          */
         nn::Object &add(const nn::Object &obj)
         {
-            Object *obj_new = new Object(obj.x, obj.y, obj.w, obj.h, obj.class_id, obj.score, obj.points, obj.angle);
-            if(!obj_new)
-                throw err::Exception(err::ERR_NO_MEM);
-            obj_new->seg_mask = NULL;
-            objs.push_back(obj_new);
+            Object *obj_new = _alloc();
+            obj_new->x = obj.x;
+            obj_new->y = obj.y;
+            obj_new->w = obj.w;
+            obj_new->h = obj.h;
+            obj_new->class_id = obj.class_id;
+            obj_new->score = obj.score;
+            obj_new->points.assign(obj.points.begin(), obj.points.end());
+            obj_new->angle = obj.angle;
             return *obj_new;
         }
 
@@ -323,10 +340,79 @@ namespace maix::nn
         {
             if ((size_t)idx >= objs.size())
                 return err::ERR_ARGS;
+            _release(objs[idx]);
             objs.erase(objs.begin() + idx);
             return err::ERR_NONE;
         }
 
+        /**
+         * Remove all objects, memory of objects and masks is kept and reused by later add,
+         * so reuse one Objects for every frame instead of create a new one.
+         * @attention Objects and seg_mask got before are invalid after clear.
+         * @maixpy maix.nn.Objects.clear
+         */
+        void clear()
+        {
+            for (Object *obj : objs)
+                _release(obj);
+            objs.clear();
+            // merge mask blocks to one block, so next frame with the same masks needs only one block
+            if (_mask_blocks.size() > 1)
+            {
+                size_t total = 0;
+                for (auto &block : _mask_blocks)
+                    total += block.size();
+                _mask_blocks.clear();
+                _mask_blocks.emplace_back(total);
+            }
+            _mask_used = 0;
+        }
+
+        /**
+         * Create segmentation mask image for obj in mask buffer of this Objects, and set to obj.seg_mask,
+         * old mask of obj is released. Mask data is not initialized.
+         * @param obj object of this Objects.
+         * @param w mask width.
+         * @param h mask height.
+         * @param format mask format, image::FMT_GRAYSCALE or image::FMT_BITMAP, default image::FMT_GRAYSCALE.
+         * @return mask image, valid until obj is removed or Objects is cleared.
+         * @throw Throw exception if w or h <= 0 or format not support.
+         * @maixcdk maix.nn.Objects.new_mask
+         */
+        image::Image *new_mask(nn::Object &obj, int w, int h, image::Format format = image::Format::FMT_GRAYSCALE)
+        {
+            if (w <= 0 || h <= 0)
+                throw err::Exception(err::ERR_ARGS, "mask width and height should > 0");
+            if (format != image::Format::FMT_GRAYSCALE && format != image::Format::FMT_BITMAP)
+                throw err::Exception(err::ERR_ARGS, "mask only support grayscale and bitmap");
+            size_t size = format == image::Format::FMT_BITMAP ? (size_t)((w + 31) >> 5) * 4 * h : (size_t)w * h;
+            size = (size + 63) & ~(size_t)63; // round up, keep every mask aligned as block
+            if (_mask_blocks.empty() || _mask_used + size > _mask_blocks.back().size())
+            {
+                size_t block_size = _mask_blocks.empty() ? MASK_BLOCK_MIN : _mask_blocks.back().size() * 2;
+                _mask_blocks.emplace_back(std::max(size, block_size));
+                _mask_used = 0;
+            }
+            uint8_t *data = _mask_blocks.back().data() + _mask_used;
+            _mask_used += size;
+            image::Image *img;
+            if (_mask_free.empty())
+            {
+                img = new image::Image();
+            }
+            else
+            {
+                img = _mask_free.back();
+                _mask_free.pop_back();
+            }
+            // old mask data is still valid until clear, so caller can read it after get new mask
+            if (obj.seg_mask)
+                _mask_free.push_back(obj.seg_mask);
+            img->update(w, h, format, data, 0, false);
+            obj.seg_mask = img;
+            return img;
+        }
+
         /**
          * Get object item
          * @maixpy maix.nn.Objects.at
@@ -376,6 +462,42 @@ namespace maix::nn
         }
 
     private:
+        static constexpr int OBJECTS_CHUNK = 64;          // objects allocated at once
+        static constexpr size_t MASK_BLOCK_MIN = 65536; // min size of mask block
+
         std::vector<Object *> objs;
+        std::vector<Object *> _chunks;       // arrays of OBJECTS_CHUNK objects
+        std::vector<Object *> _free;         // objects not in use
+        std::vector<image::Image *> _mask_free; // mask images not in use
+        std::vector<std::vector<uint8_t>> _mask_blocks;
+        size_t _mask_used; // used bytes of last mask block
+
+        Object *_alloc()
+        {
+            if (_free.empty())
+            {
+                Object *chunk = new Object[OBJECTS_CHUNK];
+                _chunks.push_back(chunk);
+                for (int i = OBJECTS_CHUNK - 1; i >= 0; --i)
+                    _free.push_back(&chunk[i]);
+            }
+            Object *obj = _free.back();
+            _free.pop_back();
+            obj->seg_mask = NULL;
+            obj->temp = NULL;
+            objs.push_back(obj);
+            return obj;
+        }
+
+        void _release(Object *obj)
+        {
+            if (obj->seg_mask)
+            {
+                _mask_free.push_back(obj->seg_mask);
+                obj->seg_mask = NULL;
+            }
+            obj->temp = NULL;
+            _free.push_back(obj);
+        }
     };
 }
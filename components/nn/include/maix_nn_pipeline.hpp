@@ -0,0 +1,212 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add Pipeline, run capture, preprocess, forward, decode and user callback as stages on their own threads.
+ */
+
+#pragma once
+
+#include "maix_basic.hpp"
+#include "maix_nn.hpp"
+#include "maix_nn_object.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace maix::nn
+{
+    /**
+     * Frame flows through pipeline stages, carries frame id, timestamps and data produced by stages.
+     * Image, tensors and objects set by stages are owned by frame and deleted when frame finished or dropped.
+     * @maixpy maix.nn.PipelineFrame
+     */
+    class PipelineFrame
+    {
+    public:
+        /**
+         * PipelineFrame constructor
+         * @param id frame id
+         * @maixcdk maix.nn.PipelineFrame.PipelineFrame
+         */
+        PipelineFrame(uint64_t id = 0)
+        {
+            this->id = id;
+            img = nullptr;
+            tensors = nullptr;
+            objs = nullptr;
+        }
+
+        ~PipelineFrame()
+        {
+            release();
+        }
+
+        /**
+         * Delete image, tensors and objects of frame
+         * @maixcdk maix.nn.PipelineFrame.release
+         */
+        void release()
+        {
+            if (img)
+            {
+                delete img;
+                img = nullptr;
+            }
+            if (tensors)
+            {
+                delete tensors;
+                tensors = nullptr;
+            }
+            if (objs)
+            {
+                delete objs;
+                objs = nullptr;
+            }
+        }
+
+        /**
+         * Frame id, increase from 0 for every frame captured, continuous ids with gaps means frames dropped.
+         * @maixpy maix.nn.PipelineFrame.id
+         */
+        uint64_t id;
+
+        /**
+         * Timestamps in us(time.ticks_us()), timestamps[0] is capture start time, timestamps[i + 1] is stage i finished time.
+         * @maixpy maix.nn.PipelineFrame.timestamps
+         */
+        std::vector<uint64_t> timestamps;
+
+        /**
+         * Image of frame, usually set by capture stage, owned by frame.
+         * @maixpy maix.nn.PipelineFrame.img
+         */
+        image::Image *img;
+
+        /**
+         * Tensors of frame, usually set by forward stage, owned by frame.
+         * @maixpy maix.nn.PipelineFrame.tensors
+         */
+        tensor::Tensors *tensors;
+
+        /**
+         * Objects of frame, usually set by decode stage, owned by frame.
+         * @maixpy maix.nn.PipelineFrame.objs
+         */
+        nn::Objects *objs;
+
+        /**
+         * Time from capture start to the last finished stage in us
+         * @maixpy maix.nn.PipelineFrame.latency_us
+         */
+        uint64_t latency_us()
+        {
+            if (timestamps.size() < 2)
+                return 0;
+            return timestamps.back() - timestamps.front();
+        }
+    };
+
+    /**
+     * Multi-stage async inference pipeline.
+     * Every stage(e.g. capture -> preprocess -> forward -> decode -> user callback) runs on its own thread,
+     * stages are connected by bounded lock-free queues, so all stages run in parallel on multiple cores,
+     * throughput is limited by the slowest stage instead of the sum of all stages.
+     * When a queue is full, the oldest frame in queue is dropped(drop_oldest mode) so latency is bounded,
+     * or the producer stage waits(block mode) so no frame is dropped.
+     * Frames come out of the last stage in capture order.
+     * @maixpy maix.nn.Pipeline
+     */
+    class Pipeline
+    {
+    public:
+        /**
+         * Pipeline constructor
+         * @param queue_size capacity of queue between two stages, range [1, 64], default 2.
+         *                   Smaller value less latency, larger value absorbs more jitter of stage time.
+         * @param drop_oldest true: drop oldest frame in queue when queue is full, capture never waits, latency is bounded.
+         *                    false: producer waits until queue has space, no frame dropped except by stage function.
+         *                    default true.
+         * @throw err.Exception if args invalid.
+         * @maixpy maix.nn.Pipeline.__init__
+         * @maixcdk maix.nn.Pipeline.Pipeline
+         */
+        Pipeline(int queue_size = 2, bool drop_oldest = true);
+
+        ~Pipeline();
+
+        /**
+         * Append a stage, the first stage is source(e.g. capture image from camera) called repeatedly with a new frame,
+         * the last stage is sink(e.g. show result). Only can add stages before start.
+         * @param func stage function, args is frame, set or use frame's img, tensors or objs,
+         *             return true to pass frame to next stage, false to drop frame,
+         *             source stage returns false(e.g. camera read timeout) is not counted as dropped and the frame id is reused.
+         *             Stage function is called in stage's thread, one frame at a time.
+         *             Frame is deleted after the last stage, in C++ set frame's member to nullptr to take ownership of it.
+         * @param name stage name, for stats, default empty means "stage" + index.
+         * @return stage index, start from 0.
+         * @throw err.Exception if pipeline is running.
+         * @maixpy maix.nn.Pipeline.add_stage
+         */
+        int add_stage(std::function<bool(nn::PipelineFrame &)> func, const std::string &name = "");
+
+        /**
+         * Start threads of all stages
+         * @return err::ERR_NONE if success, err::ERR_NOT_PERMIT if already running, err::ERR_ARGS if no stage.
+         * @maixpy maix.nn.Pipeline.start
+         */
+        err::Err start();
+
+        /**
+         * Stop all stages and wait threads exit, frames in queues are dropped.
+         * Stage function is not interrupted, so a stage blocks long(e.g. camera read) delays stop.
+         * @maixpy maix.nn.Pipeline.stop
+         */
+        void stop();
+
+        /**
+         * Is pipeline running
+         * @maixpy maix.nn.Pipeline.running
+         */
+        bool running();
+
+        /**
+         * Number of stages
+         * @maixpy maix.nn.Pipeline.stages
+         */
+        int stages();
+
+        /**
+         * Number of frames finished the last stage
+         * @maixpy maix.nn.Pipeline.finished
+         */
+        uint64_t finished();
+
+        /**
+         * Number of frames dropped of every stage, dropped by queue full before the stage, or the stage function returned false.
+         * Continuously increasing dropped number of a stage means it's the bottleneck, in drop_oldest mode.
+         * @return dropped frame number list, one for every stage.
+         * @maixpy maix.nn.Pipeline.dropped
+         */
+        std::vector<uint64_t> dropped();
+
+        /**
+         * Average time of every stage function in recent frames, in ms
+         * @return stage time list, one for every stage.
+         * @maixpy maix.nn.Pipeline.stage_time
+         */
+        std::vector<float> stage_time();
+
+        /**
+         * Stage names
+         * @maixpy maix.nn.Pipeline.stage_names
+         */
+        std::vector<std::string> stage_names();
+
+    private:
+        void *_handle;
+        int _queue_size;
+        bool _drop_oldest;
+    };
+
+} // namespace maix::nn
@@ -3,6 +3,7 @@
  * @author neucrack@sipeed
  * @license Apache 2.0
  * @date 2024.6.14 Add support.
+ * @update 2026.10.19: Store features in contiguous matrix, classify with batched SIMD distance, add CPU learn.
  */
 #pragma once
 
@@ -51,14 +52,6 @@ namespace maix::nn
                 delete _model;
                 _model = nullptr;
             }
-            for (auto i : _features)
-            {
-                delete[] i;
-            }
-            for (auto i : _features_sample)
-            {
-                delete[] i;
-            }
         }
 
         /**
@@ -187,13 +180,14 @@ namespace maix::nn
         {
             float *feature = NULL;
             tensor::Tensors *outs = _get_feature(img, &feature, fit);
-            std::vector<std::pair<int, float>> *distances = new std::vector<std::pair<int, float>>();
-            for (size_t i = 0; i < _features.size(); ++i)
-            {
-                float distance = _get_distance(feature, _features[i]);
-                distances->push_back(std::make_pair(i, distance));
-            }
+            int num = (int)_features.size();
+            std::vector<float> dis(num);
+            _get_distances(feature, _class_mat.data(), num, dis.data());
             delete outs;
+            std::vector<std::pair<int, float>> *distances = new std::vector<std::pair<int, float>>();
+            distances->reserve(num);
+            for (int i = 0; i < num; ++i)
+                distances->push_back(std::make_pair(i, dis[i]));
             // sort
             std::sort(distances->begin(), distances->end(), [](const std::pair<int, float> &a, const std::pair<int, float> &b)
                       { return a.second < b.second; });
@@ -232,8 +226,9 @@ namespace maix::nn
         {
             if ((size_t)idx >= _features.size())
                 return err::ERR_ARGS;
-            delete[] _features[idx];
-            _features.erase(_features.begin() + idx);
+            _class_mat.erase(_class_mat.begin() + (size_t)idx * _feature_num, _class_mat.begin() + (size_t)(idx + 1) * _feature_num);
+            _anchor_mat.erase(_anchor_mat.begin() + (size_t)idx * _feature_num, _anchor_mat.begin() + (size_t)(idx + 1) * _feature_num);
+            _update_rows(_class_mat, _features);
             return err::ERR_NONE;
         }
 
@@ -260,8 +255,8 @@ namespace maix::nn
         {
             if ((size_t)idx >= _features_sample.size())
                 return err::ERR_ARGS;
-            delete[] _features_sample[idx];
-            _features_sample.erase(_features_sample.begin() + idx);
+            _sample_mat.erase(_sample_mat.begin() + (size_t)idx * _feature_num, _sample_mat.begin() + (size_t)(idx + 1) * _feature_num);
+            _update_rows(_sample_mat, _features_sample);
             return err::ERR_NONE;
         }
 
@@ -277,6 +272,9 @@ namespace maix::nn
         /**
          * Start auto learn class features from classes image and samples.
          * You should call this method after you add some samples.
+         * Every sample is assigned to the nearest class, class feature is updated to mean of its feature and assigned samples,
+         * repeat until assignments not change.
+         * Learn always starts from features of add_class images, so call it again after add more samples gets the same result as learn all samples once.
          * @return learn epoch(times), 0 means learn nothing.
          * @maixpy maix.nn.SelfLearnClassifier.learn
          */
@@ -288,15 +286,10 @@ namespace maix::nn
          */
         void clear()
         {
-            for (auto i : _features)
-            {
-                delete[] i;
-            }
+            _class_mat.clear();
+            _anchor_mat.clear();
             _features.clear();
-            for (auto i : _features_sample)
-            {
-                delete[] i;
-            }
+            _sample_mat.clear();
             _features_sample.clear();
         }
 
@@ -409,15 +402,10 @@ namespace maix::nn
                 }
             }
 
-            for (const auto &feature : _features)
-            {
-                f->write(reinterpret_cast<const char *>(feature), _feature_num * sizeof(float));
-            }
-
-            for (const auto &feature : _features_sample)
-            {
-                f->write(reinterpret_cast<const char *>(feature), _feature_num * sizeof(float));
-            }
+            // features are contiguous, write all at once
+            f->write(_class_mat.data(), (int)(_class_mat.size() * sizeof(float)));
+            if (!_sample_mat.empty())
+                f->write(_sample_mat.data(), (int)(_sample_mat.size() * sizeof(float)));
 
             f->close();
             delete f; // Make sure to delete the file object to avoid memory leaks
@@ -469,28 +457,16 @@ namespace maix::nn
                     labels.push_back(label);
                 }
             }
-            for (auto i : _features)
-            {
-                delete[] i;
-            }
-            _features.clear();
-            for (int i = 0; i < class_num; ++i)
-            {
-                float *feature = new float[_feature_num];
-                _features.push_back(feature);
-                f->read(reinterpret_cast<char *>(feature), feature_length * sizeof(float));
-            }
-            for (auto i : _features_sample)
-            {
-                delete[] i;
-            }
-            _features_sample.clear();
-            for (int i = 0; i < sample_num; ++i)
-            {
-                float *feature = new float[_feature_num];
-                _features_sample.push_back(feature);
-                f->read(reinterpret_cast<char *>(feature), feature_length * sizeof(float));
-            }
+            _class_mat.assign((size_t)class_num * _feature_num, 0);
+            if (!_class_mat.empty())
+                f->read(_class_mat.data(), (int)(_class_mat.size() * sizeof(float)));
+            _update_rows(_class_mat, _features);
+            // class images are not saved, learn starts from loaded class features
+            _anchor_mat = _class_mat;
+            _sample_mat.assign((size_t)sample_num * _feature_num, 0);
+            if (!_sample_mat.empty())
+                f->read(_sample_mat.data(), (int)(_sample_mat.size() * sizeof(float)));
+            _update_rows(_sample_mat, _features_sample);
 
             f->close();
             delete f; // Make sure to delete the file object to avoid memory leaks
@@ -532,8 +508,11 @@ namespace maix::nn
         int _feature_num;
         bool _dual_buff;
         std::vector<nn::LayerInfo> _inputs;
-        std::vector<float *> _features;
-        std::vector<float *> _features_sample;
+        std::vector<float> _class_mat;          // class features, class_num x _feature_num, contiguous
+        std::vector<float> _anchor_mat;         // class features of add_class, learn starts from them
+        std::vector<float> _sample_mat;         // sample features, sample_num x _feature_num, contiguous
+        std::vector<float *> _features;         // rows of _class_mat
+        std::vector<float *> _features_sample;  // rows of _sample_mat
 
         static void split0(std::vector<std::string> &items, const std::string &s, const std::string &delimiter)
         {
@@ -581,30 +560,32 @@ namespace maix::nn
             return outputs;
         }
 
-        void _add_feature(float *new_feature)
+        // update row pointers after matrix changed, as matrix memory may be reallocated
+        void _update_rows(std::vector<float> &mat, std::vector<float *> &rows)
         {
-            float *feature = new float[_feature_num];
-            memcpy(feature, new_feature, _feature_num * sizeof(float));
-            _features.push_back(feature);
+            size_t num = _feature_num > 0 ? mat.size() / _feature_num : 0;
+            rows.resize(num);
+            for (size_t i = 0; i < num; ++i)
+                rows[i] = mat.data() + i * _feature_num;
         }
 
-        void _add_feature_sample(float *new_feature)
+        void _add_feature(float *new_feature)
         {
-            float *feature = new float[_feature_num];
-            memcpy(feature, new_feature, _feature_num * sizeof(float));
-            _features_sample.push_back(feature);
+            _class_mat.insert(_class_mat.end(), new_feature, new_feature + _feature_num);
+            _anchor_mat.insert(_anchor_mat.end(), new_feature, new_feature + _feature_num);
+            _update_rows(_class_mat, _features);
         }
 
-        float _get_distance(float *a, float *b)
+        void _add_feature_sample(float *new_feature)
         {
-            float sum = 0.;
-            for (int i = 0; i < _feature_num; i++)
-            {
-                sum += (a[i] - b[i]) * (a[i] - b[i]);
-            }
-            sum = sqrtf(sum);
-            return sum;
+            _sample_mat.insert(_sample_mat.end(), new_feature, new_feature + _feature_num);
+            _update_rows(_sample_mat, _features_sample);
         }
+
+        /**
+         * L2 distances of feature to num contiguous features of mat, calculated with SIMD in multiple threads.
+         */
+        void _get_distances(const float *feature, const float *mat, int num, float *distances);
     }; // class SelfLearnClassifier
 
 } // namespace maix::nn
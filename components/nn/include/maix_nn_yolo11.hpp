@@ -11,6 +11,8 @@
 #include "maix_image.hpp"
 #include "maix_nn_F.hpp"
 #include "maix_nn_object.hpp"
+#include "maix_nn_yolo_decoder.hpp"
+#include "maix_nn_nms.hpp"
 #include <math.h>
 #include <omp.h>
 
@@ -37,6 +39,20 @@ namespace maix::nn
         float stride;
     };
 
+    struct _BoxYolo11
+    {
+        float x, y, w, h, angle; // angle is -1 if not OBB
+        int level, offset;       // level of stride, offset of anchor in all levels
+        int ax, ay;              // anchor position in level
+    };
+
+    struct _SegRoiYolo11
+    {
+        int x, y, w, h;      // ROI in prototype
+        size_t offset;       // offset of logits
+        const float *coeffs; // mask coefficients
+    };
+
     struct _OutIdxes
     {
         // mode 1
@@ -513,6 +529,28 @@ namespace maix::nn
          */
         nn::Objects *detect(image::Image &img, float conf_th = 0.5, float iou_th = 0.45, maix::image::Fit fit = maix::image::FIT_CONTAIN, float keypoint_th = 0.5, int sort = 0)
         {
+            nn::Objects *res = new nn::Objects();
+            try
+            {
+                detect(img, *res, conf_th, iou_th, fit, keypoint_th, sort);
+            }
+            catch (...)
+            {
+                delete res;
+                throw;
+            }
+            return res;
+        }
+
+        /**
+         * Detect objects from image to objs, same as detect above but result is put into objs,
+         * objs is cleared first and its memory is reused, detect every frame with the same objs allocates no memory for results after first frames.
+         * @param objs Objects to store result, objects and masks got from objs before are invalid after this call.
+         * @throw Same as detect above.
+         * @maixcdk maix.nn.YOLO11.detect
+         */
+        void detect(image::Image &img, nn::Objects &objs, float conf_th = 0.5, float iou_th = 0.45, maix::image::Fit fit = maix::image::FIT_CONTAIN, float keypoint_th = 0.5, int sort = 0)
+        {
 #define SHOW_DETECT_TIME 0
             this->_conf_th = conf_th;
             this->_iou_th = iou_th;
@@ -532,18 +570,18 @@ namespace maix::nn
 #endif
             if (!outputs) // not ready, return empty result.
             {
-                return new nn::Objects();
+                objs.clear();
+                return;
             }
-            nn::Objects *res = _post_process(outputs, img.width(), img.height(), fit, sort);
+            bool ok = _post_process(outputs, img.width(), img.height(), fit, sort, objs);
 #if SHOW_DETECT_TIME
             log::info("postprocess time: %ld", time::ticks_ms() - start);
 #endif
             delete outputs;
-            if(!res)
+            if(!ok)
             {
                 throw err::Exception("post process failed, please see log before");
             }
-            return res;
         }
 
         /**
@@ -652,18 +690,33 @@ namespace maix::nn
             }
         }
 
+        /**
+         * Set segmentation mask output of detect, only for yolo11-seg/yolov8-seg model.
+         * Mask is only calculated and resized inside object box, sigmoid and threshold are done in the same pass.
+         * @param threshold < 0: object's seg_mask is grayscale image of probability * 255, default -1.
+         *                  >= 0: object's seg_mask is image.Format.FMT_BITMAP image, bit is 1 if probability > threshold, 8x smaller and faster.
+         * @param bilinear true: resize mask from model's mask size to object size with bilinear interpolation, smoother edge,
+         *                 false: nearest neighbor, default false.
+         * @maixpy maix.nn.YOLO11.set_seg_mask
+         */
+        void set_seg_mask(float threshold = -1, bool bilinear = false)
+        {
+            _seg_th = threshold;
+            _seg_bilinear = bilinear;
+        }
+
         /**
          * Draw segmentation on image
          * @param img image object, maix.image.Image type.
-         * @param seg_mask segmentation mask image by detect method, a grayscale image
-         * @param threshold only mask's value > threshold will be draw on image, value from 0 to 255.
+         * @param seg_mask segmentation mask image by detect method, a grayscale image, or bitmap image if set_seg_mask threshold >= 0.
+         * @param threshold only mask's value > threshold will be draw on image, value from 0 to 255, not used for bitmap mask.
          * @maixpy maix.nn.YOLO11.draw_seg_mask
          */
         void draw_seg_mask(image::Image &img, int x, int y, image::Image &seg_mask, int threshold = 127)
         {
-            if (seg_mask.format() != image::FMT_GRAYSCALE)
+            if (seg_mask.format() != image::FMT_GRAYSCALE && seg_mask.format() != image::FMT_BITMAP)
             {
-                throw err::Exception(err::ERR_ARGS, "seg_mask only support grascale");
+                throw err::Exception(err::ERR_ARGS, "seg_mask only support grascale and bitmap");
             }
             if (img.format() != image::FMT_RGB888 &&
                 img.format() != image::FMT_BGR888 &&
@@ -676,6 +729,22 @@ namespace maix::nn
             int fmt_size = image::fmt_size[img.format()];
             uint8_t *to = (uint8_t*)img.data();
             uint8_t *from = (uint8_t*)seg_mask.data();
+            if (seg_mask.format() == image::FMT_BITMAP)
+            {
+                int words = (seg_mask.width() + 31) >> 5;
+                for (int i = 0; i < seg_mask.height(); ++i)
+                {
+                    uint32_t *row = (uint32_t *)from + i * words;
+                    for (int j = 0; j < seg_mask.width(); ++j)
+                    {
+                        if (row[j >> 5] >> (j & 31) & 1)
+                        {
+                            to[((y + i) * img.width() + x + j) * fmt_size] = 255;
+                        }
+                    }
+                }
+                return;
+            }
             for (int i = 0; i < seg_mask.height(); ++i)
             {
                 for (int j = 0; j < seg_mask.width(); ++j)
@@ -734,6 +803,19 @@ namespace maix::nn
         std::vector<float> _stride = {8, 16, 32};
         int _anchor_num = 0;
         bool _obb_need_sigmoid;
+        nn::NMS _nms_engine;
+        std::vector<int> _nms_keep;             // indexes kept by NMS, reused every frame
+        nn::Objects _candidates;                // objects before NMS
+        std::vector<_KpInfoYolo11> _kp_infos;   // keypoint info of _candidates
+        std::vector<int> _anchors, _class_ids;  // anchors passed filter
+        std::vector<float> _max_scores;
+        std::vector<float> _angles;             // OBB angle of anchors passed filter
+        std::vector<_BoxYolo11> _boxes;         // boxes of anchors passed filter, decoded in parallel, added to objects in anchor order
+        std::vector<int> _keypoints;            // keypoints of result objects, x, y of keypoint_num keypoints per object
+        std::vector<_SegRoiYolo11> _seg_rois;   // mask ROI of result objects
+        std::vector<float> _seg_logits;         // mask logits of all ROIs
+        float _seg_th = -1;
+        bool _seg_bilinear = false;
 
     private:
         err::Err _load_labels_from_file(std::vector<std::string> &labels, const std::string &label_path)
@@ -760,43 +842,44 @@ namespace maix::nn
             return err::ERR_NONE;
         }
 
-        nn::Objects *_post_process(tensor::Tensors *outputs, int img_w, int img_h, maix::image::Fit fit, int sort)
+        bool _post_process(tensor::Tensors *outputs, int img_w, int img_h, maix::image::Fit fit, int sort, nn::Objects &objects)
         {
-            nn::Objects *objects = new nn::Objects();
             tensor::Tensor *kp_out = NULL;
             tensor::Tensor *mask_out = NULL;
             float scale_w = 1;
             float scale_h = 1;
 
-            if(!_decode_objs(*objects, outputs, _conf_th, _input_size.width(), _input_size.height(), &kp_out, &mask_out))
+            objects.clear();
+            if(!_decode_objs(_candidates, outputs, _conf_th, _input_size.width(), _input_size.height(), &kp_out, &mask_out))
             {
-                delete objects;
-                return NULL;
+                return false;
             }
-            if (objects->size() > 0)
+            if (_candidates.size() > 0)
             {
-                nn::Objects *objects_total = objects;
-                objects = _nms(*objects);
-                delete objects_total;
+                _nms(_candidates, objects);
                 if(sort != 0)
                 {
-                    _sort_objects(*objects, sort);
+                    _sort_objects(objects, sort);
                 }
             }
             // decode keypoints
             if (_type == YOLO11_Type::POSE)
             {
-                _decode_keypoints(*objects, kp_out);
+                _decode_keypoints(objects, kp_out);
             }
             else if (_type == YOLO11_Type::SEG)
             {
-                _decode_seg_points(*objects, kp_out, mask_out);
+                _decode_seg_points(objects, kp_out, mask_out);
+            }
+            if (objects.size() > 0)
+            {
+                _correct_bbox(objects, img_w, img_h, fit, &scale_w, &scale_h);
             }
-            if (objects->size() > 0)
+            if (_type == YOLO11_Type::SEG)
             {
-                _correct_bbox(*objects, img_w, img_h, fit, &scale_w, &scale_h);
+                _make_seg_masks(objects);
             }
-            return objects;
+            return true;
         }
 
         bool _decode_objs(nn::Objects &objs, tensor::Tensors *outputs, float conf_thresh, int w, int h, tensor::Tensor **kp_out, tensor::Tensor **mask_out)
@@ -818,289 +901,48 @@ namespace maix::nn
                 0,
                 (int)(h / _stride[0] * w / _stride[0]),
                 (int)(h / _stride[0] * w / _stride[0] + h / _stride[1] * w / _stride[1])};
+            int class_num = (int)labels.size();
+            const float *angle_ptr = _type == YOLO11_Type::OBB ? (float *)(*kp_out)->data() : nullptr; // same layout as anchors
+            // anchors whose max class score > conf_thresh, found by scanning class scores with SIMD,
+            // then only these anchors are decoded. Buffers are members reused every frame.
+            std::vector<int> &anchors = _anchors, &class_ids = _class_ids;
+            std::vector<float> &max_scores = _max_scores;
+            objs.clear();
+            _kp_infos.clear();
             // detect
             if(_out_node_mode == 1)
             {
+                // raw class scores, compare in logit space so sigmoid is only calculated for anchors passed
+                float th = yolo::logit(conf_thresh);
+                int prob_offset = _reg_max * 4;
                 tensor::Tensor *dets[3] = {&(*outputs)[_out_idxes.det0], &(*outputs)[_out_idxes.det1], &(*outputs)[_out_idxes.det2]};
-                if (_type == YOLO11_Type::OBB)
+                for (int i = 0; i < 3; ++i)
                 {
-                    if(_out_chw)
-                    {
-                        int class_num = (int)labels.size();
-                        int prob_offset = _reg_max * 4;
-                        float* angle_data = (float*)(*kp_out)->data(); // CHW, same layout
-
-                        #pragma omp parallel for
-                        for (int index = 0; index < _anchor_num; ++index)
-                        {
-                            int i = 1;
-                            int anchor_idx;
-                            if (index >= idx_start[2]) {
-                                i = 2;
-                                anchor_idx = index - idx_start[2];
-                            } else if (index < idx_start[1]) {
-                                i = 0;
-                                anchor_idx = index;
-                            } else {
-                                anchor_idx = index - idx_start[1];
-                            }
-
-                            int nh = dets[i]->shape()[2]; // H
-                            int nw = dets[i]->shape()[3]; // W
-                            int s = nh * nw;
-                            float* feature = (float*)dets[i]->data(); // shape: (1, C, H, W)
-
-                            int ax = anchor_idx % nw;
-                            int ay = anchor_idx / nw;
-                            int offset = idx_start[i] + anchor_idx;
-                            float* p = feature + anchor_idx;
-
-                            // class
-                            int class_id = _argmax(p + prob_offset * s, class_num, s);
-                            float score = _sigmoid(p[(prob_offset + class_id) * s]);
-                            if (score <= conf_thresh)
-                                continue;
-
-                            float dis[4];
-                            for(int k = 0; k < 4; ++k)
-                            {
-                                // float softmax_res[_reg_max];
-                                float* p_dis = p + k * _reg_max * s;
-                                // dis[k] = _softmax_step(p_dis, softmax_res, _reg_max, s);
-                                dis[k] = _softmax_expectation(p_dis, _reg_max, s);
-                            }
-
-
-                            float lt_x = dis[0];
-                            float lt_y = dis[1];
-                            float rb_x = dis[2];
-                            float rb_y = dis[3];
-
-                            // angle
-                            float angle_val = angle_data[offset];
-                            float angle = (_obb_need_sigmoid ? _sigmoid(angle_val) : angle_val) - 0.25f;
-                            float angle_rad = angle * M_PI;
-
-                            float stride = _stride[i];
-                            float cos_angle = cosf(angle_rad);
-                            float sin_angle = sinf(angle_rad);
-                            float xf = (rb_x - lt_x) / 2.f;
-                            float yf = (rb_y - lt_y) / 2.f;
-                            float bbox_w = (lt_x + rb_x) * stride;
-                            float bbox_h = (lt_y + rb_y) * stride;
-                            float bbox_x = ((xf * cos_angle - yf * sin_angle) + ax + 0.5f) * stride - bbox_w * 0.5f;
-                            float bbox_y = ((xf * sin_angle + yf * cos_angle) + ay + 0.5f) * stride - bbox_h * 0.5f;
-
-                            _KpInfoYolo11* kp_info = new _KpInfoYolo11(offset, ax, ay, stride);
-                            #pragma omp critical
-                            {
-                                Object& obj = objs.add(bbox_x, bbox_y, bbox_w, bbox_h, class_id, score, {}, angle);
-                                obj.temp = (void*)kp_info;
-                            }
-                        }
-                    }
-                    else
-                    {
-                        int class_num = (int)labels.size();
-                        int prob_offset = _reg_max * 4;
-                        int batch_data_size = prob_offset + class_num;
-                        float *angle_ptr = (float *)(*kp_out)->data();
-                        // for(int i = 0; i < 3; ++i) // 1 x nh x nw x (_reg_max * 4 + class_num)
-                        // {
-                        //     for (int anchor_idx = 0; anchor_idx < anchor_num; ++anchor_idx)
-                            #pragma omp parallel for
-                            for(int index = 0; index < _anchor_num; ++index)
-                            {
-                                int i = 1;
-                                int anchor_idx;
-                                if (index >= idx_start[2]) {
-                                    i = 2;
-                                    anchor_idx = index - idx_start[2];
-                                } else if (index < idx_start[1]) {
-                                    i = 0;
-                                    anchor_idx = index;
-                                }
-                                else{
-                                    anchor_idx = index - idx_start[1];
-                                }
-                                // int nh = dets[i]->shape()[1];
-                                int nw = dets[i]->shape()[2];
-                                float *feature = (float*)dets[i]->data();
-
-                                int ax = anchor_idx % nw;
-                                int ay = anchor_idx / nw;
-                                int offset = idx_start[i] + anchor_idx;
-                                float *p = feature + batch_data_size * anchor_idx;
-                                int class_id = _argmax(p + prob_offset, class_num, 1);
-                                float score = _sigmoid(p[prob_offset + class_id]);
-                                if (score <= conf_thresh)
-                                {
-                                    continue;
-                                }
-                                float dis[4];
-                                for(int k = 0; k < 4; ++k)
-                                {
-                                    // std::vector<float> softmax_res(_reg_max, 0.f);
-                                    float softmax_res[_reg_max];
-                                    dis[k] = _softmax(p + k * _reg_max, softmax_res, _reg_max);
-                                }
-                                float lt_x = dis[0];
-                                float lt_y = dis[1];
-                                float rb_x = dis[2];
-                                float rb_y = dis[3];
-                                float angle = ((_obb_need_sigmoid ? _sigmoid(angle_ptr[offset]) : angle_ptr[offset]) - 0.25);
-                                float angle_rad = angle * M_PI;
-                                float cos_angle = cosf(angle_rad);
-                                float sin_angle = sinf(angle_rad);
-                                float xf = (rb_x - lt_x) / 2.0;
-                                float yf = (rb_y - lt_y) / 2.0;
-                                float bbox_w = (lt_x + rb_x) * _stride[i];
-                                float bbox_h = (lt_y + rb_y) * _stride[i];
-                                float bbox_x = ((xf * cos_angle - yf * sin_angle) + ax + 0.5) * _stride[i] - bbox_w * 0.5;
-                                float bbox_y = ((xf * sin_angle + yf * cos_angle) + ay + 0.5) * _stride[i] - bbox_h * 0.5;
-                                _KpInfoYolo11 *kp_info = new _KpInfoYolo11(offset, ax, ay, _stride[i]);
-                                #pragma omp critical
-                                {
-                                    Object &obj = objs.add(bbox_x, bbox_y, bbox_w, bbox_h, class_id, score, {}, angle);
-                                    obj.temp = (void *)kp_info;
-                                }
-                            }
-                        // }
-                    }
-                }
-                else
-                {
-                    if(_out_chw)
-                    {
-                        int class_num = (int)labels.size();
-                        int prob_offset = _reg_max * 4;
-                        struct LayerInfo {
-                            int nh;
-                            int nw;
-                            float* feature;
-                        };
-
-                        LayerInfo layer_info[3];
-                        for (int i = 0; i < 3; ++i)
-                        {
-                            layer_info[i].nh = dets[i]->shape()[2];
-                            layer_info[i].nw = dets[i]->shape()[3];
-                            layer_info[i].feature = (float*)dets[i]->data();
-                        }
-
-
-                        #pragma omp parallel for
-                        for(int index = 0; index < _anchor_num; ++index)
-                        {
-                            int i = 1;
-                            int anchor_idx;
-                            if (index >= idx_start[2]) {
-                                i = 2;
-                                anchor_idx = index - idx_start[2];
-                            } else if (index < idx_start[1]) {
-                                i = 0;
-                                anchor_idx = index;
-                            } else {
-                                anchor_idx = index - idx_start[1];
-                            }
-
-                            int nh = layer_info[i].nh;
-                            int nw = layer_info[i].nw;
-                            float* feature = layer_info[i].feature;
-
-                            int ax = anchor_idx % nw;
-                            int ay = anchor_idx / nw;
-
-                            int s = nh * nw;
-                            float *p = feature + anchor_idx;
-
-                            int class_id = _argmax(p + prob_offset * s, class_num, s);
-                            float score = _sigmoid(p[prob_offset * s + class_id * s]);
-
-                            if (score <= conf_thresh)
-                                continue;
-
-                            float dis[4];
-                            for(int k = 0; k < 4; ++k)
-                            {
-                                // float softmax_res[_reg_max];
-                                float* p_dis = p + k * _reg_max * s;
-                                // dis[k] = _softmax_step(p_dis, softmax_res, _reg_max, s);
-                                dis[k] = _softmax_expectation(p_dis, _reg_max, s);
-                            }
-
-                            float bbox_x = (ax + 0.5 - dis[0]) * _stride[i];
-                            float bbox_y = (ay + 0.5 - dis[1]) * _stride[i];
-                            float bbox_w = (ax + 0.5 + dis[2]) * _stride[i] - bbox_x;
-                            float bbox_h = (ay + 0.5 + dis[3]) * _stride[i] - bbox_y;
-
-                            _KpInfoYolo11 *kp_info = new _KpInfoYolo11(idx_start[i] + anchor_idx, ax, ay, _stride[i]);
-                            #pragma omp critical
-                            {
-                                Object &obj = objs.add(bbox_x, bbox_y, bbox_w, bbox_h, class_id, score);
-                                obj.temp = (void *)kp_info;
-                            }
-                        }
-                    }
+                    // chw: 1 x (_reg_max * 4 + class_num) x nh x nw, hwc: 1 x nh x nw x (_reg_max * 4 + class_num)
+                    int nh = dets[i]->shape()[_out_chw ? 2 : 1];
+                    int nw = dets[i]->shape()[_out_chw ? 3 : 2];
+                    int s = nh * nw;
+                    float *feature = (float *)dets[i]->data();
+                    int ch_step = _out_chw ? s : 1;                          // distance of two channels of one anchor
+                    int anchor_step = _out_chw ? 1 : prob_offset + class_num; // distance of two anchors
+                    if (_out_chw)
+                        yolo::filter_chw(feature + prob_offset * s, s, class_num, s, th, anchors, class_ids, max_scores);
                     else
+                        yolo::filter_hwc(feature + prob_offset, s, class_num, anchor_step, th, anchors, class_ids, max_scores);
+                    yolo::sigmoid(max_scores.data(), max_scores.data(), (int)max_scores.size());
+                    _decode_angles(angle_ptr, idx_start[i], anchors);
+                    _boxes.resize(anchors.size());
+                    #pragma omp parallel for
+                    for (int k = 0; k < (int)anchors.size(); ++k)
                     {
-                        int class_num = (int)labels.size();
-                        int prob_offset = _reg_max * 4;
-                        int batch_data_size = prob_offset + class_num;
-                        // for(int i = 0; i < 3; ++i) // 1 x nh x nw x (_reg_max * 4 + class_num)
-                        // {
-                        //     int nh = dets[i]->shape()[1];
-                        //     int nw = dets[i]->shape()[2];
-                        //     int anchor_num = nh * nw;
-                        //     float *feature = (float*)dets[i]->data();
-                        //     for (int anchor_idx = 0; anchor_idx < anchor_num; ++anchor_idx)
-                            #pragma omp parallel for
-                            for(int index = 0; index < _anchor_num; ++index)
-                            {
-                                int i = 1;
-                                int anchor_idx;
-                                if (index >= idx_start[2]) {
-                                    i = 2;
-                                    anchor_idx = index - idx_start[2];
-                                } else if (index < idx_start[1]) {
-                                    i = 0;
-                                    anchor_idx = index;
-                                }
-                                else{
-                                    anchor_idx = index - idx_start[1];
-                                }
-                                // int nh = dets[i]->shape()[1];
-                                int nw = dets[i]->shape()[2];
-                                float *feature = (float*)dets[i]->data();
-
-                                int ax = anchor_idx % nw;
-                                int ay = anchor_idx / nw;
-                                float *p = feature + batch_data_size * anchor_idx;
-                                int class_id = _argmax(p + prob_offset, class_num, 1);
-                                float score = _sigmoid(p[prob_offset + class_id]);
-                                if (score <= conf_thresh)
-                                    continue;
-
-                                float dis[4];
-                                for(int k = 0; k < 4; ++k)
-                                {
-                                    // std::vector<float> softmax_res(_reg_max, 0.f);
-                                    float softmax_res[_reg_max];
-                                    dis[k] = _softmax(p + k * _reg_max, softmax_res, _reg_max);
-                                }
-                                float bbox_x = (ax + 0.5 - dis[0]) * _stride[i];
-                                float bbox_y = (ay + 0.5 - dis[1]) * _stride[i];
-                                float bbox_w = (ax + 0.5 + dis[2]) * _stride[i] - bbox_x;
-                                float bbox_h = (ay + 0.5 + dis[3]) * _stride[i] - bbox_y;
-                                _KpInfoYolo11 *kp_info = new _KpInfoYolo11(idx_start[i] + anchor_idx, ax, ay, _stride[i]);
-                                #pragma omp critical
-                                {
-                                    Object &obj = objs.add(bbox_x, bbox_y, bbox_w, bbox_h, class_id, score);
-                                    obj.temp = (void *)kp_info;
-                                }
-                            }
-                        // }
+                        int anchor_idx = anchors[k];
+                        float *p = feature + anchor_idx * anchor_step;
+                        float dis[4];
+                        for (int j = 0; j < 4; ++j)
+                            dis[j] = yolo::dfl(p + j * _reg_max * ch_step, _reg_max, ch_step);
+                        _decode_box(_boxes[k], dis, i, idx_start[i] + anchor_idx, anchor_idx % nw, anchor_idx / nw, angle_ptr ? _angles[k] : 0);
                     }
+                    _add_objs(objs, class_ids, max_scores);
                 }
             }
             else // mode 2
@@ -1109,183 +951,134 @@ namespace maix::nn
                 tensor::Tensor *box_out = NULL;   // shape 1,  1,    4, 8400 hwc: 1,    1, 8400, 4
                 score_out = &(*outputs)[_out_idxes.sigmoid];
                 box_out = &(*outputs)[_out_idxes.dfl];
-                int class_num = (int)labels.size();
                 float *scores_ptr = (float *)score_out->data();
                 float *dets_ptr = (float *)box_out->data();
-                if (_type == YOLO11_Type::OBB)
+                if (_type == YOLO11_Type::OBB && !_out_chw)
                 {
-                    if(!_out_chw)
-                    {
-                        throw err::Exception(err::ERR_NOT_IMPL, "not support output hwc layout");
-                    }
-                    float *angle_ptr = (float *)(*kp_out)->data();
-                    for (int i = 0; i < 3; i++)
-                    {
-                        int nh = h / _stride[i];
-                        int nw = w / _stride[i];
-                        for (int ay = 0; ay < nh; ++ay)
-                        {
-                            for (int ax = 0; ax < nw; ++ax)
-                            {
-                                int offset = idx_start[i] + ay * nw + ax;
-                                int class_id = _argmax(scores_ptr + offset, class_num, _anchor_num);
-                                // int max_idx = _argmax2(scores_ptr + offset, class_num * _anchor_num - offset, _anchor_num);
-                                // int class_id = (offset + max_idx) / _anchor_num;
-                                float obj_score = scores_ptr[offset + class_id * _anchor_num];
-                                if (obj_score <= conf_thresh)
-                                {
-                                    continue;
-                                }
-                                float angle = ((_obb_need_sigmoid ? _sigmoid(angle_ptr[offset]) : angle_ptr[offset]) - 0.25);
-                                float angle_rad = angle * M_PI;
-                                float cos_angle = cosf(angle_rad);
-                                float sin_angle = sinf(angle_rad);
-                                float lt_x = dets_ptr[offset];
-                                float lt_y = dets_ptr[offset + _anchor_num];
-                                float rb_x = dets_ptr[offset + _anchor_num * 2];
-                                float rb_y = dets_ptr[offset + _anchor_num * 3];
-                                float xf = (rb_x - lt_x) / 2.0;
-                                float yf = (rb_y - lt_y) / 2.0;
-                                float bbox_w = (lt_x + rb_x) * _stride[i];
-                                float bbox_h = (lt_y + rb_y) * _stride[i];
-                                float bbox_x = ((xf * cos_angle - yf * sin_angle) + ax + 0.5) * _stride[i] - bbox_w * 0.5;
-                                float bbox_y = ((xf * sin_angle + yf * cos_angle) + ay + 0.5) * _stride[i] - bbox_h * 0.5;
-                                _KpInfoYolo11 *kp_info = new _KpInfoYolo11(offset, ax, ay, _stride[i]);
-                                Object &obj = objs.add(bbox_x, bbox_y, bbox_w, bbox_h, class_id, obj_score, {}, angle);
-                                obj.temp = (void *)kp_info;
-                            }
-                        }
-                    }
+                    throw err::Exception(err::ERR_NOT_IMPL, "not support output hwc layout");
                 }
+                // scores already sigmoided
+                if (_out_chw)
+                    yolo::filter_chw(scores_ptr, _anchor_num, class_num, _anchor_num, conf_thresh, anchors, class_ids, max_scores);
                 else
+                    yolo::filter_hwc(scores_ptr, _anchor_num, class_num, class_num, conf_thresh, anchors, class_ids, max_scores);
+                _decode_angles(angle_ptr, 0, anchors);
+                _boxes.resize(anchors.size());
+                #pragma omp parallel for
+                for (int k = 0; k < (int)anchors.size(); ++k)
                 {
-                    if(_out_chw)
-                    {
-                        for (int i = 0; i < 3; i++)
-                        {
-                            int nh = h / _stride[i];
-                            int nw = w / _stride[i];
-                            for (int ay = 0; ay < nh; ++ay)
-                            {
-                                for (int ax = 0; ax < nw; ++ax)
-                                {
-                                    int offset = idx_start[i] + ay * nw + ax;
-                                    int class_id = _argmax(scores_ptr + offset, class_num, _anchor_num);
-                                    // int max_idx = _argmax2(scores_ptr + offset, class_num * _anchor_num - offset, _anchor_num);
-                                    // int class_id = (offset + max_idx) / _anchor_num;
-                                    float obj_score = scores_ptr[offset + class_id * _anchor_num];
-                                    if (obj_score <= conf_thresh)
-                                    {
-                                        continue;
-                                    }
-                                    float bbox_x = (ax + 0.5 - dets_ptr[offset]) * _stride[i];
-                                    float bbox_y = (ay + 0.5 - dets_ptr[offset + _anchor_num]) * _stride[i];
-                                    float bbox_w = (ax + 0.5 + dets_ptr[offset + _anchor_num * 2]) * _stride[i] - bbox_x;
-                                    float bbox_h = (ay + 0.5 + dets_ptr[offset + _anchor_num * 3]) * _stride[i] - bbox_y;
-                                    _KpInfoYolo11 *kp_info = new _KpInfoYolo11(offset, ax, ay, _stride[i]);
-                                    Object &obj = objs.add(bbox_x, bbox_y, bbox_w, bbox_h, class_id, obj_score);
-                                    obj.temp = (void *)kp_info;
-                                }
-                            }
-                        }
-                    }
-                    else
-                    {
-                        typedef struct
-                        {
-                            float bbox_x;
-                            float bbox_y;
-                            float bbox_w;
-                            float bbox_h;
-                            int class_id;
-                            float score;
-                        } valid_item_t;
-                        for (int i = 0; i < 3; i++)
-                        {
-                            int nh = h / _stride[i];
-                            int nw = w / _stride[i];
-                            for (int ay = 0; ay < nh; ++ay)
-                            {
-                                for (int ax = 0; ax < nw; ++ax)
-                                {
-                                    valid_item_t item;
-                                    int offset = idx_start[i] + ay * nw + ax;
-                                    float *p = scores_ptr + offset * class_num;
-                                    item.class_id = _argmax(p, class_num, 1);
-                                    item.score = p[item.class_id];
-                                    if (item.score <= conf_thresh)
-                                    {
-                                        continue;
-                                    }
-                                    item.bbox_x = (ax + 0.5 - dets_ptr[offset * 4]) * _stride[i];
-                                    item.bbox_y = (ay + 0.5 - dets_ptr[offset * 4 + 1]) * _stride[i];
-                                    item.bbox_w = (ax + 0.5 + dets_ptr[offset * 4 + 2]) * _stride[i] - item.bbox_x;
-                                    item.bbox_h = (ay + 0.5 + dets_ptr[offset * 4 + 3]) * _stride[i] - item.bbox_y;
-                                    _KpInfoYolo11 *kp_info = new _KpInfoYolo11(offset, ax, ay, _stride[i]);
-                                    Object &obj = objs.add(item.bbox_x, item.bbox_y, item.bbox_w, item.bbox_h, item.class_id, item.score);
-                                    obj.temp = (void *)kp_info;
-                                }
-                            }
-                        }
-                    }
+                    int offset = anchors[k];
+                    int i = offset >= idx_start[2] ? 2 : (offset >= idx_start[1] ? 1 : 0);
+                    int nw = w / _stride[i];
+                    int anchor_idx = offset - idx_start[i];
+                    float dis[4];
+                    for (int j = 0; j < 4; ++j)
+                        dis[j] = _out_chw ? dets_ptr[offset + _anchor_num * j] : dets_ptr[offset * 4 + j];
+                    _decode_box(_boxes[k], dis, i, offset, anchor_idx % nw, anchor_idx / nw, angle_ptr ? _angles[k] : 0);
                 }
+                _add_objs(objs, class_ids, max_scores);
             }
+            // objects and keypoint infos are added in the same order, link after all added as _kp_infos may grow
+            for (size_t i = 0; i < objs.size(); ++i)
+                objs.at(i).temp = (void *)&_kp_infos[i];
             return true;
         }
 
-        nn::Objects *_nms(nn::Objects &objs)
+        /**
+         * Gather OBB angle output of anchors to contiguous _angles and sigmoid them with SIMD if needed,
+         * anchor k is angle_ptr[base + anchors[k]], do nothing if angle_ptr is nullptr(not OBB).
+         */
+        void _decode_angles(const float *angle_ptr, int base, const std::vector<int> &anchors)
         {
-            nn::Objects *result = new nn::Objects();
-            std::sort(objs.begin(), objs.end(), [](const nn::Object *a, const nn::Object *b)
-                      { return a->score > b->score; });
-            for (size_t i = 0; i < objs.size(); ++i)
+            if (!angle_ptr)
+                return;
+            _angles.resize(anchors.size());
+            for (size_t k = 0; k < anchors.size(); ++k)
+                _angles[k] = angle_ptr[base + anchors[k]];
+            if (_obb_need_sigmoid)
+                yolo::sigmoid(_angles.data(), _angles.data(), (int)_angles.size());
+        }
+
+        /**
+         * Decode box of anchor (ax, ay) of level, dis is left, top, right, bottom distance to anchor center in stride unit,
+         * angle is OBB angle decoded by _decode_angles, only used for OBB. Can be called in multiple threads.
+         */
+        void _decode_box(_BoxYolo11 &box, const float dis[4], int level, int offset, int ax, int ay, float angle)
+        {
+            float stride = _stride[level];
+            float bbox_x, bbox_y, bbox_w, bbox_h;
+            if (_type == YOLO11_Type::OBB)
+            {
+                angle -= 0.25f;
+                float angle_rad = angle * M_PI;
+                float cos_angle = cosf(angle_rad);
+                float sin_angle = sinf(angle_rad);
+                float xf = (dis[2] - dis[0]) / 2.f;
+                float yf = (dis[3] - dis[1]) / 2.f;
+                bbox_w = (dis[0] + dis[2]) * stride;
+                bbox_h = (dis[1] + dis[3]) * stride;
+                bbox_x = ((xf * cos_angle - yf * sin_angle) + ax + 0.5f) * stride - bbox_w * 0.5f;
+                bbox_y = ((xf * sin_angle + yf * cos_angle) + ay + 0.5f) * stride - bbox_h * 0.5f;
+            }
+            else
             {
-                nn::Object &a = objs.at(i);
-                if (a.score == 0)
-                    continue;
-                for (size_t j = i + 1; j < objs.size(); ++j)
-                {
-                    nn::Object &b = objs.at(j);
-                    {
-                        if (b.score != 0 && a.class_id == b.class_id && _calc_iou(a, b) > this->_iou_th)
-                        {
-                            b.score = 0;
-                        }
-                    }
-                }
+                bbox_x = (ax + 0.5f - dis[0]) * stride;
+                bbox_y = (ay + 0.5f - dis[1]) * stride;
+                bbox_w = (ax + 0.5f + dis[2]) * stride - bbox_x;
+                bbox_h = (ay + 0.5f + dis[3]) * stride - bbox_y;
+                angle = -1;
+            }
+            box.x = bbox_x;
+            box.y = bbox_y;
+            box.w = bbox_w;
+            box.h = bbox_h;
+            box.angle = angle;
+            box.level = level;
+            box.offset = offset;
+            box.ax = ax;
+            box.ay = ay;
+        }
+
+        /**
+         * Add decoded _boxes to objs in anchor order, so candidates order is the same in every run whatever the thread number.
+         */
+        void _add_objs(nn::Objects &objs, const std::vector<int> &class_ids, const std::vector<float> &scores)
+        {
+            for (size_t k = 0; k < _boxes.size(); ++k)
+            {
+                const _BoxYolo11 &b = _boxes[k];
+                objs.add(b.x, b.y, b.w, b.h, class_ids[k], scores[k], {}, b.angle);
+                _kp_infos.push_back(_KpInfoYolo11(b.offset, b.ax, b.ay, _stride[b.level]));
             }
-            for (nn::Object *a : objs)
+        }
+
+        void _nms(nn::Objects &objs, nn::Objects &result)
+        {
+            _nms_engine.run(objs, _nms_keep, this->_iou_th, 0, _type == YOLO11_Type::OBB);
+            for (int i : _nms_keep)
             {
-                if (a->score != 0)
+                nn::Object *a = &objs.at(i);
+                Object &obj = result.add(a->x, a->y, a->w, a->h, a->class_id, a->score, a->points, a->angle);
+                if (obj.x < 0)
                 {
-                    Object &obj = result->add(a->x, a->y, a->w, a->h, a->class_id, a->score, a->points, a->angle);
-                    if (obj.x < 0)
-                    {
-                        obj.w += obj.x;
-                        obj.x = 0;
-                    }
-                    if (obj.y < 0)
-                    {
-                        obj.h += obj.y;
-                        obj.y = 0;
-                    }
-                    if (obj.x + obj.w > _input_size.width())
-                    {
-                        obj.w = _input_size.width() - obj.x;
-                    }
-                    if (obj.y + obj.h > _input_size.height())
-                    {
-                        obj.h = _input_size.height() - obj.y;
-                    }
-                    obj.temp = a->temp;
+                    obj.w += obj.x;
+                    obj.x = 0;
                 }
-                else
+                if (obj.y < 0)
+                {
+                    obj.h += obj.y;
+                    obj.y = 0;
+                }
+                if (obj.x + obj.w > _input_size.width())
                 {
-                    delete (_KpInfoYolo11 *)a->temp;
-                    a->temp = NULL;
+                    obj.w = _input_size.width() - obj.x;
                 }
+                if (obj.y + obj.h > _input_size.height())
+                {
+                    obj.h = _input_size.height() - obj.y;
+                }
+                obj.temp = a->temp;
             }
-            return result;
         }
 
         void _sort_objects(nn::Objects &objects, int sort)
@@ -1298,195 +1091,108 @@ namespace maix::nn
                       { return (a->w * a->h) < (b->w * b->h); });
         }
 
+        /**
+         * Decode keypoints of objects after NMS, all keypoints are decoded to contiguous _keypoints in multiple threads,
+         * visibility is compared in logit space so no exp is needed.
+         */
         void _decode_keypoints(nn::Objects &objs, tensor::Tensor *kp_out)
+        {
+            const float *data = (float *)kp_out->data();
+            // chw: 1, 51, 8400, hwc: 1, 8400, 51
+            int channels = kp_out->shape()[_out_chw ? 1 : 2];
+            int keypoint_num = channels / 3;
+            int kp_step = _out_chw ? 3 * _anchor_num : 3;
+            int ch_step = _out_chw ? _anchor_num : 1;
+            float vis_th = yolo::logit(_keypoint_th);
+            int n = (int)objs.size();
+            _keypoints.resize((size_t)n * keypoint_num * 2);
+            #pragma omp parallel for
+            for (int i = 0; i < n; ++i)
+            {
+                _KpInfoYolo11 *kp_info = (_KpInfoYolo11 *)objs.at(i).temp;
+                const float *p = data + (_out_chw ? kp_info->idx : (size_t)kp_info->idx * channels);
+                yolo::keypoints(p, keypoint_num, kp_step, ch_step, kp_info->anchor_x, kp_info->anchor_y, kp_info->stride,
+                                vis_th, _keypoints.data() + (size_t)i * keypoint_num * 2);
+            }
+            for (int i = 0; i < n; ++i)
+            {
+                nn::Object &o = objs.at(i);
+                const int *kp = _keypoints.data() + (size_t)i * keypoint_num * 2;
+                o.points.assign(kp, kp + keypoint_num * 2);
+                o.temp = NULL;
+            }
+        }
+
+        /**
+         * Calculate mask logits of box ROI of every object to _seg_logits, masks are created by _make_seg_masks after boxes corrected.
+         */
+        void _decode_seg_points(nn::Objects &objs, tensor::Tensor *kp_out, tensor::Tensor *mask_out)
         {
             float *data = (float *)kp_out->data();
+            const float *mask_data = (float *)mask_out->data();
+            int mask_h, mask_w, mask_num, coeff_step;
+            bool mask_chw = true;
             if(_out_chw)
             {
-                int keypoint_num = kp_out->shape()[1] / 3; // 1, 51, 8400
-                for (size_t i = 0; i < objs.size(); ++i)
-                {
-                    nn::Object &o = objs.at(i);
-                    _KpInfoYolo11 *kp_info = (_KpInfoYolo11 *)o.temp;
-                    float *p = data + kp_info->idx;
-                    for (int k = 0; k < keypoint_num; ++k)
-                    {
-                        float score = _sigmoid(p[(k * 3 + 2) * _anchor_num]);
-                        int x = -1;
-                        int y = -1;
-                        if (score > _keypoint_th)
-                        {
-                            x = (p[(k * 3) * _anchor_num] * 2.0 + kp_info->anchor_x) * kp_info->stride;
-                            y = (p[(k * 3 + 1) * _anchor_num] * 2.0 + kp_info->anchor_y) * kp_info->stride;
-                        }
-                        o.points.push_back(x);
-                        o.points.push_back(y);
-                    }
-                    delete (_KpInfoYolo11 *)o.temp;
-                    o.temp = NULL;
-                }
+                mask_h = mask_out->shape()[2];  // 1, 32, 160, 160
+                mask_w = mask_out->shape()[3];
+                mask_num = kp_out->shape()[1];  // 1, 32, 8400
+                coeff_step = _anchor_num;
             }
             else
             {
-                int keypoint_num = kp_out->shape()[2] / 3; // 1, 8400, 51
-                for (size_t i = 0; i < objs.size(); ++i)
-                {
-                    nn::Object &o = objs.at(i);
-                    _KpInfoYolo11 *kp_info = (_KpInfoYolo11 *)o.temp;
-                    float *p = data + kp_info->idx * kp_out->shape()[2];
-                    for (int k = 0; k < keypoint_num; ++k)
-                    {
-                        float score = _sigmoid(p[k * 3 + 2]);
-                        int x = -1;
-                        int y = -1;
-                        if (score > _keypoint_th)
-                        {
-                            x = (p[k * 3] * 2.0 + kp_info->anchor_x) * kp_info->stride;
-                            y = (p[k * 3 + 1] * 2.0 + kp_info->anchor_y) * kp_info->stride;
-                        }
-                        o.points.push_back(x);
-                        o.points.push_back(y);
-                    }
-                    delete (_KpInfoYolo11 *)o.temp;
-                    o.temp = NULL;
-                }
+                mask_h = _input_size.height() / 4;
+                mask_w = _input_size.width() / 4;
+                mask_num = 32;
+                coeff_step = 1;
+                // 1, 32, 160, 160 or 1 160 160 32
+                mask_chw = mask_out->shape()[1] == mask_num && mask_out->shape()[2] == mask_h && mask_out->shape()[3] == mask_w;
+            }
+            _seg_rois.resize(objs.size());
+            size_t total = 0;
+            for (size_t i = 0; i < objs.size(); ++i)
+            {
+                nn::Object &o = objs.at(i);
+                _SegRoiYolo11 &roi = _seg_rois[i];
+                roi.x = std::min(std::max(o.x * mask_w / _input_size.width(), 0), mask_w - 1);
+                roi.y = std::min(std::max(o.y * mask_h / _input_size.height(), 0), mask_h - 1);
+                roi.w = std::max(std::min((o.x + o.w) * mask_w / _input_size.width(), mask_w) - roi.x, 1);
+                roi.h = std::max(std::min((o.y + o.h) * mask_h / _input_size.height(), mask_h) - roi.y, 1);
+                roi.offset = total;
+                total += roi.w * roi.h;
+                int idx = ((_KpInfoYolo11 *)o.temp)->idx;
+                roi.coeffs = _out_chw ? data + idx : data + idx * mask_num; // 1 32 8400 or 1 8400 32
+                o.temp = NULL;
+            }
+            _seg_logits.resize(total);
+            #pragma omp parallel for schedule(dynamic)
+            for (int i = 0; i < (int)objs.size(); ++i)
+            {
+                _SegRoiYolo11 &roi = _seg_rois[i];
+                yolo::seg_logits(mask_data, mask_w, mask_h, mask_num, mask_chw, roi.coeffs, coeff_step,
+                                 roi.x, roi.y, roi.w, roi.h, _seg_logits.data() + roi.offset);
             }
         }
 
-        void _decode_seg_points(nn::Objects &objs, tensor::Tensor *kp_out, tensor::Tensor *mask_out)
+        /**
+         * Create seg_mask of every object with object's size from logits of _decode_seg_points,
+         * only box ROI is resized, sigmoid or threshold are fused.
+         */
+        void _make_seg_masks(nn::Objects &objs)
         {
-            float *data = (float *)kp_out->data();
-            float *mask_data = (float *)mask_out->data();
-            if(_out_chw)
+            image::Format fmt = _seg_th < 0 ? image::Format::FMT_GRAYSCALE : image::Format::FMT_BITMAP;
+            for (size_t i = 0; i < objs.size(); ++i)
             {
-                int mask_h = mask_out->shape()[2];  // 1, 32, 160, 160
-                int mask_w = mask_out->shape()[3];
-                int mask_squre = mask_h * mask_w;
-                int mask_num = kp_out->shape()[1];  // 1, 32, 8400
-                float mask_weights[mask_num];
-                for (size_t i = 0; i < objs.size(); ++i)
-                {
-                    nn::Object &o = objs.at(i);
-                    int mask_x = o.x * mask_w / _input_size.width();
-                    int mask_y = o.y * mask_h / _input_size.height();
-                    int mask_x2 = (o.x + o.w) * mask_w / _input_size.width();
-                    int mask_y2 = (o.y + o.h) * mask_h / _input_size.height();
-                    _KpInfoYolo11 *kp_info = (_KpInfoYolo11 *)o.temp;
-                    float *p = data + kp_info->idx;
-                    for (int k = 0; k < mask_num; ++k)
-                    {
-                        mask_weights[k] = p[k * _anchor_num];
-                    }
-                    o.seg_mask = new image::Image(mask_x2 - mask_x, mask_y2 - mask_y, image::Format::FMT_GRAYSCALE);
-                    uint8_t *p_img_data = (uint8_t *)o.seg_mask->data();
-                    for (int j = mask_y; j < mask_y2; ++j)
-                    {
-                        for (int k = mask_x; k < mask_x2; ++k)
-                        {
-                            mask_data[j * mask_w + k] *= mask_weights[0];
-                        }
-                    }
-                    for (int n = 1; n < mask_num; ++n)
-                    {
-                        for (int j = mask_y; j < mask_y2; ++j)
-                        {
-                            for (int k = mask_x; k < mask_x2; ++k)
-                            {
-                                mask_data[j * mask_w + k] += mask_weights[n] * mask_data[n * mask_squre + j * mask_w + k];
-                            }
-                        }
-                    }
-                    for (int j = mask_y; j < mask_y2; ++j)
-                    {
-                        for (int k = mask_x; k < mask_x2; ++k)
-                        {
-                            *p_img_data++ = (uint8_t)(_sigmoid(mask_data[j * mask_w + k]) * 255);
-                        }
-                    }
-                    delete (_KpInfoYolo11 *)o.temp;
-                    o.temp = NULL;
-                }
+                nn::Object &o = objs.at(i);
+                objs.new_mask(o, std::max(o.w, 1), std::max(o.h, 1), fmt);
             }
-            else
+            #pragma omp parallel for schedule(dynamic)
+            for (int i = 0; i < (int)objs.size(); ++i)
             {
-                bool mask_chw = false;
-                int mask_h = _input_size.height() / 4;
-                int mask_w = _input_size.width() / 4;
-                int mask_num = 32;
-                int mask_squre = mask_h * mask_w;
-                // 1, 32, 160, 160 or 1 160 160 32
-                if(mask_out->shape()[1] == mask_num && mask_out->shape()[2] == mask_h && mask_out->shape()[3] == mask_w)
-                {
-                    mask_chw = true;
-                }
-                for (size_t i = 0; i < objs.size(); ++i)
-                {
-                    nn::Object &o = objs.at(i);
-                    int mask_x = o.x * mask_w / _input_size.width();
-                    int mask_y = o.y * mask_h / _input_size.height();
-                    int mask_x2 = (o.x + o.w) * mask_w / _input_size.width();
-                    int mask_y2 = (o.y + o.h) * mask_h / _input_size.height();
-                    _KpInfoYolo11 *kp_info = (_KpInfoYolo11 *)o.temp;
-                    float *mask_weights = data + kp_info->idx * mask_num; //1 8400 32
-                    o.seg_mask = new image::Image(mask_x2 - mask_x, mask_y2 - mask_y, image::Format::FMT_GRAYSCALE);
-                    uint8_t *p_img_data = (uint8_t *)o.seg_mask->data();
-                    if(mask_chw) // 1 32 160 160
-                    {
-                        for (int j = mask_y; j < mask_y2; ++j)
-                        {
-                            for (int k = mask_x; k < mask_x2; ++k)
-                            {
-                                mask_data[j * mask_w + k] *= mask_weights[0];
-                            }
-                        }
-                        for (int n = 1; n < mask_num; ++n)
-                        {
-                            for (int j = mask_y; j < mask_y2; ++j)
-                            {
-                                for (int k = mask_x; k < mask_x2; ++k)
-                                {
-                                    mask_data[j * mask_w + k] += mask_weights[n] * mask_data[n * mask_squre + j * mask_w + k];
-                                }
-                            }
-                        }
-                        for (int j = mask_y; j < mask_y2; ++j)
-                        {
-                            for (int k = mask_x; k < mask_x2; ++k)
-                            {
-                                *p_img_data++ = (uint8_t)(_sigmoid(mask_data[j * mask_w + k]) * 255);
-                            }
-                        }
-                    }
-                    else // 1 160 160 32
-                    {
-                        for (int j = mask_y; j < mask_y2; ++j)
-                        {
-                            for (int k = mask_x; k < mask_x2; ++k)
-                            {
-                                mask_data[(j * mask_w + k) * mask_num] *= mask_weights[0];
-                            }
-                        }
-                        for (int j = mask_y; j < mask_y2; ++j)
-                        {
-                            for (int k = mask_x; k < mask_x2; ++k)
-                            {
-                                for (int n = 1; n < mask_num; ++n)
-                                {
-                                    mask_data[(j * mask_w + k) * mask_num] += mask_weights[n] * mask_data[(j * mask_w + k) * mask_num + n];
-                                }
-                            }
-                        }
-                        for (int j = mask_y; j < mask_y2; ++j)
-                        {
-                            for (int k = mask_x; k < mask_x2; ++k)
-                            {
-                                *p_img_data++ = (uint8_t)(_sigmoid(mask_data[(j * mask_w + k) * mask_num]) * 255);
-                            }
-                        }
-                    }
-                    delete (_KpInfoYolo11 *)o.temp;
-                    o.temp = NULL;
-                }
+                nn::Object &o = objs.at(i);
+                _SegRoiYolo11 &roi = _seg_rois[i];
+                yolo::seg_mask(_seg_logits.data() + roi.offset, roi.w, roi.h, (uint8_t *)o.seg_mask->data(),
+                               o.seg_mask->width(), o.seg_mask->height(), _seg_th, _seg_bilinear);
             }
         }
 
@@ -1517,26 +1223,10 @@ namespace maix::nn
 
             for (nn::Object *obj : objs)
             {
-                if (obj->temp)
-                {
-                    delete (_KpInfoYolo11 *)obj->temp;
-                    obj->temp = NULL;
-                }
+                obj->temp = NULL;
             }
             if (img_w == _input_size.width() && img_h == _input_size.height())
             {
-                if (_type == YOLO11_Type::SEG)
-                {
-                    for (nn::Object *obj : objs)
-                    {
-                        if (obj->w != obj->seg_mask->width() || obj->h != obj->seg_mask->height())
-                        {
-                            image::Image *old = obj->seg_mask;
-                            obj->seg_mask = old->resize(obj->w, obj->h, image::FIT_FILL);
-                            delete old;
-                        }
-                    }
-                }
                 return;
             }
             if (fit == maix::image::FIT_FILL)
@@ -1555,15 +1245,6 @@ namespace maix::nn
                         obj->points.at(i * 2 + 1) *= *scale_h;
                     }
                     CORRECT_BBOX_RANGE_YOLO11(obj);
-                    if (_type == YOLO11_Type::SEG)
-                    {
-                        if (obj->w != obj->seg_mask->width() || obj->h != obj->seg_mask->height())
-                        {
-                            image::Image *old = obj->seg_mask;
-                            obj->seg_mask = old->resize(obj->w, obj->h, image::FIT_FILL);
-                            delete old;
-                        }
-                    }
                 }
             }
             else if (fit == maix::image::FIT_CONTAIN)
@@ -1588,15 +1269,6 @@ namespace maix::nn
                         obj->points.at(i * 2 + 1) = (obj->points.at(i * 2 + 1) - pad_h) * scale_reverse;
                     }
                     CORRECT_BBOX_RANGE_YOLO11(obj);
-                    if (_type == YOLO11_Type::SEG)
-                    {
-                        if (obj->w != obj->seg_mask->width() || obj->h != obj->seg_mask->height())
-                        {
-                            image::Image *old = obj->seg_mask;
-                            obj->seg_mask = old->resize(obj->w, obj->h, image::FIT_FILL);
-                            delete old;
-                        }
-                    }
                 }
             }
             else if (fit == maix::image::FIT_COVER)
@@ -1621,15 +1293,6 @@ namespace maix::nn
                         obj->points.at(i * 2 + 1) = (obj->points.at(i * 2 + 1) - pad_h) * scale_reverse;
                     }
                     CORRECT_BBOX_RANGE_YOLO11(obj);
-                    if (_type == YOLO11_Type::SEG)
-                    {
-                        if (obj->w != obj->seg_mask->width() || obj->h != obj->seg_mask->height())
-                        {
-                            image::Image *old = obj->seg_mask;
-                            obj->seg_mask = old->resize(obj->w, obj->h, image::FIT_FILL);
-                            delete old;
-                        }
-                    }
                 }
             }
             else
@@ -1640,47 +1303,6 @@ namespace maix::nn
 
         inline static float _sigmoid(float x) { return 1.0 / (1 + expf(-x)); }
 
-        inline static float _calc_iou(Object &a, Object &b)
-        {
-            float area1 = a.w * a.h;
-            float area2 = b.w * b.h;
-            float wi = std::min((a.x + a.w), (b.x + b.w)) -
-                       std::max(a.x, b.x);
-            float hi = std::min((a.y + a.h), (b.y + b.h)) -
-                       std::max(a.y, b.y);
-            float area_i = std::max(wi, 0.0f) * std::max(hi, 0.0f);
-            return area_i / (area1 + area2 - area_i);
-        }
-
-        template <typename T>
-        static int _argmax(const T *data, size_t len, size_t stride = 1)
-        {
-            int maxIndex = 0;
-            for (size_t i = 1; i < len; i++)
-            {
-                int idx = i * stride;
-                if (data[maxIndex * stride] < data[idx])
-                {
-                    maxIndex = i;
-                }
-            }
-            return maxIndex;
-        }
-
-        template <typename T>
-        static int _argmax2(const T *data, size_t end, size_t stride = 1)
-        {
-            int maxIndex = 0;
-            for (size_t i = stride; i < end; i += stride)
-            {
-                if (data[maxIndex] < data[i])
-                {
-                    maxIndex = i;
-                }
-            }
-            return maxIndex;
-        }
-
         static void split0(std::vector<std::string> &items, const std::string &s, const std::string &delimiter)
         {
             items.clear();
@@ -1705,77 +1327,6 @@ namespace maix::nn
             split0(tokens, s, delimiter);
             return tokens;
         }
-        static float _softmax(const float* src, float* dst, int length)
-        {
-            const float alpha = *std::max_element(src, src + length);
-            float denominator = 0;
-            float dis_sum = 0;
-            for (int i = 0; i < length; ++i)
-            {
-                dst[i] = exp(src[i] - alpha);
-                denominator += dst[i];
-            }
-            for (int i = 0; i < length; ++i)
-            {
-                dst[i] /= denominator;
-                dis_sum += i * dst[i];
-            }
-            return dis_sum;
-        }
-
-        static float _softmax_step(const float* src, float* dst, int length, int step)
-        {
-            // 找最大值用于稳定性
-            float alpha = src[0];
-            for (int i = 1; i < length; ++i)
-            {
-                float val = src[i * step];
-                if (val > alpha)
-                    alpha = val;
-            }
-
-            // softmax 计算（先减最大值再归一化）
-            float denominator = 0.0f;
-            for (int i = 0; i < length; ++i)
-            {
-                dst[i] = std::exp(src[i * step] - alpha);
-                denominator += dst[i];
-            }
-
-            // 归一化并计算加权和
-            float dis_sum = 0.0f;
-            for (int i = 0; i < length; ++i)
-            {
-                dst[i] /= denominator;
-                dis_sum += i * dst[i];
-            }
-
-            return dis_sum;
-        }
-
-        static float _softmax_expectation(const float* src, int length, int step)
-        {
-            float alpha = src[0];
-            for (int i = 1; i < length; ++i)
-            {
-                float val = src[i * step];
-                if (val > alpha)
-                    alpha = val;
-            }
-
-            float denominator = 0.f;
-            float numerator = 0.f;
-
-            for (int i = 0; i < length; ++i)
-            {
-                float e = std::exp(src[i * step] - alpha);
-                denominator += e;
-                numerator += i * e;
-            }
-
-            return numerator / denominator;
-        }
-
     };
 
 } // namespace maix::nn
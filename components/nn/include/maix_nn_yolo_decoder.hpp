@@ -0,0 +1,131 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add YOLO decoder core, filter anchors by class score in logit space with SIMD, shared by all YOLO models.
+ *                     Add segmentation mask decode of box ROI, fused resize, sigmoid, threshold and bit pack.
+ *                     Add SIMD sigmoid with polynomial exp, and keypoints decode with SIMD.
+ */
+
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <math.h>
+
+namespace maix::nn::yolo
+{
+    /**
+     * Inverse of sigmoid, sigmoid(x) > prob is equal to x > logit(prob),
+     * so raw model outputs can be compared with confidence threshold directly without exp.
+     * @param prob probability, <= 0 returns -inf, >= 1 returns inf.
+     * @maixcdk maix.nn.yolo.logit
+     */
+    float logit(float prob);
+
+    /**
+     * Sigmoid
+     * @maixcdk maix.nn.yolo.sigmoid
+     */
+    inline float sigmoid(float x) { return 1.0f / (1 + expf(-x)); }
+
+    /**
+     * Sigmoid of n floats with SIMD, exp is approximated by polynomial after range reduction,
+     * max absolute error to sigmoid(float) is about 1e-7, scalar tail uses sigmoid(float).
+     * @param src input n floats.
+     * @param dst output n floats, can be the same as src.
+     * @param n number.
+     * @maixcdk maix.nn.yolo.sigmoid
+     */
+    void sigmoid(const float *src, float *dst, int n);
+
+    /**
+     * Find anchors whose max class score > th, class scores are in CHW layout, class c of anchor a is scores[c * plane_stride + a].
+     * Class planes are scanned contiguously with SIMD keeping running max and argmax of every anchor,
+     * anchors are split to blocks scanned in multiple threads, so no strided walk for every anchor.
+     * @param scores class scores, point to class 0 of anchor 0.
+     * @param anchor_num anchor number.
+     * @param class_num class number.
+     * @param plane_stride distance of two class planes in float, >= anchor_num.
+     * @param th score threshold, in the same space as scores, e.g. logit(conf_th) for raw output, conf_th for sigmoid output.
+     * @param anchors output anchor indexes whose max class score > th, in ascending order.
+     * @param class_ids output class id of every anchor in anchors, the first one if several classes have the max score.
+     * @param max_scores output max class score of every anchor in anchors, value in scores, not converted.
+     * @maixcdk maix.nn.yolo.filter_chw
+     */
+    void filter_chw(const float *scores, int anchor_num, int class_num, int plane_stride, float th,
+                    std::vector<int> &anchors, std::vector<int> &class_ids, std::vector<float> &max_scores);
+
+    /**
+     * Same as filter_chw but class scores are in HWC layout, class c of anchor a is scores[a * anchor_stride + c].
+     * Class scores of every anchor are reduced with SIMD max, argmax is only searched for anchors > th.
+     * @param anchor_stride distance of two anchors in float, >= class_num.
+     * @maixcdk maix.nn.yolo.filter_hwc
+     */
+    void filter_hwc(const float *scores, int anchor_num, int class_num, int anchor_stride, float th,
+                    std::vector<int> &anchors, std::vector<int> &class_ids, std::vector<float> &max_scores);
+
+    /**
+     * Distribution focal loss decode, expectation of softmax of reg_max bins, call it only for anchors passed filter.
+     * @param src bin 0, bin i is src[i * step].
+     * @param reg_max bin number.
+     * @param step distance of two bins in float, anchor number of the level for CHW layout, 1 for HWC layout.
+     * @return distance in stride unit.
+     * @maixcdk maix.nn.yolo.dfl
+     */
+    float dfl(const float *src, int reg_max, int step = 1);
+
+    /**
+     * Decode keypoints of one anchor, keypoint k is (x, y, visibility) at p[k * kp_step + c * ch_step], c = 0, 1, 2,
+     * position is (x * 2 + anchor_x) * stride, keypoint whose visibility <= vis_th is (-1, -1).
+     * Keypoints are gathered to contiguous arrays first, then transformed and compared with SIMD.
+     * @param p x of keypoint 0.
+     * @param keypoint_num keypoint number.
+     * @param kp_step distance of two keypoints in float, 3 * anchor number for CHW layout, 3 for HWC layout.
+     * @param ch_step distance of x, y and visibility in float, anchor number for CHW layout, 1 for HWC layout.
+     * @param anchor_x anchor x.
+     * @param anchor_y anchor y.
+     * @param stride stride of anchor level.
+     * @param vis_th visibility threshold, in the same space as visibility, e.g. logit(keypoint_th) for raw output.
+     * @param out output 2 * keypoint_num ints, x0, y0, x1, y1, ...
+     * @maixcdk maix.nn.yolo.keypoints
+     */
+    void keypoints(const float *p, int keypoint_num, int kp_step, int ch_step, float anchor_x, float anchor_y, float stride,
+                   float vis_th, int *out);
+
+    /**
+     * Segmentation mask logits of ROI [x, y, w, h] of prototypes, that is coeffs(1 x mask_num) * protos(mask_num x ROI pixels),
+     * only pixels inside ROI are calculated. CHW prototypes are accumulated row by row with SIMD multiply-add.
+     * @param protos prototype masks, CHW: mask_num x proto_h x proto_w, HWC: proto_h x proto_w x mask_num.
+     * @param proto_w prototype width.
+     * @param proto_h prototype height.
+     * @param mask_num prototype number.
+     * @param chw layout of protos.
+     * @param coeffs mask coefficients of object, coefficient n is coeffs[n * coeff_step].
+     * @param coeff_step distance of two coefficients in float.
+     * @param x ROI left, ROI must inside prototype.
+     * @param y ROI top.
+     * @param w ROI width.
+     * @param h ROI height.
+     * @param logits output w * h logits, row by row.
+     * @maixcdk maix.nn.yolo.seg_logits
+     */
+    void seg_logits(const float *protos, int proto_w, int proto_h, int mask_num, bool chw, const float *coeffs, int coeff_step,
+                    int x, int y, int w, int h, float *logits);
+
+    /**
+     * Convert mask logits to mask image data, resize, sigmoid, threshold and bit pack are done in one pass.
+     * @param logits src_w * src_h logits.
+     * @param src_w logits width.
+     * @param src_h logits height.
+     * @param out output data, dst_w * dst_h bytes for grayscale, ((dst_w + 31) / 32 * 4) * dst_h bytes for bitmap.
+     * @param dst_w output width, resized if not equal to src_w.
+     * @param dst_h output height.
+     * @param th < 0: output grayscale, pixel is sigmoid(logit) * 255.
+     *           >= 0: output bitmap(image::FMT_BITMAP layout), bit is 1 if sigmoid(logit) > th, compared in logit space.
+     * @param bilinear resize logits with bilinear interpolation if true, else nearest neighbor same as image::Image::resize.
+     * @maixcdk maix.nn.yolo.seg_mask
+     */
+    void seg_mask(const float *logits, int src_w, int src_h, uint8_t *out, int dst_w, int dst_h, float th = -1, bool bilinear = false);
+
+} // namespace maix::nn::yolo
@@ -13,6 +13,7 @@
 #include "maix_nn_object.hpp"
 #include <math.h>
 #include "maix_nn_yolo11.hpp"
+#include "maix_nn_nms.hpp"
 
 namespace maix::nn
 {
@@ -638,10 +639,6 @@ namespace maix::nn
 
         bool _decode_objs(nn::Objects &objs, tensor::Tensors *outputs, float conf_thresh, int w, int h, tensor::Tensor **kp_out, tensor::Tensor **mask_out)
         {
-            int idx_start[3] = {
-                0,
-                (int)(h / _stride[0] * w / _stride[0]),
-                (int)(h / _stride[0] * w / _stride[0] + h / _stride[1] * w / _stride[1])};
             // detect
             tensor::Tensor *dets[3] = {&(*outputs)[_out_idxes.det0], &(*outputs)[_out_idxes.det1], &(*outputs)[_out_idxes.det2]};
             if(_out_chw)
@@ -653,61 +650,41 @@ namespace maix::nn
                 int class_num = (int)labels.size();
                 int prob_offset = _reg_max * 4;
                 int batch_data_size = prob_offset + class_num;
-                // for(int i = 0; i < 3; ++i) // 1 x nh x nw x (_reg_max * 4 + class_num)
-                // {
-                //     int nh = dets[i]->shape()[1];
-                //     int nw = dets[i]->shape()[2];
-                //     int anchor_num = nh * nw;
-                //     float *feature = (float*)dets[i]->data();
-                //     for (int anchor_idx = 0; anchor_idx < anchor_num; ++anchor_idx)
+                // raw class scores, compare in logit space so sigmoid is only calculated for anchors passed
+                float th = yolo::logit(conf_thresh);
+                std::vector<int> anchors, class_ids;
+                std::vector<float> max_scores;
+                std::vector<float> boxes; // x, y, w, h of anchors passed filter, decoded in parallel, added in anchor order
+                for(int i = 0; i < 3; ++i) // 1 x nh x nw x (_reg_max * 4 + class_num)
+                {
+                    int nh = dets[i]->shape()[1];
+                    int nw = dets[i]->shape()[2];
+                    float *feature = (float*)dets[i]->data();
+                    yolo::filter_hwc(feature + prob_offset, nh * nw, class_num, batch_data_size, th, anchors, class_ids, max_scores);
+                    boxes.resize(anchors.size() * 4);
                     #pragma omp parallel for
-                    for(int index = 0; index < _anchor_num; ++index)
+                    for(int k = 0; k < (int)anchors.size(); ++k)
                     {
-                        int i = 1;
-                        int anchor_idx;
-                        if (index >= idx_start[2]) {
-                            i = 2;
-                            anchor_idx = index - idx_start[2];
-                        } else if (index < idx_start[1]) {
-                            i = 0;
-                            anchor_idx = index;
-                        }
-                        else{
-                            anchor_idx = index - idx_start[1];
-                        }
-                        // int nh = dets[i]->shape()[1];
-                        int nw = dets[i]->shape()[2];
-                        float *feature = (float*)dets[i]->data();
-
+                        int anchor_idx = anchors[k];
                         int ax = anchor_idx % nw;
                         int ay = anchor_idx / nw;
                         float *p = feature + batch_data_size * anchor_idx;
-                        int class_id = _argmax(p + prob_offset, class_num, 1);
-                        float score = _sigmoid(p[prob_offset + class_id]);
-                        if (score <= conf_thresh)
-                        {
-                            continue;
-                        }
                         float dis[4];
-                        for(int k = 0; k < 4; ++k)
-                        {
-                            // std::vector<float> softmax_res(_reg_max, 0.f);
-                            float softmax_res[_reg_max];
-                            dis[k] = _softmax(p + k * _reg_max, softmax_res, _reg_max);
-                        }
-                        float bbox_x = (ax + 0.5 - dis[0]) * _stride[i];
-                        float bbox_y = (ay + 0.5 - dis[1]) * _stride[i];
-                        float bbox_w = (ax + 0.5 + dis[2]) * _stride[i] - bbox_x;
-                        float bbox_h = (ay + 0.5 + dis[3]) * _stride[i] - bbox_y;
-                        // _KpInfoYolo11 *kp_info = new _KpInfoYolo11(idx_start[i] + anchor_idx, ax, ay, _stride[i]);
-                        #pragma omp critical
-                        {
-                            Object &obj = objs.add(bbox_x, bbox_y, bbox_w, bbox_h, class_id, score);
-                            // obj.temp = (void *)kp_info;
-                            obj.temp = nullptr;
-                        }
+                        for(int j = 0; j < 4; ++j)
+                            dis[j] = yolo::dfl(p + j * _reg_max, _reg_max);
+                        float *box = &boxes[k * 4];
+                        box[0] = (ax + 0.5 - dis[0]) * _stride[i];
+                        box[1] = (ay + 0.5 - dis[1]) * _stride[i];
+                        box[2] = (ax + 0.5 + dis[2]) * _stride[i] - box[0];
+                        box[3] = (ay + 0.5 + dis[3]) * _stride[i] - box[1];
                     }
-                // }
+                    for(int k = 0; k < (int)anchors.size(); ++k)
+                    {
+                        const float *box = &boxes[k * 4];
+                        Object &obj = objs.add(box[0], box[1], box[2], box[3], class_ids[k], yolo::sigmoid(max_scores[k]));
+                        obj.temp = nullptr;
+                    }
+                }
             }
             return true;
         }
@@ -715,54 +692,30 @@ namespace maix::nn
         nn::Objects *_nms(nn::Objects &objs)
         {
             nn::Objects *result = new nn::Objects();
-            std::sort(objs.begin(), objs.end(), [](const nn::Object *a, const nn::Object *b)
-                      { return a->score > b->score; });
-            for (size_t i = 0; i < objs.size(); ++i)
-            {
-                nn::Object &a = objs.at(i);
-                if (a.score == 0)
-                    continue;
-                for (size_t j = i + 1; j < objs.size(); ++j)
+            _nms_engine.run(objs, _nms_keep, this->_iou_th);
+            for (int i : _nms_keep)
+            {
+                nn::Object *a = &objs.at(i);
+                Object &obj = result->add(a->x, a->y, a->w, a->h, a->class_id, a->score, a->points, a->angle);
+                if (obj.x < 0)
                 {
-                    nn::Object &b = objs.at(j);
-                    {
-                        if (b.score != 0 && a.class_id == b.class_id && _calc_iou(a, b) > this->_iou_th)
-                        {
-                            b.score = 0;
-                        }
-                    }
+                    obj.w += obj.x;
+                    obj.x = 0;
                 }
-            }
-            for (nn::Object *a : objs)
-            {
-                if (a->score != 0)
+                if (obj.y < 0)
                 {
-                    Object &obj = result->add(a->x, a->y, a->w, a->h, a->class_id, a->score, a->points, a->angle);
-                    if (obj.x < 0)
-                    {
-                        obj.w += obj.x;
-                        obj.x = 0;
-                    }
-                    if (obj.y < 0)
-                    {
-                        obj.h += obj.y;
-                        obj.y = 0;
-                    }
-                    if (obj.x + obj.w > _input_size.width())
-                    {
-                        obj.w = _input_size.width() - obj.x;
-                    }
-                    if (obj.y + obj.h > _input_size.height())
-                    {
-                        obj.h = _input_size.height() - obj.y;
-                    }
-                    obj.temp = a->temp;
+                    obj.h += obj.y;
+                    obj.y = 0;
                 }
-                else
+                if (obj.x + obj.w > _input_size.width())
                 {
-                    // delete (_KpInfoYolo11 *)a->temp;
-                    a->temp = NULL;
+                    obj.w = _input_size.width() - obj.x;
                 }
+                if (obj.y + obj.h > _input_size.height())
+                {
+                    obj.h = _input_size.height() - obj.y;
+                }
+                obj.temp = a->temp;
             }
             return result;
         }
@@ -915,51 +868,6 @@ namespace maix::nn
 
         inline static float _sigmoid(float x) { return 1.0 / (1 + expf(-x)); }
 
-        inline static float _calc_iou(Object &a, Object &b)
-        {
-            float area1 = a.w * a.h;
-            float area2 = b.w * b.h;
-            float wi = std::min((a.x + a.w), (b.x + b.w)) -
-                       std::max(a.x, b.x);
-            float hi = std::min((a.y + a.h), (b.y + b.h)) -
-                       std::max(a.y, b.y);
-            float area_i = std::max(wi, 0.0f) * std::max(hi, 0.0f);
-            return area_i / (area1 + area2 - area_i);
-        }
-
-        template <typename T>
-        static int _argmax(const T *data, size_t len, size_t stride = 1)
-        {
-            int maxIndex = 0;
-            for (size_t i = 1; i < len; i++)
-            {
-                int idx = i * stride;
-                if (data[maxIndex * stride] < data[idx])
-                {
-                    maxIndex = i;
-                }
-            }
-            return maxIndex;
-        }
-
-        static float _softmax(const float* src, float* dst, int length)
-        {
-            const float alpha = *std::max_element(src, src + length);
-            float denominator = 0;
-            float dis_sum = 0;
-            for (int i = 0; i < length; ++i)
-            {
-                dst[i] = exp(src[i] - alpha);
-                denominator += dst[i];
-            }
-            for (int i = 0; i < length; ++i)
-            {
-                dst[i] /= denominator;
-                dis_sum += i * dst[i];
-            }
-            return dis_sum;
-        }
-
         static void split0(std::vector<std::string> &items, const std::string &s, const std::string &delimiter)
         {
             items.clear();
@@ -1012,6 +920,8 @@ namespace maix::nn
         std::map<string, string> _extra_info;
         float _conf_th = 0.5;
         float _iou_th = 0.45;
+        nn::NMS _nms_engine;
+        std::vector<int> _nms_keep; // indexes kept by NMS, reused every frame
     };
 
 } // namespace maix::nn
@@ -11,6 +11,8 @@
 #include "maix_image.hpp"
 #include "maix_nn_F.hpp"
 #include "maix_nn_object.hpp"
+#include "maix_nn_yolo_decoder.hpp"
+#include "maix_nn_nms.hpp"
 
 namespace maix::nn
 {
@@ -325,6 +327,8 @@ namespace maix::nn
         std::map<string, string> _extra_info;
         float _conf_th = 0.5;
         float _iou_th = 0.45;
+        nn::NMS _nms_engine;
+        std::vector<int> _nms_keep; // indexes kept by NMS, reused every frame
         bool _dual_buff;
 
     private:
@@ -403,6 +407,8 @@ namespace maix::nn
             int anchor_start = anchor_num * layer_i * 2;
             float scale_x = _input_size.width() / w;
             float scale_y = _input_size.height() / h;
+            // compare raw objectness in logit space, objectness plane is contiguous, sigmoid only for anchors passed
+            float obj_th = yolo::logit(_conf_th);
             for (int a = 0; a < anchor_num; ++a)
             {
                 for (int y = 0; y < h; ++y)
@@ -410,9 +416,9 @@ namespace maix::nn
                     for (int x = 0; x < w; ++x)
                     {
                         float *p = data + a * anchor_stride + y * w + x + s4;
-                        float obj_score = _sigmoid(*p);
-                        if (obj_score <= _conf_th)
+                        if (*p <= obj_th)
                             continue;
+                        float obj_score = _sigmoid(*p);
                         float *cls_scores = p + s;
                         int class_id = _argmax(cls_scores, class_num, s);
                         obj_score *= _sigmoid(cls_scores[class_id * s]);
@@ -434,47 +440,29 @@ namespace maix::nn
         std::vector<nn::Object> *_nms(std::vector<nn::Object> &objs)
         {
             std::vector<nn::Object> *result = new std::vector<nn::Object>();
-            std::sort(objs.begin(), objs.end(), [](const nn::Object &a, const nn::Object &b) {
-                return a.score > b.score;
-            });
-            for(size_t i=0; i < objs.size(); ++i)
+            _nms_engine.run(objs, _nms_keep, this->_iou_th);
+            for (int i : _nms_keep)
             {
                 nn::Object &a = objs.at(i);
-                if(a.score == 0)
-                    continue;
-                for(size_t j = i + 1; j < objs.size(); ++j)
+                if (a.x < 0)
                 {
-                    nn::Object &b = objs.at(j);
-                    if(b.score != 0 && a.class_id == b.class_id && _calc_iou(a, b) > this->_iou_th)
-                    {
-                        b.score = 0;
-                    }
+                    a.w += a.x;
+                    a.x = 0;
                 }
-            }
-            for(nn::Object &a :objs)
-            {
-                if(a.score != 0)
+                if (a.y < 0)
                 {
-                    if (a.x < 0)
-                    {
-                        a.w += a.x;
-                        a.x = 0;
-                    }
-                    if (a.y < 0)
-                    {
-                        a.h += a.y;
-                        a.y = 0;
-                    }
-                    if (a.x + a.w > _input_size.width())
-                    {
-                        a.w = _input_size.width() - a.x;
-                    }
-                    if (a.y + a.h > _input_size.height())
-                    {
-                        a.h = _input_size.height() - a.y;
-                    }
-                    result->push_back(a);
+                    a.h += a.y;
+                    a.y = 0;
+                }
+                if (a.x + a.w > _input_size.width())
+                {
+                    a.w = _input_size.width() - a.x;
                 }
+                if (a.y + a.h > _input_size.height())
+                {
+                    a.h = _input_size.height() - a.y;
+                }
+                result->push_back(a);
             }
             return result;
         }
@@ -571,18 +559,6 @@ namespace maix::nn
 
         inline static float _sigmoid(float x) { return 1.0 / (1 + expf(-x)); }
 
-        inline static float _calc_iou(Object &a, Object &b)
-        {
-            float area1 = a.w * a.h;
-            float area2 = b.w * b.h;
-            float wi = std::min((a.x + a.w), (b.x + b.w)) -
-                       std::max(a.x, b.x);
-            float hi = std::min((a.y + a.h), (b.y + b.h)) -
-                       std::max(a.y, b.y);
-            float area_i = std::max(wi, 0.0f) * std::max(hi, 0.0f);
-            return area_i / (area1 + area2 - area_i);
-        }
-
         template <typename T>
         static int _argmax(const T *data, size_t len, size_t stride = 1)
         {
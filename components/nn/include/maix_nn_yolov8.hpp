@@ -102,6 +102,15 @@ namespace maix::nn
          */
         // void draw_pose(image::Image &img, std::vector<int> points, int radius = 4, image::Color color = image::COLOR_RED, const std::vector<image::Color> &colors = std::vector<image::Color>(), bool body = true, bool close = false);
 
+        /**
+         * Set segmentation mask output of detect, only for yolov8-seg model.
+         * @param threshold < 0: object's seg_mask is grayscale image of probability * 255, default -1.
+         *                  >= 0: object's seg_mask is image.Format.FMT_BITMAP image, bit is 1 if probability > threshold.
+         * @param bilinear true: resize mask to object size with bilinear interpolation, false: nearest neighbor, default false.
+         * @maixpy maix.nn.YOLOv8.set_seg_mask
+         */
+        // void set_seg_mask(float threshold = -1, bool bilinear = false);
+
         /**
          * Draw segmentation on image
          * @param img image object, maix.image.Image type.
@@ -1,13 +1,984 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add ONNX Runtime CPU backend NN_ONNX.
+ *         2026.10.19: Add forward_image_batch, forward multiple images in one run for model with batch dimension.
+ */
 
-#include "maix_nn.hpp"
+#include "maix_nn_linux.hpp"
+#include "maix_basic.hpp"
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <string.h>
+#include <stdlib.h>
+#if HAVE_ONNXRUNTIME
+#include "onnxruntime/onnxruntime_cxx_api.h"
+#endif
 
 namespace maix::nn
 {
     err::Err mud_load_raw_model(const std::string &model_path, MUD *mud_obj)
     {
-        log::error("mud_load_raw_model not impl yet");
+        size_t len = model_path.size();
+        if (len > 5 && model_path.compare(len - 5, 5, ".onnx") == 0)
+        {
+            mud_obj->type = "onnx";
+            mud_obj->items["basic"]["type"] = "onnx";
+            mud_obj->items["basic"]["model"] = fs::basename(model_path);
+            mud_obj->items["extra"];
+            return err::ERR_NONE;
+        }
+        log::error("only support .onnx raw model on this platform");
         return err::ERR_NOT_IMPL;
     }
 
-} // namespace maix::nn
+#if HAVE_ONNXRUNTIME
+
+    // one set of input and output buffers bound to the session, two sets for dual buff mode
+    typedef struct
+    {
+        Ort::IoBinding *binding;
+        std::vector<std::vector<uint8_t>> in_buff;  // model side input data
+        std::vector<std::vector<uint8_t>> out_buff; // model side output data, empty for dynamic shape output
+        std::vector<std::vector<int32_t>> cvt_buff; // int64 output converted to int32
+        std::vector<Ort::Value> dyn_values;         // outputs of last run, hold memory of dynamic shape outputs
+        std::vector<std::vector<int>> out_shapes;   // output shapes of last run
+        std::vector<tensor::Tensor *> out_tensors;  // outputs returned without copy, point to output buffers, reused every run
+        err::Err err;                               // error of last run
+    } onnx_slot_t;
+
+    typedef struct
+    {
+        Ort::Session *session;
+        Ort::RunOptions run_options;
+        std::vector<std::string> in_names;
+        std::vector<std::string> out_names;
+        std::vector<ONNXTensorElementDataType> in_types;
+        std::vector<ONNXTensorElementDataType> out_types;
+        std::vector<std::vector<int64_t>> in_shapes;
+        std::vector<std::vector<int64_t>> out_shapes; // empty if dynamic shape
+        std::vector<nn::LayerInfo> inputs;
+        std::vector<nn::LayerInfo> outputs;
+        onnx_slot_t slots[2];
+        int cur; // slot to fill input
+        int64_t batch;          // batch dim of model input, 0 if dynamic
+        onnx_slot_t batch_slot; // slot of forward_image_batch, all outputs are dynamic
+        int batch_slot_n;       // image number batch_slot bound for, 0 if not bound
+
+        // dual buff
+        std::thread *thread;
+        std::mutex lock;
+        std::condition_variable cond_job;
+        std::condition_variable cond_done;
+        int running; // slot running by thread, -1 if idle
+        int pending; // slot finished and result not taken, -1 if none
+        bool exit;
+    } onnx_t;
+
+    static Ort::Env &_onnx_env()
+    {
+        // one env for all sessions, never freed to avoid destruct order problem at exit
+        static Ort::Env *env = new Ort::Env(ORT_LOGGING_LEVEL_WARNING, "maix_nn");
+        return *env;
+    }
+
+    // map onnx type to tensor dtype, int64 is converted to int32 as tensor has no int64 type
+    static bool _onnx_dtype(ONNXTensorElementDataType type, tensor::DType &dtype, int &elem_size)
+    {
+        switch (type)
+        {
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+            dtype = tensor::FLOAT32, elem_size = 4;
+            break;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+            dtype = tensor::UINT8, elem_size = 1;
+            break;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+            dtype = tensor::INT8, elem_size = 1;
+            break;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16:
+            dtype = tensor::UINT16, elem_size = 2;
+            break;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16:
+            dtype = tensor::INT16, elem_size = 2;
+            break;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT32:
+            dtype = tensor::UINT32, elem_size = 4;
+            break;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32:
+            dtype = tensor::INT32, elem_size = 4;
+            break;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64:
+            dtype = tensor::INT32, elem_size = 8;
+            break;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+            dtype = tensor::FLOAT16, elem_size = 2;
+            break;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE:
+            dtype = tensor::FLOAT64, elem_size = 8;
+            break;
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_BOOL:
+            dtype = tensor::BOOL, elem_size = 1;
+            break;
+        default:
+            return false;
+        }
+        return true;
+    }
+
+    static int64_t _onnx_elem_num(const std::vector<int64_t> &shape)
+    {
+        int64_t n = 1;
+        for (auto d : shape)
+            n *= d;
+        return n;
+    }
+
+    static int _onnx_elem_size(ONNXTensorElementDataType type)
+    {
+        tensor::DType dtype;
+        int size = 0;
+        _onnx_dtype(type, dtype, size);
+        return size;
+    }
+
+    static int _mud_int(const MUD &mud, const std::string &key, int default_value)
+    {
+        auto sect = mud.items.find("basic");
+        if (sect == mud.items.end())
+            return default_value;
+        auto it = sect->second.find(key);
+        if (it == sect->second.end())
+            return default_value;
+        return atoi(it->second.c_str());
+    }
+
+    static void _onnx_free_slot(onnx_slot_t &s)
+    {
+        if (s.binding)
+        {
+            delete s.binding;
+            s.binding = nullptr;
+        }
+        s.in_buff.clear();
+        s.out_buff.clear();
+        s.cvt_buff.clear();
+        s.dyn_values.clear();
+        s.out_shapes.clear();
+        for (auto t : s.out_tensors)
+            delete t;
+        s.out_tensors.clear();
+    }
+
+    static void _onnx_free_slots(onnx_t *o)
+    {
+        _onnx_free_slot(o->slots[0]);
+        _onnx_free_slot(o->slots[1]);
+        _onnx_free_slot(o->batch_slot);
+        o->batch_slot_n = 0;
+    }
+
+    // allocate input and output buffers of slot and bind them to session
+    static err::Err _onnx_init_slot(onnx_t *o, onnx_slot_t &s)
+    {
+        Ort::MemoryInfo mem_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+        size_t in_num = o->in_names.size(), out_num = o->out_names.size();
+        try
+        {
+            s.binding = new Ort::IoBinding(*o->session);
+            s.in_buff.resize(in_num);
+            for (size_t i = 0; i < in_num; i++)
+            {
+                size_t bytes = _onnx_elem_num(o->in_shapes[i]) * _onnx_elem_size(o->in_types[i]);
+                s.in_buff[i].assign(bytes, 0);
+                Ort::Value v = Ort::Value::CreateTensor(mem_info, s.in_buff[i].data(), bytes, o->in_shapes[i].data(), o->in_shapes[i].size(), o->in_types[i]);
+                s.binding->BindInput(o->in_names[i].c_str(), v);
+            }
+            s.out_buff.resize(out_num);
+            s.cvt_buff.resize(out_num);
+            s.out_shapes.resize(out_num);
+            for (size_t i = 0; i < out_num; i++)
+            {
+                if (o->out_shapes[i].empty())
+                {
+                    // dynamic shape, runtime allocates output every run
+                    s.binding->BindOutput(o->out_names[i].c_str(), mem_info);
+                    continue;
+                }
+                int64_t n = _onnx_elem_num(o->out_shapes[i]);
+                size_t bytes = n * _onnx_elem_size(o->out_types[i]);
+                s.out_buff[i].resize(bytes);
+                if (o->out_types[i] == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64)
+                    s.cvt_buff[i].resize(n);
+                s.out_shapes[i] = o->outputs[i].shape;
+                Ort::Value v = Ort::Value::CreateTensor(mem_info, s.out_buff[i].data(), bytes, o->out_shapes[i].data(), o->out_shapes[i].size(), o->out_types[i]);
+                s.binding->BindOutput(o->out_names[i].c_str(), v);
+            }
+        }
+        catch (const Ort::Exception &e)
+        {
+            log::error("onnx bind buffers failed: %s", e.what());
+            return err::ERR_NO_MEM;
+        }
+        s.err = err::ERR_NONE;
+        return err::ERR_NONE;
+    }
+
+    // run model with inputs in slot, outputs are written to slot
+    static err::Err _onnx_run_slot(onnx_t *o, onnx_slot_t &s)
+    {
+        try
+        {
+            o->session->Run(o->run_options, *s.binding);
+        }
+        catch (const Ort::Exception &e)
+        {
+            log::error("onnx run failed: %s", e.what());
+            return err::ERR_RUNTIME;
+        }
+        size_t out_num = o->out_names.size();
+        bool dyn = false;
+        for (size_t i = 0; i < out_num; i++)
+        {
+            if (o->out_shapes[i].empty())
+                dyn = true;
+        }
+        if (dyn)
+        {
+            s.dyn_values = s.binding->GetOutputValues();
+            for (size_t i = 0; i < out_num; i++)
+            {
+                if (!o->out_shapes[i].empty())
+                    continue;
+                std::vector<int64_t> shape = s.dyn_values[i].GetTensorTypeAndShapeInfo().GetShape();
+                s.out_shapes[i].assign(shape.begin(), shape.end());
+                if (o->out_types[i] == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64)
+                    s.cvt_buff[i].resize(_onnx_elem_num(shape));
+            }
+        }
+        for (size_t i = 0; i < out_num; i++)
+        {
+            if (o->out_types[i] != ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64)
+                continue;
+            const int64_t *src = o->out_shapes[i].empty() ? s.dyn_values[i].GetTensorMutableData<int64_t>() : (const int64_t *)s.out_buff[i].data();
+            int32_t *dst = s.cvt_buff[i].data();
+            size_t n = s.cvt_buff[i].size();
+            for (size_t k = 0; k < n; k++)
+                dst[k] = (int32_t)src[k];
+        }
+        return err::ERR_NONE;
+    }
+
+    // data of output i in slot, in tensor dtype
+    static void *_onnx_out_data(onnx_t *o, onnx_slot_t &s, int i)
+    {
+        if (o->out_types[i] == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64)
+            return s.cvt_buff[i].data();
+        if (o->out_shapes[i].empty())
+            return s.dyn_values[i].GetTensorMutableData<uint8_t>();
+        return s.out_buff[i].data();
+    }
+
+    static void _onnx_thread(onnx_t *o)
+    {
+        std::unique_lock<std::mutex> lock(o->lock);
+        while (1)
+        {
+            o->cond_job.wait(lock, [o]
+                             { return o->exit || o->running >= 0; });
+            if (o->exit)
+                break;
+            int slot = o->running;
+            lock.unlock();
+            err::Err e = _onnx_run_slot(o, o->slots[slot]);
+            lock.lock();
+            o->slots[slot].err = e;
+            o->pending = slot;
+            o->running = -1;
+            o->cond_done.notify_all();
+        }
+    }
+
+    static void _onnx_stop_thread(onnx_t *o)
+    {
+        if (!o->thread)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(o->lock);
+            o->exit = true;
+        }
+        o->cond_job.notify_all();
+        o->thread->join();
+        delete o->thread;
+        o->thread = nullptr;
+        o->exit = false;
+        o->running = -1;
+        o->pending = -1;
+        o->cur = 0;
+    }
+
+    /**
+     * Run model with inputs already filled in slot o->cur.
+     * Not dual buff: run and return o->cur.
+     * Dual buff: start running o->cur in thread and return the slot finished last time, -1 if not ready,
+     *            if wait, run o->cur and return it.
+     * Returned slot's outputs are valid until next run.
+     */
+    static int _onnx_run(onnx_t *o, bool dual_buff, bool wait, err::Err &e)
+    {
+        int slot = o->cur;
+        if (!dual_buff || !o->thread)
+        {
+            e = _onnx_run_slot(o, o->slots[slot]);
+            return e == err::ERR_NONE ? slot : -1;
+        }
+        std::unique_lock<std::mutex> lock(o->lock);
+        o->cond_done.wait(lock, [o]
+                          { return o->running < 0; });
+        int prev = o->pending;
+        o->pending = -1;
+        if (wait)
+        {
+            lock.unlock();
+            e = _onnx_run_slot(o, o->slots[slot]);
+            return e == err::ERR_NONE ? slot : -1;
+        }
+        o->running = slot;
+        o->cond_job.notify_one();
+        o->cur = 1 - slot;
+        if (prev < 0)
+        {
+            e = err::ERR_NOT_READY;
+            return -1;
+        }
+        e = o->slots[prev].err;
+        return e == err::ERR_NONE ? prev : -1;
+    }
+
+    // copy input tensor to model input buffer
+    static err::Err _onnx_set_input(onnx_t *o, onnx_slot_t &s, int i, tensor::Tensor &t)
+    {
+        int64_t n = _onnx_elem_num(o->in_shapes[i]);
+        if (t.size_int() != n)
+        {
+            log::error("input %s size %d not match model's %d", o->in_names[i].c_str(), t.size_int(), (int)n);
+            return err::ERR_ARGS;
+        }
+        if (t.dtype() != o->inputs[i].dtype)
+        {
+            log::error("input %s dtype %s not match model's %s", o->in_names[i].c_str(),
+                       tensor::dtype_name[t.dtype()].c_str(), tensor::dtype_name[o->inputs[i].dtype].c_str());
+            return err::ERR_ARGS;
+        }
+        if (o->in_types[i] == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64)
+        {
+            const int32_t *src = (const int32_t *)t.data();
+            int64_t *dst = (int64_t *)s.in_buff[i].data();
+            for (int64_t k = 0; k < n; k++)
+                dst[k] = src[k];
+        }
+        else
+        {
+            memcpy(s.in_buff[i].data(), t.data(), s.in_buff[i].size());
+        }
+        return err::ERR_NONE;
+    }
+
+    // put outputs of slot to tensors, copy or share model's output buffer
+    static void _onnx_get_outputs(onnx_t *o, onnx_slot_t &s, tensor::Tensors &outputs, bool copy_result)
+    {
+        for (size_t i = 0; i < o->out_names.size(); i++)
+        {
+            const std::string &name = o->out_names[i];
+            void *data = _onnx_out_data(o, s, i);
+            tensor::DType dtype = o->outputs[i].dtype;
+            auto it = outputs.tensors.find(name);
+            if (it != outputs.tensors.end())
+            {
+                // allocated by caller
+                tensor::Tensor *t = it->second;
+                int n = 1;
+                for (auto d : s.out_shapes[i])
+                    n *= d;
+                if (t->dtype() != dtype || t->size_int() != n)
+                {
+                    log::warn("output tensor %s size not match, reallocate", name.c_str());
+                    outputs.rm_tensor(name);
+                }
+                else
+                {
+                    memcpy(t->data(), data, n * tensor::dtype_size[dtype]);
+                    continue;
+                }
+            }
+            if (copy_result)
+            {
+                outputs.add_tensor(name, new tensor::Tensor(s.out_shapes[i], dtype, data, true), false, true);
+                continue;
+            }
+            // share output buffer, tensor object is kept by slot, only created again when dynamic output changed
+            if (s.out_tensors.size() < o->out_names.size())
+                s.out_tensors.resize(o->out_names.size(), nullptr);
+            tensor::Tensor *&t = s.out_tensors[i];
+            if (!t || t->data() != data || t->shape() != s.out_shapes[i])
+            {
+                delete t;
+                t = new tensor::Tensor(s.out_shapes[i], dtype, data, false);
+            }
+            outputs.add_tensor(name, t, false, false);
+        }
+    }
+
+    static void _onnx_check_image(onnx_t *o, image::Image &img, bool chw)
+    {
+        nn::LayerInfo &info = o->inputs[0];
+        bool nchw = info.layout == nn::Layout::NCHW;
+        // layout comes from model(or extra.input_layout of mud), image is converted to it,
+        // only hwc input asked for a chw model can not be satisfied
+        if (!chw && nchw)
+        {
+            log::error("model input layout is NCHW but chw is false, set extra.input_layout to nhwc in mud file if model input is NHWC");
+            throw err::Exception(err::ERR_ARGS, "model input layout not match chw arg");
+        }
+        int c = nchw ? info.shape[1] : info.shape[3];
+        int h = nchw ? info.shape[2] : info.shape[1];
+        int w = nchw ? info.shape[3] : info.shape[2];
+        if (img.width() != w || img.height() != h || image::fmt_size[img.format()] != c || !img.is_contiguous())
+        {
+            log::error("image %dx%d %d channels not match model input %dx%d %d channels", img.width(), img.height(), (int)image::fmt_size[img.format()], w, h, c);
+            throw err::Exception(err::ERR_ARGS, "image not match model input");
+        }
+    }
 
+    /**
+     * Check mean, scale and model input dtype for image input,
+     * return normalize lookup table of every channel for float32 input, empty for uint8 input.
+     */
+    static std::vector<float> _onnx_image_lut(onnx_t *o, std::vector<float> &mean, std::vector<float> &scale)
+    {
+        nn::LayerInfo &info = o->inputs[0];
+        int c = info.layout == nn::Layout::NCHW ? info.shape[1] : info.shape[3];
+        if ((!mean.empty() && mean.size() != (size_t)c && mean.size() != 1) || (!scale.empty() && scale.size() != (size_t)c && scale.size() != 1))
+            throw err::Exception(err::ERR_ARGS, "mean and scale size should be 0, 1 or channel number");
+        std::vector<float> lut;
+        if (o->in_types[0] == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT)
+        {
+            lut.resize(256 * c);
+            for (int k = 0; k < c; k++)
+            {
+                float m = mean.empty() ? 0 : mean[mean.size() == 1 ? 0 : k];
+                float sc = scale.empty() ? 1 : scale[scale.size() == 1 ? 0 : k];
+                for (int v = 0; v < 256; v++)
+                    lut[k * 256 + v] = (v - m) * sc;
+            }
+        }
+        else if (o->in_types[0] != ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8)
+        {
+            log::error("forward_image only support float32 or uint8 input, model input is %s", tensor::dtype_name[info.dtype].c_str());
+            throw err::Exception(err::ERR_NOT_IMPL, "model input dtype not support");
+        }
+        return lut;
+    }
+
+    // convert one HWC image to model input layout at dst, image size is already checked
+    static void _onnx_fill_image(onnx_t *o, const uint8_t *src, void *dst_buff, const std::vector<float> &lut)
+    {
+        nn::LayerInfo &info = o->inputs[0];
+        bool nchw = info.layout == nn::Layout::NCHW;
+        int c = nchw ? info.shape[1] : info.shape[3];
+        int h = nchw ? info.shape[2] : info.shape[1];
+        int w = nchw ? info.shape[3] : info.shape[2];
+        int plane = w * h;
+        if (o->in_types[0] == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT)
+        {
+            float *dst = (float *)dst_buff;
+            #pragma omp parallel for
+            for (int y = 0; y < h; y++)
+            {
+                const uint8_t *p = src + y * w * c;
+                if (nchw)
+                {
+                    for (int k = 0; k < c; k++)
+                    {
+                        const float *l = lut.data() + k * 256;
+                        float *d = dst + k * plane + y * w;
+                        for (int x = 0; x < w; x++)
+                            d[x] = l[p[x * c + k]];
+                    }
+                }
+                else
+                {
+                    float *d = dst + y * w * c;
+                    for (int x = 0; x < w * c; x++)
+                        d[x] = lut[(x % c) * 256 + p[x]];
+                }
+            }
+        }
+        else
+        {
+            uint8_t *dst = (uint8_t *)dst_buff;
+            if (!nchw || c == 1)
+            {
+                memcpy(dst, src, plane * c);
+            }
+            else
+            {
+                #pragma omp parallel for
+                for (int y = 0; y < h; y++)
+                {
+                    const uint8_t *p = src + y * w * c;
+                    for (int k = 0; k < c; k++)
+                    {
+                        uint8_t *d = dst + k * plane + y * w;
+                        for (int x = 0; x < w; x++)
+                            d[x] = p[x * c + k];
+                    }
+                }
+            }
+        }
+    }
+
+    // bind batch slot for n images, input buffer is reused, all outputs are allocated by runtime as their batch dim changes with n
+    static err::Err _onnx_bind_batch(onnx_t *o, int n)
+    {
+        if (o->batch_slot_n == n)
+            return err::ERR_NONE;
+        onnx_slot_t &s = o->batch_slot;
+        if (s.binding)
+        {
+            delete s.binding;
+            s.binding = nullptr;
+        }
+        o->batch_slot_n = 0;
+        Ort::MemoryInfo mem_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+        try
+        {
+            std::vector<int64_t> shape = o->in_shapes[0];
+            shape[0] = n;
+            size_t bytes = _onnx_elem_num(shape) * _onnx_elem_size(o->in_types[0]);
+            s.in_buff.resize(1);
+            s.in_buff[0].resize(bytes);
+            s.binding = new Ort::IoBinding(*o->session);
+            Ort::Value v = Ort::Value::CreateTensor(mem_info, s.in_buff[0].data(), bytes, shape.data(), shape.size(), o->in_types[0]);
+            s.binding->BindInput(o->in_names[0].c_str(), v);
+            for (size_t i = 0; i < o->out_names.size(); i++)
+                s.binding->BindOutput(o->out_names[i].c_str(), mem_info);
+        }
+        catch (const Ort::Exception &e)
+        {
+            log::error("onnx bind batch buffers failed: %s", e.what());
+            return err::ERR_NO_MEM;
+        }
+        o->batch_slot_n = n;
+        return err::ERR_NONE;
+    }
+
+    // split batch outputs along dim 0, append count images' outputs to res
+    static void _onnx_split_batch(onnx_t *o, std::vector<Ort::Value> &values, int n, int count, std::vector<tensor::Tensors *> &res)
+    {
+        size_t base = res.size();
+        for (int i = 0; i < count; i++)
+            res.push_back(new tensor::Tensors());
+        for (size_t k = 0; k < o->out_names.size(); k++)
+        {
+            std::vector<int64_t> shape = values[k].GetTensorTypeAndShapeInfo().GetShape();
+            if (shape.empty() || shape[0] != n)
+            {
+                log::error("output %s have no batch dimension", o->out_names[k].c_str());
+                throw err::Exception(err::ERR_NOT_IMPL, "output have no batch dimension");
+            }
+            tensor::DType dtype = o->outputs[k].dtype;
+            int elem_size = _onnx_elem_size(o->out_types[k]);
+            int64_t per = _onnx_elem_num(shape) / n;
+            std::vector<int> one(shape.begin(), shape.end());
+            one[0] = 1;
+            const uint8_t *src = values[k].GetTensorMutableData<uint8_t>();
+            for (int i = 0; i < count; i++)
+            {
+                tensor::Tensor *t = new tensor::Tensor(one, dtype);
+                const uint8_t *p = src + i * per * elem_size;
+                if (o->out_types[k] == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64)
+                {
+                    int32_t *dst = (int32_t *)t->data();
+                    for (int64_t j = 0; j < per; j++)
+                        dst[j] = (int32_t)((const int64_t *)p)[j];
+                }
+                else
+                {
+                    memcpy(t->data(), p, per * elem_size);
+                }
+                res[base + i]->add_tensor(o->out_names[k], t, false, true);
+            }
+        }
+    }
+
+    NN_ONNX::NN_ONNX(bool dual_buff)
+    {
+        _loaded = false;
+        _enable_dual_buff = dual_buff;
+        onnx_t *o = new onnx_t();
+        o->session = nullptr;
+        o->slots[0].binding = nullptr;
+        o->slots[1].binding = nullptr;
+        o->cur = 0;
+        o->batch = 1;
+        o->batch_slot.binding = nullptr;
+        o->batch_slot_n = 0;
+        o->thread = nullptr;
+        o->running = -1;
+        o->pending = -1;
+        o->exit = false;
+        _data = o;
+    }
+
+    NN_ONNX::~NN_ONNX()
+    {
+        unload();
+        delete (onnx_t *)_data;
+        _data = nullptr;
+    }
+
+    err::Err NN_ONNX::load(const MUD &mud, const std::string &dir)
+    {
+        onnx_t *o = (onnx_t *)_data;
+        if (_loaded)
+        {
+            log::error("model already loaded");
+            return err::ERR_NOT_PERMIT;
+        }
+        if (mud.type != "onnx")
+        {
+            log::error("model type %s not support, only support onnx on this platform", mud.type.c_str());
+            return err::ERR_ARGS;
+        }
+        auto basic = mud.items.find("basic");
+        if (basic == mud.items.end() || basic->second.find("model") == basic->second.end())
+        {
+            log::error("model key not found in basic section of mud");
+            return err::ERR_ARGS;
+        }
+        std::string model_path = dir + "/" + basic->second.at("model");
+        if (!fs::exists(model_path))
+        {
+            log::error("model file %s not exists", model_path.c_str());
+            return err::ERR_NOT_FOUND;
+        }
+        int intra_threads = _mud_int(mud, "intra_threads", 0);
+        int inter_threads = _mud_int(mud, "inter_threads", 1);
+
+        try
+        {
+            Ort::SessionOptions options;
+            options.SetIntraOpNumThreads(intra_threads);
+            options.SetInterOpNumThreads(inter_threads);
+            if (inter_threads > 1)
+                options.SetExecutionMode(ExecutionMode::ORT_PARALLEL);
+            options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+            o->session = new Ort::Session(_onnx_env(), model_path.c_str(), options);
+
+            Ort::AllocatorWithDefaultOptions allocator;
+            size_t in_num = o->session->GetInputCount();
+            size_t out_num = o->session->GetOutputCount();
+            for (size_t i = 0; i < in_num; i++)
+            {
+                o->in_names.push_back(o->session->GetInputNameAllocated(i, allocator).get());
+                Ort::TypeInfo type_info = o->session->GetInputTypeInfo(i);
+                if (type_info.GetONNXType() != ONNX_TYPE_TENSOR)
+                {
+                    log::error("input %s is not tensor", o->in_names[i].c_str());
+                    throw err::Exception(err::ERR_NOT_IMPL, "input type not support");
+                }
+                auto info = type_info.GetTensorTypeAndShapeInfo();
+                std::vector<int64_t> shape = info.GetShape();
+                if (i == 0 && !shape.empty())
+                    o->batch = shape[0] > 0 ? shape[0] : 0;
+                for (size_t k = 0; k < shape.size(); k++)
+                {
+                    if (shape[k] > 0)
+                        continue;
+                    if (k != 0)
+                    {
+                        log::error("input %s dim %d is dynamic, please export model with fixed input shape", o->in_names[i].c_str(), (int)k);
+                        throw err::Exception(err::ERR_NOT_IMPL, "dynamic input shape");
+                    }
+                    shape[k] = 1; // batch
+                }
+                nn::LayerInfo layer(o->in_names[i]);
+                int elem_size;
+                if (!_onnx_dtype(info.GetElementType(), layer.dtype, elem_size))
+                {
+                    log::error("input %s element type %d not support", o->in_names[i].c_str(), (int)info.GetElementType());
+                    throw err::Exception(err::ERR_NOT_IMPL, "input type not support");
+                }
+                layer.shape.assign(shape.begin(), shape.end());
+                if (shape.size() == 4)
+                {
+                    auto layout = mud.items.find("extra");
+                    std::string layout_str;
+                    if (layout != mud.items.end() && layout->second.find("input_layout") != layout->second.end())
+                        layout_str = layout->second.at("input_layout");
+                    if (layout_str == "nhwc" || (layout_str != "nchw" && shape[3] <= 4 && shape[1] > 4))
+                        layer.layout = nn::Layout::NHWC;
+                    else
+                        layer.layout = nn::Layout::NCHW;
+                }
+                o->in_types.push_back(info.GetElementType());
+                o->in_shapes.push_back(shape);
+                o->inputs.push_back(layer);
+            }
+            for (size_t i = 0; i < out_num; i++)
+            {
+                o->out_names.push_back(o->session->GetOutputNameAllocated(i, allocator).get());
+                Ort::TypeInfo type_info = o->session->GetOutputTypeInfo(i);
+                if (type_info.GetONNXType() != ONNX_TYPE_TENSOR)
+                {
+                    log::error("output %s is not tensor", o->out_names[i].c_str());
+                    throw err::Exception(err::ERR_NOT_IMPL, "output type not support");
+                }
+                auto info = type_info.GetTensorTypeAndShapeInfo();
+                std::vector<int64_t> shape = info.GetShape();
+                nn::LayerInfo layer(o->out_names[i]);
+                int elem_size;
+                if (!_onnx_dtype(info.GetElementType(), layer.dtype, elem_size))
+                {
+                    log::error("output %s element type %d not support", o->out_names[i].c_str(), (int)info.GetElementType());
+                    throw err::Exception(err::ERR_NOT_IMPL, "output type not support");
+                }
+                bool dynamic = false;
+                for (auto d : shape)
+                {
+                    if (d <= 0)
+                        dynamic = true;
+                }
+                layer.shape.assign(shape.begin(), shape.end());
+                o->out_types.push_back(info.GetElementType());
+                o->out_shapes.push_back(dynamic ? std::vector<int64_t>() : shape);
+                o->outputs.push_back(layer);
+            }
+        }
+        catch (const Ort::Exception &e)
+        {
+            log::error("load onnx model %s failed: %s", model_path.c_str(), e.what());
+            _loaded = true;
+            unload();
+            return err::ERR_RUNTIME;
+        }
+        catch (const err::Exception &e)
+        {
+            _loaded = true;
+            unload();
+            return e.code();
+        }
+
+        for (int i = 0; i < 2; i++)
+        {
+            err::Err e = _onnx_init_slot(o, o->slots[i]);
+            if (e != err::ERR_NONE)
+            {
+                _loaded = true;
+                unload();
+                return e;
+            }
+        }
+        // first run initializes kernels, and gets real shape of dynamic shape outputs
+        err::Err e = _onnx_run_slot(o, o->slots[0]);
+        if (e != err::ERR_NONE)
+        {
+            _loaded = true;
+            unload();
+            return e;
+        }
+        for (size_t i = 0; i < o->out_names.size(); i++)
+        {
+            if (o->out_shapes[i].empty())
+                o->outputs[i].shape = o->slots[0].out_shapes[i];
+        }
+        o->cur = 0;
+        if (_enable_dual_buff)
+            o->thread = new std::thread(_onnx_thread, o);
+        _loaded = true;
+        return err::ERR_NONE;
+    }
+
+    err::Err NN_ONNX::unload()
+    {
+        onnx_t *o = (onnx_t *)_data;
+        if (!_loaded)
+            return err::ERR_NONE;
+        _onnx_stop_thread(o);
+        _onnx_free_slots(o);
+        if (o->session)
+        {
+            delete o->session;
+            o->session = nullptr;
+        }
+        o->in_names.clear();
+        o->out_names.clear();
+        o->in_types.clear();
+        o->out_types.clear();
+        o->in_shapes.clear();
+        o->out_shapes.clear();
+        o->inputs.clear();
+        o->outputs.clear();
+        o->cur = 0;
+        _loaded = false;
+        return err::ERR_NONE;
+    }
+
+    bool NN_ONNX::loaded()
+    {
+        return _loaded;
+    }
+
+    void NN_ONNX::set_dual_buff(bool enable)
+    {
+        onnx_t *o = (onnx_t *)_data;
+        _enable_dual_buff = enable;
+        if (!_loaded)
+            return;
+        if (enable && !o->thread)
+            o->thread = new std::thread(_onnx_thread, o);
+        else if (!enable)
+            _onnx_stop_thread(o);
+    }
+
+    std::vector<LayerInfo> NN_ONNX::inputs_info()
+    {
+        onnx_t *o = (onnx_t *)_data;
+        return o->inputs;
+    }
+
+    std::vector<LayerInfo> NN_ONNX::outputs_info()
+    {
+        onnx_t *o = (onnx_t *)_data;
+        return o->outputs;
+    }
+
+    err::Err NN_ONNX::forward(tensor::Tensors &inputs, tensor::Tensors &outputs, bool copy_result, bool dual_buff_wait)
+    {
+        onnx_t *o = (onnx_t *)_data;
+        if (!_loaded)
+        {
+            log::error("model not loaded");
+            return err::ERR_NOT_READY;
+        }
+        if (inputs.size() != o->in_names.size())
+        {
+            log::error("model need %d inputs, but got %d", (int)o->in_names.size(), (int)inputs.size());
+            return err::ERR_ARGS;
+        }
+        onnx_slot_t &s = o->slots[o->cur];
+        for (size_t i = 0; i < o->in_names.size(); i++)
+        {
+            // find by name, or by order if names not match
+            auto it = inputs.tensors.find(o->in_names[i]);
+            tensor::Tensor &t = it != inputs.tensors.end() ? *it->second : inputs[(int)i];
+            err::Err e = _onnx_set_input(o, s, i, t);
+            if (e != err::ERR_NONE)
+                return e;
+        }
+        err::Err e;
+        int slot = _onnx_run(o, _enable_dual_buff, dual_buff_wait, e);
+        if (slot < 0)
+            return e;
+        _onnx_get_outputs(o, o->slots[slot], outputs, copy_result);
+        return err::ERR_NONE;
+    }
+
+    tensor::Tensors *NN_ONNX::forward(tensor::Tensors &inputs, bool copy_result, bool dual_buff_wait)
+    {
+        tensor::Tensors *outputs = new tensor::Tensors();
+        err::Err e = forward(inputs, *outputs, copy_result, dual_buff_wait);
+        if (e != err::ERR_NONE)
+        {
+            delete outputs;
+            if (e == err::ERR_NOT_READY && _enable_dual_buff)
+                return nullptr;
+            throw err::Exception(e, "forward failed");
+        }
+        return outputs;
+    }
+
+    tensor::Tensors *NN_ONNX::forward_image(image::Image &img, std::vector<float> mean, std::vector<float> scale, image::Fit fit, bool copy_result, bool dual_buff_wait, bool chw)
+    {
+        onnx_t *o = (onnx_t *)_data;
+        if (!_loaded)
+            throw err::Exception(err::ERR_NOT_READY, "model not loaded");
+        if (o->inputs.size() != 1 || o->inputs[0].shape.size() != 4)
+            throw err::Exception(err::ERR_ARGS, "forward_image only support model with one 4 dims input");
+        _onnx_check_image(o, img, chw);
+        std::vector<float> lut = _onnx_image_lut(o, mean, scale);
+        _onnx_fill_image(o, (const uint8_t *)img.data(), o->slots[o->cur].in_buff[0].data(), lut);
+        err::Err e;
+        int slot = _onnx_run(o, _enable_dual_buff, dual_buff_wait, e);
+        if (slot < 0)
+        {
+            if (e == err::ERR_NOT_READY)
+                return nullptr;
+            throw err::Exception(e, "forward failed");
+        }
+        tensor::Tensors *outputs = new tensor::Tensors();
+        _onnx_get_outputs(o, o->slots[slot], *outputs, copy_result);
+        return outputs;
+    }
+
+    std::vector<tensor::Tensors *> NN_ONNX::forward_image_batch(std::vector<image::Image *> &imgs, std::vector<float> &mean, std::vector<float> &scale, bool chw)
+    {
+        onnx_t *o = (onnx_t *)_data;
+        std::vector<tensor::Tensors *> res;
+        if (!_loaded)
+            throw err::Exception(err::ERR_NOT_READY, "model not loaded");
+        if (o->inputs.size() != 1 || o->inputs[0].shape.size() != 4)
+            throw err::Exception(err::ERR_ARGS, "forward_image only support model with one 4 dims input");
+        if (o->batch == 1 || imgs.empty())
+            return res;
+        for (auto img : imgs)
+            _onnx_check_image(o, *img, chw);
+        std::vector<float> lut = _onnx_image_lut(o, mean, scale);
+        int num = (int)imgs.size();
+        int n = o->batch > 0 ? (int)o->batch : num; // images of one run
+        err::Err e = _onnx_bind_batch(o, n);
+        if (e != err::ERR_NONE)
+            throw err::Exception(e, "bind batch buffers failed");
+        onnx_slot_t &s = o->batch_slot;
+        size_t img_bytes = s.in_buff[0].size() / n;
+        try
+        {
+            for (int start = 0; start < num; start += n)
+            {
+                int count = std::min(n, num - start);
+                uint8_t *dst = s.in_buff[0].data();
+                // pad images of fixed batch keep data of last run, their outputs are dropped
+                #pragma omp parallel for
+                for (int i = 0; i < count; i++)
+                    _onnx_fill_image(o, (const uint8_t *)imgs[start + i]->data(), dst + i * img_bytes, lut);
+                try
+                {
+                    o->session->Run(o->run_options, *s.binding);
+                    s.dyn_values = s.binding->GetOutputValues();
+                }
+                catch (const Ort::Exception &ex)
+                {
+                    log::error("onnx run failed: %s", ex.what());
+                    throw err::Exception(err::ERR_RUNTIME, "forward failed");
+                }
+                _onnx_split_batch(o, s.dyn_values, n, count, res);
+            }
+        }
+        catch (...)
+        {
+            for (auto t : res)
+                delete t;
+            throw;
+        }
+        s.dyn_values.clear();
+        return res;
+    }
+
+#endif // HAVE_ONNXRUNTIME
+
+} // namespace maix::nn
@@ -6,4 +6,100 @@ namespace maix::nn
 {
     err::Err mud_load_raw_model(const std::string &model_path, MUD *mud_obj);
 
+    /**
+     * ONNX Runtime CPU backend, load MUD file with type onnx, or .onnx file directly.
+     * MUD file example:
+     * [basic]
+     * type = onnx
+     * model = yolo11n.onnx
+     * intra_threads = 4 ; optional, threads to run one operator, 0 means number of physical cores, default 0
+     * inter_threads = 1 ; optional, threads to run independent operators in parallel, default 1
+     * Input and output buffers are allocated once at load time and bound to the session,
+     * so forward only copies input data and runs the model.
+     */
+    class NN_ONNX : public NNBase
+    {
+    public:
+        NN_ONNX(bool dual_buff);
+        ~NN_ONNX();
+
+        /**
+         * Load model from file
+         * @param[in] mud simply parsed model describe object
+         * @return error code, if load success, return err::ERR_NONE
+         */
+        virtual err::Err load(const MUD &mud, const std::string &dir) final;
+
+        /**
+         * Unload model
+         * @return error code, if unload success, return err::ERR_NONE
+         */
+        virtual err::Err unload() final;
+
+        /**
+         * Is model loaded
+         * @return true if model loaded, else false
+         */
+        virtual bool loaded() final;
+
+        /**
+         * Enable dual buff or disable dual buff
+         * @param enable true to enable, false to disable
+         */
+        virtual void set_dual_buff(bool enable);
+
+        /**
+         * Get model input layer info
+         * @return input layer info
+         */
+        std::vector<LayerInfo> inputs_info();
+
+        /**
+         * Get model output layer info
+         * @return output layer info
+         */
+        std::vector<LayerInfo> outputs_info();
+
+        /**
+         * forward run model, get output of model
+         * @param[in] input input tensor
+         * @param[out] output output tensor
+         * @return error code, if forward success, return err::ERR_NONE
+         */
+        virtual err::Err forward(tensor::Tensors &inputs, tensor::Tensors &outputs, bool copy_result = true, bool dual_buff_wait = false) final;
+
+        /**
+         * forward run model, get output of model,
+         * this is specially for MaixPy, not efficient, but easy to use in MaixPy
+         * @param[in] input input tensor
+         * @return output tensor
+         */
+        virtual tensor::Tensors *forward(tensor::Tensors &inputs, bool copy_result = true, bool dual_buff_wait = false) final;
+
+        /**
+         * forward model, param is image
+         * @param[in] img input image
+         * @param chw image is converted to model input layout(from model or extra.input_layout of mud),
+         *            false for a NCHW model raises err.Exception instead of being ignored.
+         * @return output tensor
+         */
+        virtual tensor::Tensors *forward_image(image::Image &img, std::vector<float> mean = std::vector<float>(), std::vector<float> scale = std::vector<float>(), image::Fit fit = image::Fit::FIT_CONTAIN, bool copy_result = true, bool dual_buff_wait = false, bool chw = true) final;
+
+        /**
+         * forward images in batches, for model input with dynamic batch dimension(all images in one run),
+         * or fixed batch size > 1(batch size images every run), images are converted to input buffer in multiple threads.
+         * Not affected by dual buff, result is always of the input images.
+         * @param[in] imgs input images, size and format should match model input already
+         * @param chw same as forward_image.
+         * @return outputs of every image, output shape is model's with batch dimension 1,
+         *         empty if model batch size is 1, caller should forward images one by one.
+         */
+        std::vector<tensor::Tensors *> forward_image_batch(std::vector<image::Image *> &imgs, std::vector<float> &mean, std::vector<float> &scale, bool chw = true);
+
+    private:
+        bool _loaded;
+        void *_data;
+        bool _enable_dual_buff;
+    };
+
 } // namespace maix::nn
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.19: Add SelfLearnClassifier CPU learn and SIMD feature distance.
  */
 
 
@@ -10,6 +11,12 @@
 #include "maix_basic.hpp"
 #include "inifile.h"
 #include "maix_nn_self_learn_classifier.hpp"
+#include <math.h>
+#if __riscv_vector
+#include <riscv_vector.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 #if PLATFORM_MAIXCAM || PLATFORM_MAIXCAM2
     #include "maix_nn_maixcam.hpp"
@@ -197,8 +204,12 @@ namespace maix::nn
     NN::NN(const std::string &model_path, bool dual_buff)
     {
         _impl = nullptr;
+        _dual_buff = dual_buff;
+        _drop_pending = false;
 #if PLATFORM_MAIXCAM || PLATFORM_MAIXCAM2
         _impl = new NN_MaixCam(dual_buff);
+#elif HAVE_ONNXRUNTIME
+        _impl = new NN_ONNX(dual_buff);
 #endif
         if(!_impl)
         {
@@ -261,6 +272,17 @@ namespace maix::nn
     void NN::set_dual_buff(bool enable)
     {
         _impl->set_dual_buff(enable);
+        _dual_buff = enable;
+        _drop_pending = false;
+    }
+
+    bool NN::_drop_result(bool dual_buff_wait)
+    {
+        if (!_drop_pending)
+            return false;
+        // waiting forward drops the pending result in backend
+        _drop_pending = false;
+        return _dual_buff && !dual_buff_wait;
     }
 
     std::vector<nn::LayerInfo> NN::inputs_info()
@@ -295,12 +317,21 @@ namespace maix::nn
 
     err::Err NN::forward(tensor::Tensors &inputs, tensor::Tensors &outputs, bool copy_result, bool dual_buff_wait)
     {
-        return _impl->forward(inputs, outputs, copy_result, dual_buff_wait);
+        bool drop = _drop_result(dual_buff_wait);
+        err::Err e = _impl->forward(inputs, outputs, copy_result, dual_buff_wait);
+        return drop && e == err::ERR_NONE ? err::ERR_NOT_READY : e;
     }
 
     tensor::Tensors *NN::forward(tensor::Tensors &inputs, bool copy_result, bool dual_buff_wait)
     {
-        return _impl->forward(inputs, copy_result, dual_buff_wait);
+        bool drop = _drop_result(dual_buff_wait);
+        tensor::Tensors *res = _impl->forward(inputs, copy_result, dual_buff_wait);
+        if (drop && res)
+        {
+            delete res;
+            res = nullptr;
+        }
+        return res;
     }
 
     tensor::Tensors *NN::forward_image(image::Image &img, std::vector<float> mean, std::vector<float> scale, image::Fit fit, bool copy_result, bool dual_buff_wait, bool chw)
@@ -334,18 +365,261 @@ namespace maix::nn
             img_p = img.resize(input_w, input_h, fit);
             img_need_free = true;
         }
+        else if (!img.is_contiguous())
+        {
+            // backend use image data directly, need continuous data, e.g. image created by Image.view
+            img_p = img.copy();
+            img_need_free = true;
+        }
+        bool drop = _drop_result(dual_buff_wait);
         tensor::Tensors *res = _impl->forward_image(*img_p, mean, scale, fit, copy_result, dual_buff_wait, chw);
         if (img_need_free)
             delete img_p;
+        if (drop && res)
+        {
+            delete res;
+            res = nullptr;
+        }
+        return res;
+    }
+
+    std::vector<tensor::Tensors *> NN::forward_batch(std::vector<image::Image *> &imgs, std::vector<float> mean, std::vector<float> scale, image::Fit fit, std::vector<int> rois, bool copy_result, bool chw)
+    {
+        if (imgs.empty())
+            throw err::Exception(err::ERR_ARGS, "forward_batch need at least one image");
+        if (rois.size() % 4 != 0)
+            throw err::Exception(err::ERR_ARGS, "rois should be [x, y, w, h] list");
+        int num = rois.empty() ? (int)imgs.size() : (int)rois.size() / 4;
+        if (imgs.size() != 1 && (int)imgs.size() != num)
+        {
+            log::error("rois number %d not match images number %d", num, (int)imgs.size());
+            throw err::Exception(err::ERR_ARGS, "rois number not match images number");
+        }
+        nn::LayerInfo info = _impl->inputs_info()[0];
+        bool nchw = info.layout == nn::Layout::NCHW;
+        int input_w = nchw ? info.shape[3] : info.shape[2];
+        int input_h = nchw ? info.shape[2] : info.shape[1];
+        int input_c = nchw ? info.shape[1] : info.shape[3];
+        for (auto img : imgs)
+        {
+            if (!img || image::fmt_size[img->format()] != input_c)
+            {
+                log::error("model need image channel is %d, but image have %d", input_c, img ? (int)image::fmt_size[img->format()] : 0);
+                throw err::Exception(err::ERR_ARGS, "model input channel not match image channel");
+            }
+        }
+
+        // crop and resize all images in parallel, inputs[i] is imgs[i] itself if already fit model input
+        std::vector<image::Image *> inputs(num, nullptr);
+        std::vector<uint8_t> need_free(num, 0);
+        int failed = 0;
+        #pragma omp parallel for reduction(+:failed)
+        for (int i = 0; i < num; i++)
+        {
+            image::Image *src = imgs.size() == 1 ? imgs[0] : imgs[i];
+            image::Image *img = src;
+            try
+            {
+                if (!rois.empty())
+                    img = src->crop(rois[i * 4], rois[i * 4 + 1], rois[i * 4 + 2], rois[i * 4 + 3]);
+                if (img->width() != input_w || img->height() != input_h)
+                {
+                    image::Image *resized = img->resize(input_w, input_h, fit);
+                    if (img != src)
+                        delete img;
+                    img = resized;
+                }
+                else if (!img->is_contiguous())
+                {
+                    // backend use image data directly, need continuous data, e.g. image created by Image.view
+                    image::Image *copied = img->copy();
+                    if (img != src)
+                        delete img;
+                    img = copied;
+                }
+                inputs[i] = img;
+                need_free[i] = img != src;
+            }
+            catch (const std::exception &e)
+            {
+                log::error("forward_batch prepare image %d failed: %s", i, e.what());
+                if (img != src)
+                    delete img;
+                ++failed;
+            }
+        }
+
+        std::vector<tensor::Tensors *> res;
+        try
+        {
+            if (failed)
+                throw err::Exception(err::ERR_ARGS, "forward_batch prepare image failed");
+#if !(PLATFORM_MAIXCAM || PLATFORM_MAIXCAM2) && HAVE_ONNXRUNTIME
+            // model with batch dimension, forward all images in one run
+            res = ((NN_ONNX *)_impl)->forward_image_batch(inputs, mean, scale, chw);
+            // batch run not touch dual buff slots, drop result of the input forwarded before this call as documented
+            if (!res.empty())
+                _drop_pending = _dual_buff;
+#endif
+            if (res.empty() && (!_dual_buff || num == 1))
+            {
+                // no batch dimension, forward one by one and wait result of every image,
+                // output memory is reused by the next forward, so only the last result can be not copied
+                for (int i = 0; i < num; i++)
+                {
+                    tensor::Tensors *out = _impl->forward_image(*inputs[i], mean, scale, fit, copy_result || i < num - 1, true, chw);
+                    if (!out)
+                        throw err::Exception(err::ERR_RUNTIME, "forward_batch forward failed");
+                    res.push_back(out);
+                }
+                _drop_pending = false;
+            }
+            else if (res.empty())
+            {
+                // dual buff, not wait, forward image i returns result of image i - 1, so input of image i is prepared while image i - 1 is running.
+                // Result of the first call is of the input before this batch, dropped. Backend can only return the running result with a new input,
+                // so the last image is forwarded again to get its result, result of the extra run is dropped by the next forward.
+                _drop_pending = true;
+                for (int i = 0; i <= num; i++)
+                {
+                    // slot of result i - 1 is reused by input i + 1, only the last result is kept until next forward
+                    tensor::Tensors *out = _impl->forward_image(*inputs[i < num ? i : num - 1], mean, scale, fit, copy_result || i < num, false, chw);
+                    if (i == 0)
+                    {
+                        delete out;
+                        continue;
+                    }
+                    if (!out)
+                        throw err::Exception(err::ERR_RUNTIME, "forward_batch forward failed");
+                    res.push_back(out);
+                }
+            }
+        }
+        catch (...)
+        {
+            for (auto t : res)
+                delete t;
+            for (int i = 0; i < num; i++)
+            {
+                if (need_free[i])
+                    delete inputs[i];
+            }
+            throw;
+        }
+        for (int i = 0; i < num; i++)
+        {
+            if (need_free[i])
+                delete inputs[i];
+        }
         return res;
     }
 
+    #define SELF_LEARN_MAX_EPOCH (100) // max epochs of SelfLearnClassifier::learn without NPU, assignments usually converge in a few epochs
+
+    // squared L2 distance of a and b
+    static float _l2_sq(const float *a, const float *b, int n)
+    {
+        int i = 0;
+        float sum = 0;
+#if __riscv_vector
+        size_t vl = vsetvl_e32m1(1);
+        vfloat32m1_t acc = vfmv_s_f_f32m1(vundefined_f32m1(), 0, vl);
+        for (; (vl = vsetvl_e32m1(n - i)) > 0; i += vl)
+        {
+            vfloat32m1_t d = vfsub_vv_f32m1(vle32_v_f32m1(a + i, vl), vle32_v_f32m1(b + i, vl), vl);
+            acc = vfredsum_vs_f32m1_f32m1(acc, vfmul_vv_f32m1(d, d, vl), acc, vl);
+        }
+        sum = vfmv_f_s_f32m1_f32(acc);
+#elif defined(__ARM_NEON)
+        float32x4_t acc0 = vdupq_n_f32(0), acc1 = vdupq_n_f32(0);
+        for (; i + 8 <= n; i += 8)
+        {
+            float32x4_t d0 = vsubq_f32(vld1q_f32(a + i), vld1q_f32(b + i));
+            float32x4_t d1 = vsubq_f32(vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+            acc0 = vmlaq_f32(acc0, d0, d0);
+            acc1 = vmlaq_f32(acc1, d1, d1);
+        }
+        float32x4_t acc = vaddq_f32(acc0, acc1);
+        float32x2_t r = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+        sum = vget_lane_f32(vpadd_f32(r, r), 0);
+#endif
+        for (; i < n; i++)
+            sum += (a[i] - b[i]) * (a[i] - b[i]);
+        return sum;
+    }
+
+    void SelfLearnClassifier::_get_distances(const float *feature, const float *mat, int num, float *distances)
+    {
+        #pragma omp parallel for
+        for (int i = 0; i < num; ++i)
+            distances[i] = sqrtf(_l2_sq(feature, mat + (size_t)i * _feature_num, _feature_num));
+    }
+
     int SelfLearnClassifier::learn()
     {
+        // learn from anchors every time, or class features drift after learn called repeatedly
+        _class_mat = _anchor_mat;
+        _update_rows(_class_mat, _features);
         #if PLATFORM_MAIXCAM || PLATFORM_MAIXCAM2
             return maix_nn_self_learn_classifier_learn(_features, _features_sample, _feature_num);
         #else
-            throw err::Exception(err::ERR_NOT_IMPL);
+            int class_num = (int)_features.size();
+            int sample_num = (int)_features_sample.size();
+            if (class_num == 0 || sample_num == 0 || _feature_num <= 0)
+                return 0;
+            int dim = _feature_num;
+            // every epoch assigns samples to the nearest class,
+            // then class feature = mean of anchor and assigned samples, until assignments not change.
+            std::vector<int> assign(sample_num, -1);
+            int epoch = 0;
+            while (epoch < SELF_LEARN_MAX_EPOCH)
+            {
+                int changed = 0;
+                #pragma omp parallel for reduction(+ : changed)
+                for (int i = 0; i < sample_num; ++i)
+                {
+                    const float *sample = _sample_mat.data() + (size_t)i * dim;
+                    int best = 0;
+                    float best_dis = INFINITY;
+                    for (int c = 0; c < class_num; ++c)
+                    {
+                        float dis = _l2_sq(sample, _class_mat.data() + (size_t)c * dim, dim);
+                        if (dis < best_dis)
+                        {
+                            best_dis = dis;
+                            best = c;
+                        }
+                    }
+                    if (assign[i] != best)
+                    {
+                        assign[i] = best;
+                        changed++;
+                    }
+                }
+                if (changed == 0)
+                    break;
+                ++epoch;
+                #pragma omp parallel for
+                for (int c = 0; c < class_num; ++c)
+                {
+                    float *center = _class_mat.data() + (size_t)c * dim;
+                    memcpy(center, _anchor_mat.data() + (size_t)c * dim, dim * sizeof(float));
+                    int count = 1;
+                    for (int i = 0; i < sample_num; ++i)
+                    {
+                        if (assign[i] != c)
+                            continue;
+                        const float *sample = _sample_mat.data() + (size_t)i * dim;
+                        for (int k = 0; k < dim; ++k)
+                            center[k] += sample[k];
+                        ++count;
+                    }
+                    float inv = 1.0f / count;
+                    for (int k = 0; k < dim; ++k)
+                        center[k] *= inv;
+                }
+            }
+            return epoch;
         #endif
     }
 
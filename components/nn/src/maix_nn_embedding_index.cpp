@@ -0,0 +1,808 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add EmbeddingIndex, normalized contiguous float32/float16/int8 embeddings, SIMD cosine top-k search,
+ *                     IVF approximate search and mmap-able file format.
+ */
+
+#include "maix_nn_embedding_index.hpp"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if __riscv_vector
+#include <riscv_vector.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace maix::nn
+{
+    #define EMB_BLOCK (1024)          // rows of one search block, every block keeps its top-k
+    #define EMB_ALIGN (64)            // rows and file parts alignment in bytes
+    #define EMB_MAGIC (0x4945584d)    // "MXEI"
+    #define EMB_VERSION (1)
+
+    // file header, followed by parts aligned to EMB_ALIGN:
+    // rows(num * row_bytes), scales(num floats, int8 only), centroids(nlist * dim floats), list sizes(nlist uint32), ids(num uint32)
+    typedef struct
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t dtype;
+        uint32_t dim;
+        uint32_t num;
+        uint32_t row_bytes;
+        uint32_t nlist;
+        uint32_t reserved[9];
+    } emb_header_t;
+
+    // prepared query, float for float32 and float16 rows, quantized for int8 rows
+    typedef struct
+    {
+        const float *f;
+        const int8_t *q;
+        float scale;
+    } emb_query_t;
+
+    typedef struct
+    {
+        int dim;
+        nn::EmbeddingDType dtype;
+        int num;
+        size_t row_bytes;
+        std::vector<uint8_t> rows;  // heap storage of rows
+        std::vector<float> scales;  // int8 scale of every row
+        const uint8_t *data;        // rows, point to heap or mmap
+        const float *scale_data;    // scales, point to heap or mmap
+        void *map;
+        size_t map_size;
+        std::vector<float> centroids;         // IVF normalized cluster centers, nlist * dim
+        std::vector<std::vector<int>> lists;  // IVF row indexes of every cluster
+
+        // search buffers
+        std::vector<float> query;
+        std::vector<int8_t> query_q;
+        std::vector<int> cand;
+        std::vector<int> top_idx;
+        std::vector<float> top_score;
+        std::vector<std::pair<float, int>> merge;
+    } emb_t;
+
+    static size_t _align(size_t n)
+    {
+        return (n + EMB_ALIGN - 1) / EMB_ALIGN * EMB_ALIGN;
+    }
+
+    static size_t _elem_size(nn::EmbeddingDType dtype)
+    {
+        return dtype == nn::EmbeddingDType::EMBEDDING_FLOAT32 ? 4 : (dtype == nn::EmbeddingDType::EMBEDDING_FLOAT16 ? 2 : 1);
+    }
+
+    // float to IEEE half, round to nearest even, values less than min normal half flush to zero, same as _half_to_float
+    static uint16_t _float_to_half(float f)
+    {
+        uint32_t x;
+        memcpy(&x, &f, 4);
+        uint32_t sign = (x >> 16) & 0x8000;
+        int exp = (int)((x >> 23) & 0xff) - 127 + 15;
+        uint32_t mant = x & 0x7fffff;
+        if (exp <= 0)
+            return sign;
+        if (exp >= 31)
+            return sign | 0x7bff; // clamp to max half
+        uint32_t h = ((uint32_t)exp << 10) | (mant >> 13);
+        uint32_t rem = mant & 0x1fff;
+        if (rem > 0x1000 || (rem == 0x1000 && (h & 1)))
+            h++;
+        if (h >= 0x7c00)
+            h = 0x7bff;
+        return sign | h;
+    }
+
+    static float _half_to_float(uint16_t h)
+    {
+        uint32_t em = h & 0x7fff;
+        uint32_t x = em < 0x400 ? 0 : (((uint32_t)(h & 0x8000) << 16) | ((em << 13) + 0x38000000));
+        float f;
+        memcpy(&f, &x, 4);
+        return f;
+    }
+
+    static float _dot_f32(const float *a, const float *b, int n)
+    {
+        int i = 0;
+        float sum = 0;
+#if __riscv_vector
+        size_t vl = vsetvl_e32m1(1);
+        vfloat32m1_t acc = vfmv_s_f_f32m1(vundefined_f32m1(), 0, vl);
+        for (; (vl = vsetvl_e32m1(n - i)) > 0; i += vl)
+            acc = vfredsum_vs_f32m1_f32m1(acc, vfmul_vv_f32m1(vle32_v_f32m1(a + i, vl), vle32_v_f32m1(b + i, vl), vl), acc, vl);
+        sum = vfmv_f_s_f32m1_f32(acc);
+#elif defined(__ARM_NEON)
+        float32x4_t acc0 = vdupq_n_f32(0), acc1 = vdupq_n_f32(0);
+        for (; i + 8 <= n; i += 8)
+        {
+            acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+            acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+        }
+        float32x4_t acc = vaddq_f32(acc0, acc1);
+        float32x2_t r = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+        sum = vget_lane_f32(vpadd_f32(r, r), 0);
+#endif
+        for (; i < n; i++)
+            sum += a[i] * b[i];
+        return sum;
+    }
+
+    // half is converted to float by bit operations, no float16 arithmetic needed
+    static float _dot_f16(const float *a, const uint16_t *b, int n)
+    {
+        int i = 0;
+        float sum = 0;
+#if __riscv_vector
+        size_t vl = vsetvl_e32m1(1);
+        vfloat32m1_t acc = vfmv_s_f_f32m1(vundefined_f32m1(), 0, vl);
+        for (; (vl = vsetvl_e16m1(n - i)) > 0; i += vl)
+        {
+            vuint32m2_t w = vwaddu_vx_u32m2(vle16_v_u16m1(b + i, vl), 0, vl);
+            vuint32m2_t em = vand_vx_u32m2(w, 0x7fff, vl);
+            vuint32m2_t bits = vor_vv_u32m2(vsll_vx_u32m2(vand_vx_u32m2(w, 0x8000, vl), 16, vl),
+                                            vadd_vx_u32m2(vsll_vx_u32m2(em, 13, vl), 0x38000000, vl), vl);
+            bits = vmerge_vxm_u32m2(vmsltu_vx_u32m2_b16(em, 0x400, vl), bits, 0, vl);
+            vfloat32m2_t f = vreinterpret_v_u32m2_f32m2(bits);
+            acc = vfredsum_vs_f32m2_f32m1(acc, vfmul_vv_f32m2(f, vle32_v_f32m2(a + i, vl), vl), acc, vl);
+        }
+        sum = vfmv_f_s_f32m1_f32(acc);
+#elif defined(__ARM_NEON)
+        float32x4_t acc = vdupq_n_f32(0);
+        uint32x4_t min_normal = vdupq_n_u32(0x400);
+        for (; i + 4 <= n; i += 4)
+        {
+            uint32x4_t w = vmovl_u16(vld1_u16(b + i));
+            uint32x4_t em = vandq_u32(w, vdupq_n_u32(0x7fff));
+            uint32x4_t bits = vorrq_u32(vshlq_n_u32(vandq_u32(w, vdupq_n_u32(0x8000)), 16),
+                                        vaddq_u32(vshlq_n_u32(em, 13), vdupq_n_u32(0x38000000)));
+            bits = vandq_u32(bits, vcgeq_u32(em, min_normal));
+            acc = vmlaq_f32(acc, vreinterpretq_f32_u32(bits), vld1q_f32(a + i));
+        }
+        float32x2_t r = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+        sum = vget_lane_f32(vpadd_f32(r, r), 0);
+#endif
+        for (; i < n; i++)
+            sum += a[i] * _half_to_float(b[i]);
+        return sum;
+    }
+
+    static int32_t _dot_i8(const int8_t *a, const int8_t *b, int n)
+    {
+        int i = 0;
+        int32_t sum = 0;
+#if __riscv_vector
+        size_t vl = vsetvl_e32m1(1);
+        vint32m1_t acc = vmv_s_x_i32m1(vundefined_i32m1(), 0, vl);
+        for (; (vl = vsetvl_e8m1(n - i)) > 0; i += vl)
+            acc = vwredsum_vs_i16m2_i32m1(acc, vwmul_vv_i16m2(vle8_v_i8m1(a + i, vl), vle8_v_i8m1(b + i, vl), vl), acc, vl);
+        sum = vmv_x_s_i32m1_i32(acc);
+#elif defined(__ARM_NEON)
+        int32x4_t acc = vdupq_n_s32(0);
+        for (; i + 16 <= n; i += 16)
+        {
+            int8x16_t va = vld1q_s8(a + i);
+            int8x16_t vb = vld1q_s8(b + i);
+            acc = vpadalq_s16(acc, vmull_s8(vget_low_s8(va), vget_low_s8(vb)));
+            acc = vpadalq_s16(acc, vmull_s8(vget_high_s8(va), vget_high_s8(vb)));
+        }
+        int32x2_t r = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+        sum = vget_lane_s32(vpadd_s32(r, r), 0);
+#endif
+        for (; i < n; i++)
+            sum += (int32_t)a[i] * b[i];
+        return sum;
+    }
+
+    // quantize normalized vector to int8 by max abs value, return scale, value = q * scale
+    static float _quantize(const float *src, int8_t *dst, int n)
+    {
+        float max_abs = 0;
+        for (int i = 0; i < n; i++)
+            max_abs = std::max(max_abs, fabsf(src[i]));
+        if (max_abs == 0)
+        {
+            memset(dst, 0, n);
+            return 0;
+        }
+        float inv = 127 / max_abs;
+        for (int i = 0; i < n; i++)
+            dst[i] = (int8_t)lrintf(src[i] * inv);
+        return max_abs / 127;
+    }
+
+    static void _normalize(const float *src, float *dst, int n)
+    {
+        double sum = 0;
+        for (int i = 0; i < n; i++)
+            sum += (double)src[i] * src[i];
+        float inv = sum > 0 ? (float)(1 / sqrt(sum)) : 0;
+        for (int i = 0; i < n; i++)
+            dst[i] = src[i] * inv;
+    }
+
+    static float _row_dot(const emb_t *s, const emb_query_t &q, int row)
+    {
+        const uint8_t *p = s->data + (size_t)row * s->row_bytes;
+        switch (s->dtype)
+        {
+        case nn::EmbeddingDType::EMBEDDING_FLOAT32:
+            return _dot_f32(q.f, (const float *)p, s->dim);
+        case nn::EmbeddingDType::EMBEDDING_FLOAT16:
+            return _dot_f16(q.f, (const uint16_t *)p, s->dim);
+        default:
+            return _dot_i8(q.q, (const int8_t *)p, s->dim) * q.scale * s->scale_data[row];
+        }
+    }
+
+    static void _row_get(const emb_t *s, int row, float *dst)
+    {
+        const uint8_t *p = s->data + (size_t)row * s->row_bytes;
+        for (int i = 0; i < s->dim; i++)
+        {
+            if (s->dtype == nn::EmbeddingDType::EMBEDDING_FLOAT32)
+                dst[i] = ((const float *)p)[i];
+            else if (s->dtype == nn::EmbeddingDType::EMBEDDING_FLOAT16)
+                dst[i] = _half_to_float(((const uint16_t *)p)[i]);
+            else
+                dst[i] = ((const int8_t *)p)[i] * s->scale_data[row];
+        }
+    }
+
+    // prepare normalized query q of dim floats, q_buf is buffer of quantized query
+    static emb_query_t _prepare(const emb_t *s, const float *q, std::vector<int8_t> &q_buf)
+    {
+        emb_query_t query = {q, nullptr, 0};
+        if (s->dtype == nn::EmbeddingDType::EMBEDDING_INT8)
+        {
+            q_buf.resize(s->dim);
+            query.scale = _quantize(q, q_buf.data(), s->dim);
+            query.q = q_buf.data();
+        }
+        return query;
+    }
+
+    static void _unmap(emb_t *s)
+    {
+        if (s->map)
+        {
+            munmap(s->map, s->map_size);
+            s->map = nullptr;
+            s->map_size = 0;
+        }
+    }
+
+    // copy mapped rows to memory before modified
+    static void _writable(emb_t *s)
+    {
+        if (!s->map)
+            return;
+        s->rows.assign(s->data, s->data + (size_t)s->num * s->row_bytes);
+        if (s->dtype == nn::EmbeddingDType::EMBEDDING_INT8)
+            s->scales.assign(s->scale_data, s->scale_data + s->num);
+        _unmap(s);
+        s->data = s->rows.data();
+        s->scale_data = s->scales.data();
+    }
+
+    static int _nearest_centroid(const emb_t *s, const float *v)
+    {
+        int best = 0;
+        float best_score = -INFINITY;
+        for (size_t c = 0; c < s->lists.size(); c++)
+        {
+            float score = _dot_f32(v, s->centroids.data() + c * s->dim, s->dim);
+            if (score > best_score)
+            {
+                best_score = score;
+                best = c;
+            }
+        }
+        return best;
+    }
+
+    // insert (score, idx) to top k arrays sorted by score from high to low, index ascending if score equal
+    static inline void _top_insert(int *idx, float *score, int &n, int k, int i, float v)
+    {
+        if (n == k && (v < score[n - 1] || (v == score[n - 1] && i > idx[n - 1])))
+            return;
+        int j = n < k ? n++ : n - 1;
+        while (j > 0 && (v > score[j - 1] || (v == score[j - 1] && i < idx[j - 1])))
+        {
+            idx[j] = idx[j - 1];
+            score[j] = score[j - 1];
+            j--;
+        }
+        idx[j] = i;
+        score[j] = v;
+    }
+
+    EmbeddingIndex::EmbeddingIndex(int dim, nn::EmbeddingDType dtype)
+    {
+        if (dim < 0)
+            throw err::Exception(err::ERR_ARGS, "EmbeddingIndex dim should >= 0");
+        emb_t *s = new emb_t();
+        s->dim = dim;
+        s->dtype = dtype;
+        s->num = 0;
+        s->row_bytes = _align(dim * _elem_size(dtype));
+        s->data = nullptr;
+        s->scale_data = nullptr;
+        s->map = nullptr;
+        s->map_size = 0;
+        _handle = s;
+    }
+
+    EmbeddingIndex::~EmbeddingIndex()
+    {
+        emb_t *s = (emb_t *)_handle;
+        _unmap(s);
+        delete s;
+        _handle = nullptr;
+    }
+
+    int EmbeddingIndex::add(const std::vector<float> &embedding)
+    {
+        return add(embedding.data(), (int)embedding.size());
+    }
+
+    int EmbeddingIndex::add(const float *embedding, int dim)
+    {
+        emb_t *s = (emb_t *)_handle;
+        if (s->dim == 0 && dim > 0)
+        {
+            s->dim = dim;
+            s->row_bytes = _align(dim * _elem_size(s->dtype));
+        }
+        if (dim <= 0 || dim != s->dim)
+        {
+            log::error("embedding length %d not equal to index dim %d", dim, s->dim);
+            throw err::Exception(err::ERR_ARGS, "embedding length not equal to index dim");
+        }
+        _writable(s);
+        std::vector<float> v(dim);
+        _normalize(embedding, v.data(), dim);
+        s->rows.resize((size_t)(s->num + 1) * s->row_bytes, 0);
+        uint8_t *p = s->rows.data() + (size_t)s->num * s->row_bytes;
+        if (s->dtype == nn::EmbeddingDType::EMBEDDING_FLOAT32)
+            memcpy(p, v.data(), dim * sizeof(float));
+        else if (s->dtype == nn::EmbeddingDType::EMBEDDING_FLOAT16)
+        {
+            for (int i = 0; i < dim; i++)
+                ((uint16_t *)p)[i] = _float_to_half(v[i]);
+        }
+        else
+            s->scales.push_back(_quantize(v.data(), (int8_t *)p, dim));
+        s->data = s->rows.data();
+        s->scale_data = s->scales.data();
+        if (!s->lists.empty())
+            s->lists[_nearest_centroid(s, v.data())].push_back(s->num);
+        return s->num++;
+    }
+
+    err::Err EmbeddingIndex::remove(int idx)
+    {
+        emb_t *s = (emb_t *)_handle;
+        if (idx < 0 || idx >= s->num)
+        {
+            log::error("idx value error: %d", idx);
+            return err::ERR_ARGS;
+        }
+        _writable(s);
+        s->rows.erase(s->rows.begin() + (size_t)idx * s->row_bytes, s->rows.begin() + (size_t)(idx + 1) * s->row_bytes);
+        if (s->dtype == nn::EmbeddingDType::EMBEDDING_INT8)
+            s->scales.erase(s->scales.begin() + idx);
+        s->data = s->rows.data();
+        s->scale_data = s->scales.data();
+        s->num--;
+        for (auto &list : s->lists)
+        {
+            size_t n = 0;
+            for (size_t i = 0; i < list.size(); i++)
+            {
+                if (list[i] != idx)
+                    list[n++] = list[i] > idx ? list[i] - 1 : list[i];
+            }
+            list.resize(n);
+        }
+        return err::ERR_NONE;
+    }
+
+    void EmbeddingIndex::clear()
+    {
+        emb_t *s = (emb_t *)_handle;
+        _unmap(s);
+        s->num = 0;
+        s->rows.clear();
+        s->scales.clear();
+        s->data = nullptr;
+        s->scale_data = nullptr;
+        s->centroids.clear();
+        s->lists.clear();
+    }
+
+    int EmbeddingIndex::size()
+    {
+        return ((emb_t *)_handle)->num;
+    }
+
+    int EmbeddingIndex::dim()
+    {
+        return ((emb_t *)_handle)->dim;
+    }
+
+    nn::EmbeddingDType EmbeddingIndex::dtype()
+    {
+        return ((emb_t *)_handle)->dtype;
+    }
+
+    int EmbeddingIndex::nlist()
+    {
+        return (int)((emb_t *)_handle)->lists.size();
+    }
+
+    std::vector<float> EmbeddingIndex::get(int idx)
+    {
+        emb_t *s = (emb_t *)_handle;
+        if (idx < 0 || idx >= s->num)
+        {
+            log::error("idx value error: %d", idx);
+            throw err::Exception(err::ERR_ARGS, "idx out of range");
+        }
+        std::vector<float> v(s->dim);
+        _row_get(s, idx, v.data());
+        return v;
+    }
+
+    err::Err EmbeddingIndex::build_ivf(int nlist, int iters)
+    {
+        emb_t *s = (emb_t *)_handle;
+        if (s->num == 0)
+        {
+            log::error("index is empty");
+            return err::ERR_NOT_READY;
+        }
+        if (nlist <= 0)
+            nlist = std::max(1, (int)sqrt((double)s->num));
+        nlist = std::min(nlist, s->num);
+        int dim = s->dim;
+        // spherical k-means, init centers by evenly spaced rows, so result is deterministic
+        std::vector<float> centroids((size_t)nlist * dim);
+        for (int c = 0; c < nlist; c++)
+            _row_get(s, (int)((int64_t)c * s->num / nlist), centroids.data() + (size_t)c * dim);
+        std::vector<int> assign(s->num, -1);
+        std::vector<float> sums;
+        std::vector<int8_t> centroids_q((size_t)nlist * dim);
+        std::vector<float> centroids_scale(nlist);
+        for (int it = 0; it < std::max(iters, 1); it++)
+        {
+            if (s->dtype == nn::EmbeddingDType::EMBEDDING_INT8)
+            {
+                for (int c = 0; c < nlist; c++)
+                    centroids_scale[c] = _quantize(centroids.data() + (size_t)c * dim, centroids_q.data() + (size_t)c * dim, dim);
+            }
+            int changed = 0;
+            #pragma omp parallel for reduction(+ : changed)
+            for (int i = 0; i < s->num; i++)
+            {
+                int best = 0;
+                float best_score = -INFINITY;
+                for (int c = 0; c < nlist; c++)
+                {
+                    emb_query_t q = {centroids.data() + (size_t)c * dim, centroids_q.data() + (size_t)c * dim, centroids_scale[c]};
+                    float score = _row_dot(s, q, i);
+                    if (score > best_score)
+                    {
+                        best_score = score;
+                        best = c;
+                    }
+                }
+                if (assign[i] != best)
+                {
+                    assign[i] = best;
+                    changed++;
+                }
+            }
+            if (changed == 0)
+                break;
+            // new centers are normalized mean of members, empty cluster keeps old center
+            sums.assign((size_t)nlist * dim, 0);
+            std::vector<int> counts(nlist, 0);
+            std::vector<float> v(dim);
+            for (int i = 0; i < s->num; i++)
+            {
+                _row_get(s, i, v.data());
+                float *sum = sums.data() + (size_t)assign[i] * dim;
+                for (int d = 0; d < dim; d++)
+                    sum[d] += v[d];
+                counts[assign[i]]++;
+            }
+            for (int c = 0; c < nlist; c++)
+            {
+                if (counts[c] > 0)
+                    _normalize(sums.data() + (size_t)c * dim, centroids.data() + (size_t)c * dim, dim);
+            }
+        }
+        s->centroids.swap(centroids);
+        s->lists.assign(nlist, std::vector<int>());
+        for (int i = 0; i < s->num; i++)
+            s->lists[assign[i]].push_back(i);
+        return err::ERR_NONE;
+    }
+
+    std::vector<std::pair<int, float>> EmbeddingIndex::search(const std::vector<float> &query, int k, int nprobe)
+    {
+        std::vector<std::pair<int, float>> res;
+        if (k <= 0)
+            return res;
+        std::vector<int> idxes(k);
+        std::vector<float> scores(k);
+        int n = search(query.data(), (int)query.size(), k, idxes.data(), scores.data(), nprobe);
+        res.reserve(n);
+        for (int i = 0; i < n; i++)
+            res.push_back(std::make_pair(idxes[i], scores[i]));
+        return res;
+    }
+
+    int EmbeddingIndex::search(const float *query, int dim, int k, int *idxes, float *scores, int nprobe)
+    {
+        emb_t *s = (emb_t *)_handle;
+        if (s->num == 0 || k <= 0)
+            return 0;
+        if (dim != s->dim)
+        {
+            log::error("query length %d not equal to index dim %d", dim, s->dim);
+            throw err::Exception(err::ERR_ARGS, "query length not equal to index dim");
+        }
+        s->query.resize(dim);
+        _normalize(query, s->query.data(), dim);
+        emb_query_t q = _prepare(s, s->query.data(), s->query_q);
+
+        // candidates, all rows if exact search, or rows of nprobe nearest clusters
+        const int *cand = nullptr;
+        int cand_num = s->num;
+        int nlist = (int)s->lists.size();
+        if (nprobe > 0 && nlist > 0 && nprobe < nlist)
+        {
+            std::vector<int> &probe_idx = s->top_idx;
+            std::vector<float> &probe_score = s->top_score;
+            probe_idx.resize(nprobe);
+            probe_score.resize(nprobe);
+            int probe_num = 0;
+            for (int c = 0; c < nlist; c++)
+                _top_insert(probe_idx.data(), probe_score.data(), probe_num, nprobe, c,
+                            _dot_f32(s->query.data(), s->centroids.data() + (size_t)c * dim, dim));
+            s->cand.clear();
+            for (int i = 0; i < probe_num; i++)
+                s->cand.insert(s->cand.end(), s->lists[probe_idx[i]].begin(), s->lists[probe_idx[i]].end());
+            cand = s->cand.data();
+            cand_num = (int)s->cand.size();
+        }
+        if (cand_num == 0)
+            return 0;
+
+        // every block keeps its top k, then merge, result not depends on thread number
+        int blocks = (cand_num + EMB_BLOCK - 1) / EMB_BLOCK;
+        int kb = std::min(k, EMB_BLOCK);
+        s->top_idx.resize((size_t)blocks * kb);
+        s->top_score.resize((size_t)blocks * kb);
+        std::vector<int> block_n(blocks);
+        #pragma omp parallel for
+        for (int b = 0; b < blocks; b++)
+        {
+            int *idx = s->top_idx.data() + (size_t)b * kb;
+            float *score = s->top_score.data() + (size_t)b * kb;
+            int n = 0;
+            int end = std::min(cand_num, (b + 1) * EMB_BLOCK);
+            for (int i = b * EMB_BLOCK; i < end; i++)
+            {
+                int row = cand ? cand[i] : i;
+                _top_insert(idx, score, n, kb, row, _row_dot(s, q, row));
+            }
+            block_n[b] = n;
+        }
+        s->merge.clear();
+        for (int b = 0; b < blocks; b++)
+        {
+            for (int i = 0; i < block_n[b]; i++)
+                s->merge.push_back(std::make_pair(s->top_score[(size_t)b * kb + i], s->top_idx[(size_t)b * kb + i]));
+        }
+        int n = std::min(k, (int)s->merge.size());
+        std::partial_sort(s->merge.begin(), s->merge.begin() + n, s->merge.end(), [](const std::pair<float, int> &a, const std::pair<float, int> &b)
+                          { return a.first > b.first || (a.first == b.first && a.second < b.second); });
+        for (int i = 0; i < n; i++)
+        {
+            idxes[i] = s->merge[i].second;
+            scores[i] = s->merge[i].first;
+        }
+        return n;
+    }
+
+    err::Err EmbeddingIndex::save(const std::string &path)
+    {
+        emb_t *s = (emb_t *)_handle;
+        std::string dir = fs::dirname(path);
+        if (!dir.empty())
+        {
+            err::Err e = fs::mkdir(dir);
+            if (e != err::ERR_NONE)
+                return e;
+        }
+        fs::File *f = fs::open(path, "w");
+        if (!f)
+            return err::ERR_IO;
+        emb_header_t header;
+        memset(&header, 0, sizeof(header));
+        header.magic = EMB_MAGIC;
+        header.version = EMB_VERSION;
+        header.dtype = s->dtype;
+        header.dim = s->dim;
+        header.num = s->num;
+        header.row_bytes = s->row_bytes;
+        header.nlist = s->lists.size();
+        static const uint8_t zeros[EMB_ALIGN] = {0};
+        size_t pos = 0;
+        bool ok = true;
+        auto write = [&](const void *buf, size_t size)
+        {
+            if (size > 0 && ok)
+                ok = f->write(buf, (int)size) == (int)size;
+            pos += size;
+        };
+        auto pad = [&]()
+        {
+            write(zeros, _align(pos) - pos);
+        };
+        write(&header, sizeof(header));
+        pad();
+        write(s->data, (size_t)s->num * s->row_bytes);
+        pad();
+        if (s->dtype == nn::EmbeddingDType::EMBEDDING_INT8)
+        {
+            write(s->scale_data, (size_t)s->num * sizeof(float));
+            pad();
+        }
+        if (header.nlist > 0)
+        {
+            write(s->centroids.data(), s->centroids.size() * sizeof(float));
+            pad();
+            for (auto &list : s->lists)
+            {
+                uint32_t n = list.size();
+                write(&n, sizeof(n));
+            }
+            for (auto &list : s->lists)
+                write(list.data(), list.size() * sizeof(int));
+        }
+        f->flush();
+        f->close();
+        delete f;
+        return ok ? err::ERR_NONE : err::ERR_IO;
+    }
+
+    err::Err EmbeddingIndex::load(const std::string &path, bool mmap)
+    {
+        emb_t *s = (emb_t *)_handle;
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            log::error("open %s failed", path.c_str());
+            return err::ERR_IO;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(emb_header_t))
+        {
+            close(fd);
+            log::error("%s is not a embedding index file", path.c_str());
+            return err::ERR_IO;
+        }
+        size_t file_size = st.st_size;
+        // mmap whole file, or read to memory
+        uint8_t *buf = nullptr;
+        std::vector<uint8_t> content;
+        if (mmap)
+        {
+            void *p = ::mmap(NULL, file_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED)
+            {
+                close(fd);
+                log::error("mmap %s failed", path.c_str());
+                return err::ERR_IO;
+            }
+            buf = (uint8_t *)p;
+        }
+        else
+        {
+            content.resize(file_size);
+            size_t n = 0;
+            while (n < file_size)
+            {
+                ssize_t r = read(fd, content.data() + n, file_size - n);
+                if (r <= 0)
+                    break;
+                n += r;
+            }
+            if (n != file_size)
+            {
+                close(fd);
+                log::error("read %s failed", path.c_str());
+                return err::ERR_IO;
+            }
+            buf = content.data();
+        }
+        close(fd);
+
+        emb_header_t header;
+        memcpy(&header, buf, sizeof(header));
+        size_t rows_pos = _align(sizeof(header));
+        size_t scales_pos = _align(rows_pos + (size_t)header.num * header.row_bytes);
+        size_t centroids_pos = header.dtype == nn::EmbeddingDType::EMBEDDING_INT8 ? _align(scales_pos + (size_t)header.num * sizeof(float)) : scales_pos;
+        size_t sizes_pos = _align(centroids_pos + (size_t)header.nlist * header.dim * sizeof(float));
+        size_t end = header.nlist > 0 ? sizes_pos + (header.nlist + (size_t)header.num) * sizeof(uint32_t) : centroids_pos;
+        if (header.magic != EMB_MAGIC || header.version != EMB_VERSION || header.dtype > nn::EmbeddingDType::EMBEDDING_INT8 ||
+            header.row_bytes != _align(header.dim * _elem_size((nn::EmbeddingDType)header.dtype)) || end > file_size)
+        {
+            if (mmap)
+                munmap(buf, file_size);
+            log::error("%s is not a valid embedding index file", path.c_str());
+            return err::ERR_IO;
+        }
+        clear();
+        s->dim = header.dim;
+        s->dtype = (nn::EmbeddingDType)header.dtype;
+        s->num = header.num;
+        s->row_bytes = header.row_bytes;
+        if (mmap)
+        {
+            s->map = buf;
+            s->map_size = file_size;
+            s->data = buf + rows_pos;
+            s->scale_data = (const float *)(buf + scales_pos);
+        }
+        else
+        {
+            s->rows.assign(buf + rows_pos, buf + rows_pos + (size_t)s->num * s->row_bytes);
+            if (s->dtype == nn::EmbeddingDType::EMBEDDING_INT8)
+                s->scales.assign((const float *)(buf + scales_pos), (const float *)(buf + scales_pos) + s->num);
+            s->data = s->rows.data();
+            s->scale_data = s->scales.data();
+        }
+        // IVF lists are small, always copied to memory
+        if (header.nlist > 0)
+        {
+            const float *centroids = (const float *)(buf + centroids_pos);
+            s->centroids.assign(centroids, centroids + (size_t)header.nlist * header.dim);
+            const uint32_t *sizes = (const uint32_t *)(buf + sizes_pos);
+            const uint32_t *ids = sizes + header.nlist;
+            size_t total = 0;
+            s->lists.resize(header.nlist);
+            for (uint32_t c = 0; c < header.nlist; c++)
+            {
+                bool valid = total + sizes[c] <= header.num;
+                for (uint32_t i = 0; valid && i < sizes[c]; i++)
+                    valid = ids[total + i] < header.num;
+                if (!valid)
+                {
+                    clear();
+                    log::error("%s is not a valid embedding index file", path.c_str());
+                    return err::ERR_IO;
+                }
+                s->lists[c].assign(ids + total, ids + total + sizes[c]);
+                total += sizes[c];
+            }
+        }
+        return err::ERR_NONE;
+    }
+
+} // namespace maix::nn
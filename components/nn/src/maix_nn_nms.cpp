@@ -0,0 +1,482 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add NMS, per class grid bucketed hard NMS, soft-NMS and Matrix NMS, support rotated boxes.
+ */
+
+#include "maix_nn_nms.hpp"
+#include <algorithm>
+#include <queue>
+#include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace maix::nn
+{
+    #define NMS_GRID_MAX (64)    // max grid cells of each side
+    #define NMS_BRUTE_FORCE (32) // buckets with boxes less than this skip grid
+#ifdef _OPENMP
+    #define NMS_THREAD_NUM() omp_get_max_threads()
+    #define NMS_THREAD_ID() omp_get_thread_num()
+#else
+    #define NMS_THREAD_NUM() 1
+    #define NMS_THREAD_ID() 0
+#endif
+
+    // buffers of one thread
+    typedef struct
+    {
+        std::vector<std::vector<int>> cells;
+        std::vector<int> kept;
+    } nms_scratch_t;
+
+    typedef struct
+    {
+        // boxes in structure of arrays, axis aligned bounding box of rotated boxes
+        std::vector<float> x1, y1, x2, y2, area;
+        std::vector<float> corners; // 8 floats every box, only for rotated
+        std::vector<float> scores;
+        std::vector<int> class_ids;
+        bool rotated;
+
+        std::vector<int> order;   // box indexes sorted by class then score
+        std::vector<int> buckets; // start of every class in order, and order.size() at end
+        std::vector<int> stamp;   // last box compared with, avoid comparing twice when boxes share multiple cells
+        std::vector<uint8_t> keep;
+        std::vector<float> comp; // Matrix NMS compensate IoU of every box
+        std::vector<float> input;     // x, y, w, h, scores, angles gathered from objects
+        std::vector<int> input_class; // class ids gathered from objects
+        std::vector<nms_scratch_t> scratch;
+    } nms_t;
+
+    // grid of one bucket
+    typedef struct
+    {
+        float x0, y0;
+        float cell_w, cell_h;
+        int gw, gh;
+    } nms_grid_t;
+
+    static float _polygon_area(const float *p, int n)
+    {
+        float a = 0;
+        for (int i = 0; i < n; i++)
+        {
+            int j = (i + 1) % n;
+            a += p[i * 2] * p[j * 2 + 1] - p[j * 2] * p[i * 2 + 1];
+        }
+        return fabsf(a) * 0.5f;
+    }
+
+    // intersection area of two convex quadrangles with the same winding, clip a by every edge of b
+    static float _quad_intersection(const float *a, const float *b)
+    {
+        float buf0[32], buf1[32];
+        float *in = buf0, *out = buf1;
+        int n = 4;
+        for (int i = 0; i < 8; i++)
+            in[i] = a[i];
+        float sign = (b[2] - b[0]) * (b[5] - b[1]) - (b[3] - b[1]) * (b[4] - b[0]) >= 0 ? 1.f : -1.f;
+        for (int e = 0; e < 4 && n > 0; e++)
+        {
+            float ex0 = b[e * 2], ey0 = b[e * 2 + 1];
+            float ex1 = b[(e + 1) % 4 * 2], ey1 = b[(e + 1) % 4 * 2 + 1];
+            int m = 0;
+            for (int i = 0; i < n; i++)
+            {
+                float px = in[i * 2], py = in[i * 2 + 1];
+                float qx = in[(i + 1) % n * 2], qy = in[(i + 1) % n * 2 + 1];
+                float dp = sign * ((ex1 - ex0) * (py - ey0) - (ey1 - ey0) * (px - ex0));
+                float dq = sign * ((ex1 - ex0) * (qy - ey0) - (ey1 - ey0) * (qx - ex0));
+                if (dp >= 0)
+                {
+                    out[m * 2] = px;
+                    out[m * 2 + 1] = py;
+                    m++;
+                }
+                if ((dp >= 0) != (dq >= 0))
+                {
+                    float t = dp / (dp - dq);
+                    out[m * 2] = px + (qx - px) * t;
+                    out[m * 2 + 1] = py + (qy - py) * t;
+                    m++;
+                }
+            }
+            n = m;
+            std::swap(in, out);
+        }
+        return n < 3 ? 0 : _polygon_area(in, n);
+    }
+
+    static inline float _iou(nms_t *s, int a, int b)
+    {
+        float wi = std::min(s->x2[a], s->x2[b]) - std::max(s->x1[a], s->x1[b]);
+        float hi = std::min(s->y2[a], s->y2[b]) - std::max(s->y1[a], s->y1[b]);
+        if (wi <= 0 || hi <= 0)
+            return 0;
+        float inter = s->rotated ? _quad_intersection(&s->corners[a * 8], &s->corners[b * 8]) : wi * hi;
+        float uni = s->area[a] + s->area[b] - inter;
+        return uni > 0 ? inter / uni : 0;
+    }
+
+    static void _grid_init(nms_t *s, const int *idx, int n, nms_grid_t &g, nms_scratch_t &sc)
+    {
+        float x0 = s->x1[idx[0]], y0 = s->y1[idx[0]], x1 = s->x2[idx[0]], y1 = s->y2[idx[0]];
+        float size = 0;
+        for (int i = 0; i < n; i++)
+        {
+            int k = idx[i];
+            x0 = std::min(x0, s->x1[k]);
+            y0 = std::min(y0, s->y1[k]);
+            x1 = std::max(x1, s->x2[k]);
+            y1 = std::max(y1, s->y2[k]);
+            size += std::max(s->x2[k] - s->x1[k], s->y2[k] - s->y1[k]);
+        }
+        // cell about average box size, so a box covers about 2x2 cells
+        size = std::max(size / n, 1.f);
+        g.x0 = x0;
+        g.y0 = y0;
+        g.gw = std::min(std::max((int)((x1 - x0) / size), 1), NMS_GRID_MAX);
+        g.gh = std::min(std::max((int)((y1 - y0) / size), 1), NMS_GRID_MAX);
+        g.cell_w = std::max((x1 - x0) / g.gw, 1e-6f);
+        g.cell_h = std::max((y1 - y0) / g.gh, 1e-6f);
+        if ((int)sc.cells.size() < g.gw * g.gh)
+            sc.cells.resize(g.gw * g.gh);
+        for (int i = 0; i < g.gw * g.gh; i++)
+            sc.cells[i].clear();
+    }
+
+    static inline void _grid_range(nms_t *s, const nms_grid_t &g, int k, int &cx0, int &cy0, int &cx1, int &cy1)
+    {
+        cx0 = std::min(std::max((int)((s->x1[k] - g.x0) / g.cell_w), 0), g.gw - 1);
+        cy0 = std::min(std::max((int)((s->y1[k] - g.y0) / g.cell_h), 0), g.gh - 1);
+        cx1 = std::min(std::max((int)((s->x2[k] - g.x0) / g.cell_w), 0), g.gw - 1);
+        cy1 = std::min(std::max((int)((s->y2[k] - g.y0) / g.cell_h), 0), g.gh - 1);
+    }
+
+    static void _grid_insert(nms_t *s, const nms_grid_t &g, nms_scratch_t &sc, int k)
+    {
+        int cx0, cy0, cx1, cy1;
+        _grid_range(s, g, k, cx0, cy0, cx1, cy1);
+        for (int cy = cy0; cy <= cy1; cy++)
+        {
+            for (int cx = cx0; cx <= cx1; cx++)
+                sc.cells[cy * g.gw + cx].push_back(k);
+        }
+    }
+
+    /**
+     * Call func(i) for every box i in grid cells box k covers, every box once,
+     * stop and return true if func returns true.
+     */
+    template <typename F>
+    static bool _grid_query(nms_t *s, const nms_grid_t &g, nms_scratch_t &sc, int k, F func)
+    {
+        int cx0, cy0, cx1, cy1;
+        _grid_range(s, g, k, cx0, cy0, cx1, cy1);
+        for (int cy = cy0; cy <= cy1; cy++)
+        {
+            for (int cx = cx0; cx <= cx1; cx++)
+            {
+                for (int i : sc.cells[cy * g.gw + cx])
+                {
+                    if (s->stamp[i] == k)
+                        continue;
+                    s->stamp[i] = k;
+                    if (func(i))
+                        return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // greedy NMS, idx sorted by score
+    static void _nms_hard(nms_t *s, const int *idx, int n, float iou_th, nms_scratch_t &sc)
+    {
+        sc.kept.clear();
+        if (n <= NMS_BRUTE_FORCE || iou_th < 0)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                int k = idx[j];
+                bool suppressed = false;
+                for (int i : sc.kept)
+                {
+                    if (_iou(s, i, k) > iou_th)
+                    {
+                        suppressed = true;
+                        break;
+                    }
+                }
+                if (!suppressed)
+                {
+                    sc.kept.push_back(k);
+                    s->keep[k] = 1;
+                }
+            }
+            return;
+        }
+        // only kept boxes are in grid, candidate compares with kept boxes near it
+        nms_grid_t g;
+        _grid_init(s, idx, n, g, sc);
+        for (int j = 0; j < n; j++)
+        {
+            int k = idx[j];
+            bool suppressed = _grid_query(s, g, sc, k, [&](int i)
+                                          { return _iou(s, i, k) > iou_th; });
+            if (!suppressed)
+            {
+                _grid_insert(s, g, sc, k);
+                s->keep[k] = 1;
+            }
+        }
+    }
+
+    // Gaussian soft-NMS, pick the highest score box, decay overlapped boxes, repeat
+    static void _nms_soft(nms_t *s, const int *idx, int n, float sigma, float score_th, nms_scratch_t &sc)
+    {
+        nms_grid_t g;
+        _grid_init(s, idx, n, g, sc);
+        for (int j = 0; j < n; j++)
+            _grid_insert(s, g, sc, idx[j]);
+        // lazy max heap, decayed box is pushed again, outdated entries are skipped when popped
+        typedef std::pair<float, int> item_t;
+        std::priority_queue<item_t> heap;
+        for (int j = 0; j < n; j++)
+            heap.push(item_t(s->scores[idx[j]], idx[j]));
+        while (!heap.empty())
+        {
+            item_t top = heap.top();
+            heap.pop();
+            int k = top.second;
+            if (s->keep[k] || top.first != s->scores[k] || s->scores[k] < score_th)
+                continue;
+            s->keep[k] = 1;
+            _grid_query(s, g, sc, k, [&](int i)
+                        {
+                if (s->keep[i] || s->scores[i] < score_th)
+                    return false;
+                float iou = _iou(s, k, i);
+                if (iou > 0)
+                {
+                    s->scores[i] *= expf(-iou * iou / sigma);
+                    heap.push(item_t(s->scores[i], i));
+                }
+                return false; });
+        }
+    }
+
+    /**
+     * Matrix NMS, idx sorted by score,
+     * decay of box j = min over higher score box i of f(iou(i, j)) / f(compensate(i)), f(x) = exp(-x^2 / sigma),
+     * compensate(i) is the max IoU of box i with boxes have higher score than it.
+     * Boxes not overlapped gives f(0) / f(compensate(i)) >= 1, so only overlapped boxes are needed.
+     */
+    static void _nms_matrix(nms_t *s, const int *idx, int n, float sigma, float score_th, nms_scratch_t &sc)
+    {
+        nms_grid_t g;
+        _grid_init(s, idx, n, g, sc);
+        // boxes are inserted in score order, so boxes found in grid all have higher score
+        for (int j = 0; j < n; j++)
+        {
+            int k = idx[j];
+            float comp = 0;
+            float decay = 1;
+            _grid_query(s, g, sc, k, [&](int i)
+                        {
+                float iou = _iou(s, i, k);
+                if (iou > 0)
+                {
+                    comp = std::max(comp, iou);
+                    decay = std::min(decay, expf((s->comp[i] * s->comp[i] - iou * iou) / sigma));
+                }
+                return false; });
+            s->comp[k] = comp;
+            _grid_insert(s, g, sc, k);
+            s->scores[k] *= decay;
+            if (s->scores[k] >= score_th)
+                s->keep[k] = 1;
+        }
+    }
+
+    NMS::NMS(nn::NMSMethod method, float sigma, bool class_agnostic)
+    {
+        if (sigma <= 0)
+            throw err::Exception(err::ERR_ARGS, "NMS sigma should > 0");
+        _method = method;
+        _sigma = sigma;
+        _class_agnostic = class_agnostic;
+        _handle = new nms_t();
+    }
+
+    NMS::~NMS()
+    {
+        delete (nms_t *)_handle;
+        _handle = nullptr;
+    }
+
+    std::vector<int> NMS::run(int n, const float *x, const float *y, const float *w, const float *h, float *scores,
+                              const int *class_ids, const float *angles, float iou_th, float score_th)
+    {
+        std::vector<int> res;
+        run(n, x, y, w, h, scores, class_ids, angles, res, iou_th, score_th);
+        return res;
+    }
+
+    void NMS::run(int n, const float *x, const float *y, const float *w, const float *h, float *scores,
+                  const int *class_ids, const float *angles, std::vector<int> &res, float iou_th, float score_th)
+    {
+        nms_t *s = (nms_t *)_handle;
+        res.clear();
+        if (n <= 0)
+            return;
+        bool by_class = !_class_agnostic && class_ids;
+        s->rotated = angles != nullptr;
+        s->x1.resize(n);
+        s->y1.resize(n);
+        s->x2.resize(n);
+        s->y2.resize(n);
+        s->area.resize(n);
+        s->scores.assign(scores, scores + n);
+        s->class_ids.assign(n, 0);
+        if (by_class)
+            s->class_ids.assign(class_ids, class_ids + n);
+        if (s->rotated)
+            s->corners.resize(n * 8);
+        for (int i = 0; i < n; i++)
+        {
+            s->area[i] = w[i] * h[i];
+            if (!s->rotated)
+            {
+                s->x1[i] = x[i];
+                s->y1[i] = y[i];
+                s->x2[i] = x[i] + w[i];
+                s->y2[i] = y[i] + h[i];
+                continue;
+            }
+            // corners of box rotated around center, and their bounding box
+            float cx = x[i] + w[i] * 0.5f, cy = y[i] + h[i] * 0.5f;
+            float c = cosf(angles[i] * M_PI), sn = sinf(angles[i] * M_PI);
+            float dx[4] = {-w[i] * 0.5f, w[i] * 0.5f, w[i] * 0.5f, -w[i] * 0.5f};
+            float dy[4] = {-h[i] * 0.5f, -h[i] * 0.5f, h[i] * 0.5f, h[i] * 0.5f};
+            float *p = &s->corners[i * 8];
+            for (int k = 0; k < 4; k++)
+            {
+                p[k * 2] = cx + dx[k] * c - dy[k] * sn;
+                p[k * 2 + 1] = cy + dx[k] * sn + dy[k] * c;
+            }
+            s->x1[i] = std::min(std::min(p[0], p[2]), std::min(p[4], p[6]));
+            s->x2[i] = std::max(std::max(p[0], p[2]), std::max(p[4], p[6]));
+            s->y1[i] = std::min(std::min(p[1], p[3]), std::min(p[5], p[7]));
+            s->y2[i] = std::max(std::max(p[1], p[3]), std::max(p[5], p[7]));
+        }
+
+        // sort by class then score, ties keep input order
+        s->order.resize(n);
+        for (int i = 0; i < n; i++)
+            s->order[i] = i;
+        std::sort(s->order.begin(), s->order.end(), [s](int a, int b)
+                  {
+            if (s->class_ids[a] != s->class_ids[b])
+                return s->class_ids[a] < s->class_ids[b];
+            if (s->scores[a] != s->scores[b])
+                return s->scores[a] > s->scores[b];
+            return a < b; });
+        s->buckets.clear();
+        for (int i = 0; i < n; i++)
+        {
+            if (i == 0 || s->class_ids[s->order[i]] != s->class_ids[s->order[i - 1]])
+                s->buckets.push_back(i);
+        }
+        s->buckets.push_back(n);
+        s->stamp.assign(n, -1);
+        s->keep.assign(n, 0);
+        s->comp.assign(_method == nn::NMSMethod::NMS_MATRIX ? n : 0, 0.f);
+        if ((int)s->scratch.size() < NMS_THREAD_NUM())
+            s->scratch.resize(NMS_THREAD_NUM());
+
+        int bucket_num = (int)s->buckets.size() - 1;
+        #pragma omp parallel for schedule(dynamic)
+        for (int b = 0; b < bucket_num; b++)
+        {
+            nms_scratch_t &sc = s->scratch[NMS_THREAD_ID()];
+            const int *idx = s->order.data() + s->buckets[b];
+            int num = s->buckets[b + 1] - s->buckets[b];
+            if (_method == nn::NMSMethod::NMS_SOFT)
+                _nms_soft(s, idx, num, _sigma, score_th, sc);
+            else if (_method == nn::NMSMethod::NMS_MATRIX)
+                _nms_matrix(s, idx, num, _sigma, score_th, sc);
+            else
+                _nms_hard(s, idx, num, iou_th, sc);
+        }
+
+        int kept = 0;
+        for (int i = 0; i < n; i++)
+            kept += s->keep[i];
+        res.reserve(kept);
+        for (int i = 0; i < n; i++)
+        {
+            if (s->keep[i])
+                res.push_back(i);
+        }
+        std::sort(res.begin(), res.end(), [s](int a, int b)
+                  { return s->scores[a] > s->scores[b] || (s->scores[a] == s->scores[b] && a < b); });
+        if (_method != nn::NMSMethod::NMS_HARD)
+        {
+            for (int i : res)
+                scores[i] = s->scores[i];
+        }
+    }
+
+    template <typename T>
+    static void _run_objects(NMS *nms, nms_t *s, T &objs, int n, std::vector<int> &res, float iou_th, float score_th, bool rotated)
+    {
+        // gather to buffers of nms_t, no memory allocation when reused
+        s->input.resize(n * 6);
+        s->input_class.resize(n);
+        float *x = s->input.data(), *y = x + n, *w = y + n, *h = w + n, *scores = h + n, *angles = scores + n;
+        int *class_ids = s->input_class.data();
+        for (int i = 0; i < n; i++)
+        {
+            nn::Object &o = objs.at(i);
+            x[i] = o.x;
+            y[i] = o.y;
+            w[i] = o.w;
+            h[i] = o.h;
+            scores[i] = o.score;
+            angles[i] = o.angle;
+            class_ids[i] = o.class_id;
+        }
+        nms->run(n, x, y, w, h, scores, class_ids, rotated ? angles : nullptr, res, iou_th, score_th);
+        for (int i : res)
+            objs.at(i).score = scores[i];
+    }
+
+    std::vector<int> NMS::run(nn::Objects &objs, float iou_th, float score_th, bool rotated)
+    {
+        std::vector<int> res;
+        _run_objects(this, (nms_t *)_handle, objs, (int)objs.size(), res, iou_th, score_th, rotated);
+        return res;
+    }
+
+    std::vector<int> NMS::run(std::vector<nn::Object> &objs, float iou_th, float score_th, bool rotated)
+    {
+        std::vector<int> res;
+        _run_objects(this, (nms_t *)_handle, objs, (int)objs.size(), res, iou_th, score_th, rotated);
+        return res;
+    }
+
+    void NMS::run(nn::Objects &objs, std::vector<int> &keep, float iou_th, float score_th, bool rotated)
+    {
+        _run_objects(this, (nms_t *)_handle, objs, (int)objs.size(), keep, iou_th, score_th, rotated);
+    }
+
+    void NMS::run(std::vector<nn::Object> &objs, std::vector<int> &keep, float iou_th, float score_th, bool rotated)
+    {
+        _run_objects(this, (nms_t *)_handle, objs, (int)objs.size(), keep, iou_th, score_th, rotated);
+    }
+
+} // namespace maix::nn
@@ -0,0 +1,326 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add Pipeline, run capture, preprocess, forward, decode and user callback as stages on their own threads.
+ */
+
+#include "maix_nn_pipeline.hpp"
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+namespace maix::nn
+{
+    #define PIPELINE_MAX_QUEUE_SIZE (64)
+    #define PIPELINE_SPIN_COUNT (64)    // yield this many times before sleep when waiting queue
+    #define PIPELINE_SLEEP_US (100)
+
+    /**
+     * Bounded lock-free queue between two stages, one producer and one consumer.
+     * head and tail increase forever, slot is index % size, so no ABA problem.
+     * In drop oldest mode, producer pops the oldest frame when full, so head is advanced by CAS from both sides,
+     * the side fails CAS knows the frame is taken by the other side.
+     */
+    typedef struct
+    {
+        alignas(64) std::atomic<uint64_t> head; // next to pop
+        alignas(64) std::atomic<uint64_t> tail; // next to push
+        std::vector<std::atomic<nn::PipelineFrame *>> slots;
+        uint64_t size;
+    } pipeline_queue_t;
+
+    typedef struct
+    {
+        std::vector<std::function<bool(nn::PipelineFrame &)>> funcs;
+        std::vector<std::string> names;
+        std::vector<pipeline_queue_t *> queues; // queues[i] is between stage i and stage i + 1
+        std::vector<std::thread *> threads;
+        std::vector<std::atomic<uint64_t>> dropped;
+        std::vector<std::atomic<uint32_t>> stage_us; // moving average of stage function time
+        std::atomic<uint64_t> finished;
+        std::atomic<bool> running;
+    } pipeline_t;
+
+    static pipeline_queue_t *_queue_create(int size)
+    {
+        pipeline_queue_t *q = new pipeline_queue_t();
+        q->slots = std::vector<std::atomic<nn::PipelineFrame *>>(size);
+        for (int i = 0; i < size; i++)
+            q->slots[i].store(nullptr, std::memory_order_relaxed);
+        q->head.store(0);
+        q->tail.store(0);
+        q->size = size;
+        return q;
+    }
+
+    /**
+     * Push frame to queue, only called by producer.
+     * @param dropped set to the oldest frame popped if queue full in drop oldest mode, caller should delete it.
+     * @return false if queue full in block mode.
+     */
+    static bool _queue_push(pipeline_queue_t *q, nn::PipelineFrame *frame, bool drop_oldest, nn::PipelineFrame **dropped)
+    {
+        *dropped = nullptr;
+        uint64_t t = q->tail.load(std::memory_order_relaxed);
+        uint64_t h = q->head.load(std::memory_order_acquire);
+        while (t - h >= q->size)
+        {
+            if (!drop_oldest)
+                return false;
+            nn::PipelineFrame *old = q->slots[h % q->size].load(std::memory_order_acquire);
+            if (q->head.compare_exchange_weak(h, h + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                *dropped = old;
+                break;
+            }
+            // h updated by CAS, consumer took one, retry
+        }
+        q->slots[t % q->size].store(frame, std::memory_order_relaxed);
+        q->tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // pop frame from queue, only called by consumer, return nullptr if empty
+    static nn::PipelineFrame *_queue_pop(pipeline_queue_t *q)
+    {
+        uint64_t h = q->head.load(std::memory_order_acquire);
+        while (h != q->tail.load(std::memory_order_acquire))
+        {
+            nn::PipelineFrame *frame = q->slots[h % q->size].load(std::memory_order_acquire);
+            if (q->head.compare_exchange_weak(h, h + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+                return frame;
+            // producer dropped this frame, h updated by CAS, retry
+        }
+        return nullptr;
+    }
+
+    // delete frames left in queue, only called when no thread running
+    static void _queue_clear(pipeline_queue_t *q)
+    {
+        nn::PipelineFrame *frame;
+        while ((frame = _queue_pop(q)) != nullptr)
+            delete frame;
+    }
+
+    static inline void _wait(int &count)
+    {
+        if (++count < PIPELINE_SPIN_COUNT)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(PIPELINE_SLEEP_US));
+    }
+
+    static void _stage_thread(pipeline_t *p, int idx, bool drop_oldest)
+    {
+        int stages = (int)p->funcs.size();
+        bool source = idx == 0;
+        bool sink = idx == stages - 1;
+        pipeline_queue_t *in = source ? nullptr : p->queues[idx - 1];
+        pipeline_queue_t *out = sink ? nullptr : p->queues[idx];
+        uint64_t next_id = 0;
+        nn::PipelineFrame *frame = nullptr;
+        int wait_count = 0;
+        while (p->running.load(std::memory_order_relaxed))
+        {
+            if (source)
+            {
+                // frame of failed capture is reused, so frame ids keep continuous when nothing dropped
+                if (!frame)
+                    frame = new nn::PipelineFrame(next_id++);
+                frame->timestamps.clear();
+                frame->timestamps.push_back(time::ticks_us());
+            }
+            else
+            {
+                frame = _queue_pop(in);
+                if (!frame)
+                {
+                    _wait(wait_count);
+                    continue;
+                }
+            }
+            wait_count = 0;
+
+            uint64_t t0 = time::ticks_us();
+            bool ok = false;
+            try
+            {
+                ok = p->funcs[idx](*frame);
+            }
+            catch (const std::exception &e)
+            {
+                log::error("pipeline stage %s error: %s", p->names[idx].c_str(), e.what());
+            }
+            uint64_t t1 = time::ticks_us();
+            uint32_t avg = p->stage_us[idx].load(std::memory_order_relaxed);
+            p->stage_us[idx].store(avg == 0 ? (uint32_t)(t1 - t0) : (uint32_t)((avg * 7ULL + (t1 - t0)) / 8), std::memory_order_relaxed);
+
+            if (!ok)
+            {
+                if (source)
+                {
+                    frame->release();
+                    continue;
+                }
+                p->dropped[idx].fetch_add(1, std::memory_order_relaxed);
+                delete frame;
+                frame = nullptr;
+                continue;
+            }
+            frame->timestamps.push_back(t1);
+            if (sink)
+            {
+                p->finished.fetch_add(1, std::memory_order_relaxed);
+                delete frame;
+                frame = nullptr;
+                continue;
+            }
+            nn::PipelineFrame *dropped = nullptr;
+            bool pushed;
+            while (!(pushed = _queue_push(out, frame, drop_oldest, &dropped)))
+            {
+                // block mode, wait consumer
+                if (!p->running.load(std::memory_order_relaxed))
+                    break;
+                _wait(wait_count);
+            }
+            wait_count = 0;
+            if (dropped)
+            {
+                p->dropped[idx + 1].fetch_add(1, std::memory_order_relaxed);
+                delete dropped;
+            }
+            if (!pushed)
+                delete frame;
+            frame = nullptr;
+        }
+        if (source && frame)
+            delete frame;
+    }
+
+    Pipeline::Pipeline(int queue_size, bool drop_oldest)
+    {
+        if (queue_size < 1 || queue_size > PIPELINE_MAX_QUEUE_SIZE)
+        {
+            log::error("Pipeline queue_size should in range [1, %d], but got %d", PIPELINE_MAX_QUEUE_SIZE, queue_size);
+            throw err::Exception(err::ERR_ARGS, "Pipeline queue_size error");
+        }
+        _queue_size = queue_size;
+        _drop_oldest = drop_oldest;
+        pipeline_t *p = new pipeline_t();
+        p->finished.store(0);
+        p->running.store(false);
+        _handle = p;
+    }
+
+    Pipeline::~Pipeline()
+    {
+        stop();
+        delete (pipeline_t *)_handle;
+        _handle = nullptr;
+    }
+
+    int Pipeline::add_stage(std::function<bool(nn::PipelineFrame &)> func, const std::string &name)
+    {
+        pipeline_t *p = (pipeline_t *)_handle;
+        if (p->running.load())
+            throw err::Exception(err::ERR_NOT_PERMIT, "Pipeline can not add stage when running");
+        if (!func)
+            throw err::Exception(err::ERR_ARGS, "Pipeline stage function is empty");
+        int idx = (int)p->funcs.size();
+        p->funcs.push_back(func);
+        p->names.push_back(name.empty() ? "stage" + std::to_string(idx) : name);
+        return idx;
+    }
+
+    err::Err Pipeline::start()
+    {
+        pipeline_t *p = (pipeline_t *)_handle;
+        if (p->running.load())
+            return err::ERR_NOT_PERMIT;
+        int stages = (int)p->funcs.size();
+        if (stages == 0)
+        {
+            log::error("Pipeline has no stage");
+            return err::ERR_ARGS;
+        }
+        p->dropped = std::vector<std::atomic<uint64_t>>(stages);
+        p->stage_us = std::vector<std::atomic<uint32_t>>(stages);
+        for (int i = 0; i < stages; i++)
+        {
+            p->dropped[i].store(0);
+            p->stage_us[i].store(0);
+        }
+        p->finished.store(0);
+        for (int i = 0; i < stages - 1; i++)
+            p->queues.push_back(_queue_create(_queue_size));
+        p->running.store(true);
+        for (int i = 0; i < stages; i++)
+            p->threads.push_back(new std::thread(_stage_thread, p, i, _drop_oldest));
+        return err::ERR_NONE;
+    }
+
+    void Pipeline::stop()
+    {
+        pipeline_t *p = (pipeline_t *)_handle;
+        if (!p->running.load())
+            return;
+        p->running.store(false);
+        for (auto t : p->threads)
+        {
+            t->join();
+            delete t;
+        }
+        p->threads.clear();
+        for (auto q : p->queues)
+        {
+            _queue_clear(q);
+            delete q;
+        }
+        p->queues.clear();
+    }
+
+    bool Pipeline::running()
+    {
+        pipeline_t *p = (pipeline_t *)_handle;
+        return p->running.load();
+    }
+
+    int Pipeline::stages()
+    {
+        pipeline_t *p = (pipeline_t *)_handle;
+        return (int)p->funcs.size();
+    }
+
+    uint64_t Pipeline::finished()
+    {
+        pipeline_t *p = (pipeline_t *)_handle;
+        return p->finished.load();
+    }
+
+    std::vector<uint64_t> Pipeline::dropped()
+    {
+        pipeline_t *p = (pipeline_t *)_handle;
+        std::vector<uint64_t> res;
+        for (auto &d : p->dropped)
+            res.push_back(d.load());
+        return res;
+    }
+
+    std::vector<float> Pipeline::stage_time()
+    {
+        pipeline_t *p = (pipeline_t *)_handle;
+        std::vector<float> res;
+        for (auto &t : p->stage_us)
+            res.push_back(t.load() / 1000.0f);
+        return res;
+    }
+
+    std::vector<std::string> Pipeline::stage_names()
+    {
+        pipeline_t *p = (pipeline_t *)_handle;
+        return p->names;
+    }
+
+} // namespace maix::nn
@@ -0,0 +1,534 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add YOLO decoder core, filter anchors by class score in logit space with SIMD, shared by all YOLO models.
+ *                     Add segmentation mask decode of box ROI, fused resize, sigmoid, threshold and bit pack.
+ *                     Add SIMD sigmoid with polynomial exp, and keypoints decode with SIMD.
+ */
+
+#include "maix_nn_yolo_decoder.hpp"
+#include <algorithm>
+#include <string.h>
+#if __riscv_vector
+#include <riscv_vector.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace maix::nn::yolo
+{
+    #define FILTER_BLOCK (512) // anchors of one block, running max and argmax of a block stay in L1 cache
+
+    // scratch buffer reused by calls in the same thread, so no VLA on stack or memory allocation every call,
+    // functions may be called in omp parallel loops, so one buffer per thread and type
+    template <typename T>
+    static T *_scratch(size_t n)
+    {
+        static thread_local std::vector<T> buf;
+        if (buf.size() < n)
+            buf.resize(n);
+        return buf.data();
+    }
+
+    float logit(float prob)
+    {
+        if (prob <= 0)
+            return -INFINITY;
+        if (prob >= 1)
+            return INFINITY;
+        return logf(prob / (1 - prob));
+    }
+
+    // update running max and argmax of n anchors with class c plane p
+    static void _max_update(float *mx, int *id, const float *p, int c, int n)
+    {
+        int i = 0;
+#if __riscv_vector
+        size_t vl;
+        for (; (vl = vsetvl_e32m1(n - i)) > 0; i += vl)
+        {
+            vfloat32m1_t v = vle32_v_f32m1(p + i, vl);
+            vfloat32m1_t m = vle32_v_f32m1(mx + i, vl);
+            vbool32_t gt = vmfgt_vv_f32m1_b32(v, m, vl);
+            vse32_v_f32m1(mx + i, vfmax_vv_f32m1(m, v, vl), vl);
+            vint32m1_t ids = vle32_v_i32m1(id + i, vl);
+            vse32_v_i32m1(id + i, vmerge_vxm_i32m1(gt, ids, c, vl), vl);
+        }
+#elif defined(__ARM_NEON)
+        int32x4_t vc = vdupq_n_s32(c);
+        for (; i + 4 <= n; i += 4)
+        {
+            float32x4_t v = vld1q_f32(p + i);
+            float32x4_t m = vld1q_f32(mx + i);
+            uint32x4_t gt = vcgtq_f32(v, m);
+            vst1q_f32(mx + i, vbslq_f32(gt, v, m));
+            vst1q_s32(id + i, vbslq_s32(gt, vc, vld1q_s32(id + i)));
+        }
+#endif
+        for (; i < n; i++)
+        {
+            if (p[i] > mx[i])
+            {
+                mx[i] = p[i];
+                id[i] = c;
+            }
+        }
+    }
+
+    // dst[i] += a * src[i]
+    static void _axpy(float *dst, const float *src, float a, int n)
+    {
+        int i = 0;
+#if __riscv_vector
+        size_t vl;
+        for (; (vl = vsetvl_e32m1(n - i)) > 0; i += vl)
+        {
+            vfloat32m1_t d = vle32_v_f32m1(dst + i, vl);
+            d = vfmacc_vf_f32m1(d, a, vle32_v_f32m1(src + i, vl), vl);
+            vse32_v_f32m1(dst + i, d, vl);
+        }
+#elif defined(__ARM_NEON)
+        for (; i + 4 <= n; i += 4)
+            vst1q_f32(dst + i, vmlaq_n_f32(vld1q_f32(dst + i), vld1q_f32(src + i), a));
+#endif
+        for (; i < n; i++)
+            dst[i] += a * src[i];
+    }
+
+    // dst[i] = a * src[i]
+    static void _scale(float *dst, const float *src, float a, int n)
+    {
+        int i = 0;
+#if __riscv_vector
+        size_t vl;
+        for (; (vl = vsetvl_e32m1(n - i)) > 0; i += vl)
+            vse32_v_f32m1(dst + i, vfmul_vf_f32m1(vle32_v_f32m1(src + i, vl), a, vl), vl);
+#elif defined(__ARM_NEON)
+        for (; i + 4 <= n; i += 4)
+            vst1q_f32(dst + i, vmulq_n_f32(vld1q_f32(src + i), a));
+#endif
+        for (; i < n; i++)
+            dst[i] = a * src[i];
+    }
+
+    // max of n contiguous floats
+    static float _max(const float *p, int n)
+    {
+        int i = 0;
+        float m = p[0];
+#if __riscv_vector
+        size_t vl = vsetvl_e32m1(1);
+        vfloat32m1_t acc = vfmv_s_f_f32m1(vundefined_f32m1(), m, vl);
+        for (; (vl = vsetvl_e32m1(n - i)) > 0; i += vl)
+            acc = vfredmax_vs_f32m1_f32m1(acc, vle32_v_f32m1(p + i, vl), acc, vl);
+        m = vfmv_f_s_f32m1_f32(acc);
+#elif defined(__ARM_NEON)
+        if (n >= 4)
+        {
+            float32x4_t acc = vld1q_f32(p);
+            for (i = 4; i + 4 <= n; i += 4)
+                acc = vmaxq_f32(acc, vld1q_f32(p + i));
+            float32x2_t r = vpmax_f32(vget_low_f32(acc), vget_high_f32(acc));
+            r = vpmax_f32(r, r);
+            m = vget_lane_f32(r, 0);
+        }
+#endif
+        for (; i < n; i++)
+        {
+            if (p[i] > m)
+                m = p[i];
+        }
+        return m;
+    }
+
+    // exp(x) = 2^n * exp(r), n = round(x / ln2), r = x - n * ln2 in [-ln2/2, ln2/2],
+    // exp(r) by polynomial of cephes expf, relative error about 1e-7 in [-87, 88]
+    #define EXP_HI (88.3762626647949f)
+    #define EXP_LO (-87.3365447504019f)
+    #define EXP_LOG2E (1.44269504088896341f)
+    #define EXP_C1 (0.693359375f)      // ln2 = C1 + C2, C1 has few bits so n * C1 is exact
+    #define EXP_C2 (-2.12194440e-4f)
+    #define EXP_P0 (1.9875691500e-4f)
+    #define EXP_P1 (1.3981999507e-3f)
+    #define EXP_P2 (8.3334519073e-3f)
+    #define EXP_P3 (4.1665795894e-2f)
+    #define EXP_P4 (1.6666665459e-1f)
+    #define EXP_P5 (5.0000001201e-1f)
+
+#if __riscv_vector
+    static inline vfloat32m1_t _exp_f32m1(vfloat32m1_t x, size_t vl)
+    {
+        x = vfmin_vf_f32m1(vfmax_vf_f32m1(x, EXP_LO, vl), EXP_HI, vl);
+        vint32m1_t n = vfcvt_x_f_v_i32m1(vfmul_vf_f32m1(x, EXP_LOG2E, vl), vl); // round to nearest
+        vfloat32m1_t fn = vfcvt_f_x_v_f32m1(n, vl);
+        x = vfnmsac_vf_f32m1(x, EXP_C1, fn, vl);
+        x = vfnmsac_vf_f32m1(x, EXP_C2, fn, vl);
+        vfloat32m1_t y = vfmv_v_f_f32m1(EXP_P0, vl);
+        y = vfadd_vf_f32m1(vfmul_vv_f32m1(y, x, vl), EXP_P1, vl);
+        y = vfadd_vf_f32m1(vfmul_vv_f32m1(y, x, vl), EXP_P2, vl);
+        y = vfadd_vf_f32m1(vfmul_vv_f32m1(y, x, vl), EXP_P3, vl);
+        y = vfadd_vf_f32m1(vfmul_vv_f32m1(y, x, vl), EXP_P4, vl);
+        y = vfadd_vf_f32m1(vfmul_vv_f32m1(y, x, vl), EXP_P5, vl);
+        y = vfmacc_vv_f32m1(vfadd_vf_f32m1(x, 1.0f, vl), y, vfmul_vv_f32m1(x, x, vl), vl); // y * x^2 + x + 1
+        vint32m1_t e = vsll_vx_i32m1(vadd_vx_i32m1(n, 127, vl), 23, vl);
+        return vfmul_vv_f32m1(y, vreinterpret_v_i32m1_f32m1(e), vl);
+    }
+#elif defined(__ARM_NEON)
+    static inline float32x4_t _exp_f32x4(float32x4_t x)
+    {
+        x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(EXP_LO)), vdupq_n_f32(EXP_HI));
+        // n = floor(x / ln2 + 0.5), armv7 has no round to nearest convert
+        float32x4_t fx = vmlaq_n_f32(vdupq_n_f32(0.5f), x, EXP_LOG2E);
+        float32x4_t t = vcvtq_f32_s32(vcvtq_s32_f32(fx));
+        uint32x4_t gt = vcgtq_f32(t, fx);
+        float32x4_t fn = vsubq_f32(t, vreinterpretq_f32_u32(vandq_u32(gt, vreinterpretq_u32_f32(vdupq_n_f32(1.0f)))));
+        x = vmlsq_n_f32(x, fn, EXP_C1);
+        x = vmlsq_n_f32(x, fn, EXP_C2);
+        float32x4_t y = vdupq_n_f32(EXP_P0);
+        y = vmlaq_f32(vdupq_n_f32(EXP_P1), y, x);
+        y = vmlaq_f32(vdupq_n_f32(EXP_P2), y, x);
+        y = vmlaq_f32(vdupq_n_f32(EXP_P3), y, x);
+        y = vmlaq_f32(vdupq_n_f32(EXP_P4), y, x);
+        y = vmlaq_f32(vdupq_n_f32(EXP_P5), y, x);
+        y = vmlaq_f32(vaddq_f32(x, vdupq_n_f32(1.0f)), y, vmulq_f32(x, x));
+        int32x4_t e = vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(fn), vdupq_n_s32(127)), 23);
+        return vmulq_f32(y, vreinterpretq_f32_s32(e));
+    }
+
+    // 1 / d with reciprocal estimate and two Newton steps, armv7 has no float division
+    static inline float32x4_t _recip_f32x4(float32x4_t d)
+    {
+        float32x4_t r = vrecpeq_f32(d);
+        r = vmulq_f32(vrecpsq_f32(d, r), r);
+        return vmulq_f32(vrecpsq_f32(d, r), r);
+    }
+#endif
+
+    void filter_chw(const float *scores, int anchor_num, int class_num, int plane_stride, float th,
+                    std::vector<int> &anchors, std::vector<int> &class_ids, std::vector<float> &max_scores)
+    {
+        anchors.clear();
+        class_ids.clear();
+        max_scores.clear();
+        if (anchor_num <= 0 || class_num <= 0)
+            return;
+        // outputs are used as buffers of running max and argmax, then compacted in place, so no memory allocation when reused
+        max_scores.resize(anchor_num);
+        class_ids.resize(anchor_num);
+        float *mx = max_scores.data();
+        int *id = class_ids.data();
+        int blocks = (anchor_num + FILTER_BLOCK - 1) / FILTER_BLOCK;
+        #pragma omp parallel for
+        for (int b = 0; b < blocks; b++)
+        {
+            int start = b * FILTER_BLOCK;
+            int n = std::min(FILTER_BLOCK, anchor_num - start);
+            float *m = mx + start;
+            int *d = id + start;
+            memcpy(m, scores + start, n * sizeof(float));
+            memset(d, 0, n * sizeof(int));
+            for (int c = 1; c < class_num; c++)
+                _max_update(m, d, scores + (size_t)c * plane_stride + start, c, n);
+        }
+        int num = 0;
+        for (int i = 0; i < anchor_num; i++)
+        {
+            if (mx[i] > th)
+            {
+                anchors.push_back(i);
+                id[num] = id[i];
+                mx[num] = mx[i];
+                num++;
+            }
+        }
+        max_scores.resize(num);
+        class_ids.resize(num);
+    }
+
+    void filter_hwc(const float *scores, int anchor_num, int class_num, int anchor_stride, float th,
+                    std::vector<int> &anchors, std::vector<int> &class_ids, std::vector<float> &max_scores)
+    {
+        anchors.clear();
+        class_ids.clear();
+        max_scores.clear();
+        if (anchor_num <= 0 || class_num <= 0)
+            return;
+        max_scores.resize(anchor_num);
+        float *mx = max_scores.data();
+        #pragma omp parallel for
+        for (int i = 0; i < anchor_num; i++)
+            mx[i] = _max(scores + (size_t)i * anchor_stride, class_num);
+        int num = 0;
+        for (int i = 0; i < anchor_num; i++)
+        {
+            if (mx[i] > th)
+            {
+                const float *p = scores + (size_t)i * anchor_stride;
+                anchors.push_back(i);
+                class_ids.push_back((int)(std::find(p, p + class_num, mx[i]) - p));
+                mx[num++] = mx[i];
+            }
+        }
+        max_scores.resize(num);
+    }
+
+    float dfl(const float *src, int reg_max, int step)
+    {
+        float alpha = src[0];
+        for (int i = 1; i < reg_max; ++i)
+        {
+            float val = src[i * step];
+            if (val > alpha)
+                alpha = val;
+        }
+        float denominator = 0.f;
+        float numerator = 0.f;
+        for (int i = 0; i < reg_max; ++i)
+        {
+            float e = expf(src[i * step] - alpha);
+            denominator += e;
+            numerator += i * e;
+        }
+        return numerator / denominator;
+    }
+
+    void sigmoid(const float *src, float *dst, int n)
+    {
+        int i = 0;
+#if __riscv_vector
+        size_t vl;
+        for (; (vl = vsetvl_e32m1(n - i)) > 0; i += vl)
+        {
+            vfloat32m1_t e = _exp_f32m1(vfneg_v_f32m1(vle32_v_f32m1(src + i, vl), vl), vl);
+            vse32_v_f32m1(dst + i, vfrdiv_vf_f32m1(vfadd_vf_f32m1(e, 1.0f, vl), 1.0f, vl), vl);
+        }
+#elif defined(__ARM_NEON)
+        for (; i + 4 <= n; i += 4)
+        {
+            float32x4_t e = _exp_f32x4(vnegq_f32(vld1q_f32(src + i)));
+            vst1q_f32(dst + i, _recip_f32x4(vaddq_f32(e, vdupq_n_f32(1.0f))));
+        }
+#endif
+        for (; i < n; i++)
+            dst[i] = sigmoid(src[i]);
+    }
+
+    void keypoints(const float *p, int keypoint_num, int kp_step, int ch_step, float anchor_x, float anchor_y, float stride,
+                   float vis_th, int *out)
+    {
+        if (keypoint_num <= 0)
+            return;
+        // gather x, y, visibility to contiguous arrays, then transform and compare with SIMD
+        float *xs = _scratch<float>((size_t)keypoint_num * 3);
+        float *ys = xs + keypoint_num;
+        float *vs = ys + keypoint_num;
+        for (int k = 0; k < keypoint_num; k++)
+        {
+            const float *kp = p + (size_t)k * kp_step;
+            xs[k] = kp[0];
+            ys[k] = kp[ch_step];
+            vs[k] = kp[2 * ch_step];
+        }
+        int k = 0;
+#if __riscv_vector
+        size_t vl;
+        for (; (vl = vsetvl_e32m1(keypoint_num - k)) > 0; k += vl)
+        {
+            vbool32_t vis = vmfgt_vf_f32m1_b32(vle32_v_f32m1(vs + k, vl), vis_th, vl);
+            vfloat32m1_t x = vle32_v_f32m1(xs + k, vl);
+            vfloat32m1_t y = vle32_v_f32m1(ys + k, vl);
+            x = vfmul_vf_f32m1(vfadd_vf_f32m1(vfadd_vv_f32m1(x, x, vl), anchor_x, vl), stride, vl);
+            y = vfmul_vf_f32m1(vfadd_vf_f32m1(vfadd_vv_f32m1(y, y, vl), anchor_y, vl), stride, vl);
+            vint32m1_t invalid = vmv_v_x_i32m1(-1, vl);
+            vint32m1_t xi = vmerge_vvm_i32m1(vis, invalid, vfcvt_rtz_x_f_v_i32m1(x, vl), vl);
+            vint32m1_t yi = vmerge_vvm_i32m1(vis, invalid, vfcvt_rtz_x_f_v_i32m1(y, vl), vl);
+            vsse32_v_i32m1(out + k * 2, 2 * sizeof(int), xi, vl);
+            vsse32_v_i32m1(out + k * 2 + 1, 2 * sizeof(int), yi, vl);
+        }
+#elif defined(__ARM_NEON)
+        float32x4_t vax = vdupq_n_f32(anchor_x);
+        float32x4_t vay = vdupq_n_f32(anchor_y);
+        int32x4_t invalid = vdupq_n_s32(-1);
+        for (; k + 4 <= keypoint_num; k += 4)
+        {
+            uint32x4_t vis = vcgtq_f32(vld1q_f32(vs + k), vdupq_n_f32(vis_th));
+            float32x4_t x = vld1q_f32(xs + k);
+            float32x4_t y = vld1q_f32(ys + k);
+            x = vmulq_n_f32(vaddq_f32(vaddq_f32(x, x), vax), stride);
+            y = vmulq_n_f32(vaddq_f32(vaddq_f32(y, y), vay), stride);
+            int32x4x2_t xy;
+            xy.val[0] = vbslq_s32(vis, vcvtq_s32_f32(x), invalid);
+            xy.val[1] = vbslq_s32(vis, vcvtq_s32_f32(y), invalid);
+            vst2q_s32(out + k * 2, xy);
+        }
+#endif
+        for (; k < keypoint_num; k++)
+        {
+            bool vis = vs[k] > vis_th;
+            out[k * 2] = vis ? (int)((xs[k] * 2 + anchor_x) * stride) : -1;
+            out[k * 2 + 1] = vis ? (int)((ys[k] * 2 + anchor_y) * stride) : -1;
+        }
+    }
+
+    void seg_logits(const float *protos, int proto_w, int proto_h, int mask_num, bool chw, const float *coeffs, int coeff_step,
+                    int x, int y, int w, int h, float *logits)
+    {
+        if (w <= 0 || h <= 0 || mask_num <= 0)
+            return;
+        float *c = _scratch<float>(mask_num);
+        for (int n = 0; n < mask_num; n++)
+            c[n] = coeffs[n * coeff_step];
+        if (chw)
+        {
+            // logits row = sum of coefficient * prototype row, prototype rows are contiguous
+            size_t plane = (size_t)proto_w * proto_h;
+            for (int j = 0; j < h; j++)
+            {
+                float *dst = logits + j * w;
+                const float *src = protos + (size_t)(y + j) * proto_w + x;
+                _scale(dst, src, c[0], w);
+                for (int n = 1; n < mask_num; n++)
+                    _axpy(dst, src + n * plane, c[n], w);
+            }
+        }
+        else
+        {
+            // coefficients of every pixel are contiguous, dot product with 4 accumulators
+            for (int j = 0; j < h; j++)
+            {
+                float *dst = logits + j * w;
+                const float *src = protos + ((size_t)(y + j) * proto_w + x) * mask_num;
+                for (int i = 0; i < w; i++, src += mask_num)
+                {
+                    float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+                    int n = 0;
+                    for (; n + 4 <= mask_num; n += 4)
+                    {
+                        s0 += c[n] * src[n];
+                        s1 += c[n + 1] * src[n + 1];
+                        s2 += c[n + 2] * src[n + 2];
+                        s3 += c[n + 3] * src[n + 3];
+                    }
+                    for (; n < mask_num; n++)
+                        s0 += c[n] * src[n];
+                    dst[i] = (s0 + s1) + (s2 + s3);
+                }
+            }
+        }
+    }
+
+    // bilinear interpolation between rows r0 and r1
+    static inline float _lerp2(const float *r0, const float *r1, int src_w, int x0, float fx, float fy)
+    {
+        int x1 = std::min(x0 + 1, src_w - 1);
+        float top = r0[x0] + (r0[x1] - r0[x0]) * fx;
+        float bottom = r1[x0] + (r1[x1] - r1[x0]) * fx;
+        return top + (bottom - top) * fy;
+    }
+
+    // source position of output position i, nearest: floor(i * scale), bilinear: pixel centers aligned
+    static inline void _map(int i, int src, int dst, bool bilinear, int &p0, float &f)
+    {
+        double scale = (double)src / dst;
+        if (!bilinear)
+        {
+            p0 = std::min((int)floor(i * scale), src - 1);
+            f = 0;
+            return;
+        }
+        double v = std::max((i + 0.5) * scale - 0.5, 0.0);
+        p0 = std::min((int)v, src - 1);
+        f = p0 == src - 1 ? 0 : (float)(v - p0);
+    }
+
+    void seg_mask(const float *logits, int src_w, int src_h, uint8_t *out, int dst_w, int dst_h, float th, bool bilinear)
+    {
+        if (src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0)
+            return;
+        int *x0 = _scratch<int>(dst_w);
+        float *fx = _scratch<float>((size_t)dst_w + 2 * src_w);
+        for (int x = 0; x < dst_w; x++)
+            _map(x, src_w, dst_w, bilinear, x0[x], fx[x]);
+        // sigmoid(v) > th equals to v > logit(th), no exp needed
+        float th_logit = th < 0 ? 0 : logit(th);
+        size_t row_bytes = th < 0 ? dst_w : ((dst_w + 31) >> 5) * 4;
+        // sigmoid of source rows y0 and y0 + 1 for grayscale, or gray/0/1 of source row y0 for nearest,
+        // so sigmoid is only calculated for source pixels
+        float *prob0 = fx + dst_w;
+        float *prob1 = prob0 + src_w;
+        uint8_t *value = _scratch<uint8_t>(src_w);
+        int cache_y = -1, last_y = -1;
+        for (int y = 0; y < dst_h; y++)
+        {
+            int y0;
+            float fy;
+            _map(y, src_h, dst_h, bilinear, y0, fy);
+            uint8_t *dst = out + y * row_bytes;
+            if (!bilinear && y0 == last_y)
+            {
+                memcpy(dst, dst - row_bytes, row_bytes); // upsampled, same as last row
+                continue;
+            }
+            last_y = y0;
+            const float *row = logits + y0 * src_w;
+            if (!bilinear)
+            {
+                if (th < 0)
+                {
+                    sigmoid(row, prob0, src_w);
+                    for (int x = 0; x < src_w; x++)
+                        value[x] = (uint8_t)(prob0[x] * 255);
+                }
+                else
+                {
+                    for (int x = 0; x < src_w; x++)
+                        value[x] = row[x] > th_logit;
+                }
+            }
+            else if (th < 0 && y0 != cache_y)
+            {
+                const float *row1 = logits + std::min(y0 + 1, src_h - 1) * src_w;
+                if (y0 == cache_y + 1 && cache_y >= 0)
+                    memcpy(prob0, prob1, src_w * sizeof(float));
+                else
+                    sigmoid(row, prob0, src_w);
+                sigmoid(row1, prob1, src_w);
+                cache_y = y0;
+            }
+            if (th < 0)
+            {
+                if (!bilinear)
+                {
+                    for (int x = 0; x < dst_w; x++)
+                        dst[x] = value[x0[x]];
+                    continue;
+                }
+                for (int x = 0; x < dst_w; x++)
+                    dst[x] = (uint8_t)(_lerp2(prob0, prob1, src_w, x0[x], fx[x], fy) * 255);
+                continue;
+            }
+            uint32_t *bits = (uint32_t *)dst;
+            for (int i = 0; i < (int)(row_bytes / 4); i++)
+            {
+                uint32_t word = 0;
+                int end = std::min(32, dst_w - i * 32);
+                const int *xs = x0 + i * 32;
+                if (!bilinear)
+                {
+                    for (int b = 0; b < end; b++)
+                        word |= (uint32_t)value[xs[b]] << b;
+                }
+                else
+                {
+                    // interpolate logits, compare without exp
+                    const float *row1 = logits + std::min(y0 + 1, src_h - 1) * src_w;
+                    for (int b = 0; b < end; b++)
+                        word |= (uint32_t)(_lerp2(row, row1, src_w, xs[b], fx[i * 32 + b], fy) > th_logit) << b;
+                }
+                bits[i] = word;
+            }
+        }
+    }
+
+} // namespace maix::nn::yolo
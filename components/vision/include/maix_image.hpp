@@ -13,9 +13,11 @@
 #include "maix_fs.hpp"
 #include "maix_image_def.hpp"
 #include "maix_image_color.hpp"
+#include "maix_image_cmap.hpp"
 #include "maix_image_obj.hpp"
 #include "maix_type.hpp"
 #include <stdlib.h>
+#include <functional>
 
 /**
  * @brief maix.image module, image related definition and functions
@@ -56,6 +58,32 @@ namespace maix::image
     */
     std::vector<int> resize_map_pos_reverse(int w_in, int h_in, int w_out, int h_out, image::Fit fit, int x, int y, int w = -1, int h = -1);
 
+    class Image;
+
+    /**
+     * Buffer descriptor of image pixels for zero copy export, e.g. Python buffer protocol(numpy array, memoryview), DLPack.
+     * Fields are the same as Python buffer protocol, it holds a view of the image, so the pixel buffer is pinned(see Image.view)
+     * and alive until the descriptor is deleted, export should keep the descriptor while exported memory is in use.
+     * @maixcdk maix.image.BufferInfo
+     */
+    class BufferInfo
+    {
+    public:
+        BufferInfo(image::Image *ref) : _ref(ref) {}
+        ~BufferInfo();
+        BufferInfo(const BufferInfo &) = delete;
+        BufferInfo &operator=(const BufferInfo &) = delete;
+
+        void *ptr;                  // address of the first element
+        int itemsize;               // bytes of one element
+        std::string format;         // element format in Python struct module syntax, "B" for uint8, "H" for uint16(RGB565, BGR565)
+        std::vector<int> shape;     // [h, w, c] for RGB888 like formats, [h, w] for GRAYSCALE, RGB565, BGR565, [data_size] for others
+        std::vector<int> strides;   // bytes between two elements of every dimension, rows have stride of image
+        bool readonly;              // always false, write through exported memory modify the image in place
+    private:
+        image::Image *_ref;         // view of the image, keep buffer alive
+    };
+
     /**
      * Image class
      * @maixpy maix.image.Image
@@ -95,6 +123,23 @@ namespace maix::image
          */
         Image(int width, int height, image::Format format, uint8_t *data, int data_size, bool copy, const image::Color &bg = image::COLOR_INVALID);
 
+        /**
+         * Image constructor, wrap external pixel memory(e.g. numpy array, cv::Mat) without copy and share its ownership.
+         * The image owns the memory like a malloc one, share(), assignment and copy on write work as usual,
+         * and release is called when the last image or view(and cv::Mat, tensor created from them without copy) use this buffer is destroyed.
+         * So the memory owner(e.g. python object or cv::Mat) can be captured by release to keep the memory alive.
+         * @param width image width, should > 0
+         * @param height image height, should > 0
+         * @param format image format @see image::Format, only support uncompressed format.
+         * @param data external pixel data, must be valid until release is called.
+         * @param stride bytes from one row to the next row, 0 means continuous rows(width * bytes_per_pixel),
+         *               only RGB888, BGR888, RGBA8888, BGRA8888, RGB565, BGR565, GRAYSCALE support stride not continuous.
+         * @param release called once when buffer is not used any more, can be nullptr if data is always valid.
+         *                Attention, it may be called from any thread which destroy the last image, e.g. for python object should acquire GIL first.
+         * @maixcdk maix.image.Image.Image
+         */
+        Image(int width, int height, image::Format format, uint8_t *data, int stride, const std::function<void()> &release);
+
         Image() {
             _width = 0;
             _height = 0;
@@ -102,6 +147,10 @@ namespace maix::image
             _data = nullptr;
             _data_size = 0;
             _is_malloc = false;
+            _stride = 0;
+            _pack_data = nullptr;
+            _buf = nullptr;
+            _alpha_tiles = nullptr;
         }
         ~Image();
 
@@ -111,6 +160,11 @@ namespace maix::image
          */
         err::Err update(int width, int height, image::Format format, uint8_t *data = NULL, int data_size = 0, bool copy = true);
 
+        /**
+         * Assign image, share pixel buffer with img by reference count instead of copy data,
+         * data will be copied when one of them is modified by Image's methods(copy on write).
+         * If img not own its data(e.g. created with copy=false), is a view or has views, will copy data.
+         */
         void operator=(const image::Image &img);
 
         //************************** get and set basic info **************************//
@@ -150,9 +204,91 @@ namespace maix::image
         /**
          * Get image's data pointer.
          * In MaixPy is capsule object.
+         * @attention If image is shared(is_shared() is true), call detach() before modify data directly,
+         *            or the modification will affect other images share the same buffer.
+         *            Data may be modified after this call, so cache of image like draw_image's alpha tiles will be rebuilt.
          * @maixcdk maix.image.Image.data
          */
-        void *data(){ return _data; }
+        void *data(){ _buf_modified(); return _data; }
+
+        /**
+         * Create a new image object share the same pixel buffer with this image by reference count, no data copy.
+         * Image's methods modify image(e.g. draw_rect) will copy data first if buffer is shared(copy on write),
+         * so share one frame to multiple consumers(display, encoder, streamer, nn) is cheap and safe.
+         * If this image not own its data(e.g. created with copy=false), is a view or has views(buffer pinned, see view()), will return a copied image.
+         * @return new Image object
+         * @maixpy maix.image.Image.share
+         */
+        image::Image *share();
+
+        /**
+         * Whether pixel buffer is shared with other images created by share() or assignment.
+         * @maixpy maix.image.Image.is_shared
+         */
+        bool is_shared();
+
+        /**
+         * Make pixel buffer owned by this image only, copy data if buffer is shared, do nothing if not shared or image is a view.
+         * Call this before modify data returned by data() directly.
+         * @maixpy maix.image.Image.detach
+         */
+        void detach() { _cow(); }
+
+        /**
+         * Get image's row stride, bytes from one row to the next row(for YUV format is the Y plane's row).
+         * Image created by view() has stride bigger than width * bytes_per_pixel, compressed image's stride is 0.
+         * @maixpy maix.image.Image.stride
+         */
+        int stride() { return _stride; }
+
+        /**
+         * Whether image rows are stored continuously, that is stride equal to width * bytes_per_pixel.
+         * @maixpy maix.image.Image.is_contiguous
+         */
+        bool is_contiguous() { return _format > FMT_COMPRESSED_MIN || _stride == _stride_of(_width, _format); }
+
+        /**
+         * Create a sub-image(region of interest) shares the same pixel buffer with this image, no data copy.
+         * Modify the view will modify this image and the reverse. If this image owns its buffer, the view keeps the buffer alive,
+         * else(e.g. image created with copy=false) the data must be valid while the view is in use.
+         * Buffer with views is pinned: if this image's buffer is shared(is_shared()), it's copied first(the same as detach()),
+         * and while views exist, share() and assignment of this image or views copy data, so this image and its views
+         * always write in place and no other image sees the writes.
+         * resize, to_format, crop, draw functions, to_tensor_float32 and find functions can use view directly,
+         * for APIs need raw continuous data(e.g. data(), to_bytes), use copy() to get a continuous image.
+         * @param x left-top x of the region
+         * @param y left-top y of the region
+         * @param w width of the region
+         * @param h height of the region
+         * @return new Image object share data with this image, only support RGB888, BGR888, RGBA8888, BGRA8888, RGB565, BGR565, GRAYSCALE,
+         *         view of the whole image support all formats, it's useful to keep buffer alive when export data without copy(e.g. numpy buffer protocol).
+         * @maixpy maix.image.Image.view
+         */
+        image::Image *view(int x, int y, int w, int h);
+
+        /**
+         * Get buffer descriptor of pixels for zero copy export, e.g. implement Python buffer protocol or create numpy array, cv::Mat without copy.
+         * The descriptor holds a view of this image, so pixel buffer is pinned(modify this image writes in place, share() copies)
+         * and alive even this image is deleted, until the descriptor is deleted.
+         * @return new BufferInfo object, need to delete by caller in C++.
+         * @maixcdk maix.image.Image.buffer_info
+         */
+        image::BufferInfo *buffer_info();
+
+        /**
+         * Get continuous pixel data, for not continuous image(e.g. created by view),
+         * will pack rows to an internal buffer which will be reused by next call and freed when image destroyed.
+         * If modify the packed data, call sync_contiguous_data to write back to image.
+         * @return continuous data pointer, for continuous image is the same as data().
+         * @maixcdk maix.image.Image.contiguous_data
+         */
+        void *contiguous_data();
+
+        /**
+         * Write packed data from contiguous_data back to image rows, do nothing for continuous image.
+         * @maixcdk maix.image.Image.sync_contiguous_data
+         */
+        void sync_contiguous_data();
 
         /**
          * To string method
@@ -176,6 +312,7 @@ namespace maix::image
          * format is FMT_RGB888, rgbtuple is true, return [R, G, B]; rgbtuple is false, return [RGB]
          * foramt is FMT_BGR888, rgbtuple is true, return [B, G, R]; rgbtuple is false, return [BGR]
          * format is FMT_GRAYSCALE, return [GRAY];
+         * format is FMT_BITMAP, return [0] or [1];
          *
          * @maixpy maix.image.Image.get_pixel
         */
@@ -183,7 +320,7 @@ namespace maix::image
             std::vector<uint32_t> pixels;
             if (!(_format == image::Format::FMT_RGB888 || _format == image::Format::FMT_BGR888 ||
                 _format == image::Format::FMT_RGB565 || _format == image::Format::FMT_BGR565 ||
-                _format == image::Format::FMT_GRAYSCALE ||
+                _format == image::Format::FMT_GRAYSCALE || _format == image::Format::FMT_BITMAP ||
                 _format == image::Format::FMT_RGBA8888 || _format == image::Format::FMT_BGRA8888)) {
                 log::error("get_pixel not support format: %d\r\n", _format);
                 return pixels;
@@ -194,13 +331,20 @@ namespace maix::image
                 return pixels;
             }
 
+            if (_format == image::Format::FMT_BITMAP) {
+                uint32_t *row = (uint32_t *)((uint8_t *)_data + y * _stride);
+                pixels.push_back((row[x >> 5] >> (x & 31)) & 1);
+                return pixels;
+            }
+
+            uint8_t *p = (uint8_t *)_data + y * _stride + x * (int)image::fmt_size[_format];
             switch (_format) {
             case image::Format::FMT_RGB888: // fall through
             case image::Format::FMT_BGR888:
             {
-                uint8_t v0 = ((uint8_t *)_data)[y * _width * 3 + x * 3 + 0];
-                uint8_t v1 = ((uint8_t *)_data)[y * _width * 3 + x * 3 + 1];
-                uint8_t v2 = ((uint8_t *)_data)[y * _width * 3 + x * 3 + 2];
+                uint8_t v0 = p[0];
+                uint8_t v1 = p[1];
+                uint8_t v2 = p[2];
                 if (!rgbtuple) {
                     uint32_t value = v2 << 16 | v1 << 8 | v0;
                     pixels.push_back(value);
@@ -212,16 +356,16 @@ namespace maix::image
                 break;
             }
             case image::Format::FMT_GRAYSCALE:
-                pixels.push_back(((uint8_t *)_data)[y * _width + x]);
+                pixels.push_back(p[0]);
                 break;
             case image::Format::FMT_BGR565: // fall through
             case image::Format::FMT_RGB565:
             {
                 if (!rgbtuple) {
-                    uint32_t value = ((uint16_t *)_data)[y * _width + x] & 0xffff;
+                    uint32_t value = *(uint16_t *)p & 0xffff;
                     pixels.push_back(value);
                 } else {
-                    uint32_t value = ((uint16_t *)_data)[y * _width + x] & 0xffff;
+                    uint32_t value = *(uint16_t *)p & 0xffff;
                     uint32_t v0 = (value >> 11) & 0x1F;
                     uint32_t v1 = (value >> 5) & 0x3F;
                     uint32_t v2 = value & 0x1F;
@@ -234,10 +378,10 @@ namespace maix::image
             case image::Format::FMT_RGBA8888: // fall through
             case image::Format::FMT_BGRA8888:
                 if (!rgbtuple) {
-                    uint32_t value = ((uint32_t *)_data)[y * _width + x] & 0xffffffff;
+                    uint32_t value = *(uint32_t *)p & 0xffffffff;
                     pixels.push_back(value);
                 } else {
-                    uint32_t value = ((uint32_t *)_data)[y * _width + x] & 0xffffffff;
+                    uint32_t value = *(uint32_t *)p & 0xffffffff;
                     uint32_t v0 = value & 0xFF;
                     uint32_t v1 = (value >> 8) & 0xFF;
                     uint32_t v2 = (value >> 16) & 0xFF;
@@ -264,13 +408,14 @@ namespace maix::image
          * format is FMT_RGB888, pixel size must be 1 or 3, if size is 1, will split pixel[0] to [R, G, B]; if size is 3, will use pixel directly
          * format is FMT_BGR888, pixel size must be 1 or 3, if size is 1, will split pixel[0] to [B, G, R]; if size is 3, will use pixel directly
          * format is FMT_GRAYSCALE, pixel size must be 1, will use pixel directly
+         * format is FMT_BITMAP, pixel size must be 1, not 0 value will set pixel to 1
          * @return error code, Err::ERR_NONE is ok, other is error
          * @maixpy maix.image.Image.set_pixel
         */
         err::Err set_pixel(int x, int y, std::vector<uint32_t> pixel) {
             if (!(_format == image::Format::FMT_RGB888 || _format == image::Format::FMT_BGR888 ||
                 _format == image::Format::FMT_RGB565 || _format == image::Format::FMT_BGR565 ||
-                _format == image::Format::FMT_GRAYSCALE ||
+                _format == image::Format::FMT_GRAYSCALE || _format == image::Format::FMT_BITMAP ||
                 _format == image::Format::FMT_RGBA8888 || _format == image::Format::FMT_BGRA8888)) {
                 log::error("get_pixel not support format: %d\r\n", _format);
                 return err::Err::ERR_RUNTIME;
@@ -281,18 +426,32 @@ namespace maix::image
                 return err::Err::ERR_RUNTIME;
             }
 
+            _cow();
+            if (_format == image::Format::FMT_BITMAP) {
+                if (pixel.size() != 1) {
+                    log::error("set_pixel pixel size must be 1, but %d\r\n", pixel.size());
+                    return err::Err::ERR_RUNTIME;
+                }
+                uint32_t *row = (uint32_t *)((uint8_t *)_data + y * _stride);
+                if (pixel[0])
+                    row[x >> 5] |= 1u << (x & 31);
+                else
+                    row[x >> 5] &= ~(1u << (x & 31));
+                return err::Err::ERR_NONE;
+            }
+            uint8_t *p = (uint8_t *)_data + y * _stride + x * (int)image::fmt_size[_format];
             switch (_format) {
             case image::Format::FMT_RGB888: // fall through
             case image::Format::FMT_BGR888:
                 if (pixel.size() == 1) {
                     uint8_t v0 = pixel[0];
-                    ((uint8_t *)_data)[y * _width * 3 + x * 3 + 0] = (v0 >> 16) & 0xFF;
-                    ((uint8_t *)_data)[y * _width * 3 + x * 3 + 1] = (v0 >> 8) & 0xFF;
-                    ((uint8_t *)_data)[y * _width * 3 + x * 3 + 2] = v0 & 0xFF;
+                    p[0] = (v0 >> 16) & 0xFF;
+                    p[1] = (v0 >> 8) & 0xFF;
+                    p[2] = v0 & 0xFF;
                 } else if (pixel.size() == 3 || pixel.size() == 4) {
-                    ((uint8_t *)_data)[y * _width * 3 + x * 3 + 0] = pixel[0];
-                    ((uint8_t *)_data)[y * _width * 3 + x * 3 + 1] = pixel[1];
-                    ((uint8_t *)_data)[y * _width * 3 + x * 3 + 2] = pixel[2];
+                    p[0] = pixel[0];
+                    p[1] = pixel[1];
+                    p[2] = pixel[2];
                 } else {
                     log::error("set_pixel pixel size must be 1, 3, 4, but %d\r\n", pixel.size());
                     return err::Err::ERR_RUNTIME;
@@ -300,7 +459,7 @@ namespace maix::image
                 break;
             case image::Format::FMT_GRAYSCALE:
                 if (pixel.size() == 1) {
-                    ((uint8_t *)_data)[y * _width + x] = pixel[0];
+                    p[0] = pixel[0];
                 } else {
                     log::error("set_pixel pixel size must be 1, but %d\r\n", pixel.size());
                     return err::Err::ERR_RUNTIME;
@@ -310,10 +469,10 @@ namespace maix::image
             case image::Format::FMT_RGB565:
             {
                 if (pixel.size() == 1) {
-                    ((uint16_t *)_data)[y * _width + x] = pixel[0];
+                    *(uint16_t *)p = pixel[0];
                 } else if (pixel.size() == 3) {
                     int num = ((pixel[0] & 0x1F) << 11) | ((pixel[1] & 0x3F) << 5) | (pixel[2] & 0x1F);
-                    ((uint16_t *)_data)[y * _width + x] = num;
+                    *(uint16_t *)p = num;
                 } else {
                     log::error("set_pixel pixel size must be 1 or 3, but %d\r\n", pixel.size());
                     return err::Err::ERR_RUNTIME;
@@ -323,17 +482,17 @@ namespace maix::image
             case image::Format::FMT_RGBA8888: // fall through
             case image::Format::FMT_BGRA8888:
                 if (pixel.size() == 1) {
-                    ((uint32_t *)_data)[y * _width + x] = (uint32_t)pixel[0];
+                    *(uint32_t *)p = (uint32_t)pixel[0];
                 } else if (pixel.size() == 3) {
-                    ((uint8_t *)_data)[(y * _width << 2) + (x << 2) + 0] = pixel[0];
-                    ((uint8_t *)_data)[(y * _width << 2) + (x << 2) + 1] = pixel[1];
-                    ((uint8_t *)_data)[(y * _width << 2) + (x << 2) + 2] = pixel[2];
-                    ((uint8_t *)_data)[(y * _width << 2) + (x << 2) + 3] = 255;
+                    p[0] = pixel[0];
+                    p[1] = pixel[1];
+                    p[2] = pixel[2];
+                    p[3] = 255;
                 } else if (pixel.size() == 4) {
-                    ((uint8_t *)_data)[(y * _width << 2) + (x << 2) + 0] = pixel[0];
-                    ((uint8_t *)_data)[(y * _width << 2) + (x << 2) + 1] = pixel[1];
-                    ((uint8_t *)_data)[(y * _width << 2) + (x << 2) + 2] = pixel[2];
-                    ((uint8_t *)_data)[(y * _width << 2) + (x << 2) + 3] = (uint8_t)(pixel[3]*255);
+                    p[0] = pixel[0];
+                    p[1] = pixel[1];
+                    p[2] = pixel[2];
+                    p[3] = (uint8_t)(pixel[3]*255);
                 } else {
                     log::error("set_pixel pixel size must be 1, 3, 4, but %d\r\n", pixel.size());
                     return err::Err::ERR_RUNTIME;
@@ -347,6 +506,104 @@ namespace maix::image
             return err::Err::ERR_NONE;
         }
 
+        /**
+         * Get pointer of row y, pixel type is decided by format F at compile time, no format switch for each pixel.
+         * Will copy data first if buffer is shared(copy on write), use const_row for read only access.
+         * @param y row index, not checked
+         * @return pointer of the first pixel of row y, rows are not continuous if image is a view, use row() for every row.
+         * @throw err.Exception if image format is not F
+         * @maixcdk maix.image.Image.row
+         */
+        template <image::Format F>
+        typename image::FormatTraits<F>::pixel_t *row(int y)
+        {
+            if (_format != F)
+                throw err::Exception(err::ERR_ARGS, "row: image format not match");
+            _cow();
+            return (typename image::FormatTraits<F>::pixel_t *)((uint8_t *)_data + y * _stride);
+        }
+
+        /**
+         * Get read only pointer of row y, same as row() but not copy shared buffer.
+         * @param y row index, not checked
+         * @return pointer of the first pixel of row y
+         * @throw err.Exception if image format is not F
+         * @maixcdk maix.image.Image.const_row
+         */
+        template <image::Format F>
+        const typename image::FormatTraits<F>::pixel_t *const_row(int y)
+        {
+            if (_format != F)
+                throw err::Exception(err::ERR_ARGS, "const_row: image format not match");
+            return (const typename image::FormatTraits<F>::pixel_t *)((uint8_t *)_data + y * _stride);
+        }
+
+        /**
+         * Call fn for every pixel, format check and copy on write are done once, pixels are walked row by row with stride.
+         * e.g. img.for_each_pixel<image::FMT_RGB888>([](int x, int y, image::PixelRGB888 &p) { p.r = 255 - p.r; });
+         * @param fn function called as fn(int x, int y, FormatTraits<F>::pixel_t &pixel), pixel can be modified.
+         * @param parallel process rows in parallel with OpenMP, fn must be thread safe, default false.
+         * @throw err.Exception if image format is not F
+         * @maixcdk maix.image.Image.for_each_pixel
+         */
+        template <image::Format F, typename Fn>
+        void for_each_pixel(Fn fn, bool parallel = false)
+        {
+            typedef typename image::FormatTraits<F>::pixel_t pixel_t;
+            if (_format != F)
+                throw err::Exception(err::ERR_ARGS, "for_each_pixel: image format not match");
+            _cow();
+            uint8_t *data = (uint8_t *)_data;
+            int width = _width, height = _height, stride = _stride;
+            #pragma omp parallel for if(parallel)
+            for (int y = 0; y < height; y++)
+            {
+                pixel_t *p = (pixel_t *)(data + y * stride);
+                for (int x = 0; x < width; x++)
+                    fn(x, y, p[x]);
+            }
+        }
+
+        /**
+         * Get pixels of a rectangle in one call, rows are packed continuous in result.
+         * Only support RGB888, BGR888, RGBA8888, BGRA8888, RGB565, BGR565, GRAYSCALE.
+         * @param roi region [x, y, w, h], must inside image, default empty means whole image.
+         * @return pixels data, size is w * h * bytes_per_pixel, same pixel layout as image format.
+         * @throw err.Exception if format not support or roi invalid.
+         * @maixpy maix.image.Image.get_pixels
+         */
+        Bytes *get_pixels(std::vector<int> roi = std::vector<int>());
+
+        /**
+         * Get pixels of a rectangle into user's buffer, rows are packed continuous.
+         * @param roi region [x, y, w, h], must inside image, empty means whole image.
+         * @param buff output buffer, size must >= w * h * bytes_per_pixel
+         * @param buff_size buffer size
+         * @return err::ERR_NONE if success, err::ERR_ARGS if roi invalid or buffer too small, err::ERR_NOT_IMPL if format not support.
+         * @maixcdk maix.image.Image.get_pixels
+         */
+        err::Err get_pixels(std::vector<int> roi, void *buff, size_t buff_size);
+
+        /**
+         * Set pixels of a rectangle in one call from packed rows data, will copy data first if buffer is shared(copy on write).
+         * Only support RGB888, BGR888, RGBA8888, BGRA8888, RGB565, BGR565, GRAYSCALE.
+         * @param roi region [x, y, w, h], must inside image, empty means whole image.
+         * @param data pixels data, size must be w * h * bytes_per_pixel, same pixel layout as image format.
+         * @return err::ERR_NONE if success, err::ERR_ARGS if roi or data size invalid, err::ERR_NOT_IMPL if format not support.
+         * @maixpy maix.image.Image.set_pixels
+         */
+        err::Err set_pixels(std::vector<int> roi, Bytes *data);
+
+        /**
+         * Set pixels of a rectangle from packed rows data.
+         * @param roi region [x, y, w, h], must inside image, empty means whole image.
+         * @param data pixels data
+         * @param size data size, must be w * h * bytes_per_pixel
+         * @return err::ERR_NONE if success, err::ERR_ARGS if roi or data size invalid, err::ERR_NOT_IMPL if format not support.
+         * @maixcdk maix.image.Image.set_pixels
+         */
+        err::Err set_pixels(std::vector<int> roi, const void *data, size_t size);
+
         //************************** convert format **************************//
         // more maixpy convert func in MaixPy project's convert_image.hpp
 
@@ -355,7 +612,8 @@ namespace maix::image
          * @param chw convert to tensor with CHW or HWC layout result, image is HWC,
          *            so default chw is false, if set true, will convert to CHW layout.
          *            Attention, if set chw to true, copy must be true, or will raise err.Exception.
-         * @param copy if true, will alloc memory for tensor data, else will use the memory of Image object.
+         * @param copy if true, will alloc memory for tensor data, else will use the memory of Image object,
+         *             and the tensor keeps image's buffer alive, so it can be used after image is destroyed.
          *             Attention, if set chw to true, copy must be true, or will raise err.Exception.
          * @return tensor::Tensor object pointer, an allocated tensor object
          * @maixpy maix.image.Image.to_tensor
@@ -429,6 +687,17 @@ namespace maix::image
         */
         image::Image *to_jpeg(int quality = 95, void *buff = nullptr, size_t buff_size = 0);
 
+        /**
+         * Map grayscale image to pseudo color image by colormap, resize(bicubic) and colormap lookup are done in one pass.
+         * @param cmap colormap, @see image::CMap. For colormap less than 256 colors(for classify), gray value is used as index cyclically.
+         * @param out_size output image size, default Size() means same as this image.
+         * @param format output image format, support FMT_RGB888, FMT_BGR888, FMT_YVU420SP(NV21), default FMT_RGB888.
+         * @return new image object, need to delete by caller in C++.
+         * @throw err.Exception if this image is not GRAYSCALE or args invalid.
+         * @maixpy maix.image.Image.apply_cmap
+         */
+        image::Image *apply_cmap(image::CMap cmap, image::Size out_size = image::Size(), image::Format format = image::FMT_RGB888);
+
         //************************** draw **************************//
 
         /**
@@ -436,11 +705,18 @@ namespace maix::image
          * @param x left top corner of image point's coordinate x
          * @param y left top corner of image point's coordinate y
          * @param img image object to draw, the caller's channel must <= the args' channel,
-         *            e.g. caller is RGB888, args is RGBA8888, will throw exception, but caller is RGBA8888, args is RGB888 or RGBA8888 is ok
+         *            e.g. caller is RGB888, args is GRAYSCALE, will throw exception, but caller is RGBA8888, args is RGB888 or RGBA8888 is ok.
+         *            RGBA8888 and BGRA8888 image will be alpha blended(Porter-Duff over) directly onto
+         *            RGB888, BGR888, RGBA8888, BGRA8888, GRAYSCALE, YVU420SP(NV21) and YUV420SP(NV12) image without format convert,
+         *            fully transparent 16x16 tiles are skipped by an occupancy map cached in img,
+         *            the cache is rebuilt after img modified by Image's methods or img.data() called,
+         *            call img.data() again before modify img after draw_image, don't keep the pointer.
+         * @param premultiplied if true, img's RGB is premultiplied by alpha, and this image's RGB is premultiplied too if it has alpha channel,
+         *                      only valid when img has alpha channel, default false.
          * @return this image object self
          * @maixpy maix.image.Image.draw_image
          */
-        image::Image *draw_image(int x, int y, image::Image &img);
+        image::Image *draw_image(int x, int y, image::Image &img, bool premultiplied = false);
 
         /**
          * Fill rectangle color to image
@@ -578,6 +854,7 @@ namespace maix::image
 
         /**
          * Affine transform image, will create a new transformed image object, need 3 points.
+         * Transform matrix is calculated every call, use image.Warp to apply the same transform to every frame faster.
          * @param src_points three source points, [x1, y1, x2, y2, x3, y3]
          * @param dst_points three destination points, [x1, y1, x2, y2, x3, y3]
          * @param width new width, if value is -1, will use height to calculate aspect ratio
@@ -590,6 +867,7 @@ namespace maix::image
 
         /**
          * Perspective transform image, will create a new transformed image object, need 4 points.
+         * Transform matrix is calculated every call, use image.Warp to apply the same transform to every frame faster.
          * @param src_points three source points, [x1, y1, x2, y2, x3, y3, x4, y4]
          * @param dst_points three destination points, [x1, y1, x2, y2, x3, y3, x4, y4]
          * @param width new width, if value is -1, will use height to calculate aspect ratio
@@ -601,7 +879,7 @@ namespace maix::image
         image::Image* perspective(std::vector<int> src_points, std::vector<int> dst_points, int width = -1, int height = -1, image::ResizeMethod method = image::ResizeMethod::BILINEAR);
 
         /**
-         * Copy image, will create a new copied image object
+         * Copy image, will create a new copied image object, use share() if you only need to read the image to avoid data copy.
          * @return new copied image object
          * @maixpy maix.image.Image.copy
          */
@@ -620,6 +898,7 @@ namespace maix::image
 
         /**
          * Rotate image, will create a new rotated image object
+         * Use image.Warp with Warp.rotate_matrix to apply the same rotate to every frame faster.
          * @param angle anti-clock wise rotate angle, if angle is 90 or 270, and width or height is -1, will swap width and height, or will throw exception
          * @param width new width, if value is -1, will use height to calculate aspect ratio
          * @param height new height, if value is -1, will use width to calculate aspect ratio
@@ -724,7 +1003,9 @@ namespace maix::image
          * @param zero If zero is true, the image will be set the pixels within the threshold to 0, other pixels remain unchanged. If zero is false, the image will be set to black or white. default is false.
          * @param mask Mask is another image to use as a pixel level mask for the operation. The mask should be an image with just black or white pixels and should be the same size as the image being operated on.
          * Only pixels set in the mask are modified. default is None.
-         * @param to_bitmap If true, the image will be converted to a bitmap image before thresholding. default is false. TODO: support in the future
+         * @param to_bitmap If true, the result will be a 1-bit FMT_BITMAP image, pixels within the threshold are 1, others are 0.
+         * logic ops, erode/dilate, get_statistics and find_blobs of FMT_BITMAP image process 32 pixels a time.
+         * If copy is false, this image will become FMT_BITMAP, image not own its data(e.g. camera frame) not support, default is false.
          * @param copy Select whether to return a new image or modify the original image. default is false.
          * @return Returns the image after the operation is completed.
          * @maixpy maix.image.Image.binary
@@ -989,6 +1270,7 @@ namespace maix::image
 
         /**
          * @brief Runs the histogram equalization algorithm on the image.
+         * For every frame processing of video stream, image.CLAHE is faster(parallel tiles), supports YUV420SP and keeps lookup tables between frames.
          * @param adaptive If true, an adaptive histogram equalization method will be run on the image instead which as generally better results than non-adaptive histogram qualization but a longer run time. default is false.
          * @param clip_limit Provides a way to limit the contrast of the adaptive histogram qualization. Use a small value for this, like 10, to produce good histogram equalized contrast limited images. default is -1.
          * @param mask Mask is another image to use as a pixel level mask for the operation. The mask should be an image with just black or white pixels and should be the same size as the image being operated on.
@@ -1332,6 +1614,7 @@ namespace maix::image
          * @param thresholds You can define multiple thresholds.
          * For GRAYSCALE format, you can use {{Lmin, Lmax}, ...} to define one or more thresholds.
          * For RGB888 format, you can use {{Lmin, Lmax, Amin, Amax, Bmin, Bmax}, ...} to define one or more thresholds.
+         * For BITMAP format, use {{1, 1}} to find blobs of set pixels, blobs are labelled on packed rows directly when merge is false and no histogram.
          * Where the upper case L,A,B represent the L,A,B channels of the LAB image format, and min, max represent the minimum and maximum values of the corresponding channels.
          * @param invert if true, will invert thresholds before find blobs, default is false
          * @param roi The region of interest, input in the format of (x, y, w, h), x and y are the coordinates of the upper left corner, w and h are the width and height of roi.
@@ -1387,6 +1670,7 @@ namespace maix::image
          * @param merge_degree Minimum angle difference required when merging multiple lines
          * @param min_len_of_new_path The minimum length of a new path, if the crossing length exceeds this value, it is considered a new path.
          * @return Return the line when found lines, format is (groupline1, groupline2, ...), you can use LineGroup class methods to do more operations
+         * @note This method runs Canny and Hough transform every call, for tracking line every frame, use image.LinePathSearcher instead, which is much faster.
          * @maixpy maix.image.Image.search_line_path
          */
         std::vector<image::LineGroup> search_line_path(int threshold = 30, int merge_degree = 10, int min_len_of_new_path = 10);
@@ -1474,6 +1758,7 @@ namespace maix::image
         /**
          * @brief Finds the displacement between the image and the template.    TODO: support in the future
          * note: this method must be used on power-of-2 image sizes
+         * To compare every frame of video with the same reference(stabilization, odometry), use image.DisplacementTracker, which caches reference's spectrum.
          * @param template_image The template image.
          * @param roi The region of interest, input in the format of (x, y, w, h), x and y are the coordinates of the upper left corner, w and h are the width and height of roi.
          * default is None, means whole image.
@@ -1519,7 +1804,7 @@ namespace maix::image
         image::LBPKeyPoint find_lbp(std::vector<int> roi = std::vector<int>());
 
         /**
-         * @brief Finds the keypoints in the image. TODO: support in the future.
+         * @brief Finds the keypoints in the image. TODO: support in the future. Use image.ORB for multi-thread ORB extraction now.
          * @param roi The region of interest, input in the format of (x, y, w, h), x and y are the coordinates of the upper left corner, w and h are the width and height of roi.
          * default is None, means whole image.
          * @param threshold The threshold to use for the keypoints. default is 20.
@@ -1563,7 +1848,7 @@ namespace maix::image
         int match_lbp_descriptor(image::LBPKeyPoint &desc1, image::LBPKeyPoint &desc2);
 
         /**
-         * @brief Matches the orb descriptor of the image. TODO: support in the future
+         * @brief Matches the orb descriptor of the image. TODO: support in the future. Use image.ORB.match or image.ORBIndex now.
          * @param desc1 The descriptor to use for the match.
          * @param desc2 The descriptor to use for the match.
          * @param threshold The threshold to use for the match. default is 95.
@@ -1598,10 +1883,34 @@ namespace maix::image
         int _data_size;
         Format _format;
         bool _is_malloc;
+        int _stride;        // row bytes, for YUV is Y plane row bytes, 0 for compressed format
+        void *_pack_data;   // continuous buffer for strided image, used by contiguous_data
+        void *_buf;         // reference counted pixel buffer, nullptr if data not owned by image
+        void *_alpha_tiles; // alpha occupancy map of 16x16 tiles, cache for draw_image
+
+        static int _stride_of(int width, image::Format format)
+        {
+            if (format >= image::FMT_YUV422SP && format <= image::FMT_YUV420P)
+                return width;
+            if (format == image::FMT_BITMAP)
+                return ((width + 31) >> 5) * 4;
+            if (format < image::FMT_UNCOMPRESSED_MAX)
+                return width * (int)image::fmt_size[format];
+            return 0;
+        }
 
         int _get_cv_pixel_num(image::Format &format);
         std::vector<int> _get_available_roi(std::vector<int> roi, std::vector<int> other_roi = std::vector<int>());
         void _create_image(int width, int height, image::Format format, uint8_t *data, int data_size, bool copy, const image::Color &bg = image::FMT_INVALID);
+        void _alloc_buffer(int size);
+        void _release();
+        void _cow();
+        err::Err _check_pixels_roi(std::vector<int> &roi, size_t size, int *bpp);
+        uint32_t _buf_version();
+        void _buf_modified();
+        void *_get_alpha_tiles();
+        void _free_alpha_tiles();
+        void _draw_image_alpha(int x, int y, int src_x, int src_y, int w, int h, image::Image &img, bool premultiplied);
     }; // class Image
 
     /**
@@ -1627,6 +1936,43 @@ namespace maix::image
     */
     image::Image *from_bytes(int width, int height, image::Format format, Bytes *data, bool copy = true);
 
+    /**
+     * Create pseudo color image from float data(e.g. depth map, thermal matrix) by colormap.
+     * Normalize, bicubic resize and colormap lookup are done in one multi-thread pass, no intermediate image.
+     * @param data float data, row major, size is w * h
+     * @param w data width
+     * @param h data height
+     * @param min_v value map to the first color of cmap, values less than it are clamped.
+     * @param max_v value map to the last color of cmap, values greater than it are clamped.
+     *              If min_v >= max_v, will use min and max value of data, default 0 and 0.
+     * @param cmap colormap, @see image::CMap, default image::CMap::TURBO
+     * @param out_size output image size, data will be resized by bicubic interpolation before colormap lookup,
+     *                 default Size() means same as data size.
+     * @param format output image format, support FMT_RGB888, FMT_BGR888, FMT_YVU420SP(NV21), default FMT_RGB888.
+     * @return new image object, need to delete by caller in C++.
+     * @throw err.Exception if args invalid.
+     * @maixcdk maix.image.from_float
+     */
+    image::Image *from_float(const float *data, int w, int h, float min_v = 0, float max_v = 0, image::CMap cmap = image::CMap::TURBO,
+                             image::Size out_size = image::Size(), image::Format format = image::FMT_RGB888);
+
+    /**
+     * Create pseudo color image from float32 tensor(e.g. depth map, thermal matrix) by colormap.
+     * Normalize, bicubic resize and colormap lookup are done in one multi-thread pass, no intermediate image.
+     * @param tensor float32 tensor, shape is [h, w], dims of size 1 are ignored, e.g. [1, h, w] is ok.
+     * @param min_v value map to the first color of cmap, values less than it are clamped.
+     * @param max_v value map to the last color of cmap, values greater than it are clamped.
+     *              If min_v >= max_v, will use min and max value of data, default 0 and 0.
+     * @param cmap colormap, @see image::CMap, default image::CMap::TURBO
+     * @param out_size output image size, default Size() means same as tensor size.
+     * @param format output image format, support FMT_RGB888, FMT_BGR888, FMT_YVU420SP(NV21), default FMT_RGB888.
+     * @return new image object
+     * @throw err.Exception if args invalid.
+     * @maixpy maix.image.from_float
+     */
+    image::Image *from_float(tensor::Tensor *tensor, float min_v = 0, float max_v = 0, image::CMap cmap = image::CMap::TURBO,
+                             image::Size out_size = image::Size(), image::Format format = image::FMT_RGB888);
+
     /**
      * Load font from file
      * @param name font name, used to identify font
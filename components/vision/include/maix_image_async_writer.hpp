@@ -0,0 +1,127 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add AsyncWriter, save images in background thread.
+ */
+
+#pragma once
+
+#include "maix_image.hpp"
+#include <string>
+#include <functional>
+
+namespace maix::image
+{
+    /**
+     * What AsyncWriter do when pending images exceed memory budget or queue length.
+     * @maixpy maix.image.AsyncWriterPolicy
+     */
+    enum AsyncWriterPolicy
+    {
+        ASYNC_WRITER_BLOCK = 0,   // block caller until enough space
+        ASYNC_WRITER_DROP_NEW,    // drop the image being written
+        ASYNC_WRITER_DROP_OLD,    // drop oldest pending images to make space
+    };
+
+    /**
+     * Save images in a background thread, encode and write will not block caller(e.g. camera loop).
+     * Images are queued with a memory budget, when budget exceeded, block or drop images by policy.
+     * Written files are fsync-ed in batch to reduce storage stall.
+     * @maixpy maix.image.AsyncWriter
+     */
+    class AsyncWriter
+    {
+    public:
+        /**
+         * AsyncWriter constructor, will start a background worker thread.
+         * @param max_bytes memory budget of pending images in bytes, default 32MB.
+         *                  One image larger than budget is still accepted when queue is empty.
+         * @param max_pending max pending image number, default 16.
+         * @param policy what to do when budget exceeded, @see image.AsyncWriterPolicy, default block caller.
+         * @param sync_batch fsync written files every sync_batch files or when queue becomes empty,
+         *                   0 means never fsync(left to system), default 8.
+         * @maixpy maix.image.AsyncWriter.__init__
+         * @maixcdk maix.image.AsyncWriter.AsyncWriter
+         */
+        AsyncWriter(size_t max_bytes = 32 * 1024 * 1024, int max_pending = 16,
+                    image::AsyncWriterPolicy policy = image::AsyncWriterPolicy::ASYNC_WRITER_BLOCK, int sync_batch = 8);
+
+        /**
+         * Will wait all pending images written then exit worker thread.
+         */
+        ~AsyncWriter();
+
+        /**
+         * Queue an image to save, pixel buffer is shared with img by Image.share(no copy), so caller can reuse it immediately,
+         * Image's methods modify img copy data first, but data written through img.data() pointer directly will be saved.
+         * Image not own its data, has views or is a view is copied.
+         * @param img image to save, JPEG image will be written directly without decode.
+         * @param path file path, format is decided by extension, same as Image.save, dir will be created if not exists.
+         * @param quality same as Image.save, for jpeg is [0, 100], for png is [-1, 9], default 95.
+         * @return err::ERR_NONE if queued, err::ERR_BUFF_FULL if dropped by policy, err::ERR_NOT_READY if writer closed.
+         * @maixpy maix.image.AsyncWriter.write
+         */
+        err::Err write(image::Image &img, const std::string &path, int quality = 95);
+
+        /**
+         * Queue an image to save and take its ownership, no data copy.
+         * @param img image to save, will be deleted by AsyncWriter after written or dropped, caller must not use it any more.
+         * @param path file path
+         * @param quality same as Image.save
+         * @return err::ERR_NONE if queued, err::ERR_BUFF_FULL if dropped by policy, err::ERR_NOT_READY if writer closed.
+         * @maixcdk maix.image.AsyncWriter.write_take
+         */
+        err::Err write_take(image::Image *img, const std::string &path, int quality = 95);
+
+        /**
+         * Set callback called in worker thread after each image written or dropped.
+         * @param callback callback function, args are file path and result, err::ERR_NONE means written and synced(if sync_batch > 0),
+         *                 err::ERR_BUFF_FULL means dropped by policy, others are write error.
+         *                 Don't do heavy work in callback, it will block the writer.
+         * @maixpy maix.image.AsyncWriter.set_callback
+         */
+        void set_callback(std::function<void(const std::string &, err::Err)> callback);
+
+        /**
+         * Wait until all queued images written and synced.
+         * @param timeout_ms timeout in ms, -1 means wait forever, default -1.
+         * @return err::ERR_NONE if all done, err::ERR_TIMEOUT if timeout.
+         * @maixpy maix.image.AsyncWriter.wait
+         */
+        err::Err wait(int timeout_ms = -1);
+
+        /**
+         * Get number of images not written yet, include the one being written.
+         * @maixpy maix.image.AsyncWriter.pending
+         */
+        int pending();
+
+        /**
+         * Get memory in bytes used by pending images.
+         * @maixpy maix.image.AsyncWriter.pending_bytes
+         */
+        size_t pending_bytes();
+
+        /**
+         * Get number of images dropped by policy since created.
+         * @maixpy maix.image.AsyncWriter.dropped
+         */
+        int dropped();
+
+        /**
+         * Get number of images failed to write since created.
+         * @maixpy maix.image.AsyncWriter.failed
+         */
+        int failed();
+
+        /**
+         * Stop accept new images, wait pending images written and exit worker thread.
+         * @maixpy maix.image.AsyncWriter.close
+         */
+        void close();
+
+    private:
+        void *_handle;
+    };
+}
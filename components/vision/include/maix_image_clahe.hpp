@@ -0,0 +1,95 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add CLAHE, tiled parallel contrast limited adaptive histogram equalization.
+ */
+
+#pragma once
+
+#include "maix_image.hpp"
+
+namespace maix::image
+{
+    /**
+     * Contrast limited adaptive histogram equalization, for low light and thermal image preprocessing every frame.
+     * Tile histograms and lookup tables are computed in parallel, then pixels are mapped by bilinear interpolation of
+     * the four nearest tiles' lookup tables in parallel. Lookup tables are kept between frames,
+     * so they can be blended with previous frame's for temporal stability(less flicker),
+     * and only part of tiles can be updated every frame to save time.
+     * Compared to Image.histeq(adaptive=True), this works directly on YUV420 images and keeps state between frames.
+     * @maixpy maix.image.CLAHE
+     */
+    class CLAHE
+    {
+    public:
+        /**
+         * CLAHE constructor
+         * @param clip_limit contrast limit, histogram bins higher than clip_limit * average bin count of a tile are clipped
+         *                   and the excess is redistributed to all bins, same as OpenCV and Image.histeq.
+         *                   Use small value like 2 ~ 4 to avoid noise amplify, <= 0 means no limit(plain adaptive histogram equalization), default 2.
+         * @param tiles_x tile number in horizontal direction, range [1, 64], default 8.
+         * @param tiles_y tile number in vertical direction, range [1, 64], default 8.
+         * @param temporal weight of previous frame's lookup tables, range [0, 1), new_lut = prev_lut * temporal + lut * (1 - temporal),
+         *                 larger value more stable but adapt slower to scene change, 0 means not blend, default 0.
+         * @param update_interval every frame only recompute 1 / update_interval of tiles in turn, others reuse previous lookup tables,
+         *                        1 means recompute all tiles every frame, default 1. The first frame and frame size changed always compute all tiles.
+         * @throw err.Exception if args invalid.
+         * @maixpy maix.image.CLAHE.__init__
+         * @maixcdk maix.image.CLAHE.CLAHE
+         */
+        CLAHE(float clip_limit = 2, int tiles_x = 8, int tiles_y = 8, float temporal = 0, int update_interval = 1);
+
+        ~CLAHE();
+
+        /**
+         * Equalize image in place
+         * @param img image to equalize, support GRAYSCALE, YVU420SP(NV21), YUV420SP(NV12) which only Y plane is equalized,
+         *            and RGB888, BGR888, RGBA8888, BGRA8888 which luma(BT.601) is equalized and chroma is kept. View is supported.
+         * @return err::ERR_NONE if success, err::ERR_ARGS if format not support.
+         * @maixpy maix.image.CLAHE.apply
+         */
+        err::Err apply(image::Image &img);
+
+        /**
+         * Drop lookup tables of previous frames, the next frame will compute all tiles without temporal blending.
+         * Call it when scene changed(e.g. camera switched).
+         * @maixpy maix.image.CLAHE.reset
+         */
+        void reset();
+
+        /**
+         * Set contrast limit
+         * @param clip_limit <= 0 means no limit
+         * @maixpy maix.image.CLAHE.set_clip_limit
+         */
+        void set_clip_limit(float clip_limit) { _clip_limit = clip_limit; }
+
+        /**
+         * Get contrast limit
+         * @maixpy maix.image.CLAHE.clip_limit
+         */
+        float clip_limit() { return _clip_limit; }
+
+        /**
+         * Set temporal blending weight of previous frame's lookup tables
+         * @param temporal range [0, 1), 0 means not blend.
+         * @maixpy maix.image.CLAHE.set_temporal
+         */
+        void set_temporal(float temporal);
+
+        /**
+         * Get temporal blending weight
+         * @maixpy maix.image.CLAHE.temporal
+         */
+        float temporal() { return _temporal; }
+
+    private:
+        void *_handle;
+        float _clip_limit;
+        int _tiles_x;
+        int _tiles_y;
+        float _temporal;
+        int _update_interval;
+    };
+}
@@ -14,6 +14,8 @@ namespace maix::image
      *                       If copy is false, ensure_bgr always be false.
      * @param[in] copy Whether alloc new image and copy data or not, if ensure_bgr and img is not bgr or bgra format, always copy,
      *        if not copy, array object will directly use img's data buffer, will faster but change array will affect img's data, default true.
+     *        Mat created without copy keeps img's pixel buffer alive, so it can be used after img is destroyed,
+     *        except img not own its data(e.g. created with copy=false), then the data must be valid while mat is in use.
      * @maixcdk maix.image.image2cv
      */
     err::Err image2cv(image::Image &img, cv::Mat &mat, bool ensure_bgr = false, bool copy = true);
@@ -24,7 +26,9 @@ namespace maix::image
      * @param mat cv::Mat image object.
      * @param bgr if set bgr, the return image will be marked as BGR888 or BGRA8888 format, grayscale will ignore this arg.
      * @param copy if true, will alloc new buffer and copy data, else will directly use array's data buffer, default true.
-     *        Use this arg carefully, when set to false, ther array MUST keep alive until we don't use the return img of this func, or will cause program crash.
+     *        When set to false, the return img keeps a reference of mat so mat's data is alive until img and images share its buffer are destroyed,
+     *        mat with row stride(e.g. a roi of other mat) is also supported without copy.
+     *        If mat's data is not allocated by opencv(e.g. create mat from user pointer), the data MUST keep alive while the return img is in use.
      * @return Image object
      * @maixcdk maix.image.cv2image
      */
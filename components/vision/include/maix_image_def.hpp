@@ -52,6 +52,7 @@ namespace maix::image
         FMT_GBRG12,     // 12-bit Bayer format with a GBRG pattern.
         FMT_GRBG12,     // 12-bit Bayer format with a GRBG pattern.
         FMT_RGGB12,     // 12-bit Bayer format with a RGGB pattern.
+        FMT_BITMAP,     // 1-bit per pixel, row is uint32 words, pixel x at bit (x % 32) of word (x / 32), row padded to 32 pixels.
         FMT_UNCOMPRESSED_MAX,
 
         // compressed format below, not compressed should define upper
@@ -100,6 +101,7 @@ namespace maix::image
         1.5,    // 12-bit Bayer format
         1.5,    // 12-bit Bayer format
         1.5,    // 12-bit Bayer format
+        0.125,  // bitmap, rows are padded to 32 bits, use Image.data_size() for actual size
         0, // uncompereed_max
         0, // compressed_min
         1, // jpeg
@@ -144,6 +146,7 @@ namespace maix::image
         "GBRG12",
         "GRBG12",
         "RGGB12",
+        "BITMAP",
         "UNCOMPRESSED_MAX",
         "COMPRESSED_MIN",
         "JPEG",
@@ -159,6 +162,68 @@ namespace maix::image
      */
      std::string format_name(maix::image::Format fmt);
 
+    /**
+     * Pixel of FMT_RGB888 image
+     * @maixcdk maix.image.PixelRGB888
+     */
+    struct PixelRGB888
+    {
+        uint8_t r, g, b;
+    };
+
+    /**
+     * Pixel of FMT_BGR888 image
+     * @maixcdk maix.image.PixelBGR888
+     */
+    struct PixelBGR888
+    {
+        uint8_t b, g, r;
+    };
+
+    /**
+     * Pixel of FMT_RGBA8888 image
+     * @maixcdk maix.image.PixelRGBA8888
+     */
+    struct PixelRGBA8888
+    {
+        uint8_t r, g, b, a;
+    };
+
+    /**
+     * Pixel of FMT_BGRA8888 image
+     * @maixcdk maix.image.PixelBGRA8888
+     */
+    struct PixelBGRA8888
+    {
+        uint8_t b, g, r, a;
+    };
+
+    static_assert(sizeof(PixelRGB888) == 3 && sizeof(PixelBGR888) == 3, "pixel struct must be packed");
+    static_assert(sizeof(PixelRGBA8888) == 4 && sizeof(PixelBGRA8888) == 4, "pixel struct must be packed");
+
+    /**
+     * Compile time info of image format, pixel_t is pixel type, bpp is bytes per pixel.
+     * Only defined for formats one pixel is whole bytes: RGB888, BGR888, RGBA8888, BGRA8888, RGB565, BGR565, GRAYSCALE.
+     * @maixcdk maix.image.FormatTraits
+     */
+    template <image::Format F>
+    struct FormatTraits;
+
+    template <>
+    struct FormatTraits<FMT_RGB888> { typedef PixelRGB888 pixel_t; static constexpr int bpp = 3; };
+    template <>
+    struct FormatTraits<FMT_BGR888> { typedef PixelBGR888 pixel_t; static constexpr int bpp = 3; };
+    template <>
+    struct FormatTraits<FMT_RGBA8888> { typedef PixelRGBA8888 pixel_t; static constexpr int bpp = 4; };
+    template <>
+    struct FormatTraits<FMT_BGRA8888> { typedef PixelBGRA8888 pixel_t; static constexpr int bpp = 4; };
+    template <>
+    struct FormatTraits<FMT_RGB565> { typedef uint16_t pixel_t; static constexpr int bpp = 2; };
+    template <>
+    struct FormatTraits<FMT_BGR565> { typedef uint16_t pixel_t; static constexpr int bpp = 2; };
+    template <>
+    struct FormatTraits<FMT_GRAYSCALE> { typedef uint8_t pixel_t; static constexpr int bpp = 1; };
+
     /**
      * Image size type
      * @maixpy maix.image.Size
@@ -308,6 +373,16 @@ namespace maix::image
         EDGE_SIMPLE,
     };
 
+    /**
+     * Displacement estimate method of DisplacementTracker
+     * @maixpy maix.image.DisplacementMethod
+     */
+    enum DisplacementMethod
+    {
+        DISPLACEMENT_PHASE, // Phase correlation of the whole roi, robust to noise and blur
+        DISPLACEMENT_LK,    // Pyramidal sparse Lucas-Kanade of corners, robust to moving objects and large rotation
+    };
+
     /**
      * FlipDir
      * @maixpy maix.image.FlipDir
@@ -0,0 +1,113 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add DisplacementTracker, displacement of every frame against a cached reference.
+ */
+
+#pragma once
+
+#include "maix_image.hpp"
+#include <vector>
+
+namespace maix::image
+{
+    /**
+     * Displacement tracker, estimate translation, rotation and scale of every frame against a reference frame,
+     * for video stabilization and visual odometry.
+     * Unlike Image.find_displacement which computes FFT of both images every call, the reference's spectrum(or pyramid and
+     * feature templates for LK method) is computed once in set_reference and reused by every update.
+     * Frames are converted to grayscale and resampled to a small working size first, results are in input image pixels.
+     * @maixpy maix.image.DisplacementTracker
+     */
+    class DisplacementTracker
+    {
+    public:
+        /**
+         * DisplacementTracker constructor
+         * @param method image.DisplacementMethod.DISPLACEMENT_PHASE: phase correlation with float FFT, the whole roi contributes,
+         *               robust to noise, blur and low texture, translation range is less than half of roi.
+         *               image.DisplacementMethod.DISPLACEMENT_LK: pyramidal sparse Lucas-Kanade of corners on reference,
+         *               then fit motion robustly, better when part of the scene moves, needs textured scene.
+         *               default DISPLACEMENT_PHASE.
+         * @param width working width, roi is resampled to width x height, must be power of 2 for DISPLACEMENT_PHASE, range [16, 1024], default 128.
+         *              Keep width / height the same as roi's aspect ratio if estimate rotation.
+         * @param height working height, same limit as width, default 128.
+         * @param rotation_scale estimate rotation and scale too, or only translation, default false.
+         *                       For DISPLACEMENT_PHASE, rotation and scale are estimated by log-polar transform of magnitude spectrum,
+         *                       rotation range is (-90, 90) degree and it costs about 2x time.
+         * @param update_rate only for DISPLACEMENT_PHASE, blend aligned spectrum of every frame into reference spectrum by this rate,
+         *                    new_ref = ref * (1 - update_rate) + aligned_frame * update_rate, so the reference follows slowly changing scene
+         *                    (light, moving objects) while results are still relative to the reference frame. Range [0, 1), 0 means not update, default 0.
+         * @param points only for DISPLACEMENT_LK, max number of corners to track, default 64.
+         * @param levels only for DISPLACEMENT_LK, pyramid levels, more levels support larger motion, default 3.
+         * @throw err.Exception if args invalid.
+         * @maixpy maix.image.DisplacementTracker.__init__
+         * @maixcdk maix.image.DisplacementTracker.DisplacementTracker
+         */
+        DisplacementTracker(image::DisplacementMethod method = image::DisplacementMethod::DISPLACEMENT_PHASE, int width = 128, int height = 128,
+                            bool rotation_scale = false, float update_rate = 0, int points = 64, int levels = 3);
+
+        ~DisplacementTracker();
+
+        /**
+         * Set reference frame, cache its spectrum or pyramid and feature templates.
+         * @param img reference image, support GRAYSCALE, RGB888, BGR888, RGBA8888, BGRA8888, YVU420SP, YUV420SP.
+         * @param roi region of interest [x, y, w, h], default None means whole image. Frames of update must use the same roi size.
+         * @return err::ERR_NONE if success, err::ERR_ARGS if format or roi invalid, err::ERR_NOT_FOUND if no corner found for DISPLACEMENT_LK.
+         * @maixpy maix.image.DisplacementTracker.set_reference
+         */
+        err::Err set_reference(image::Image &img, std::vector<int> roi = std::vector<int>());
+
+        /**
+         * Estimate displacement of frame against reference, if no reference, the frame is set as reference and returns zero displacement.
+         * @param img frame image, same formats as set_reference.
+         * @param roi region of interest [x, y, w, h], default None means whole image, size must be the same as reference's roi.
+         * @return displacement of frame content relative to reference:
+         *         x_translation and y_translation: translation of roi center in pixels, x right and y down positive.
+         *                                          y_translation has opposite sign of Image.find_displacement's.
+         *         rotation: rotation around roi center in radian, clockwise positive(in image coordinates), 0 if rotation_scale is false.
+         *         scale: scale ratio around roi center, 1 if rotation_scale is false.
+         *         response: confidence in range [0, 1], normalized correlation peak for DISPLACEMENT_PHASE,
+         *                   ratio of corners agree with the motion for DISPLACEMENT_LK, discard result if too low(e.g. < 0.1 for phase, < 0.3 for LK).
+         * @throw err.Exception if format or roi invalid.
+         * @maixpy maix.image.DisplacementTracker.update
+         */
+        image::Displacement update(image::Image &img, std::vector<int> roi = std::vector<int>());
+
+        /**
+         * Drop reference, the next update will set reference.
+         * @maixpy maix.image.DisplacementTracker.reset
+         */
+        void reset();
+
+        /**
+         * Whether reference is set
+         * @maixpy maix.image.DisplacementTracker.has_reference
+         */
+        bool has_reference();
+
+        /**
+         * Get working size
+         * @return [width, height]
+         * @maixpy maix.image.DisplacementTracker.size
+         */
+        std::vector<int> size() { return {_width, _height}; }
+
+        /**
+         * Get method
+         * @maixpy maix.image.DisplacementTracker.method
+         */
+        image::DisplacementMethod method() { return _method; }
+
+    private:
+        void *_handle;
+        image::DisplacementMethod _method;
+        int _width;
+        int _height;
+        bool _rotation_scale;
+        float _update_rate;
+        int _points;
+        int _levels;
+    };
+}
@@ -0,0 +1,196 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add JpegEncoder, reusable jpeg encoder context.
+ * @update 2026.10.19: Add JpegDecoder, decode to target format with DCT domain downscale.
+ */
+
+#pragma once
+
+#include "maix_image.hpp"
+
+namespace maix::image
+{
+    /**
+     * JPEG encoder, keep encoder context and output buffer between frames,
+     * so encode continuous frames(e.g. MJPEG stream) will not alloc and init encoder every time.
+     * On Linux, encode with libjpeg(turbo), YUV420 input(NV21, NV12, I420, YV12) is encoded directly without convert to RGB,
+     * and image can be split to horizontal slices and encoded in parallel, slices are joined by JPEG restart markers.
+     * On MaixCAM and MaixCAM2, use hardware encoder by Image.to_jpeg, slices arg will be ignored.
+     * @maixpy maix.image.JpegEncoder
+     */
+    class JpegEncoder
+    {
+    public:
+        /**
+         * JpegEncoder constructor
+         * @param quality jpeg quality, range [0, 100], default 95, MaixCAM limit to [51, 99].
+         * @param slices encode image in slices parallel, 1 means not split, 0 means auto(number of cpu cores), default 1.
+         *               Only valid on Linux, slice number may be reduced to fit image height.
+         * @maixpy maix.image.JpegEncoder.__init__
+         * @maixcdk maix.image.JpegEncoder.JpegEncoder
+         */
+        JpegEncoder(int quality = 95, int slices = 1);
+        ~JpegEncoder();
+
+        /**
+         * Encode image to jpeg
+         * @param img image to encode, RGB888, BGR888, RGBA8888, BGRA8888, GRAYSCALE, YVU420SP, YUV420SP, YVU420P, YUV420P are encoded directly,
+         *            other formats are converted to BGR888 first.
+         * @param buff output buffer, if not nullptr, will encode directly into this buffer and return image use this buffer,
+         *             if buffer size not enough, will raise err.Exception. If nullptr, return image will alloc new buffer.
+         * @param buff_size output buffer size
+         * @return jpeg image object, need to delete by caller in C++.
+         * @maixcdk maix.image.JpegEncoder.encode
+         */
+        image::Image *encode(image::Image &img, void *buff, size_t buff_size);
+
+        /**
+         * Encode image to jpeg
+         * @param img image to encode, RGB888, BGR888, RGBA8888, BGRA8888, GRAYSCALE, YVU420SP, YUV420SP, YVU420P, YUV420P are encoded directly,
+         *            other formats are converted to BGR888 first.
+         * @return jpeg image object
+         * @maixpy maix.image.JpegEncoder.encode
+         */
+        image::Image *encode(image::Image &img)
+        {
+            return encode(img, nullptr, 0);
+        }
+
+        /**
+         * Encode image to jpeg into internal buffer, no Image object created, no memory alloc if internal buffer is big enough.
+         * @param img image to encode
+         * @param[out] data jpeg data pointer, valid until next encode call or encoder destroyed.
+         * @param[out] size jpeg data size
+         * @return err::ERR_NONE if success, else error code.
+         * @maixcdk maix.image.JpegEncoder.encode_raw
+         */
+        err::Err encode_raw(image::Image &img, uint8_t **data, size_t *size);
+
+        /**
+         * Set jpeg quality
+         * @param quality range [0, 100]
+         * @maixpy maix.image.JpegEncoder.set_quality
+         */
+        void set_quality(int quality) { _quality = quality < 0 ? 0 : (quality > 100 ? 100 : quality); }
+
+        /**
+         * Get jpeg quality
+         * @maixpy maix.image.JpegEncoder.quality
+         */
+        int quality() { return _quality; }
+
+        /**
+         * Set slice number
+         * @param slices 1 means not split, 0 means auto(number of cpu cores).
+         * @maixpy maix.image.JpegEncoder.set_slices
+         */
+        void set_slices(int slices) { _slices = slices < 0 ? 1 : slices; }
+
+        /**
+         * Get slice number setting
+         * @maixpy maix.image.JpegEncoder.slices
+         */
+        int slices() { return _slices; }
+
+    private:
+        void *_handle;
+        int _quality;
+        int _slices;
+    };
+
+    /**
+     * JPEG decoder, keep decoder context between images, decode directly into target format and buffer, no extra copy or convert.
+     * Support DCT domain downscale(1/2, 1/4, 1/8) while decoding, which is much faster than decode full size then resize,
+     * useful for thumbnails and small input of AI models.
+     * On Linux, decode with libjpeg(turbo), on MaixCAM and MaixCAM2, decode with OpenCV's reduced decode mode.
+     * @maixpy maix.image.JpegDecoder
+     */
+    class JpegDecoder
+    {
+    public:
+        /**
+         * JpegDecoder constructor
+         * @param format output image format, support RGB888, BGR888, RGBA8888, BGRA8888, GRAYSCALE, default RGB888.
+         * @param scale downscale denominator, 1, 2, 4 or 8, output size is ceil(width / scale) x ceil(height / scale), default 1.
+         * @throw err.Exception if args invalid.
+         * @maixpy maix.image.JpegDecoder.__init__
+         * @maixcdk maix.image.JpegDecoder.JpegDecoder
+         */
+        JpegDecoder(image::Format format = image::FMT_RGB888, int scale = 1);
+
+        ~JpegDecoder();
+
+        /**
+         * Decode jpeg data
+         * @param data jpeg data
+         * @param size jpeg data size
+         * @param buff output buffer, if not nullptr, will decode directly into this buffer and return image use this buffer,
+         *             if buffer size not enough, will raise err.Exception. If nullptr, return image will alloc new buffer.
+         * @param buff_size output buffer size
+         * @return decoded image, nullptr if data is not a valid jpeg, need to delete by caller in C++.
+         * @maixcdk maix.image.JpegDecoder.decode
+         */
+        image::Image *decode(const uint8_t *data, size_t size, void *buff = nullptr, size_t buff_size = 0);
+
+        /**
+         * Decode jpeg image
+         * @param jpg jpeg image, format should be FMT_JPEG
+         * @return decoded image, None(nullptr in C++) if decode failed.
+         * @maixpy maix.image.JpegDecoder.decode
+         */
+        image::Image *decode(image::Image &jpg)
+        {
+            return decode((const uint8_t *)jpg.data(), jpg.data_size());
+        }
+
+        /**
+         * Set output format
+         * @param format support RGB888, BGR888, RGBA8888, BGRA8888, GRAYSCALE.
+         * @maixpy maix.image.JpegDecoder.set_format
+         */
+        void set_format(image::Format format)
+        {
+            if (format != image::FMT_RGB888 && format != image::FMT_BGR888 && format != image::FMT_RGBA8888 &&
+                format != image::FMT_BGRA8888 && format != image::FMT_GRAYSCALE)
+            {
+                log::error("jpeg decode not support format: %s\n", image::fmt_names[format].c_str());
+                throw err::Exception(err::ERR_ARGS, "jpeg decode not support format");
+            }
+            _format = format;
+        }
+
+        /**
+         * Get output format
+         * @maixpy maix.image.JpegDecoder.format
+         */
+        image::Format format() { return _format; }
+
+        /**
+         * Set downscale denominator
+         * @param scale 1, 2, 4 or 8
+         * @maixpy maix.image.JpegDecoder.set_scale
+         */
+        void set_scale(int scale)
+        {
+            if (scale != 1 && scale != 2 && scale != 4 && scale != 8)
+            {
+                log::error("jpeg decode scale should be 1, 2, 4 or 8, but got %d\n", scale);
+                throw err::Exception(err::ERR_ARGS, "jpeg decode scale error");
+            }
+            _scale = scale;
+        }
+
+        /**
+         * Get downscale denominator
+         * @maixpy maix.image.JpegDecoder.scale
+         */
+        int scale() { return _scale; }
+
+    private:
+        void *_handle;
+        image::Format _format;
+        int _scale;
+    };
+}
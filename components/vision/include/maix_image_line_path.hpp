@@ -0,0 +1,190 @@
+/**
+ * @author lxowalle@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add LinePathSearcher, a row sampled line path engine for line following.
+ */
+
+#pragma once
+
+#include "maix_image.hpp"
+#include <vector>
+#include <stdint.h>
+
+namespace maix::image
+{
+    /**
+     * One sampled point of a line path, the center of a run on a scanline.
+     * @maixcdk maix.image.LinePathPoint
+     */
+    struct LinePathPoint
+    {
+        int16_t x;      // run center x
+        int16_t y;      // scanline y
+        int16_t width;  // run width
+    };
+
+    /**
+     * Wide run area, usually a horizontal line crossing the path.
+     * @maixcdk maix.image.LinePathBar
+     */
+    struct LinePathBar
+    {
+        int16_t x1;     // left x
+        int16_t x2;     // right x(exclusive)
+        int16_t y1;     // top y
+        int16_t y2;     // bottom y
+    };
+
+    /**
+     * One path, points are ordered from image bottom to top.
+     * @maixcdk maix.image.LinePath
+     */
+    struct LinePath
+    {
+        int id;             // path id, keep the same for the same path in continuous frames
+        int parent_id;      // id of the path this one forked from, -1 if not forked
+        int bar;            // index of the bar this path meets, -1 if not meet any bar
+        int num_points;     // number of valid points
+        const LinePathPoint *points;
+    };
+
+    /**
+     * Result of LinePathSearcher.
+     * All buffers are allocated once by LinePathSearcher when image size or config changes,
+     * search a new frame will not alloc memory.
+     * @maixcdk maix.image.LinePathResult
+     */
+    class LinePathResult
+    {
+    public:
+        std::vector<image::LinePath> paths;
+        std::vector<image::LinePathBar> bars;
+        std::vector<image::LinePathPoint> points;   // points of all paths, max_paths * max_rows
+        int threshold = 0;                          // binary threshold used by this frame
+    };
+
+    /**
+     * Line path search engine for line following robots.
+     * Image is binarized on a row sampled and column downscaled grid, each scanline is run length encoded,
+     * then runs are linked to paths from image bottom to top, with the help of previous frame's result.
+     * @maixpy maix.image.LinePathSearcher
+     */
+    class LinePathSearcher
+    {
+    public:
+        /**
+         * LinePathSearcher constructor
+         * @param threshold binary threshold of gray value, -1 means auto calculate by otsu method every frame.
+         * @param invert by default(false) dark pixels(<= threshold) are line, set true to find bright line.
+         * @param row_step sample one scanline every row_step rows, default 4.
+         * @param col_step sample one pixel every col_step pixels in scanline, default 2.
+         * @param min_width run narrower than this value(in pixel) will be ignored, default 4.
+         * @param max_width run wider than this value(in pixel) will be treated as bar(horizontal line), -1 means 1/4 of image width.
+         * @param max_paths max path number tracked at the same time, slot of lost path is reused by new path, default 8.
+         * @param link_tolerance max x distance(in pixel) when link a run to a path, default 12.
+         * @param max_gap max continuous missing scanlines of one path, default 2.
+         * @maixpy maix.image.LinePathSearcher.__init__
+         * @maixcdk maix.image.LinePathSearcher.LinePathSearcher
+         */
+        LinePathSearcher(int threshold = -1, bool invert = false, int row_step = 4, int col_step = 2, int min_width = 4, int max_width = -1,
+                         int max_paths = 8, int link_tolerance = 12, int max_gap = 2);
+
+        ~LinePathSearcher();
+
+        /**
+         * Search line paths in image, only support GRAYSCALE, YVU420SP, YUV420SP, RGB888, BGR888, RGBA8888, BGRA8888.
+         * @param img image to search
+         * @return result, valid until next update or destroy, not alloc memory if image size not change.
+         * @maixcdk maix.image.LinePathSearcher.update
+         */
+        const image::LinePathResult &update(image::Image &img);
+
+        /**
+         * Search line paths and convert to LineGroup list, compatible with Image.search_line_path.
+         * @param img image to search
+         * @param min_len_of_new_path The minimum length of a new path, if the crossing length exceeds this value, it is considered a new path.
+         * @return line group list, @see image.LineGroup
+         * @maixpy maix.image.LinePathSearcher.search
+         */
+        std::vector<image::LineGroup> search(image::Image &img, int min_len_of_new_path = 10);
+
+        /**
+         * Get last result
+         * @maixcdk maix.image.LinePathSearcher.result
+         */
+        const image::LinePathResult &result() { return _result; }
+
+        /**
+         * Get binary threshold used by last frame
+         * @maixpy maix.image.LinePathSearcher.threshold
+         */
+        int threshold() { return _result.threshold; }
+
+        /**
+         * Clear history result, the next frame will not link to previous frame.
+         * @maixpy maix.image.LinePathSearcher.reset
+         */
+        void reset();
+
+    private:
+        struct Run
+        {
+            int16_t x1;
+            int16_t x2;
+        };
+
+        struct Track
+        {
+            int slot;
+            int id;
+            int parent_id;
+            int bar;
+            int num_points;
+            int last_row;       // last row added point
+            int seen_row;       // last row added point or crossed bar
+            int claimed_row;
+            float last_x;
+            float dx;
+            int prev_slot;
+            bool active;
+        };
+
+        int _threshold;
+        bool _invert;
+        int _row_step;
+        int _col_step;
+        int _min_width;
+        int _max_width;
+        int _max_paths;
+        int _link_tolerance;
+        int _max_gap;
+
+        int _width;
+        int _height;
+        int _rows;
+        int _max_runs;
+        int _next_id;
+        std::vector<Run> _runs;             // _rows * _max_runs
+        std::vector<int> _runs_num;         // _rows
+        std::vector<uint32_t> _hist;        // 256
+        std::vector<Track> _tracks;         // _max_paths, index is slot
+        std::vector<int> _free_slots;       // slots of _tracks not active
+        std::vector<image::LinePathPoint> _slot_points; // _max_paths * _rows, points of track in slot, copied to result when track finished
+        std::vector<int16_t> _prev_x;       // _max_paths * _rows, previous frame path x by row, -1 if none
+        std::vector<int> _prev_ids;         // _max_paths
+        std::vector<int> _prev_claimed;     // _max_paths
+        std::vector<int> _prev_order;       // paths index sorted by length, longest _max_paths paths are saved to history
+        std::vector<int> _run_track;        // _max_runs
+        std::vector<uint32_t> _pairs;       // _max_runs * _max_paths, (dist << 16) | (run << 8) | track
+        int _prev_num;
+        image::LinePathResult _result;
+
+        void _alloc(int width, int height);
+        int _auto_threshold(image::Image &img);
+        void _scan(image::Image &img, int threshold);
+        void _link();
+        void _finish(Track &track, int &points_num);
+        void _save_history();
+    };
+}
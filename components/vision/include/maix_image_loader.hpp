@@ -0,0 +1,111 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add Loader, decode images on worker threads with prefetch.
+ */
+
+#pragma once
+
+#include "maix_image.hpp"
+#include <vector>
+#include <string>
+
+namespace maix::image
+{
+    /**
+     * Image loader, decode image files on worker threads and prefetch ahead of the consumer, for batch jobs and photo albums.
+     * JPEG is decoded by image.JpegDecoder directly into the target format and buffer, and downscaled in DCT domain if scale > 1,
+     * other formats(png, bmp etc.) are decoded by OpenCV.
+     * To save images in background, use image.AsyncWriter.
+     * @maixpy maix.image.Loader
+     */
+    class Loader
+    {
+    public:
+        /**
+         * Loader constructor
+         * @param format output image format, support RGB888, BGR888, RGBA8888, BGRA8888, GRAYSCALE, default RGB888.
+         * @param scale downscale denominator, 1, 2, 4 or 8, output size is ceil(width / scale) x ceil(height / scale), default 1.
+         *              JPEG is downscaled in DCT domain while decoding(much faster than decode then resize, good for thumbnails),
+         *              other formats are resized by area interpolation after decode.
+         * @param threads worker thread number, 0 means number of cpu cores, default 0.
+         * @param prefetch max number of images decoded ahead of next(), memory usage is about prefetch * image size, default 4.
+         * @throw err.Exception if args invalid.
+         * @maixpy maix.image.Loader.__init__
+         * @maixcdk maix.image.Loader.Loader
+         */
+        Loader(image::Format format = image::FMT_RGB888, int scale = 1, int threads = 0, int prefetch = 4);
+
+        ~Loader();
+
+        /**
+         * Open a directory or a file, image files(jpg, jpeg, png, bmp, webp, tif, tiff, pgm, ppm) in directory are sorted by path,
+         * and prefetch starts immediately. Previous files not consumed are dropped.
+         * @param path directory or image file path
+         * @param recursive list sub directories, default false.
+         * @return err::ERR_NONE if success, err::ERR_ARGS if path not exists.
+         * @maixpy maix.image.Loader.open
+         */
+        err::Err open(const std::string &path, bool recursive = false);
+
+        /**
+         * Set image file list to load in order, prefetch starts immediately. Previous files not consumed are dropped.
+         * @param paths image file paths
+         * @maixpy maix.image.Loader.set_files
+         */
+        void set_files(const std::vector<std::string> &paths);
+
+        /**
+         * Get next image in order, block until it's decoded.
+         * Files failed to decode are skipped with an error log.
+         * @return next image, None(nullptr in C++) if no more images, need to delete by caller in C++.
+         * @maixpy maix.image.Loader.next
+         */
+        image::Image *next();
+
+        /**
+         * Get file path of the image last returned by next.
+         * @maixpy maix.image.Loader.path
+         */
+        std::string path();
+
+        /**
+         * Get number of files not returned by next yet, include prefetched ones.
+         * @maixpy maix.image.Loader.remain
+         */
+        int remain();
+
+        /**
+         * Get all file paths set by open or set_files.
+         * @maixpy maix.image.Loader.files
+         */
+        std::vector<std::string> files();
+
+        /**
+         * Load one image on caller's thread with the same format and scale, not affect the file list.
+         * @param path image file path
+         * @return image, None(nullptr in C++) if load failed, need to delete by caller in C++.
+         * @maixpy maix.image.Loader.load
+         */
+        image::Image *load(const std::string &path);
+
+        /**
+         * Get output format
+         * @maixpy maix.image.Loader.format
+         */
+        image::Format format() { return _format; }
+
+        /**
+         * Get downscale denominator
+         * @maixpy maix.image.Loader.scale
+         */
+        int scale() { return _scale; }
+
+    private:
+        void *_handle;
+        image::Format _format;
+        int _scale;
+        int _prefetch;
+    };
+}
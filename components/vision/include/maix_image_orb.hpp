@@ -0,0 +1,219 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add ORB, ORBFeatures and ORBIndex, multi-thread ORB extraction and fast binary descriptor matching.
+ */
+
+#pragma once
+
+#include "maix_image.hpp"
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+namespace maix::image
+{
+    /**
+     * ORB features of an image, keypoints and 256 bits(32 bytes) descriptors, descriptors are stored contiguously.
+     * @maixpy maix.image.ORBFeatures
+     */
+    class ORBFeatures
+    {
+    public:
+        /**
+         * Descriptor size in bytes
+         * @maixcdk maix.image.ORBFeatures.DESC_SIZE
+         */
+        static const int DESC_SIZE = 32;
+
+        /**
+         * Get keypoint number
+         * @maixpy maix.image.ORBFeatures.size
+         */
+        int size() { return (int)_kps.size() / 5; }
+
+        /**
+         * Get keypoint
+         * @param idx keypoint index
+         * @return [x, y, angle, octave, score], x, y is position in image, angle is orientation in degree [0, 360),
+         *         octave is pyramid level the keypoint found, score is corner response.
+         * @maixpy maix.image.ORBFeatures.keypoint
+         */
+        std::vector<float> keypoint(int idx);
+
+        /**
+         * Get positions of all keypoints
+         * @return [x0, y0, x1, y1, ...]
+         * @maixpy maix.image.ORBFeatures.points
+         */
+        std::vector<float> points();
+
+        /**
+         * Get descriptor of keypoint
+         * @param idx keypoint index
+         * @return 32 bytes descriptor
+         * @maixpy maix.image.ORBFeatures.descriptor
+         */
+        std::vector<uint8_t> descriptor(int idx);
+
+        /**
+         * Get all descriptors, size() * DESC_SIZE bytes, contiguous
+         * @maixcdk maix.image.ORBFeatures.descriptors
+         */
+        const uint8_t *descriptors() { return _desc.data(); }
+
+        /**
+         * Add a keypoint
+         * @param keypoint [x, y, angle, octave, score]
+         * @param desc 32 bytes descriptor
+         * @maixcdk maix.image.ORBFeatures.add
+         */
+        void add(const float keypoint[5], const uint8_t *desc);
+
+        /**
+         * Remove all keypoints
+         * @maixpy maix.image.ORBFeatures.clear
+         */
+        void clear();
+
+    private:
+        std::vector<float> _kps;    // 5 floats per keypoint
+        std::vector<uint8_t> _desc; // DESC_SIZE bytes per keypoint
+    };
+
+    /**
+     * ORB(oriented FAST and rotated BRIEF) keypoint extractor and matcher.
+     * Keypoints are detected on an image pyramid, every level is divided to grid cells and cells are detected in multiple threads,
+     * each cell keeps its strongest corners, so keypoints spread over the whole image instead of gathering in textured area.
+     * Hamming distance is computed by hardware popcount(NEON on ARM) on 64 bits words.
+     * For matching against a database of many reference objects, use image.ORBIndex.
+     * @maixpy maix.image.ORB
+     */
+    class ORB
+    {
+    public:
+        /**
+         * ORB constructor
+         * @param max_keypoints max keypoint number of all levels, default 500.
+         * @param threshold FAST threshold, intensity difference between center and circle pixels, default 20.
+         * @param levels pyramid levels, default 4.
+         * @param scale_factor pyramid scale factor between levels, range (1, 2], default 1.2.
+         * @param grid grid cells number of each side, every level is divided to grid x grid cells, default 8.
+         * @param detector corner detector, CORNER_FAST or CORNER_AGAST, both find corners by the same 9 of 16 segment test,
+         *                 default CORNER_FAST.
+         * @throw err.Exception if args invalid.
+         * @maixpy maix.image.ORB.__init__
+         * @maixcdk maix.image.ORB.ORB
+         */
+        ORB(int max_keypoints = 500, int threshold = 20, int levels = 4, float scale_factor = 1.2f, int grid = 8,
+            image::CornerDetector detector = image::CornerDetector::CORNER_FAST);
+
+        /**
+         * Detect keypoints and compute descriptors
+         * @param img image, support GRAYSCALE, RGB888, BGR888, RGBA8888, BGRA8888, YVU420SP, YUV420SP.
+         * @param roi region of interest [x, y, w, h], default None means whole image.
+         * @return features, keypoint positions are in img coordinates.
+         * @throw err.Exception if format or roi invalid.
+         * @maixpy maix.image.ORB.detect
+         */
+        image::ORBFeatures detect(image::Image &img, std::vector<int> roi = std::vector<int>());
+
+        /**
+         * Match descriptors by brute force, multiple threads.
+         * @param query query features
+         * @param train features to match against
+         * @param max_distance max hamming distance of a match, range [0, 256], default 64.
+         * @param ratio ratio test of Lowe, accept best match only if best_distance < ratio * second_best_distance,
+         *              1 means disable, default 0.8.
+         * @param cross_check only keep matches whose train keypoint's best match is the query keypoint too, default false.
+         * @return matches, [query_idx0, train_idx0, distance0, query_idx1, train_idx1, distance1, ...]
+         * @maixpy maix.image.ORB.match
+         */
+        static std::vector<int> match(image::ORBFeatures &query, image::ORBFeatures &train, int max_distance = 64, float ratio = 0.8f, bool cross_check = false);
+
+        /**
+         * Hamming distance of two 32 bytes descriptors
+         * @maixcdk maix.image.ORB.distance
+         */
+        static int distance(const uint8_t *a, const uint8_t *b);
+
+    private:
+        int _max_keypoints;
+        int _threshold;
+        int _levels;
+        float _scale_factor;
+        int _grid;
+    };
+
+    /**
+     * Index of ORB descriptors of reference objects, match query features against all objects at once.
+     * Descriptors are indexed by multi-index hashing: 256 bits are split to 16 substrings of 16 bits, each substring has a sorted table,
+     * candidates are descriptors have a substring equal to(or 1 bit different from if multi_probe) query's, then verified by full hamming distance.
+     * Descriptors within distance 15(31 if multi_probe) of query are always found, farther ones usually too,
+     * so results are close to brute force while about 10x faster for thousands of descriptors.
+     * Small database(less than 1024 descriptors) is matched by brute force.
+     * @maixpy maix.image.ORBIndex
+     */
+    class ORBIndex
+    {
+    public:
+        /**
+         * ORBIndex constructor
+         * @param multi_probe also probe substrings 1 bit different from query's, guarantee recall up to distance 31, but about 8x slower, default false.
+         * @maixpy maix.image.ORBIndex.__init__
+         * @maixcdk maix.image.ORBIndex.ORBIndex
+         */
+        ORBIndex(bool multi_probe = false);
+
+        ~ORBIndex();
+
+        /**
+         * Add features of a reference object
+         * @param features object's features
+         * @return object id, start from 0.
+         * @maixpy maix.image.ORBIndex.add
+         */
+        int add(image::ORBFeatures &features);
+
+        /**
+         * Get features of object
+         * @param object_id id returned by add
+         * @maixpy maix.image.ORBIndex.get
+         */
+        image::ORBFeatures get(int object_id);
+
+        /**
+         * Match features against all objects
+         * @param features query features
+         * @param max_distance max hamming distance of a match, default 64.
+         * @param ratio ratio test of best and second best match of all objects, 1 means disable, default 0.8.
+         * @param min_matches only return objects have at least min_matches matches, default 8.
+         * @return matches of objects, key is object id, value is [query_idx0, object_keypoint_idx0, distance0, ...]
+         * @maixpy maix.image.ORBIndex.query
+         */
+        std::map<int, std::vector<int>> query(image::ORBFeatures &features, int max_distance = 64, float ratio = 0.8f, int min_matches = 8);
+
+        /**
+         * Remove all objects
+         * @maixpy maix.image.ORBIndex.clear
+         */
+        void clear();
+
+        /**
+         * Get object number
+         * @maixpy maix.image.ORBIndex.size
+         */
+        int size();
+
+        /**
+         * Get descriptor number of all objects
+         * @maixpy maix.image.ORBIndex.count
+         */
+        int count();
+
+    private:
+        void *_handle;
+        bool _multi_probe;
+    };
+}
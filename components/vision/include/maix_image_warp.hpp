@@ -0,0 +1,115 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add Warp, affine and perspective transform with precomputed fixed point maps.
+ */
+
+#pragma once
+
+#include "maix_image.hpp"
+#include <vector>
+#include <stdint.h>
+
+namespace maix::image
+{
+    /**
+     * Geometric transform(affine, perspective, rotate) with precomputed coordinate maps.
+     * Transform matrix is inverted and sampled to fixed point source coordinates once when construct,
+     * apply only gather pixels by the maps in multiple threads, no matrix math and no memory alloc if dst is provided.
+     * Use it instead of Image.affine, Image.perspective and Image.rotate when apply the same geometry to every frame,
+     * e.g. document scanning, face alignment, lens correction.
+     * @maixpy maix.image.Warp
+     */
+    class Warp
+    {
+    public:
+        /**
+         * Warp constructor
+         * @param matrix transform matrix map source image coordinates to destination image coordinates, row major,
+         *               6 values for affine(2x3), 9 values for perspective(3x3), same as OpenCV's warpAffine and warpPerspective.
+         *               You can get it by Warp.affine_matrix, Warp.perspective_matrix or Warp.rotate_matrix.
+         * @param src_width source image width
+         * @param src_height source image height
+         * @param width destination image width
+         * @param height destination image height
+         * @param method sample method, only support NEAREST and BILINEAR, default BILINEAR.
+         * @param bg color of destination pixels map to outside of source image, default black,
+         *           if bg is image.COLOR_INVALID, these pixels will not be modified, useful when apply to an existing image.
+         * @throw err.Exception if args invalid.
+         * @maixpy maix.image.Warp.__init__
+         * @maixcdk maix.image.Warp.Warp
+         */
+        Warp(std::vector<float> matrix, int src_width, int src_height, int width, int height,
+             image::ResizeMethod method = image::ResizeMethod::BILINEAR, const image::Color &bg = image::COLOR_BLACK);
+
+        /**
+         * Apply transform to image
+         * @param img source image, size must be the same as src_width and src_height of constructor,
+         *            support GRAYSCALE, RGB888, BGR888, RGBA8888, BGRA8888, YVU420SP(NV21), YUV420SP(NV12), view is supported.
+         * @param dst destination image, size must be the same as width and height of constructor, format must be the same as img.
+         *            If nullptr, will create a new image, default nullptr.
+         * @return destination image, dst if dst is not nullptr, else new image need to delete by caller in C++.
+         * @throw err.Exception if args invalid.
+         * @maixpy maix.image.Warp.apply
+         */
+        image::Image *apply(image::Image &img, image::Image *dst = nullptr);
+
+        /**
+         * Get transform matrix of three pairs of points, can be used to construct Warp.
+         * @param src_points three source points, [x1, y1, x2, y2, x3, y3]
+         * @param dst_points three destination points, [x1, y1, x2, y2, x3, y3]
+         * @return 2x3 affine matrix, 6 values, row major.
+         * @maixpy maix.image.Warp.affine_matrix
+         */
+        static std::vector<float> affine_matrix(std::vector<int> src_points, std::vector<int> dst_points);
+
+        /**
+         * Get transform matrix of four pairs of points, can be used to construct Warp.
+         * @param src_points four source points, [x1, y1, x2, y2, x3, y3, x4, y4]
+         * @param dst_points four destination points, [x1, y1, x2, y2, x3, y3, x4, y4]
+         * @return 3x3 perspective matrix, 9 values, row major.
+         * @maixpy maix.image.Warp.perspective_matrix
+         */
+        static std::vector<float> perspective_matrix(std::vector<int> src_points, std::vector<int> dst_points);
+
+        /**
+         * Get rotate matrix, rotate around image center and keep center in destination image center, the same as Image.rotate.
+         * @param angle anti-clock wise rotate angle in degree
+         * @param src_width source image width
+         * @param src_height source image height
+         * @param width destination image width
+         * @param height destination image height
+         * @return 2x3 affine matrix, 6 values, row major.
+         * @maixpy maix.image.Warp.rotate_matrix
+         */
+        static std::vector<float> rotate_matrix(float angle, int src_width, int src_height, int width, int height);
+
+        /**
+         * Get destination image size
+         * @maixpy maix.image.Warp.size
+         */
+        image::Size size() { return image::Size(_width, _height); }
+
+        /**
+         * Get source image size
+         * @maixpy maix.image.Warp.src_size
+         */
+        image::Size src_size() { return image::Size(_src_width, _src_height); }
+
+    private:
+        int _src_width;
+        int _src_height;
+        int _width;
+        int _height;
+        image::ResizeMethod _method;
+        image::Color _bg;
+        std::vector<int16_t> _map;          // _width * _height * 2, source x and y, integer part
+        std::vector<uint16_t> _frac;        // _width * _height, (fy << 5) | fx, only for BILINEAR
+        std::vector<int16_t> _uv_map;       // (_width / 2) * (_height / 2) * 2, map for 420 chroma plane
+        std::vector<uint16_t> _uv_frac;
+
+        void _build_map(const double *inv, bool perspective, int width, int height, int scale,
+                        std::vector<int16_t> &map, std::vector<uint16_t> &frac);
+    };
+}
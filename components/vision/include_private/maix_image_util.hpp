@@ -13,5 +13,29 @@ namespace maix::image
     */
     extern void convert_to_imlib_image(image::Image *image, image_t *imlib_image);
     extern void _convert_to_lab_thresholds(std::vector<std::vector<int>> &in, list_t *out);
+
+    /**
+     * Logic operations of BITMAP image
+    */
+    typedef enum
+    {
+        BITMAP_OP_AND = 0,
+        BITMAP_OP_NAND,
+        BITMAP_OP_OR,
+        BITMAP_OP_NOR,
+        BITMAP_OP_XOR,
+        BITMAP_OP_XNOR,
+    } bitmap_op_t;
+
+    /**
+     * BITMAP image fast path, process 32 pixels a time, implemented in maix_image_bitmap.cpp
+     * @param img BITMAP image, other and mask should be BITMAP image with the same size
+    */
+    extern void _bitmap_logic(image::Image *img, image::Image *other, image::Image *mask, bitmap_op_t op);
+    extern void _bitmap_morph(image::Image *img, int ksize, bool dilate, image::Image *mask);
+    extern void _bitmap_get_histogram(histogram_t *out, image::Image *img, rectangle_t *roi, list_t *thresholds, bool invert, image::Image *other);
+    extern std::vector<image::Blob> _bitmap_find_blobs(image::Image *img, list_t *thresholds, bool invert, rectangle_t *roi,
+                                                       int x_stride, int y_stride, int area_threshold, int pixels_threshold);
+    extern image::Image *_bitmap_to_format(image::Image *img, image::Format format, void *buff, size_t buff_size);
 }
 
@@ -0,0 +1,728 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add JpegEncoder, reusable libjpeg(turbo) encoder context.
+ * @update 2026.10.19: Add JpegDecoder, decode with libjpeg(turbo) DCT domain downscale.
+ * @update 2026.10.19: Use OpenCV if libjpeg-turbo not found.
+ */
+
+#include "maix_image_jpeg.hpp"
+#include <vector>
+#if HAVE_LIBJPEG_TURBO
+#include <stdio.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+#include <thread>
+
+namespace maix::image
+{
+    struct _jpeg_error_mgr
+    {
+        struct jpeg_error_mgr pub;
+        jmp_buf jmp;
+        char msg[JMSG_LENGTH_MAX];
+    };
+
+    struct _jpeg_dest_mgr
+    {
+        struct jpeg_destination_mgr pub;
+        std::vector<uint8_t> *buff; // internal buffer, can grow
+        uint8_t *ext;               // user buffer, fixed size
+        size_t ext_size;
+        bool overflow;              // user buffer not enough
+    };
+
+    struct _jpeg_slice
+    {
+        struct jpeg_compress_struct cinfo;
+        struct _jpeg_error_mgr jerr;
+        struct _jpeg_dest_mgr dest;
+        std::vector<uint8_t> buff;
+        std::vector<uint8_t> scratch;   // padded YUV rows
+        size_t size;
+        bool ok;
+    };
+
+    struct _jpeg_context
+    {
+        std::vector<_jpeg_slice *> slices;
+        std::vector<uint8_t> buff;      // joined slices
+    };
+
+    static void _jpeg_error_exit(j_common_ptr cinfo)
+    {
+        _jpeg_error_mgr *err = (_jpeg_error_mgr *)cinfo->err;
+        (*cinfo->err->format_message)(cinfo, err->msg);
+        longjmp(err->jmp, 1);
+    }
+
+    static void _jpeg_dest_init(j_compress_ptr cinfo)
+    {
+        _jpeg_dest_mgr *dest = (_jpeg_dest_mgr *)cinfo->dest;
+        dest->overflow = false;
+        if (dest->ext)
+        {
+            dest->pub.next_output_byte = dest->ext;
+            dest->pub.free_in_buffer = dest->ext_size;
+        }
+        else
+        {
+            if (dest->buff->size() < 64 * 1024)
+                dest->buff->resize(64 * 1024);
+            dest->pub.next_output_byte = dest->buff->data();
+            dest->pub.free_in_buffer = dest->buff->size();
+        }
+    }
+
+    static boolean _jpeg_dest_empty(j_compress_ptr cinfo)
+    {
+        _jpeg_dest_mgr *dest = (_jpeg_dest_mgr *)cinfo->dest;
+        size_t used;
+        if (dest->ext)
+        {
+            // user buffer full, go on with internal buffer, caller will raise error
+            used = dest->ext_size;
+            if (dest->buff->size() < used * 2)
+                dest->buff->resize(used * 2);
+            memcpy(dest->buff->data(), dest->ext, used);
+            dest->ext = nullptr;
+            dest->overflow = true;
+        }
+        else
+        {
+            used = dest->buff->size();
+            dest->buff->resize(used * 2);
+        }
+        dest->pub.next_output_byte = dest->buff->data() + used;
+        dest->pub.free_in_buffer = dest->buff->size() - used;
+        return TRUE;
+    }
+
+    static void _jpeg_dest_term(j_compress_ptr cinfo)
+    {
+        (void)cinfo;
+    }
+
+    static _jpeg_slice *_jpeg_slice_create()
+    {
+        _jpeg_slice *s = new _jpeg_slice();
+        s->cinfo.err = jpeg_std_error(&s->jerr.pub);
+        s->jerr.pub.error_exit = _jpeg_error_exit;
+        if (setjmp(s->jerr.jmp))
+        {
+            log::error("create jpeg encoder failed: %s\n", s->jerr.msg);
+            delete s;
+            return nullptr;
+        }
+        jpeg_create_compress(&s->cinfo);
+        s->dest.pub.init_destination = _jpeg_dest_init;
+        s->dest.pub.empty_output_buffer = _jpeg_dest_empty;
+        s->dest.pub.term_destination = _jpeg_dest_term;
+        s->dest.buff = &s->buff;
+        s->cinfo.dest = &s->dest.pub;
+        return s;
+    }
+
+    static void _jpeg_slice_destroy(_jpeg_slice *s)
+    {
+        jpeg_destroy_compress(&s->cinfo);
+        delete s;
+    }
+
+    static bool _is_yuv420(image::Format fmt)
+    {
+        return fmt == image::FMT_YVU420SP || fmt == image::FMT_YUV420SP || fmt == image::FMT_YVU420P || fmt == image::FMT_YUV420P;
+    }
+
+    // copy YUV420 rows of [y, y + 16) to padded planes in scratch, rows out of [0, y_end) repeat the last row
+    static void _jpeg_fill_yuv_rows(image::Image &img, int y, int y_end, int pad_w, uint8_t *scratch, JSAMPROW *rows_y, JSAMPROW *rows_u, JSAMPROW *rows_v)
+    {
+        int w = img.width();
+        int h = img.height();
+        int cw = w / 2;
+        int pad_cw = pad_w / 2;
+        uint8_t *data = (uint8_t *)img.data();
+        uint8_t *plane_y = data;
+        uint8_t *plane_c = data + w * h;
+        image::Format fmt = img.format();
+
+        bool copy_y = pad_w != w;
+        uint8_t *scratch_y = scratch;
+        uint8_t *scratch_u = scratch_y + (copy_y ? pad_w * 16 : 0);
+        uint8_t *scratch_v = scratch_u + pad_cw * 8;
+        for (int i = 0; i < 16; i++)
+        {
+            int yy = std::min(y + i, y_end - 1);
+            if (!copy_y)
+            {
+                rows_y[i] = plane_y + yy * w;
+                continue;
+            }
+            uint8_t *dst = scratch_y + i * pad_w;
+            memcpy(dst, plane_y + yy * w, w);
+            memset(dst + w, dst[w - 1], pad_w - w);
+            rows_y[i] = dst;
+        }
+        for (int i = 0; i < 8; i++)
+        {
+            int cy = std::min(y / 2 + i, (y_end - 1) / 2);
+            uint8_t *dst_u = scratch_u + i * pad_cw;
+            uint8_t *dst_v = scratch_v + i * pad_cw;
+            if (fmt == image::FMT_YVU420SP || fmt == image::FMT_YUV420SP)
+            {
+                uint8_t *src = plane_c + cy * w;
+                uint8_t *dst0 = fmt == image::FMT_YVU420SP ? dst_v : dst_u;
+                uint8_t *dst1 = fmt == image::FMT_YVU420SP ? dst_u : dst_v;
+                for (int x = 0; x < cw; x++)
+                {
+                    dst0[x] = src[x * 2];
+                    dst1[x] = src[x * 2 + 1];
+                }
+            }
+            else
+            {
+                uint8_t *plane0 = plane_c + cy * cw;
+                uint8_t *plane1 = plane_c + (h / 2) * cw + cy * cw;
+                memcpy(fmt == image::FMT_YUV420P ? dst_u : dst_v, plane0, cw);
+                memcpy(fmt == image::FMT_YUV420P ? dst_v : dst_u, plane1, cw);
+            }
+            memset(dst_u + cw, dst_u[cw - 1], pad_cw - cw);
+            memset(dst_v + cw, dst_v[cw - 1], pad_cw - cw);
+            rows_u[i] = dst_u;
+            rows_v[i] = dst_v;
+        }
+    }
+
+    // encode rows [y, y + rows) of img, return false if error
+    static bool _jpeg_encode_slice(_jpeg_slice *s, image::Image &img, int y, int rows, int quality, uint8_t *ext, size_t ext_size)
+    {
+        struct jpeg_compress_struct *cinfo = &s->cinfo;
+        image::Format fmt = img.format();
+        int w = img.width();
+        s->ok = false;
+        s->size = 0;
+        s->dest.ext = ext;
+        s->dest.ext_size = ext_size;
+        if (setjmp(s->jerr.jmp))
+        {
+            log::error("jpeg encode failed: %s\n", s->jerr.msg);
+            jpeg_abort_compress(cinfo);
+            return false;
+        }
+        cinfo->image_width = w;
+        cinfo->image_height = rows;
+        switch (fmt)
+        {
+        case image::FMT_GRAYSCALE:
+            cinfo->input_components = 1;
+            cinfo->in_color_space = JCS_GRAYSCALE;
+            break;
+        case image::FMT_RGB888:
+            cinfo->input_components = 3;
+            cinfo->in_color_space = JCS_RGB;
+            break;
+        case image::FMT_BGR888:
+            cinfo->input_components = 3;
+            cinfo->in_color_space = JCS_EXT_BGR;
+            break;
+        case image::FMT_RGBA8888:
+            cinfo->input_components = 4;
+            cinfo->in_color_space = JCS_EXT_RGBA;
+            break;
+        case image::FMT_BGRA8888:
+            cinfo->input_components = 4;
+            cinfo->in_color_space = JCS_EXT_BGRA;
+            break;
+        default:
+            cinfo->input_components = 3;
+            cinfo->in_color_space = JCS_YCbCr;
+            break;
+        }
+        jpeg_set_defaults(cinfo);
+        jpeg_set_quality(cinfo, quality, TRUE);
+        // same huffman tables for all slices, or they can't be joined
+        cinfo->optimize_coding = FALSE;
+        if (cinfo->num_components == 3)
+        {
+            cinfo->comp_info[0].h_samp_factor = 2;
+            cinfo->comp_info[0].v_samp_factor = 2;
+            cinfo->comp_info[1].h_samp_factor = 1;
+            cinfo->comp_info[1].v_samp_factor = 1;
+            cinfo->comp_info[2].h_samp_factor = 1;
+            cinfo->comp_info[2].v_samp_factor = 1;
+        }
+        bool raw = _is_yuv420(fmt);
+        cinfo->raw_data_in = raw ? TRUE : FALSE;
+        jpeg_start_compress(cinfo, TRUE);
+        if (raw)
+        {
+            int pad_w = (w + 15) & ~15;
+            size_t scratch_size = pad_w * 16 + pad_w / 2 * 8 * 2;
+            if (s->scratch.size() < scratch_size)
+                s->scratch.resize(scratch_size);
+            JSAMPROW rows_y[16], rows_u[8], rows_v[8];
+            JSAMPARRAY planes[3] = {rows_y, rows_u, rows_v};
+            for (int i = 0; i < rows; i += 16)
+            {
+                _jpeg_fill_yuv_rows(img, y + i, y + rows, pad_w, s->scratch.data(), rows_y, rows_u, rows_v);
+                jpeg_write_raw_data(cinfo, planes, 16);
+            }
+        }
+        else
+        {
+            int stride = img.stride();
+            uint8_t *data = (uint8_t *)img.data() + y * stride;
+            JSAMPROW row_pointers[16];
+            for (int i = 0; i < rows;)
+            {
+                int n = std::min(16, rows - i);
+                for (int j = 0; j < n; j++)
+                    row_pointers[j] = data + (i + j) * stride;
+                i += jpeg_write_scanlines(cinfo, row_pointers, n);
+            }
+        }
+        jpeg_finish_compress(cinfo);
+        s->size = s->dest.ext ? (s->dest.ext_size - s->dest.pub.free_in_buffer) : (s->buff.size() - s->dest.pub.free_in_buffer);
+        s->ok = true;
+        return true;
+    }
+
+    static const uint8_t *_jpeg_slice_data(_jpeg_slice *s)
+    {
+        return s->dest.ext ? s->dest.ext : s->buff.data();
+    }
+
+    // find SOF and the end of SOS segment, return SOS marker offset
+    static int _jpeg_parse_header(const uint8_t *data, size_t size, int *sof, int *scan_start)
+    {
+        size_t p = 2;
+        *sof = -1;
+        while (p + 4 <= size)
+        {
+            if (data[p] != 0xFF)
+                return -1;
+            uint8_t marker = data[p + 1];
+            int len = (data[p + 2] << 8) | data[p + 3];
+            if (marker >= 0xC0 && marker <= 0xC2)
+                *sof = p;
+            if (marker == 0xDA)
+            {
+                *scan_start = p + 2 + len;
+                return p;
+            }
+            p += 2 + len;
+        }
+        return -1;
+    }
+
+    // join slices with restart markers to context buffer or user buffer
+    static size_t _jpeg_join_slices(_jpeg_context *ctx, int slices, int height, int restart_interval, uint8_t *ext, size_t ext_size)
+    {
+        _jpeg_slice *first = ctx->slices[0];
+        const uint8_t *data = _jpeg_slice_data(first);
+        int sof = -1, scan_start = -1;
+        int sos = _jpeg_parse_header(data, first->size, &sof, &scan_start);
+        if (sos < 0 || sof < 0)
+            throw err::Exception(err::ERR_RUNTIME, "parse jpeg header failed");
+
+        size_t total = scan_start + 6 + 2;
+        for (int i = 0; i < slices; i++)
+            total += ctx->slices[i]->size + 2;
+        uint8_t *out = ext;
+        if (!ext)
+        {
+            if (ctx->buff.size() < total)
+                ctx->buff.resize(total);
+            out = ctx->buff.data();
+        }
+        else if (ext_size < total)
+            throw err::Exception(err::ERR_ARGS, "convert format failed, buffer size not enough");
+
+        // header, with full image height and DRI segment
+        size_t p = 0;
+        memcpy(out, data, sos);
+        out[sof + 5] = (height >> 8) & 0xFF;
+        out[sof + 6] = height & 0xFF;
+        p = sos;
+        out[p++] = 0xFF;
+        out[p++] = 0xDD;
+        out[p++] = 0x00;
+        out[p++] = 0x04;
+        out[p++] = (restart_interval >> 8) & 0xFF;
+        out[p++] = restart_interval & 0xFF;
+        memcpy(out + p, data + sos, scan_start - sos);
+        p += scan_start - sos;
+
+        // entropy coded data of each slice, without EOI
+        for (int i = 0; i < slices; i++)
+        {
+            _jpeg_slice *s = ctx->slices[i];
+            const uint8_t *d = _jpeg_slice_data(s);
+            int s_sof, s_scan_start;
+            if (_jpeg_parse_header(d, s->size, &s_sof, &s_scan_start) < 0)
+                throw err::Exception(err::ERR_RUNTIME, "parse jpeg header failed");
+            size_t len = s->size - s_scan_start - 2;
+            memmove(out + p, d + s_scan_start, len);
+            p += len;
+            if (i != slices - 1)
+            {
+                out[p++] = 0xFF;
+                out[p++] = 0xD0 + (i & 7);
+            }
+        }
+        out[p++] = 0xFF;
+        out[p++] = 0xD9;
+        return p;
+    }
+
+    // encode img, return data pointer and size, data is in ext or context buffer
+    static void _jpeg_encode(_jpeg_context *ctx, image::Image &img, int quality, int slices, uint8_t *ext, size_t ext_size, uint8_t **out_data, size_t *out_size)
+    {
+        image::Format fmt = img.format();
+        int w = img.width();
+        int h = img.height();
+        if (!(fmt == image::FMT_GRAYSCALE || fmt == image::FMT_RGB888 || fmt == image::FMT_BGR888 ||
+              fmt == image::FMT_RGBA8888 || fmt == image::FMT_BGRA8888 || _is_yuv420(fmt)))
+        {
+            // other formats(RGB565, BGR565, BITMAP etc.), convert to BGR888 first, output data is not in converted image
+            image::Image *bgr = img.to_format(image::FMT_BGR888);
+            try
+            {
+                _jpeg_encode(ctx, *bgr, quality, slices, ext, ext_size, out_data, out_size);
+            }
+            catch (...)
+            {
+                delete bgr;
+                throw;
+            }
+            delete bgr;
+            return;
+        }
+        if (_is_yuv420(fmt) && ((w & 1) || (h & 1)))
+            throw err::Exception(err::ERR_ARGS, "YUV420 image width and height must be even");
+
+        // slice height must be multiple of MCU height, and restart interval is 16 bits
+        int mcu_h = fmt == image::FMT_GRAYSCALE ? 8 : 16;
+        int mcu_w = mcu_h;
+        int mcu_rows = (h + mcu_h - 1) / mcu_h;
+        int mcu_cols = (w + mcu_w - 1) / mcu_w;
+        if (slices <= 0)
+            slices = std::max(1, (int)std::thread::hardware_concurrency());
+        slices = std::max(1, std::min(slices, mcu_rows));
+        int slice_mcu_rows = (mcu_rows + slices - 1) / slices;
+        while (slice_mcu_rows * mcu_cols > 0xFFFF && slice_mcu_rows > 1)
+            slice_mcu_rows = (slice_mcu_rows + 1) / 2;
+        if (slice_mcu_rows * mcu_cols > 0xFFFF)
+            slice_mcu_rows = mcu_rows; // too wide, not split
+        slices = (mcu_rows + slice_mcu_rows - 1) / slice_mcu_rows;
+        int slice_h = slice_mcu_rows * mcu_h;
+
+        while ((int)ctx->slices.size() < slices)
+        {
+            _jpeg_slice *s = _jpeg_slice_create();
+            if (!s)
+                throw err::Exception(err::ERR_NO_MEM, "create jpeg encoder failed");
+            ctx->slices.push_back(s);
+        }
+
+        if (slices == 1)
+        {
+            _jpeg_slice *s = ctx->slices[0];
+            if (!_jpeg_encode_slice(s, img, 0, h, quality, ext, ext_size))
+                throw err::Exception(err::ERR_RUNTIME, "jpeg encode failed");
+            if (s->dest.overflow)
+                throw err::Exception(err::ERR_ARGS, "convert format failed, buffer size not enough");
+            *out_data = (uint8_t *)_jpeg_slice_data(s);
+            *out_size = s->size;
+            return;
+        }
+
+        #pragma omp parallel for num_threads(slices)
+        for (int i = 0; i < slices; i++)
+        {
+            int y = i * slice_h;
+            _jpeg_encode_slice(ctx->slices[i], img, y, std::min(slice_h, h - y), quality, nullptr, 0);
+        }
+        for (int i = 0; i < slices; i++)
+        {
+            if (!ctx->slices[i]->ok)
+                throw err::Exception(err::ERR_RUNTIME, "jpeg encode failed");
+        }
+        *out_size = _jpeg_join_slices(ctx, slices, h, slice_mcu_rows * mcu_cols, ext, ext_size);
+        *out_data = ext ? ext : ctx->buff.data();
+    }
+
+    JpegEncoder::JpegEncoder(int quality, int slices)
+    {
+        set_quality(quality);
+        set_slices(slices);
+        _handle = new _jpeg_context();
+    }
+
+    JpegEncoder::~JpegEncoder()
+    {
+        _jpeg_context *ctx = (_jpeg_context *)_handle;
+        for (auto s : ctx->slices)
+            _jpeg_slice_destroy(s);
+        delete ctx;
+        _handle = nullptr;
+    }
+
+    image::Image *JpegEncoder::encode(image::Image &img, void *buff, size_t buff_size)
+    {
+        uint8_t *data = nullptr;
+        size_t size = 0;
+        _jpeg_encode((_jpeg_context *)_handle, img, _quality, _slices, (uint8_t *)buff, buff_size, &data, &size);
+        if (buff)
+            return new image::Image(img.width(), img.height(), image::FMT_JPEG, (uint8_t *)buff, size, false);
+        return new image::Image(img.width(), img.height(), image::FMT_JPEG, data, size, true);
+    }
+
+    err::Err JpegEncoder::encode_raw(image::Image &img, uint8_t **data, size_t *size)
+    {
+        try
+        {
+            _jpeg_encode((_jpeg_context *)_handle, img, _quality, _slices, nullptr, 0, data, size);
+        }
+        catch (err::Exception &e)
+        {
+            log::error("%s\n", e.what());
+            return e.code();
+        }
+        return err::ERR_NONE;
+    }
+
+    struct _jpeg_decoder
+    {
+        struct jpeg_decompress_struct cinfo;
+        struct _jpeg_error_mgr jerr;
+    };
+
+    JpegDecoder::JpegDecoder(image::Format format, int scale)
+    {
+        set_format(format);
+        set_scale(scale);
+        _jpeg_decoder *d = new _jpeg_decoder();
+        d->cinfo.err = jpeg_std_error(&d->jerr.pub);
+        d->jerr.pub.error_exit = _jpeg_error_exit;
+        if (setjmp(d->jerr.jmp))
+        {
+            log::error("create jpeg decoder failed: %s\n", d->jerr.msg);
+            delete d;
+            throw err::Exception(err::ERR_RUNTIME, "create jpeg decoder failed");
+        }
+        jpeg_create_decompress(&d->cinfo);
+        _handle = d;
+    }
+
+    JpegDecoder::~JpegDecoder()
+    {
+        _jpeg_decoder *d = (_jpeg_decoder *)_handle;
+        jpeg_destroy_decompress(&d->cinfo);
+        delete d;
+        _handle = nullptr;
+    }
+
+    image::Image *JpegDecoder::decode(const uint8_t *data, size_t size, void *buff, size_t buff_size)
+    {
+        if (!data || size == 0)
+            throw err::Exception(err::ERR_ARGS, "jpeg data is empty");
+        _jpeg_decoder *d = (_jpeg_decoder *)_handle;
+        j_decompress_ptr cinfo = &d->cinfo;
+        image::Image *volatile img = nullptr;
+        if (setjmp(d->jerr.jmp))
+        {
+            // corrupted data or not support color space(e.g. CMYK), reset context for next image
+            log::error("jpeg decode failed: %s\n", d->jerr.msg);
+            jpeg_abort_decompress(cinfo);
+            delete img;
+            return nullptr;
+        }
+        jpeg_mem_src(cinfo, (unsigned char *)data, size);
+        jpeg_read_header(cinfo, TRUE);
+        switch (_format)
+        {
+        case image::FMT_GRAYSCALE:
+            cinfo->out_color_space = JCS_GRAYSCALE;
+            break;
+        case image::FMT_BGR888:
+            cinfo->out_color_space = JCS_EXT_BGR;
+            break;
+        case image::FMT_RGBA8888:
+            cinfo->out_color_space = JCS_EXT_RGBA;
+            break;
+        case image::FMT_BGRA8888:
+            cinfo->out_color_space = JCS_EXT_BGRA;
+            break;
+        default:
+            cinfo->out_color_space = JCS_RGB;
+            break;
+        }
+        // DCT domain downscale
+        cinfo->scale_num = 1;
+        cinfo->scale_denom = _scale;
+        jpeg_start_decompress(cinfo);
+        int w = cinfo->output_width;
+        int h = cinfo->output_height;
+        size_t need = (size_t)w * h * (int)image::fmt_size[_format];
+        if (buff && buff_size < need)
+        {
+            jpeg_abort_decompress(cinfo);
+            log::error("jpeg decode buffer size not enough, need %d, but %d\n", (int)need, (int)buff_size);
+            throw err::Exception(err::ERR_ARGS, "jpeg decode buffer size not enough");
+        }
+        img = buff ? new image::Image(w, h, _format, (uint8_t *)buff, need, false) : new image::Image(w, h, _format);
+        uint8_t *out = (uint8_t *)img->data();
+        int stride = img->stride();
+        JSAMPROW rows[8];
+        while ((int)cinfo->output_scanline < h)
+        {
+            int n = std::min(8, h - (int)cinfo->output_scanline);
+            for (int i = 0; i < n; i++)
+                rows[i] = out + (cinfo->output_scanline + i) * stride;
+            jpeg_read_scanlines(cinfo, rows, n);
+        }
+        jpeg_finish_decompress(cinfo);
+        return img;
+    }
+}
+
+#else // HAVE_LIBJPEG_TURBO
+#include "opencv2/opencv.hpp"
+
+namespace maix::image
+{
+    // encode img to buff by OpenCV, slices not used
+    static void _jpeg_encode(std::vector<uint8_t> *buff, image::Image &img, int quality)
+    {
+        // imencode only accept BGR and grayscale
+        image::Image *bgr = nullptr;
+        if (img.format() != image::FMT_BGR888 && img.format() != image::FMT_GRAYSCALE)
+            bgr = img.to_format(image::FMT_BGR888);
+        image::Image *src = bgr ? bgr : &img;
+        bool ok = false;
+        try
+        {
+            cv::Mat mat(src->height(), src->width(), CV_8UC((int)image::fmt_size[src->format()]), src->data(), src->stride());
+            ok = cv::imencode(".jpg", mat, *buff, {cv::IMWRITE_JPEG_QUALITY, quality});
+        }
+        catch (...)
+        {
+            delete bgr;
+            throw;
+        }
+        delete bgr;
+        if (!ok)
+            throw err::Exception(err::ERR_RUNTIME, "jpeg encode failed");
+    }
+
+    JpegEncoder::JpegEncoder(int quality, int slices)
+    {
+        set_quality(quality);
+        set_slices(slices);
+        _handle = new std::vector<uint8_t>();
+    }
+
+    JpegEncoder::~JpegEncoder()
+    {
+        delete (std::vector<uint8_t> *)_handle;
+        _handle = nullptr;
+    }
+
+    image::Image *JpegEncoder::encode(image::Image &img, void *buff, size_t buff_size)
+    {
+        std::vector<uint8_t> *jpg = (std::vector<uint8_t> *)_handle;
+        _jpeg_encode(jpg, img, _quality);
+        if (!buff)
+            return new image::Image(img.width(), img.height(), image::FMT_JPEG, jpg->data(), jpg->size(), true);
+        if (buff_size < jpg->size())
+            throw err::Exception(err::ERR_ARGS, "convert format failed, buffer size not enough");
+        memcpy(buff, jpg->data(), jpg->size());
+        return new image::Image(img.width(), img.height(), image::FMT_JPEG, (uint8_t *)buff, jpg->size(), false);
+    }
+
+    err::Err JpegEncoder::encode_raw(image::Image &img, uint8_t **data, size_t *size)
+    {
+        std::vector<uint8_t> *jpg = (std::vector<uint8_t> *)_handle;
+        try
+        {
+            _jpeg_encode(jpg, img, _quality);
+        }
+        catch (err::Exception &e)
+        {
+            log::error("%s\n", e.what());
+            return e.code();
+        }
+        *data = jpg->data();
+        *size = jpg->size();
+        return err::ERR_NONE;
+    }
+
+    JpegDecoder::JpegDecoder(image::Format format, int scale)
+    {
+        set_format(format);
+        set_scale(scale);
+        _handle = nullptr;
+    }
+
+    JpegDecoder::~JpegDecoder()
+    {
+    }
+
+    image::Image *JpegDecoder::decode(const uint8_t *data, size_t size, void *buff, size_t buff_size)
+    {
+        if (!data || size == 0)
+            throw err::Exception(err::ERR_ARGS, "jpeg data is empty");
+        bool gray = _format == image::FMT_GRAYSCALE;
+        int flags;
+        // reduced mode use libjpeg's DCT domain downscale
+        switch (_scale)
+        {
+        case 2:
+            flags = gray ? cv::IMREAD_REDUCED_GRAYSCALE_2 : cv::IMREAD_REDUCED_COLOR_2;
+            break;
+        case 4:
+            flags = gray ? cv::IMREAD_REDUCED_GRAYSCALE_4 : cv::IMREAD_REDUCED_COLOR_4;
+            break;
+        case 8:
+            flags = gray ? cv::IMREAD_REDUCED_GRAYSCALE_8 : cv::IMREAD_REDUCED_COLOR_8;
+            break;
+        default:
+            flags = gray ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
+            break;
+        }
+        cv::Mat mat = cv::imdecode(cv::Mat(1, (int)size, CV_8UC1, (void *)data), flags);
+        if (mat.empty())
+        {
+            log::error("jpeg decode failed\n");
+            return nullptr;
+        }
+        size_t need = (size_t)mat.cols * mat.rows * (int)image::fmt_size[_format];
+        if (buff && buff_size < need)
+        {
+            log::error("jpeg decode buffer size not enough, need %d, but %d\n", (int)need, (int)buff_size);
+            throw err::Exception(err::ERR_ARGS, "jpeg decode buffer size not enough");
+        }
+        image::Image *img = buff ? new image::Image(mat.cols, mat.rows, _format, (uint8_t *)buff, need, false) : new image::Image(mat.cols, mat.rows, _format);
+        // convert directly into image buffer
+        cv::Mat dst(mat.rows, mat.cols, CV_8UC((int)image::fmt_size[_format]), img->data());
+        switch (_format)
+        {
+        case image::FMT_RGB888:
+            cv::cvtColor(mat, dst, cv::COLOR_BGR2RGB);
+            break;
+        case image::FMT_RGBA8888:
+            cv::cvtColor(mat, dst, cv::COLOR_BGR2RGBA);
+            break;
+        case image::FMT_BGRA8888:
+            cv::cvtColor(mat, dst, cv::COLOR_BGR2BGRA);
+            break;
+        default:
+            mat.copyTo(dst);
+            break;
+        }
+        return img;
+    }
+}
+#endif // HAVE_LIBJPEG_TURBO
@@ -0,0 +1,123 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add JpegEncoder, use hardware encoder by Image::to_jpeg.
+ * @update 2026.10.19: Add JpegDecoder, use OpenCV reduced decode mode.
+ */
+
+#include "maix_image_jpeg.hpp"
+#include "opencv2/opencv.hpp"
+#include <vector>
+
+namespace maix::image
+{
+    JpegEncoder::JpegEncoder(int quality, int slices)
+    {
+        set_quality(quality);
+        set_slices(slices);
+        _handle = new std::vector<uint8_t>();
+    }
+
+    JpegEncoder::~JpegEncoder()
+    {
+        delete (std::vector<uint8_t> *)_handle;
+        _handle = nullptr;
+    }
+
+    image::Image *JpegEncoder::encode(image::Image &img, void *buff, size_t buff_size)
+    {
+        // hardware encoder, slices not used
+        return img.to_jpeg(_quality, buff, buff_size);
+    }
+
+    err::Err JpegEncoder::encode_raw(image::Image &img, uint8_t **data, size_t *size)
+    {
+        std::vector<uint8_t> *buff = (std::vector<uint8_t> *)_handle;
+        image::Image *jpg = nullptr;
+        try
+        {
+            jpg = img.to_jpeg(_quality);
+        }
+        catch (err::Exception &e)
+        {
+            log::error("%s\n", e.what());
+            return e.code();
+        }
+        if (!jpg)
+            return err::ERR_RUNTIME;
+        if (buff->size() < (size_t)jpg->data_size())
+            buff->resize(jpg->data_size());
+        memcpy(buff->data(), jpg->data(), jpg->data_size());
+        *data = buff->data();
+        *size = jpg->data_size();
+        delete jpg;
+        return err::ERR_NONE;
+    }
+
+    JpegDecoder::JpegDecoder(image::Format format, int scale)
+    {
+        set_format(format);
+        set_scale(scale);
+        _handle = nullptr;
+    }
+
+    JpegDecoder::~JpegDecoder()
+    {
+    }
+
+    image::Image *JpegDecoder::decode(const uint8_t *data, size_t size, void *buff, size_t buff_size)
+    {
+        if (!data || size == 0)
+            throw err::Exception(err::ERR_ARGS, "jpeg data is empty");
+        bool gray = _format == image::FMT_GRAYSCALE;
+        int flags;
+        // reduced mode use libjpeg's DCT domain downscale
+        switch (_scale)
+        {
+        case 2:
+            flags = gray ? cv::IMREAD_REDUCED_GRAYSCALE_2 : cv::IMREAD_REDUCED_COLOR_2;
+            break;
+        case 4:
+            flags = gray ? cv::IMREAD_REDUCED_GRAYSCALE_4 : cv::IMREAD_REDUCED_COLOR_4;
+            break;
+        case 8:
+            flags = gray ? cv::IMREAD_REDUCED_GRAYSCALE_8 : cv::IMREAD_REDUCED_COLOR_8;
+            break;
+        default:
+            flags = gray ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
+            break;
+        }
+        cv::Mat mat = cv::imdecode(cv::Mat(1, (int)size, CV_8UC1, (void *)data), flags);
+        if (mat.empty())
+        {
+            log::error("jpeg decode failed\n");
+            return nullptr;
+        }
+        size_t need = (size_t)mat.cols * mat.rows * (int)image::fmt_size[_format];
+        if (buff && buff_size < need)
+        {
+            log::error("jpeg decode buffer size not enough, need %d, but %d\n", (int)need, (int)buff_size);
+            throw err::Exception(err::ERR_ARGS, "jpeg decode buffer size not enough");
+        }
+        image::Image *img = buff ? new image::Image(mat.cols, mat.rows, _format, (uint8_t *)buff, need, false) : new image::Image(mat.cols, mat.rows, _format);
+        // convert directly into image buffer
+        cv::Mat dst(mat.rows, mat.cols, CV_8UC((int)image::fmt_size[_format]), img->data());
+        switch (_format)
+        {
+        case image::FMT_RGB888:
+            cv::cvtColor(mat, dst, cv::COLOR_BGR2RGB);
+            break;
+        case image::FMT_RGBA8888:
+            cv::cvtColor(mat, dst, cv::COLOR_BGR2RGBA);
+            break;
+        case image::FMT_BGRA8888:
+            cv::cvtColor(mat, dst, cv::COLOR_BGR2BGRA);
+            break;
+        default:
+            mat.copyTo(dst);
+            break;
+        }
+        return img;
+    }
+}
@@ -187,6 +187,15 @@ namespace maix::display
     {
         err::Err e = err::ERR_NONE;
 
+        // backends use image data directly, image created by Image.view need copy to continuous buffer first
+        if (!img.is_contiguous())
+        {
+            image::Image *tmp = img.copy();
+            e = show(*tmp, fit);
+            delete tmp;
+            return e;
+        }
+
         if(img_trans)
             img_trans->send_image(img);
 
@@ -6,6 +6,7 @@
  */
 
 #include "maix_image.hpp"
+#include "maix_image_jpeg.hpp"
 #include "opencv2/opencv.hpp"
 #include "opencv2/freetype.hpp"
 #include <map>
@@ -13,6 +14,7 @@
 #include <vector>
 #include <string>
 #include <array>
+#include <atomic>
 #include <sched.h>
 #include <thread>
 #include "omp.h"
@@ -28,6 +30,8 @@ namespace maix::image
 {
 
     static void _get_cv_format_color(image::Format _format, const image::Color &color_in, int *ch_format, cv::Scalar &cv_color);
+    // implemented in maix_image_bitmap.cpp
+    extern image::Image *_bitmap_to_format(image::Image *img, image::Format format, void *buff, size_t buff_size);
 
     static bool path_is_format(const std::string &str, const std::string ext)
     {
@@ -368,11 +372,137 @@ namespace maix::image
         }
     }
 
+    /**
+     * Reference counted pixel buffer shared by images.
+     * refs count all images use this buffer include views, buffer is freed when refs is 0.
+     * owners count images own this buffer(not views), copy on write when owners more than one.
+     * views count views(and cv::Mat, tensor hold a view) of this buffer, buffer with views is pinned to one owner:
+     * view() detaches a shared owner first, share() and assignment copy data instead of sharing a pinned buffer,
+     * so every writer(owner or view) writes in place and the writes are seen by and only by the owner and its views.
+     * version increase every time buffer is going to be modified, used to invalidate caches built on pixels.
+     * release is set for external memory(e.g. numpy array, cv::Mat), called instead of free when refs is 0.
+     */
+    typedef struct
+    {
+        std::atomic<int> refs;
+        std::atomic<int> owners;
+        std::atomic<int> views;
+        std::atomic<uint32_t> version;
+        void *actual_data;
+        std::function<void()> release;
+    } image_buffer_t;
+
+    static void _unref_buffer(image_buffer_t *buf)
+    {
+        if (--buf->refs != 0)
+            return;
+        if (buf->release)
+            buf->release();
+        else
+            free(buf->actual_data);
+        delete buf;
+    }
+
+    static void _copy_rows(void *dst, int dst_stride, const void *src, int src_stride, int row_bytes, int rows)
+    {
+        uint8_t *d = (uint8_t *)dst;
+        const uint8_t *s = (const uint8_t *)src;
+        for (int i = 0; i < rows; ++i)
+        {
+            memcpy(d, s, row_bytes);
+            d += dst_stride;
+            s += src_stride;
+        }
+    }
+
+    void Image::_alloc_buffer(int size)
+    {
+        void *actual_data = malloc(size + 0x1000);
+        if (!actual_data)
+            throw err::Exception(err::ERR_NO_MEM, "malloc image data failed");
+        _actual_data = actual_data;
+        _data = (void *)(((uint64_t)_actual_data + 0x1000) & ~0xFFF);
+        image_buffer_t *buf = new image_buffer_t();
+        buf->refs = 1;
+        buf->owners = 1;
+        buf->views = 0;
+        buf->version = 0;
+        buf->actual_data = _actual_data;
+        _buf = buf;
+        _is_malloc = true;
+    }
+
+    void Image::_release()
+    {
+        _free_alpha_tiles();
+        if (_buf)
+        {
+            image_buffer_t *buf = (image_buffer_t *)_buf;
+            if (_is_malloc)
+                --buf->owners;
+            else
+                --buf->views;
+            _unref_buffer(buf);
+            _buf = NULL;
+        }
+        else if (_is_malloc)
+        {
+            free(_actual_data);
+        }
+        _actual_data = NULL;
+        _data = NULL;
+        _is_malloc = false;
+        if (_pack_data)
+        {
+            free(_pack_data);
+            _pack_data = NULL;
+        }
+    }
+
+    void Image::_cow()
+    {
+        if (!_buf)
+            return;
+        image_buffer_t *buf = (image_buffer_t *)_buf;
+        ++buf->version;
+        // views write to the buffer directly, buffer with views is never shared by other owners
+        if (!_is_malloc || buf->owners.load() <= 1)
+            return;
+        void *old_data = _data;
+        int old_stride = _stride;
+        _alloc_buffer(_data_size);
+        // wrapped external buffer may have stride, copied one is always continuous
+        if (is_contiguous())
+            memcpy(_data, old_data, _data_size);
+        else
+        {
+            _stride = _stride_of(_width, _format);
+            _copy_rows(_data, _stride, old_data, old_stride, _stride, _height);
+        }
+        --buf->owners;
+        _unref_buffer(buf);
+    }
+
+    uint32_t Image::_buf_version()
+    {
+        return _buf ? ((image_buffer_t *)_buf)->version.load() : 0;
+    }
+
+    void Image::_buf_modified()
+    {
+        if (_buf)
+            ++((image_buffer_t *)_buf)->version;
+    }
+
     void Image::_create_image(int width, int height, image::Format format, uint8_t *data, int data_size, bool copy, const image::Color &bg)
     {
         _format = format;
         _width = width;
         _height = height;
+        _stride = _stride_of(width, format);
+        _pack_data = nullptr;
+        _buf = nullptr;
+        _alpha_tiles = nullptr;
         if (width <= 0 || height <= 0)
             throw err::Exception(err::ERR_ARGS, "image width and height should > 0");
 
@@ -385,7 +515,7 @@ namespace maix::image
         else
         {
             // not use data_size, uncompressed image only use fiexed size.
-            int size_calc = width * height * image::fmt_size[format];
+            int size_calc = format == image::FMT_BITMAP ? _stride * height : width * height * image::fmt_size[format];
             if (data_size > 0 && data_size != size_calc)
             {
                 log::error("data_size not match image content size, data_size: %d, image content size: %d\n", data_size, size_calc);
@@ -396,15 +526,25 @@ namespace maix::image
 
         if (!data)
         {
-            _actual_data = malloc(_data_size + 0x1000);
-            if (!_actual_data)
-                throw err::Exception(err::ERR_NO_MEM, "malloc image data failed");
-            _data = (void *)(((uint64_t)_actual_data + 0x1000) & ~0xFFF);
+            _alloc_buffer(_data_size);
             // set background color
             if(bg.format == image::FMT_INVALID)
             {
                 // do nothing
             }
+            else if (_format == image::FMT_BITMAP)
+            {
+                int gray = bg.format == image::FMT_GRAYSCALE ? bg.gray : (bg.r + bg.g + bg.b) / 3;
+                memset(_data, 0, _data_size);
+                if (gray > 127)
+                {
+                    int words = _stride / 4;
+                    uint32_t tail = (_width & 31) ? ((1u << (_width & 31)) - 1) : 0xFFFFFFFFu;
+                    uint32_t *p = (uint32_t *)_data;
+                    for (int i = 0; i < words * _height; i++)
+                        p[i] = (i % words == words - 1) ? tail : 0xFFFFFFFFu;
+                }
+            }
             else if(bg.format == image::FMT_GRAYSCALE)
             {
                 memset(_data, bg.gray, _data_size);
@@ -451,13 +591,10 @@ namespace maix::image
             }
             else
             {
-                free(_actual_data);
-                _actual_data = NULL;
-                _data = NULL;
+                _release();
                 log::error("image bg format not support, format: %d\n", bg.format);
                 throw err::Exception(err::ERR_ARGS, "image bg format not support, use grayscale(recommend)/rgb/rgba");
             }
-            _is_malloc = true;
         }
         else
         {
@@ -469,13 +606,9 @@ namespace maix::image
             }
             else
             {
-                _actual_data = malloc(_data_size + 0x1000);
-                if (!_actual_data)
-                    throw std::bad_alloc();
-                _data = (void *)(((uint64_t)_actual_data + 0x1000) & ~0xFFF);
+                _alloc_buffer(_data_size);
                 memcpy(_data, data, _data_size);
                 // log::debug("malloc image data\n");
-                _is_malloc = true;
             }
         }
     }
@@ -485,6 +618,50 @@ namespace maix::image
         _create_image(width, height, format, data, data_size, copy, bg);
     }
 
+    Image::Image(int width, int height, image::Format format, uint8_t *data, int stride, const std::function<void()> &release)
+    {
+        _pack_data = nullptr;
+        _buf = nullptr;
+        _alpha_tiles = nullptr;
+        _data = nullptr;
+        _actual_data = nullptr;
+        _is_malloc = false;
+        if (format >= image::FMT_UNCOMPRESSED_MAX)
+        {
+            log::error("wrap external data not support format: %s\n", fmt_names[format].c_str());
+            throw err::Exception(err::ERR_ARGS, "wrap external data only support uncompressed format");
+        }
+        if (!data || width <= 0 || height <= 0)
+            throw err::Exception(err::ERR_ARGS, "image data, width and height are incorrect");
+        int stride_min = _stride_of(width, format);
+        if (stride == 0)
+            stride = stride_min;
+        if (stride != stride_min && !(stride > stride_min &&
+            (format == image::FMT_RGB888 || format == image::FMT_BGR888 || format == image::FMT_RGBA8888 || format == image::FMT_BGRA8888 ||
+             format == image::FMT_RGB565 || format == image::FMT_BGR565 || format == image::FMT_GRAYSCALE)))
+        {
+            log::error("stride %d not support for format %s, width %d\n", stride, fmt_names[format].c_str(), width);
+            throw err::Exception(err::ERR_ARGS, "stride not support");
+        }
+        _format = format;
+        _width = width;
+        _height = height;
+        _stride = stride;
+        _data_size = format == image::FMT_BITMAP ? stride_min * height : width * height * image::fmt_size[format];
+        _data = data;
+        _actual_data = data;
+        image_buffer_t *buf = new image_buffer_t();
+        buf->refs = 1;
+        buf->owners = 1;
+        buf->views = 0;
+        buf->version = 0;
+        buf->actual_data = data;
+        // release must not be empty, or external data will be freed by free()
+        buf->release = release ? release : [](){};
+        _buf = buf;
+        _is_malloc = true;
+    }
+
     Image::Image(int width, int height, image::Format format, const image::Color &bg)
     // Image::Image(int width, int height, image::Format format, Bytes *data, bool copy)
     {
@@ -498,55 +675,184 @@ namespace maix::image
 
     Image::~Image()
     {
-        if (_is_malloc)
-        {
-            // log::debug("free image data\n");
-            free(_actual_data);
-            _actual_data = NULL;
-            _data = NULL;
-        }
+        _release();
     }
 
     err::Err Image::update(int width, int height, image::Format format, uint8_t *data, int data_size, bool copy)
     {
-        if (_actual_data && _is_malloc)
-        {
-            // log::debug("free image data\n");
-            free(_actual_data);
-            _actual_data = NULL;
-            _data = NULL;
-        }
+        _release();
         _create_image(width, height, format, data, data_size, copy);
         return err::ERR_NONE;
     }
 
     void Image::operator=(const image::Image &img)
     {
-        if (_data)
-        {
-            if (_is_malloc)
-            {
-                log::info("free _actual_data");
-                free(_actual_data);
-                _actual_data = NULL;
-                _data = NULL;
-            }
-            else
-                throw err::Exception(err::ERR_NOT_IMPL, "not support copy image to not alloc data image");
-        }
+        if (this == &img)
+            return;
+        if (_data && !_is_malloc)
+            throw err::Exception(err::ERR_NOT_IMPL, "not support copy image to not alloc data image");
+        _release();
         _format = img._format;
         _width = img._width;
         _height = img._height;
-        _data_size = _width * _height * image::fmt_size[_format];
-        _actual_data = malloc(_data_size + 0x1000);
-        if (!_actual_data)
-            throw std::bad_alloc();
-        _data = (void *)(((uint64_t)_actual_data + 0x1000) & ~0xFFF);
-        memcpy(_data, img._data, _data_size);
-        _is_malloc = true;
+        _data_size = img._data_size;
+        if (img._buf && img._is_malloc && ((image_buffer_t *)img._buf)->views.load() == 0)
+        {
+            // share buffer, copy on write
+            image_buffer_t *buf = (image_buffer_t *)img._buf;
+            ++buf->refs;
+            ++buf->owners;
+            _buf = buf;
+            _actual_data = img._actual_data;
+            _data = img._data;
+            _stride = img._stride;
+            _is_malloc = true;
+            return;
+        }
+        _stride = _stride_of(_width, _format);
+        _alloc_buffer(_data_size);
+        if (img._stride == _stride)
+            memcpy(_data, img._data, _data_size);
+        else
+            _copy_rows(_data, _stride, img._data, img._stride, _stride, _height);
         // log::debug("malloc image data\n");
     }
 
+    image::Image *Image::share()
+    {
+        // buffer pinned by views, share it will see writes of views, so copy
+        if (!_buf || !_is_malloc || ((image_buffer_t *)_buf)->views.load() > 0)
+            return copy();
+        image_buffer_t *buf = (image_buffer_t *)_buf;
+        image::Image *ret = new image::Image();
+        ret->_width = _width;
+        ret->_height = _height;
+        ret->_format = _format;
+        ret->_stride = _stride;
+        ret->_data_size = _data_size;
+        ret->_data = _data;
+        ret->_actual_data = _actual_data;
+        ret->_is_malloc = true;
+        ret->_buf = buf;
+        ++buf->refs;
+        ++buf->owners;
+        return ret;
+    }
+
+    bool Image::is_shared()
+    {
+        return _buf && ((image_buffer_t *)_buf)->owners.load() > 1;
+    }
+
+    image::Image *Image::view(int x, int y, int w, int h)
+    {
+        bool full = x == 0 && y == 0 && w == _width && h == _height;
+        if (!full && !(_format == image::FMT_RGB888 || _format == image::FMT_BGR888 || _format == image::FMT_RGBA8888 || _format == image::FMT_BGRA8888 ||
+              _format == image::FMT_RGB565 || _format == image::FMT_BGR565 || _format == image::FMT_GRAYSCALE))
+        {
+            log::error("view not support format: %s\n", fmt_names[_format].c_str());
+            throw err::Exception(err::ERR_NOT_IMPL, "view not support format");
+        }
+        if (x < 0 || y < 0 || w <= 0 || h <= 0 || x + w > _width || y + h > _height)
+        {
+            log::error("view region (%d, %d, %d, %d) out of image (%d, %d)\n", x, y, w, h, _width, _height);
+            throw err::Exception(err::ERR_ARGS, "view region out of image");
+        }
+        // pin buffer to this image, views must not write to buffer shared with other owners
+        if (is_shared())
+            _cow();
+        int bpp = (int)image::fmt_size[_format];
+        image::Image *ret = new image::Image();
+        ret->_width = w;
+        ret->_height = h;
+        ret->_format = _format;
+        ret->_stride = _stride;
+        ret->_data_size = full ? _data_size : w * h * bpp;
+        ret->_data = (uint8_t *)_data + y * _stride + x * bpp;
+        ret->_actual_data = ret->_data;
+        ret->_is_malloc = false;
+        // view keep the buffer alive but not own it, so not trigger copy on write
+        if (_buf)
+        {
+            ret->_buf = _buf;
+            ++((image_buffer_t *)_buf)->refs;
+            ++((image_buffer_t *)_buf)->views;
+        }
+        return ret;
+    }
+
+    BufferInfo::~BufferInfo()
+    {
+        delete _ref;
+    }
+
+    image::BufferInfo *Image::buffer_info()
+    {
+        image::Image *ref = view(0, 0, _width, _height);
+        image::BufferInfo *info = new image::BufferInfo(ref);
+        info->ptr = ref->data();
+        info->readonly = false;
+        switch (_format)
+        {
+        case image::FMT_RGB888:
+        case image::FMT_BGR888:
+        case image::FMT_RGBA8888:
+        case image::FMT_BGRA8888:
+        {
+            int c = (int)image::fmt_size[_format];
+            info->itemsize = 1;
+            info->format = "B";
+            info->shape = {_height, _width, c};
+            info->strides = {_stride, c, 1};
+            break;
+        }
+        case image::FMT_GRAYSCALE:
+            info->itemsize = 1;
+            info->format = "B";
+            info->shape = {_height, _width};
+            info->strides = {_stride, 1};
+            break;
+        case image::FMT_RGB565:
+        case image::FMT_BGR565:
+            info->itemsize = 2;
+            info->format = "H";
+            info->shape = {_height, _width};
+            info->strides = {_stride, 2};
+            break;
+        default:
+            // YUV, BITMAP and compressed formats, export raw bytes
+            info->itemsize = 1;
+            info->format = "B";
+            info->shape = {_data_size};
+            info->strides = {1};
+            break;
+        }
+        return info;
+    }
+
+    void *Image::contiguous_data()
+    {
+        if (is_contiguous())
+            return _data;
+        if (!_pack_data)
+        {
+            _pack_data = malloc(_data_size);
+            if (!_pack_data)
+                throw err::Exception(err::ERR_NO_MEM, "malloc pack data failed");
+        }
+        int row_bytes = _width * (int)image::fmt_size[_format];
+        _copy_rows(_pack_data, row_bytes, _data, _stride, row_bytes, _height);
+        return _pack_data;
+    }
+
+    void Image::sync_contiguous_data()
+    {
+        if (is_contiguous() || !_pack_data)
+            return;
+        int row_bytes = _width * (int)image::fmt_size[_format];
+        _copy_rows(_data, _stride, _pack_data, row_bytes, row_bytes, _height);
+    }
+
     std::string Image::__str__()
     {
         char buf[128];
@@ -556,14 +862,97 @@ namespace maix::image
 
     Bytes *Image::to_bytes(bool copy)
     {
+        if (!is_contiguous())
+        {
+            if (!copy)
+                throw err::Exception(err::ERR_ARGS, "to_bytes: image is not continuous(e.g. a view), copy=false not support");
+            return new Bytes((uint8_t *)contiguous_data(), _data_size, true, true);
+        }
         if (copy)
             return new Bytes((uint8_t *)_data, _data_size, true, true);
         return new Bytes((uint8_t *)_data, _data_size, false, false);
     }
 
+    err::Err Image::_check_pixels_roi(std::vector<int> &roi, size_t size, int *bpp)
+    {
+        if (!(_format == image::FMT_RGB888 || _format == image::FMT_BGR888 || _format == image::FMT_RGBA8888 || _format == image::FMT_BGRA8888 ||
+              _format == image::FMT_RGB565 || _format == image::FMT_BGR565 || _format == image::FMT_GRAYSCALE))
+        {
+            log::error("pixels access not support format: %s\n", image::fmt_names[_format].c_str());
+            return err::ERR_NOT_IMPL;
+        }
+        if (roi.size() == 0)
+            roi = {0, 0, _width, _height};
+        if (roi.size() != 4 || roi[0] < 0 || roi[1] < 0 || roi[2] <= 0 || roi[3] <= 0 ||
+            roi[0] + roi[2] > _width || roi[1] + roi[3] > _height)
+        {
+            log::error("pixels roi invalid, should be [x, y, w, h] inside image\n");
+            return err::ERR_ARGS;
+        }
+        *bpp = (int)image::fmt_size[_format];
+        if (size < (size_t)roi[2] * roi[3] * *bpp)
+        {
+            log::error("pixels buffer size %d too small, need %d\n", (int)size, roi[2] * roi[3] * *bpp);
+            return err::ERR_ARGS;
+        }
+        return err::ERR_NONE;
+    }
+
+    Bytes *Image::get_pixels(std::vector<int> roi)
+    {
+        if (roi.size() == 0)
+            roi = {0, 0, _width, _height};
+        err::check_bool_raise(roi.size() == 4 && roi[2] > 0 && roi[3] > 0, "get_pixels: roi should be [x, y, w, h]");
+        Bytes *bytes = new Bytes(nullptr, roi[2] * roi[3] * (int)image::fmt_size[_format], true, true);
+        err::Err e = get_pixels(roi, bytes->data, bytes->buff_len);
+        if (e != err::ERR_NONE)
+        {
+            delete bytes;
+            throw err::Exception(e, "get_pixels failed");
+        }
+        return bytes;
+    }
+
+    err::Err Image::get_pixels(std::vector<int> roi, void *buff, size_t buff_size)
+    {
+        int bpp;
+        err::Err e = _check_pixels_roi(roi, buff_size, &bpp);
+        if (e != err::ERR_NONE)
+            return e;
+        int row_bytes = roi[2] * bpp;
+        _copy_rows(buff, row_bytes, (uint8_t *)_data + roi[1] * _stride + roi[0] * bpp, _stride, row_bytes, roi[3]);
+        return err::ERR_NONE;
+    }
+
+    err::Err Image::set_pixels(std::vector<int> roi, Bytes *data)
+    {
+        if (!data)
+            return err::ERR_ARGS;
+        return set_pixels(roi, data->data, data->data_len);
+    }
+
+    err::Err Image::set_pixels(std::vector<int> roi, const void *data, size_t size)
+    {
+        int bpp;
+        err::Err e = _check_pixels_roi(roi, size, &bpp);
+        if (e != err::ERR_NONE)
+            return e;
+        if (size != (size_t)roi[2] * roi[3] * bpp)
+        {
+            log::error("set_pixels data size %d not match roi, need %d\n", (int)size, roi[2] * roi[3] * bpp);
+            return err::ERR_ARGS;
+        }
+        _cow();
+        int row_bytes = roi[2] * bpp;
+        _copy_rows((uint8_t *)_data + roi[1] * _stride + roi[0] * bpp, _stride, data, row_bytes, row_bytes, roi[3]);
+        return err::ERR_NONE;
+    }
+
     tensor::Tensor *Image::to_tensor(bool chw, bool copy)
     {
-        void *data = _data;
+        if (!is_contiguous() && !copy)
+            throw err::Exception(err::Err::ERR_ARGS, "to_tensor: image is not continuous(e.g. a view), copy=false not support");
+        void *data = copy ? contiguous_data() : _data;
         std::vector<int> shape;
         tensor::Tensor *t = nullptr;
         if (_format == image::FMT_GRAYSCALE)
@@ -603,7 +992,12 @@ namespace maix::image
         else
         {
             if(!chw)
-                t = new tensor::Tensor(shape, tensor::UINT8, data);
+            {
+                // tensor hold a view to keep image buffer alive
+                image::Image *ref = view(0, 0, _width, _height);
+                // view may detach shared buffer, use its data
+                t = new tensor::Tensor(shape, tensor::UINT8, ref->data(), [ref]() { delete ref; });
+            }
             else
             {
                 throw err::Exception(err::Err::ERR_ARGS, "to_tensor: chw=true requires copy=true");
@@ -652,15 +1046,21 @@ namespace maix::image
         {
             throw err::Exception(err::Err::ERR_ARGS, "mean and scale size not same");
         }
+        // src row stride may not equal to width * channels(e.g. image created by view), so index src by row
+        int stride = _stride;
+        int row_size = _width * channels;
         bool normalize = !(mean.empty() || scale.empty());
         if(!normalize)
         {
             if(channels == 1 || !chw)
             {
                 #pragma omp parallel for
-                for (size_t i = 0; i < _height * _width * channels; ++i)
+                for (int h = 0; h < _height; h++)
                 {
-                    dst[i] = static_cast<float>(src[i]);
+                    const uint8_t *s = src + h * stride;
+                    float *d = dst + h * row_size;
+                    for (int i = 0; i < row_size; ++i)
+                        d[i] = static_cast<float>(s[i]);
                 }
             }
             else if(channels == 3) // chw
@@ -673,10 +1073,10 @@ namespace maix::image
                     for (int w = 0; w < _width; w++)
                     {
                             int offset = h * _width + w;
-                            int idx = offset * 3;
-                            dst[offset] = static_cast<float>(src[idx]);
-                            dst[offset + layer_size] = static_cast<float>(src[idx + 1]);
-                            dst[offset + layer_size_x2] = static_cast<float>(src[idx + 2]);
+                            const uint8_t *s = src + h * stride + w * 3;
+                            dst[offset] = static_cast<float>(s[0]);
+                            dst[offset + layer_size] = static_cast<float>(s[1]);
+                            dst[offset + layer_size_x2] = static_cast<float>(s[2]);
                     }
                 }
             }
@@ -691,11 +1091,11 @@ namespace maix::image
                     for (int w = 0; w < _width; w++)
                     {
                         int offset = h * _width + w;
-                        int idx = offset * 4;
-                        dst[offset] = static_cast<float>(src[idx]);
-                        dst[offset + layer_size] = static_cast<float>(src[idx + 1]);
-                        dst[offset + layer_size_x2] = static_cast<float>(src[idx + 2]);
-                        dst[offset + layer_size_x3] = static_cast<float>(src[idx + 3]);
+                        const uint8_t *s = src + h * stride + w * 4;
+                        dst[offset] = static_cast<float>(s[0]);
+                        dst[offset + layer_size] = static_cast<float>(s[1]);
+                        dst[offset + layer_size_x2] = static_cast<float>(s[2]);
+                        dst[offset + layer_size_x3] = static_cast<float>(s[3]);
                     }
                 }
             }
@@ -721,10 +1121,13 @@ namespace maix::image
             {
                 if(channels == 1)
                 {
-                    #pragma omp parallel for
-                    for (int i = 0; i < _height * _width; ++i)
+                    #pragma omp parallel for collapse(2)
+                    for (int h = 0; h < _height; h++)
                     {
-                        dst[i] = (static_cast<float>(src[i]) - mean[0]) * scale[0];
+                        for (int w = 0; w < _width; w++)
+                        {
+                            dst[h * _width + w] = (static_cast<float>(src[h * stride + w]) - mean[0]) * scale[0];
+                        }
                     }
                 }
                 else if(channels == 3)
@@ -735,9 +1138,10 @@ namespace maix::image
                         for (int w = 0; w < _width; w++)
                         {
                                 int idx = (h * _width + w) * 3;
-                                dst[idx] = (static_cast<float>(src[idx]) - mean[0]) * scale[0];
-                                dst[idx + 1] = (static_cast<float>(src[idx + 1]) - mean[1]) * scale[1];
-                                dst[idx + 2] = (static_cast<float>(src[idx + 2]) - mean[2]) * scale[2];
+                                const uint8_t *s = src + h * stride + w * 3;
+                                dst[idx] = (static_cast<float>(s[0]) - mean[0]) * scale[0];
+                                dst[idx + 1] = (static_cast<float>(s[1]) - mean[1]) * scale[1];
+                                dst[idx + 2] = (static_cast<float>(s[2]) - mean[2]) * scale[2];
                         }
                     }
                 }
@@ -749,10 +1153,11 @@ namespace maix::image
                         for (int w = 0; w < _width; w++)
                         {
                             int idx = (h * _width + w) * 4;
-                            dst[idx] = (static_cast<float>(src[idx]) - mean[0]) * scale[0];
-                            dst[idx + 1] = (static_cast<float>(src[idx + 1]) - mean[1]) * scale[1];
-                            dst[idx + 2] = (static_cast<float>(src[idx + 2]) - mean[2]) * scale[2];
-                            dst[idx + 3] = (static_cast<float>(src[idx + 3]) - mean[3]) * scale[3];
+                            const uint8_t *s = src + h * stride + w * 4;
+                            dst[idx] = (static_cast<float>(s[0]) - mean[0]) * scale[0];
+                            dst[idx + 1] = (static_cast<float>(s[1]) - mean[1]) * scale[1];
+                            dst[idx + 2] = (static_cast<float>(s[2]) - mean[2]) * scale[2];
+                            dst[idx + 3] = (static_cast<float>(s[3]) - mean[3]) * scale[3];
                         }
                     }
                 }
@@ -767,10 +1172,10 @@ namespace maix::image
                     for (int w = 0; w < _width; w++)
                     {
                             int offset = h * _width + w;
-                            int idx = offset * 3;
-                            dst[offset] = (static_cast<float>(src[idx]) - mean[0]) * scale[0];
-                            dst[offset + layer_size] = (static_cast<float>(src[idx + 1]) - mean[1]) * scale[1];
-                            dst[offset + layer_size_x2] = (static_cast<float>(src[idx + 2]) - mean[2]) * scale[2];
+                            const uint8_t *s = src + h * stride + w * 3;
+                            dst[offset] = (static_cast<float>(s[0]) - mean[0]) * scale[0];
+                            dst[offset + layer_size] = (static_cast<float>(s[1]) - mean[1]) * scale[1];
+                            dst[offset + layer_size_x2] = (static_cast<float>(s[2]) - mean[2]) * scale[2];
                     }
                 }
             }
@@ -785,18 +1190,17 @@ namespace maix::image
                     for (int w = 0; w < _width; w++)
                     {
                         int offset = h * _width + w;
-                        int idx = offset * 4;
-                        dst[offset] = (static_cast<float>(src[idx]) - mean[0]) * scale[0];
-                        dst[offset + layer_size] = (static_cast<float>(src[idx + 1]) - mean[1]) * scale[1];
-                        dst[offset + layer_size_x2] = (static_cast<float>(src[idx + 2]) - mean[2]) * scale[2];
-                        dst[offset + layer_size_x3] = (static_cast<float>(src[idx + 3]) - mean[3]) * scale[3];
+                        const uint8_t *s = src + h * stride + w * 4;
+                        dst[offset] = (static_cast<float>(s[0]) - mean[0]) * scale[0];
+                        dst[offset + layer_size] = (static_cast<float>(s[1]) - mean[1]) * scale[1];
+                        dst[offset + layer_size_x2] = (static_cast<float>(s[2]) - mean[2]) * scale[2];
+                        dst[offset + layer_size_x3] = (static_cast<float>(s[3]) - mean[3]) * scale[3];
                     }
                 }
             }
         }
     }
 
-
     tensor::Tensor *Image::to_tensor_float32(bool chw, std::vector<float> mean, std::vector<float> scale)
     {
         tensor::Tensor *result = nullptr;
@@ -811,7 +1215,12 @@ namespace maix::image
             log::error("convert format failed, already the format %d\n", format);
             throw err::Exception(err::ERR_ARGS, "convert format failed, already the format");
         }
-        cv::Mat src(_format > FMT_COMPRESSED_MIN ? 1 : _height, _format > FMT_COMPRESSED_MIN ? _data_size : _width, CV_8UC((int)image::fmt_size[_format]), _data);
+        if (_format == image::FMT_BITMAP || format == image::FMT_BITMAP)
+        {
+            return _bitmap_to_format(this, format, buff, buff_size);
+        }
+        cv::Mat src(_format > FMT_COMPRESSED_MIN ? 1 : _height, _format > FMT_COMPRESSED_MIN ? _data_size : _width, CV_8UC((int)image::fmt_size[_format]), _data,
+                    _format > FMT_COMPRESSED_MIN ? cv::Mat::AUTO_STEP : (size_t)_stride);
         cv::ColorConversionCodes cvt_code;
 
         // special for convert to jpeg and png
@@ -1088,7 +1497,7 @@ namespace maix::image
             cv::Mat dst(src.rows * 3 / 2, src.cols, CV_8UC((int)image::fmt_size[format]), img->data());
             int nv_len = src.cols * src.rows / 2;
             int offset = src.cols * src.rows;
-            memcpy(dst.data, src.data, src.cols * src.rows);
+            _copy_rows(dst.data, src.cols, src.data, src.step, src.cols, src.rows);
             memset(dst.data + offset, 128, nv_len);
         }
         else if (format == image::FMT_YVU420SP)
@@ -1113,24 +1522,20 @@ namespace maix::image
         }
         else if (_format == image::FMT_RGB888 && format == image::FMT_GRAYSCALE)
         {
-            int height = _width;
-            int width = _height;
             uint8_t *src = (uint8_t *)_data;
             uint8_t *dst = (uint8_t *)img->data();
 #if CONFIG_OMP_ENABLE
             #pragma omp parallel for
-            for (int i = 0; i < width * height; i ++) {
-                dst[i] = (src[i * 3 + 0] * 38 + src[i * 3 + 1] * 75 + src[i * 3 + 2] * 15) >> 7;
-            }
-#else
-            for (int i = 0; i < height; i++)
+#endif
+            for (int i = 0; i < _height; i++)
             {
-                for (int j = 0; j < width; j++)
+                const uint8_t *s = src + i * _stride;
+                uint8_t *d = dst + i * _width;
+                for (int j = 0; j < _width; j++)
                 {
-                    dst[i * width + j] = (src[(i * width + j) * 3 + 0] * 38 + src[(i * width + j) * 3 + 1] * 75 + src[(i * width + j) * 3 + 2] * 15) >> 7;
+                    d[j] = (s[j * 3 + 0] * 38 + s[j * 3 + 1] * 75 + s[j * 3 + 2] * 15) >> 7;
                 }
             }
-#endif
         }
         else
         {
@@ -1148,10 +1553,18 @@ namespace maix::image
 
     image::Image *Image::to_jpeg(int quality, void *buff, size_t buff_size)
     {
-        image::Format format = image::Format::FMT_JPEG;
-
-        cv::Mat src(_height, _width, CV_8UC((int)image::fmt_size[_format]), _data);
+#if defined(PLATFORM_MAIXCAM) || defined(PLATFORM_MAIXCAM2)
+        // hardware encoder need continuous data
+        if (!is_contiguous())
+        {
+            image::Image *tmp = copy();
+            image::Image *ret = tmp->to_jpeg(quality, buff, buff_size);
+            delete tmp;
+            return ret;
+        }
+#endif
 #if defined(PLATFORM_MAIXCAM)
+        image::Format format = image::Format::FMT_JPEG;
         quality = quality < 51 ? 51 : quality;
         quality = quality > 99 ? 99 : quality;
         image::Image *p_img = nullptr;
@@ -1186,6 +1599,7 @@ namespace maix::image
             throw err::Exception(err::ERR_RUNTIME, "convert format failed, see log");
         return img;
 #elif defined(PLATFORM_MAIXCAM2)
+        image::Format format = image::Format::FMT_JPEG;
         image::Image *p_img = nullptr;
         image::Image *img = nullptr;
         maixcam2::Frame *src_frame = nullptr, *out_frame = nullptr;
@@ -1232,45 +1646,10 @@ __EXIT:
         }
         return img;
 #else
-        // soft convert, slower
-        image::Image *p_img = nullptr;
-        cv::Mat *p_src = &src;
-        bool src_alloc = false;
-        if (_format != Format::FMT_BGR888 && _format != Format::FMT_BGRA8888)
-        {
-            p_img = to_format(image::FMT_BGR888);
-            p_src = new cv::Mat(p_img->_height, p_img->_width, CV_8UC((int)image::fmt_size[image::FMT_BGR888]), p_img->_data);
-            src_alloc = true;
-        }
-        cv::InputArray input(*p_src);
-        std::vector<uchar> jpeg_buff;
-        std::vector<int> params;
-        params.push_back(cv::IMWRITE_JPEG_QUALITY);
-        params.push_back(quality);
-        cv::imencode(".jpg", input, jpeg_buff, params);
-        image::Image *img;
-        if (buff)
-        {
-            if (buff_size < jpeg_buff.size())
-            {
-                if (src_alloc)
-                {
-                    delete p_img;
-                    delete p_src;
-                }
-                throw err::Exception(err::ERR_ARGS, "convert format failed, buffer size not enough");
-            }
-            memcpy(buff, jpeg_buff.data(), jpeg_buff.size());
-            img = new image::Image(src.cols, src.rows, format, (uint8_t *)buff, jpeg_buff.size(), false);
-        }
-        else
-            img = new image::Image(src.cols, src.rows, format, (uint8_t *)jpeg_buff.data(), jpeg_buff.size(), true);
-        if (src_alloc)
-        {
-            delete p_img;
-            delete p_src;
-        }
-        return img;
+        // libjpeg encoder, keep encoder context and output buffer per thread to avoid init encoder every call
+        static thread_local image::JpegEncoder encoder;
+        encoder.set_quality(quality);
+        return encoder.encode(*this, buff, buff_size);
 #endif
         return nullptr;
     }
@@ -1284,17 +1663,30 @@ __EXIT:
         return cv::Rect(newX, newY, newWidth, newHeight);
     }
 
-    image::Image *Image::draw_image(int x, int y, image::Image &img)
+    image::Image *Image::draw_image(int x, int y, image::Image &img, bool premultiplied)
     {
+        _cow();
         image::Format fmt = img.format();
         if (!(fmt == image::FMT_GRAYSCALE || fmt == image::FMT_RGB888 || fmt == image::FMT_BGR888 ||
               fmt == image::FMT_RGBA8888 || fmt == image::FMT_BGRA8888))
             throw std::runtime_error("image format not support");
+        // alpha blend directly to destination format, no convert
+        if ((fmt == image::FMT_RGBA8888 || fmt == image::FMT_BGRA8888) &&
+            (_format == image::FMT_RGB888 || _format == image::FMT_BGR888 || _format == image::FMT_RGBA8888 || _format == image::FMT_BGRA8888 ||
+             _format == image::FMT_GRAYSCALE || _format == image::FMT_YVU420SP || _format == image::FMT_YUV420SP))
+        {
+            int x0 = std::max(0, x), y0 = std::max(0, y);
+            int x1 = std::min(_width, x + img.width()), y1 = std::min(_height, y + img.height());
+            if (x1 <= x0 || y1 <= y0)
+                throw err::Exception(err::ERR_ARGS, "range error");
+            _draw_image_alpha(x0, y0, x0 - x, y0 - y, x1 - x0, y1 - y0, img, premultiplied);
+            return this;
+        }
         // check format
         if (image::fmt_size[img.format()] > image::fmt_size[_format])
             throw std::runtime_error("image format not match");
-        cv::Mat src(img.height(), img.width(), CV_8UC((int)image::fmt_size[img.format()]), img.data());
-        cv::Mat dst(_height, _width, CV_8UC((int)image::fmt_size[_format]), _data);
+        cv::Mat src(img.height(), img.width(), CV_8UC((int)image::fmt_size[img.format()]), img.data(), img.stride());
+        cv::Mat dst(_height, _width, CV_8UC((int)image::fmt_size[_format]), _data, _stride);
         cv::Rect rect(x, y, img.width(), img.height());
         cv::Rect adjustedRect = _adjustRectToFit(rect, dst.size());
         int srcX = std::max(0, -x);
@@ -1304,7 +1696,7 @@ __EXIT:
         {
             throw err::Exception(err::ERR_ARGS, "range error");
         }
-        if (_format == fmt && image::fmt_size[fmt] < 4)
+        if (_format == fmt)
         {
             src(srcRect).copyTo(dst(adjustedRect));
         }
@@ -1324,45 +1716,8 @@ __EXIT:
             }
             else
                 img_new = &img;
-            cv::Mat src_new(img_new->height(), img_new->width(), CV_8UC((int)image::fmt_size[_format]), img_new->data());
-            if (image::fmt_size[_format] < 4)
-            {
-                src_new(srcRect).copyTo(dst(adjustedRect));
-            }
-            else // merge two BGRA images
-            {
-                uint8_t *data = (uint8_t *)_data;
-                #pragma omp parallel for
-                for (int y = 0; y < adjustedRect.height; y++)
-                {
-                    for (int x = 0; x < adjustedRect.width; x++)
-                    {
-                        cv::Vec4b &pixel = src_new.at<cv::Vec4b>(y + srcY, x + srcX);
-                        // ignore transparent pixel
-                        if (pixel[3] == 0)
-                            continue;
-                        // cv::Vec4b &pixel_dst = dst.at<cv::Vec4b>(y + adjustedRect.y, x + adjustedRect.x);
-                        // alpha is 255, just copy
-                        uint8_t *p = data + (_width * (y + adjustedRect.y) + (x + adjustedRect.x)) * 4;
-                        if (pixel[3] == 255)
-                        {
-                            p[0] = pixel[0];
-                            p[1] = pixel[1];
-                            p[2] = pixel[2];
-                            p[3] = pixel[3];
-                        }
-                        // alpha > 0 and < 255, blend
-                        else
-                        {
-                            // TODO: optimize blend algorithm
-                            p[0] = (uint32_t)((pixel[0] * pixel[3] + p[0] * (255 - pixel[3]))) >> 8;
-                            p[1] = (uint32_t)((pixel[1] * pixel[3] + p[1] * (255 - pixel[3]))) >> 8;
-                            p[2] = (uint32_t)((pixel[2] * pixel[3] + p[2] * (255 - pixel[3]))) >> 8;
-                            p[3] = 255 - (255 - pixel[3]) * (255 - p[3]);
-                        }
-                    }
-                }
-            }
+            cv::Mat src_new(img_new->height(), img_new->width(), CV_8UC((int)image::fmt_size[_format]), img_new->data(), img_new->stride());
+            src_new(srcRect).copyTo(dst(adjustedRect));
             if (img_alloc)
                 delete img_new;
         }
@@ -1371,10 +1726,11 @@ __EXIT:
 
     image::Image *Image::draw_rect(int x, int y, int w, int h, const image::Color &color, int thickness)
     {
+        _cow();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
-        cv::Mat img(_height, _width, ch_format, _data);
+        cv::Mat img(_height, _width, ch_format, _data, _stride);
         cv::Rect rect(x, y, w, h);
         if (color.alpha != 1 && (_format == Format::FMT_RGBA8888 || _format == Format::FMT_BGRA8888))
         {
@@ -1389,30 +1745,33 @@ __EXIT:
 
     image::Image *Image::draw_line(int x1, int y1, int x2, int y2, const image::Color &color, int thickness)
     {
+        _cow();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
-        cv::Mat img(_height, _width, ch_format, _data);
+        cv::Mat img(_height, _width, ch_format, _data, _stride);
         cv::line(img, cv::Point(x1, y1), cv::Point(x2, y2), cv_color, thickness);
         return this;
     }
 
     image::Image *Image::draw_circle(int x, int y, int radius, const image::Color &color, int thickness)
     {
+        _cow();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
-        cv::Mat img(_height, _width, ch_format, _data);
+        cv::Mat img(_height, _width, ch_format, _data, _stride);
         cv::circle(img, cv::Point(x, y), radius, cv_color, thickness);
         return this;
     }
 
     image::Image *Image::draw_ellipse(int x, int y, int a, int b, float angle, float start_angle, float end_angle, const image::Color &color, int thickness)
     {
+        _cow();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
-        cv::Mat img(_height, _width, ch_format, _data);
+        cv::Mat img(_height, _width, ch_format, _data, _stride);
         cv::ellipse(img, cv::Point(x, y), cv::Size(a, b), angle, start_angle, end_angle, cv_color, thickness);
         return this;
     }
@@ -1420,11 +1779,12 @@ __EXIT:
     image::Image *image::Image::draw_string(int x, int y, const std::string &text, const image::Color &color, float scale, int thickness,
                                             bool wrap, int wrap_space, const std::string &font)
     {
+        _cow();
         int ch_format = 0;
         cv::Scalar cv_color;
         add_default_fonts(fonts_info);
         _get_cv_format_color(_format, color, &ch_format, cv_color);
-        cv::Mat img(_height, _width, ch_format, _data);
+        cv::Mat img(_height, _width, ch_format, _data, _stride);
         cv::Point point(x, y);
         const std::string *final_font = &curr_font_name;
         int final_font_id = curr_font_id;
@@ -1538,10 +1898,11 @@ __EXIT:
 
     image::Image *Image::draw_cross(int x, int y, const image::Color &color, int size, int thickness)
     {
+        _cow();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
-        cv::Mat img(_height, _width, ch_format, _data);
+        cv::Mat img(_height, _width, ch_format, _data, _stride);
         cv::line(img, cv::Point(x - size, y), cv::Point(x + size, y), cv_color, thickness);
         cv::line(img, cv::Point(x, y - size), cv::Point(x, y + size), cv_color, thickness);
         return this;
@@ -1549,10 +1910,11 @@ __EXIT:
 
     image::Image *Image::draw_arrow(int x0, int y0, int x1, int y1, const image::Color &color, int thickness)
     {
+        _cow();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
-        cv::Mat img(_height, _width, ch_format, _data);
+        cv::Mat img(_height, _width, ch_format, _data, _stride);
         cv::Point start(x0, y0);
         cv::Point end(x1, y1);
         cv::arrowedLine(img, start, end, cv_color, thickness);
@@ -1561,10 +1923,11 @@ __EXIT:
 
     image::Image *Image::draw_edges(std::vector<std::vector<int>> corners, const image::Color &color, int size, int thickness, bool fill)
     {
+        _cow();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
-        cv::Mat img(_height, _width, ch_format, _data);
+        cv::Mat img(_height, _width, ch_format, _data, _stride);
 
         if (corners.size() < 4)
         {
@@ -1585,10 +1948,11 @@ __EXIT:
 
     image::Image *Image::draw_keypoints(const std::vector<int> &keypoints, const image::Color &color, int size, int thickness, int line_thickness)
     {
+        _cow();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
-        cv::Mat img(_height, _width, ch_format, _data);
+        cv::Mat img(_height, _width, ch_format, _data, _stride);
 
         if (keypoints.size() < 2 || keypoints.size() % 2 != 0)
         {
@@ -1677,7 +2041,7 @@ __EXIT:
         }
         image::Image *ret = new image::Image(width, height, _format);
 
-        cv::Mat img(cv_h, _width, pixel_num, _data);
+        cv::Mat img(cv_h, _width, pixel_num, _data, _stride);
         cv::Mat dst;
         cv::InterpolationFlags inter_method = (cv::InterpolationFlags)method;
         if (object_fit == image::Fit::FIT_FILL)
@@ -1776,7 +2140,7 @@ __EXIT:
         }
         image::Image *ret = new image::Image(width, height, _format);
         ;
-        cv::Mat img(_height, _width, pixel_num, _data);
+        cv::Mat img(_height, _width, pixel_num, _data, _stride);
         cv::Mat dst(height, width, pixel_num, ret->data());
         cv::Point2f srcTri[3];
         cv::Point2f dstTri[3];
@@ -1828,7 +2192,7 @@ __EXIT:
         cv::Mat warp_mat = cv::getPerspectiveTransform(srcPts, dstPts);
 
         // Apply the perspective transform to the image
-        cv::Mat img(_height, _width, pixel_num, _data);
+        cv::Mat img(_height, _width, pixel_num, _data, _stride);
         cv::Mat dst(height, width, pixel_num, ret->data());
 
         cv::warpPerspective(img, dst, warp_mat, dst.size(), (cv::InterpolationFlags)method);
@@ -1839,6 +2203,11 @@ __EXIT:
     image::Image *Image::copy()
     {
         image::Image *ret = new image::Image(_width, _height, _format);
+        if (!is_contiguous())
+        {
+            _copy_rows(ret->data(), ret->stride(), _data, _stride, ret->stride(), _height);
+            return ret;
+        }
 
 #if defined(PLATFORM_MAIXCAM2)
         auto src = (uint8_t *)_data;
@@ -1852,7 +2221,7 @@ __EXIT:
         memcpy(dst + copy_size, src + copy_size, copy_size);
 }
 #else
-        memcpy(ret->data(), _data, _width * _height * image::fmt_size[_format]);
+        memcpy(ret->data(), _data, ret->data_size());
 #endif
         return ret;
     }
@@ -1862,7 +2231,7 @@ __EXIT:
         image::Image *ret = new image::Image(w, h, _format);
         ;
         int pixel_num = _get_cv_pixel_num(_format);
-        cv::Mat img(_height, _width, pixel_num, _data);
+        cv::Mat img(_height, _width, pixel_num, _data, _stride);
         cv::Mat dst(h, w, pixel_num, ret->data());
         cv::Rect rect(x, y, w, h);
         img(rect).copyTo(dst);
@@ -1893,7 +2262,7 @@ __EXIT:
         }
         image::Image *ret = new image::Image(width, height, _format);
         ;
-        cv::Mat img(_height, _width, pixel_num, _data);
+        cv::Mat img(_height, _width, pixel_num, _data, _stride);
         cv::Mat dst(height, width, pixel_num, ret->data());
         cv::Point2f center((float)_width / 2.0, (float)_height / 2.0);
         cv::Mat rot_mat = cv::getRotationMatrix2D(center, angle, 1.0);
@@ -1909,7 +2278,7 @@ __EXIT:
     {
         int pixel_num = _get_cv_pixel_num(_format);
         Image *ret = new Image(_width, _height, _format);
-        cv::Mat img(_height, _width, pixel_num, _data);
+        cv::Mat img(_height, _width, pixel_num, _data, _stride);
         cv::Mat dst(_height, _width, pixel_num, ret->data());
 
         int flipCode;
@@ -1938,7 +2307,14 @@ __EXIT:
             log::error("save image failed, image size is invalid\n");
             return err::ERR_ARGS;
         }
-        cv::Mat img(_height, _width, CV_8UC((int)image::fmt_size[_format]), _data);
+        if (_format == image::FMT_BITMAP)
+        {
+            image::Image *gray = to_format(image::FMT_GRAYSCALE);
+            err::Err e = gray->save(path, quality);
+            delete gray;
+            return e;
+        }
+        cv::Mat img(_height, _width, CV_8UC((int)image::fmt_size[_format]), _data, _stride);
         std::vector<int> params;
         if (quality >= 0 && quality <= 100)
         {
@@ -1980,19 +2356,24 @@ __EXIT:
                 return err::ERR_RUNTIME;
             break;
         case FMT_RGB888:
-            cv::cvtColor(img, img, cv::COLOR_RGB2BGR);
-            ok = cv::imwrite(path, img, params);
-            cv::cvtColor(img, img, cv::COLOR_RGB2BGR);
+        {
+            // convert to new mat, not modify data in place, data may be shared with other images
+            cv::Mat bgr;
+            cv::cvtColor(img, bgr, cv::COLOR_RGB2BGR);
+            ok = cv::imwrite(path, bgr, params);
             if (!ok)
                 return err::ERR_RUNTIME;
             break;
+        }
         case FMT_RGBA8888:
-            cv::cvtColor(img, img, cv::COLOR_RGBA2BGRA);
-            ok = cv::imwrite(path, img, params);
-            cv::cvtColor(img, img, cv::COLOR_RGBA2BGRA);
+        {
+            cv::Mat bgra;
+            cv::cvtColor(img, bgra, cv::COLOR_RGBA2BGRA);
+            ok = cv::imwrite(path, bgra, params);
             if (!ok)
                 return err::ERR_RUNTIME;
             break;
+        }
         case FMT_YVU420SP:
         {
             cv::Mat bgr;
@@ -2095,6 +2476,39 @@ __EXIT:
         return Size(size.width, size.height);
     }
 
+    /**
+     * cv::Mat allocator for mat share data with image::Image, userdata of UMatData is an image view keep the buffer alive.
+     * New allocation(e.g. mat.create with other size) use opencv's default allocator.
+     */
+    class ImageMatAllocator : public cv::MatAllocator
+    {
+    public:
+        cv::UMatData *allocate(int dims, const int *sizes, int type, void *data, size_t *step, cv::AccessFlag flags, cv::UMatUsageFlags usage_flags) const override
+        {
+            return cv::Mat::getDefaultAllocator()->allocate(dims, sizes, type, data, step, flags, usage_flags);
+        }
+
+        bool allocate(cv::UMatData *data, cv::AccessFlag access_flags, cv::UMatUsageFlags usage_flags) const override
+        {
+            return cv::Mat::getDefaultAllocator()->allocate(data, access_flags, usage_flags);
+        }
+
+        void deallocate(cv::UMatData *u) const override
+        {
+            if (!u)
+                return;
+            CV_Assert(u->urefcount >= 0);
+            CV_Assert(u->refcount >= 0);
+            if (u->refcount == 0)
+            {
+                delete (image::Image *)u->userdata;
+                delete u;
+            }
+        }
+    };
+
+    static ImageMatAllocator _image_mat_allocator;
+
     err::Err image2cv(image::Image &img, cv::Mat &mat, bool ensure_bgr, bool copy)
     {
         int width = img.width();
@@ -2107,62 +2521,51 @@ __EXIT:
             log::error("image2cv arg error");
             return err::Err::ERR_ARGS;
         }
+        if (channels != 1 && channels != 3 && channels != 4)
+        {
+            log::error("not support channel num %d", channels);
+            return err::Err::ERR_ARGS;
+        }
 
+        // use image stride, so image created by Image.view can be used directly
+        cv::Mat src(height, width, CV_8UC(channels), (void *)img_data, img.stride());
+        if (!copy)
+        {
+            // mat hold a view of img, so img's buffer is alive until the last mat share the data released
+            // view may detach shared buffer, use its data
+            image::Image *ref = img.view(0, 0, width, height);
+            img_data = (uint8_t *)ref->data();
+            src = cv::Mat(height, width, CV_8UC(channels), (void *)img_data, img.stride());
+            cv::UMatData *u = new cv::UMatData(&_image_mat_allocator);
+            u->data = u->origdata = img_data;
+            u->size = (size_t)img.stride() * (height - 1) + width * channels;
+            u->userdata = ref;
+            src.u = u;
+            src.addref();
+            src.allocator = &_image_mat_allocator;
+            mat = src;
+            return err::ERR_NONE;
+        }
         if (channels == 1)
         {
-            if (copy)
-            {
-                mat = cv::Mat(height, width, CV_8UC1);
-                if(ensure_bgr)
-                {
-                    cv::cvtColor(mat, mat, cv::COLOR_GRAY2BGR);
-                }
-                else
-                {
-                    memcpy(mat.data, img_data, width * height);
-                }
-            }
+            if(ensure_bgr)
+                cv::cvtColor(src, mat, cv::COLOR_GRAY2BGR);
             else
-            {
-                mat = cv::Mat(height, width, CV_8UC1, (void *)img_data);
-            }
+                mat = src.clone();
         }
         else if (channels == 3)
         {
-            if (copy)
-            {
-                mat = cv::Mat(height, width, CV_8UC3);
-                memcpy(mat.data, img_data, width * height * 3);
-                if(ensure_bgr && img.format() == image::FMT_RGB888)
-                {
-                    cv::cvtColor(mat, mat, cv::COLOR_RGB2BGR);
-                }
-            }
+            if(ensure_bgr && img.format() == image::FMT_RGB888)
+                cv::cvtColor(src, mat, cv::COLOR_RGB2BGR);
             else
-            {
-                mat = cv::Mat(height, width, CV_8UC3, (void *)img_data);
-            }
-        }
-        else if (channels == 4)
-        {
-            if (copy)
-            {
-                mat = cv::Mat(height, width, CV_8UC4);
-                memcpy(mat.data, img_data, width * height * 4);
-                if(ensure_bgr && img.format() == image::FMT_RGBA8888)
-                {
-                    cv::cvtColor(mat, mat, cv::COLOR_RGBA2BGRA);
-                }
-            }
-            else
-            {
-                mat = cv::Mat(height, width, CV_8UC4, (void *)img_data);
-            }
+                mat = src.clone();
         }
         else
         {
-            log::error("not support channel num %d", channels);
-            return err::Err::ERR_ARGS;
+            if(ensure_bgr && img.format() == image::FMT_RGBA8888)
+                cv::cvtColor(src, mat, cv::COLOR_RGBA2BGRA);
+            else
+                mat = src.clone();
         }
         return err::ERR_NONE;
     }
@@ -2190,6 +2593,23 @@ __EXIT:
             log::error("not support channel num %d", channels);
             return nullptr;
         }
+        if (mat.depth() != CV_8U || mat.dims != 2)
+        {
+            log::error("only support 2 dims CV_8U mat, depth: %d, dims: %d", mat.depth(), mat.dims);
+            return nullptr;
+        }
+        if (!copy)
+        {
+            // image hold a mat header to keep mat's data alive, rows can have stride(e.g. mat is a roi)
+            cv::Mat *ref = new cv::Mat(mat);
+            return new image::Image(width, height, format, mat.data, (int)mat.step[0], [ref]() { delete ref; });
+        }
+        if (!mat.isContinuous())
+        {
+            image::Image *img = new image::Image(width, height, format);
+            _copy_rows(img->data(), img->stride(), mat.data, (int)mat.step[0], width * channels, height);
+            return img;
+        }
         return new image::Image(width, height, format, mat.data, width * height * channels, copy);
     }
 
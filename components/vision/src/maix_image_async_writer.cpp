@@ -0,0 +1,454 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add AsyncWriter, save images in background thread.
+ */
+
+#include "maix_image_async_writer.hpp"
+#include "maix_image_jpeg.hpp"
+#include "maix_fs.hpp"
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace maix::image
+{
+    typedef struct
+    {
+        image::Image *img;
+        std::string path;
+        int quality;
+        size_t bytes;
+    } async_writer_task_t;
+
+    typedef struct
+    {
+        size_t max_bytes;
+        int max_pending;
+        image::AsyncWriterPolicy policy;
+        int sync_batch;
+
+        std::mutex lock;
+        std::condition_variable cond_task;  // new task or closed
+        std::condition_variable cond_space; // budget released
+        std::condition_variable cond_done;  // all tasks done
+        std::deque<async_writer_task_t> queue;
+        std::vector<std::string> drops; // paths of images dropped by ASYNC_WRITER_DROP_OLD, notified in worker thread
+        size_t bytes;       // bytes of queued and writing images
+        int inflight;       // queued + writing + written but not synced
+        int dropped;
+        int failed;
+        bool closed;
+        std::function<void(const std::string &, err::Err)> callback;
+        std::thread *thread;
+
+        // only used by worker thread
+        image::JpegEncoder *encoder;
+        std::vector<int> unsynced_fds;
+        std::vector<std::string> unsynced_paths;
+    } async_writer_t;
+
+    static bool _path_is_jpeg(const std::string &path)
+    {
+        size_t pos = path.find_last_of('.');
+        if (pos == std::string::npos)
+            return false;
+        std::string ext = path.substr(pos);
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c)
+                       { return std::tolower(c); });
+        return ext == ".jpg" || ext == ".jpeg";
+    }
+
+    static err::Err _write_all(int fd, const uint8_t *data, size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t n = ::write(fd, data, size);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return err::ERR_WRITE;
+            }
+            data += n;
+            size -= n;
+        }
+        return err::ERR_NONE;
+    }
+
+    static void _notify(async_writer_t *w, const std::string &path, err::Err e)
+    {
+        std::function<void(const std::string &, err::Err)> cb;
+        {
+            std::lock_guard<std::mutex> guard(w->lock);
+            cb = w->callback;
+        }
+        if (cb)
+        {
+            try
+            {
+                cb(path, e);
+            }
+            catch (std::exception &ex)
+            {
+                log::error("AsyncWriter callback error: %s\n", ex.what());
+            }
+        }
+        std::lock_guard<std::mutex> guard(w->lock);
+        --w->inflight;
+        if (w->inflight == 0)
+            w->cond_done.notify_all();
+    }
+
+    static void _sync(async_writer_t *w)
+    {
+        std::vector<std::string> paths;
+        std::vector<err::Err> rets;
+        for (size_t i = 0; i < w->unsynced_fds.size(); ++i)
+        {
+            int fd = w->unsynced_fds[i];
+            err::Err e = err::ERR_NONE;
+            if (fd < 0 || fsync(fd) != 0)
+                e = err::ERR_IO;
+            if (fd >= 0)
+                ::close(fd);
+            paths.push_back(w->unsynced_paths[i]);
+            rets.push_back(e);
+        }
+        w->unsynced_fds.clear();
+        w->unsynced_paths.clear();
+        for (size_t i = 0; i < paths.size(); ++i)
+        {
+            if (rets[i] != err::ERR_NONE)
+            {
+                log::error("AsyncWriter sync %s failed\n", paths[i].c_str());
+                std::lock_guard<std::mutex> guard(w->lock);
+                ++w->failed;
+            }
+            _notify(w, paths[i], rets[i]);
+        }
+    }
+
+    /**
+     * Write one image to file, return fd of the written file for fsync later, or -1 if not need sync.
+     */
+    static err::Err _write_file(async_writer_t *w, async_writer_task_t &task, int *out_fd)
+    {
+        image::Image *img = task.img;
+        const std::string &path = task.path;
+        *out_fd = -1;
+
+        size_t pos = path.find_last_of('/');
+        if (pos != std::string::npos && pos > 0)
+        {
+            std::string dir = path.substr(0, pos);
+            if (!fs::exists(dir) && fs::mkdir(dir) < 0)
+            {
+                log::error("create dir %s failed\n", dir.c_str());
+                return err::ERR_IO;
+            }
+        }
+
+        // jpeg, encode to reused buffer and write directly
+        if (_path_is_jpeg(path))
+        {
+            uint8_t *data = nullptr;
+            size_t size = 0;
+            err::Err e = err::ERR_NONE;
+            if (img->format() == image::FMT_JPEG)
+            {
+                data = (uint8_t *)img->data();
+                size = img->data_size();
+            }
+            else
+            {
+                w->encoder->set_quality((task.quality >= 0 && task.quality <= 100) ? task.quality : 95);
+                e = w->encoder->encode_raw(*img, &data, &size);
+            }
+            if (e == err::ERR_NONE)
+            {
+                int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                if (fd < 0)
+                {
+                    log::error("open %s failed\n", path.c_str());
+                    return err::ERR_IO;
+                }
+                e = _write_all(fd, data, size);
+                if (e != err::ERR_NONE || w->sync_batch <= 0)
+                    ::close(fd);
+                else
+                    *out_fd = fd;
+                return e;
+            }
+            // format not supported by encoder, fallback to Image::save
+        }
+
+        // Image::save converts color to new buffer, so buffer shared with caller is not modified
+        err::Err e = img->save(path.c_str(), task.quality);
+        if (e != err::ERR_NONE)
+            return e;
+        if (w->sync_batch > 0)
+            *out_fd = ::open(path.c_str(), O_RDONLY);
+        return err::ERR_NONE;
+    }
+
+    static void _worker(async_writer_t *w)
+    {
+        while (1)
+        {
+            async_writer_task_t task;
+            bool need_sync = false;
+            std::vector<std::string> drops;
+            {
+                std::unique_lock<std::mutex> guard(w->lock);
+                if (w->queue.empty() && w->unsynced_fds.empty() && w->drops.empty())
+                    w->cond_task.wait(guard, [w]
+                                      { return !w->queue.empty() || !w->drops.empty() || w->closed; });
+                if (!w->drops.empty())
+                {
+                    drops.swap(w->drops);
+                }
+                else if (w->queue.empty())
+                {
+                    if (w->unsynced_fds.empty() && w->closed)
+                        break;
+                    // queue drained, sync written files now
+                    need_sync = true;
+                }
+                else
+                {
+                    task = w->queue.front();
+                    w->queue.pop_front();
+                }
+            }
+            if (!drops.empty())
+            {
+                for (auto &path : drops)
+                    _notify(w, path, err::ERR_BUFF_FULL);
+                continue;
+            }
+            if (need_sync)
+            {
+                _sync(w);
+                continue;
+            }
+
+            int fd = -1;
+            err::Err e = err::ERR_NONE;
+            try
+            {
+                e = _write_file(w, task, &fd);
+            }
+            catch (std::exception &ex)
+            {
+                log::error("AsyncWriter write %s failed: %s\n", task.path.c_str(), ex.what());
+                e = err::ERR_RUNTIME;
+            }
+            delete task.img;
+            {
+                std::lock_guard<std::mutex> guard(w->lock);
+                w->bytes -= task.bytes;
+                if (e != err::ERR_NONE)
+                    ++w->failed;
+            }
+            w->cond_space.notify_all();
+
+            if (e != err::ERR_NONE)
+            {
+                log::error("AsyncWriter write %s failed, code: %d\n", task.path.c_str(), e);
+                _notify(w, task.path, e);
+                continue;
+            }
+            if (w->sync_batch <= 0)
+            {
+                _notify(w, task.path, err::ERR_NONE);
+                continue;
+            }
+            w->unsynced_fds.push_back(fd);
+            w->unsynced_paths.push_back(task.path);
+            if ((int)w->unsynced_fds.size() >= w->sync_batch)
+                _sync(w);
+        }
+    }
+
+    AsyncWriter::AsyncWriter(size_t max_bytes, int max_pending, image::AsyncWriterPolicy policy, int sync_batch)
+    {
+        async_writer_t *w = new async_writer_t();
+        w->max_bytes = max_bytes;
+        w->max_pending = max_pending > 0 ? max_pending : 1;
+        w->policy = policy;
+        w->sync_batch = sync_batch;
+        w->bytes = 0;
+        w->inflight = 0;
+        w->dropped = 0;
+        w->failed = 0;
+        w->closed = false;
+        w->encoder = new image::JpegEncoder();
+        w->thread = new std::thread(_worker, w);
+        _handle = w;
+    }
+
+    AsyncWriter::~AsyncWriter()
+    {
+        async_writer_t *w = (async_writer_t *)_handle;
+        if (!w)
+            return;
+        close();
+        delete w->encoder;
+        delete w;
+        _handle = nullptr;
+    }
+
+    err::Err AsyncWriter::write(image::Image &img, const std::string &path, int quality)
+    {
+        // share buffer instead of copy, drawing on img later copies data first(copy on write),
+        // and share() copies if img has views or not owns its data
+        image::Image *shared = img.share();
+        if (!shared)
+            return err::ERR_NO_MEM;
+        return write_take(shared, path, quality);
+    }
+
+    err::Err AsyncWriter::write_take(image::Image *img, const std::string &path, int quality)
+    {
+        async_writer_t *w = (async_writer_t *)_handle;
+        if (!img)
+            return err::ERR_ARGS;
+        size_t bytes = img->data_size() > 0 ? img->data_size() : (size_t)(img->width() * img->height() * image::fmt_size[img->format()]);
+        std::vector<image::Image *> drops;
+        {
+            std::unique_lock<std::mutex> guard(w->lock);
+            auto full = [w, bytes]
+            {
+                if (w->queue.empty())
+                    return false; // always accept one image, even it's larger than budget
+                return w->bytes + bytes > w->max_bytes || (int)w->queue.size() >= w->max_pending;
+            };
+            if (w->closed)
+            {
+                delete img;
+                return err::ERR_NOT_READY;
+            }
+            switch (w->policy)
+            {
+            case image::AsyncWriterPolicy::ASYNC_WRITER_BLOCK:
+                w->cond_space.wait(guard, [w, &full]
+                                   { return w->closed || !full(); });
+                if (w->closed)
+                {
+                    delete img;
+                    return err::ERR_NOT_READY;
+                }
+                break;
+            case image::AsyncWriterPolicy::ASYNC_WRITER_DROP_NEW:
+                if (full())
+                {
+                    ++w->dropped;
+                    delete img;
+                    return err::ERR_BUFF_FULL;
+                }
+                break;
+            case image::AsyncWriterPolicy::ASYNC_WRITER_DROP_OLD:
+                while (full())
+                {
+                    async_writer_task_t &t = w->queue.front();
+                    drops.push_back(t.img);
+                    w->drops.push_back(t.path);
+                    w->bytes -= t.bytes;
+                    ++w->dropped;
+                    w->queue.pop_front();
+                }
+                break;
+            default:
+                break;
+            }
+            w->queue.push_back({img, path, quality, bytes});
+            w->bytes += bytes;
+            ++w->inflight;
+        }
+        w->cond_task.notify_one();
+        // free memory now, callback of dropped images is called in worker thread
+        for (auto dropped_img : drops)
+            delete dropped_img;
+        return err::ERR_NONE;
+    }
+
+    void AsyncWriter::set_callback(std::function<void(const std::string &, err::Err)> callback)
+    {
+        async_writer_t *w = (async_writer_t *)_handle;
+        std::lock_guard<std::mutex> guard(w->lock);
+        w->callback = callback;
+    }
+
+    err::Err AsyncWriter::wait(int timeout_ms)
+    {
+        async_writer_t *w = (async_writer_t *)_handle;
+        std::unique_lock<std::mutex> guard(w->lock);
+        if (timeout_ms < 0)
+        {
+            w->cond_done.wait(guard, [w]
+                              { return w->inflight == 0; });
+            return err::ERR_NONE;
+        }
+        bool ok = w->cond_done.wait_for(guard, std::chrono::milliseconds(timeout_ms), [w]
+                                        { return w->inflight == 0; });
+        return ok ? err::ERR_NONE : err::ERR_TIMEOUT;
+    }
+
+    int AsyncWriter::pending()
+    {
+        async_writer_t *w = (async_writer_t *)_handle;
+        std::lock_guard<std::mutex> guard(w->lock);
+        return w->inflight;
+    }
+
+    size_t AsyncWriter::pending_bytes()
+    {
+        async_writer_t *w = (async_writer_t *)_handle;
+        std::lock_guard<std::mutex> guard(w->lock);
+        return w->bytes;
+    }
+
+    int AsyncWriter::dropped()
+    {
+        async_writer_t *w = (async_writer_t *)_handle;
+        std::lock_guard<std::mutex> guard(w->lock);
+        return w->dropped;
+    }
+
+    int AsyncWriter::failed()
+    {
+        async_writer_t *w = (async_writer_t *)_handle;
+        std::lock_guard<std::mutex> guard(w->lock);
+        return w->failed;
+    }
+
+    void AsyncWriter::close()
+    {
+        async_writer_t *w = (async_writer_t *)_handle;
+        {
+            std::lock_guard<std::mutex> guard(w->lock);
+            if (w->closed && !w->thread)
+                return;
+            w->closed = true;
+        }
+        w->cond_task.notify_all();
+        w->cond_space.notify_all();
+        if (w->thread)
+        {
+            if (w->thread->joinable())
+                w->thread->join();
+            delete w->thread;
+            w->thread = nullptr;
+        }
+    }
+}
@@ -0,0 +1,648 @@
+/**
+ * @author lxowalle@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add 1-bit BITMAP format, word wide logic/morphology/histogram and run based blob labelling.
+ */
+
+#include "maix_image.hpp"
+#include "maix_image_util.hpp"
+#include <vector>
+#include <algorithm>
+#include <string.h>
+#include <math.h>
+
+namespace maix::image
+{
+    // BITMAP row layout is the same as imlib PIXFORMAT_BINARY:
+    // uint32 words, pixel x is bit (x & 31) of word (x >> 5), padding bits at row end are kept 0.
+
+    static inline uint32_t *_bitmap_row(image::Image *img, int y)
+    {
+        return (uint32_t *)((uint8_t *)img->data() + y * img->stride());
+    }
+
+    // bits of word i inside pixel range [x0, x1)
+    static inline uint32_t _bitmap_range_mask(int i, int x0, int x1)
+    {
+        int s = std::max(x0 - i * 32, 0);
+        int e = std::min(x1 - i * 32, 32);
+        if (e <= s)
+            return 0;
+        uint32_t m = e >= 32 ? 0xFFFFFFFFu : ((1u << e) - 1);
+        return m & ~((1u << s) - 1);
+    }
+
+    static inline uint32_t _bitmap_tail_mask(int width)
+    {
+        return (width & 31) ? ((1u << (width & 31)) - 1) : 0xFFFFFFFFu;
+    }
+
+    // same as imlib binary ops: nand is a & ~b, nor is a | ~b
+    template <int OP>
+    static inline uint32_t _bitmap_op(uint32_t a, uint32_t b)
+    {
+        switch (OP)
+        {
+        case BITMAP_OP_AND:  return a & b;
+        case BITMAP_OP_NAND: return a & ~b;
+        case BITMAP_OP_OR:   return a | b;
+        case BITMAP_OP_NOR:  return a | ~b;
+        case BITMAP_OP_XOR:  return a ^ b;
+        default:             return ~(a ^ b);
+        }
+    }
+
+    template <int OP>
+    static void _bitmap_logic_rows(image::Image *img, image::Image *other, image::Image *mask)
+    {
+        int words = (img->width() + 31) >> 5;
+        uint32_t tail = _bitmap_tail_mask(img->width());
+        int h = img->height();
+        #pragma omp parallel for
+        for (int y = 0; y < h; y++)
+        {
+            uint32_t *d = _bitmap_row(img, y);
+            const uint32_t *o = _bitmap_row(other, y);
+            if (mask)
+            {
+                const uint32_t *m = _bitmap_row(mask, y);
+                for (int i = 0; i < words; i++)
+                    d[i] = (_bitmap_op<OP>(d[i], o[i]) & m[i]) | (d[i] & ~m[i]);
+            }
+            else
+            {
+                for (int i = 0; i < words; i++)
+                    d[i] = _bitmap_op<OP>(d[i], o[i]);
+            }
+            d[words - 1] &= tail;
+        }
+    }
+
+    void _bitmap_logic(image::Image *img, image::Image *other, image::Image *mask, bitmap_op_t op)
+    {
+        err::check_bool_raise(!mask || (mask->width() == img->width() && mask->height() == img->height()), "Mask image size is not match source image");
+        switch (op)
+        {
+        case BITMAP_OP_AND:  _bitmap_logic_rows<BITMAP_OP_AND>(img, other, mask); break;
+        case BITMAP_OP_NAND: _bitmap_logic_rows<BITMAP_OP_NAND>(img, other, mask); break;
+        case BITMAP_OP_OR:   _bitmap_logic_rows<BITMAP_OP_OR>(img, other, mask); break;
+        case BITMAP_OP_NOR:  _bitmap_logic_rows<BITMAP_OP_NOR>(img, other, mask); break;
+        case BITMAP_OP_XOR:  _bitmap_logic_rows<BITMAP_OP_XOR>(img, other, mask); break;
+        case BITMAP_OP_XNOR: _bitmap_logic_rows<BITMAP_OP_XNOR>(img, other, mask); break;
+        }
+    }
+
+    // word i of row shifted by d pixels, positive d moves pixel x + d to x, out of row words read as fill
+    static inline uint32_t _bitmap_shift_word(const uint32_t *row, int words, uint32_t fill, int i, int d)
+    {
+        int q = d >= 0 ? (d >> 5) : -((-d + 31) >> 5);
+        int r = d - q * 32; // [0, 31]
+        int i0 = i + q;
+        uint32_t lo = (i0 >= 0 && i0 < words) ? row[i0] : fill;
+        if (r == 0)
+            return lo;
+        uint32_t hi = (i0 + 1 >= 0 && i0 + 1 < words) ? row[i0 + 1] : fill;
+        return (lo >> r) | (hi << (32 - r));
+    }
+
+    // out(x) = op(in(x - k), ..., in(x + k)), op is AND for erode and OR for dilate,
+    // window length 2k+1 is built by doubling, so cost is O(log(k)) word ops per word.
+    // tmp and tmp2 have pad + words words, pad words at left make x - k always inside buffer.
+    template <bool DILATE>
+    static void _bitmap_morph_row(const uint32_t *in, uint32_t *out, uint32_t *tmp, uint32_t *tmp2, int words, int pad, uint32_t tail, int k)
+    {
+        uint32_t fill = DILATE ? 0 : 0xFFFFFFFFu;
+        int n_words = pad + words;
+        // pixels out of image never change the result
+        for (int i = 0; i < pad; i++)
+            tmp[i] = fill;
+        memcpy(tmp + pad, in, words * sizeof(uint32_t));
+        tmp[n_words - 1] = DILATE ? (tmp[n_words - 1] & tail) : (tmp[n_words - 1] | ~tail);
+
+        // tmp(x) covers [x, x + n - 1]
+        int len = 2 * k + 1;
+        int n = 1;
+        while (n * 2 <= len)
+        {
+            for (int i = 0; i < n_words; i++)
+            {
+                uint32_t s = _bitmap_shift_word(tmp, n_words, fill, i, n);
+                tmp2[i] = DILATE ? (tmp[i] | s) : (tmp[i] & s);
+            }
+            std::swap(tmp, tmp2);
+            n *= 2;
+        }
+        // [x - k, x - k + n - 1] op [x + k - n + 1, x + k]
+        for (int i = 0; i < words; i++)
+        {
+            uint32_t a = _bitmap_shift_word(tmp, n_words, fill, i + pad, -k);
+            uint32_t b = _bitmap_shift_word(tmp, n_words, fill, i + pad, k - n + 1);
+            out[i] = DILATE ? (a | b) : (a & b);
+        }
+    }
+
+    template <bool DILATE>
+    static void _bitmap_morph_impl(image::Image *img, int ksize, image::Image *mask)
+    {
+        int w = img->width();
+        int h = img->height();
+        int words = (w + 31) >> 5;
+        int pad = (ksize + 31) >> 5;
+        uint32_t tail = _bitmap_tail_mask(w);
+        std::vector<uint32_t> horiz((size_t)words * h);
+
+        #pragma omp parallel
+        {
+            std::vector<uint32_t> tmp((pad + words) * 2);
+            #pragma omp for
+            for (int y = 0; y < h; y++)
+                _bitmap_morph_row<DILATE>(_bitmap_row(img, y), horiz.data() + (size_t)y * words, tmp.data(), tmp.data() + pad + words, words, pad, tail, ksize);
+        }
+
+        // vertical pass reads horiz only, so original rows are still in image for mask blend
+        #pragma omp parallel for
+        for (int y = 0; y < h; y++)
+        {
+            int y0 = std::max(y - ksize, 0);
+            int y1 = std::min(y + ksize, h - 1);
+            uint32_t *d = _bitmap_row(img, y);
+            const uint32_t *m = mask ? _bitmap_row(mask, y) : nullptr;
+            for (int i = 0; i < words; i++)
+            {
+                uint32_t v = horiz[(size_t)y0 * words + i];
+                for (int j = y0 + 1; j <= y1; j++)
+                    v = DILATE ? (v | horiz[(size_t)j * words + i]) : (v & horiz[(size_t)j * words + i]);
+                d[i] = m ? ((v & m[i]) | (d[i] & ~m[i])) : v;
+            }
+            d[words - 1] &= tail;
+        }
+    }
+
+    void _bitmap_morph(image::Image *img, int ksize, bool dilate, image::Image *mask)
+    {
+        err::check_bool_raise(!mask || (mask->width() == img->width() && mask->height() == img->height()), "Mask image size is not match source image");
+        if (dilate)
+            _bitmap_morph_impl<true>(img, ksize, mask);
+        else
+            _bitmap_morph_impl<false>(img, ksize, mask);
+    }
+
+    void _bitmap_get_histogram(histogram_t *out, image::Image *img, rectangle_t *roi, list_t *thresholds, bool invert, image::Image *other)
+    {
+        int x0 = roi->x, x1 = roi->x + roi->w;
+        int i0 = x0 >> 5, i1 = (x1 - 1) >> 5;
+        int64_t ones = 0;
+        #pragma omp parallel for reduction(+:ones)
+        for (int y = roi->y; y < roi->y + roi->h; y++)
+        {
+            const uint32_t *row = _bitmap_row(img, y);
+            const uint32_t *other_row = other ? _bitmap_row(other, y) : nullptr;
+            for (int i = i0; i <= i1; i++)
+            {
+                uint32_t v = other_row ? (row[i] ^ other_row[i]) : row[i];
+                ones += __builtin_popcount(v & _bitmap_range_mask(i, x0, x1));
+            }
+        }
+        int64_t zeros = (int64_t)roi->w * roi->h - ones;
+
+        int64_t n0 = zeros, n1 = ones;
+        if (thresholds && list_size(thresholds))
+        {
+            n0 = n1 = 0;
+            for (list_lnk_t *it = iterator_start_from_head(thresholds); it; it = iterator_next(it))
+            {
+                color_thresholds_list_lnk_data_t lnk_data;
+                iterator_get(thresholds, it, &lnk_data);
+                if (COLOR_THRESHOLD_BINARY(0, &lnk_data, invert))
+                    n0 += zeros;
+                if (COLOR_THRESHOLD_BINARY(1, &lnk_data, invert))
+                    n1 += ones;
+            }
+        }
+        float scale = (n0 + n1) ? 1.0f / (float)(n0 + n1) : 0;
+        out->LBins[0] = n0 * scale;
+        out->LBins[out->LBinCount - 1] = n1 * scale;
+    }
+
+    typedef struct
+    {
+        int y;
+        int l;      // include
+        int r;      // include
+        int parent;
+        int perimeter;
+        bool seed;  // contains a seed pixel on x_stride/y_stride grid
+    } bitmap_run_t;
+
+    typedef struct
+    {
+        point_t corners[FIND_BLOBS_CORNERS_RESOLUTION];
+        float corners_acc[FIND_BLOBS_CORNERS_RESOLUTION];
+        int corners_n[FIND_BLOBS_CORNERS_RESOLUTION];
+        int64_t pixels;
+        int64_t perimeter;
+        int64_t cx;
+        int64_t cy;
+        int64_t a;
+        int64_t b;
+        int64_t c;
+        bool seed;
+    } bitmap_blob_t;
+
+    static inline int _bitmap_find_root(std::vector<bitmap_run_t> &runs, int i)
+    {
+        while (runs[i].parent != i)
+        {
+            runs[i].parent = runs[runs[i].parent].parent;
+            i = runs[i].parent;
+        }
+        return i;
+    }
+
+    static inline void _bitmap_union(std::vector<bitmap_run_t> &runs, int a, int b)
+    {
+        a = _bitmap_find_root(runs, a);
+        b = _bitmap_find_root(runs, b);
+        // keep the first run(top left) as root, blobs output in scan order
+        if (a < b)
+            runs[b].parent = a;
+        else if (b < a)
+            runs[a].parent = b;
+    }
+
+    static inline float _bitmap_sign(float x)
+    {
+        return x / fabsf(x);
+    }
+
+    // IM_MAX(IM_MIN(v, max), 0) of imlib, NaN(sign of 0) gives max
+    static inline int _bitmap_clamp_max(float v, int max)
+    {
+        float r = v < max ? v : max;
+        return r > 0 ? r : 0;
+    }
+
+    // same as imlib calc_roundness
+    static float _bitmap_roundness(float blob_a, float blob_b, float blob_c)
+    {
+        float roundness_div = fast_sqrtf((blob_b * blob_b) + ((blob_a - blob_c) * (blob_a - blob_c)));
+        float roundness_sin = IM_DIV(blob_b, roundness_div);
+        float roundness_cos = IM_DIV(blob_a - blob_c, roundness_div);
+        float roundness_add = (blob_a + blob_c) / 2;
+        float roundness_cos_mul = (blob_a - blob_c) / 2;
+        float roundness_sin_mul = blob_b / 2;
+        float r0 = roundness_add + (roundness_cos * roundness_cos_mul) + (roundness_sin * roundness_sin_mul);
+        float r1 = roundness_add + (roundness_cos * roundness_cos_mul) - (roundness_sin * roundness_sin_mul);
+        float r2 = roundness_add - (roundness_cos * roundness_cos_mul) + (roundness_sin * roundness_sin_mul);
+        float r3 = roundness_add - (roundness_cos * roundness_cos_mul) - (roundness_sin * roundness_sin_mul);
+        float r_max = std::max(std::max(r0, r1), std::max(r2, r3));
+        float r_min = std::min(std::min(r0, r1), std::min(r2, r3));
+        return IM_DIV(r_min, r_max);
+    }
+
+    // pass bits of one row for current threshold, pixels outside roi are 0
+    static inline void _bitmap_pass_row(const uint32_t *row, const uint32_t *claimed, uint32_t *out, int i0, int i1, int x0, int x1, bool pass0, bool pass1)
+    {
+        for (int i = i0; i <= i1; i++)
+        {
+            uint32_t v = pass0 ? (pass1 ? 0xFFFFFFFFu : ~row[i]) : row[i];
+            if (claimed)
+                v &= ~claimed[i];
+            out[i - i0] = v & _bitmap_range_mask(i, x0, x1);
+        }
+    }
+
+    // count pixels in [l, r] which bit is 0 in bits, bits word 0 is word i0 of row
+    static inline int _bitmap_count_zero(const uint32_t *bits, int i0, int l, int r)
+    {
+        if (r < l)
+            return 0;
+        int n = 0;
+        for (int i = l >> 5; i <= (r >> 5); i++)
+            n += __builtin_popcount(bits[i - i0] & _bitmap_range_mask(i, l, r + 1));
+        return (r - l + 1) - n;
+    }
+
+    std::vector<image::Blob> _bitmap_find_blobs(image::Image *img, list_t *thresholds, bool invert, rectangle_t *roi,
+                                                int x_stride, int y_stride, int area_threshold, int pixels_threshold)
+    {
+        std::vector<image::Blob> blobs;
+        x_stride = std::max(x_stride, 1);
+        y_stride = std::max(y_stride, 1);
+        int x0 = roi->x, x1 = roi->x + roi->w;
+        int y0 = roi->y, y1 = roi->y + roi->h;
+        int i0 = x0 >> 5, i1 = (x1 - 1) >> 5;
+        int row_words = i1 - i0 + 1;
+        int x_max = x1 - 1, y_max = y1 - 1;
+
+        // pixels taken by blobs of previous thresholds, same as imlib shared visited bitmap
+        std::vector<uint32_t> claimed;
+        bool multi = list_size(thresholds) > 1;
+        if (multi)
+            claimed.resize((size_t)row_words * roi->h, 0);
+
+        std::vector<bitmap_run_t> runs;
+        std::vector<uint32_t> pass((size_t)row_words * 3);
+        std::vector<uint32_t> near((size_t)row_words * 3);
+        std::vector<int> blob_idx;
+        std::vector<bitmap_blob_t> accs;
+
+        size_t code = 0;
+        for (list_lnk_t *it = iterator_start_from_head(thresholds); it; it = iterator_next(it), code++)
+        {
+            color_thresholds_list_lnk_data_t lnk_data;
+            iterator_get(thresholds, it, &lnk_data);
+            bool pass0 = COLOR_THRESHOLD_BINARY(0, &lnk_data, invert);
+            bool pass1 = COLOR_THRESHOLD_BINARY(1, &lnk_data, invert);
+            if (!pass0 && !pass1)
+                continue;
+
+            // 1. extract runs of each row and union with overlapped runs of previous row(4-connectivity)
+            runs.clear();
+            int prev_begin = 0, prev_end = 0;
+            for (int y = y0; y < y1; y++)
+            {
+                uint32_t *cur = pass.data() + (size_t)((y - y0) % 3) * row_words;
+                uint32_t *cur_near = near.data() + (size_t)((y - y0) % 3) * row_words;
+                const uint32_t *cl = multi ? claimed.data() + (size_t)(y - y0) * row_words - i0 : nullptr;
+                if (y == y0)
+                {
+                    _bitmap_pass_row(_bitmap_row(img, y), cl, cur, i0, i1, x0, x1, pass0, pass1);
+                    _bitmap_pass_row(_bitmap_row(img, y), nullptr, cur_near, i0, i1, x0, x1, pass0, pass1);
+                }
+                uint32_t *next = nullptr, *next_near = nullptr;
+                if (y + 1 < y1)
+                {
+                    next = pass.data() + (size_t)((y + 1 - y0) % 3) * row_words;
+                    next_near = near.data() + (size_t)((y + 1 - y0) % 3) * row_words;
+                    const uint32_t *ncl = multi ? claimed.data() + (size_t)(y + 1 - y0) * row_words - i0 : nullptr;
+                    _bitmap_pass_row(_bitmap_row(img, y + 1), ncl, next, i0, i1, x0, x1, pass0, pass1);
+                    // pixels visited by other thresholds are not counted as edge, same as imlib
+                    _bitmap_pass_row(_bitmap_row(img, y + 1), nullptr, next_near, i0, i1, x0, x1, pass0, pass1);
+                    if (multi)
+                        for (int i = 0; i < row_words; i++)
+                            next_near[i] |= ncl[i + i0] & _bitmap_range_mask(i + i0, x0, x1);
+                }
+                if (y == y0 && multi)
+                    for (int i = 0; i < row_words; i++)
+                        cur_near[i] |= cl[i + i0] & _bitmap_range_mask(i + i0, x0, x1);
+                const uint32_t *prev_near = y > y0 ? near.data() + (size_t)((y - 1 - y0) % 3) * row_words : nullptr;
+
+                bool seed_row = ((y - y0) % y_stride) == 0;
+                int seed_x0 = x0 + (y % x_stride);
+                int cur_begin = runs.size();
+                int start = -1;
+                for (int i = i0; i <= i1; i++)
+                {
+                    uint32_t bits = cur[i - i0];
+                    int pos = 0;
+                    while (pos < 32)
+                    {
+                        if (start < 0)
+                        {
+                            uint32_t rem = bits >> pos;
+                            if (!rem)
+                                break;
+                            pos += __builtin_ctz(rem);
+                            start = i * 32 + pos;
+                        }
+                        uint32_t rem = (~bits) >> pos;
+                        if (!rem)
+                            break;
+                        pos += __builtin_ctz(rem);
+                        runs.push_back({y, start, i * 32 + pos - 1, (int)runs.size(), 0, false});
+                        start = -1;
+                    }
+                }
+                if (start >= 0)
+                    runs.push_back({y, start, x_max, (int)runs.size(), 0, false});
+                int cur_end = runs.size();
+
+                for (int j = cur_begin; j < cur_end; j++)
+                {
+                    bitmap_run_t &run = runs[j];
+                    // imlib perimeter: 2 for each run, and pixels above/below not in blob, except two ends of run
+                    int perimeter = 2;
+                    perimeter += prev_near ? _bitmap_count_zero(prev_near, i0, run.l + 1, run.r - 1) : run.r - run.l + 1;
+                    perimeter += next_near ? _bitmap_count_zero(next_near, i0, run.l + 1, run.r - 1) : run.r - run.l + 1;
+                    run.perimeter = perimeter;
+                    if (seed_row && seed_x0 < x1)
+                    {
+                        int s = run.l <= seed_x0 ? seed_x0 : seed_x0 + ((run.l - seed_x0 + x_stride - 1) / x_stride) * x_stride;
+                        run.seed = s <= run.r;
+                    }
+                }
+
+                // runs in both rows are sorted by x
+                int p = prev_begin;
+                for (int j = cur_begin; j < cur_end && p < prev_end; )
+                {
+                    if (runs[p].r < runs[j].l)
+                        p++;
+                    else if (runs[j].r < runs[p].l)
+                        j++;
+                    else
+                    {
+                        _bitmap_union(runs, p, j);
+                        if (runs[p].r < runs[j].r)
+                            p++;
+                        else
+                            j++;
+                    }
+                }
+                prev_begin = cur_begin;
+                prev_end = cur_end;
+            }
+
+            // 2. accumulate blob statistics, same formula as imlib_find_blobs
+            blob_idx.assign(runs.size(), -1);
+            accs.clear();
+            for (size_t j = 0; j < runs.size(); j++)
+            {
+                bitmap_run_t &run = runs[j];
+                int root = _bitmap_find_root(runs, j);
+                if (blob_idx[root] < 0)
+                {
+                    blob_idx[root] = accs.size();
+                    accs.emplace_back();
+                    bitmap_blob_t &acc = accs.back();
+                    memset(&acc, 0, sizeof(acc));
+                    for (int i = 0; i < FIND_BLOBS_CORNERS_RESOLUTION; i++)
+                    {
+                        float cos_v = cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i];
+                        float sin_v = sin_table[FIND_BLOBS_ANGLE_RESOLUTION * i];
+                        acc.corners[i].x = _bitmap_clamp_max(x_max * _bitmap_sign(cos_v), x_max);
+                        acc.corners[i].y = _bitmap_clamp_max(y_max * _bitmap_sign(sin_v), y_max);
+                        acc.corners_acc[i] = (acc.corners[i].x * cos_v) + (acc.corners[i].y * sin_v);
+                        acc.corners_n[i] = 1;
+                    }
+                }
+                bitmap_blob_t &acc = accs[blob_idx[root]];
+                int left = run.l, right = run.r, y = run.y;
+                int64_t cnt = right - left + 1;
+                int64_t sum = ((int64_t)right * (right + 1) - (int64_t)left * (left - 1)) / 2;
+                int64_t sum_2 = ((int64_t)right * (right + 1) * (2 * right + 1) - (int64_t)left * (left - 1) * (2 * left - 1)) / 6;
+                int avg = sum / cnt;
+                for (int i = 0; i < FIND_BLOBS_CORNERS_RESOLUTION; i++)
+                {
+                    float cos_v = cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i];
+                    float sin_v = sin_table[FIND_BLOBS_ANGLE_RESOLUTION * i];
+                    int x_new = (cos_v > 0) ? left : ((cos_v == 0) ? avg : right);
+                    float z = (x_new * cos_v) + (y * sin_v);
+                    if (z < acc.corners_acc[i])
+                    {
+                        acc.corners_acc[i] = z;
+                        acc.corners[i].x = x_new;
+                        acc.corners[i].y = y;
+                        acc.corners_n[i] = 1;
+                    }
+                    else if (z == acc.corners_acc[i])
+                    {
+                        int n = acc.corners_n[i];
+                        acc.corners[i].x = (x_new + (n * acc.corners[i].x)) / (n + 1);
+                        acc.corners[i].y = (y + (n * acc.corners[i].y)) / (n + 1);
+                        acc.corners_n[i] += 1;
+                    }
+                }
+                acc.pixels += cnt;
+                acc.perimeter += run.perimeter;
+                acc.cx += sum;
+                acc.cy += y * cnt;
+                acc.a += sum_2;
+                acc.b += y * sum;
+                acc.c += (int64_t)y * y * cnt;
+                acc.seed |= run.seed;
+            }
+
+            // 3. output blobs found from seed pixels, and mark them visited for next thresholds
+            for (size_t j = 0; j < runs.size(); j++)
+            {
+                int root = _bitmap_find_root(runs, j);
+                bitmap_blob_t &acc = accs[blob_idx[root]];
+                if (!acc.seed)
+                    continue;
+                if (multi)
+                {
+                    uint32_t *cl = claimed.data() + (size_t)(runs[j].y - y0) * row_words - i0;
+                    for (int i = runs[j].l >> 5; i <= (runs[j].r >> 5); i++)
+                        cl[i] |= _bitmap_range_mask(i, runs[j].l, runs[j].r + 1);
+                }
+                if ((int)j != root)
+                    continue;
+
+                point_t *corners = acc.corners;
+                std::vector<int> rect = {corners[(FIND_BLOBS_CORNERS_RESOLUTION * 0) / 4].x,
+                                         corners[(FIND_BLOBS_CORNERS_RESOLUTION * 1) / 4].y,
+                                         corners[(FIND_BLOBS_CORNERS_RESOLUTION * 2) / 4].x - corners[(FIND_BLOBS_CORNERS_RESOLUTION * 0) / 4].x + 1,
+                                         corners[(FIND_BLOBS_CORNERS_RESOLUTION * 3) / 4].y - corners[(FIND_BLOBS_CORNERS_RESOLUTION * 1) / 4].y + 1};
+                if (rect[2] * rect[3] < area_threshold || acc.pixels < pixels_threshold)
+                    continue;
+
+                float b_mx = acc.cx / (float)acc.pixels;
+                float b_my = acc.cy / (float)acc.pixels;
+                int64_t mx = fast_roundf(b_mx);
+                int64_t my = fast_roundf(b_my);
+                float small_a = acc.a - ((mx * acc.cx) + (mx * acc.cx)) + (acc.pixels * mx * mx);
+                float small_b = acc.b - ((mx * acc.cy) + (my * acc.cx)) + (acc.pixels * mx * my);
+                float small_c = acc.c - ((my * acc.cy) + (my * acc.cy)) + (acc.pixels * my * my);
+                float rotation = (small_a != small_c) ? (fast_atan2f(2 * small_b, small_a - small_c) / 2.0f) : 0.0f;
+                float roundness = _bitmap_roundness(small_a, small_b, small_c);
+
+                std::vector<std::vector<int>> corners_out = {
+                    {(int)corners[((FIND_BLOBS_CORNERS_RESOLUTION * 0) / 4)].x, (int)corners[((FIND_BLOBS_CORNERS_RESOLUTION * 0) / 4)].y},
+                    {(int)corners[((FIND_BLOBS_CORNERS_RESOLUTION * 1) / 4)].x, (int)corners[((FIND_BLOBS_CORNERS_RESOLUTION * 1) / 4)].y},
+                    {(int)corners[((FIND_BLOBS_CORNERS_RESOLUTION * 2) / 4)].x, (int)corners[((FIND_BLOBS_CORNERS_RESOLUTION * 2) / 4)].y},
+                    {(int)corners[((FIND_BLOBS_CORNERS_RESOLUTION * 3) / 4)].x, (int)corners[((FIND_BLOBS_CORNERS_RESOLUTION * 3) / 4)].y},
+                };
+                point_t min_corners_tmp[4];
+                point_min_area_rectangle(corners, min_corners_tmp, FIND_BLOBS_CORNERS_RESOLUTION);
+                std::vector<std::vector<int>> mini_corners = {
+                    {(int)min_corners_tmp[0].x, (int)min_corners_tmp[0].y},
+                    {(int)min_corners_tmp[1].x, (int)min_corners_tmp[1].y},
+                    {(int)min_corners_tmp[2].x, (int)min_corners_tmp[2].y},
+                    {(int)min_corners_tmp[3].x, (int)min_corners_tmp[3].y},
+                };
+                std::vector<int> hist_x_bins;
+                std::vector<int> hist_y_bins;
+                blobs.push_back(image::Blob(rect, corners_out, mini_corners, b_mx, b_my, acc.pixels, rotation,
+                                            1 << code, 1, acc.perimeter, roundness, hist_x_bins, hist_y_bins));
+            }
+        }
+        return blobs;
+    }
+
+    image::Image *_bitmap_to_format(image::Image *img, image::Format format, void *buff, size_t buff_size)
+    {
+        int w = img->width();
+        int h = img->height();
+        int words = (w + 31) >> 5;
+        if (img->format() == image::FMT_BITMAP)
+        {
+            image::Image *gray;
+            if (format == image::FMT_GRAYSCALE && buff)
+            {
+                err::check_bool_raise(buff_size >= (size_t)w * h, "convert format failed, buffer size not enough");
+                gray = new image::Image(w, h, image::FMT_GRAYSCALE, (uint8_t *)buff, w * h, false);
+            }
+            else
+            {
+                gray = new image::Image(w, h, image::FMT_GRAYSCALE);
+            }
+            #pragma omp parallel for
+            for (int y = 0; y < h; y++)
+            {
+                const uint32_t *row = _bitmap_row(img, y);
+                uint8_t *out = (uint8_t *)gray->data() + y * gray->stride();
+                for (int x = 0; x < w; x++)
+                    out[x] = ((row[x >> 5] >> (x & 31)) & 1) ? 255 : 0;
+            }
+            if (format == image::FMT_GRAYSCALE)
+                return gray;
+            image::Image *ret = gray->to_format(format, buff, buff_size);
+            delete gray;
+            return ret;
+        }
+
+        err::check_bool_raise(format == image::FMT_BITMAP, "convert format failed, not bitmap format");
+        image::Image *gray = img;
+        if (img->format() != image::FMT_GRAYSCALE)
+            gray = img->to_format(image::FMT_GRAYSCALE);
+        image::Image *ret;
+        int size = words * 4 * h;
+        if (buff)
+        {
+            if (buff_size < (size_t)size)
+            {
+                if (gray != img)
+                    delete gray;
+                log::error("convert format failed, buffer size not enough, need %d, but %d\n", size, (int)buff_size);
+                throw err::Exception(err::ERR_ARGS, "convert format failed, buffer size not enough");
+            }
+            ret = new image::Image(w, h, image::FMT_BITMAP, (uint8_t *)buff, size, false);
+        }
+        else
+        {
+            ret = new image::Image(w, h, image::FMT_BITMAP);
+        }
+        // same as imlib COLOR_GRAYSCALE_TO_BINARY
+        #pragma omp parallel for
+        for (int y = 0; y < h; y++)
+        {
+            const uint8_t *in = (uint8_t *)gray->data() + y * gray->stride();
+            uint32_t *row = _bitmap_row(ret, y);
+            for (int i = 0; i < words; i++)
+            {
+                uint32_t v = 0;
+                int n = std::min(32, w - i * 32);
+                const uint8_t *p = in + i * 32;
+                for (int b = 0; b < n; b++)
+                    v |= (uint32_t)(p[b] > (((COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN) / 2) + COLOR_GRAYSCALE_MIN)) << b;
+                row[i] = v;
+            }
+        }
+        if (gray != img)
+            delete gray;
+        return ret;
+    }
+}
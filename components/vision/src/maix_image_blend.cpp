@@ -0,0 +1,379 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add alpha blend of RGBA image to RGB/RGBA/GRAY/NV21/NV12 image, skip transparent tiles.
+ */
+
+#include "maix_image.hpp"
+#include <vector>
+#include <algorithm>
+#include <string.h>
+#if __riscv_vector
+#include <riscv_vector.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace maix::image
+{
+    #define ALPHA_TILE_SIZE     (16)
+    #define ALPHA_TILE_EMPTY    (0) // all pixels transparent
+    #define ALPHA_TILE_PARTIAL  (1)
+    #define ALPHA_TILE_OPAQUE   (2) // all pixels opaque
+
+    typedef struct
+    {
+        void *data;         // pixel data the map built from
+        uint32_t version;   // buffer version the map built from
+        int width;
+        int height;
+        int tiles_w;
+        int tiles_h;
+        std::vector<uint8_t> tiles;
+    } alpha_tiles_t;
+
+    typedef struct
+    {
+        int start;  // source x, include
+        int end;    // source x, exclude
+        uint8_t type;
+    } alpha_run_t;
+
+    // round(v / 255), v in [0, 65025]
+    static inline uint32_t _div255(uint32_t v)
+    {
+        v += 128;
+        return (v + (v >> 8)) >> 8;
+    }
+
+    static inline uint8_t _clamp_u8(int v)
+    {
+        return v < 0 ? 0 : (v > 255 ? 255 : v);
+    }
+
+    // round(v / d) for signed v
+    static inline int _div_round(int v, int d)
+    {
+        return v >= 0 ? (v + d / 2) / d : -((-v + d / 2) / d);
+    }
+
+    static void _build_alpha_tiles(alpha_tiles_t *t, const uint8_t *data, int width, int height, int stride)
+    {
+        t->tiles_w = (width + ALPHA_TILE_SIZE - 1) / ALPHA_TILE_SIZE;
+        t->tiles_h = (height + ALPHA_TILE_SIZE - 1) / ALPHA_TILE_SIZE;
+        t->tiles.resize(t->tiles_w * t->tiles_h);
+        uint8_t *tiles = t->tiles.data();
+        int tiles_w = t->tiles_w;
+        #pragma omp parallel for
+        for (int ty = 0; ty < t->tiles_h; ty++)
+        {
+            int y0 = ty * ALPHA_TILE_SIZE;
+            int y1 = std::min(height, y0 + ALPHA_TILE_SIZE);
+            for (int tx = 0; tx < tiles_w; tx++)
+            {
+                int x0 = tx * ALPHA_TILE_SIZE;
+                int n = std::min(width, x0 + ALPHA_TILE_SIZE) - x0;
+                uint8_t a_min = 255, a_max = 0;
+                for (int y = y0; y < y1; y++)
+                {
+                    const uint8_t *p = data + y * stride + x0 * 4 + 3;
+                    for (int i = 0; i < n; i++)
+                    {
+                        a_min = std::min(a_min, p[i * 4]);
+                        a_max = std::max(a_max, p[i * 4]);
+                    }
+                }
+                tiles[ty * tiles_w + tx] = a_max == 0 ? ALPHA_TILE_EMPTY : (a_min == 255 ? ALPHA_TILE_OPAQUE : ALPHA_TILE_PARTIAL);
+            }
+        }
+    }
+
+    /**
+     * Get runs of not empty tiles of source rows [sy0, sy1] and columns [sx, sx + w),
+     * adjacent tiles with same type are merged, a tile is opaque only when opaque in all rows.
+     */
+    static void _alpha_tile_runs(const alpha_tiles_t *t, int sy0, int sy1, int sx, int w, std::vector<alpha_run_t> &runs)
+    {
+        runs.clear();
+        int ty0 = sy0 / ALPHA_TILE_SIZE, ty1 = sy1 / ALPHA_TILE_SIZE;
+        int tx0 = sx / ALPHA_TILE_SIZE, tx1 = (sx + w - 1) / ALPHA_TILE_SIZE;
+        for (int tx = tx0; tx <= tx1; tx++)
+        {
+            uint8_t type = t->tiles[ty0 * t->tiles_w + tx];
+            for (int ty = ty0 + 1; ty <= ty1; ty++)
+            {
+                if (t->tiles[ty * t->tiles_w + tx] != type)
+                    type = ALPHA_TILE_PARTIAL;
+            }
+            if (type == ALPHA_TILE_EMPTY)
+                continue;
+            int start = std::max(sx, tx * ALPHA_TILE_SIZE);
+            int end = std::min(sx + w, (tx + 1) * ALPHA_TILE_SIZE);
+            if (!runs.empty() && runs.back().end == start && runs.back().type == type)
+                runs.back().end = end;
+            else
+                runs.push_back({start, end, type});
+        }
+    }
+
+    /**
+     * Blend n pixels of 4 channels source to 3 or 4 channels destination,
+     * sr and sb are source channel index for destination channel 0 and 2.
+     * color: out = s * a + d * (1 - a), or out = s + d * (1 - a) if premultiplied,
+     * alpha: out = a + d * (1 - a).
+     */
+    template <int DST_CH>
+    static void _blend_row(const uint8_t *s, uint8_t *d, int n, int sr, int sb, bool premultiplied)
+    {
+        int i = 0;
+#if __riscv_vector
+        size_t vl;
+        for (; (vl = vsetvl_e8m1(n - i)) > 0; i += vl)
+        {
+            const uint8_t *sp = s + i * 4;
+            uint8_t *dp = d + i * DST_CH;
+            vuint8m1_t a = vlse8_v_u8m1(sp + 3, 4, vl);
+            vuint8m1_t ia = vrsub_vx_u8m1(a, 255, vl);
+            for (int c = 0; c < DST_CH; c++)
+            {
+                bool add = premultiplied || c == 3;
+                vuint8m1_t sc = vlse8_v_u8m1(sp + (c == 0 ? sr : (c == 2 ? sb : c)), 4, vl);
+                vuint8m1_t dc = vlse8_v_u8m1(dp + c, DST_CH, vl);
+                vuint16m2_t acc = vwmulu_vv_u16m2(dc, ia, vl);
+                if (!add)
+                    acc = vwmaccu_vv_u16m2(acc, sc, a, vl);
+                acc = vadd_vx_u16m2(acc, 128, vl);
+                acc = vadd_vv_u16m2(acc, vsrl_vx_u16m2(acc, 8, vl), vl);
+                vuint8m1_t out = vnsrl_wx_u8m1(acc, 8, vl);
+                if (add)
+                    out = vsaddu_vv_u8m1(out, sc, vl);
+                vsse8_v_u8m1(dp + c, DST_CH, out, vl);
+            }
+        }
+#elif defined(__ARM_NEON)
+        for (; i + 8 <= n; i += 8)
+        {
+            uint8x8x4_t sv = vld4_u8(s + i * 4);
+            uint8x8_t a = sv.val[3];
+            uint8x8_t ia = vmvn_u8(a);
+            uint8x8_t sc[4] = {sr == 0 ? sv.val[0] : sv.val[2], sv.val[1], sb == 2 ? sv.val[2] : sv.val[0], a};
+            uint8x8_t dc[4];
+            if (DST_CH == 4)
+            {
+                uint8x8x4_t dv = vld4_u8(d + i * 4);
+                for (int c = 0; c < 4; c++)
+                    dc[c] = dv.val[c];
+            }
+            else
+            {
+                uint8x8x3_t dv = vld3_u8(d + i * 3);
+                for (int c = 0; c < 3; c++)
+                    dc[c] = dv.val[c];
+            }
+            for (int c = 0; c < DST_CH; c++)
+            {
+                bool add = premultiplied || c == 3;
+                uint16x8_t acc = vmull_u8(dc[c], ia);
+                if (!add)
+                    acc = vmlal_u8(acc, sc[c], a);
+                // round(acc / 255)
+                uint8x8_t out = vraddhn_u16(acc, vrshrq_n_u16(acc, 8));
+                dc[c] = add ? vqadd_u8(out, sc[c]) : out;
+            }
+            if (DST_CH == 4)
+            {
+                uint8x8x4_t dv = {{dc[0], dc[1], dc[2], dc[3]}};
+                vst4_u8(d + i * 4, dv);
+            }
+            else
+            {
+                uint8x8x3_t dv = {{dc[0], dc[1], dc[2]}};
+                vst3_u8(d + i * 3, dv);
+            }
+        }
+#endif
+        for (; i < n; i++)
+        {
+            const uint8_t *sp = s + i * 4;
+            uint8_t *dp = d + i * DST_CH;
+            uint32_t a = sp[3];
+            if (a == 0)
+                continue;
+            uint32_t ia = 255 - a;
+            uint32_t sc[3] = {sp[sr], sp[1], sp[sb]};
+            for (int c = 0; c < 3; c++)
+            {
+                if (premultiplied)
+                    dp[c] = std::min(255u, sc[c] + _div255(dp[c] * ia));
+                else
+                    dp[c] = _div255(sc[c] * a + dp[c] * ia);
+            }
+            if (DST_CH == 4)
+                dp[3] = a + _div255(dp[3] * ia);
+        }
+    }
+
+    // copy n opaque pixels of 4 channels source to 3 or 4 channels destination
+    template <int DST_CH>
+    static void _copy_row(const uint8_t *s, uint8_t *d, int n, int sr, int sb)
+    {
+        if (DST_CH == 4 && sr == 0)
+        {
+            memcpy(d, s, n * 4);
+            return;
+        }
+        for (int i = 0; i < n; i++)
+        {
+            d[i * DST_CH + 0] = s[i * 4 + sr];
+            d[i * DST_CH + 1] = s[i * 4 + 1];
+            d[i * DST_CH + 2] = s[i * 4 + sb];
+            if (DST_CH == 4)
+                d[i * DST_CH + 3] = 255;
+        }
+    }
+
+    /**
+     * Blend n pixels of 4 channels source to luma, sr and sb are source channel index of R and B.
+     * yuv true for Y plane of YUV(BT.601 limited range, same as Image.to_format), false for GRAYSCALE.
+     */
+    static void _blend_row_luma(const uint8_t *s, uint8_t *d, int n, int sr, int sb, bool premultiplied, bool yuv)
+    {
+        int base = yuv ? 16 : 0;
+        for (int i = 0; i < n; i++)
+        {
+            const uint8_t *sp = s + i * 4;
+            int a = sp[3];
+            if (a == 0)
+                continue;
+            int l = yuv ? ((66 * sp[sr] + 129 * sp[1] + 25 * sp[sb] + 128) >> 8)
+                        : ((sp[sr] * 38 + sp[1] * 75 + sp[sb] * 15) >> 7);
+            int v = (premultiplied ? l * 255 : l * a) + (d[i] - base) * (255 - a);
+            d[i] = _clamp_u8(base + _div_round(v, 255));
+        }
+    }
+
+    void *Image::_get_alpha_tiles()
+    {
+        alpha_tiles_t *t = (alpha_tiles_t *)_alpha_tiles;
+        uint32_t version = _buf_version();
+        // cache is only valid for image owns buffer, for external data we can't know when it changed
+        if (t && _buf && t->data == _data && t->version == version && t->width == _width && t->height == _height)
+            return t;
+        if (!t)
+        {
+            t = new alpha_tiles_t();
+            _alpha_tiles = t;
+        }
+        _build_alpha_tiles(t, (const uint8_t *)_data, _width, _height, _stride);
+        t->data = _data;
+        t->version = version;
+        t->width = _width;
+        t->height = _height;
+        return t;
+    }
+
+    void Image::_free_alpha_tiles()
+    {
+        if (_alpha_tiles)
+        {
+            delete (alpha_tiles_t *)_alpha_tiles;
+            _alpha_tiles = nullptr;
+        }
+    }
+
+    void Image::_draw_image_alpha(int x, int y, int src_x, int src_y, int w, int h, image::Image &img, bool premultiplied)
+    {
+        const alpha_tiles_t *tiles = (const alpha_tiles_t *)img._get_alpha_tiles();
+        // not img.data(), it invalidates the tiles cache
+        const uint8_t *src = (const uint8_t *)img._data;
+        int src_stride = img.stride();
+        uint8_t *dst = (uint8_t *)_data;
+        bool src_rgb = img.format() == image::FMT_RGBA8888;
+        bool yuv = _format == image::FMT_YVU420SP || _format == image::FMT_YUV420SP;
+        bool luma = yuv || _format == image::FMT_GRAYSCALE;
+        int dst_ch = luma ? 1 : (int)image::fmt_size[_format];
+        // source channel index of destination channel 0 and 2, for luma is index of R and B
+        bool dst_rgb = luma || _format == image::FMT_RGB888 || _format == image::FMT_RGBA8888;
+        int sr = src_rgb == dst_rgb ? 0 : 2;
+        int sb = 2 - sr;
+
+        #pragma omp parallel for
+        for (int j = 0; j < h; j++)
+        {
+            std::vector<alpha_run_t> runs;
+            _alpha_tile_runs(tiles, src_y + j, src_y + j, src_x, w, runs);
+            const uint8_t *s = src + (src_y + j) * src_stride;
+            uint8_t *d = dst + (y + j) * _stride + (x - src_x) * dst_ch;
+            for (const alpha_run_t &r : runs)
+            {
+                const uint8_t *sp = s + r.start * 4;
+                uint8_t *dp = d + r.start * dst_ch;
+                int n = r.end - r.start;
+                if (luma)
+                    _blend_row_luma(sp, dp, n, sr, sb, premultiplied, yuv);
+                else if (dst_ch == 4)
+                {
+                    if (r.type == ALPHA_TILE_OPAQUE)
+                        _copy_row<4>(sp, dp, n, sr, sb);
+                    else
+                        _blend_row<4>(sp, dp, n, sr, sb, premultiplied);
+                }
+                else
+                {
+                    if (r.type == ALPHA_TILE_OPAQUE)
+                        _copy_row<3>(sp, dp, n, sr, sb);
+                    else
+                        _blend_row<3>(sp, dp, n, sr, sb, premultiplied);
+                }
+            }
+        }
+        if (!yuv)
+            return;
+
+        // chroma, blend every 2x2 block with sum of covered pixels, uncovered pixels are treated as transparent
+        uint8_t *uv = dst + _stride * _height;
+        int u_idx = _format == image::FMT_YUV420SP ? 0 : 1;
+        int cy0 = y / 2, cy1 = (y + h - 1) / 2;
+        int cx0 = x / 2, cx1 = (x + w - 1) / 2;
+        #pragma omp parallel for
+        for (int cy = cy0; cy <= cy1; cy++)
+        {
+            int dy0 = std::max(y, cy * 2), dy1 = std::min(y + h - 1, cy * 2 + 1);
+            std::vector<alpha_run_t> runs;
+            _alpha_tile_runs(tiles, dy0 - y + src_y, dy1 - y + src_y, src_x, w, runs);
+            uint8_t *uv_row = uv + cy * _stride;
+            for (const alpha_run_t &r : runs)
+            {
+                // run in destination chroma columns
+                int rcx0 = (r.start - src_x + x) / 2, rcx1 = (r.end - 1 - src_x + x) / 2;
+                for (int cx = std::max(cx0, rcx0); cx <= std::min(cx1, rcx1); cx++)
+                {
+                    int dx0 = std::max(x, cx * 2), dx1 = std::min(x + w - 1, cx * 2 + 1);
+                    int sum_a = 0, sum_u = 0, sum_v = 0;
+                    for (int dy = dy0; dy <= dy1; dy++)
+                    {
+                        const uint8_t *s = src + (dy - y + src_y) * src_stride;
+                        for (int dx = dx0; dx <= dx1; dx++)
+                        {
+                            const uint8_t *sp = s + (dx - x + src_x) * 4;
+                            int a = sp[3];
+                            if (a == 0)
+                                continue;
+                            int k = premultiplied ? 255 : a;
+                            sum_a += a;
+                            sum_u += k * (-38 * sp[sr] - 74 * sp[1] + 112 * sp[sb]);
+                            sum_v += k * (112 * sp[sr] - 94 * sp[1] - 18 * sp[sb]);
+                        }
+                    }
+                    if (sum_a == 0)
+                        continue;
+                    uint8_t *p = uv_row + cx * 2;
+                    int rest = 255 * 4 - sum_a;
+                    p[u_idx] = _clamp_u8(128 + _div_round(_div_round(sum_u, 256) + (p[u_idx] - 128) * rest, 255 * 4));
+                    p[1 - u_idx] = _clamp_u8(128 + _div_round(_div_round(sum_v, 256) + (p[1 - u_idx] - 128) * rest, 255 * 4));
+                }
+            }
+        }
+    }
+}
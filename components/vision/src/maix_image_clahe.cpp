@@ -0,0 +1,321 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add CLAHE, tiled parallel contrast limited adaptive histogram equalization.
+ */
+
+#include "maix_image_clahe.hpp"
+#include <vector>
+#include <omp.h>
+
+namespace maix::image
+{
+    #define CLAHE_MAX_TILES (64)
+
+    typedef struct
+    {
+        int width;
+        int height;
+        bool valid;                 // lut holds previous frame's value
+        uint32_t frame;
+        std::vector<uint16_t> lut;  // tiles * 256, 8.8 fixed point, kept between frames for blending
+        std::vector<uint8_t> lut8;  // tiles * 256, rounded lut to map pixels
+        std::vector<int> x_bound;   // tiles_x + 1, tile boundaries
+        std::vector<int> y_bound;   // tiles_y + 1
+        std::vector<uint16_t> col_l; // per column, left and right tile index and weight of right tile in [0, 256]
+        std::vector<uint16_t> col_r;
+        std::vector<uint16_t> col_w;
+        std::vector<uint16_t> row_t; // per row, top and bottom tile index and weight of bottom tile in [0, 256]
+        std::vector<uint16_t> row_b;
+        std::vector<uint16_t> row_w;
+        std::vector<uint8_t> luma;  // luma plane of RGB image
+    } clahe_t;
+
+    // tile boundaries, and interpolation between the two nearest tile centers for every pixel of an axis
+    static void _clahe_axis(int size, int tiles, std::vector<int> &bound, std::vector<uint16_t> &idx0, std::vector<uint16_t> &idx1, std::vector<uint16_t> &weight)
+    {
+        bound.resize(tiles + 1);
+        for (int i = 0; i <= tiles; i++)
+            bound[i] = (int)((int64_t)size * i / tiles);
+        idx0.resize(size);
+        idx1.resize(size);
+        weight.resize(size);
+        int t = 0;
+        for (int x = 0; x < size; x++)
+        {
+            while (t < tiles - 1 && x >= (bound[t + 1] + bound[t + 2] - 1) * 0.5)
+                t++;
+            double c0 = (bound[t] + bound[t + 1] - 1) * 0.5;
+            if (x <= c0 || t == tiles - 1)
+            {
+                idx0[x] = idx1[x] = t;
+                weight[x] = 0;
+                continue;
+            }
+            double c1 = (bound[t + 1] + bound[t + 2] - 1) * 0.5;
+            idx0[x] = t;
+            idx1[x] = t + 1;
+            weight[x] = (uint16_t)((x - c0) / (c1 - c0) * 256 + 0.5);
+        }
+    }
+
+    // lut of one tile, 8.8 fixed point
+    static void _clahe_tile_lut(const uint8_t *plane, int stride, int x0, int x1, int y0, int y1, float clip_limit, uint16_t *lut)
+    {
+        uint32_t hist[4][256] = {{0}};
+        int n = x1 - x0;
+        for (int y = y0; y < y1; y++)
+        {
+            const uint8_t *p = plane + y * stride + x0;
+            int x = 0;
+            // four sub histograms, avoid stall on continuous same value
+            for (; x + 4 <= n; x += 4)
+            {
+                hist[0][p[x]]++;
+                hist[1][p[x + 1]]++;
+                hist[2][p[x + 2]]++;
+                hist[3][p[x + 3]]++;
+            }
+            for (; x < n; x++)
+                hist[0][p[x]]++;
+        }
+        for (int i = 0; i < 256; i++)
+            hist[0][i] += hist[1][i] + hist[2][i] + hist[3][i];
+        uint32_t *h = hist[0];
+        uint32_t total = (uint32_t)n * (y1 - y0);
+        if (clip_limit > 0)
+        {
+            uint32_t clip = (uint32_t)(clip_limit * total / 256);
+            if (clip < 1)
+                clip = 1;
+            uint32_t excess = 0;
+            for (int i = 0; i < 256; i++)
+            {
+                if (h[i] > clip)
+                {
+                    excess += h[i] - clip;
+                    h[i] = clip;
+                }
+            }
+            // redistribute excess uniformly, the residual to bins evenly spaced
+            uint32_t batch = excess / 256;
+            uint32_t residual = excess - batch * 256;
+            for (int i = 0; i < 256; i++)
+                h[i] += batch;
+            if (residual > 0)
+            {
+                int step = 256 / residual;
+                if (step < 1)
+                    step = 1;
+                for (int i = 0; i < 256 && residual > 0; i += step, residual--)
+                    h[i]++;
+            }
+        }
+        uint64_t cdf = 0;
+        for (int i = 0; i < 256; i++)
+        {
+            cdf += h[i];
+            lut[i] = (uint16_t)((cdf * 255 * 256 + total / 2) / total);
+        }
+    }
+
+    // map pixels by bilinear interpolation of the four nearest tiles' lut,
+    // CH 1 write plane directly, CH 3 or 4 add luma difference to R, G, B to keep chroma
+    template <int CH>
+    static void _clahe_map(clahe_t *c, int tiles_x, const uint8_t *plane, int plane_stride, uint8_t *data, int stride)
+    {
+        const uint8_t *lut8 = c->lut8.data();
+        #pragma omp parallel for
+        for (int y = 0; y < c->height; y++)
+        {
+            const uint8_t *lut_t = lut8 + c->row_t[y] * tiles_x * 256;
+            const uint8_t *lut_b = lut8 + c->row_b[y] * tiles_x * 256;
+            int wy = c->row_w[y];
+            const uint8_t *src = plane + y * plane_stride;
+            uint8_t *dst = data + y * stride;
+            for (int x = 0; x < c->width; x++)
+            {
+                int v = src[x];
+                int l = c->col_l[x] * 256 + v;
+                int r = c->col_r[x] * 256 + v;
+                int wx = c->col_w[x];
+                int top = lut_t[l] * (256 - wx) + lut_t[r] * wx;
+                int bottom = lut_b[l] * (256 - wx) + lut_b[r] * wx;
+                int out = (top * (256 - wy) + bottom * wy + 32768) >> 16;
+                if (CH == 1)
+                {
+                    dst[x] = out;
+                }
+                else
+                {
+                    int d = out - v;
+                    uint8_t *p = dst + x * CH;
+                    for (int i = 0; i < 3; i++)
+                    {
+                        int t = p[i] + d;
+                        p[i] = t < 0 ? 0 : (t > 255 ? 255 : t);
+                    }
+                }
+            }
+        }
+    }
+
+    template <int CH, int R, int B>
+    static void _clahe_luma(const uint8_t *data, int stride, int width, int height, uint8_t *luma)
+    {
+        #pragma omp parallel for
+        for (int y = 0; y < height; y++)
+        {
+            const uint8_t *p = data + y * stride;
+            uint8_t *l = luma + y * width;
+            for (int x = 0; x < width; x++, p += CH)
+                l[x] = (p[R] * 77 + p[1] * 150 + p[B] * 29 + 128) >> 8;
+        }
+    }
+
+    CLAHE::CLAHE(float clip_limit, int tiles_x, int tiles_y, float temporal, int update_interval)
+    {
+        if (tiles_x < 1 || tiles_y < 1 || tiles_x > CLAHE_MAX_TILES || tiles_y > CLAHE_MAX_TILES)
+        {
+            log::error("CLAHE tiles should in range [1, %d], but got %d x %d\n", CLAHE_MAX_TILES, tiles_x, tiles_y);
+            throw err::Exception(err::ERR_ARGS, "CLAHE tiles error");
+        }
+        if (update_interval < 1)
+            throw err::Exception(err::ERR_ARGS, "CLAHE update_interval should >= 1");
+        _clip_limit = clip_limit;
+        _tiles_x = tiles_x;
+        _tiles_y = tiles_y;
+        _update_interval = update_interval;
+        set_temporal(temporal);
+        clahe_t *c = new clahe_t();
+        c->width = 0;
+        c->height = 0;
+        c->valid = false;
+        c->frame = 0;
+        _handle = c;
+    }
+
+    CLAHE::~CLAHE()
+    {
+        delete (clahe_t *)_handle;
+        _handle = nullptr;
+    }
+
+    void CLAHE::set_temporal(float temporal)
+    {
+        if (temporal < 0 || temporal >= 1)
+        {
+            log::error("CLAHE temporal should in range [0, 1), but got %f\n", temporal);
+            throw err::Exception(err::ERR_ARGS, "CLAHE temporal error");
+        }
+        _temporal = temporal;
+    }
+
+    void CLAHE::reset()
+    {
+        clahe_t *c = (clahe_t *)_handle;
+        c->valid = false;
+        c->frame = 0;
+    }
+
+    err::Err CLAHE::apply(image::Image &img)
+    {
+        clahe_t *c = (clahe_t *)_handle;
+        image::Format format = img.format();
+        int ch = 1;
+        switch (format)
+        {
+        case image::FMT_GRAYSCALE:
+        case image::FMT_YVU420SP:
+        case image::FMT_YUV420SP:
+            break;
+        case image::FMT_RGB888:
+        case image::FMT_BGR888:
+            ch = 3;
+            break;
+        case image::FMT_RGBA8888:
+        case image::FMT_BGRA8888:
+            ch = 4;
+            break;
+        default:
+            log::error("CLAHE not support format: %s\n", image::fmt_names[format].c_str());
+            return err::ERR_ARGS;
+        }
+        int w = img.width();
+        int h = img.height();
+        if (w < _tiles_x || h < _tiles_y)
+        {
+            log::error("CLAHE image size %dx%d less than tiles %dx%d\n", w, h, _tiles_x, _tiles_y);
+            return err::ERR_ARGS;
+        }
+        img.detach();
+        uint8_t *data = (uint8_t *)img.data();
+        int stride = img.stride();
+        if (w != c->width || h != c->height)
+        {
+            c->width = w;
+            c->height = h;
+            c->valid = false;
+            c->frame = 0;
+            c->lut.resize(_tiles_x * _tiles_y * 256);
+            c->lut8.resize(_tiles_x * _tiles_y * 256);
+            _clahe_axis(w, _tiles_x, c->x_bound, c->col_l, c->col_r, c->col_w);
+            _clahe_axis(h, _tiles_y, c->y_bound, c->row_t, c->row_b, c->row_w);
+        }
+
+        // plane to equalize, Y plane for YUV, luma plane for RGB
+        const uint8_t *plane = data;
+        int plane_stride = stride;
+        if (ch > 1)
+        {
+            c->luma.resize((size_t)w * h);
+            if (format == image::FMT_RGB888)
+                _clahe_luma<3, 0, 2>(data, stride, w, h, c->luma.data());
+            else if (format == image::FMT_BGR888)
+                _clahe_luma<3, 2, 0>(data, stride, w, h, c->luma.data());
+            else if (format == image::FMT_RGBA8888)
+                _clahe_luma<4, 0, 2>(data, stride, w, h, c->luma.data());
+            else
+                _clahe_luma<4, 2, 0>(data, stride, w, h, c->luma.data());
+            plane = c->luma.data();
+            plane_stride = w;
+        }
+
+        // update tile luts, all tiles for the first frame, else 1 / update_interval of tiles in turn
+        int tiles = _tiles_x * _tiles_y;
+        bool all = !c->valid || _update_interval <= 1;
+        int phase = c->frame % _update_interval;
+        int keep = c->valid ? (int)(_temporal * 256 + 0.5f) : 0;
+        float clip_limit = _clip_limit;
+        int tiles_x = _tiles_x;
+        #pragma omp parallel for
+        for (int t = 0; t < tiles; t++)
+        {
+            if (!all && t % _update_interval != phase)
+                continue;
+            int tx = t % tiles_x;
+            int ty = t / tiles_x;
+            uint16_t cur[256];
+            _clahe_tile_lut(plane, plane_stride, c->x_bound[tx], c->x_bound[tx + 1], c->y_bound[ty], c->y_bound[ty + 1], clip_limit, cur);
+            uint16_t *lut = c->lut.data() + t * 256;
+            uint8_t *lut8 = c->lut8.data() + t * 256;
+            for (int i = 0; i < 256; i++)
+            {
+                int v = keep ? (lut[i] * keep + cur[i] * (256 - keep) + 128) >> 8 : cur[i];
+                lut[i] = v;
+                lut8[i] = (v + 128) >> 8;
+            }
+        }
+        c->valid = true;
+        c->frame++;
+
+        if (ch == 1)
+            _clahe_map<1>(c, _tiles_x, plane, plane_stride, data, stride);
+        else if (ch == 3)
+            _clahe_map<3>(c, _tiles_x, plane, plane_stride, data, stride);
+        else
+            _clahe_map<4>(c, _tiles_x, plane, plane_stride, data, stride);
+        return err::ERR_NONE;
+    }
+}
@@ -3,14 +3,17 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2025.6.9: Add cmap def.
+ * @update 2026.10.19: Add from_float and Image.apply_cmap, map data to color image in one pass.
  */
 
 #include "maix_image_cmap.hpp"
+#include "maix_image.hpp"
 #include "maix_err.hpp"
 #include <algorithm>
 #include <array>
 #include <cstdint>
 #include <vector>
+#include <math.h>
 
 namespace maix::image
 {
@@ -5875,6 +5878,234 @@ namespace maix::image
         return *_cmap_data[(int)cmap];
     }
 
+    /**
+     * Colormap lookup table of output format,
+     * for RGB888 and BGR888 c0~c2 are bytes of one pixel, for YVU420SP are Y, U, V.
+     */
+    typedef struct
+    {
+        uint8_t c0[256];
+        uint8_t c1[256];
+        uint8_t c2[256];
+    } cmap_lut_t;
+
+    static void _cmap_make_lut(image::CMap cmap, image::Format format, cmap_lut_t *lut)
+    {
+        auto &colors = cmap_colors_rgb(cmap);
+        int n = colors.size();
+        for (int i = 0; i < 256; ++i)
+        {
+            // colormap for classify has less colors, use gray as index cyclically
+            auto &c = colors[n == 256 ? i : i % n];
+            int r = c[0], g = c[1], b = c[2];
+            if (format == image::FMT_RGB888)
+            {
+                lut->c0[i] = r;
+                lut->c1[i] = g;
+                lut->c2[i] = b;
+            }
+            else if (format == image::FMT_BGR888)
+            {
+                lut->c0[i] = b;
+                lut->c1[i] = g;
+                lut->c2[i] = r;
+            }
+            else // BT.601 limited range, same as Image.to_format
+            {
+                lut->c0[i] = 16 + ((66 * r + 129 * g + 25 * b + 128) >> 8);
+                lut->c1[i] = 128 + ((-38 * r - 74 * g + 112 * b + 128) >> 8);
+                lut->c2[i] = 128 + ((112 * r - 94 * g - 18 * b + 128) >> 8);
+            }
+        }
+    }
+
+    // bicubic taps of every output pixel, same as cv::resize INTER_CUBIC
+    static void _cmap_cubic_taps(int in, int out, std::vector<int> &idx, std::vector<float> &weight)
+    {
+        const float A = -0.75f;
+        float scale = (float)in / out;
+        idx.resize(out * 4);
+        weight.resize(out * 4);
+        for (int i = 0; i < out; ++i)
+        {
+            float f = (i + 0.5f) * scale - 0.5f;
+            int x = (int)floorf(f);
+            float t = f - x;
+            float *w = &weight[i * 4];
+            w[0] = ((A * (t + 1) - 5 * A) * (t + 1) + 8 * A) * (t + 1) - 4 * A;
+            w[1] = ((A + 2) * t - (A + 3)) * t * t + 1;
+            w[2] = ((A + 2) * (1 - t) - (A + 3)) * (1 - t) * (1 - t) + 1;
+            w[3] = 1.f - w[0] - w[1] - w[2];
+            for (int k = 0; k < 4; ++k)
+                idx[i * 4 + k] = std::min(std::max(x - 1 + k, 0), in - 1);
+        }
+    }
+
+    static inline uint8_t _cmap_index(float v, float offset, float scale)
+    {
+        float f = (v - offset) * scale;
+        if (!(f > 0)) // include NaN
+            return 0;
+        return f >= 255.f ? 255 : (uint8_t)(f + 0.5f);
+    }
+
+    static inline uint8_t _cmap_index(uint8_t v, float offset, float scale)
+    {
+        return v;
+    }
+
+    /**
+     * Map src to color image, index = (v - offset) * scale, uint8_t src is used as index directly.
+     * @param stride src row stride in elements
+     */
+    template <typename T>
+    static image::Image *_cmap_map(const T *src, int w, int h, int stride, float offset, float scale, const cmap_lut_t &lut,
+                                   int out_w, int out_h, image::Format format)
+    {
+        image::Image *img = new image::Image(out_w, out_h, format);
+        uint8_t *out = (uint8_t *)img->data();
+        uint8_t *uv = out + out_w * out_h;
+        bool resize = out_w != w || out_h != h;
+        bool yuv = format == image::FMT_YVU420SP;
+        std::vector<int> xi, yi;
+        std::vector<float> xw, yw;
+        if (resize)
+        {
+            _cmap_cubic_taps(w, out_w, xi, xw);
+            _cmap_cubic_taps(h, out_h, yi, yw);
+        }
+        // YUV420 process two rows together for chroma
+        int rows = yuv ? 2 : 1;
+        #pragma omp parallel for
+        for (int y0 = 0; y0 < out_h; y0 += rows)
+        {
+            std::vector<uint8_t> index(out_w * rows);
+            std::vector<float> tmp(resize ? w : 0);
+            for (int k = 0; k < rows; ++k)
+            {
+                int y = y0 + k;
+                uint8_t *id = index.data() + k * out_w;
+                if (!resize)
+                {
+                    const T *s = src + y * stride;
+                    for (int x = 0; x < out_w; ++x)
+                        id[x] = _cmap_index(s[x], offset, scale);
+                }
+                else
+                {
+                    // vertical then horizontal, normalize after interpolation
+                    const int *sy = &yi[y * 4];
+                    const float *wy = &yw[y * 4];
+                    const T *r0 = src + sy[0] * stride, *r1 = src + sy[1] * stride;
+                    const T *r2 = src + sy[2] * stride, *r3 = src + sy[3] * stride;
+                    for (int x = 0; x < w; ++x)
+                        tmp[x] = r0[x] * wy[0] + r1[x] * wy[1] + r2[x] * wy[2] + r3[x] * wy[3];
+                    for (int x = 0; x < out_w; ++x)
+                    {
+                        const int *sx = &xi[x * 4];
+                        const float *wx = &xw[x * 4];
+                        float v = tmp[sx[0]] * wx[0] + tmp[sx[1]] * wx[1] + tmp[sx[2]] * wx[2] + tmp[sx[3]] * wx[3];
+                        id[x] = _cmap_index(v, offset, scale);
+                    }
+                }
+                if (yuv)
+                {
+                    uint8_t *d = out + y * out_w;
+                    for (int x = 0; x < out_w; ++x)
+                        d[x] = lut.c0[id[x]];
+                }
+                else
+                {
+                    uint8_t *d = out + y * out_w * 3;
+                    for (int x = 0; x < out_w; ++x)
+                    {
+                        d[x * 3] = lut.c0[id[x]];
+                        d[x * 3 + 1] = lut.c1[id[x]];
+                        d[x * 3 + 2] = lut.c2[id[x]];
+                    }
+                }
+            }
+            if (yuv)
+            {
+                // NV21, V first
+                const uint8_t *i0 = index.data(), *i1 = index.data() + out_w;
+                uint8_t *d = uv + y0 / 2 * out_w;
+                for (int x = 0; x < out_w; x += 2)
+                {
+                    d[x] = (lut.c2[i0[x]] + lut.c2[i0[x + 1]] + lut.c2[i1[x]] + lut.c2[i1[x + 1]] + 2) >> 2;
+                    d[x + 1] = (lut.c1[i0[x]] + lut.c1[i0[x + 1]] + lut.c1[i1[x]] + lut.c1[i1[x + 1]] + 2) >> 2;
+                }
+            }
+        }
+        return img;
+    }
+
+    static void _cmap_check_args(int w, int h, image::CMap cmap, image::Size &out_size, image::Format format)
+    {
+        err::check_bool_raise(w > 0 && h > 0, "cmap data size invalid");
+        err::check_bool_raise((int)cmap >= 0 && cmap < image::CMap::MAX, "cmap invalid");
+        err::check_bool_raise(format == image::FMT_RGB888 || format == image::FMT_BGR888 || format == image::FMT_YVU420SP,
+                              "cmap output format only support RGB888, BGR888, YVU420SP");
+        if (out_size.width() <= 0 || out_size.height() <= 0)
+            out_size = image::Size(w, h);
+        if (format == image::FMT_YVU420SP)
+            err::check_bool_raise(out_size.width() % 2 == 0 && out_size.height() % 2 == 0, "YVU420SP output size must be even");
+    }
+
+    image::Image *from_float(const float *data, int w, int h, float min_v, float max_v, image::CMap cmap, image::Size out_size, image::Format format)
+    {
+        err::check_null_raise((void *)data, "from_float data is null");
+        _cmap_check_args(w, h, cmap, out_size, format);
+        if (min_v >= max_v)
+        {
+            float mn = data[0], mx = data[0];
+            int n = w * h;
+            #pragma omp parallel for reduction(min:mn) reduction(max:mx)
+            for (int i = 0; i < n; ++i)
+            {
+                mn = std::min(mn, data[i]);
+                mx = std::max(mx, data[i]);
+            }
+            min_v = mn;
+            max_v = mx;
+        }
+        float scale = 255.f / (max_v - min_v);
+        if (!(max_v > min_v))
+        {
+            // all values equal, map to middle color
+            scale = 1;
+            min_v -= 127.f;
+        }
+        cmap_lut_t lut;
+        _cmap_make_lut(cmap, format, &lut);
+        return _cmap_map(data, w, h, w, min_v, scale, lut, out_size.width(), out_size.height(), format);
+    }
+
+    image::Image *from_float(tensor::Tensor *tensor, float min_v, float max_v, image::CMap cmap, image::Size out_size, image::Format format)
+    {
+        err::check_null_raise(tensor, "from_float tensor is null");
+        err::check_bool_raise(tensor->dtype() == tensor::FLOAT32, "from_float tensor dtype must be float32");
+        std::vector<int> dims;
+        for (int d : tensor->shape())
+        {
+            if (d != 1)
+                dims.push_back(d);
+        }
+        err::check_bool_raise(dims.size() <= 2, "from_float tensor shape should be [h, w]");
+        int h = dims.size() == 2 ? dims[0] : 1;
+        int w = dims.size() >= 1 ? dims.back() : 1;
+        return from_float((const float *)tensor->data(), w, h, min_v, max_v, cmap, out_size, format);
+    }
+
+    image::Image *Image::apply_cmap(image::CMap cmap, image::Size out_size, image::Format format)
+    {
+        err::check_bool_raise(_format == image::FMT_GRAYSCALE, "apply_cmap only support GRAYSCALE image");
+        _cmap_check_args(_width, _height, cmap, out_size, format);
+        cmap_lut_t lut;
+        _cmap_make_lut(cmap, format, &lut);
+        return _cmap_map((const uint8_t *)_data, _width, _height, _stride, 0, 1, lut, out_size.width(), out_size.height(), format);
+    }
+
 }; // namespace maix::image
 
 
@@ -0,0 +1,940 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add DisplacementTracker, displacement of every frame against a cached reference.
+ */
+
+#include "maix_image_displacement.hpp"
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <omp.h>
+
+namespace maix::image
+{
+    #define DISP_LK_RADIUS (4)                                         // LK window is (2 * r + 1) ^ 2
+    #define DISP_LK_PATCH ((2 * DISP_LK_RADIUS + 1) * (2 * DISP_LK_RADIUS + 1))
+    #define DISP_LK_ITERS (20)
+    #define DISP_LK_MIN_ERR (4.0f)                                     // tracked patch error limit is max(min_err, contrast * ratio)
+    #define DISP_LK_ERR_RATIO (0.5f)
+    #define DISP_UPDATE_MIN_RESPONSE (0.05f)                           // not blend reference with frames not matched
+
+    typedef struct
+    {
+        int n;
+        std::vector<int> rev;
+        std::vector<float> tw_re; // twiddles of stage with half size h are at [h, 2h), contiguous for butterflies
+        std::vector<float> tw_im;
+    } fft_plan_t;
+
+    typedef struct
+    {
+        bool has_ref;
+        int roi_w; // roi size of reference
+        int roi_h;
+        std::vector<float> gray;    // working gray image of frame
+        std::vector<float> gray2;   // rotation and scale fixed frame
+
+        // phase correlation
+        fft_plan_t pw; // plan of width
+        fft_plan_t ph; // plan of height
+        std::vector<float> window;  // hann window, h x w
+        std::vector<float> hp;      // high pass filter of magnitude spectrum, w x h(transposed spectrum layout)
+        std::vector<float> lp_x;    // log polar sample coordinates in spectrum, h(angle) x w(log radius)
+        std::vector<float> lp_y;
+        float lp_base;              // radius ratio of adjacent log polar columns
+        std::vector<float> ref_re;  // reference spectrum, w x h
+        std::vector<float> ref_im;
+        std::vector<float> ref_lp_re; // reference log polar magnitude spectrum's spectrum, w x h
+        std::vector<float> ref_lp_im;
+        std::vector<float> re;      // work buffers
+        std::vector<float> im;
+        std::vector<float> tre;
+        std::vector<float> tim;
+        std::vector<float> mag;
+        std::vector<float> cur_re;  // aligned frame spectrum for reference update
+        std::vector<float> cur_im;
+
+        // lucas kanade
+        std::vector<std::vector<float>> ref_pyr;
+        std::vector<std::vector<float>> pyr;
+        std::vector<float> pts;     // corners of reference, x, y in working pixels
+        std::vector<float> tmpl;    // templates, points x levels x DISP_LK_PATCH
+        std::vector<float> gx;      // gradients of templates
+        std::vector<float> gy;
+        std::vector<float> hinv;    // inverse hessian of templates, points x levels x 3(xx, xy, yy)
+        std::vector<float> max_err; // max mean abs error of tracked patch, by template contrast
+        std::vector<float> moved;   // tracked points, x, y
+        std::vector<uint8_t> ok;
+        float last[4];              // last motion a, b, tx, ty(x' = a * x - b * y + tx, y' = b * x + a * y + ty), as initial guess
+    } disp_t;
+
+    static void _fft_plan(fft_plan_t &p, int n)
+    {
+        int bits = 0;
+        while ((1 << bits) < n)
+            bits++;
+        p.n = n;
+        p.rev.resize(n);
+        for (int i = 0; i < n; i++)
+        {
+            int r = 0;
+            for (int b = 0; b < bits; b++)
+            {
+                if (i & (1 << b))
+                    r |= 1 << (bits - 1 - b);
+            }
+            p.rev[i] = r;
+        }
+        p.tw_re.resize(n);
+        p.tw_im.resize(n);
+        for (int h = 1; h < n; h <<= 1)
+        {
+            for (int j = 0; j < h; j++)
+            {
+                double a = -M_PI * j / h;
+                p.tw_re[h + j] = (float)cos(a);
+                p.tw_im[h + j] = (float)sin(a);
+            }
+        }
+    }
+
+    // in place radix 2 complex fft of one row, not scaled.
+    // Real and imaginary parts are split arrays, so butterflies of a stage are contiguous loops vectorized by compiler.
+    static void _fft_row(const fft_plan_t &p, float *re, float *im, bool inverse)
+    {
+        int n = p.n;
+        for (int i = 0; i < n; i++)
+        {
+            int j = p.rev[i];
+            if (j > i)
+            {
+                std::swap(re[i], re[j]);
+                std::swap(im[i], im[j]);
+            }
+        }
+        float sign = inverse ? -1.0f : 1.0f;
+        for (int h = 1; h < n; h <<= 1)
+        {
+            const float *wr = p.tw_re.data() + h;
+            const float *wi = p.tw_im.data() + h;
+            for (int s = 0; s < n; s += 2 * h)
+            {
+                float *ar = re + s;
+                float *ai = im + s;
+                float *br = re + s + h;
+                float *bi = im + s + h;
+                for (int j = 0; j < h; j++)
+                {
+                    float w_i = wi[j] * sign;
+                    float tr = br[j] * wr[j] - bi[j] * w_i;
+                    float ti = br[j] * w_i + bi[j] * wr[j];
+                    br[j] = ar[j] - tr;
+                    bi[j] = ai[j] - ti;
+                    ar[j] += tr;
+                    ai[j] += ti;
+                }
+            }
+        }
+    }
+
+    static void _fft_rows(const fft_plan_t &p, float *re, float *im, int rows, bool inverse)
+    {
+        #pragma omp parallel for
+        for (int y = 0; y < rows; y++)
+            _fft_row(p, re + y * p.n, im + y * p.n, inverse);
+    }
+
+    static void _transpose(const float *src, float *dst, int rows, int cols)
+    {
+        const int block = 16;
+        #pragma omp parallel for
+        for (int y0 = 0; y0 < rows; y0 += block)
+        {
+            int y1 = std::min(y0 + block, rows);
+            for (int x0 = 0; x0 < cols; x0 += block)
+            {
+                int x1 = std::min(x0 + block, cols);
+                for (int y = y0; y < y1; y++)
+                    for (int x = x0; x < x1; x++)
+                        dst[x * rows + y] = src[y * cols + x];
+            }
+        }
+    }
+
+    // forward fft of h x w image in re/im, spectrum is transposed to w x h in tre/tim, save a transpose back
+    static void _fft2d(disp_t *d, int w, int h)
+    {
+        _fft_rows(d->pw, d->re.data(), d->im.data(), h, false);
+        _transpose(d->re.data(), d->tre.data(), h, w);
+        _transpose(d->im.data(), d->tim.data(), h, w);
+        _fft_rows(d->ph, d->tre.data(), d->tim.data(), w, false);
+    }
+
+    // inverse of _fft2d, w x h spectrum in tre/tim, real part of h x w result in re, scaled by w * h
+    static void _ifft2d(disp_t *d, int w, int h)
+    {
+        _fft_rows(d->ph, d->tre.data(), d->tim.data(), w, true);
+        _transpose(d->tre.data(), d->re.data(), w, h);
+        _transpose(d->tim.data(), d->im.data(), w, h);
+        _fft_rows(d->pw, d->re.data(), d->im.data(), h, true);
+    }
+
+    // source pixels and weights of every output pixel on one axis, area average when downscale, bilinear when upscale,
+    // keep sample positions exact so subpixel results are not biased by uneven boxes
+    static int _area_axis(int offset, int size, int n, std::vector<int> &start, std::vector<float> &weight)
+    {
+        double s = (double)size / n;
+        int taps = s > 1 ? (int)ceil(s) + 1 : 2;
+        start.resize(n);
+        weight.assign(n * taps, 0);
+        for (int i = 0; i < n; i++)
+        {
+            float *wt = weight.data() + i * taps;
+            if (s <= 1)
+            {
+                double c = std::max(0.0, std::min((i + 0.5) * s - 0.5, size - 1.0));
+                int x0 = std::min((int)c, size - 2 < 0 ? 0 : size - 2);
+                start[i] = offset + x0;
+                wt[1] = size > 1 ? (float)(c - x0) : 0;
+                wt[0] = 1 - wt[1];
+                continue;
+            }
+            double a = i * s, b = (i + 1) * s;
+            int x0 = (int)floor(a);
+            start[i] = offset + x0;
+            for (int k = 0; k < taps && x0 + k < size; k++)
+            {
+                double lo = std::max(a, (double)(x0 + k)), hi = std::min(b, (double)(x0 + k + 1));
+                if (hi > lo)
+                    wt[k] = (float)((hi - lo) / s);
+            }
+        }
+        return taps;
+    }
+
+    // resample roi to w x h gray, luma for color formats
+    static void _disp_gray(image::Image &img, const std::vector<int> &roi, int w, int h, float *out)
+    {
+        int ch = 1, ro = 0, go = 0, bo = 0;
+        switch (img.format())
+        {
+        case image::FMT_GRAYSCALE:
+        case image::FMT_YVU420SP:
+        case image::FMT_YUV420SP:
+            break;
+        case image::FMT_RGB888:
+            ch = 3, go = 1, bo = 2;
+            break;
+        case image::FMT_BGR888:
+            ch = 3, ro = 2, go = 1;
+            break;
+        case image::FMT_RGBA8888:
+            ch = 4, go = 1, bo = 2;
+            break;
+        case image::FMT_BGRA8888:
+            ch = 4, ro = 2, go = 1;
+            break;
+        default:
+            log::error("DisplacementTracker not support format: %s\n", image::fmt_names[img.format()].c_str());
+            throw err::Exception(err::ERR_ARGS, "DisplacementTracker not support format");
+        }
+        const uint8_t *data = (const uint8_t *)img.data();
+        int stride = img.stride();
+        std::vector<int> xs, ys;
+        std::vector<float> xw, yw;
+        int xt = _area_axis(roi[0], roi[2], w, xs, xw);
+        int yt = _area_axis(roi[1], roi[3], h, ys, yw);
+        #pragma omp parallel for
+        for (int y = 0; y < h; y++)
+        {
+            for (int x = 0; x < w; x++)
+            {
+                float sum = 0;
+                for (int j = 0; j < yt; j++)
+                {
+                    float wy = yw[y * yt + j];
+                    if (wy == 0)
+                        continue;
+                    const uint8_t *p = data + (ys[y] + j) * stride + xs[x] * ch;
+                    const float *wx = xw.data() + x * xt;
+                    float row = 0;
+                    for (int i = 0; i < xt; i++, p += ch)
+                    {
+                        if (wx[i] != 0)
+                            row += wx[i] * (p[ro] * 77 + p[go] * 150 + p[bo] * 29);
+                    }
+                    sum += row * wy;
+                }
+                out[y * w + x] = sum * (1.0f / 256);
+            }
+        }
+    }
+
+    // remove mean and apply window, to re and clear im
+    static void _disp_prepare(disp_t *d, const float *gray, int n)
+    {
+        double sum = 0;
+        for (int i = 0; i < n; i++)
+            sum += gray[i];
+        float mean = (float)(sum / n);
+        const float *win = d->window.data();
+        float *re = d->re.data();
+        for (int i = 0; i < n; i++)
+            re[i] = (gray[i] - mean) * win[i];
+        std::fill(d->im.begin(), d->im.end(), 0.0f);
+    }
+
+    // normalized cross power spectrum of spectrum in tre/tim and reference, in place
+    static void _cross_power(disp_t *d, const float *ref_re, const float *ref_im, int n)
+    {
+        float *re = d->tre.data();
+        float *im = d->tim.data();
+        #pragma omp parallel for
+        for (int i = 0; i < n; i++)
+        {
+            float r = re[i] * ref_re[i] + im[i] * ref_im[i];
+            float m = im[i] * ref_re[i] - re[i] * ref_im[i];
+            float inv = 1.0f / sqrtf(r * r + m * m + 1e-12f);
+            re[i] = r * inv;
+            im[i] = m * inv;
+        }
+    }
+
+    // peak of correlation surface in re(h x w), subpixel by parabola fit, shift in (-w/2, w/2], returns normalized peak
+    static float _corr_peak(const float *re, int w, int h, float &dx, float &dy)
+    {
+        int n = w * h;
+        int idx = (int)(std::max_element(re, re + n) - re);
+        int px = idx % w, py = idx / w;
+        float c = re[idx];
+        auto sub = [c](float l, float r)
+        {
+            float den = l - 2 * c + r;
+            return den < 0 ? std::max(-0.5f, std::min(0.5f, 0.5f * (l - r) / den)) : 0.0f;
+        };
+        float fx = px + sub(re[py * w + (px + w - 1) % w], re[py * w + (px + 1) % w]);
+        float fy = py + sub(re[((py + h - 1) % h) * w + px], re[((py + 1) % h) * w + px]);
+        dx = fx > w / 2 ? fx - w : fx;
+        dy = fy > h / 2 ? fy - h : fy;
+        float response = c / n;
+        return std::max(0.0f, std::min(1.0f, response));
+    }
+
+    // log polar transform of high passed magnitude of spectrum in tre/tim to re, rows are angle [0, pi), columns are log radius
+    static void _disp_logpolar(disp_t *d, int w, int h)
+    {
+        int n = w * h;
+        float *mag = d->mag.data();
+        const float *re = d->tre.data();
+        const float *im = d->tim.data();
+        const float *hp = d->hp.data();
+        for (int i = 0; i < n; i++)
+            mag[i] = sqrtf(re[i] * re[i] + im[i] * im[i]) * hp[i];
+        float *out = d->re.data();
+        const float *lx = d->lp_x.data();
+        const float *ly = d->lp_y.data();
+        // spectrum layout is w(kx) x h(ky), wrap around
+        #pragma omp parallel for
+        for (int i = 0; i < n; i++)
+        {
+            float x = lx[i], y = ly[i];
+            int x0 = (int)floorf(x), y0 = (int)floorf(y);
+            float ax = x - x0, ay = y - y0;
+            int x1 = (x0 + 1 + w) % w, y1 = (y0 + 1 + h) % h;
+            x0 = (x0 + w) % w;
+            y0 = (y0 + h) % h;
+            float v0 = mag[x0 * h + y0] * (1 - ay) + mag[x0 * h + y1] * ay;
+            float v1 = mag[x1 * h + y0] * (1 - ay) + mag[x1 * h + y1] * ay;
+            out[i] = v0 * (1 - ax) + v1 * ax;
+        }
+    }
+
+    static float _sample(const float *img, int w, int h, float x, float y)
+    {
+        x = std::max(0.0f, std::min(x, w - 1.001f));
+        y = std::max(0.0f, std::min(y, h - 1.001f));
+        int x0 = (int)x, y0 = (int)y;
+        float ax = x - x0, ay = y - y0;
+        const float *p = img + y0 * w + x0;
+        return (p[0] * (1 - ax) + p[1] * ax) * (1 - ay) + (p[w] * (1 - ax) + p[w + 1] * ax) * ay;
+    }
+
+    // gray2(p) = gray(c + s * R(angle) * (p - c)), undo rotation and scale of frame
+    static void _disp_unrotate(disp_t *d, int w, int h, float angle, float scale)
+    {
+        float a = scale * cosf(angle), b = scale * sinf(angle);
+        float cx = (w - 1) * 0.5f, cy = (h - 1) * 0.5f;
+        const float *src = d->gray.data();
+        float *dst = d->gray2.data();
+        #pragma omp parallel for
+        for (int y = 0; y < h; y++)
+        {
+            for (int x = 0; x < w; x++)
+            {
+                float px = x - cx, py = y - cy;
+                dst[y * w + x] = _sample(src, w, h, cx + a * px - b * py, cy + b * px + a * py);
+            }
+        }
+    }
+
+    static void _pyramid(std::vector<std::vector<float>> &pyr, const float *gray, int w, int h, int levels)
+    {
+        pyr.resize(levels);
+        pyr[0].assign(gray, gray + w * h);
+        for (int l = 1; l < levels; l++)
+        {
+            int pw = w >> (l - 1), nw = w >> l, nh = h >> l;
+            pyr[l].resize(nw * nh);
+            const float *src = pyr[l - 1].data();
+            float *dst = pyr[l].data();
+            for (int y = 0; y < nh; y++)
+            {
+                const float *r0 = src + 2 * y * pw;
+                const float *r1 = r0 + pw;
+                for (int x = 0; x < nw; x++)
+                    dst[y * nw + x] = (r0[2 * x] + r0[2 * x + 1] + r1[2 * x] + r1[2 * x + 1]) * 0.25f;
+            }
+        }
+    }
+
+    // corners with largest minimum eigenvalue of structure tensor, best one per grid cell
+    static void _lk_corners(const float *img, int w, int h, int max_points, std::vector<float> &pts)
+    {
+        std::vector<float> ixx(w * h, 0), ixy(w * h, 0), iyy(w * h, 0), eig(w * h, 0);
+        for (int y = 1; y < h - 1; y++)
+        {
+            for (int x = 1; x < w - 1; x++)
+            {
+                float gx = (img[y * w + x + 1] - img[y * w + x - 1]) * 0.5f;
+                float gy = (img[(y + 1) * w + x] - img[(y - 1) * w + x]) * 0.5f;
+                ixx[y * w + x] = gx * gx;
+                ixy[y * w + x] = gx * gy;
+                iyy[y * w + x] = gy * gy;
+            }
+        }
+        int margin = DISP_LK_RADIUS + 2;
+        float max_eig = 0;
+        for (int y = margin; y < h - margin; y++)
+        {
+            for (int x = margin; x < w - margin; x++)
+            {
+                float a = 0, b = 0, c = 0;
+                for (int j = -2; j <= 2; j++)
+                {
+                    for (int i = -2; i <= 2; i++)
+                    {
+                        int k = (y + j) * w + x + i;
+                        a += ixx[k];
+                        b += ixy[k];
+                        c += iyy[k];
+                    }
+                }
+                float e = (a + c) * 0.5f - sqrtf((a - c) * (a - c) * 0.25f + b * b);
+                eig[y * w + x] = e;
+                max_eig = std::max(max_eig, e);
+            }
+        }
+        pts.clear();
+        if (max_eig <= 0)
+            return;
+        int grid = std::max(1, (int)ceilf(sqrtf((float)max_points)));
+        int gw = std::max(1, (w - 2 * margin) / grid), gh = std::max(1, (h - 2 * margin) / grid);
+        for (int gy = margin; gy + gh <= h - margin; gy += gh)
+        {
+            for (int gx = margin; gx + gw <= w - margin; gx += gw)
+            {
+                float best = max_eig * 0.01f;
+                int bx = -1, by = -1;
+                for (int y = gy; y < gy + gh; y++)
+                {
+                    for (int x = gx; x < gx + gw; x++)
+                    {
+                        if (eig[y * w + x] > best)
+                        {
+                            best = eig[y * w + x];
+                            bx = x;
+                            by = y;
+                        }
+                    }
+                }
+                if (bx >= 0 && (int)pts.size() < max_points * 2)
+                {
+                    pts.push_back(bx);
+                    pts.push_back(by);
+                }
+            }
+        }
+    }
+
+    // fit x' = a * x - b * y + tx, y' = b * x + a * y + ty of points relative to center,
+    // or translation only(a = 1, b = 0), iteratively drop outliers. Returns inlier number.
+    static int _fit_motion(const float *src, const float *dst, const uint8_t *ok, int n, bool similarity, float cx, float cy, float m[4])
+    {
+        std::vector<uint8_t> in(ok, ok + n);
+        std::vector<float> res;
+        int inliers = 0;
+        m[0] = 1, m[1] = 0, m[2] = 0, m[3] = 0;
+        for (int iter = 0; iter < 4; iter++)
+        {
+            double sx = 0, sy = 0, dx = 0, dy = 0;
+            int cnt = 0;
+            for (int i = 0; i < n; i++)
+            {
+                if (!in[i])
+                    continue;
+                sx += src[2 * i] - cx;
+                sy += src[2 * i + 1] - cy;
+                dx += dst[2 * i] - cx;
+                dy += dst[2 * i + 1] - cy;
+                cnt++;
+            }
+            if (cnt < (similarity ? 2 : 1))
+                return 0;
+            sx /= cnt, sy /= cnt, dx /= cnt, dy /= cnt;
+            double a = 1, b = 0;
+            if (similarity)
+            {
+                double num_a = 0, num_b = 0, den = 0;
+                for (int i = 0; i < n; i++)
+                {
+                    if (!in[i])
+                        continue;
+                    double px = src[2 * i] - cx - sx, py = src[2 * i + 1] - cy - sy;
+                    double qx = dst[2 * i] - cx - dx, qy = dst[2 * i + 1] - cy - dy;
+                    num_a += px * qx + py * qy;
+                    num_b += px * qy - py * qx;
+                    den += px * px + py * py;
+                }
+                if (den <= 0)
+                    return 0;
+                a = num_a / den;
+                b = num_b / den;
+            }
+            m[0] = (float)a;
+            m[1] = (float)b;
+            m[2] = (float)(dx - (a * sx - b * sy));
+            m[3] = (float)(dy - (b * sx + a * sy));
+            // residuals of all tracked points, keep points near the motion
+            res.clear();
+            for (int i = 0; i < n; i++)
+            {
+                if (!in[i])
+                    continue;
+                float px = src[2 * i] - cx, py = src[2 * i + 1] - cy;
+                float ex = m[0] * px - m[1] * py + m[2] - (dst[2 * i] - cx);
+                float ey = m[1] * px + m[0] * py + m[3] - (dst[2 * i + 1] - cy);
+                res.push_back(sqrtf(ex * ex + ey * ey));
+            }
+            std::vector<float> sorted = res;
+            std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+            float th = std::max(0.5f, sorted[sorted.size() / 2] * 3);
+            inliers = 0;
+            for (int i = 0; i < n; i++)
+            {
+                if (!ok[i])
+                {
+                    in[i] = 0;
+                    continue;
+                }
+                float px = src[2 * i] - cx, py = src[2 * i + 1] - cy;
+                float ex = m[0] * px - m[1] * py + m[2] - (dst[2 * i] - cx);
+                float ey = m[1] * px + m[0] * py + m[3] - (dst[2 * i + 1] - cy);
+                in[i] = sqrtf(ex * ex + ey * ey) <= th;
+                inliers += in[i];
+            }
+        }
+        return inliers;
+    }
+
+    // track corners of reference from the coarsest level, initial position by guess motion, then fit motion of tracked corners
+    static int _lk_track(disp_t *d, int w, int h, int levels, bool similarity, const float guess[4], float m[4])
+    {
+        int np = (int)d->pts.size() / 2;
+        float cx = (w - 1) * 0.5f, cy = (h - 1) * 0.5f;
+        #pragma omp parallel for
+        for (int i = 0; i < np; i++)
+        {
+            float px = d->pts[2 * i], py = d->pts[2 * i + 1];
+            float rx = px - cx, ry = py - cy;
+            float ux = guess[0] * rx - guess[1] * ry + guess[2] + cx - px;
+            float uy = guess[1] * rx + guess[0] * ry + guess[3] + cy - py;
+            bool ok = true;
+            float err_sum = 0;
+            for (int l = levels - 1; l >= 0; l--)
+            {
+                const float *hi = d->hinv.data() + (i * levels + l) * 3;
+                if (hi[0] == 0 && hi[2] == 0)
+                {
+                    ok = false;
+                    break;
+                }
+                const float *img_l = d->pyr[l].data();
+                int lw = w >> l, lh = h >> l;
+                float s = 1.0f / (1 << l);
+                float lx = px * s, ly = py * s;
+                float vx = ux * s, vy = uy * s;
+                int base = (i * levels + l) * DISP_LK_PATCH;
+                const float *t = d->tmpl.data() + base;
+                const float *gx = d->gx.data() + base;
+                const float *gy = d->gy.data() + base;
+                for (int iter = 0; iter < DISP_LK_ITERS; iter++)
+                {
+                    float bx = 0, by = 0;
+                    err_sum = 0;
+                    int k = 0;
+                    for (int y = -DISP_LK_RADIUS; y <= DISP_LK_RADIUS; y++)
+                    {
+                        for (int x = -DISP_LK_RADIUS; x <= DISP_LK_RADIUS; x++, k++)
+                        {
+                            float e = _sample(img_l, lw, lh, lx + x + vx, ly + y + vy) - t[k];
+                            bx += gx[k] * e;
+                            by += gy[k] * e;
+                            err_sum += fabsf(e);
+                        }
+                    }
+                    float dvx = hi[0] * bx + hi[1] * by;
+                    float dvy = hi[1] * bx + hi[2] * by;
+                    vx -= dvx;
+                    vy -= dvy;
+                    if (dvx * dvx + dvy * dvy < 1e-4f)
+                        break;
+                }
+                ux = vx / s;
+                uy = vy / s;
+            }
+            float qx = px + ux, qy = py + uy;
+            d->moved[2 * i] = qx;
+            d->moved[2 * i + 1] = qy;
+            d->ok[i] = ok && err_sum / DISP_LK_PATCH < d->max_err[i] && qx >= 0 && qy >= 0 && qx <= w - 1 && qy <= h - 1;
+        }
+        return _fit_motion(d->pts.data(), d->moved.data(), d->ok.data(), np, similarity, cx, cy, m);
+    }
+
+    DisplacementTracker::DisplacementTracker(image::DisplacementMethod method, int width, int height, bool rotation_scale, float update_rate, int points, int levels)
+    {
+        if (width < 16 || height < 16 || width > 1024 || height > 1024)
+        {
+            log::error("DisplacementTracker size should in range [16, 1024], but got %dx%d\n", width, height);
+            throw err::Exception(err::ERR_ARGS, "DisplacementTracker size error");
+        }
+        if (method == image::DisplacementMethod::DISPLACEMENT_PHASE && ((width & (width - 1)) || (height & (height - 1))))
+        {
+            log::error("DisplacementTracker size should be power of 2 for phase correlation, but got %dx%d\n", width, height);
+            throw err::Exception(err::ERR_ARGS, "DisplacementTracker size error");
+        }
+        if (update_rate < 0 || update_rate >= 1)
+        {
+            log::error("DisplacementTracker update_rate should in range [0, 1), but got %f\n", update_rate);
+            throw err::Exception(err::ERR_ARGS, "DisplacementTracker update_rate error");
+        }
+        if (method == image::DisplacementMethod::DISPLACEMENT_LK && (points < 1 || levels < 1 || (std::min(width, height) >> (levels - 1)) < 2 * DISP_LK_RADIUS + 4))
+        {
+            log::error("DisplacementTracker points %d or levels %d invalid for size %dx%d\n", points, levels, width, height);
+            throw err::Exception(err::ERR_ARGS, "DisplacementTracker points or levels error");
+        }
+        _method = method;
+        _width = width;
+        _height = height;
+        _rotation_scale = rotation_scale;
+        _update_rate = update_rate;
+        _points = points;
+        _levels = levels;
+
+        disp_t *d = new disp_t();
+        int n = width * height;
+        d->has_ref = false;
+        d->roi_w = 0;
+        d->roi_h = 0;
+        d->gray.resize(n);
+        d->gray2.resize(n);
+        if (method == image::DisplacementMethod::DISPLACEMENT_PHASE)
+        {
+            _fft_plan(d->pw, width);
+            _fft_plan(d->ph, height);
+            d->re.resize(n);
+            d->im.resize(n);
+            d->tre.resize(n);
+            d->tim.resize(n);
+            d->window.resize(n);
+            for (int y = 0; y < height; y++)
+            {
+                float wy = 0.5f - 0.5f * cosf(2 * M_PI * y / height);
+                for (int x = 0; x < width; x++)
+                    d->window[y * width + x] = wy * (0.5f - 0.5f * cosf(2 * M_PI * x / width));
+            }
+            if (rotation_scale)
+            {
+                d->mag.resize(n);
+                d->hp.resize(n);
+                for (int kx = 0; kx < width; kx++)
+                {
+                    float fx = (kx < width / 2 ? kx : kx - width) / (float)width;
+                    for (int ky = 0; ky < height; ky++)
+                    {
+                        float fy = (ky < height / 2 ? ky : ky - height) / (float)height;
+                        float c = cosf(M_PI * fx) * cosf(M_PI * fy);
+                        d->hp[kx * height + ky] = (1 - c) * (2 - c);
+                    }
+                }
+                // radius from 1 bin to nyquist, in cycles per working pixel
+                float r_min = 1.0f / std::min(width, height);
+                d->lp_base = powf(0.5f / r_min, 1.0f / (width - 1));
+                d->lp_x.resize(n);
+                d->lp_y.resize(n);
+                for (int y = 0; y < height; y++)
+                {
+                    float theta = M_PI * y / height;
+                    for (int x = 0; x < width; x++)
+                    {
+                        float r = r_min * powf(d->lp_base, (float)x);
+                        d->lp_x[y * width + x] = r * cosf(theta) * width;
+                        d->lp_y[y * width + x] = r * sinf(theta) * height;
+                    }
+                }
+            }
+        }
+        _handle = d;
+    }
+
+    DisplacementTracker::~DisplacementTracker()
+    {
+        delete (disp_t *)_handle;
+        _handle = nullptr;
+    }
+
+    void DisplacementTracker::reset()
+    {
+        disp_t *d = (disp_t *)_handle;
+        d->has_ref = false;
+    }
+
+    bool DisplacementTracker::has_reference()
+    {
+        disp_t *d = (disp_t *)_handle;
+        return d->has_ref;
+    }
+
+    static std::vector<int> _disp_roi(image::Image &img, const std::vector<int> &roi)
+    {
+        if (roi.empty())
+            return {0, 0, img.width(), img.height()};
+        if (roi.size() != 4 || roi[0] < 0 || roi[1] < 0 || roi[2] <= 0 || roi[3] <= 0 ||
+            roi[0] + roi[2] > img.width() || roi[1] + roi[3] > img.height())
+        {
+            log::error("DisplacementTracker roi invalid\n");
+            throw err::Exception(err::ERR_ARGS, "DisplacementTracker roi invalid");
+        }
+        return roi;
+    }
+
+    err::Err DisplacementTracker::set_reference(image::Image &img, std::vector<int> roi)
+    {
+        disp_t *d = (disp_t *)_handle;
+        int w = _width, h = _height, n = w * h;
+        try
+        {
+            roi = _disp_roi(img, roi);
+            _disp_gray(img, roi, w, h, d->gray.data());
+        }
+        catch (err::Exception &e)
+        {
+            return e.code();
+        }
+        if (_method == image::DisplacementMethod::DISPLACEMENT_PHASE)
+        {
+            _disp_prepare(d, d->gray.data(), n);
+            _fft2d(d, w, h);
+            d->ref_re = d->tre;
+            d->ref_im = d->tim;
+            if (_rotation_scale)
+            {
+                _disp_logpolar(d, w, h);
+                std::fill(d->im.begin(), d->im.end(), 0.0f);
+                _fft2d(d, w, h);
+                d->ref_lp_re = d->tre;
+                d->ref_lp_im = d->tim;
+            }
+        }
+        else
+        {
+            _pyramid(d->ref_pyr, d->gray.data(), w, h, _levels);
+            _lk_corners(d->gray.data(), w, h, _points, d->pts);
+            int np = (int)d->pts.size() / 2;
+            if (np == 0)
+            {
+                log::warn("DisplacementTracker no corner found in reference\n");
+                return err::ERR_NOT_FOUND;
+            }
+            // templates, gradients and inverse hessians of every point and level, reused by every frame(inverse compositional)
+            d->tmpl.resize(np * _levels * DISP_LK_PATCH);
+            d->gx.resize(d->tmpl.size());
+            d->gy.resize(d->tmpl.size());
+            d->hinv.resize(np * _levels * 3);
+            d->max_err.resize(np);
+            #pragma omp parallel for
+            for (int i = 0; i < np; i++)
+            {
+                for (int l = 0; l < _levels; l++)
+                {
+                    const float *img_l = d->ref_pyr[l].data();
+                    int lw = w >> l, lh = h >> l;
+                    float s = 1.0f / (1 << l);
+                    float px = d->pts[2 * i] * s, py = d->pts[2 * i + 1] * s;
+                    int base = (i * _levels + l) * DISP_LK_PATCH;
+                    float a = 0, b = 0, c = 0;
+                    int k = 0;
+                    for (int y = -DISP_LK_RADIUS; y <= DISP_LK_RADIUS; y++)
+                    {
+                        for (int x = -DISP_LK_RADIUS; x <= DISP_LK_RADIUS; x++, k++)
+                        {
+                            float gx = (_sample(img_l, lw, lh, px + x + 1, py + y) - _sample(img_l, lw, lh, px + x - 1, py + y)) * 0.5f;
+                            float gy = (_sample(img_l, lw, lh, px + x, py + y + 1) - _sample(img_l, lw, lh, px + x, py + y - 1)) * 0.5f;
+                            d->tmpl[base + k] = _sample(img_l, lw, lh, px + x, py + y);
+                            d->gx[base + k] = gx;
+                            d->gy[base + k] = gy;
+                            a += gx * gx;
+                            b += gx * gy;
+                            c += gy * gy;
+                        }
+                    }
+                    if (l == 0)
+                    {
+                        float mean = 0, dev = 0;
+                        for (int k = 0; k < DISP_LK_PATCH; k++)
+                            mean += d->tmpl[base + k];
+                        mean /= DISP_LK_PATCH;
+                        for (int k = 0; k < DISP_LK_PATCH; k++)
+                            dev += fabsf(d->tmpl[base + k] - mean);
+                        d->max_err[i] = std::max(DISP_LK_MIN_ERR, dev / DISP_LK_PATCH * DISP_LK_ERR_RATIO);
+                    }
+                    float det = a * c - b * b;
+                    float *hi = d->hinv.data() + (i * _levels + l) * 3;
+                    if (det < 1e-6f)
+                    {
+                        hi[0] = hi[1] = hi[2] = 0;
+                        continue;
+                    }
+                    hi[0] = c / det;
+                    hi[1] = -b / det;
+                    hi[2] = a / det;
+                }
+            }
+            d->moved.resize(np * 2);
+            d->ok.resize(np);
+            d->last[0] = 1;
+            d->last[1] = d->last[2] = d->last[3] = 0;
+        }
+        d->roi_w = roi[2];
+        d->roi_h = roi[3];
+        d->has_ref = true;
+        return err::ERR_NONE;
+    }
+
+    image::Displacement DisplacementTracker::update(image::Image &img, std::vector<int> roi)
+    {
+        disp_t *d = (disp_t *)_handle;
+        int w = _width, h = _height, n = w * h;
+        if (!d->has_ref)
+        {
+            err::Err e = set_reference(img, roi);
+            if (e != err::ERR_NONE && e != err::ERR_NOT_FOUND)
+                throw err::Exception(e, "DisplacementTracker set reference failed");
+            return image::Displacement(0, 0, 0, 1, e == err::ERR_NONE ? 1 : 0);
+        }
+        roi = _disp_roi(img, roi);
+        if (roi[2] != d->roi_w || roi[3] != d->roi_h)
+        {
+            log::error("DisplacementTracker roi size %dx%d not the same as reference %dx%d\n", roi[2], roi[3], d->roi_w, d->roi_h);
+            throw err::Exception(err::ERR_ARGS, "DisplacementTracker roi size not match reference");
+        }
+        _disp_gray(img, roi, w, h, d->gray.data());
+        float sx = (float)roi[2] / w, sy = (float)roi[3] / h;
+
+        if (_method == image::DisplacementMethod::DISPLACEMENT_PHASE)
+        {
+            float angle = 0, scale = 1;
+            const float *gray = d->gray.data();
+            if (_rotation_scale)
+            {
+                // magnitude spectrum is invariant to translation, rotation and scale become shifts in its log polar form
+                _disp_prepare(d, gray, n);
+                _fft2d(d, w, h);
+                _disp_logpolar(d, w, h);
+                std::fill(d->im.begin(), d->im.end(), 0.0f);
+                _fft2d(d, w, h);
+                _cross_power(d, d->ref_lp_re.data(), d->ref_lp_im.data(), n);
+                _ifft2d(d, w, h);
+                float dr, da;
+                _corr_peak(d->re.data(), w, h, dr, da);
+                angle = (float)(da * M_PI / h);
+                scale = powf(d->lp_base, -dr);
+                _disp_unrotate(d, w, h, angle, scale);
+                gray = d->gray2.data();
+            }
+            _disp_prepare(d, gray, n);
+            _fft2d(d, w, h);
+            if (_update_rate > 0)
+            {
+                d->cur_re.assign(d->tre.begin(), d->tre.end());
+                d->cur_im.assign(d->tim.begin(), d->tim.end());
+            }
+            _cross_power(d, d->ref_re.data(), d->ref_im.data(), n);
+            _ifft2d(d, w, h);
+            float dx, dy;
+            float response = _corr_peak(d->re.data(), w, h, dx, dy);
+            if (_update_rate > 0 && response >= DISP_UPDATE_MIN_RESPONSE)
+            {
+                // shift frame's spectrum back by (dx, dy) to align with reference, then blend
+                float r = _update_rate;
+                float *ref_re = d->ref_re.data();
+                float *ref_im = d->ref_im.data();
+                const float *cur_re = d->cur_re.data();
+                const float *cur_im = d->cur_im.data();
+                #pragma omp parallel for
+                for (int kx = 0; kx < w; kx++)
+                {
+                    float fx = (kx < w / 2 ? kx : kx - w) * dx / w;
+                    for (int ky = 0; ky < h; ky++)
+                    {
+                        float ph = (float)(2 * M_PI) * (fx + (ky < h / 2 ? ky : ky - h) * dy / h);
+                        float c = cosf(ph), s = sinf(ph);
+                        int i = kx * h + ky;
+                        float re = cur_re[i] * c - cur_im[i] * s;
+                        float im = cur_re[i] * s + cur_im[i] * c;
+                        ref_re[i] = ref_re[i] * (1 - r) + re * r;
+                        ref_im[i] = ref_im[i] * (1 - r) + im * r;
+                    }
+                }
+            }
+            // translation was measured in rotation and scale fixed frame, transform back
+            float a = scale * cosf(angle), b = scale * sinf(angle);
+            float tx = a * dx - b * dy, ty = b * dx + a * dy;
+            return image::Displacement(tx * sx, ty * sy, angle, scale, response);
+        }
+
+        // lucas kanade, start from last motion, retry from no motion if lost(e.g. sudden shake)
+        _pyramid(d->pyr, d->gray.data(), w, h, _levels);
+        int np = (int)d->pts.size() / 2;
+        float m[4];
+        int inliers = _lk_track(d, w, h, _levels, _rotation_scale, d->last, m);
+        bool moved = d->last[0] != 1 || d->last[1] != 0 || d->last[2] != 0 || d->last[3] != 0;
+        if (moved && inliers < np / 2)
+        {
+            const float identity[4] = {1, 0, 0, 0};
+            float m2[4];
+            int inliers2 = _lk_track(d, w, h, _levels, _rotation_scale, identity, m2);
+            if (inliers2 > inliers)
+            {
+                inliers = inliers2;
+                memcpy(m, m2, sizeof(m));
+            }
+        }
+        if (inliers == 0)
+            return image::Displacement(0, 0, 0, 1, 0);
+        memcpy(d->last, m, sizeof(m));
+        return image::Displacement(m[2] * sx, m[3] * sy, atan2f(m[1], m[0]), sqrtf(m[0] * m[0] + m[1] * m[1]), (float)inliers / np);
+    }
+}
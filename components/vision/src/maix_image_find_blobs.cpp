@@ -68,6 +68,13 @@ namespace maix::image
         list_init(&thresholds_list, sizeof(color_thresholds_list_lnk_data_t));
         _convert_to_lab_thresholds(thresholds, &thresholds_list);
 
+        // label runs of packed rows directly, imlib flood fill is used for merge and histogram
+        if (_format == image::FMT_BITMAP && !merge && x_hist_bins_max == 0 && y_hist_bins_max == 0) {
+            std::vector<image::Blob> blobs = _bitmap_find_blobs(this, &thresholds_list, invert, &roi_rect, x_stride, y_stride, area_threshold, pixels_threshold);
+            list_free(&thresholds_list);
+            return blobs;
+        }
+
         list_t out;
         std::vector<image::Blob> blobs;
         imlib_find_blobs(&out, &src_img, &roi_rect, x_stride, y_stride, &thresholds_list, invert,  area_threshold, pixels_threshold, merge, margin, NULL, NULL, NULL, NULL, x_hist_bins_max, y_hist_bins_max);
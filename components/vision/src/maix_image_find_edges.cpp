@@ -13,6 +13,7 @@ namespace maix::image
 {
     image::Image* Image::find_edges(EdgeDetector edge_type, std::vector<int> roi, std::vector<int> threshold)
     {
+        _cow();
         image_t src_img;
         Image *gray_img = NULL;
         if (_format == image::FMT_GRAYSCALE) {
@@ -41,10 +42,11 @@ namespace maix::image
 
         if (_format != image::FMT_GRAYSCALE) {
             Image *out = gray_img->to_format(image::FMT_RGB888);
-            memcpy(this->data(), out->data(), out->data_size());
+            memcpy(this->contiguous_data(), out->data(), out->data_size());
             delete gray_img;
             delete out;
         }
+        sync_contiguous_data();
 
         return this;
     }
@@ -16,6 +16,7 @@ namespace maix::image
         image_t src_img;
         Image *gray_img = NULL;
         if (_format == image::FMT_GRAYSCALE) {
+            _cow();
             convert_to_imlib_image(this, &src_img);
         } else {
             gray_img = to_format(image::FMT_GRAYSCALE);
@@ -45,6 +46,7 @@ namespace maix::image
             delete gray_img;
             return out;
         }
+        sync_contiguous_data();
 
         return this;
     }
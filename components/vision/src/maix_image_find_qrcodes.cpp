@@ -190,7 +190,7 @@ namespace maix::image
                     need_delete_gray_img = true;
                 }
                 image::Image *new_img = NULL;
-                if (avail_roi[0] != 0 || avail_roi[1] != 0 || avail_roi[2] != gray_img->width() || avail_roi[3] != gray_img->height()) {
+                if (avail_roi[0] != 0 || avail_roi[1] != 0 || avail_roi[2] != gray_img->width() || avail_roi[3] != gray_img->height() || !gray_img->is_contiguous()) {
                     new_img = gray_img->crop(avail_roi[0], avail_roi[1], avail_roi[2], avail_roi[3]);
                     need_delete_new_img = true;
                 } else {
@@ -256,7 +256,7 @@ namespace maix::image
                     need_delete_gray_img = true;
                 }
                 image::Image *new_img = NULL;
-                if (avail_roi[0] != 0 || avail_roi[1] != 0 || avail_roi[2] != gray_img->width() || avail_roi[3] != gray_img->height()) {
+                if (avail_roi[0] != 0 || avail_roi[1] != 0 || avail_roi[2] != gray_img->width() || avail_roi[3] != gray_img->height() || !gray_img->is_contiguous()) {
                     new_img = gray_img->crop(avail_roi[0], avail_roi[1], avail_roi[2], avail_roi[3]);
                     need_delete_new_img = true;
                 } else {
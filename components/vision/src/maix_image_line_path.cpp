@@ -0,0 +1,533 @@
+/**
+ * @author lxowalle@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add LinePathSearcher, a row sampled line path engine for line following.
+ */
+
+#include "maix_image_line_path.hpp"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <omp.h>
+
+namespace maix::image
+{
+    #define LINE_PATH_MAX_RUNS_PER_ROW  (32)
+
+    template <int BPP, int R, int G, int B>
+    static inline uint8_t _line_path_luma(const uint8_t *p)
+    {
+        if (BPP == 1)
+            return p[0];
+        return (p[R] * 38 + p[G] * 75 + p[B] * 15) >> 7;
+    }
+
+    template <int BPP, int R, int G, int B>
+    static void _line_path_hist(const uint8_t *data, int width, int stride, int height, int rows, int row_step, int col_step, uint32_t *hist)
+    {
+        for (int r = 0; r < rows; r++)
+        {
+            const uint8_t *line = data + (height - 1 - r * row_step) * stride;
+            for (int x = 0; x < width; x += col_step)
+            {
+                hist[_line_path_luma<BPP, R, G, B>(line + x * BPP)]++;
+            }
+        }
+    }
+
+    template <int BPP, int R, int G, int B>
+    static void _line_path_rle(const uint8_t *data, int width, int stride, int height, int rows, int row_step, int col_step,
+                               int threshold, bool invert, int16_t *runs, int *runs_num, int max_runs)
+    {
+        #pragma omp parallel for
+        for (int r = 0; r < rows; r++)
+        {
+            const uint8_t *line = data + (height - 1 - r * row_step) * stride;
+            int16_t *row_runs = runs + r * max_runs * 2;
+            int num = 0;
+            int start = -1;
+            for (int x = 0; x < width; x += col_step)
+            {
+                bool on = _line_path_luma<BPP, R, G, B>(line + x * BPP) <= threshold;
+                if (on != invert)
+                {
+                    if (start < 0)
+                        start = x;
+                }
+                else if (start >= 0)
+                {
+                    if (num < max_runs)
+                    {
+                        row_runs[num * 2] = start;
+                        row_runs[num * 2 + 1] = x;
+                        ++num;
+                    }
+                    start = -1;
+                }
+            }
+            if (start >= 0 && num < max_runs)
+            {
+                row_runs[num * 2] = start;
+                row_runs[num * 2 + 1] = width;
+                ++num;
+            }
+            runs_num[r] = num;
+        }
+    }
+
+    #define LINE_PATH_DISPATCH(func, data_ptr, ...)                                         \
+        switch (img.format())                                                               \
+        {                                                                                   \
+        case image::FMT_GRAYSCALE:                                                          \
+        case image::FMT_YVU420SP:                                                           \
+        case image::FMT_YUV420SP:                                                           \
+            func<1, 0, 0, 0>(data_ptr, __VA_ARGS__);                                        \
+            break;                                                                          \
+        case image::FMT_RGB888:                                                             \
+            func<3, 0, 1, 2>(data_ptr, __VA_ARGS__);                                        \
+            break;                                                                          \
+        case image::FMT_BGR888:                                                             \
+            func<3, 2, 1, 0>(data_ptr, __VA_ARGS__);                                        \
+            break;                                                                          \
+        case image::FMT_RGBA8888:                                                           \
+            func<4, 0, 1, 2>(data_ptr, __VA_ARGS__);                                        \
+            break;                                                                          \
+        case image::FMT_BGRA8888:                                                           \
+            func<4, 2, 1, 0>(data_ptr, __VA_ARGS__);                                        \
+            break;                                                                          \
+        default:                                                                            \
+            log::error("line path not support format %s\n", image::fmt_names[img.format()].c_str()); \
+            throw err::Exception(err::ERR_ARGS, "line path not support this format");     \
+        }
+
+    LinePathSearcher::LinePathSearcher(int threshold, bool invert, int row_step, int col_step, int min_width, int max_width,
+                                       int max_paths, int link_tolerance, int max_gap)
+    {
+        err::check_bool_raise(threshold <= 255, "threshold should <= 255");
+        err::check_bool_raise(row_step > 0 && col_step > 0, "row_step and col_step should > 0");
+        err::check_bool_raise(max_paths > 0 && max_paths < 256, "max_paths should in [1, 255]");
+        _threshold = threshold;
+        _invert = invert;
+        _row_step = row_step;
+        _col_step = col_step;
+        _min_width = min_width;
+        _max_width = max_width;
+        _max_paths = max_paths;
+        _link_tolerance = link_tolerance;
+        _max_gap = max_gap;
+        _width = 0;
+        _height = 0;
+        _rows = 0;
+        _max_runs = LINE_PATH_MAX_RUNS_PER_ROW;
+        _next_id = 0;
+        _prev_num = 0;
+        _hist.resize(256);
+        _tracks.resize(_max_paths);
+        _free_slots.reserve(_max_paths);
+        _prev_ids.resize(_max_paths);
+        _prev_claimed.resize(_max_paths);
+        _run_track.resize(_max_runs);
+        _pairs.resize(_max_runs * _max_paths);
+        _result.bars.reserve(_max_paths * 2);
+    }
+
+    LinePathSearcher::~LinePathSearcher()
+    {
+    }
+
+    void LinePathSearcher::reset()
+    {
+        _prev_num = 0;
+        _result.paths.clear();
+        _result.bars.clear();
+    }
+
+    void LinePathSearcher::_alloc(int width, int height)
+    {
+        if (width == _width && height == _height)
+            return;
+        _width = width;
+        _height = height;
+        _rows = (height - 1) / _row_step + 1;
+        _runs.resize(_rows * _max_runs);
+        _runs_num.resize(_rows);
+        _prev_x.resize(_max_paths * _rows);
+        _slot_points.resize(_max_paths * _rows);
+        _result.points.resize(_max_paths * _rows);
+        // path has 2 points at least
+        _result.paths.reserve(_max_paths * _rows / 2);
+        _prev_order.reserve(_max_paths * _rows / 2);
+        reset();
+    }
+
+    int LinePathSearcher::_auto_threshold(image::Image &img)
+    {
+        uint32_t *hist = _hist.data();
+        memset(hist, 0, 256 * sizeof(uint32_t));
+        LINE_PATH_DISPATCH(_line_path_hist, (const uint8_t *)img.data(), _width, img.stride(), _height, _rows, _row_step, _col_step, hist);
+
+        // otsu
+        uint64_t total = 0, sum = 0;
+        for (int i = 0; i < 256; i++)
+        {
+            total += hist[i];
+            sum += (uint64_t)i * hist[i];
+        }
+        uint64_t sum_b = 0, w_b = 0;
+        double max_var = 0;
+        int threshold = 127;
+        for (int i = 0; i < 256; i++)
+        {
+            w_b += hist[i];
+            if (w_b == 0)
+                continue;
+            uint64_t w_f = total - w_b;
+            if (w_f == 0)
+                break;
+            sum_b += (uint64_t)i * hist[i];
+            double m_b = (double)sum_b / w_b;
+            double m_f = (double)(sum - sum_b) / w_f;
+            double var = (double)w_b * w_f * (m_b - m_f) * (m_b - m_f);
+            if (var > max_var)
+            {
+                max_var = var;
+                threshold = i;
+            }
+        }
+        return threshold;
+    }
+
+    void LinePathSearcher::_scan(image::Image &img, int threshold)
+    {
+        LINE_PATH_DISPATCH(_line_path_rle, (const uint8_t *)img.data(), _width, img.stride(), _height, _rows, _row_step, _col_step,
+                           threshold, _invert, (int16_t *)_runs.data(), _runs_num.data(), _max_runs);
+    }
+
+    void LinePathSearcher::_finish(Track &track, int &points_num)
+    {
+        if (track.num_points < 2)
+            return;
+        // every row at most _max_paths tracks add one point, so points of all tracks fit in _result.points
+        LinePathPoint *dst = _result.points.data() + points_num;
+        memcpy(dst, _slot_points.data() + track.slot * _rows, track.num_points * sizeof(LinePathPoint));
+        points_num += track.num_points;
+        _result.paths.push_back(LinePath{track.id, track.parent_id, track.bar, track.num_points, dst});
+    }
+
+    void LinePathSearcher::_link()
+    {
+        int max_width = _max_width > 0 ? _max_width : _width / 4;
+        int points_num = 0;
+        Track *tracks = _tracks.data();
+        LinePathPoint *points = _slot_points.data();
+        std::vector<image::LinePathBar> &bars = _result.bars;
+        bars.clear();
+        _result.paths.clear();
+        for (int i = 0; i < _prev_num; i++)
+            _prev_claimed[i] = 0;
+        // all slots free, pop from back, so lower slots are used first
+        _free_slots.clear();
+        for (int t = _max_paths - 1; t >= 0; t--)
+        {
+            tracks[t].active = false;
+            _free_slots.push_back(t);
+        }
+
+        for (int r = 0; r < _rows; r++)
+        {
+            int y = _height - 1 - r * _row_step;
+            Run *runs = _runs.data() + r * _max_runs;
+            int runs_num = _runs_num[r];
+            int pairs_num = 0;
+
+            for (int i = 0; i < runs_num; i++)
+            {
+                _run_track[i] = -2; // -2: ignored, -1: not linked
+                int w = runs[i].x2 - runs[i].x1;
+                if (w < _min_width)
+                    continue;
+                if (w > max_width)
+                {
+                    // wide run, merge to bar of last row or create new one
+                    int bar_idx = -1;
+                    for (size_t b = 0; b < bars.size(); b++)
+                    {
+                        LinePathBar &bar = bars[b];
+                        if (bar.y1 == y + _row_step && runs[i].x1 < bar.x2 && runs[i].x2 > bar.x1)
+                        {
+                            bar.y1 = y;
+                            bar.x1 = std::min(bar.x1, runs[i].x1);
+                            bar.x2 = std::max(bar.x2, runs[i].x2);
+                            bar_idx = b;
+                            break;
+                        }
+                    }
+                    if (bar_idx < 0 && bars.size() < bars.capacity())
+                    {
+                        bars.push_back(LinePathBar{runs[i].x1, runs[i].x2, (int16_t)y, (int16_t)y});
+                        bar_idx = bars.size() - 1;
+                    }
+                    if (bar_idx < 0)
+                        continue;
+                    // tracks go through bar keep alive
+                    for (int t = 0; t < _max_paths; t++)
+                    {
+                        if (tracks[t].active && tracks[t].last_x >= runs[i].x1 - _link_tolerance && tracks[t].last_x <= runs[i].x2 + _link_tolerance)
+                        {
+                            tracks[t].bar = bar_idx;
+                            tracks[t].seen_row = r;
+                        }
+                    }
+                    continue;
+                }
+                _run_track[i] = -1;
+                int cx = (runs[i].x1 + runs[i].x2) / 2;
+                for (int t = 0; t < _max_paths; t++)
+                {
+                    Track &track = tracks[t];
+                    if (!track.active)
+                        continue;
+                    float pred = track.last_x + track.dx * (r - track.last_row);
+                    if (track.prev_slot >= 0)
+                    {
+                        int16_t prev_x = _prev_x[track.prev_slot * _rows + r];
+                        if (prev_x >= 0)
+                            pred = (pred + prev_x) / 2;
+                    }
+                    int dist = (int)fabsf(cx - pred);
+                    if (dist <= _link_tolerance + w / 2)
+                        _pairs[pairs_num++] = ((uint32_t)dist << 16) | (i << 8) | t;
+                }
+            }
+
+            // greedy assign, nearest first
+            std::sort(_pairs.begin(), _pairs.begin() + pairs_num);
+            for (int p = 0; p < pairs_num; p++)
+            {
+                int i = (_pairs[p] >> 8) & 0xff;
+                int t = _pairs[p] & 0xff;
+                Track &track = tracks[t];
+                if (_run_track[i] != -1 || track.claimed_row == r)
+                    continue;
+                int cx = (runs[i].x1 + runs[i].x2) / 2;
+                float new_dx = (cx - track.last_x) / (r - track.last_row);
+                track.dx = track.num_points > 1 ? (track.dx + new_dx) / 2 : new_dx;
+                track.last_x = cx;
+                track.last_row = r;
+                track.seen_row = r;
+                track.claimed_row = r;
+                points[track.slot * _rows + track.num_points++] = LinePathPoint{(int16_t)cx, (int16_t)y, (int16_t)(runs[i].x2 - runs[i].x1)};
+                _run_track[i] = t;
+            }
+
+            // not linked runs start new tracks in free slots
+            for (int i = 0; i < runs_num && !_free_slots.empty(); i++)
+            {
+                if (_run_track[i] != -1)
+                    continue;
+                int cx = (runs[i].x1 + runs[i].x2) / 2;
+                int w = runs[i].x2 - runs[i].x1;
+                int slot = _free_slots.back();
+                _free_slots.pop_back();
+                Track &track = tracks[slot];
+                track.slot = slot;
+                track.parent_id = -1;
+                track.bar = -1;
+                track.num_points = 0;
+                track.last_row = r;
+                track.seen_row = r;
+                track.claimed_row = r;
+                track.last_x = cx;
+                track.dx = 0;
+                track.prev_slot = -1;
+                track.active = true;
+                // forked from a track linked in this row
+                int min_dist = (_link_tolerance + w) * 2;
+                for (int t = 0; t < _max_paths; t++)
+                {
+                    if (t != slot && tracks[t].active && tracks[t].claimed_row == r && tracks[t].num_points > 1)
+                    {
+                        int dist = abs((int)tracks[t].last_x - cx);
+                        if (dist <= min_dist)
+                        {
+                            min_dist = dist;
+                            track.parent_id = tracks[t].id;
+                        }
+                    }
+                }
+                // same path in previous frame
+                min_dist = _link_tolerance * 2;
+                for (int p = 0; p < _prev_num; p++)
+                {
+                    int16_t prev_x = _prev_x[p * _rows + r];
+                    if (_prev_claimed[p] || prev_x < 0)
+                        continue;
+                    int dist = abs(prev_x - cx);
+                    if (dist <= min_dist)
+                    {
+                        min_dist = dist;
+                        track.prev_slot = p;
+                    }
+                }
+                if (track.prev_slot >= 0)
+                {
+                    _prev_claimed[track.prev_slot] = 1;
+                    track.id = _prev_ids[track.prev_slot];
+                }
+                else
+                    track.id = _next_id++;
+                points[track.slot * _rows + track.num_points++] = LinePathPoint{(int16_t)cx, (int16_t)y, (int16_t)w};
+                _run_track[i] = slot;
+            }
+
+            // lost tracks output their path and release slot for new tracks
+            for (int t = 0; t < _max_paths; t++)
+            {
+                if (tracks[t].active && r - tracks[t].seen_row > _max_gap)
+                {
+                    tracks[t].active = false;
+                    _finish(tracks[t], points_num);
+                    _free_slots.push_back(t);
+                }
+            }
+        }
+
+        for (int t = 0; t < _max_paths; t++)
+        {
+            if (tracks[t].active)
+                _finish(tracks[t], points_num);
+        }
+    }
+
+    void LinePathSearcher::_save_history()
+    {
+        std::fill(_prev_x.begin(), _prev_x.end(), -1);
+        // keep the longest _max_paths paths
+        int paths_num = _result.paths.size();
+        _prev_num = std::min(paths_num, _max_paths);
+        _prev_order.resize(paths_num);
+        for (int p = 0; p < paths_num; p++)
+            _prev_order[p] = p;
+        std::sort(_prev_order.begin(), _prev_order.end(), [this](int a, int b) {
+            int na = _result.paths[a].num_points, nb = _result.paths[b].num_points;
+            return na > nb || (na == nb && a < b);
+        });
+        std::sort(_prev_order.begin(), _prev_order.begin() + _prev_num);
+        for (int p = 0; p < _prev_num; p++)
+        {
+            const LinePath &path = _result.paths[_prev_order[p]];
+            _prev_ids[p] = path.id;
+            for (int i = 0; i < path.num_points; i++)
+            {
+                int r = (_height - 1 - path.points[i].y) / _row_step;
+                _prev_x[p * _rows + r] = path.points[i].x;
+            }
+        }
+    }
+
+    const image::LinePathResult &LinePathSearcher::update(image::Image &img)
+    {
+        if (img.width() <= 0 || img.height() <= 0 || !img.data())
+            throw err::Exception(err::ERR_ARGS, "image is empty");
+        _alloc(img.width(), img.height());
+        int threshold = _threshold >= 0 ? _threshold : _auto_threshold(img);
+        _scan(img, threshold);
+        _link();
+        _result.threshold = threshold;
+        _save_history();
+        return _result;
+    }
+
+    static image::Line _line_path_make_line(int x1, int y1, int x2, int y2, int magnitude)
+    {
+        // normal form x * cos(theta) + y * sin(theta) = rho, theta in [0, 180)
+        double a = y2 - y1;
+        double b = x1 - x2;
+        double c = (double)x2 * y1 - (double)x1 * y2;
+        double norm = sqrt(a * a + b * b);
+        if (norm < 1e-6)
+            return image::Line(x1, y1, x2, y2, magnitude, 0, 0);
+        double theta = atan2(b, a);
+        double rho = -c / norm;
+        if (theta < 0)
+        {
+            theta += M_PI;
+            rho = -rho;
+        }
+        int theta_deg = (int)(theta * 180 / M_PI + 0.5) % 180;
+        return image::Line(x1, y1, x2, y2, magnitude, theta_deg, (int)rho);
+    }
+
+    std::vector<image::LineGroup> LinePathSearcher::search(image::Image &img, int min_len_of_new_path)
+    {
+        const LinePathResult &res = update(img);
+        std::vector<image::LineGroup> groups;
+        std::vector<bool> bar_used(res.bars.size(), false);
+        int group_idx = 0;
+
+        for (const LinePath &path : res.paths)
+        {
+            // least squares x = k * y + b
+            double sum_y = 0, sum_x = 0, sum_yy = 0, sum_xy = 0;
+            for (int i = 0; i < path.num_points; i++)
+            {
+                sum_y += path.points[i].y;
+                sum_x += path.points[i].x;
+                sum_yy += (double)path.points[i].y * path.points[i].y;
+                sum_xy += (double)path.points[i].x * path.points[i].y;
+            }
+            int n = path.num_points;
+            double denominator = n * sum_yy - sum_y * sum_y;
+            double k = fabs(denominator) < 1e-6 ? 0 : (n * sum_xy - sum_x * sum_y) / denominator;
+            double b = (sum_x - k * sum_y) / n;
+            int bottom_y = path.points[0].y;
+            int top_y = path.points[n - 1].y;
+            int bottom_x = (int)(k * bottom_y + b);
+            int top_x = (int)(k * top_y + b);
+
+            std::vector<image::Line> lines;
+            image::LineType type = image::LineType::LINE_NORMAL;
+            if (path.bar >= 0 && !bar_used[path.bar])
+            {
+                const LinePathBar &bar = res.bars[path.bar];
+                int iy = (bar.y1 + bar.y2) / 2;
+                int ix = (int)(k * iy + b);
+                bool left = ix - bar.x1 >= min_len_of_new_path;
+                bool right = bar.x2 - 1 - ix >= min_len_of_new_path;
+                bool go_on = top_y <= bar.y1 - min_len_of_new_path;
+                if (left || right)
+                {
+                    bar_used[path.bar] = true;
+                    lines.push_back(_line_path_make_line(bottom_x, bottom_y, ix, iy, n));
+                    if (go_on)
+                        lines.push_back(_line_path_make_line(ix, iy, top_x, top_y, n));
+                    if (left)
+                        lines.push_back(_line_path_make_line(bar.x1, iy, ix, iy, bar.x2 - bar.x1));
+                    if (right)
+                        lines.push_back(_line_path_make_line(ix, iy, bar.x2 - 1, iy, bar.x2 - bar.x1));
+                    if (left && right)
+                        type = go_on ? image::LineType::LINE_CROSS : image::LineType::LINE_T;
+                    else
+                        type = go_on ? image::LineType::LINE_T : image::LineType::LINE_L;
+                }
+            }
+            if (lines.empty())
+                lines.push_back(_line_path_make_line(bottom_x, bottom_y, top_x, top_y, n));
+            groups.push_back(image::LineGroup(group_idx++, type, lines));
+        }
+
+        // bars not belong to any path
+        for (size_t i = 0; i < res.bars.size(); i++)
+        {
+            if (bar_used[i])
+                continue;
+            const LinePathBar &bar = res.bars[i];
+            int iy = (bar.y1 + bar.y2) / 2;
+            std::vector<image::Line> lines;
+            lines.push_back(_line_path_make_line(bar.x1, iy, bar.x2 - 1, iy, bar.x2 - bar.x1));
+            groups.push_back(image::LineGroup(group_idx++, image::LineType::LINE_NORMAL, lines));
+        }
+        return groups;
+    }
+}
@@ -0,0 +1,332 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add Loader, decode images on worker threads with prefetch.
+ */
+
+#include "maix_image_loader.hpp"
+#include "maix_image_jpeg.hpp"
+#include "maix_fs.hpp"
+#include "opencv2/opencv.hpp"
+#include <map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cctype>
+#include <stdio.h>
+
+namespace maix::image
+{
+    typedef struct
+    {
+        image::Format format;
+        int scale;
+        int prefetch;
+
+        std::mutex lock;
+        std::condition_variable cond_job;   // window moved, new files or exit
+        std::condition_variable cond_ready; // image decoded
+        std::vector<std::string> files;
+        std::map<int, image::Image *> ready; // decoded images by file index, nullptr if decode failed
+        int next_job;       // next file index to decode
+        int next_out;       // next file index to return
+        uint32_t gen;       // increase when file list changed, results of old list are dropped
+        std::string path;   // path of last returned image
+        bool exit;
+        std::vector<std::thread *> threads;
+    } loader_t;
+
+    static bool _path_is_image(const std::string &path)
+    {
+        size_t pos = path.find_last_of('.');
+        if (pos == std::string::npos)
+            return false;
+        std::string ext = path.substr(pos);
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c)
+                       { return std::tolower(c); });
+        return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp" || ext == ".webp" ||
+               ext == ".tif" || ext == ".tiff" || ext == ".pgm" || ext == ".ppm";
+    }
+
+    static bool _read_file(const std::string &path, std::vector<uint8_t> &buff)
+    {
+        FILE *fp = fopen(path.c_str(), "rb");
+        if (!fp)
+            return false;
+        fseek(fp, 0, SEEK_END);
+        long size = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+        if (size <= 0)
+        {
+            fclose(fp);
+            return false;
+        }
+        buff.resize(size);
+        bool ok = fread(buff.data(), 1, size, fp) == (size_t)size;
+        fclose(fp);
+        return ok;
+    }
+
+    // decode not jpeg image(or jpeg libjpeg can't decode, e.g. CMYK) by OpenCV, convert and resize directly into image buffer
+    static image::Image *_cv_decode(const std::vector<uint8_t> &buff, image::Format format, int scale)
+    {
+        cv::Mat mat = cv::imdecode(cv::Mat(1, (int)buff.size(), CV_8UC1, (void *)buff.data()), cv::IMREAD_UNCHANGED);
+        if (mat.empty())
+            return nullptr;
+        if (mat.depth() != CV_8U)
+            mat.convertTo(mat, CV_8UC(mat.channels()), mat.depth() == CV_16U ? 1.0 / 256.0 : 1.0);
+        int ch = mat.channels();
+        if (ch != 1 && ch != 3 && ch != 4)
+        {
+            log::error("load image failed, channels not support: %d\n", ch);
+            return nullptr;
+        }
+        int code = -1;
+        switch (format)
+        {
+        case image::FMT_GRAYSCALE:
+            code = ch == 3 ? cv::COLOR_BGR2GRAY : (ch == 4 ? cv::COLOR_BGRA2GRAY : -1);
+            break;
+        case image::FMT_RGB888:
+            code = ch == 1 ? cv::COLOR_GRAY2RGB : (ch == 3 ? cv::COLOR_BGR2RGB : cv::COLOR_BGRA2RGB);
+            break;
+        case image::FMT_BGR888:
+            code = ch == 1 ? cv::COLOR_GRAY2BGR : (ch == 3 ? -1 : cv::COLOR_BGRA2BGR);
+            break;
+        case image::FMT_RGBA8888:
+            code = ch == 1 ? cv::COLOR_GRAY2RGBA : (ch == 3 ? cv::COLOR_BGR2RGBA : cv::COLOR_BGRA2RGBA);
+            break;
+        case image::FMT_BGRA8888:
+            code = ch == 1 ? cv::COLOR_GRAY2BGRA : (ch == 3 ? cv::COLOR_BGR2BGRA : -1);
+            break;
+        default:
+            return nullptr;
+        }
+        int w = scale > 1 ? (mat.cols + scale - 1) / scale : mat.cols;
+        int h = scale > 1 ? (mat.rows + scale - 1) / scale : mat.rows;
+        image::Image *img = new image::Image(w, h, format);
+        cv::Mat dst(h, w, CV_8UC((int)image::fmt_size[format]), img->data());
+        if (scale > 1)
+        {
+            // resize before convert, fewer pixels to convert
+            cv::Mat small;
+            cv::resize(mat, small, cv::Size(w, h), 0, 0, cv::INTER_AREA);
+            mat = small;
+        }
+        if (code < 0)
+            mat.copyTo(dst);
+        else
+            cv::cvtColor(mat, dst, code);
+        return img;
+    }
+
+    static image::Image *_decode_file(image::JpegDecoder &decoder, const std::string &path, image::Format format, int scale)
+    {
+        std::vector<uint8_t> buff;
+        if (!_read_file(path, buff))
+        {
+            log::error("read image file %s failed\n", path.c_str());
+            return nullptr;
+        }
+        image::Image *img = nullptr;
+        try
+        {
+            if (buff.size() > 2 && buff[0] == 0xFF && buff[1] == 0xD8)
+                img = decoder.decode(buff.data(), buff.size());
+            if (!img)
+                img = _cv_decode(buff, format, scale);
+        }
+        catch (std::exception &e)
+        {
+            log::error("decode image %s failed: %s\n", path.c_str(), e.what());
+            delete img;
+            return nullptr;
+        }
+        if (!img)
+            log::error("decode image %s failed\n", path.c_str());
+        return img;
+    }
+
+    static void _worker(loader_t *l)
+    {
+        // decoder context per thread, reused for all files
+        image::JpegDecoder decoder(l->format, l->scale);
+        std::unique_lock<std::mutex> lock(l->lock);
+        while (true)
+        {
+            l->cond_job.wait(lock, [l]()
+                             { return l->exit || (l->next_job < (int)l->files.size() && l->next_job < l->next_out + l->prefetch); });
+            if (l->exit)
+                break;
+            int idx = l->next_job++;
+            uint32_t gen = l->gen;
+            std::string path = l->files[idx];
+            lock.unlock();
+            image::Image *img = _decode_file(decoder, path, l->format, l->scale);
+            lock.lock();
+            if (gen != l->gen)
+            {
+                delete img;
+                continue;
+            }
+            l->ready[idx] = img;
+            l->cond_ready.notify_all();
+        }
+    }
+
+    static void _clear_ready(loader_t *l)
+    {
+        for (auto &item : l->ready)
+            delete item.second;
+        l->ready.clear();
+    }
+
+    Loader::Loader(image::Format format, int scale, int threads, int prefetch)
+    {
+        if (format != image::FMT_RGB888 && format != image::FMT_BGR888 && format != image::FMT_RGBA8888 &&
+            format != image::FMT_BGRA8888 && format != image::FMT_GRAYSCALE)
+        {
+            log::error("Loader not support format: %s\n", image::fmt_names[format].c_str());
+            throw err::Exception(err::ERR_ARGS, "Loader not support format");
+        }
+        if (scale != 1 && scale != 2 && scale != 4 && scale != 8)
+        {
+            log::error("Loader scale should be 1, 2, 4 or 8, but got %d\n", scale);
+            throw err::Exception(err::ERR_ARGS, "Loader scale error");
+        }
+        if (threads <= 0)
+            threads = std::max(1, (int)std::thread::hardware_concurrency());
+        _format = format;
+        _scale = scale;
+        _prefetch = std::max(1, prefetch);
+        loader_t *l = new loader_t();
+        l->format = format;
+        l->scale = scale;
+        l->prefetch = _prefetch;
+        l->next_job = 0;
+        l->next_out = 0;
+        l->gen = 0;
+        l->exit = false;
+        for (int i = 0; i < threads; ++i)
+            l->threads.push_back(new std::thread(_worker, l));
+        _handle = l;
+    }
+
+    Loader::~Loader()
+    {
+        loader_t *l = (loader_t *)_handle;
+        {
+            std::lock_guard<std::mutex> guard(l->lock);
+            l->exit = true;
+        }
+        l->cond_job.notify_all();
+        for (auto t : l->threads)
+        {
+            t->join();
+            delete t;
+        }
+        _clear_ready(l);
+        delete l;
+        _handle = nullptr;
+    }
+
+    err::Err Loader::open(const std::string &path, bool recursive)
+    {
+        if (fs::isfile(path))
+        {
+            set_files({path});
+            return err::ERR_NONE;
+        }
+        if (!fs::isdir(path))
+        {
+            log::error("Loader open %s failed, not exists\n", path.c_str());
+            return err::ERR_ARGS;
+        }
+        std::vector<std::string> *items = fs::listdir(path, recursive, true);
+        if (!items)
+            return err::ERR_IO;
+        std::vector<std::string> paths;
+        for (auto &item : *items)
+        {
+            if (_path_is_image(item) && fs::isfile(item))
+                paths.push_back(item);
+        }
+        delete items;
+        std::sort(paths.begin(), paths.end());
+        set_files(paths);
+        return err::ERR_NONE;
+    }
+
+    void Loader::set_files(const std::vector<std::string> &paths)
+    {
+        loader_t *l = (loader_t *)_handle;
+        {
+            std::lock_guard<std::mutex> guard(l->lock);
+            ++l->gen;
+            _clear_ready(l);
+            l->files = paths;
+            l->next_job = 0;
+            l->next_out = 0;
+            l->path.clear();
+        }
+        l->cond_job.notify_all();
+        l->cond_ready.notify_all();
+    }
+
+    image::Image *Loader::next()
+    {
+        loader_t *l = (loader_t *)_handle;
+        std::unique_lock<std::mutex> lock(l->lock);
+        while (l->next_out < (int)l->files.size())
+        {
+            int idx = l->next_out;
+            uint32_t gen = l->gen;
+            l->cond_ready.wait(lock, [l, idx, gen]()
+                               { return l->gen != gen || l->ready.count(idx) > 0; });
+            if (l->gen != gen)
+                continue;
+            image::Image *img = l->ready[idx];
+            l->ready.erase(idx);
+            ++l->next_out;
+            l->cond_job.notify_all();
+            if (img)
+            {
+                l->path = l->files[idx];
+                return img;
+            }
+        }
+        return nullptr;
+    }
+
+    std::string Loader::path()
+    {
+        loader_t *l = (loader_t *)_handle;
+        std::lock_guard<std::mutex> guard(l->lock);
+        return l->path;
+    }
+
+    int Loader::remain()
+    {
+        loader_t *l = (loader_t *)_handle;
+        std::lock_guard<std::mutex> guard(l->lock);
+        return (int)l->files.size() - l->next_out;
+    }
+
+    std::vector<std::string> Loader::files()
+    {
+        loader_t *l = (loader_t *)_handle;
+        std::lock_guard<std::mutex> guard(l->lock);
+        return l->files;
+    }
+
+    image::Image *Loader::load(const std::string &path)
+    {
+        static thread_local image::JpegDecoder decoder;
+        decoder.set_format(_format);
+        decoder.set_scale(_scale);
+        return _decode_file(decoder, path, _format, _scale);
+    }
+}
@@ -10,6 +10,7 @@
 #include "maix_err.hpp"
 #include <omv.hpp>
 #include <opencv2/opencv.hpp>
+#include <string.h>
 
 namespace maix::image {
     void convert_to_imlib_image(image::Image *image, image_t *imlib_image) {
@@ -29,16 +30,24 @@ namespace maix::image {
         case Format::FMT_RGB888:
             imlib_format = PIXFORMAT_RGB888;
             break;
+        case Format::FMT_BITMAP:
+            imlib_format = PIXFORMAT_BINARY;
+            break;
         default:
             log::error("convert_to_imlib_image format not support: %d", image->format());
             return;
         }
 
-        image_init(imlib_image, image->width(), image->height(), imlib_format, image->data_size(), image->data());
+        // imlib image has no stride, not continuous image(e.g. a view) will use packed data,
+        // functions modify image in place should call image->sync_contiguous_data() to write back.
+        image_init(imlib_image, image->width(), image->height(), imlib_format, image->data_size(), image->contiguous_data());
     }
 
     image::Image *Image::mean_pool(int x_div, int y_div, bool copy) {
+        if (!copy)
+            _cow();
         err::check_bool_raise(x_div > 0 && x_div <= _width && y_div > 0 && y_div <= _height, "mean pool get invalid param");
+        err::check_bool_raise(copy || is_contiguous(), "mean pool not support copy=false for not continuous image(e.g. a view)");
 
         image_t src_img, out_img;
         uint8_t *buffer = NULL;
@@ -67,10 +76,13 @@ namespace maix::image {
             _width = out_img.w;
             _height = out_img.h;
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::midpoint_pool(int x_div, int y_div, double bias, bool copy) {
+        if (!copy)
+            _cow();
         if (x_div <= 0 || x_div > _width || y_div <= 0 || y_div > _height) {
             log::warn("midpoint pool invalid div: %d, %d", x_div, y_div);
             return nullptr;
@@ -80,6 +92,7 @@ namespace maix::image {
             log::warn("midpoint pool not support format: %d", _format);
             return nullptr;
         }
+        err::check_bool_raise(copy || is_contiguous(), "midpoint pool not support copy=false for not continuous image(e.g. a view)");
 
         image::Image *dst;
         int _dst_width = _width / x_div;
@@ -103,7 +116,7 @@ namespace maix::image {
                     uint8_t *dst_data = (uint8_t *)dst->data();
                     for (int i = 0; i < y_div; i++) {
                         for (int j = 0; j < x_div; j++) {
-                            int pixel = src_data[(yyy + (y * y_div) + i) * _width + (xxx + (x * x_div) + j)];
+                            int pixel = src_data[(yyy + (y * y_div) + i) * _stride + (xxx + (x * x_div) + j)];
                             min = std::min(min, pixel);
                             max = std::max(max, pixel);
                         }
@@ -123,9 +136,9 @@ namespace maix::image {
                     uint8_t *dst_data = (uint8_t *)dst->data();
                     for (int i = 0; i < y_div; i++) {
                         for (int j = 0; j < x_div; j++) {
-                            int v0 = src_data[((yyy + (y * y_div) + i) * _width + (xxx + (x * x_div) + j)) * 3];
-                            int v1 = src_data[((yyy + (y * y_div) + i) * _width + (xxx + (x * x_div) + j)) * 3 + 1];
-                            int v2 = src_data[((yyy + (y * y_div) + i) * _width + (xxx + (x * x_div) + j)) * 3 + 2];
+                            int v0 = src_data[(yyy + (y * y_div) + i) * _stride + (xxx + (x * x_div) + j) * 3];
+                            int v1 = src_data[(yyy + (y * y_div) + i) * _stride + (xxx + (x * x_div) + j) * 3 + 1];
+                            int v2 = src_data[(yyy + (y * y_div) + i) * _stride + (xxx + (x * x_div) + j) * 3 + 2];
                             v0_min = std::min(v0_min, v0);
                             v0_max = std::max(v0_max, v0);
                             v1_min = std::min(v1_min, v1);
@@ -158,17 +171,21 @@ namespace maix::image {
     }
 
     err::Err image_zero(image::Image &src, image::Image &mask, bool invert) {
+        src.detach();
         image_t src_img, mask_img;
         convert_to_imlib_image(&src, &src_img);
         convert_to_imlib_image(&mask, &mask_img);
         imlib_zero(&src_img, &mask_img, invert);
+        src.sync_contiguous_data();
 
         return err::Err::ERR_NONE;
     }
 
     image::Image *Image::clear(image::Image *mask) {
+        _cow();
         if (!mask) {
-            memset(_data, 0, _data_size);
+            memset(contiguous_data(), 0, _data_size);
+            sync_contiguous_data();
         } else {
             image_zero(*this, *mask, false);
         }
@@ -228,8 +245,9 @@ namespace maix::image {
     }
 
     image::Image *Image::binary(std::vector<std::vector<int>> thresholds, bool invert, bool zero, image::Image *mask, bool to_bitmap, bool copy) {
+        if (!copy)
+            _cow();
         err::check_bool_raise(thresholds.size() != 0, "You need to set thresholds");
-        err::check_bool_raise(to_bitmap == false, "Parameter to_bitmap is not supported");
 
         list_t thresholds_list;
         list_init(&thresholds_list, sizeof(color_thresholds_list_lnk_data_t));
@@ -237,7 +255,9 @@ namespace maix::image {
 
         image_t src_img, mask_img, out_img;
         image::Image *dst = nullptr;
-        if (copy) {
+        if (to_bitmap) {
+            dst = new image::Image(_width, _height, image::FMT_BITMAP);
+        } else if (copy) {
             dst = new image::Image(_width, _height, _format);
         } else {
             dst = this;
@@ -251,15 +271,30 @@ namespace maix::image {
 
         imlib_binary(&out_img, &src_img, &thresholds_list, invert, zero, mask ? &mask_img : NULL);
         list_free(&thresholds_list);
+        if (to_bitmap && !copy) {
+            // take the bitmap buffer, this image becomes FMT_BITMAP
+            try {
+                *this = *dst;
+            } catch (...) {
+                delete dst;
+                throw;
+            }
+            delete dst;
+            return this;
+        }
+        if (!copy)
+            sync_contiguous_data();
 
         return dst;
     }
 
     image::Image *Image::invert() {
+        _cow();
         int remain_len = _data_size % 4;
         int u32_len = (_data_size - remain_len) >> 2;
-        uint8_t *remain_data = (uint8_t *)((uint8_t *)_data + (u32_len << 2));
-        uint32_t *u32_data = (uint32_t *)_data;
+        uint8_t *data = (uint8_t *)contiguous_data();
+        uint8_t *remain_data = (uint8_t *)(data + (u32_len << 2));
+        uint32_t *u32_data = (uint32_t *)data;
         for (int i = 0; i < u32_len; i ++) {
             u32_data[i] = ~u32_data[i];
         }
@@ -267,205 +302,205 @@ namespace maix::image {
         for (int i = 0; i < remain_len; i ++) {
             remain_data[i] = ~remain_data[i];
         }
+        sync_contiguous_data();
 
         return this;
     }
 
+    // apply bitwise op to every byte of img and other(same format and size) in place,
+    // rows are processed one by one as images may have row padding(e.g. a view).
+    template <typename OP>
+    static void _bytes_logic(image::Image *img, image::Image *other, OP op)
+    {
+        int row_bytes = img->width() * (int)image::fmt_size[img->format()];
+        int rows = img->height();
+        if (img->is_contiguous() && other->is_contiguous())
+        {
+            row_bytes = img->data_size();
+            rows = 1;
+        }
+        int u32_len = row_bytes >> 2;
+        for (int y = 0; y < rows; y++)
+        {
+            uint8_t *src = (uint8_t *)img->data() + (size_t)y * img->stride();
+            uint8_t *oth = (uint8_t *)other->data() + (size_t)y * other->stride();
+            for (int i = 0; i < u32_len; i++)
+            {
+                uint32_t a, b;
+                memcpy(&a, src + (i << 2), 4);
+                memcpy(&b, oth + (i << 2), 4);
+                a = op(a, b);
+                memcpy(src + (i << 2), &a, 4);
+            }
+            for (int i = u32_len << 2; i < row_bytes; i++)
+                src[i] = (uint8_t)op(src[i], oth[i]);
+        }
+    }
+
     image::Image *Image::b_and(image::Image *other, image::Image *mask) {
+        _cow();
         image_t src_img, other_img, mask_img;
 
         err::check_bool_raise(other != NULL && other->data() != NULL, "Other image is null");
         err::check_bool_raise(_format == other->format(), "Other image format is not match source image");
         err::check_bool_raise(_width == other->width() && _height == other->height(), "Other image size is not match source image");
 
+        if (_format == image::FMT_BITMAP && (!mask || mask->format() == image::FMT_BITMAP)) {
+            _bitmap_logic(this, other, mask, BITMAP_OP_AND);
+            return this;
+        }
+
         if (mask) {
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
             err::check_bool_raise(_width == mask->width() && _height == mask->height(), "Mask image size is not match source image");
             convert_to_imlib_image(mask, &mask_img);
             imlib_b_and(&src_img, NULL, other ? &other_img : NULL, 0, mask ? &mask_img : NULL);
+            sync_contiguous_data();
         } else {
-            int remain_len = _data_size % 4;
-            int u32_len = (_data_size - remain_len) >> 2;
-            uint8_t *remain_src_data = (uint8_t *)((uint8_t *)_data + (u32_len << 2));
-            uint32_t *u32_src_data = (uint32_t *)_data;
-            uint8_t *remain_other_data = (uint8_t *)((uint8_t *)other->data() + (u32_len << 2));
-            uint32_t *u32_other_data = (uint32_t *)other->data();
-            for (int i = 0; i < u32_len; i ++) {
-                u32_src_data[i] = u32_src_data[i] & u32_other_data[i];
-            }
-
-            for (int i = 0; i < remain_len; i ++) {
-                remain_src_data[i] = remain_src_data[i] & remain_other_data[i];
-            }
+            _bytes_logic(this, other, [](auto a, auto b) { return a & b; });
         }
 
         return this;
     }
 
     image::Image *Image::b_nand(image::Image *other, image::Image *mask) {
+        _cow();
         image_t src_img, other_img, mask_img;
 
         err::check_bool_raise(other != NULL && other->data() != NULL, "Other image is null");
         err::check_bool_raise(_format == other->format(), "Other image format is not match source image");
         err::check_bool_raise(_width == other->width() && _height == other->height(), "Other image size is not match source image");
 
+        if (_format == image::FMT_BITMAP && (!mask || mask->format() == image::FMT_BITMAP)) {
+            _bitmap_logic(this, other, mask, BITMAP_OP_NAND);
+            return this;
+        }
+
         if (mask) {
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
             err::check_bool_raise(_width == mask->width() && _height == mask->height(), "Mask image size is not match source image");
             convert_to_imlib_image(mask, &mask_img);
             imlib_b_nand(&src_img, NULL, other ? &other_img : NULL, 0, mask ? &mask_img : NULL);
+            sync_contiguous_data();
         } else {
-            int remain_len = _data_size % 4;
-            int u32_len = (_data_size - remain_len) >> 2;
-            uint8_t *remain_src_data = (uint8_t *)((uint8_t *)_data + (u32_len << 2));
-            uint32_t *u32_src_data = (uint32_t *)_data;
-            uint8_t *remain_other_data = (uint8_t *)((uint8_t *)other->data() + (u32_len << 2));
-            uint32_t *u32_other_data = (uint32_t *)other->data();
-            for (int i = 0; i < u32_len; i ++) {
-                u32_src_data[i] = u32_src_data[i] & ~u32_other_data[i];
-            }
-
-            for (int i = 0; i < remain_len; i ++) {
-                remain_src_data[i] = remain_src_data[i] & ~remain_other_data[i];
-            }
+            _bytes_logic(this, other, [](auto a, auto b) { return a & ~b; });
         }
 
         return this;
     }
 
     image::Image *Image::b_or(image::Image *other, image::Image *mask) {
+        _cow();
         image_t src_img, other_img, mask_img;
 
         err::check_bool_raise(other != NULL && other->data() != NULL, "Other image is null");
         err::check_bool_raise(_format == other->format(), "Other image format is not match source image");
         err::check_bool_raise(_width == other->width() && _height == other->height(), "Other image size is not match source image");
 
+        if (_format == image::FMT_BITMAP && (!mask || mask->format() == image::FMT_BITMAP)) {
+            _bitmap_logic(this, other, mask, BITMAP_OP_OR);
+            return this;
+        }
+
         if (mask) {
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
             err::check_bool_raise(_width == mask->width() && _height == mask->height(), "Mask image size is not match source image");
             convert_to_imlib_image(mask, &mask_img);
             imlib_b_or(&src_img, NULL, other ? &other_img : NULL, 0, mask ? &mask_img : NULL);
+            sync_contiguous_data();
         } else {
-            int remain_len = _data_size % 4;
-            int u32_len = (_data_size - remain_len) >> 2;
-            uint8_t *remain_src_data = (uint8_t *)((uint8_t *)_data + (u32_len << 2));
-            uint32_t *u32_src_data = (uint32_t *)_data;
-            uint8_t *remain_other_data = (uint8_t *)((uint8_t *)other->data() + (u32_len << 2));
-            uint32_t *u32_other_data = (uint32_t *)other->data();
-            for (int i = 0; i < u32_len; i ++) {
-                u32_src_data[i] = u32_src_data[i] | u32_other_data[i];
-            }
-
-            for (int i = 0; i < remain_len; i ++) {
-                remain_src_data[i] = remain_src_data[i] | remain_other_data[i];
-            }
+            _bytes_logic(this, other, [](auto a, auto b) { return a | b; });
         }
 
-
         return this;
     }
 
     image::Image *Image::b_nor(image::Image *other, image::Image *mask) {
+        _cow();
         image_t src_img, other_img, mask_img;
 
         err::check_bool_raise(other != NULL && other->data() != NULL, "Other image is null");
         err::check_bool_raise(_format == other->format(), "Other image format is not match source image");
         err::check_bool_raise(_width == other->width() && _height == other->height(), "Other image size is not match source image");
 
+        if (_format == image::FMT_BITMAP && (!mask || mask->format() == image::FMT_BITMAP)) {
+            _bitmap_logic(this, other, mask, BITMAP_OP_NOR);
+            return this;
+        }
+
         if (mask) {
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
             err::check_bool_raise(_width == mask->width() && _height == mask->height(), "Mask image size is not match source image");
             convert_to_imlib_image(mask, &mask_img);
             imlib_b_nor(&src_img, NULL, other ? &other_img : NULL, 0, mask ? &mask_img : NULL);
+            sync_contiguous_data();
         } else {
-            int remain_len = _data_size % 4;
-            int u32_len = (_data_size - remain_len) >> 2;
-            uint8_t *remain_src_data = (uint8_t *)((uint8_t *)_data + (u32_len << 2));
-            uint32_t *u32_src_data = (uint32_t *)_data;
-            uint8_t *remain_other_data = (uint8_t *)((uint8_t *)other->data() + (u32_len << 2));
-            uint32_t *u32_other_data = (uint32_t *)other->data();
-            for (int i = 0; i < u32_len; i ++) {
-                u32_src_data[i] = u32_src_data[i] | ~u32_other_data[i];
-            }
-
-            for (int i = 0; i < remain_len; i ++) {
-                remain_src_data[i] = remain_src_data[i] | ~remain_other_data[i];
-            }
+            _bytes_logic(this, other, [](auto a, auto b) { return a | ~b; });
         }
 
-
         return this;
     }
 
     image::Image *Image::b_xor(image::Image *other, image::Image *mask) {
+        _cow();
         image_t src_img, other_img, mask_img;
 
         err::check_bool_raise(other != NULL && other->data() != NULL, "Other image is null");
         err::check_bool_raise(_format == other->format(), "Other image format is not match source image");
         err::check_bool_raise(_width == other->width() && _height == other->height(), "Other image size is not match source image");
 
+        if (_format == image::FMT_BITMAP && (!mask || mask->format() == image::FMT_BITMAP)) {
+            _bitmap_logic(this, other, mask, BITMAP_OP_XOR);
+            return this;
+        }
+
         if (mask) {
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
             err::check_bool_raise(_width == mask->width() && _height == mask->height(), "Mask image size is not match source image");
             convert_to_imlib_image(mask, &mask_img);
             imlib_b_xor(&src_img, NULL, other ? &other_img : NULL, 0, mask ? &mask_img : NULL);
+            sync_contiguous_data();
         } else {
-            int remain_len = _data_size % 4;
-            int u32_len = (_data_size - remain_len) >> 2;
-            uint8_t *remain_src_data = (uint8_t *)((uint8_t *)_data + (u32_len << 2));
-            uint32_t *u32_src_data = (uint32_t *)_data;
-            uint8_t *remain_other_data = (uint8_t *)((uint8_t *)other->data() + (u32_len << 2));
-            uint32_t *u32_other_data = (uint32_t *)other->data();
-            for (int i = 0; i < u32_len; i ++) {
-                u32_src_data[i] = u32_src_data[i] ^ u32_other_data[i];
-            }
-
-            for (int i = 0; i < remain_len; i ++) {
-                remain_src_data[i] = remain_src_data[i] ^ remain_other_data[i];
-            }
+            _bytes_logic(this, other, [](auto a, auto b) { return a ^ b; });
         }
 
         return this;
     }
 
     image::Image *Image::b_xnor(image::Image *other, image::Image *mask) {
+        _cow();
         image_t src_img, other_img, mask_img;
 
         err::check_bool_raise(other != NULL && other->data() != NULL, "Other image is null");
         err::check_bool_raise(_format == other->format(), "Other image format is not match source image");
         err::check_bool_raise(_width == other->width() && _height == other->height(), "Other image size is not match source image");
 
+        if (_format == image::FMT_BITMAP && (!mask || mask->format() == image::FMT_BITMAP)) {
+            _bitmap_logic(this, other, mask, BITMAP_OP_XNOR);
+            return this;
+        }
+
         if (mask) {
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
             err::check_bool_raise(_width == mask->width() && _height == mask->height(), "Mask image size is not match source image");
             convert_to_imlib_image(mask, &mask_img);
             imlib_b_xnor(&src_img, NULL, other ? &other_img : NULL, 0, mask ? &mask_img : NULL);
+            sync_contiguous_data();
         } else {
-            int remain_len = _data_size % 4;
-            int u32_len = (_data_size - remain_len) >> 2;
-            uint8_t *remain_src_data = (uint8_t *)((uint8_t *)_data + (u32_len << 2));
-            uint32_t *u32_src_data = (uint32_t *)_data;
-            uint8_t *remain_other_data = (uint8_t *)((uint8_t *)other->data() + (u32_len << 2));
-            uint32_t *u32_other_data = (uint32_t *)other->data();
-            for (int i = 0; i < u32_len; i ++) {
-                u32_src_data[i] = u32_src_data[i] ^ ~u32_other_data[i];
-            }
-
-            for (int i = 0; i < remain_len; i ++) {
-                remain_src_data[i] = remain_src_data[i] ^ ~remain_other_data[i];
-            }
+            _bytes_logic(this, other, [](auto a, auto b) { return a ^ ~b; });
         }
 
         return this;
     }
 
     image::Image *Image::awb(bool max) {
+        _cow();
         image_t src_img;
         Image *rgb565_img = nullptr;
         if (_format == image::FMT_RGB888 || _format == image::FMT_BGR888) {
@@ -480,7 +515,8 @@ namespace maix::image {
 
         if (_format == image::FMT_RGB888 || _format == image::FMT_BGR888) {
             Image *rgb888_img = rgb565_img->to_format(image::FMT_RGB888);
-            memcpy(_data, rgb888_img->data(), _data_size);
+            memcpy(contiguous_data(), rgb888_img->data(), _data_size);
+            sync_contiguous_data();
             delete rgb888_img;
             delete rgb565_img;
         }
@@ -488,6 +524,7 @@ namespace maix::image {
     }
 
     image::Image *Image::ccm(std::vector<float> &matrix) {
+        _cow();
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -504,14 +541,17 @@ namespace maix::image {
         }
 
         imlib_ccm(&src_img, ccm, len == 12);
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::gamma(double gamma, double contrast, double brightness) {
+        _cow();
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
 
         imlib_gamma(&src_img, gamma, contrast, brightness);
+        sync_contiguous_data();
         return this;
     }
 
@@ -520,13 +560,16 @@ namespace maix::image {
     }
 
     image::Image *Image::negate(void) {
+        _cow();
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
         imlib_negate(&src_img);
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::replace(image::Image *other, bool hmirror, bool vflip, bool transpose, image::Image *mask) {
+        _cow();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -553,6 +596,7 @@ namespace maix::image {
         _width = src_img.w;
         _height = src_img.h;
 
+        sync_contiguous_data();
         return this;
     }
 
@@ -561,6 +605,7 @@ namespace maix::image {
     }
 
     image::Image *Image::add(image::Image *other, image::Image *mask) {
+        _cow();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -571,10 +616,12 @@ namespace maix::image {
         } else {
             imlib_add(&src_img, NULL, &other_img, 0, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::sub(image::Image *other, bool reverse, image::Image *mask) {
+        _cow();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -585,10 +632,12 @@ namespace maix::image {
         } else {
             imlib_sub(&src_img, NULL, &other_img, 0, reverse, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::mul(image::Image *other, bool invert, image::Image *mask) {
+        _cow();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -599,10 +648,12 @@ namespace maix::image {
         } else {
             imlib_mul(&src_img, NULL, &other_img, 0, invert, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::div(image::Image *other, bool invert, bool mod, image::Image *mask) {
+        _cow();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -613,10 +664,12 @@ namespace maix::image {
         } else {
             imlib_div(&src_img, NULL, &other_img, 0, invert, mod, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::min(image::Image *other, image::Image *mask) {
+        _cow();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -627,10 +680,12 @@ namespace maix::image {
         } else {
             imlib_min(&src_img, NULL, &other_img, 0, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::max(image::Image *other, image::Image *mask) {
+        _cow();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -641,10 +696,12 @@ namespace maix::image {
         } else {
             imlib_max(&src_img, NULL, &other_img, 0, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::difference(image::Image *other, image::Image *mask) {
+        _cow();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -655,16 +712,19 @@ namespace maix::image {
         } else {
             imlib_difference(&src_img, NULL, &other_img, 0, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::blend(image::Image *other, int alpha, image::Image *mask) {
+        _cow();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
 
         if (alpha < 0 || alpha > 256) {
             log::error("alpha value not valid: %d", alpha);
+            sync_contiguous_data();
             return this;
         }
 
@@ -675,10 +735,12 @@ namespace maix::image {
         } else {
             imlib_blend(&src_img, NULL, &other_img, 0, alpha_f, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::histeq(bool adaptive, int clip_limit, image::Image *mask) {
+        _cow();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -698,10 +760,12 @@ namespace maix::image {
                 imlib_histeq(&src_img, NULL);
             }
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::mean(int size, bool threshold, int offset, bool invert, image::Image *mask) {
+        _cow();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -711,10 +775,12 @@ namespace maix::image {
         } else {
             imlib_mean_filter(&src_img, size, threshold, offset, invert, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::median(int size, double percentile, bool threshold, int offset, bool invert, image::Image *mask) {
+        _cow();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -725,10 +791,12 @@ namespace maix::image {
             imlib_median_filter(&src_img, size, percentile, threshold, offset, invert, NULL);
         }
 
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::mode(int size, bool threshold, int offset, bool invert, image::Image *mask) {
+        _cow();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -738,10 +806,12 @@ namespace maix::image {
         } else {
             imlib_mode_filter(&src_img, size, threshold, offset, invert, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::midpoint(int size, double bias, bool threshold, int offset, bool invert, image::Image *mask) {
+        _cow();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -751,10 +821,12 @@ namespace maix::image {
         } else {
             imlib_midpoint_filter(&src_img, size, bias, threshold, offset, invert, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::morph(int size, std::vector<int> kernel, float mul, float add, bool threshold, int offset, bool invert, image::Image *mask) {
+        _cow();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -781,10 +853,12 @@ namespace maix::image {
         } else {
             imlib_morph(&src_img, size, kernel_data, mul, add, threshold, offset, invert, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::gaussian(int size, bool unsharp, float mul, float add, bool threshold, int offset, bool invert, image::Image *mask) {
+        _cow();
         std::vector<int> pascal;
         std::vector<int> kernel;
         int m = 0;
@@ -825,10 +899,12 @@ namespace maix::image {
             imlib_morph(&src_img, size, kernel.data(), mul, add, threshold, offset, invert, NULL);
         }
 
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::laplacian(int size, bool sharpen, float mul, float add, bool threshold, int offset, bool invert, image::Image *mask) {
+        _cow();
         std::vector<int> pascal;
         std::vector<int> kernel;
         int m = 0;
@@ -870,10 +946,12 @@ namespace maix::image {
         } else {
             imlib_morph(&src_img, size, kernel.data(), mul, add, threshold, offset, invert, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::bilateral(int size, double color_sigma, double space_sigma, bool threshold, int offset, bool invert, image::Image *mask) {
+        _cow();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -883,24 +961,30 @@ namespace maix::image {
         } else {
             imlib_bilateral_filter(&src_img, size, color_sigma, space_sigma, threshold, offset, invert, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::linpolar(bool reverse) {
+        _cow();
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
         imlib_logpolar(&src_img, true, reverse);
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::logpolar(bool reverse) {
+        _cow();
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
         imlib_logpolar(&src_img, false, reverse);
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::lens_corr(double strength, double zoom, double x_corr, double y_corr) {
+        _cow();
         if (_width % 2 || _height % 2) {
             log::error("lens_corr image size must be even");
             return this;
@@ -909,13 +993,16 @@ namespace maix::image {
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
         imlib_lens_corr(&src_img, strength, zoom, x_corr, y_corr);
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::rotation_corr(double x_rotation, double y_rotation, double z_rotation, double x_translation, double y_translation, double zoom, double fov, std::vector<float> corners) {
+        _cow();
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
         imlib_rotation_corr(&src_img, x_rotation, y_rotation, z_rotation, x_translation, y_translation, zoom, fov, (float *)corners.data());
+        sync_contiguous_data();
         return this;
     }
 
@@ -954,6 +1041,18 @@ namespace maix::image {
             hist.BBins = NULL;
             imlib_get_histogram(&hist, &src_img, &roi_rect, &thresholds_list, invert, other_img);
             break;
+        case image::FMT_BITMAP:
+            // only 0 and 1, count with popcount instead of per pixel histogram
+            hist.LBinCount = COLOR_BINARY_MAX - COLOR_BINARY_MIN + 1;
+            hist.ABinCount = 0;
+            hist.BBinCount = 0;
+            hist.LBins = (float *)malloc(hist.LBinCount * sizeof(float));
+            hist.ABins = NULL;
+            hist.BBins = NULL;
+            err::check_bool_raise(!difference || (difference->format() == image::FMT_BITMAP && difference->width() == _width && difference->height() == _height),
+                                  "difference image should be the same size BITMAP image");
+            _bitmap_get_histogram(&hist, this, &roi_rect, &thresholds_list, invert, difference);
+            break;
         case image::FMT_RGB888:
             bins = bins >= 2 ? bins : COLOR_L_MAX - COLOR_L_MIN + 1;
             l_bins = l_bins >= 2 ? l_bins : bins;
@@ -1118,6 +1217,18 @@ namespace maix::image {
             hist.BBins = NULL;
             imlib_get_histogram(&hist, &src_img, &roi_rect, &thresholds_list, invert, other_img);
             break;
+        case image::FMT_BITMAP:
+            // only 0 and 1, count with popcount instead of per pixel histogram
+            hist.LBinCount = COLOR_BINARY_MAX - COLOR_BINARY_MIN + 1;
+            hist.ABinCount = 0;
+            hist.BBinCount = 0;
+            hist.LBins = (float *)malloc(hist.LBinCount * sizeof(float));
+            hist.ABins = NULL;
+            hist.BBins = NULL;
+            err::check_bool_raise(!difference || (difference->format() == image::FMT_BITMAP && difference->width() == _width && difference->height() == _height),
+                                  "difference image should be the same size BITMAP image");
+            _bitmap_get_histogram(&hist, this, &roi_rect, &thresholds_list, invert, difference);
+            break;
         case image::FMT_RGB888:
             bins = bins >= 2 ? bins : COLOR_L_MAX - COLOR_L_MIN + 1;
             l_bins = l_bins >= 2 ? l_bins : bins;
@@ -1187,6 +1298,7 @@ namespace maix::image {
     }
 
     image::Image *Image::flood_fill(int x, int y, float seed_threshold, float floating_threshold, image::Color color , bool invert, bool clear_background, image::Image *mask) {
+        _cow();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -1196,10 +1308,12 @@ namespace maix::image {
         } else {
             imlib_flood_fill(&src_img, x, y, seed_threshold, floating_threshold, color.hex(), invert, clear_background, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::erode(int size, int threshold, image::Image *mask) {
+        _cow();
         err::check_bool_raise(size > 0, "erode size must be greater than 0");
         err::check_bool_raise(threshold == -1 || threshold >= 0, "erode threshold must be greater than or equal to 0");
 
@@ -1210,19 +1324,34 @@ namespace maix::image {
             threshold = ((size * 2) + 1) * ((size * 2) + 1) - 1;
         }
 
+        // default threshold of BITMAP means AND of all pixels in kernel, use shifted words
+        if (_format == image::FMT_BITMAP && threshold == ((size * 2) + 1) * ((size * 2) + 1) - 1
+            && (!mask || mask->format() == image::FMT_BITMAP)) {
+            _bitmap_morph(this, size, false, mask);
+            return this;
+        }
+
         if (mask) {
             convert_to_imlib_image(mask, &mask_img);
             imlib_erode(&src_img, size, threshold, &mask_img);
         } else {
             imlib_erode(&src_img, size, threshold, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::dilate(int size, int threshold, image::Image *mask) {
+        _cow();
         err::check_bool_raise(size > 0, "dilate size must be greater than 0");
         err::check_bool_raise(threshold >= 0, "dilate threshold must be greater than or equal to 0");
 
+        // threshold 0 of BITMAP means OR of all pixels in kernel, use shifted words
+        if (_format == image::FMT_BITMAP && threshold == 0 && (!mask || mask->format() == image::FMT_BITMAP)) {
+            _bitmap_morph(this, size, true, mask);
+            return this;
+        }
+
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -1232,10 +1361,12 @@ namespace maix::image {
         } else {
             imlib_dilate(&src_img, size, threshold, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::open(int size, int threshold, image::Image *mask) {
+        _cow();
         err::check_bool_raise(size > 0, "open size must be greater than 0");
         err::check_bool_raise(threshold >= 0, "open threshold must be greater than or equal to 0");
 
@@ -1248,10 +1379,12 @@ namespace maix::image {
         } else {
             imlib_open(&src_img, size, threshold, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::close(int size, int threshold, image::Image *mask) {
+        _cow();
         err::check_bool_raise(size > 0, "close size must be greater than 0");
         err::check_bool_raise(threshold >= 0, "close threshold must be greater than or equal to 0");
 
@@ -1264,10 +1397,12 @@ namespace maix::image {
         } else {
             imlib_close(&src_img, size, threshold, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::top_hat(int size, int threshold, image::Image *mask) {
+        _cow();
         err::check_bool_raise(size > 0, "top_hat size must be greater than 0");
         err::check_bool_raise(threshold >= 0, "top_hat threshold must be greater than or equal to 0");
 
@@ -1280,10 +1415,12 @@ namespace maix::image {
         } else {
             imlib_top_hat(&src_img, size, threshold, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 
     image::Image *Image::black_hat(int size, int threshold, image::Image *mask) {
+        _cow();
         err::check_bool_raise(size > 0, "black_hat size must be greater than 0");
         err::check_bool_raise(threshold >= 0, "black_hat threshold must be greater than or equal to 0");
 
@@ -1296,6 +1433,7 @@ namespace maix::image {
         } else {
             imlib_black_hat(&src_img, size, threshold, NULL);
         }
+        sync_contiguous_data();
         return this;
     }
 }
\ No newline at end of file
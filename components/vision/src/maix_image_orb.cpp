@@ -0,0 +1,788 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add ORB, ORBFeatures and ORBIndex, multi-thread ORB extraction and fast binary descriptor matching.
+ */
+
+#include "maix_image_orb.hpp"
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <math.h>
+#include <string.h>
+#include <omp.h>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace maix::image
+{
+    #define ORB_BORDER (20)       // pattern radius(13 * sqrt(2)) and orientation patch radius(15) with margin
+    #define ORB_HALF_PATCH (15)
+    #define ORB_ANGLE_BINS (32)   // descriptor pattern is rotated by quantized angle, precomputed
+    #define ORB_INDEX_TABLES (16) // multi-index hashing, 16 substrings of 16 bits
+    #define ORB_INDEX_MIN (1024)  // less descriptors than this are matched by brute force
+
+    // test point pairs of rotated BRIEF, x0, y0, x1, y1 of 256 tests, the same as OpenCV's bit_pattern_31
+    static const int8_t _orb_pattern[256 * 4] = {
+        8, -3, 9, 5, 4, 2, 7, -12, -11, 9, -8, 2, 7, -12, 12, -13,
+        2, -13, 2, 12, 1, -7, 1, 6, -2, -10, -2, -4, -13, -13, -11, -8,
+        -13, -3, -12, -9, 10, 4, 11, 9, -13, -8, -8, -9, -11, 7, -9, 12,
+        7, 7, 12, 6, -4, -5, -3, 0, -13, 2, -12, -3, -9, 0, -7, 5,
+        12, -6, 12, -1, -3, 6, -2, 12, -6, -13, -4, -8, 11, -13, 12, -8,
+        4, 7, 5, 1, 5, -3, 10, -3, 3, -7, 6, 12, -8, -7, -6, -2,
+        -2, 11, -1, -10, -13, 12, -8, 10, -7, 3, -5, -3, -4, 2, -3, 7,
+        -10, -12, -6, 11, 5, -12, 6, -7, 5, -6, 7, -1, 1, 0, 4, -5,
+        9, 11, 11, -13, 4, 7, 4, 12, 2, -1, 4, 4, -4, -12, -2, 7,
+        -8, -5, -7, -10, 4, 11, 9, 12, 0, -8, 1, -13, -13, -2, -8, 2,
+        -3, -2, -2, 3, -6, 9, -4, -9, 8, 12, 10, 7, 0, 9, 1, 3,
+        7, -5, 11, -10, -13, -6, -11, 0, 10, 7, 12, 1, -6, -3, -6, 12,
+        10, -9, 12, -4, -13, 8, -8, -12, -13, 0, -8, -4, 3, 3, 7, 8,
+        5, 7, 10, -7, -1, 7, 1, -12, 3, -10, 5, 6, 2, -4, 3, -10,
+        -13, 0, -13, 5, -13, -7, -12, 12, -13, 3, -11, 8, -7, 12, -4, 7,
+        6, -10, 12, 8, -9, -1, -7, -6, -2, -5, 0, 12, -12, 5, -7, 5,
+        3, -10, 8, -13, -7, -7, -4, 5, -3, -2, -1, -7, 2, 9, 5, -11,
+        -11, -13, -5, -13, -1, 6, 0, -1, 5, -3, 5, 2, -4, -13, -4, 12,
+        -9, -6, -9, 6, -12, -10, -8, -4, 10, 2, 12, -3, 7, 12, 12, 12,
+        -7, -13, -6, 5, -4, 9, -3, 4, 7, -1, 12, 2, -7, 6, -5, 1,
+        -13, 11, -12, 5, -3, 7, -2, -6, 7, -8, 12, -7, -13, -7, -11, -12,
+        1, -3, 12, 12, 2, -6, 3, 0, -4, 3, -2, -13, -1, -13, 1, 9,
+        7, 1, 8, -6, 1, -1, 3, 12, 9, 1, 12, 6, -1, -9, -1, 3,
+        -13, -13, -10, 5, 7, 7, 10, 12, 12, -5, 12, 9, 6, 3, 7, 11,
+        5, -13, 6, 10, 2, -12, 2, 3, 3, 8, 4, -6, 2, 6, 12, -13,
+        9, -12, 10, 3, -8, 4, -7, 9, -11, 12, -4, -6, 1, 12, 2, -8,
+        6, -9, 7, -4, 2, 3, 3, -2, 6, 3, 11, 0, 3, -3, 8, -8,
+        7, 8, 9, 3, -11, -5, -6, -4, -10, 11, -5, 10, -5, -8, -3, 12,
+        -10, 5, -9, 0, 8, -1, 12, -6, 4, -6, 6, -11, -10, 12, -8, 7,
+        4, -2, 6, 7, -2, 0, -2, 12, -5, -8, -5, 2, 7, -6, 10, 12,
+        -9, -13, -8, -8, -5, -13, -5, -2, 8, -8, 9, -13, -9, -11, -9, 0,
+        1, -8, 1, -2, 7, -4, 9, 1, -2, 1, -1, -4, 11, -6, 12, -11,
+        -12, -9, -6, 4, 3, 7, 7, 12, 5, 5, 10, 8, 0, -4, 2, 8,
+        -9, 12, -5, -13, 0, 7, 2, 12, -1, 2, 1, 7, 5, 11, 7, -9,
+        3, 5, 6, -8, -13, -4, -8, 9, -5, 9, -3, -3, -4, -7, -3, -12,
+        6, 5, 8, 0, -7, 6, -6, 12, -13, 6, -5, -2, 1, -10, 3, 10,
+        4, 1, 8, -4, -2, -2, 2, -13, 2, -12, 12, 12, -2, -13, 0, -6,
+        4, 1, 9, 3, -6, -10, -3, -5, -3, -13, -1, 1, 7, 5, 12, -11,
+        4, -2, 5, -7, -13, 9, -9, -5, 7, 1, 8, 6, 7, -8, 7, 6,
+        -7, -4, -7, 1, -8, 11, -7, -8, -13, 6, -12, -8, 2, 4, 3, 9,
+        10, -5, 12, 3, -6, -5, -6, 7, 8, -3, 9, -8, 2, -12, 2, 8,
+        -11, -2, -10, 3, -12, -13, -7, -9, -11, 0, -10, -5, 5, -3, 11, 8,
+        -2, -13, -1, 12, -1, -8, 0, 9, -13, -11, -12, -5, -10, -2, -10, 11,
+        -3, 9, -2, -13, 2, -3, 3, 2, -9, -13, -4, 0, -4, 6, -3, -10,
+        -4, 12, -2, -7, -6, -11, -4, 9, 6, -3, 6, 11, -13, 11, -5, 5,
+        11, 11, 12, 6, 7, -5, 12, -2, -1, 12, 0, 7, -4, -8, -3, -2,
+        -7, 1, -6, 7, -13, -12, -8, -13, -7, -2, -6, -8, -8, 5, -6, -9,
+        -5, -1, -4, 5, -13, 7, -8, 10, 1, 5, 5, -13, 1, 0, 10, -13,
+        9, 12, 10, -1, 5, -8, 10, -9, -1, 11, 1, -13, -9, -3, -6, 2,
+        -1, -10, 1, 12, -13, 1, -8, -10, 8, -11, 10, -6, 2, -13, 3, -6,
+        7, -13, 12, -9, -10, -10, -5, -7, -10, -8, -8, -13, 4, -6, 8, 5,
+        3, 12, 8, -13, -4, 2, -3, -3, 5, -13, 10, -12, 4, -13, 5, -1,
+        -9, 9, -4, 3, 0, 3, 3, -9, -12, 1, -6, 1, 3, 2, 4, -8,
+        -10, -10, -10, 9, 8, -13, 12, 12, -8, -12, -6, -5, 2, 2, 3, 7,
+        10, 6, 11, -8, 6, 8, 8, -12, -7, 10, -6, 5, -3, -9, -3, 9,
+        -1, -13, -1, 5, -3, -7, -3, 4, -8, -2, -8, 3, 4, 2, 12, 12,
+        2, -5, 3, 11, 6, -9, 11, -13, 3, -1, 7, 12, 11, -1, 12, 4,
+        -3, 0, -3, 6, 4, -11, 4, 12, 2, -4, 2, 1, -10, -6, -8, 1,
+        -13, 7, -11, 1, -13, 12, -11, -13, 6, 0, 11, -13, 0, -1, 1, 4,
+        -13, 3, -9, -2, -9, 8, -6, -3, -13, -6, -8, -2, 5, -9, 8, 10,
+        2, 7, 3, -9, -1, -6, -1, -1, 9, 5, 11, -2, 11, -3, 12, -8,
+        3, 0, 3, 5, -1, 4, 0, 10, 3, -6, 4, 5, -13, 0, -10, 5,
+        5, 8, 12, 11, 8, 9, 9, -6, 7, -4, 8, -12, -10, 4, -10, 9,
+        7, 3, 12, 4, 9, -7, 10, -2, 7, 0, 12, -2, -1, -6, 0, -11,
+    };
+
+    // max u of circular patch for every v, radius ORB_HALF_PATCH
+    static const int _orb_u_max[ORB_HALF_PATCH + 2] = {15, 15, 15, 15, 14, 14, 14, 13, 13, 12, 11, 10, 9, 8, 6, 3, 0};
+
+    // FAST circle of radius 3, clockwise from top
+    static const int _fast_circle[16][2] = {{0, -3}, {1, -3}, {2, -2}, {3, -1}, {3, 0}, {3, 1}, {2, 2}, {1, 3},
+                                            {0, 3}, {-1, 3}, {-2, 2}, {-3, 1}, {-3, 0}, {-3, -1}, {-2, -2}, {-1, -3}};
+
+    // rotated pattern of every angle bin, x, y of 512 points
+    static int8_t _orb_rotated[ORB_ANGLE_BINS][512 * 2];
+    static std::once_flag _orb_rotated_once;
+
+    static void _orb_init_rotated()
+    {
+        for (int b = 0; b < ORB_ANGLE_BINS; b++)
+        {
+            double a = 2 * M_PI * b / ORB_ANGLE_BINS;
+            double c = cos(a), s = sin(a);
+            for (int i = 0; i < 512; i++)
+            {
+                int x = _orb_pattern[i * 2], y = _orb_pattern[i * 2 + 1];
+                _orb_rotated[b][i * 2] = (int8_t)lround(x * c - y * s);
+                _orb_rotated[b][i * 2 + 1] = (int8_t)lround(x * s + y * c);
+            }
+        }
+    }
+
+    static inline int _popcount64(uint64_t x)
+    {
+#if defined(__POPCNT__) || defined(__aarch64__) || defined(__riscv_zbb)
+        return __builtin_popcountll(x);
+#else
+        // no popcount instruction, avoid libgcc call
+        x = x - ((x >> 1) & 0x5555555555555555ULL);
+        x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+        x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return (int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+    int ORB::distance(const uint8_t *a, const uint8_t *b)
+    {
+#if defined(__ARM_NEON)
+        uint8x16_t c = vaddq_u8(vcntq_u8(veorq_u8(vld1q_u8(a), vld1q_u8(b))),
+                                vcntq_u8(veorq_u8(vld1q_u8(a + 16), vld1q_u8(b + 16))));
+#if defined(__aarch64__)
+        return vaddlvq_u8(c);
+#else
+        uint64x2_t s = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(c)));
+        return (int)(vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1));
+#endif
+#else
+        uint64_t x[4], y[4];
+        memcpy(x, a, 32);
+        memcpy(y, b, 32);
+        return _popcount64(x[0] ^ y[0]) + _popcount64(x[1] ^ y[1]) + _popcount64(x[2] ^ y[2]) + _popcount64(x[3] ^ y[3]);
+#endif
+    }
+
+    std::vector<float> ORBFeatures::keypoint(int idx)
+    {
+        if (idx < 0 || idx >= size())
+            throw err::Exception(err::ERR_ARGS, "ORBFeatures index out of range");
+        return std::vector<float>(_kps.begin() + idx * 5, _kps.begin() + idx * 5 + 5);
+    }
+
+    std::vector<float> ORBFeatures::points()
+    {
+        int n = size();
+        std::vector<float> pts(n * 2);
+        for (int i = 0; i < n; i++)
+        {
+            pts[i * 2] = _kps[i * 5];
+            pts[i * 2 + 1] = _kps[i * 5 + 1];
+        }
+        return pts;
+    }
+
+    std::vector<uint8_t> ORBFeatures::descriptor(int idx)
+    {
+        if (idx < 0 || idx >= size())
+            throw err::Exception(err::ERR_ARGS, "ORBFeatures index out of range");
+        return std::vector<uint8_t>(_desc.begin() + idx * DESC_SIZE, _desc.begin() + (idx + 1) * DESC_SIZE);
+    }
+
+    void ORBFeatures::add(const float keypoint[5], const uint8_t *desc)
+    {
+        _kps.insert(_kps.end(), keypoint, keypoint + 5);
+        _desc.insert(_desc.end(), desc, desc + DESC_SIZE);
+    }
+
+    void ORBFeatures::clear()
+    {
+        _kps.clear();
+        _desc.clear();
+    }
+
+    ORB::ORB(int max_keypoints, int threshold, int levels, float scale_factor, int grid, image::CornerDetector detector)
+    {
+        if (max_keypoints < 1 || threshold < 1 || threshold > 255 || levels < 1 || levels > 16 || scale_factor <= 1 || scale_factor > 2 || grid < 1 || grid > 64)
+        {
+            log::error("ORB args invalid, max_keypoints: %d, threshold: %d, levels: %d, scale_factor: %f, grid: %d\n",
+                       max_keypoints, threshold, levels, scale_factor, grid);
+            throw err::Exception(err::ERR_ARGS, "ORB args invalid");
+        }
+        if (detector != image::CornerDetector::CORNER_FAST && detector != image::CornerDetector::CORNER_AGAST)
+            throw err::Exception(err::ERR_ARGS, "ORB corner detector not support");
+        _max_keypoints = max_keypoints;
+        _threshold = threshold;
+        _levels = levels;
+        _scale_factor = scale_factor;
+        _grid = grid;
+        std::call_once(_orb_rotated_once, _orb_init_rotated);
+    }
+
+    // luma of roi
+    static void _orb_gray(image::Image &img, const std::vector<int> &roi, uint8_t *out)
+    {
+        int ch = 1, ro = 0, go = 0, bo = 0;
+        switch (img.format())
+        {
+        case image::FMT_GRAYSCALE:
+        case image::FMT_YVU420SP:
+        case image::FMT_YUV420SP:
+            break;
+        case image::FMT_RGB888:
+            ch = 3, go = 1, bo = 2;
+            break;
+        case image::FMT_BGR888:
+            ch = 3, ro = 2, go = 1;
+            break;
+        case image::FMT_RGBA8888:
+            ch = 4, go = 1, bo = 2;
+            break;
+        case image::FMT_BGRA8888:
+            ch = 4, ro = 2, go = 1;
+            break;
+        default:
+            log::error("ORB not support format: %s\n", image::fmt_names[img.format()].c_str());
+            throw err::Exception(err::ERR_ARGS, "ORB not support format");
+        }
+        const uint8_t *data = (const uint8_t *)img.data();
+        int stride = img.stride();
+        int w = roi[2], h = roi[3];
+        #pragma omp parallel for
+        for (int y = 0; y < h; y++)
+        {
+            const uint8_t *p = data + (roi[1] + y) * stride + roi[0] * ch;
+            uint8_t *o = out + y * w;
+            if (ch == 1)
+            {
+                memcpy(o, p, w);
+                continue;
+            }
+            for (int x = 0; x < w; x++, p += ch)
+                o[x] = (p[ro] * 77 + p[go] * 150 + p[bo] * 29 + 128) >> 8;
+        }
+    }
+
+    // bilinear downscale, 16.16 fixed point
+    static void _orb_resize(const uint8_t *src, int sw, int sh, uint8_t *dst, int dw, int dh)
+    {
+        uint32_t sx = ((uint32_t)sw << 16) / dw, sy = ((uint32_t)sh << 16) / dh;
+        #pragma omp parallel for
+        for (int y = 0; y < dh; y++)
+        {
+            int fy = std::max(0, (int)((y * sy + sy / 2) >> 8) - 128); // 8 bits fraction
+            int y0 = std::min(fy >> 8, sh - 1), y1 = std::min(y0 + 1, sh - 1), ay = fy & 0xff;
+            const uint8_t *r0 = src + y0 * sw, *r1 = src + y1 * sw;
+            for (int x = 0; x < dw; x++)
+            {
+                int fx = std::max(0, (int)((x * sx + sx / 2) >> 8) - 128);
+                int x0 = std::min(fx >> 8, sw - 1), x1 = std::min(x0 + 1, sw - 1), ax = fx & 0xff;
+                int top = r0[x0] * (256 - ax) + r0[x1] * ax;
+                int bottom = r1[x0] * (256 - ax) + r1[x1] * ax;
+                dst[y * dw + x] = (top * (256 - ay) + bottom * ay + 32768) >> 16;
+            }
+        }
+    }
+
+    // 5x5 binomial blur for descriptor sampling
+    static void _orb_blur(const uint8_t *src, int w, int h, uint8_t *dst)
+    {
+        std::vector<uint16_t> tmp(w * h);
+        #pragma omp parallel for
+        for (int y = 0; y < h; y++)
+        {
+            const uint8_t *s = src + y * w;
+            uint16_t *t = tmp.data() + y * w;
+            for (int x = 0; x < w; x++)
+            {
+                int xm2 = std::max(x - 2, 0), xm1 = std::max(x - 1, 0), xp1 = std::min(x + 1, w - 1), xp2 = std::min(x + 2, w - 1);
+                t[x] = s[xm2] + 4 * s[xm1] + 6 * s[x] + 4 * s[xp1] + s[xp2];
+            }
+        }
+        #pragma omp parallel for
+        for (int y = 0; y < h; y++)
+        {
+            const uint16_t *r[5];
+            for (int k = -2; k <= 2; k++)
+                r[k + 2] = tmp.data() + std::min(std::max(y + k, 0), h - 1) * w;
+            uint8_t *d = dst + y * w;
+            for (int x = 0; x < w; x++)
+                d[x] = (r[0][x] + 4 * r[1][x] + 6 * r[2][x] + 4 * r[3][x] + r[4][x] + 128) >> 8;
+        }
+    }
+
+    // FAST 9 of 16 segment test, returns score(sum of differences exceed threshold on the passed side), 0 if not corner
+    static inline int _fast_score(const uint8_t *p, const int *offsets, int t)
+    {
+        int v = p[0];
+        int hi = v + t, lo = v - t;
+        // an arc of 9 contains at least 2 of the 4 compass pixels
+        int c0 = p[offsets[0]], c4 = p[offsets[4]], c8 = p[offsets[8]], c12 = p[offsets[12]];
+        int nb = (c0 > hi) + (c4 > hi) + (c8 > hi) + (c12 > hi);
+        int nd = (c0 < lo) + (c4 < lo) + (c8 < lo) + (c12 < lo);
+        if (nb < 2 && nd < 2)
+            return 0;
+        uint32_t bright = 0, dark = 0;
+        int sb = 0, sd = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            int c = p[offsets[i]];
+            if (c > hi)
+            {
+                bright |= 1u << i;
+                sb += c - hi;
+            }
+            else if (c < lo)
+            {
+                dark |= 1u << i;
+                sd += lo - c;
+            }
+        }
+        int score = 0;
+        for (int pass = 0; pass < 2; pass++)
+        {
+            uint32_t m = pass ? dark : bright;
+            if (__builtin_popcount(m) < 9)
+                continue;
+            m |= m << 16;
+            uint32_t run = m;
+            for (int k = 1; k < 9; k++)
+                run &= m >> k;
+            if (run)
+                score = std::max(score, pass ? sd : sb);
+        }
+        return score;
+    }
+
+    typedef struct
+    {
+        int x;
+        int y;
+        int score;
+    } orb_corner_t;
+
+    // detect corners of one level, grid cells in parallel, keep corners spread over cells
+    static void _orb_detect_level(const uint8_t *img, int w, int h, int threshold, int grid, int max_n, std::vector<orb_corner_t> &out)
+    {
+        out.clear();
+        int x0 = ORB_BORDER, y0 = ORB_BORDER, x1 = w - ORB_BORDER, y1 = h - ORB_BORDER;
+        if (x1 <= x0 || y1 <= y0 || max_n <= 0)
+            return;
+        int offsets[16];
+        for (int i = 0; i < 16; i++)
+            offsets[i] = _fast_circle[i][1] * w + _fast_circle[i][0];
+        // score map, a score map is needed for non max suppression across cell borders
+        std::vector<uint16_t> score(w * h, 0);
+        #pragma omp parallel for
+        for (int y = y0 - 1; y < y1 + 1; y++)
+        {
+            const uint8_t *row = img + y * w;
+            uint16_t *s = score.data() + y * w;
+            for (int x = x0 - 1; x < x1 + 1; x++)
+                s[x] = (uint16_t)std::min(_fast_score(row + x, offsets, threshold), 65535);
+        }
+        int gx = std::min(grid, x1 - x0), gy = std::min(grid, y1 - y0);
+        int cells = gx * gy;
+        std::vector<std::vector<orb_corner_t>> cell_corners(cells);
+        int quota = (max_n + cells - 1) / cells * 2;
+        #pragma omp parallel for
+        for (int c = 0; c < cells; c++)
+        {
+            int cx = c % gx, cy = c / gx;
+            int sx = x0 + (x1 - x0) * cx / gx, ex = x0 + (x1 - x0) * (cx + 1) / gx;
+            int sy = y0 + (y1 - y0) * cy / gy, ey = y0 + (y1 - y0) * (cy + 1) / gy;
+            std::vector<orb_corner_t> &list = cell_corners[c];
+            for (int y = sy; y < ey; y++)
+            {
+                const uint16_t *s = score.data() + y * w;
+                for (int x = sx; x < ex; x++)
+                {
+                    int v = s[x];
+                    // 3x3 non max suppression, ties broken by position
+                    if (v == 0 || v < s[x - 1] || v <= s[x + 1] || v < s[x - w - 1] || v < s[x - w] || v < s[x - w + 1] ||
+                        v <= s[x + w - 1] || v <= s[x + w] || v <= s[x + w + 1])
+                        continue;
+                    list.push_back({x, y, v});
+                }
+            }
+            int keep = std::min((int)list.size(), quota);
+            std::partial_sort(list.begin(), list.begin() + keep, list.end(), [](const orb_corner_t &a, const orb_corner_t &b)
+                              { return a.score > b.score; });
+            list.resize(keep);
+        }
+        // take corners rank by rank from every cell, so weak cells still contribute their best corners
+        for (int rank = 0; (int)out.size() < max_n; rank++)
+        {
+            size_t start = out.size();
+            for (int c = 0; c < cells; c++)
+            {
+                if (rank < (int)cell_corners[c].size())
+                    out.push_back(cell_corners[c][rank]);
+            }
+            if (out.size() == start)
+                break;
+            if ((int)out.size() > max_n)
+            {
+                std::sort(out.begin() + start, out.end(), [](const orb_corner_t &a, const orb_corner_t &b)
+                          { return a.score > b.score; });
+                out.resize(max_n);
+            }
+        }
+    }
+
+    // orientation by intensity centroid, in degree [0, 360)
+    static float _orb_angle(const uint8_t *img, int w, int x, int y)
+    {
+        const uint8_t *center = img + y * w + x;
+        int m_01 = 0, m_10 = 0;
+        for (int u = -ORB_HALF_PATCH; u <= ORB_HALF_PATCH; ++u)
+            m_10 += u * center[u];
+        for (int v = 1; v <= ORB_HALF_PATCH; ++v)
+        {
+            int v_sum = 0;
+            int d = _orb_u_max[v];
+            for (int u = -d; u <= d; ++u)
+            {
+                int val_plus = center[u + v * w], val_minus = center[u - v * w];
+                v_sum += val_plus - val_minus;
+                m_10 += u * (val_plus + val_minus);
+            }
+            m_01 += v * v_sum;
+        }
+        float angle = atan2f((float)m_01, (float)m_10) * (float)(180.0 / M_PI);
+        return angle < 0 ? angle + 360 : angle;
+    }
+
+    static void _orb_describe(const uint8_t *img, int w, int x, int y, float angle, uint8_t *desc)
+    {
+        int bin = (int)lroundf(angle * ORB_ANGLE_BINS / 360.0f) % ORB_ANGLE_BINS;
+        const int8_t *pat = _orb_rotated[bin];
+        const uint8_t *center = img + y * w + x;
+        for (int i = 0; i < 32; i++, pat += 32)
+        {
+            int val = 0;
+            for (int k = 0; k < 8; k++)
+            {
+                int a = center[pat[k * 4 + 1] * w + pat[k * 4]];
+                int b = center[pat[k * 4 + 3] * w + pat[k * 4 + 2]];
+                val |= (a < b) << k;
+            }
+            desc[i] = (uint8_t)val;
+        }
+    }
+
+    image::ORBFeatures ORB::detect(image::Image &img, std::vector<int> roi)
+    {
+        if (roi.empty())
+            roi = {0, 0, img.width(), img.height()};
+        if (roi.size() != 4 || roi[0] < 0 || roi[1] < 0 || roi[2] <= 0 || roi[3] <= 0 ||
+            roi[0] + roi[2] > img.width() || roi[1] + roi[3] > img.height())
+        {
+            log::error("ORB roi invalid\n");
+            throw err::Exception(err::ERR_ARGS, "ORB roi invalid");
+        }
+        std::vector<uint8_t> level(roi[2] * roi[3]);
+        _orb_gray(img, roi, level.data());
+
+        // keypoint number of levels decreases geometrically, the same as OpenCV
+        std::vector<int> level_n(_levels);
+        float factor = 1.0f / _scale_factor;
+        float n = _max_keypoints * (1 - factor) / (1 - powf(factor, (float)_levels));
+        int sum = 0;
+        for (int l = 0; l < _levels - 1; l++)
+        {
+            level_n[l] = (int)lroundf(n);
+            sum += level_n[l];
+            n *= factor;
+        }
+        level_n[_levels - 1] = std::max(_max_keypoints - sum, 0);
+
+        image::ORBFeatures features;
+        std::vector<uint8_t> prev, blur;
+        std::vector<orb_corner_t> corners;
+        int w = roi[2], h = roi[3];
+        float scale = 1;
+        for (int l = 0; l < _levels; l++)
+        {
+            if (l > 0)
+            {
+                scale *= _scale_factor;
+                int nw = (int)lroundf(roi[2] / scale), nh = (int)lroundf(roi[3] / scale);
+                if (nw <= ORB_BORDER * 2 || nh <= ORB_BORDER * 2)
+                    break;
+                prev.swap(level);
+                level.resize(nw * nh);
+                _orb_resize(prev.data(), w, h, level.data(), nw, nh);
+                w = nw;
+                h = nh;
+            }
+            _orb_detect_level(level.data(), w, h, _threshold, _grid, level_n[l], corners);
+            if (corners.empty())
+                continue;
+            blur.resize(w * h);
+            _orb_blur(level.data(), w, h, blur.data());
+            int nc = (int)corners.size();
+            std::vector<float> kps(nc * 5);
+            std::vector<uint8_t> desc(nc * ORBFeatures::DESC_SIZE);
+            #pragma omp parallel for
+            for (int i = 0; i < nc; i++)
+            {
+                const orb_corner_t &c = corners[i];
+                float angle = _orb_angle(level.data(), w, c.x, c.y);
+                _orb_describe(blur.data(), w, c.x, c.y, angle, desc.data() + i * ORBFeatures::DESC_SIZE);
+                float *kp = kps.data() + i * 5;
+                kp[0] = c.x * scale + roi[0];
+                kp[1] = c.y * scale + roi[1];
+                kp[2] = angle;
+                kp[3] = (float)l;
+                kp[4] = (float)c.score;
+            }
+            for (int i = 0; i < nc; i++)
+                features.add(kps.data() + i * 5, desc.data() + i * ORBFeatures::DESC_SIZE);
+        }
+        return features;
+    }
+
+    // best and second best distance of descriptor in n descriptors
+    static inline void _orb_best2(const uint8_t *q, const uint8_t *train, int n, int &best_idx, int &best, int &second)
+    {
+        best_idx = -1;
+        best = 257;
+        second = 257;
+        for (int j = 0; j < n; j++)
+        {
+            int d = ORB::distance(q, train + j * ORBFeatures::DESC_SIZE);
+            if (d < best)
+            {
+                second = best;
+                best = d;
+                best_idx = j;
+            }
+            else if (d < second)
+            {
+                second = d;
+            }
+        }
+    }
+
+    static inline bool _orb_accept(int best, int second, int max_distance, float ratio)
+    {
+        return best <= max_distance && (ratio >= 1 || second > 256 || best < ratio * second);
+    }
+
+    std::vector<int> ORB::match(image::ORBFeatures &query, image::ORBFeatures &train, int max_distance, float ratio, bool cross_check)
+    {
+        int nq = query.size(), nt = train.size();
+        std::vector<int> result;
+        if (nq == 0 || nt == 0)
+            return result;
+        std::vector<int> idx(nq), dist(nq);
+        const uint8_t *qd = query.descriptors(), *td = train.descriptors();
+        #pragma omp parallel for
+        for (int i = 0; i < nq; i++)
+        {
+            int best_idx, best, second;
+            _orb_best2(qd + i * ORBFeatures::DESC_SIZE, td, nt, best_idx, best, second);
+            idx[i] = _orb_accept(best, second, max_distance, ratio) ? best_idx : -1;
+            dist[i] = best;
+        }
+        std::vector<int> back;
+        if (cross_check)
+        {
+            back.resize(nt);
+            #pragma omp parallel for
+            for (int j = 0; j < nt; j++)
+            {
+                int best_idx, best, second;
+                _orb_best2(td + j * ORBFeatures::DESC_SIZE, qd, nq, best_idx, best, second);
+                back[j] = best_idx;
+            }
+        }
+        for (int i = 0; i < nq; i++)
+        {
+            if (idx[i] < 0 || (cross_check && back[idx[i]] != i))
+                continue;
+            result.push_back(i);
+            result.push_back(idx[i]);
+            result.push_back(dist[i]);
+        }
+        return result;
+    }
+
+    typedef struct
+    {
+        std::vector<image::ORBFeatures> objects;
+        std::vector<uint8_t> desc;                    // descriptors of all objects, contiguous
+        std::vector<uint32_t> owner;                  // object id of descriptor
+        std::vector<uint32_t> kp;                     // keypoint index in object
+        std::vector<uint16_t> keys[ORB_INDEX_TABLES]; // sorted substrings of every table
+        std::vector<uint32_t> ids[ORB_INDEX_TABLES];  // descriptor index, the same order as keys
+        bool dirty;
+    } orb_index_t;
+
+    static inline uint16_t _orb_substring(const uint8_t *desc, int t)
+    {
+        return (uint16_t)(desc[t * 2] | (desc[t * 2 + 1] << 8));
+    }
+
+    // counting sort descriptors by substring of every table
+    static void _orb_index_build(orb_index_t *idx)
+    {
+        int n = (int)idx->owner.size();
+        #pragma omp parallel for
+        for (int t = 0; t < ORB_INDEX_TABLES; t++)
+        {
+            std::vector<uint32_t> count(65537, 0);
+            for (int i = 0; i < n; i++)
+                count[_orb_substring(idx->desc.data() + i * ORBFeatures::DESC_SIZE, t) + 1]++;
+            for (int k = 0; k < 65536; k++)
+                count[k + 1] += count[k];
+            idx->keys[t].resize(n);
+            idx->ids[t].resize(n);
+            for (int i = 0; i < n; i++)
+            {
+                uint16_t key = _orb_substring(idx->desc.data() + i * ORBFeatures::DESC_SIZE, t);
+                uint32_t pos = count[key]++;
+                idx->keys[t][pos] = key;
+                idx->ids[t][pos] = i;
+            }
+        }
+        idx->dirty = false;
+    }
+
+    ORBIndex::ORBIndex(bool multi_probe)
+    {
+        orb_index_t *idx = new orb_index_t();
+        idx->dirty = false;
+        _handle = idx;
+        _multi_probe = multi_probe;
+    }
+
+    ORBIndex::~ORBIndex()
+    {
+        delete (orb_index_t *)_handle;
+        _handle = nullptr;
+    }
+
+    int ORBIndex::add(image::ORBFeatures &features)
+    {
+        orb_index_t *idx = (orb_index_t *)_handle;
+        int id = (int)idx->objects.size();
+        int n = features.size();
+        idx->objects.push_back(features);
+        idx->desc.insert(idx->desc.end(), features.descriptors(), features.descriptors() + n * ORBFeatures::DESC_SIZE);
+        for (int i = 0; i < n; i++)
+        {
+            idx->owner.push_back(id);
+            idx->kp.push_back(i);
+        }
+        idx->dirty = true;
+        return id;
+    }
+
+    image::ORBFeatures ORBIndex::get(int object_id)
+    {
+        orb_index_t *idx = (orb_index_t *)_handle;
+        if (object_id < 0 || object_id >= (int)idx->objects.size())
+            throw err::Exception(err::ERR_ARGS, "ORBIndex object id invalid");
+        return idx->objects[object_id];
+    }
+
+    void ORBIndex::clear()
+    {
+        orb_index_t *idx = (orb_index_t *)_handle;
+        idx->objects.clear();
+        idx->desc.clear();
+        idx->owner.clear();
+        idx->kp.clear();
+        for (int t = 0; t < ORB_INDEX_TABLES; t++)
+        {
+            idx->keys[t].clear();
+            idx->ids[t].clear();
+        }
+        idx->dirty = false;
+    }
+
+    int ORBIndex::size()
+    {
+        orb_index_t *idx = (orb_index_t *)_handle;
+        return (int)idx->objects.size();
+    }
+
+    int ORBIndex::count()
+    {
+        orb_index_t *idx = (orb_index_t *)_handle;
+        return (int)idx->owner.size();
+    }
+
+    std::map<int, std::vector<int>> ORBIndex::query(image::ORBFeatures &features, int max_distance, float ratio, int min_matches)
+    {
+        orb_index_t *idx = (orb_index_t *)_handle;
+        std::map<int, std::vector<int>> result;
+        int nq = features.size(), n = (int)idx->owner.size();
+        if (nq == 0 || n == 0)
+            return result;
+        bool brute = n < ORB_INDEX_MIN;
+        if (!brute && idx->dirty)
+            _orb_index_build(idx);
+        const uint8_t *qd = features.descriptors();
+        const uint8_t *db = idx->desc.data();
+        std::vector<int> best_idx(nq), best_dist(nq);
+        bool multi_probe = _multi_probe;
+        #pragma omp parallel
+        {
+            // candidates found in several tables are verified once
+            std::vector<uint32_t> stamp(brute ? 0 : n, 0);
+            #pragma omp for
+            for (int i = 0; i < nq; i++)
+            {
+                const uint8_t *q = qd + i * ORBFeatures::DESC_SIZE;
+                int bi = -1, best = 257, second = 257;
+                if (brute)
+                {
+                    _orb_best2(q, db, n, bi, best, second);
+                }
+                else
+                {
+                    uint32_t mark = i + 1;
+                    for (int t = 0; t < ORB_INDEX_TABLES; t++)
+                    {
+                        const std::vector<uint16_t> &keys = idx->keys[t];
+                        const uint32_t *ids = idx->ids[t].data();
+                        uint16_t key = _orb_substring(q, t);
+                        for (int probe = -1; probe < (multi_probe ? 16 : 0); probe++)
+                        {
+                            uint16_t k = probe < 0 ? key : key ^ (1 << probe);
+                            auto range = std::equal_range(keys.begin(), keys.end(), k);
+                            for (auto it = range.first; it != range.second; ++it)
+                            {
+                                uint32_t j = ids[it - keys.begin()];
+                                if (stamp[j] == mark)
+                                    continue;
+                                stamp[j] = mark;
+                                int d = ORB::distance(q, db + j * ORBFeatures::DESC_SIZE);
+                                if (d < best)
+                                {
+                                    second = best;
+                                    best = d;
+                                    bi = j;
+                                }
+                                else if (d < second)
+                                {
+                                    second = d;
+                                }
+                            }
+                        }
+                    }
+                }
+                best_idx[i] = bi >= 0 && _orb_accept(best, second, max_distance, ratio) ? bi : -1;
+                best_dist[i] = best;
+            }
+        }
+        for (int i = 0; i < nq; i++)
+        {
+            int j = best_idx[i];
+            if (j < 0)
+                continue;
+            std::vector<int> &m = result[idx->owner[j]];
+            m.push_back(i);
+            m.push_back(idx->kp[j]);
+            m.push_back(best_dist[i]);
+        }
+        for (auto it = result.begin(); it != result.end();)
+        {
+            if ((int)it->second.size() / 3 < min_matches)
+                it = result.erase(it);
+            else
+                ++it;
+        }
+        return result;
+    }
+}
@@ -704,7 +704,7 @@ std::vector<image::LineGroup> Image::search_line_path(int threshold, int merge_d
     }
 
     cv::Mat edges;
-    cv::Mat gray = cv::Mat(gray_img->height(), gray_img->width(), CV_8UC((int)image::fmt_size[gray_img->format()]), gray_img->data());
+    cv::Mat gray = cv::Mat(gray_img->height(), gray_img->width(), CV_8UC((int)image::fmt_size[gray_img->format()]), gray_img->data(), gray_img->stride());
 
     // cv::GaussianBlur(gray, gray, cv::Size(5, 5), 0);
     cv::Canny(gray, edges, 50, 150);
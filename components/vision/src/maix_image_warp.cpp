@@ -0,0 +1,350 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.19: Add Warp, affine and perspective transform with precomputed fixed point maps.
+ */
+
+#include "maix_image_warp.hpp"
+#include "opencv2/opencv.hpp"
+#include <math.h>
+#include <omp.h>
+
+namespace maix::image
+{
+    #define WARP_BITS       (5)
+    #define WARP_SIZE       (1 << WARP_BITS)
+    #define WARP_MAX_SIZE   (32000)
+
+    static bool _warp_invert(const double *m, double *inv)
+    {
+        double det = m[0] * (m[4] * m[8] - m[5] * m[7]) - m[1] * (m[3] * m[8] - m[5] * m[6]) + m[2] * (m[3] * m[7] - m[4] * m[6]);
+        if (fabs(det) < 1e-12)
+            return false;
+        double d = 1.0 / det;
+        inv[0] = (m[4] * m[8] - m[5] * m[7]) * d;
+        inv[1] = (m[2] * m[7] - m[1] * m[8]) * d;
+        inv[2] = (m[1] * m[5] - m[2] * m[4]) * d;
+        inv[3] = (m[5] * m[6] - m[3] * m[8]) * d;
+        inv[4] = (m[0] * m[8] - m[2] * m[6]) * d;
+        inv[5] = (m[2] * m[3] - m[0] * m[5]) * d;
+        inv[6] = (m[3] * m[7] - m[4] * m[6]) * d;
+        inv[7] = (m[1] * m[6] - m[0] * m[7]) * d;
+        inv[8] = (m[0] * m[4] - m[1] * m[3]) * d;
+        return true;
+    }
+
+    // bg bytes of one pixel for format, for 420 formats bg[0] is Y, bg[1] and bg[2] are the chroma pair in memory order
+    static void _warp_bg(const image::Color &c, image::Format format, uint8_t *bg)
+    {
+        int r = c.r, g = c.g, b = c.b;
+        if (c.format == image::FMT_GRAYSCALE)
+            r = g = b = c.gray;
+        uint8_t alpha = (uint8_t)(c.alpha * 255);
+        int y = (r * 77 + g * 150 + b * 29 + 128) >> 8;
+        int u = ((-43 * r - 85 * g + 128 * b + 128) >> 8) + 128;
+        int v = ((128 * r - 107 * g - 21 * b + 128) >> 8) + 128;
+        switch (format)
+        {
+        case image::FMT_GRAYSCALE:
+            bg[0] = c.format == image::FMT_GRAYSCALE ? c.gray : y;
+            break;
+        case image::FMT_RGB888:
+        case image::FMT_RGBA8888:
+            bg[0] = r; bg[1] = g; bg[2] = b; bg[3] = alpha;
+            break;
+        case image::FMT_BGR888:
+        case image::FMT_BGRA8888:
+            bg[0] = b; bg[1] = g; bg[2] = r; bg[3] = alpha;
+            break;
+        case image::FMT_YVU420SP:
+            bg[0] = y; bg[1] = v; bg[2] = u;
+            break;
+        case image::FMT_YUV420SP:
+            bg[0] = y; bg[1] = u; bg[2] = v;
+            break;
+        default:
+            break;
+        }
+    }
+
+    /**
+     * Gather dst pixels from src by map.
+     * bg is nullptr means keep dst pixels map to outside of src,
+     * for bilinear, border pixels which part of neighbors outside of src are also kept, like OpenCV's BORDER_TRANSPARENT.
+     */
+    template <int CH, bool BILINEAR>
+    static void _warp_gather(const uint8_t *src, int src_stride, int src_w, int src_h,
+                             uint8_t *dst, int dst_stride, int w, int h,
+                             const int16_t *map, const uint16_t *frac, const uint8_t *bg)
+    {
+        #pragma omp parallel for
+        for (int y = 0; y < h; y++)
+        {
+            const int16_t *m = map + y * w * 2;
+            const uint16_t *f = BILINEAR ? frac + y * w : nullptr;
+            uint8_t *d = dst + y * dst_stride;
+            for (int x = 0; x < w; x++, d += CH)
+            {
+                int sx = m[x * 2];
+                int sy = m[x * 2 + 1];
+                if (!BILINEAR)
+                {
+                    if ((unsigned)sx < (unsigned)src_w && (unsigned)sy < (unsigned)src_h)
+                    {
+                        const uint8_t *p = src + sy * src_stride + sx * CH;
+                        for (int c = 0; c < CH; c++)
+                            d[c] = p[c];
+                    }
+                    else if (bg)
+                    {
+                        for (int c = 0; c < CH; c++)
+                            d[c] = bg[c];
+                    }
+                    continue;
+                }
+                int fx = f[x] & (WARP_SIZE - 1);
+                int fy = f[x] >> WARP_BITS;
+                int w00 = (WARP_SIZE - fx) * (WARP_SIZE - fy);
+                int w01 = fx * (WARP_SIZE - fy);
+                int w10 = (WARP_SIZE - fx) * fy;
+                int w11 = fx * fy;
+                if ((unsigned)sx < (unsigned)(src_w - 1) && (unsigned)sy < (unsigned)(src_h - 1))
+                {
+                    const uint8_t *p0 = src + sy * src_stride + sx * CH;
+                    const uint8_t *p1 = p0 + src_stride;
+                    for (int c = 0; c < CH; c++)
+                        d[c] = (p0[c] * w00 + p0[c + CH] * w01 + p1[c] * w10 + p1[c + CH] * w11 + (1 << (WARP_BITS * 2 - 1))) >> (WARP_BITS * 2);
+                }
+                else if (!bg)
+                {
+                    continue;
+                }
+                else if (sx >= -1 && sx < src_w && sy >= -1 && sy < src_h)
+                {
+                    // border, neighbors outside of src use bg
+                    bool x0 = sx >= 0, x1 = sx + 1 < src_w, y0 = sy >= 0, y1 = sy + 1 < src_h;
+                    const uint8_t *row0 = src + sy * src_stride;
+                    const uint8_t *row1 = row0 + src_stride;
+                    for (int c = 0; c < CH; c++)
+                    {
+                        int v00 = (x0 && y0) ? row0[sx * CH + c] : bg[c];
+                        int v01 = (x1 && y0) ? row0[(sx + 1) * CH + c] : bg[c];
+                        int v10 = (x0 && y1) ? row1[sx * CH + c] : bg[c];
+                        int v11 = (x1 && y1) ? row1[(sx + 1) * CH + c] : bg[c];
+                        d[c] = (v00 * w00 + v01 * w01 + v10 * w10 + v11 * w11 + (1 << (WARP_BITS * 2 - 1))) >> (WARP_BITS * 2);
+                    }
+                }
+                else
+                {
+                    for (int c = 0; c < CH; c++)
+                        d[c] = bg[c];
+                }
+            }
+        }
+    }
+
+    template <int CH>
+    static void _warp_plane(bool bilinear, const uint8_t *src, int src_stride, int src_w, int src_h,
+                            uint8_t *dst, int dst_stride, int w, int h,
+                            const int16_t *map, const uint16_t *frac, const uint8_t *bg)
+    {
+        if (bilinear)
+            _warp_gather<CH, true>(src, src_stride, src_w, src_h, dst, dst_stride, w, h, map, frac, bg);
+        else
+            _warp_gather<CH, false>(src, src_stride, src_w, src_h, dst, dst_stride, w, h, map, frac, bg);
+    }
+
+    Warp::Warp(std::vector<float> matrix, int src_width, int src_height, int width, int height, image::ResizeMethod method, const image::Color &bg)
+        : _src_width(src_width), _src_height(src_height), _width(width), _height(height), _method(method), _bg(bg)
+    {
+        if (src_width <= 0 || src_height <= 0 || width <= 0 || height <= 0 ||
+            src_width > WARP_MAX_SIZE || src_height > WARP_MAX_SIZE || width > WARP_MAX_SIZE || height > WARP_MAX_SIZE)
+        {
+            log::error("warp size error, src: %dx%d, dst: %dx%d\n", src_width, src_height, width, height);
+            throw err::Exception(err::ERR_ARGS, "warp size error");
+        }
+        if (matrix.size() != 6 && matrix.size() != 9)
+        {
+            log::error("warp matrix should be 6(affine) or 9(perspective) values, but got %d\n", (int)matrix.size());
+            throw err::Exception(err::ERR_ARGS, "warp matrix size error");
+        }
+        if (method != image::ResizeMethod::NEAREST && method != image::ResizeMethod::BILINEAR)
+        {
+            log::error("warp method %d not support, only support NEAREST and BILINEAR\n", method);
+            throw err::Exception(err::ERR_NOT_IMPL, "warp method not support");
+        }
+        double m[9] = {0, 0, 0, 0, 0, 0, 0, 0, 1};
+        for (size_t i = 0; i < matrix.size(); i++)
+            m[i] = matrix[i];
+        double inv[9];
+        if (!_warp_invert(m, inv))
+            throw err::Exception(err::ERR_ARGS, "warp matrix is singular");
+        bool perspective = matrix.size() == 9 && (m[6] != 0 || m[7] != 0);
+        _build_map(inv, perspective, width, height, 1, _map, _frac);
+        // chroma plane of YUV420 is sampled at its own sample centers
+        if (width % 2 == 0 && height % 2 == 0 && src_width % 2 == 0 && src_height % 2 == 0)
+            _build_map(inv, perspective, width / 2, height / 2, 2, _uv_map, _uv_frac);
+    }
+
+    void Warp::_build_map(const double *inv, bool perspective, int width, int height, int scale,
+                          std::vector<int16_t> &map, std::vector<uint16_t> &frac)
+    {
+        bool bilinear = _method == image::ResizeMethod::BILINEAR;
+        map.resize((size_t)width * height * 2);
+        if (bilinear)
+            frac.resize((size_t)width * height);
+        double off = (scale - 1) * 0.5;
+        double max_x = _src_width / scale + 1;
+        double max_y = _src_height / scale + 1;
+        int16_t *m = map.data();
+        uint16_t *f = frac.data();
+        #pragma omp parallel for
+        for (int y = 0; y < height; y++)
+        {
+            double dy = y * scale + off;
+            for (int x = 0; x < width; x++)
+            {
+                double dx = x * scale + off;
+                double sx = inv[0] * dx + inv[1] * dy + inv[2];
+                double sy = inv[3] * dx + inv[4] * dy + inv[5];
+                if (perspective)
+                {
+                    double w = inv[6] * dx + inv[7] * dy + inv[8];
+                    // point at infinity, map to outside
+                    w = w != 0 ? 1.0 / w : NAN;
+                    sx *= w;
+                    sy *= w;
+                }
+                sx = (sx - off) / scale;
+                sy = (sy - off) / scale;
+                // clamp to just outside of src, so far points fit int16 and NaN goes outside
+                sx = (sx > -2) ? (sx < max_x ? sx : max_x) : -2;
+                sy = (sy > -2) ? (sy < max_y ? sy : max_y) : -2;
+                size_t i = (size_t)y * width + x;
+                if (bilinear)
+                {
+                    int ix = (int)lrint(sx * WARP_SIZE);
+                    int iy = (int)lrint(sy * WARP_SIZE);
+                    m[i * 2] = ix >> WARP_BITS;
+                    m[i * 2 + 1] = iy >> WARP_BITS;
+                    f[i] = ((iy & (WARP_SIZE - 1)) << WARP_BITS) | (ix & (WARP_SIZE - 1));
+                }
+                else
+                {
+                    m[i * 2] = (int)floor(sx + 0.5);
+                    m[i * 2 + 1] = (int)floor(sy + 0.5);
+                }
+            }
+        }
+    }
+
+    image::Image *Warp::apply(image::Image &img, image::Image *dst)
+    {
+        image::Format format = img.format();
+        if (img.width() != _src_width || img.height() != _src_height)
+        {
+            log::error("warp image size %dx%d not match src size %dx%d\n", img.width(), img.height(), _src_width, _src_height);
+            throw err::Exception(err::ERR_ARGS, "warp image size not match");
+        }
+        bool yuv = format == image::FMT_YVU420SP || format == image::FMT_YUV420SP;
+        if (!(yuv || format == image::FMT_GRAYSCALE || format == image::FMT_RGB888 || format == image::FMT_BGR888 ||
+              format == image::FMT_RGBA8888 || format == image::FMT_BGRA8888))
+        {
+            log::error("warp not support format: %s\n", image::fmt_names[format].c_str());
+            throw err::Exception(err::ERR_NOT_IMPL, "warp not support format");
+        }
+        if (yuv && _uv_map.empty())
+            throw err::Exception(err::ERR_ARGS, "warp YUV420 image need even width and height");
+        if (dst && (dst->width() != _width || dst->height() != _height || dst->format() != format))
+        {
+            log::error("warp dst image %dx%d %s not match %dx%d %s\n", dst->width(), dst->height(), image::fmt_names[dst->format()].c_str(),
+                       _width, _height, image::fmt_names[format].c_str());
+            throw err::Exception(err::ERR_ARGS, "warp dst image not match");
+        }
+        if (dst == &img)
+            throw err::Exception(err::ERR_ARGS, "warp dst can not be the source image");
+        image::Image *ret = dst ? dst : new image::Image(_width, _height, format);
+        ret->detach();
+
+        uint8_t bg_buf[4] = {0};
+        const uint8_t *bg = nullptr;
+        if (_bg.format != image::FMT_INVALID)
+        {
+            _warp_bg(_bg, format, bg_buf);
+            bg = bg_buf;
+        }
+        bool bilinear = _method == image::ResizeMethod::BILINEAR;
+        const uint8_t *src = (const uint8_t *)img.data();
+        uint8_t *out = (uint8_t *)ret->data();
+        int src_stride = img.stride();
+        int dst_stride = ret->stride();
+        switch (format)
+        {
+        case image::FMT_GRAYSCALE:
+            _warp_plane<1>(bilinear, src, src_stride, _src_width, _src_height, out, dst_stride, _width, _height, _map.data(), _frac.data(), bg);
+            break;
+        case image::FMT_RGB888:
+        case image::FMT_BGR888:
+            _warp_plane<3>(bilinear, src, src_stride, _src_width, _src_height, out, dst_stride, _width, _height, _map.data(), _frac.data(), bg);
+            break;
+        case image::FMT_RGBA8888:
+        case image::FMT_BGRA8888:
+            _warp_plane<4>(bilinear, src, src_stride, _src_width, _src_height, out, dst_stride, _width, _height, _map.data(), _frac.data(), bg);
+            break;
+        default:
+            _warp_plane<1>(bilinear, src, src_stride, _src_width, _src_height, out, dst_stride, _width, _height, _map.data(), _frac.data(), bg);
+            _warp_plane<2>(bilinear, src + src_stride * _src_height, src_stride, _src_width / 2, _src_height / 2,
+                           out + dst_stride * _height, dst_stride, _width / 2, _height / 2, _uv_map.data(), _uv_frac.data(), bg ? bg + 1 : nullptr);
+            break;
+        }
+        return ret;
+    }
+
+    std::vector<float> Warp::affine_matrix(std::vector<int> src_points, std::vector<int> dst_points)
+    {
+        if (src_points.size() < 6 || dst_points.size() < 6)
+            throw err::Exception(err::ERR_ARGS, "3 points are required for affine transform");
+        cv::Point2f src_tri[3];
+        cv::Point2f dst_tri[3];
+        for (int i = 0; i < 3; i++)
+        {
+            src_tri[i] = cv::Point2f(src_points[i * 2], src_points[i * 2 + 1]);
+            dst_tri[i] = cv::Point2f(dst_points[i * 2], dst_points[i * 2 + 1]);
+        }
+        cv::Mat m = cv::getAffineTransform(src_tri, dst_tri);
+        std::vector<float> ret(6);
+        for (int i = 0; i < 6; i++)
+            ret[i] = (float)m.at<double>(i / 3, i % 3);
+        return ret;
+    }
+
+    std::vector<float> Warp::perspective_matrix(std::vector<int> src_points, std::vector<int> dst_points)
+    {
+        if (src_points.size() < 8 || dst_points.size() < 8)
+            throw err::Exception(err::ERR_ARGS, "4 points are required for perspective transform");
+        std::vector<cv::Point2f> src_pts, dst_pts;
+        for (size_t i = 0; i < 8; i += 2)
+        {
+            src_pts.push_back(cv::Point2f(src_points[i], src_points[i + 1]));
+            dst_pts.push_back(cv::Point2f(dst_points[i], dst_points[i + 1]));
+        }
+        cv::Mat m = cv::getPerspectiveTransform(src_pts, dst_pts);
+        std::vector<float> ret(9);
+        for (int i = 0; i < 9; i++)
+            ret[i] = (float)m.at<double>(i / 3, i % 3);
+        return ret;
+    }
+
+    std::vector<float> Warp::rotate_matrix(float angle, int src_width, int src_height, int width, int height)
+    {
+        cv::Point2f center((float)src_width / 2.0, (float)src_height / 2.0);
+        cv::Mat m = cv::getRotationMatrix2D(center, angle, 1.0);
+        m.at<double>(0, 2) += (width - src_width) / 2.0;
+        m.at<double>(1, 2) += (height - src_height) / 2.0;
+        std::vector<float> ret(6);
+        for (int i = 0; i < 6; i++)
+            ret[i] = (float)m.at<double>(i / 3, i % 3);
+        return ret;
+    }
+}
@@ -0,0 +1,136 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_image_jpeg.hpp"
+#include "maix_image_async_writer.hpp"
+#include "main.h"
+#include <atomic>
+
+using namespace maix;
+
+static const char *dir = "/tmp/test_async_writer";
+
+static image::Image *_new_image(int i)
+{
+    image::Image *img = new image::Image(640, 480, image::FMT_RGB888);
+    uint8_t *p = (uint8_t *)img->data();
+    for (int k = 0; k < img->data_size(); k++)
+        p[k] = (k / 3 % 640 + i * 16) & 0xff;
+    return img;
+}
+
+static bool _file_equal(const std::string &path, const uint8_t *data, size_t size)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f)
+        return false;
+    std::vector<uint8_t> buff(size + 1);
+    size_t n = fread(buff.data(), 1, buff.size(), f);
+    fclose(f);
+    return n == size && memcmp(buff.data(), data, size) == 0;
+}
+
+// files are the same as Image.save and JpegEncoder, images are deleted by caller right after write
+static int test_files()
+{
+    const int num = 8;
+    std::atomic<int> written{0};
+    image::AsyncWriter writer;
+    writer.set_callback([&written](const std::string &path, err::Err e)
+                        { written += e == err::ERR_NONE; });
+    for (int i = 0; i < num; i++)
+    {
+        image::Image *img = _new_image(i);
+        writer.write(*img, std::string(dir) + "/" + std::to_string(i) + (i % 2 ? ".jpg" : ".bmp"), 90);
+        delete img;
+    }
+    int errors = writer.wait() != err::ERR_NONE || written != num || writer.failed() || writer.dropped();
+    image::JpegEncoder encoder(90);
+    for (int i = 0; i < num; i++)
+    {
+        image::Image *img = _new_image(i);
+        std::string path = std::string(dir) + "/" + std::to_string(i);
+        bool same;
+        if (i % 2)
+        {
+            uint8_t *data;
+            size_t size;
+            encoder.encode_raw(*img, &data, &size);
+            same = _file_equal(path + ".jpg", data, size);
+        }
+        else
+        {
+            img->save((path + "_ref.bmp").c_str());
+            FILE *f = fopen((path + "_ref.bmp").c_str(), "rb");
+            std::vector<uint8_t> ref(img->data_size() * 2);
+            size_t size = f ? fread(ref.data(), 1, ref.size(), f) : 0;
+            if (f)
+                fclose(f);
+            same = size > 0 && _file_equal(path + ".bmp", ref.data(), size);
+        }
+        if (!same)
+        {
+            log::error("file %d is different", i);
+            ++errors;
+        }
+        delete img;
+    }
+    log::info("files: %d written, %d errors", written.load(), errors);
+    return errors;
+}
+
+// every image is written or reported dropped once
+static int test_drop(image::AsyncWriterPolicy policy)
+{
+    const int num = 20;
+    std::atomic<int> written{0}, dropped{0};
+    int errors = 0;
+    {
+        image::AsyncWriter writer(640 * 480 * 3 * 2, 2, policy, 0);
+        writer.set_callback([&](const std::string &path, err::Err e)
+                            { if (e == err::ERR_NONE) written++; else if (e == err::ERR_BUFF_FULL) dropped++; });
+        image::Image *img = _new_image(0);
+        int rejected = 0;
+        for (int i = 0; i < num; i++)
+            rejected += writer.write(*img, std::string(dir) + "/drop_" + std::to_string(i) + ".jpg") == err::ERR_BUFF_FULL;
+        delete img;
+        writer.wait();
+        if (policy == image::ASYNC_WRITER_DROP_NEW)
+            errors += rejected != writer.dropped();
+        errors += written + writer.dropped() != num || writer.failed();
+        if (policy == image::ASYNC_WRITER_DROP_OLD)
+            errors += dropped != writer.dropped();
+        if (policy == image::ASYNC_WRITER_BLOCK)
+            errors += writer.dropped() != 0;
+        log::info("policy %d: %d written, %d dropped, %d errors", (int)policy, written.load(), writer.dropped(), errors);
+    }
+    return errors;
+}
+
+int _main(int argc, char *argv[])
+{
+    fs::mkdir(dir);
+    int errors = 0;
+    errors += test_files();
+    errors += test_drop(image::ASYNC_WRITER_BLOCK);
+    errors += test_drop(image::ASYNC_WRITER_DROP_NEW);
+    errors += test_drop(image::ASYNC_WRITER_DROP_OLD);
+    fs::rmdir(dir, true);
+    if (errors)
+    {
+        log::error("AsyncWriter test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("AsyncWriter test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,195 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "main.h"
+#include <random>
+
+using namespace maix;
+
+// random bitmap, density is percentage of 1
+static image::Image *_random_bitmap(int w, int h, int density, int seed)
+{
+    std::mt19937 gen(seed);
+    image::Image *img = new image::Image(w, h, image::FMT_BITMAP);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            img->set_pixel(x, y, {(uint32_t)((int)(gen() % 100) < density)});
+    return img;
+}
+
+static bool _same(image::Image &a, image::Image &b)
+{
+    for (int y = 0; y < a.height(); y++)
+        for (int x = 0; x < a.width(); x++)
+            if (a.get_pixel(x, y)[0] != b.get_pixel(x, y)[0])
+                return false;
+    return true;
+}
+
+static int _result(const std::string &name, bool ok)
+{
+    if (ok)
+        log::info("%s: same", name.c_str());
+    else
+        log::error("%s: different", name.c_str());
+    return ok ? 0 : 1;
+}
+
+// grayscale mask makes operations use imlib path, all 255 mask is the same as no mask
+static image::Image *_gray_mask(image::Image &bitmap)
+{
+    image::Image *mask = new image::Image(bitmap.width(), bitmap.height(), image::FMT_GRAYSCALE);
+    for (int y = 0; y < bitmap.height(); y++)
+        for (int x = 0; x < bitmap.width(); x++)
+            mask->set_pixel(x, y, {bitmap.get_pixel(x, y)[0] ? 255u : 0u});
+    return mask;
+}
+
+static int test_logic()
+{
+    const int w = 77, h = 41;
+    int errors = 0;
+    image::Image *other = _random_bitmap(w, h, 50, 2);
+    image::Image *full = _random_bitmap(w, h, 100, 0);
+    image::Image *full_gray = _gray_mask(*full);
+    image::Image *mask = _random_bitmap(w, h, 50, 3);
+    image::Image *gray_mask = _gray_mask(*mask);
+    const char *names[] = {"b_and", "b_nand", "b_or", "b_nor", "b_xor", "b_xnor"};
+    for (int masked = 0; masked < 2; masked++)
+    {
+        // no mask compares with all 255 grayscale mask
+        image::Image *m = masked ? mask : nullptr;
+        image::Image *gm = masked ? gray_mask : full_gray;
+        for (int op = 0; op < 6; op++)
+        {
+            image::Image *fast = _random_bitmap(w, h, 50, 1);
+            image::Image *ref = fast->copy();
+            switch (op)
+            {
+            case 0: fast->b_and(other, m); ref->b_and(other, gm); break;
+            case 1: fast->b_nand(other, m); ref->b_nand(other, gm); break;
+            case 2: fast->b_or(other, m); ref->b_or(other, gm); break;
+            case 3: fast->b_nor(other, m); ref->b_nor(other, gm); break;
+            case 4: fast->b_xor(other, m); ref->b_xor(other, gm); break;
+            default: fast->b_xnor(other, m); ref->b_xnor(other, gm); break;
+            }
+            errors += _result(std::string(names[op]) + (masked ? " mask" : ""), _same(*fast, *ref));
+            delete fast;
+            delete ref;
+        }
+    }
+    delete other;
+    delete full;
+    delete full_gray;
+    delete mask;
+    delete gray_mask;
+    return errors;
+}
+
+static int test_morph()
+{
+    const int w = 77, h = 41;
+    int errors = 0;
+    image::Image *mask = _random_bitmap(w, h, 100, 0);
+    image::Image *gray_mask = _gray_mask(*mask);
+    for (int size = 1; size <= 4; size++)
+    {
+        for (bool dilate : {false, true})
+        {
+            image::Image *fast = _random_bitmap(w, h, dilate ? 10 : 85, size);
+            image::Image *ref = fast->copy();
+            int full = (size * 2 + 1) * (size * 2 + 1) - 1;
+            if (dilate)
+            {
+                fast->dilate(size);
+                ref->dilate(size, 0, gray_mask);
+            }
+            else
+            {
+                fast->erode(size);
+                ref->erode(size, full, gray_mask);
+            }
+            errors += _result(std::string(dilate ? "dilate " : "erode ") + std::to_string(size), _same(*fast, *ref));
+            delete fast;
+            delete ref;
+        }
+    }
+    delete mask;
+    delete gray_mask;
+    return errors;
+}
+
+// popcount histogram is the same as count of pixels
+static int test_histogram()
+{
+    image::Image *img = _random_bitmap(100, 60, 30, 5);
+    std::vector<int> roi = {3, 4, 60, 30};
+    image::Histogram hist = img->get_histogram(std::vector<std::vector<int>>(), false, roi);
+    int ones = 0;
+    for (int y = roi[1]; y < roi[1] + roi[3]; y++)
+        for (int x = roi[0]; x < roi[0] + roi[2]; x++)
+            ones += img->get_pixel(x, y)[0];
+    std::vector<float> bins = hist.bins();
+    float expected = (float)ones / (roi[2] * roi[3]);
+    delete img;
+    return _result("histogram", bins.size() == 2 && fabsf(bins[1] - expected) < 1e-6f && fabsf(bins[0] - (1 - expected)) < 1e-6f);
+}
+
+// run based blobs are the same as imlib flood fill blobs(used when histogram bins set)
+static int test_blobs()
+{
+    int errors = 0;
+    for (int seed = 0; seed < 10; seed++)
+    {
+        int w = 100 + seed * 3, h = 60 + seed;
+        image::Image *img = _random_bitmap(w, h, 40 + seed % 3 * 10, seed);
+        std::vector<int> roi = {seed % 5, seed % 3, w - seed % 5 - 2, h - seed % 3 - 1};
+        for (int x_stride = 1; x_stride <= 3; x_stride++)
+        {
+            std::vector<std::vector<int>> thresholds = {{1, 1}};
+            std::vector<image::Blob> fast = img->find_blobs(thresholds, false, roi, x_stride, 1, 2, 2);
+            std::vector<image::Blob> ref = img->find_blobs(thresholds, false, roi, x_stride, 1, 2, 2, false, 0, 1, 1);
+            auto key = [](std::vector<image::Blob> &blobs)
+            {
+                std::vector<std::vector<int>> keys;
+                for (auto &b : blobs)
+                    keys.push_back({b.pixels(), b.x(), b.y(), b.w(), b.h(), b.code(), (int)(b.cxf() * 100), (int)(b.cyf() * 100)});
+                std::sort(keys.begin(), keys.end());
+                return keys;
+            };
+            if (key(fast) != key(ref))
+            {
+                log::error("blobs of seed %d x_stride %d: %d, expected %d", seed, x_stride, (int)fast.size(), (int)ref.size());
+                ++errors;
+            }
+        }
+        delete img;
+    }
+    return _result("find_blobs", errors == 0);
+}
+
+int _main(int argc, char *argv[])
+{
+    int errors = 0;
+    errors += test_logic();
+    errors += test_morph();
+    errors += test_histogram();
+    errors += test_blobs();
+    if (errors)
+    {
+        log::error("Bitmap image test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("Bitmap image test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,170 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_image_cv.hpp"
+#include "main.h"
+
+using namespace maix;
+
+static int _result(const std::string &name, bool ok)
+{
+    if (ok)
+        log::info("%s: ok", name.c_str());
+    else
+        log::error("%s: failed", name.c_str());
+    return ok ? 0 : 1;
+}
+
+static bool _same(image::Image &a, image::Image &b)
+{
+    if (a.width() != b.width() || a.height() != b.height() || a.format() != b.format())
+        return false;
+    for (int y = 0; y < a.height(); y++)
+        for (int x = 0; x < a.width(); x++)
+            if (a.get_pixel(x, y) != b.get_pixel(x, y))
+                return false;
+    return true;
+}
+
+static void _fill(uint8_t *data, int size)
+{
+    for (int i = 0; i < size; i++)
+        data[i] = (uint8_t)(i * 7 + 3);
+}
+
+// external strided memory wrapped without copy is the same as copied rows
+static int test_external()
+{
+    int errors = 0;
+    const int w = 5, h = 4, stride = 20;
+    int released = 0;
+    uint8_t *ext = (uint8_t *)malloc(stride * h);
+    _fill(ext, stride * h);
+    image::Image *img = new image::Image(w, h, image::FMT_RGB888, ext, stride, [&released, ext]() { released++; free(ext); });
+    image::Image ref(w, h, image::FMT_RGB888);
+    for (int y = 0; y < h; y++)
+        memcpy((uint8_t *)ref.data() + y * ref.stride(), ext + y * stride, w * 3);
+    errors += _result("wrap strided", img->stride() == stride && !img->is_contiguous() && _same(*img, ref));
+
+    // copy on write of shared image packs rows, external memory not changed
+    image::Image *view = img->view(0, 0, w, h);
+    image::Image *shared = img->share();
+    shared->set_pixel(0, 0, {1, 2, 3});
+    ref.set_pixel(0, 0, {1, 2, 3});
+    errors += _result("share copy on write", shared->is_contiguous() && _same(*shared, ref) && ext[0] == 3);
+
+    // view pins the buffer, release only after the last user destroyed
+    delete img;
+    bool alive = released == 0;
+    view->set_pixel(1, 0, {9, 9, 9});
+    bool in_place = ext[3] == 9;
+    delete view;
+    errors += _result("external release", alive && in_place && released == 1);
+    delete shared;
+    errors += _result("external release once", released == 1);
+
+    // bad stride
+    bool thrown = false;
+    uint8_t yuv[8 * 4 * 3 / 2];
+    try
+    {
+        image::Image bad(8, 4, image::FMT_YVU420SP, yuv, 16, nullptr);
+    }
+    catch (err::Exception &e)
+    {
+        thrown = true;
+    }
+    errors += _result("yuv stride not support", thrown);
+    return errors;
+}
+
+// tensor created without copy is the same as copied tensor, and keeps image buffer alive
+static int test_tensor()
+{
+    int errors = 0;
+    image::Image *img = new image::Image(10, 6, image::FMT_RGB888);
+    _fill((uint8_t *)img->data(), img->data_size());
+    tensor::Tensor *copied = img->to_tensor(false, true);
+    tensor::Tensor *shared = img->to_tensor(false, false);
+    errors += _result("to_tensor no copy", shared->shape() == copied->shape() && shared->data() == img->data() &&
+                                               memcmp(shared->data(), copied->data(), img->data_size()) == 0);
+
+    // buffer is pinned, image writes in place
+    img->set_pixel(0, 0, {1, 2, 3});
+    errors += _result("to_tensor write through", ((uint8_t *)shared->data())[2] == 3);
+    delete img;
+    ((uint8_t *)copied->data())[0] = 1;
+    ((uint8_t *)copied->data())[1] = 2;
+    ((uint8_t *)copied->data())[2] = 3;
+    errors += _result("to_tensor alive", memcmp(shared->data(), copied->data(), copied->size_int()) == 0);
+    delete shared;
+    delete copied;
+
+    // tensor with release owner
+    int released = 0;
+    uint8_t buf[2];
+    tensor::Tensor *t = new tensor::Tensor({2}, tensor::UINT8, buf, [&released]() { released++; });
+    tensor::Tensor *t2 = new tensor::Tensor(*t);
+    delete t;
+    bool alive = released == 0;
+    delete t2;
+    errors += _result("tensor release", alive && released == 1);
+    return errors;
+}
+
+// cv::Mat shared without copy is the same as copied mat, and keeps buffer alive
+static int test_cv()
+{
+    int errors = 0;
+    image::Image *img = new image::Image(31, 17, image::FMT_BGR888);
+    _fill((uint8_t *)img->data(), img->data_size());
+    image::Image *view = img->view(3, 2, 20, 11);
+
+    cv::Mat copied, shared;
+    image::image2cv(*view, copied, false, true);
+    image::image2cv(*view, shared, false, false);
+    errors += _result("image2cv no copy", shared.data == view->data() && cv::norm(copied, shared, cv::NORM_INF) == 0);
+    delete view;
+    delete img;
+    cv::Mat row = shared.row(0).clone();
+    errors += _result("image2cv alive", cv::norm(copied.row(0), row, cv::NORM_INF) == 0);
+
+    // roi mat(has stride) to image without copy
+    cv::Mat big(40, 50, CV_8UC3);
+    _fill(big.data, (int)(big.total() * big.elemSize()));
+    cv::Mat roi = big(cv::Rect(7, 5, 21, 13));
+    image::Image *from_copy = image::cv2image(roi, true, true);
+    image::Image *from_shared = image::cv2image(roi, true, false);
+    errors += _result("cv2image no copy", from_shared->data() == roi.data && from_shared->stride() == (int)roi.step[0] && _same(*from_copy, *from_shared));
+    big.release();
+    roi.release();
+    errors += _result("cv2image alive", _same(*from_copy, *from_shared));
+    delete from_copy;
+    delete from_shared;
+    return errors;
+}
+
+int _main(int argc, char *argv[])
+{
+    int errors = 0;
+    errors += test_external();
+    errors += test_tensor();
+    errors += test_cv();
+    if (errors)
+    {
+        log::error("Image buffer owner test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("Image buffer owner test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
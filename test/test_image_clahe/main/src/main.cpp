@@ -0,0 +1,305 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_image_clahe.hpp"
+#include "main.h"
+#include <math.h>
+#include <random>
+
+using namespace maix;
+
+static int _result(const std::string &name, bool ok)
+{
+    if (ok)
+        log::info("%s: ok", name.c_str());
+    else
+        log::error("%s: failed", name.c_str());
+    return ok ? 0 : 1;
+}
+
+// noisy gradient with different brightness in different area
+static image::Image *_gray_image(int w, int h, int seed)
+{
+    std::mt19937 gen(seed);
+    image::Image *img = new image::Image(w, h, image::FMT_GRAYSCALE);
+    uint8_t *p = (uint8_t *)img->data();
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            p[y * img->stride() + x] = (uint8_t)(30 + x * 80 / w + (y < h / 2 ? 0 : 60) + gen() % 24);
+    return img;
+}
+
+// double precision reference of OpenCV's CLAHE: clip and redistribute histogram of every tile,
+// lut = round(cdf * 255 / n), bilinear interpolation of four nearest tile centers' lut
+static std::vector<uint8_t> _clahe_reference(const uint8_t *src, int w, int h, int tiles_x, int tiles_y, float clip_limit)
+{
+    auto bound = [](int size, int tiles, int i) { return (int)((int64_t)size * i / tiles); };
+    std::vector<double> lut(tiles_x * tiles_y * 256);
+    for (int ty = 0; ty < tiles_y; ty++)
+    {
+        for (int tx = 0; tx < tiles_x; tx++)
+        {
+            std::vector<int> hist(256);
+            int n = 0;
+            for (int y = bound(h, tiles_y, ty); y < bound(h, tiles_y, ty + 1); y++)
+                for (int x = bound(w, tiles_x, tx); x < bound(w, tiles_x, tx + 1); x++, n++)
+                    hist[src[y * w + x]]++;
+            if (clip_limit > 0)
+            {
+                int clip = std::max((int)(clip_limit * n / 256), 1);
+                int excess = 0;
+                for (int i = 0; i < 256; i++)
+                {
+                    if (hist[i] > clip)
+                    {
+                        excess += hist[i] - clip;
+                        hist[i] = clip;
+                    }
+                }
+                int batch = excess / 256, residual = excess % 256;
+                for (int i = 0; i < 256; i++)
+                    hist[i] += batch;
+                if (residual > 0)
+                {
+                    int step = std::max(256 / residual, 1);
+                    for (int i = 0; i < 256 && residual > 0; i += step, residual--)
+                        hist[i]++;
+                }
+            }
+            int cdf = 0;
+            for (int i = 0; i < 256; i++)
+            {
+                cdf += hist[i];
+                lut[(ty * tiles_x + tx) * 256 + i] = round(cdf * 255.0 / n);
+            }
+        }
+    }
+    // nearest two tile centers and weight of the second one
+    auto axis = [&](int v, int size, int tiles, int &i0, int &i1, double &f) {
+        auto center = [&](int t) { return (bound(size, tiles, t) + bound(size, tiles, t + 1) - 1) * 0.5; };
+        i0 = i1 = 0;
+        f = 0;
+        if (v <= center(0))
+            return;
+        if (v >= center(tiles - 1))
+        {
+            i0 = i1 = tiles - 1;
+            return;
+        }
+        int t = 0;
+        while (v >= center(t + 1))
+            t++;
+        i0 = t;
+        i1 = t + 1;
+        f = (v - center(t)) / (center(t + 1) - center(t));
+    };
+    std::vector<uint8_t> out(w * h);
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            int x0, x1, y0, y1;
+            double fx, fy;
+            axis(x, w, tiles_x, x0, x1, fx);
+            axis(y, h, tiles_y, y0, y1, fy);
+            int v = src[y * w + x];
+            double top = lut[(y0 * tiles_x + x0) * 256 + v] * (1 - fx) + lut[(y0 * tiles_x + x1) * 256 + v] * fx;
+            double bottom = lut[(y1 * tiles_x + x0) * 256 + v] * (1 - fx) + lut[(y1 * tiles_x + x1) * 256 + v] * fx;
+            out[y * w + x] = (uint8_t)lrint(top * (1 - fy) + bottom * fy);
+        }
+    }
+    return out;
+}
+
+static int test_reference()
+{
+    int errors = 0;
+    struct
+    {
+        int w, h, tiles_x, tiles_y;
+        float clip_limit;
+    } cases[] = {{333, 217, 5, 4, 0}, {333, 217, 5, 4, 2}, {640, 480, 8, 8, 2}, {320, 240, 1, 1, 4}, {127, 95, 16, 12, 1.5}};
+    for (auto &c : cases)
+    {
+        image::Image *img = _gray_image(c.w, c.h, c.w);
+        std::vector<uint8_t> src((uint8_t *)img->data(), (uint8_t *)img->data() + c.w * c.h);
+        std::vector<uint8_t> ref = _clahe_reference(src.data(), c.w, c.h, c.tiles_x, c.tiles_y, c.clip_limit);
+        image::CLAHE clahe(c.clip_limit, c.tiles_x, c.tiles_y);
+        err::Err e = clahe.apply(*img);
+        int max_diff = 0;
+        for (int i = 0; i < c.w * c.h; i++)
+            max_diff = std::max(max_diff, abs(ref[i] - ((uint8_t *)img->data())[i]));
+        char name[128];
+        snprintf(name, sizeof(name), "%dx%d tiles %dx%d clip %.1f max diff %d", c.w, c.h, c.tiles_x, c.tiles_y, c.clip_limit, max_diff);
+        errors += _result(name, e == err::ERR_NONE && max_diff <= 1);
+        delete img;
+    }
+    return errors;
+}
+
+// Y plane of NV21 is the same as grayscale, chroma plane not changed
+static int test_yuv()
+{
+    const int w = 320, h = 240;
+    image::Image *gray = _gray_image(w, h, 1);
+    image::Image yuv(w, h, image::FMT_YVU420SP);
+    uint8_t *p = (uint8_t *)yuv.data();
+    memcpy(p, gray->data(), w * h);
+    for (int i = 0; i < w * h / 2; i++)
+        p[w * h + i] = (uint8_t)(i * 13);
+    image::CLAHE(2, 8, 8).apply(*gray);
+    image::CLAHE(2, 8, 8).apply(yuv);
+    bool ok = memcmp(p, gray->data(), w * h) == 0;
+    for (int i = 0; i < w * h / 2 && ok; i++)
+        ok = p[w * h + i] == (uint8_t)(i * 13);
+    delete gray;
+    return _result("YVU420SP", ok);
+}
+
+// RGB adds difference of equalized luma to every channel
+static int test_rgb()
+{
+    int errors = 0;
+    const int w = 320, h = 240;
+    image::Format formats[] = {image::FMT_RGB888, image::FMT_BGR888, image::FMT_RGBA8888};
+    for (auto format : formats)
+    {
+        std::mt19937 gen(2);
+        int ch = (int)image::fmt_size[format];
+        bool bgr = format == image::FMT_BGR888;
+        image::Image img(w, h, format);
+        uint8_t *p = (uint8_t *)img.data();
+        for (int i = 0; i < w * h * ch; i++)
+            p[i] = (uint8_t)(i % ch == 3 ? 200 : 20 + (i / ch % w) * 100 / w + i % ch * 40 + gen() % 16);
+        image::Image orig(w, h, format);
+        memcpy(orig.data(), p, w * h * ch);
+
+        image::Image luma(w, h, image::FMT_GRAYSCALE);
+        uint8_t *l = (uint8_t *)luma.data();
+        for (int i = 0; i < w * h; i++)
+        {
+            const uint8_t *q = p + i * ch;
+            l[i] = (q[bgr ? 2 : 0] * 77 + q[1] * 150 + q[bgr ? 0 : 2] * 29 + 128) >> 8;
+        }
+        image::Image equalized(w, h, image::FMT_GRAYSCALE);
+        memcpy(equalized.data(), l, w * h);
+        image::CLAHE(2, 8, 8).apply(equalized);
+        image::CLAHE(2, 8, 8).apply(img);
+
+        bool ok = true;
+        const uint8_t *o = (uint8_t *)orig.data(), *e = (uint8_t *)equalized.data();
+        for (int i = 0; i < w * h && ok; i++)
+        {
+            int d = e[i] - l[i];
+            for (int c = 0; c < ch; c++)
+            {
+                int expected = c == 3 ? o[i * ch + c] : std::min(std::max(o[i * ch + c] + d, 0), 255);
+                ok = ok && p[i * ch + c] == expected;
+            }
+        }
+        errors += _result(image::fmt_names[format], ok);
+    }
+    return errors;
+}
+
+// lut reuse(temporal blend and partial update) gives the same result as a new CLAHE on static frames
+static int test_frames()
+{
+    int errors = 0;
+    const int w = 320, h = 240;
+    image::Image *src = _gray_image(w, h, 3);
+    image::Image *expected = src->copy();
+    image::CLAHE(2, 8, 8).apply(*expected);
+    struct
+    {
+        float temporal;
+        int update_interval;
+    } cases[] = {{0, 1}, {0.5, 1}, {0.8, 4}, {0, 3}};
+    for (auto &c : cases)
+    {
+        image::CLAHE clahe(2, 8, 8, c.temporal, c.update_interval);
+        bool ok = true;
+        for (int i = 0; i < 6; i++)
+        {
+            image::Image *img = src->copy();
+            clahe.apply(*img);
+            ok = ok && memcmp(img->data(), expected->data(), w * h) == 0;
+            delete img;
+        }
+        // reset and size change start from new lut
+        image::Image *other = _gray_image(w / 2, h / 2, 4);
+        image::Image *other_expected = other->copy();
+        image::CLAHE(2, 8, 8).apply(*other_expected);
+        clahe.apply(*other);
+        ok = ok && memcmp(other->data(), other_expected->data(), w / 2 * h / 2) == 0;
+        delete other;
+        delete other_expected;
+        char name[64];
+        snprintf(name, sizeof(name), "temporal %.1f update_interval %d", c.temporal, c.update_interval);
+        errors += _result(name, ok);
+    }
+
+    // reset drops previous lut, not blended with new frame
+    image::CLAHE clahe(2, 8, 8, 0.5);
+    image::Image *img = src->copy();
+    clahe.apply(*img);
+    delete img;
+    image::Image *dark = _gray_image(w, h, 3);
+    uint8_t *p = (uint8_t *)dark->data();
+    for (int i = 0; i < w * h; i++)
+        p[i] /= 2;
+    image::Image *dark_expected = dark->copy();
+    image::CLAHE(2, 8, 8).apply(*dark_expected);
+    clahe.reset();
+    clahe.apply(*dark);
+    errors += _result("reset", memcmp(dark->data(), dark_expected->data(), w * h) == 0);
+    delete dark;
+    delete dark_expected;
+    delete expected;
+    delete src;
+    return errors;
+}
+
+static int test_errors()
+{
+    bool thrown = false;
+    try
+    {
+        image::CLAHE clahe(2, 0, 8);
+    }
+    catch (err::Exception &e)
+    {
+        thrown = true;
+    }
+    image::Image rgb565(64, 48, image::FMT_RGB565);
+    image::Image small(4, 4, image::FMT_GRAYSCALE);
+    image::CLAHE clahe(2, 8, 8);
+    return _result("errors", thrown && clahe.apply(rgb565) == err::ERR_ARGS && clahe.apply(small) == err::ERR_ARGS);
+}
+
+int _main(int argc, char *argv[])
+{
+    int errors = 0;
+    errors += test_reference();
+    errors += test_yuv();
+    errors += test_rgb();
+    errors += test_frames();
+    errors += test_errors();
+    if (errors)
+    {
+        log::error("Image CLAHE test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("Image CLAHE test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
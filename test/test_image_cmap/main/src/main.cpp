@@ -0,0 +1,132 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "main.h"
+#include <random>
+
+using namespace maix;
+
+// colormap index of DepthAnything get_depth_image before from_float, truncated
+static int _index_ref(float v, float min_v, float max_v)
+{
+    return (int)std::clamp((v - min_v) * (255.0f / (max_v - min_v)), 0.0f, 255.0f);
+}
+
+// color of pixel must be color of reference index, or the next one as from_float rounds index
+static bool _color_match(const uint8_t *p, const std::vector<std::array<uint8_t, 3>> &colors, int idx, bool bgr)
+{
+    for (int i = idx; i <= std::min(idx + 1, 255); i++)
+    {
+        const std::array<uint8_t, 3> &c = colors[i];
+        if (bgr ? (p[0] == c[2] && p[1] == c[1] && p[2] == c[0]) : (p[0] == c[0] && p[1] == c[1] && p[2] == c[2]))
+            return true;
+    }
+    return false;
+}
+
+static int test_from_float(image::CMap cmap, image::Format format, bool auto_range)
+{
+    const int w = 160, h = 120;
+    std::mt19937 gen((int)cmap);
+    std::uniform_real_distribution<float> dist(-3, 40);
+    std::vector<float> data(w * h);
+    for (auto &v : data)
+        v = dist(gen);
+    float min_v = 0, max_v = 30;
+    image::Image *img = image::from_float(data.data(), w, h, auto_range ? 0 : min_v, auto_range ? 0 : max_v, cmap, image::Size(), format);
+    if (auto_range)
+    {
+        min_v = *std::min_element(data.begin(), data.end());
+        max_v = *std::max_element(data.begin(), data.end());
+    }
+    auto &colors = image::cmap_colors_rgb(cmap);
+    int errors = img->width() != w || img->height() != h || img->format() != format;
+    for (int i = 0; i < w * h && !errors; i++)
+    {
+        int idx = _index_ref(data[i], min_v, max_v);
+        if (!_color_match((uint8_t *)img->data() + i * 3, colors, idx, format == image::FMT_BGR888))
+        {
+            log::error("pixel %d value %f index %d color not match", i, data[i], idx);
+            ++errors;
+        }
+    }
+    log::info("from_float cmap %d %s %s: %s", (int)cmap, image::fmt_names[format].c_str(), auto_range ? "auto range" : "fixed range",
+              errors ? "different" : "same");
+    delete img;
+    return errors;
+}
+
+// gray value is colormap index, view is supported
+static int test_apply_cmap()
+{
+    image::Image gray(64, 48, image::FMT_GRAYSCALE);
+    uint8_t *g = (uint8_t *)gray.data();
+    for (int i = 0; i < gray.data_size(); i++)
+        g[i] = i * 5;
+    image::Image *view = gray.view(8, 4, 40, 30);
+    image::Image *img = view->apply_cmap(image::CMap::INFERNO);
+    auto &colors = image::cmap_colors_rgb(image::CMap::INFERNO);
+    int errors = 0;
+    for (int y = 0; y < img->height(); y++)
+    {
+        for (int x = 0; x < img->width(); x++)
+        {
+            const uint8_t *p = (uint8_t *)img->data() + (y * img->width() + x) * 3;
+            auto &c = colors[g[(y + 4) * gray.width() + x + 8]];
+            errors += p[0] != c[0] || p[1] != c[1] || p[2] != c[2];
+        }
+    }
+    log::info("apply_cmap: %s", errors ? "different" : "same");
+    delete img;
+    delete view;
+    return errors;
+}
+
+// resize in the same pass keeps constant area color, all equal values map to the middle color
+static int test_resize()
+{
+    std::vector<float> data(32 * 24, 10.f);
+    auto &colors = image::cmap_colors_rgb(image::CMap::TURBO);
+    int errors = 0;
+    for (auto size : {image::Size(320, 240), image::Size(16, 12)})
+    {
+        image::Image *img = image::from_float(data.data(), 32, 24, 0, 0, image::CMap::TURBO, size);
+        errors += img->width() != size.width() || img->height() != size.height();
+        const uint8_t *p = (uint8_t *)img->data();
+        for (int i = 0; i < img->width() * img->height(); i++)
+            errors += p[i * 3] != colors[127][0] || p[i * 3 + 1] != colors[127][1] || p[i * 3 + 2] != colors[127][2];
+        delete img;
+    }
+    log::info("resize: %s", errors ? "different" : "same");
+    return errors;
+}
+
+int _main(int argc, char *argv[])
+{
+    int errors = 0;
+    for (auto cmap : {image::CMap::TURBO, image::CMap::VIRIDIS, image::CMap::GREYS})
+    {
+        errors += test_from_float(cmap, image::FMT_RGB888, true);
+        errors += test_from_float(cmap, image::FMT_RGB888, false);
+        errors += test_from_float(cmap, image::FMT_BGR888, true);
+    }
+    errors += test_apply_cmap();
+    errors += test_resize();
+    if (errors)
+    {
+        log::error("Colormap test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("Colormap test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,195 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_image_displacement.hpp"
+#include "main.h"
+#include <math.h>
+#include <random>
+
+using namespace maix;
+
+static const int _tex_size = 512;
+static std::vector<float> _tex;
+
+static int _result(const std::string &name, bool ok)
+{
+    if (ok)
+        log::info("%s: ok", name.c_str());
+    else
+        log::error("%s: failed", name.c_str());
+    return ok ? 0 : 1;
+}
+
+// smooth random texture with high contrast
+static void _create_texture()
+{
+    std::mt19937 gen(1);
+    _tex.resize(_tex_size * _tex_size);
+    for (auto &v : _tex)
+        v = gen() % 256;
+    std::vector<float> tmp(_tex);
+    for (int k = 0; k < 3; k++)
+    {
+        for (int y = 1; y < _tex_size - 1; y++)
+        {
+            for (int x = 1; x < _tex_size - 1; x++)
+            {
+                float s = 0;
+                for (int j = -1; j <= 1; j++)
+                    for (int i = -1; i <= 1; i++)
+                        s += _tex[(y + j) * _tex_size + x + i];
+                tmp[y * _tex_size + x] = s / 9;
+            }
+        }
+        _tex = tmp;
+    }
+    for (auto &v : _tex)
+        v = std::max(0.f, std::min(255.f, (v - 128) * 4 + 128));
+}
+
+static float _texture(float x, float y)
+{
+    x = std::max(0.f, std::min(x, (float)_tex_size - 2));
+    y = std::max(0.f, std::min(y, (float)_tex_size - 2));
+    int x0 = (int)x, y0 = (int)y;
+    float ax = x - x0, ay = y - y0;
+    const float *p = &_tex[y0 * _tex_size + x0];
+    return (p[0] * (1 - ax) + p[1] * ax) * (1 - ay) + (p[_tex_size] * (1 - ax) + p[_tex_size + 1] * ax) * ay;
+}
+
+// frame content moved by (tx, ty), rotated clockwise by angle and scaled around image center
+static image::Image *_frame(int w, int h, float tx, float ty, float angle = 0, float scale = 1)
+{
+    image::Image *img = new image::Image(w, h, image::FMT_GRAYSCALE);
+    uint8_t *p = (uint8_t *)img->data();
+    float cx = (w - 1) / 2.f, cy = (h - 1) / 2.f;
+    float c = cosf(angle) / scale, s = sinf(angle) / scale;
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            float qx = x - cx - tx, qy = y - cy - ty;
+            p[y * w + x] = (uint8_t)_texture(c * qx + s * qy + _tex_size / 2, -s * qx + c * qy + _tex_size / 2);
+        }
+    }
+    return img;
+}
+
+static const float _moves[][2] = {{0, 0}, {5, -3}, {12.5, 7.25}, {-20, 15}, {1.5, -0.5}};
+
+// phase correlation is the same as Image.find_displacement(y sign opposite), and closer to real motion
+static int test_find_displacement()
+{
+    int errors = 0;
+    const int w = 128, h = 128;
+    image::Image *ref = _frame(w, h, 0, 0);
+    image::DisplacementTracker tracker(image::DISPLACEMENT_PHASE, w, h);
+    tracker.set_reference(*ref);
+    for (auto &m : _moves)
+    {
+        image::Image *img = _frame(w, h, m[0], m[1]);
+        image::Displacement d = tracker.update(*img);
+        image::Displacement old = img->find_displacement(*ref, {0, 0, w, h}, {0, 0, w, h});
+        char name[128];
+        snprintf(name, sizeof(name), "move %.2f %.2f: tracker %.2f %.2f, find_displacement %.2f %.2f",
+                 m[0], m[1], d.x_translation(), d.y_translation(), old.x_translation(), old.y_translation());
+        errors += _result(name, fabsf(d.x_translation() - old.x_translation()) < 0.5f && fabsf(d.y_translation() + old.y_translation()) < 0.5f &&
+                                    fabsf(d.x_translation() - m[0]) < 0.25f && fabsf(d.y_translation() - m[1]) < 0.25f && d.response() > 0.1f);
+        delete img;
+    }
+    delete ref;
+    return errors;
+}
+
+// cached reference gives the same result as a new tracker every frame, roi and resample to working size
+static int test_cache()
+{
+    const int w = 320, h = 240;
+    std::vector<int> roi = {60, 40, 192, 160};
+    image::Image *ref = _frame(w, h, 0, 0);
+    image::DisplacementTracker tracker(image::DISPLACEMENT_PHASE, 64, 64);
+    tracker.set_reference(*ref, roi);
+    bool ok = true;
+    for (auto &m : _moves)
+    {
+        image::Image *img = _frame(w, h, m[0], m[1]);
+        image::DisplacementTracker fresh(image::DISPLACEMENT_PHASE, 64, 64);
+        fresh.set_reference(*ref, roi);
+        image::Displacement a = tracker.update(*img, roi);
+        image::Displacement b = fresh.update(*img, roi);
+        ok = ok && a.x_translation() == b.x_translation() && a.y_translation() == b.y_translation() && a.response() == b.response() &&
+             fabsf(a.x_translation() - m[0]) < 0.5f && fabsf(a.y_translation() - m[1]) < 0.5f;
+        delete img;
+    }
+    delete ref;
+    return _result("cached reference with roi", ok);
+}
+
+static int test_rotation_scale()
+{
+    int errors = 0;
+    const int w = 256, h = 256;
+    const float cases[][4] = {{3, 2, 0.1f, 1}, {0, 0, -0.2f, 1.1f}, {4, -6, 0.15f, 0.9f}};
+    for (int lk = 0; lk < 2; lk++)
+    {
+        image::DisplacementTracker tracker(lk ? image::DISPLACEMENT_LK : image::DISPLACEMENT_PHASE, lk ? 160 : 128, lk ? 160 : 128, true);
+        image::Image *ref = _frame(w, h, 0, 0);
+        tracker.set_reference(*ref);
+        delete ref;
+        for (auto &c : cases)
+        {
+            image::Image *img = _frame(w, h, c[0], c[1], c[2], c[3]);
+            image::Displacement d = tracker.update(*img);
+            delete img;
+            char name[160];
+            snprintf(name, sizeof(name), "%s move %.2f %.2f rotate %.2f scale %.2f: got %.2f %.2f %.3f %.3f",
+                     lk ? "LK" : "phase", c[0], c[1], c[2], c[3], d.x_translation(), d.y_translation(), d.rotation(), d.scale());
+            errors += _result(name, fabsf(d.x_translation() - c[0]) < 1 && fabsf(d.y_translation() - c[1]) < 1 &&
+                                        fabsf(d.rotation() - c[2]) < 0.02f && fabsf(d.scale() - c[3]) < 0.02f);
+        }
+    }
+    return errors;
+}
+
+static int test_errors()
+{
+    bool thrown = false;
+    try
+    {
+        image::DisplacementTracker tracker(image::DISPLACEMENT_PHASE, 100, 128);
+    }
+    catch (err::Exception &e)
+    {
+        thrown = true;
+    }
+    image::DisplacementTracker tracker;
+    image::Image rgb565(128, 128, image::FMT_RGB565);
+    return _result("errors", thrown && tracker.set_reference(rgb565) == err::ERR_ARGS);
+}
+
+int _main(int argc, char *argv[])
+{
+    int errors = 0;
+    _create_texture();
+    errors += test_find_displacement();
+    errors += test_cache();
+    errors += test_rotation_scale();
+    errors += test_errors();
+    if (errors)
+    {
+        log::error("Image displacement test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("Image displacement test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
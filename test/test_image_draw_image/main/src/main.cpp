@@ -0,0 +1,140 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "main.h"
+#include <random>
+
+using namespace maix;
+
+// Porter-Duff over of one channel on opaque destination, exact divide by 255
+static int _blend_ref(int src, int alpha, int dst)
+{
+    return (src * alpha + dst * (255 - alpha) + 127) / 255;
+}
+
+// blend of RGBA on RGBA of draw_image before, divide by 256
+static int _blend_old(int src, int alpha, int dst)
+{
+    if (alpha == 255)
+        return src;
+    return (uint32_t)(src * alpha + dst * (255 - alpha)) >> 8;
+}
+
+// overlay columns: 0~15 transparent, 16~31 opaque, others random alpha, so all tile types are used
+static void _fill_overlay(image::Image &img, std::mt19937 &gen)
+{
+    uint8_t *p = (uint8_t *)img.data();
+    for (int y = 0; y < img.height(); y++)
+    {
+        for (int x = 0; x < img.width(); x++)
+        {
+            uint8_t *px = p + (y * img.width() + x) * 4;
+            px[0] = gen();
+            px[1] = gen();
+            px[2] = gen();
+            px[3] = x < 16 ? 0 : (x < 32 ? 255 : gen());
+        }
+    }
+}
+
+static int test_blend(image::Format dst_format, image::Format src_format, int x, int y)
+{
+    std::mt19937 gen(dst_format * 10 + src_format);
+    const int w = 160, h = 120;
+    int ch = (int)image::fmt_size[dst_format];
+    bool dst_bgr = dst_format == image::FMT_BGR888 || dst_format == image::FMT_BGRA8888;
+    bool src_bgr = src_format == image::FMT_BGRA8888;
+    image::Image dst(w, h, dst_format);
+    uint8_t *d = (uint8_t *)dst.data();
+    for (int i = 0; i < dst.data_size(); i++)
+        d[i] = ch == 4 && i % 4 == 3 ? 255 : gen();
+    std::vector<uint8_t> origin(d, d + dst.data_size());
+    image::Image overlay(70, 50, src_format);
+    _fill_overlay(overlay, gen);
+    uint8_t *o = (uint8_t *)overlay.data();
+    dst.draw_image(x, y, overlay);
+
+    int errors = 0, max_old_err = 0;
+    for (int j = 0; j < h; j++)
+    {
+        for (int i = 0; i < w; i++)
+        {
+            uint8_t *px = d + (j * w + i) * ch;
+            const uint8_t *org = origin.data() + (j * w + i) * ch;
+            int sx = i - x, sy = j - y;
+            bool inside = sx >= 0 && sx < overlay.width() && sy >= 0 && sy < overlay.height();
+            for (int c = 0; c < ch; c++)
+            {
+                int expected = org[c], old = org[c];
+                if (inside)
+                {
+                    const uint8_t *s = o + (sy * overlay.width() + sx) * 4;
+                    int src_c = c == 3 ? 255 : s[(src_bgr != dst_bgr) ? 2 - c : c];
+                    expected = c == 3 ? 255 : _blend_ref(src_c, s[3], org[c]);
+                    old = c == 3 ? 255 : (s[3] ? _blend_old(src_c, s[3], org[c]) : org[c]);
+                }
+                if (px[c] != expected && errors++ < 5)
+                    log::error("pixel (%d, %d) channel %d: %d, expected %d", i, j, c, px[c], expected);
+                max_old_err = std::max(max_old_err, abs(px[c] - old));
+            }
+        }
+    }
+    // old loop divides by 256, so it is darker by at most 2
+    if (ch == 4 && max_old_err > 2)
+        ++errors;
+    log::info("%s on %s at (%d, %d): %d errors, max difference to old blend %d", image::fmt_names[src_format].c_str(),
+              image::fmt_names[dst_format].c_str(), x, y, errors, max_old_err);
+    return errors;
+}
+
+// tile cache of overlay is rebuilt after overlay modified
+static int test_cache()
+{
+    image::Image dst(32, 32, image::FMT_RGB888);
+    memset(dst.data(), 0, dst.data_size());
+    image::Image overlay(32, 32, image::FMT_RGBA8888);
+    memset(overlay.data(), 0, overlay.data_size());
+    dst.draw_image(0, 0, overlay);
+    bool ok = ((uint8_t *)dst.data())[0] == 0;
+    overlay.set_pixel(0, 0, {255, 255, 255});
+    dst.draw_image(0, 0, overlay);
+    ok = ok && ((uint8_t *)dst.data())[0] == 255;
+    // modify by data() directly, tile of pixel (20, 20) was fully transparent
+    uint8_t *p = (uint8_t *)overlay.data() + (20 * 32 + 20) * 4;
+    memset(p, 255, 4);
+    dst.draw_image(0, 0, overlay);
+    ok = ok && ((uint8_t *)dst.data())[(20 * 32 + 20) * 3] == 255;
+    log::info("tile cache: %s", ok ? "ok" : "failed");
+    return !ok;
+}
+
+int _main(int argc, char *argv[])
+{
+    int errors = 0;
+    for (auto dst_format : {image::FMT_RGB888, image::FMT_BGR888, image::FMT_RGBA8888, image::FMT_BGRA8888})
+    {
+        for (auto src_format : {image::FMT_RGBA8888, image::FMT_BGRA8888})
+        {
+            errors += test_blend(dst_format, src_format, 10, 20);
+            errors += test_blend(dst_format, src_format, -13, 90);
+        }
+    }
+    errors += test_cache();
+    if (errors)
+    {
+        log::error("draw_image blend test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("draw_image blend test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
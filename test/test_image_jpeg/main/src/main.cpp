@@ -0,0 +1,135 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_image_jpeg.hpp"
+#include "main.h"
+
+using namespace maix;
+
+// smooth gradient, jpeg error of it is small
+static void _fill(image::Image &img)
+{
+    uint8_t *p = (uint8_t *)img.data();
+    int w = img.width(), h = img.height();
+    if (img.format() == image::FMT_RGB888)
+    {
+        for (int y = 0; y < h; y++)
+        {
+            for (int x = 0; x < w; x++)
+            {
+                p[(y * w + x) * 3] = x * 255 / w;
+                p[(y * w + x) * 3 + 1] = y * 255 / h;
+                p[(y * w + x) * 3 + 2] = (x + y) * 255 / (w + h);
+            }
+        }
+    }
+    else // GRAYSCALE or YVU420SP
+    {
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++)
+                p[y * w + x] = (x + y) * 255 / (w + h);
+        if (img.format() == image::FMT_YVU420SP)
+            memset(p + w * h, 128, w * h / 2);
+    }
+}
+
+// mean absolute error of decoded image and source, compare luma only for YUV
+static float _mean_error(image::Image &src, image::Image &decoded)
+{
+    uint8_t *s = (uint8_t *)src.data();
+    uint8_t *d = (uint8_t *)decoded.data();
+    int n = src.width() * src.height() * (src.format() == image::FMT_RGB888 ? 3 : 1);
+    double sum = 0;
+    for (int i = 0; i < n; i++)
+        sum += abs(s[i] - d[i]);
+    return sum / n;
+}
+
+static int test_encode(image::Format format, int w, int h)
+{
+    image::Image img(w, h, format);
+    _fill(img);
+    image::JpegDecoder decoder(format == image::FMT_RGB888 ? image::FMT_RGB888 : image::FMT_GRAYSCALE);
+    image::Image *ref = nullptr;
+    int errors = 0;
+    for (int slices : {1, 3, 0})
+    {
+        image::JpegEncoder encoder(95, slices);
+        // encode twice, reused encoder context gets the same result
+        uint8_t *data;
+        size_t size, size2;
+        encoder.encode_raw(img, &data, &size);
+        std::vector<uint8_t> first(data, data + size);
+        encoder.encode_raw(img, &data, &size2);
+        bool same = size == size2 && memcmp(first.data(), data, size) == 0;
+        image::Image *decoded = decoder.decode(data, size2);
+        if (!decoded || decoded->width() != w || decoded->height() != h)
+        {
+            log::error("%s %dx%d slices %d decode failed", image::fmt_names[format].c_str(), w, h, slices);
+            delete decoded;
+            ++errors;
+            continue;
+        }
+        float err = _mean_error(img, *decoded);
+        // slices are joined by restart markers, decoded pixels are the same as not split
+        if (!ref)
+            ref = decoded->copy();
+        bool same_slices = memcmp(ref->data(), decoded->data(), ref->data_size()) == 0;
+        log::info("%s %dx%d slices %d: %d bytes, mean error %.2f, %s", image::fmt_names[format].c_str(), w, h, slices, (int)size,
+                  err, same && same_slices ? "same" : "different");
+        errors += !same || !same_slices || err > 2;
+        delete decoded;
+    }
+    delete ref;
+    return errors;
+}
+
+// encode to caller buffer, buffer not enough raise exception
+static int test_buffer()
+{
+    image::Image img(640, 480, image::FMT_RGB888);
+    _fill(img);
+    image::JpegEncoder encoder;
+    std::vector<uint8_t> buff(1 << 20);
+    image::Image *jpg = encoder.encode(img, buff.data(), buff.size());
+    bool ok = jpg->format() == image::FMT_JPEG && jpg->data() == buff.data();
+    delete jpg;
+    try
+    {
+        jpg = encoder.encode(img, buff.data(), 10);
+        delete jpg;
+        ok = false;
+    }
+    catch (err::Exception &e)
+    {
+    }
+    log::info("encode to buffer: %s", ok ? "ok" : "failed");
+    return !ok;
+}
+
+int _main(int argc, char *argv[])
+{
+    int errors = 0;
+    errors += test_encode(image::FMT_RGB888, 640, 480);
+    errors += test_encode(image::FMT_RGB888, 333, 201);
+    errors += test_encode(image::FMT_GRAYSCALE, 320, 240);
+    errors += test_encode(image::FMT_YVU420SP, 640, 480);
+    errors += test_buffer();
+    if (errors)
+    {
+        log::error("JPEG encoder test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("JPEG encoder test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
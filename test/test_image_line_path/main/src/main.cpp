@@ -0,0 +1,143 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_image_line_path.hpp"
+#include "main.h"
+
+using namespace maix;
+
+// draw dark rectangle on bright gray image
+static void _fill_rect(image::Image &img, int x1, int y1, int x2, int y2)
+{
+    uint8_t *p = (uint8_t *)img.data();
+    for (int y = y1; y < y2; y++)
+        memset(p + y * img.width() + x1, 20, x2 - x1);
+}
+
+// every path point must be the center of a dark run on its scanline, found by scanning every pixel
+static int _check_points(image::Image &img, const image::LinePathResult &res, int col_step)
+{
+    int errors = 0;
+    uint8_t *p = (uint8_t *)img.data();
+    for (auto &path : res.paths)
+    {
+        for (int i = 0; i < path.num_points; i++)
+        {
+            const image::LinePathPoint &pt = path.points[i];
+            uint8_t *row = p + pt.y * img.width();
+            bool found = false;
+            for (int x = 0; x < img.width() && !found; x++)
+            {
+                if (row[x] > res.threshold)
+                    continue;
+                int x1 = x;
+                while (x < img.width() && row[x] <= res.threshold)
+                    x++;
+                found = abs((x1 + x) / 2 - pt.x) <= col_step && abs(x - x1 - pt.width) <= col_step;
+            }
+            if (i > 0 && pt.y >= path.points[i - 1].y)
+                found = false;
+            if (!found && errors++ < 5)
+                log::error("path %d point (%d, %d) width %d is not a run center", path.id, pt.x, pt.y, pt.width);
+        }
+    }
+    return errors;
+}
+
+// one vertical line, path id keeps the same in continuous frames
+static int test_line()
+{
+    image::Image img(320, 240, image::FMT_GRAYSCALE);
+    memset(img.data(), 220, img.data_size());
+    _fill_rect(img, 150, 60, 166, 240);
+    image::LinePathSearcher searcher;
+    int errors = 0;
+    for (int frame = 0; frame < 3; frame++)
+    {
+        const image::LinePathResult &res = searcher.update(img);
+        errors += _check_points(img, res, 2);
+        bool ok = res.paths.size() == 1 && res.paths[0].id == 0 && res.paths[0].num_points == (240 - 60) / 4 && res.bars.empty();
+        if (!ok)
+            log::error("line frame %d: %d paths, %d points", frame, (int)res.paths.size(), res.paths.empty() ? 0 : res.paths[0].num_points);
+        errors += !ok;
+    }
+    std::vector<image::LineGroup> groups = searcher.search(img);
+    errors += groups.size() != 1;
+    log::info("line: %d groups, %d errors", (int)groups.size(), errors);
+    return errors;
+}
+
+// vertical line crossed by a horizontal line, wide runs are the bar
+static int test_cross()
+{
+    image::Image img(320, 240, image::FMT_GRAYSCALE);
+    memset(img.data(), 220, img.data_size());
+    _fill_rect(img, 150, 20, 166, 240);
+    _fill_rect(img, 60, 100, 260, 112);
+    image::LinePathSearcher searcher;
+    const image::LinePathResult &res = searcher.update(img);
+    int errors = _check_points(img, res, 2);
+    bool ok = res.bars.size() == 1 && !res.paths.empty();
+    if (ok)
+    {
+        const image::LinePathBar &bar = res.bars[0];
+        ok = abs(bar.x1 - 60) <= 2 && abs(bar.x2 - 260) <= 2 && bar.y1 >= 100 && bar.y2 < 112 && res.paths[0].bar == 0;
+    }
+    if (!ok)
+        log::error("cross: %d paths, %d bars", (int)res.paths.size(), (int)res.bars.size());
+    errors += !ok;
+    log::info("cross: %d paths, %d bars, %d errors", (int)res.paths.size(), (int)res.bars.size(), errors);
+    return errors;
+}
+
+// 4 columns of 3 short segments, more paths than max_paths over the frame, slots of finished paths are reused
+static int test_segments()
+{
+    image::Image img(320, 240, image::FMT_GRAYSCALE);
+    memset(img.data(), 220, img.data_size());
+    for (int c = 0; c < 4; c++)
+        for (int seg = 0; seg < 3; seg++)
+            _fill_rect(img, 10 + c * 25, 20 + seg * 80, 18 + c * 25, 70 + seg * 80);
+    image::LinePathSearcher searcher(-1, false, 4, 2, 4, -1, 4);
+    int errors = 0;
+    for (int frame = 0; frame < 2; frame++)
+    {
+        const image::LinePathResult &res = searcher.update(img);
+        errors += _check_points(img, res, 2);
+        int full = 0;
+        for (auto &path : res.paths)
+            full += path.num_points == 12;
+        if (res.paths.size() != 12 || full != 12)
+        {
+            log::error("segments frame %d: %d paths, %d full", frame, (int)res.paths.size(), full);
+            ++errors;
+        }
+    }
+    log::info("segments: %d errors", errors);
+    return errors;
+}
+
+int _main(int argc, char *argv[])
+{
+    int errors = 0;
+    errors += test_line();
+    errors += test_cross();
+    errors += test_segments();
+    if (errors)
+    {
+        log::error("LinePathSearcher test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("LinePathSearcher test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
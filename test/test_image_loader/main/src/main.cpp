@@ -0,0 +1,306 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_image_jpeg.hpp"
+#include "maix_image_loader.hpp"
+#include "main.h"
+
+using namespace maix;
+
+static const char *_dir = "/tmp/test_image_loader";
+static const int _num = 12;
+
+static int _result(const std::string &name, bool ok)
+{
+    if (ok)
+        log::info("%s: ok", name.c_str());
+    else
+        log::error("%s: failed", name.c_str());
+    return ok ? 0 : 1;
+}
+
+static std::string _file_path(int i)
+{
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%s%03d.jpg", _dir, i % 4 == 0 ? "sub/" : "", i);
+    return path;
+}
+
+static std::vector<uint8_t> _read_file(const std::string &path)
+{
+    std::vector<uint8_t> data;
+    fs::File *f = fs::open(path, "rb");
+    if (!f)
+        return data;
+    data.resize(fs::getsize(path));
+    f->read(data.data(), data.size());
+    f->close();
+    delete f;
+    return data;
+}
+
+// smooth gradient jpeg files with different sizes, every 4th file in sub directory, and a broken one
+static void _create_files()
+{
+    fs::mkdir(std::string(_dir) + "/sub");
+    image::JpegEncoder encoder(90);
+    for (int i = 0; i < _num; i++)
+    {
+        int w = 320 + i * 8, h = 240 + i * 2;
+        image::Image img(w, h, image::FMT_RGB888);
+        uint8_t *p = (uint8_t *)img.data();
+        for (int y = 0; y < h; y++)
+        {
+            for (int x = 0; x < w; x++)
+            {
+                p[(y * w + x) * 3] = x * 255 / w;
+                p[(y * w + x) * 3 + 1] = y * 255 / h;
+                p[(y * w + x) * 3 + 2] = i * 20;
+            }
+        }
+        image::Image *jpg = encoder.encode(img);
+        fs::File *f = fs::open(_file_path(i), "wb");
+        f->write(jpg->data(), jpg->data_size());
+        f->close();
+        delete f;
+        delete jpg;
+    }
+    fs::File *f = fs::open(std::string(_dir) + "/zz_broken.jpg", "wb");
+    f->write("\xff\xd8garbage", 9);
+    f->close();
+    delete f;
+}
+
+static void _remove_files()
+{
+    for (int i = 0; i < _num; i++)
+        fs::remove(_file_path(i));
+    fs::remove(std::string(_dir) + "/zz_broken.jpg");
+    fs::rmdir(std::string(_dir) + "/sub");
+    fs::rmdir(_dir);
+}
+
+static bool _same(image::Image &a, image::Image &b)
+{
+    return a.width() == b.width() && a.height() == b.height() && a.format() == b.format() &&
+           memcmp(a.data(), b.data(), a.data_size()) == 0;
+}
+
+// max and mean abs difference
+static void _diff(image::Image &a, image::Image &b, int &max_diff, double &mean_diff)
+{
+    uint8_t *pa = (uint8_t *)a.data(), *pb = (uint8_t *)b.data();
+    max_diff = 0;
+    double sum = 0;
+    for (int i = 0; i < a.data_size(); i++)
+    {
+        int d = abs(pa[i] - pb[i]);
+        max_diff = std::max(max_diff, d);
+        sum += d;
+    }
+    mean_diff = sum / a.data_size();
+}
+
+// full size decode is the same as image::load(OpenCV imread) it replaced
+static int test_load()
+{
+    int errors = 0;
+    std::string path = _file_path(1);
+    std::vector<uint8_t> data = _read_file(path);
+    image::Format formats[] = {image::FMT_RGB888, image::FMT_BGR888, image::FMT_GRAYSCALE};
+    for (auto format : formats)
+    {
+        image::JpegDecoder decoder(format);
+        image::Image *decoded = decoder.decode(data.data(), data.size());
+        image::Image *loaded = image::load(path, format);
+        int max_diff = -1;
+        double mean_diff = 0;
+        if (decoded && loaded && decoded->width() == loaded->width() && decoded->height() == loaded->height() && decoded->format() == loaded->format())
+            _diff(*decoded, *loaded, max_diff, mean_diff);
+        errors += _result(std::string("decode vs image::load ") + image::fmt_names[format] + " max diff " + std::to_string(max_diff),
+                          max_diff >= 0 && max_diff <= 2 && mean_diff < 0.5);
+        delete decoded;
+        delete loaded;
+    }
+    return errors;
+}
+
+// output formats are the same pixels in different order
+static int test_formats()
+{
+    std::vector<uint8_t> data = _read_file(_file_path(2));
+    image::JpegDecoder rgb_decoder(image::FMT_RGB888);
+    image::Image *rgb = rgb_decoder.decode(data.data(), data.size());
+    bool ok = rgb != nullptr;
+    image::Format formats[] = {image::FMT_BGR888, image::FMT_RGBA8888, image::FMT_BGRA8888};
+    for (auto format : formats)
+    {
+        image::JpegDecoder decoder(format);
+        image::Image *img = decoder.decode(data.data(), data.size());
+        int bpp = (int)image::fmt_size[format];
+        bool bgr = format == image::FMT_BGR888 || format == image::FMT_BGRA8888;
+        uint8_t *p = (uint8_t *)img->data(), *q = (uint8_t *)rgb->data();
+        for (int i = 0; i < rgb->width() * rgb->height() && ok; i++)
+        {
+            ok = p[i * bpp + (bgr ? 2 : 0)] == q[i * 3] && p[i * bpp + 1] == q[i * 3 + 1] && p[i * bpp + (bgr ? 0 : 2)] == q[i * 3 + 2] &&
+                 (bpp == 3 || p[i * bpp + 3] == 255);
+        }
+        delete img;
+    }
+    delete rgb;
+    return _result("decode formats", ok);
+}
+
+// DCT domain downscale is close to full decode then area average
+static int test_scale()
+{
+    int errors = 0;
+    std::vector<uint8_t> data = _read_file(_file_path(3));
+    image::JpegDecoder full_decoder(image::FMT_RGB888);
+    image::Image *full = full_decoder.decode(data.data(), data.size());
+    for (int scale : {2, 4, 8})
+    {
+        image::JpegDecoder decoder(image::FMT_RGB888, scale);
+        image::Image *img = decoder.decode(data.data(), data.size());
+        bool size_ok = img->width() == (full->width() + scale - 1) / scale && img->height() == (full->height() + scale - 1) / scale;
+        uint8_t *p = (uint8_t *)img->data(), *q = (uint8_t *)full->data();
+        double sum = 0;
+        int count = 0;
+        for (int y = 0; y < full->height() / scale; y++)
+        {
+            for (int x = 0; x < full->width() / scale; x++)
+            {
+                for (int c = 0; c < 3; c++)
+                {
+                    int avg = 0;
+                    for (int j = 0; j < scale; j++)
+                        for (int i = 0; i < scale; i++)
+                            avg += q[((y * scale + j) * full->width() + x * scale + i) * 3 + c];
+                    avg = (avg + scale * scale / 2) / (scale * scale);
+                    sum += abs(avg - p[(y * img->width() + x) * 3 + c]);
+                    count++;
+                }
+            }
+        }
+        errors += _result("scale " + std::to_string(scale) + " mean diff " + std::to_string(sum / count), size_ok && sum / count < 2);
+        delete img;
+    }
+    delete full;
+    return errors;
+}
+
+// decode into caller buffer, error cases
+static int test_buffer()
+{
+    std::vector<uint8_t> data = _read_file(_file_path(1));
+    image::JpegDecoder decoder(image::FMT_RGB888, 2);
+    image::Image *ref = decoder.decode(data.data(), data.size());
+    std::vector<uint8_t> buff(ref->data_size());
+    image::Image *img = decoder.decode(data.data(), data.size(), buff.data(), buff.size());
+    bool ok = img->data() == buff.data() && _same(*img, *ref);
+    delete img;
+    bool thrown = false;
+    try
+    {
+        decoder.decode(data.data(), data.size(), buff.data(), 10);
+    }
+    catch (err::Exception &e)
+    {
+        thrown = true;
+    }
+    bool broken = decoder.decode((const uint8_t *)"\xff\xd8xx", 4) == nullptr;
+    // decoder is still usable after error
+    img = decoder.decode(data.data(), data.size());
+    ok = ok && thrown && broken && img && _same(*img, *ref);
+    delete img;
+    delete ref;
+    return _result("decode buffer", ok);
+}
+
+// loader returns the same images as decoding files one by one in sorted order, broken file skipped
+static int test_loader()
+{
+    int errors = 0;
+    for (int threads : {1, 4})
+    {
+        for (int recursive = 0; recursive < 2; recursive++)
+        {
+            std::vector<std::string> expected;
+            for (int i = 0; i < _num; i++)
+                if (recursive || i % 4 != 0)
+                    expected.push_back(_file_path(i));
+            std::sort(expected.begin(), expected.end());
+
+            image::Loader loader(image::FMT_RGB888, 2, threads, 3);
+            loader.open(_dir, recursive);
+            image::JpegDecoder decoder(image::FMT_RGB888, 2);
+            bool ok = (int)loader.files().size() == (int)expected.size() + 1;
+            size_t n = 0;
+            image::Image *img;
+            while ((img = loader.next()))
+            {
+                if (n < expected.size())
+                {
+                    std::vector<uint8_t> data = _read_file(expected[n]);
+                    image::Image *ref = decoder.decode(data.data(), data.size());
+                    ok = ok && loader.path() == expected[n] && _same(*img, *ref);
+                    delete ref;
+                }
+                n++;
+                delete img;
+            }
+            ok = ok && n == expected.size() && loader.remain() == 0;
+            errors += _result("loader threads " + std::to_string(threads) + (recursive ? " recursive" : ""), ok);
+        }
+    }
+
+    // reopen drops pending files, load does not affect file list
+    image::Loader loader(image::FMT_GRAYSCALE, 1, 2, 4);
+    loader.open(_dir);
+    delete loader.next();
+    loader.open(std::string(_dir) + "/sub");
+    image::Image *one = loader.load(_file_path(5));
+    image::JpegDecoder decoder(image::FMT_GRAYSCALE);
+    std::vector<uint8_t> data = _read_file(_file_path(5));
+    image::Image *ref = decoder.decode(data.data(), data.size());
+    int n = 0;
+    image::Image *img;
+    while ((img = loader.next()))
+    {
+        n++;
+        delete img;
+    }
+    errors += _result("loader reopen and load", n == (_num + 3) / 4 && one && _same(*one, *ref));
+    delete one;
+    delete ref;
+    return errors;
+}
+
+int _main(int argc, char *argv[])
+{
+    int errors = 0;
+    _create_files();
+    errors += test_load();
+    errors += test_formats();
+    errors += test_scale();
+    errors += test_buffer();
+    errors += test_loader();
+    _remove_files();
+    if (errors)
+    {
+        log::error("Image loader test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("Image loader test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,331 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_image_orb.hpp"
+#include "main.h"
+#include <math.h>
+#include <random>
+
+using namespace maix;
+
+static int _result(const std::string &name, bool ok)
+{
+    if (ok)
+        log::info("%s: ok", name.c_str());
+    else
+        log::error("%s: failed", name.c_str());
+    return ok ? 0 : 1;
+}
+
+// bit by bit hamming distance
+static int _distance_ref(const uint8_t *a, const uint8_t *b)
+{
+    int d = 0;
+    for (int i = 0; i < image::ORBFeatures::DESC_SIZE; i++)
+        for (int bit = 0; bit < 8; bit++)
+            d += ((a[i] ^ b[i]) >> bit) & 1;
+    return d;
+}
+
+static void _best2_ref(const uint8_t *q, image::ORBFeatures &train, int &best_idx, int &best, int &second)
+{
+    best_idx = -1;
+    best = second = 257;
+    for (int j = 0; j < train.size(); j++)
+    {
+        int d = _distance_ref(q, train.descriptors() + j * image::ORBFeatures::DESC_SIZE);
+        if (d < best)
+        {
+            second = best;
+            best = d;
+            best_idx = j;
+        }
+        else if (d < second)
+        {
+            second = d;
+        }
+    }
+}
+
+static bool _accept_ref(int best, int second, int max_distance, float ratio)
+{
+    return best <= max_distance && (ratio >= 1 || second > 256 || best < ratio * second);
+}
+
+// brute force matching, the same result format as ORB.match
+static std::vector<int> _match_ref(image::ORBFeatures &query, image::ORBFeatures &train, int max_distance, float ratio, bool cross_check)
+{
+    std::vector<int> result;
+    for (int i = 0; i < query.size(); i++)
+    {
+        int j, best, second;
+        _best2_ref(query.descriptors() + i * image::ORBFeatures::DESC_SIZE, train, j, best, second);
+        if (j < 0 || !_accept_ref(best, second, max_distance, ratio))
+            continue;
+        if (cross_check)
+        {
+            int back, back_best, back_second;
+            _best2_ref(train.descriptors() + j * image::ORBFeatures::DESC_SIZE, query, back, back_best, back_second);
+            if (back != i)
+                continue;
+        }
+        result.push_back(i);
+        result.push_back(j);
+        result.push_back(best);
+    }
+    return result;
+}
+
+// random descriptors, and query descriptors copied from train with some bits flipped
+static void _random_features(std::mt19937 &gen, int n, image::ORBFeatures &features)
+{
+    uint8_t desc[image::ORBFeatures::DESC_SIZE];
+    for (int i = 0; i < n; i++)
+    {
+        float kp[5] = {(float)(gen() % 640), (float)(gen() % 480), (float)(gen() % 360), 0, 1};
+        for (auto &b : desc)
+            b = gen() & 0xff;
+        features.add(kp, desc);
+    }
+}
+
+static void _noisy_copy(std::mt19937 &gen, image::ORBFeatures &src, int idx, int flip_bits, image::ORBFeatures &dst)
+{
+    std::vector<uint8_t> desc = src.descriptor(idx);
+    for (int k = 0; k < flip_bits; k++)
+    {
+        int bit = gen() % 256;
+        desc[bit / 8] ^= 1 << (bit % 8);
+    }
+    std::vector<float> kp = src.keypoint(idx);
+    dst.add(kp.data(), desc.data());
+}
+
+static int test_match()
+{
+    int errors = 0;
+    std::mt19937 gen(1);
+    image::ORBFeatures train, query;
+    _random_features(gen, 500, train);
+    for (int i = 0; i < 300; i++)
+        _noisy_copy(gen, train, gen() % train.size(), gen() % 60, query);
+    _random_features(gen, 100, query);
+
+    bool distance_ok = true;
+    for (int i = 0; i < query.size() && distance_ok; i++)
+        for (int j = 0; j < train.size() && distance_ok; j++)
+        {
+            const uint8_t *a = query.descriptors() + i * image::ORBFeatures::DESC_SIZE;
+            const uint8_t *b = train.descriptors() + j * image::ORBFeatures::DESC_SIZE;
+            distance_ok = image::ORB::distance(a, b) == _distance_ref(a, b);
+        }
+    errors += _result("distance", distance_ok);
+
+    struct
+    {
+        int max_distance;
+        float ratio;
+        bool cross_check;
+    } cases[] = {{64, 0.8f, false}, {64, 0.8f, true}, {40, 1, false}, {256, 0.6f, true}, {0, 1, false}};
+    for (auto &c : cases)
+    {
+        std::vector<int> m = image::ORB::match(query, train, c.max_distance, c.ratio, c.cross_check);
+        std::vector<int> ref = _match_ref(query, train, c.max_distance, c.ratio, c.cross_check);
+        char name[96];
+        snprintf(name, sizeof(name), "match max_distance %d ratio %.1f cross_check %d: %d matches", c.max_distance, c.ratio, c.cross_check, (int)ref.size() / 3);
+        errors += _result(name, m == ref);
+    }
+    return errors;
+}
+
+// index of few descriptors uses brute force, the same as matching concatenation of all objects
+static int test_index_brute()
+{
+    std::mt19937 gen(2);
+    image::ORBIndex index;
+    image::ORBFeatures all, query;
+    std::vector<int> owner, kp;
+    for (int o = 0; o < 10; o++)
+    {
+        image::ORBFeatures features;
+        _random_features(gen, 50, features);
+        index.add(features);
+        for (int i = 0; i < features.size(); i++)
+        {
+            std::vector<float> k = features.keypoint(i);
+            all.add(k.data(), features.descriptor(i).data());
+            owner.push_back(o);
+            kp.push_back(i);
+        }
+    }
+    for (int i = 0; i < 200; i++)
+        _noisy_copy(gen, all, i % 3 == 0 ? gen() % 50 : gen() % all.size(), gen() % 50, query);
+
+    std::map<int, std::vector<int>> result = index.query(query, 64, 0.8f, 3);
+    std::vector<int> m = _match_ref(query, all, 64, 0.8f, false);
+    std::map<int, std::vector<int>> ref;
+    for (size_t i = 0; i < m.size(); i += 3)
+    {
+        std::vector<int> &v = ref[owner[m[i + 1]]];
+        v.push_back(m[i]);
+        v.push_back(kp[m[i + 1]]);
+        v.push_back(m[i + 2]);
+    }
+    for (auto it = ref.begin(); it != ref.end();)
+        it = it->second.size() / 3 < 3 ? ref.erase(it) : std::next(it);
+    bool ok = result == ref && index.size() == 10 && index.count() == 500 && index.get(3).size() == 50;
+    return _result("index brute force, objects " + std::to_string(ref.size()), ok);
+}
+
+// hashed index finds every match brute force finds within guaranteed distance
+static int test_index_hash()
+{
+    int errors = 0;
+    std::mt19937 gen(3);
+    image::ORBFeatures all;
+    std::vector<image::ORBFeatures> objects(40);
+    for (auto &features : objects)
+    {
+        _random_features(gen, 50, features);
+        for (int i = 0; i < features.size(); i++)
+            all.add(features.keypoint(i).data(), features.descriptor(i).data());
+    }
+    for (int multi_probe = 0; multi_probe < 2; multi_probe++)
+    {
+        image::ORBIndex index(multi_probe);
+        for (auto &features : objects)
+            index.add(features);
+        // pigeonhole: 16 substrings, distance <= 15 has one same substring, <= 31 has one substring at most 1 bit different
+        int guarantee = multi_probe ? 31 : 15;
+        image::ORBFeatures query;
+        for (int i = 0; i < 300; i++)
+            _noisy_copy(gen, all, gen() % all.size(), gen() % (guarantee + 1), query);
+        std::map<int, std::vector<int>> result = index.query(query, 64, 0.8f, 1);
+        std::vector<int> m = _match_ref(query, all, 64, 0.8f, false);
+        bool ok = true;
+        int found = 0;
+        for (size_t i = 0; i < m.size(); i += 3)
+        {
+            int o = m[i + 1] / 50;
+            auto it = result.find(o);
+            bool hit = false;
+            for (size_t k = 0; it != result.end() && k < it->second.size(); k += 3)
+                hit = hit || (it->second[k] == m[i] && it->second[k + 1] == m[i + 1] % 50 && it->second[k + 2] == m[i + 2]);
+            ok = ok && hit;
+            found += hit;
+        }
+        errors += _result(std::string(multi_probe ? "index multi probe" : "index") + " recall " + std::to_string(found) + "/" + std::to_string(m.size() / 3), ok && found > 0);
+    }
+    return errors;
+}
+
+// blobs scene, rotated and scaled copy
+static void _scene(uint8_t *p, int w, int h)
+{
+    std::mt19937 gen(4);
+    std::vector<float> f(w * h, 100);
+    for (int k = 0; k < 400; k++)
+    {
+        int cx = gen() % w, cy = gen() % h, r = 3 + gen() % 15, v = (int)(gen() % 200) - 100;
+        bool circle = gen() % 2;
+        for (int y = std::max(0, cy - r); y < std::min(h, cy + r); y++)
+            for (int x = std::max(0, cx - r); x < std::min(w, cx + r); x++)
+                if (!circle || (x - cx) * (x - cx) + (y - cy) * (y - cy) <= r * r)
+                    f[y * w + x] += v * 0.5f;
+    }
+    for (int i = 0; i < w * h; i++)
+        p[i] = (uint8_t)std::max(0.f, std::min(255.f, f[i]));
+}
+
+static int test_detect()
+{
+    int errors = 0;
+    const int w = 640, h = 480;
+    const double angle = 25 * M_PI / 180, scale = 1.15, cx = w / 2.0, cy = h / 2.0;
+    image::Image a(w, h, image::FMT_GRAYSCALE), b(w, h, image::FMT_GRAYSCALE);
+    uint8_t *pa = (uint8_t *)a.data(), *pb = (uint8_t *)b.data();
+    _scene(pa, w, h);
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            double dx = x - cx, dy = y - cy;
+            double u = (cos(angle) * dx + sin(angle) * dy) / scale + cx, v = (-sin(angle) * dx + cos(angle) * dy) / scale + cy;
+            int x0 = (int)floor(u), y0 = (int)floor(v);
+            double fx = u - x0, fy = v - y0;
+            if (x0 < 0 || y0 < 0 || x0 >= w - 1 || y0 >= h - 1)
+            {
+                pb[y * w + x] = 100;
+                continue;
+            }
+            pb[y * w + x] = (uint8_t)lround(pa[y0 * w + x0] * (1 - fx) * (1 - fy) + pa[y0 * w + x0 + 1] * fx * (1 - fy) +
+                                            pa[(y0 + 1) * w + x0] * (1 - fx) * fy + pa[(y0 + 1) * w + x0 + 1] * fx * fy);
+        }
+    }
+    image::ORB orb(500, 20, 4, 1.2f, 8);
+    image::ORBFeatures fa = orb.detect(a);
+    image::ORBFeatures fb = orb.detect(b);
+    std::vector<int> m = image::ORB::match(fa, fb, 64, 0.8f, true);
+    int good = 0, n = (int)m.size() / 3;
+    for (int i = 0; i < n; i++)
+    {
+        std::vector<float> ka = fa.keypoint(m[i * 3]), kb = fb.keypoint(m[i * 3 + 1]);
+        double dx = ka[0] - cx, dy = ka[1] - cy;
+        double ex = scale * (cos(angle) * dx - sin(angle) * dy) + cx, ey = scale * (sin(angle) * dx + cos(angle) * dy) + cy;
+        good += hypot(ex - kb[0], ey - kb[1]) < 4;
+    }
+    errors += _result("detect rotated scene, keypoints " + std::to_string(fa.size()) + ", matches " + std::to_string(n) + ", good " + std::to_string(good),
+                      fa.size() > 100 && fa.size() <= 500 && n >= 30 && good >= n * 0.8);
+
+    // roi keypoints are in image coordinates, and the same as detect on cropped image moved by roi offset
+    std::vector<int> roi = {100, 80, 320, 240};
+    image::ORBFeatures fr = orb.detect(a, roi);
+    bool inside = fr.size() > 0;
+    for (int i = 0; i < fr.size(); i++)
+    {
+        std::vector<float> k = fr.keypoint(i);
+        inside = inside && k[0] >= roi[0] && k[1] >= roi[1] && k[0] < roi[0] + roi[2] && k[1] < roi[1] + roi[3];
+    }
+    image::Image *crop = a.crop(roi[0], roi[1], roi[2], roi[3]);
+    image::ORBFeatures fc = orb.detect(*crop);
+    bool same = fc.size() == fr.size();
+    for (int i = 0; i < fc.size() && same; i++)
+    {
+        std::vector<float> kc = fc.keypoint(i), kr = fr.keypoint(i);
+        same = fabsf(kc[0] + roi[0] - kr[0]) < 1e-3f && fabsf(kc[1] + roi[1] - kr[1]) < 1e-3f && fc.descriptor(i) == fr.descriptor(i);
+    }
+    delete crop;
+    errors += _result("detect roi", inside && same);
+
+    // flat image has no keypoint
+    image::Image flat(w, h, image::FMT_RGB888);
+    memset(flat.data(), 50, flat.data_size());
+    errors += _result("detect flat", orb.detect(flat).size() == 0);
+    return errors;
+}
+
+int _main(int argc, char *argv[])
+{
+    int errors = 0;
+    errors += test_match();
+    errors += test_index_brute();
+    errors += test_index_hash();
+    errors += test_detect();
+    if (errors)
+    {
+        log::error("Image ORB test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("Image ORB test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,151 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "main.h"
+
+using namespace maix;
+
+static void _fill(image::Image &img, int seed)
+{
+    uint8_t *p = (uint8_t *)img.data();
+    for (int i = 0; i < img.data_size(); i++)
+        p[i] = (i * 7 + seed * 31 + i / 97) & 0xff;
+}
+
+static int _result(const char *name, bool ok)
+{
+    if (ok)
+        log::info("%s: same", name);
+    else
+        log::error("%s: different", name);
+    return ok ? 0 : 1;
+}
+
+// row and const_row read the same values as get_pixel, image is a view to test stride
+static int test_row()
+{
+    image::Image img(97, 61, image::FMT_RGB888);
+    _fill(img, 1);
+    image::Image *view = img.view(5, 3, 80, 50);
+    bool ok = true;
+    for (int y = 0; y < view->height() && ok; y++)
+    {
+        const image::PixelRGB888 *row = view->const_row<image::FMT_RGB888>(y);
+        for (int x = 0; x < view->width() && ok; x++)
+        {
+            std::vector<uint32_t> p = view->get_pixel(x, y, true);
+            ok = p[0] == row[x].r && p[1] == row[x].g && p[2] == row[x].b;
+        }
+    }
+    bool thrown = false;
+    try
+    {
+        view->row<image::FMT_GRAYSCALE>(0);
+    }
+    catch (err::Exception &e)
+    {
+        thrown = true;
+    }
+    delete view;
+    return _result("row", ok && thrown);
+}
+
+// for_each_pixel gets the same result as set_pixel of every pixel
+static int test_for_each_pixel()
+{
+    int errors = 0;
+    for (bool parallel : {false, true})
+    {
+        image::Image img(320, 240, image::FMT_BGRA8888);
+        _fill(img, 2);
+        image::Image *ref = img.copy();
+        img.for_each_pixel<image::FMT_BGRA8888>([](int x, int y, image::PixelBGRA8888 &p)
+                                                { p.r = 255 - p.r; p.g = x; p.b = y; }, parallel);
+        for (int y = 0; y < ref->height(); y++)
+        {
+            for (int x = 0; x < ref->width(); x++)
+            {
+                std::vector<uint32_t> p = ref->get_pixel(x, y, true);
+                // BGRA8888 rgbtuple order is b, g, r, a
+                ref->set_pixel(x, y, {(uint32_t)(y & 0xff), (uint32_t)(x & 0xff), 255 - p[2]});
+                ((uint8_t *)ref->data())[(y * ref->width() + x) * 4 + 3] = p[3];
+            }
+        }
+        errors += _result(parallel ? "for_each_pixel parallel" : "for_each_pixel", memcmp(img.data(), ref->data(), img.data_size()) == 0);
+        delete ref;
+    }
+    return errors;
+}
+
+// get_pixels and set_pixels of roi are the same as get_pixel and set_pixel of every pixel in roi
+static int test_bulk(image::Format format)
+{
+    int errors = 0;
+    int bpp = (int)image::fmt_size[format];
+    image::Image img(160, 120, format);
+    _fill(img, 3);
+    image::Image *view = img.view(10, 20, 100, 80);
+    std::vector<int> roi = {7, 9, 33, 21};
+    Bytes *pixels = view->get_pixels(roi);
+    bool ok = pixels->data_len == (size_t)(roi[2] * roi[3] * bpp);
+    for (int y = 0; y < roi[3] && ok; y++)
+    {
+        for (int x = 0; x < roi[2] && ok; x++)
+        {
+            std::vector<uint32_t> p = view->get_pixel(roi[0] + x, roi[1] + y, true);
+            for (size_t c = 0; c < p.size() && ok; c++)
+                ok = p[c] == pixels->data[(y * roi[2] + x) * bpp + c];
+        }
+    }
+    errors += _result((image::fmt_names[format] + " get_pixels").c_str(), ok);
+
+    std::vector<uint8_t> data(roi[2] * roi[3] * bpp);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = i * 13;
+    image::Image *ref = img.copy();
+    ok = view->set_pixels(roi, data.data(), data.size()) == err::ERR_NONE;
+    for (int y = 0; y < roi[3]; y++)
+    {
+        for (int x = 0; x < roi[2]; x++)
+        {
+            const uint8_t *p = data.data() + (y * roi[2] + x) * bpp;
+            std::vector<uint32_t> pixel(p, p + std::min(bpp, 3));
+            ref->set_pixel(10 + roi[0] + x, 20 + roi[1] + y, pixel);
+        }
+    }
+    ok = ok && memcmp(img.data(), ref->data(), img.data_size()) == 0;
+    // out of image and wrong size
+    ok = ok && view->set_pixels({90, 70, 20, 20}, data.data(), data.size()) == err::ERR_ARGS &&
+         view->set_pixels(roi, data.data(), data.size() - 1) == err::ERR_ARGS;
+    errors += _result((image::fmt_names[format] + " set_pixels").c_str(), ok);
+    delete ref;
+    delete pixels;
+    delete view;
+    return errors;
+}
+
+int _main(int argc, char *argv[])
+{
+    int errors = 0;
+    errors += test_row();
+    errors += test_for_each_pixel();
+    errors += test_bulk(image::FMT_RGB888);
+    errors += test_bulk(image::FMT_GRAYSCALE);
+    if (errors)
+    {
+        log::error("Image pixels access test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("Image pixels access test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
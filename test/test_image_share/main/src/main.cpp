@@ -0,0 +1,127 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "main.h"
+
+using namespace maix;
+
+static void _fill(image::Image &img, int seed)
+{
+    uint8_t *p = (uint8_t *)img.data();
+    for (int i = 0; i < img.data_size(); i++)
+        p[i] = (i * 7 + seed * 31 + i / 97) & 0xff;
+}
+
+static bool _same(image::Image &a, image::Image &b)
+{
+    if (a.width() != b.width() || a.height() != b.height() || a.format() != b.format())
+        return false;
+    int row_bytes = a.width() * (int)image::fmt_size[a.format()];
+    for (int y = 0; y < a.height(); y++)
+    {
+        if (memcmp((uint8_t *)a.data() + y * a.stride(), (uint8_t *)b.data() + y * b.stride(), row_bytes))
+            return false;
+    }
+    return true;
+}
+
+static int _result(const char *name, bool ok)
+{
+    if (ok)
+        log::info("%s: ok", name);
+    else
+        log::error("%s: failed", name);
+    return ok ? 0 : 1;
+}
+
+// shared image is copied when modified, the result is the same as modify a copy, other owners not changed
+static int test_modify()
+{
+    int errors = 0;
+    image::Image img(320, 240, image::FMT_RGB888);
+    _fill(img, 1);
+    image::Image *origin = img.copy();
+    image::Image *shared = img.share();
+    image::Image assigned;
+    assigned = img;
+    errors += _result("share without copy", shared->data() == img.data() && assigned.data() == img.data() && img.is_shared());
+
+    image::Image *copied = img.copy();
+    shared->draw_rect(10, 10, 50, 40, image::COLOR_GREEN, 3);
+    copied->draw_rect(10, 10, 50, 40, image::COLOR_GREEN, 3);
+    errors += _result("draw_rect of shared", shared->data() != img.data() && _same(*shared, *copied) && _same(img, *origin));
+
+    image::Image other(320, 240, image::FMT_RGB888);
+    _fill(other, 2);
+    assigned.b_xor(&other);
+    delete copied;
+    copied = img.copy();
+    copied->b_xor(&other);
+    errors += _result("b_xor of assigned", assigned.data() != img.data() && _same(assigned, *copied) && _same(img, *origin));
+
+    // the last owner writes in place
+    void *data = img.data();
+    img.set_pixel(1, 1, {1, 2, 3});
+    errors += _result("last owner in place", !img.is_shared() && img.data() == data && img.get_pixel(1, 1, true)[0] == 1);
+
+    // buffer is alive after the first owner deleted
+    image::Image *a = new image::Image(64, 64, image::FMT_GRAYSCALE);
+    _fill(*a, 3);
+    image::Image *b = a->share();
+    image::Image *ref = a->copy();
+    delete a;
+    errors += _result("owner deleted", !b->is_shared() && _same(*b, *ref));
+    delete b;
+    delete ref;
+    delete copied;
+    delete shared;
+    delete origin;
+    return errors;
+}
+
+// buffer with views is pinned, share copies it so views never write to other owners
+static int test_view()
+{
+    int errors = 0;
+    image::Image img(64, 64, image::FMT_RGB888);
+    _fill(img, 4);
+    image::Image *shared = img.share();
+    image::Image *view = img.view(8, 8, 16, 16);
+    errors += _result("view detach shared", !img.is_shared() && img.data() != shared->data());
+    view->set_pixel(0, 0, {7, 7, 7});
+    errors += _result("view write parent", img.get_pixel(8, 8, true)[0] == 7 && shared->get_pixel(8, 8, true)[0] != 7);
+    image::Image *shared2 = img.share();
+    view->set_pixel(0, 0, {9, 9, 9});
+    errors += _result("share pinned copy", shared2->data() != img.data() && shared2->get_pixel(8, 8, true)[0] == 7 && img.get_pixel(8, 8, true)[0] == 9);
+    delete view;
+    image::Image *shared3 = img.share();
+    errors += _result("share after view deleted", shared3->data() == img.data());
+    delete shared3;
+    delete shared2;
+    delete shared;
+    return errors;
+}
+
+int _main(int argc, char *argv[])
+{
+    int errors = 0;
+    errors += test_modify();
+    errors += test_view();
+    if (errors)
+    {
+        log::error("Image share test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("Image share test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,161 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "main.h"
+
+using namespace maix;
+
+static void _fill(image::Image &img, int seed)
+{
+    uint8_t *p = (uint8_t *)img.data();
+    for (int i = 0; i < img.data_size(); i++)
+        p[i] = (i * 7 + seed * 31 + i / 97) & 0xff;
+}
+
+// compare pixels row by row, images can have different stride
+static bool _same(image::Image &a, image::Image &b)
+{
+    if (a.width() != b.width() || a.height() != b.height() || a.format() != b.format())
+        return false;
+    int row_bytes = a.width() * (int)image::fmt_size[a.format()];
+    for (int y = 0; y < a.height(); y++)
+    {
+        if (memcmp((uint8_t *)a.data() + y * a.stride(), (uint8_t *)b.data() + y * b.stride(), row_bytes))
+            return false;
+    }
+    return true;
+}
+
+// pixels of img outside rect are the same as ref
+static bool _same_outside(image::Image &img, image::Image &ref, int x, int y, int w, int h)
+{
+    int bpp = (int)image::fmt_size[img.format()];
+    for (int j = 0; j < img.height(); j++)
+    {
+        uint8_t *a = (uint8_t *)img.data() + j * img.stride();
+        uint8_t *b = (uint8_t *)ref.data() + j * ref.stride();
+        if (j < y || j >= y + h)
+        {
+            if (memcmp(a, b, img.width() * bpp))
+                return false;
+            continue;
+        }
+        if (memcmp(a, b, x * bpp) || memcmp(a + (x + w) * bpp, b + (x + w) * bpp, (img.width() - x - w) * bpp))
+            return false;
+    }
+    return true;
+}
+
+static int _result(const char *name, bool ok)
+{
+    if (ok)
+        log::info("%s: same", name);
+    else
+        log::error("%s: different", name);
+    return ok ? 0 : 1;
+}
+
+// operations create new image, view and crop get the same result
+static int test_new_image(image::Format format)
+{
+    const int x = 13, y = 7, w = 101, h = 53;
+    image::Image img(320, 240, format);
+    _fill(img, 1);
+    image::Image *view = img.view(x, y, w, h);
+    image::Image *crop = img.crop(x, y, w, h);
+    int errors = 0;
+    errors += _result("view pixels", !view->is_contiguous() && view->data() == (uint8_t *)img.data() + y * img.stride() + x * (int)image::fmt_size[format] && _same(*view, *crop));
+    image::Image *a = view->copy();
+    errors += _result("copy", a->is_contiguous() && _same(*a, *crop));
+    delete a;
+    errors += _result("contiguous_data", memcmp(view->contiguous_data(), crop->data(), crop->data_size()) == 0);
+    a = view->crop(3, 5, 40, 20);
+    image::Image *b = crop->crop(3, 5, 40, 20);
+    errors += _result("crop", _same(*a, *b));
+    delete a;
+    delete b;
+    a = view->resize(64, 37, image::FIT_FILL, image::ResizeMethod::BILINEAR);
+    b = crop->resize(64, 37, image::FIT_FILL, image::ResizeMethod::BILINEAR);
+    errors += _result("resize", _same(*a, *b));
+    delete a;
+    delete b;
+    image::Format dst_format = format == image::FMT_GRAYSCALE ? image::FMT_RGB888 : image::FMT_GRAYSCALE;
+    a = view->to_format(dst_format);
+    b = crop->to_format(dst_format);
+    errors += _result("to_format", _same(*a, *b));
+    delete a;
+    delete b;
+    delete view;
+    delete crop;
+    return errors;
+}
+
+// in place operations of view write to the region of parent image, the same as operate a crop
+static int test_in_place(image::Format format)
+{
+    const int x = 21, y = 11, w = 77, h = 45;
+    image::Image img(320, 240, format);
+    _fill(img, 2);
+    image::Image *origin = img.copy();
+    image::Image other(w, h, format);
+    _fill(other, 3);
+    image::Image *view = img.view(x, y, w, h);
+    image::Image *crop = img.crop(x, y, w, h);
+    int errors = 0;
+
+    view->draw_rect(5, 6, 30, 20, image::COLOR_RED, 2);
+    crop->draw_rect(5, 6, 30, 20, image::COLOR_RED, 2);
+    errors += _result("draw_rect", _same(*view, *crop));
+    view->b_xor(&other);
+    crop->b_xor(&other);
+    errors += _result("b_xor", _same(*view, *crop));
+    // imlib operations work on packed rows and write back
+    view->gaussian(1);
+    crop->gaussian(1);
+    errors += _result("gaussian", _same(*view, *crop));
+    view->flip(image::FlipDir::X);
+    crop->flip(image::FlipDir::X);
+    errors += _result("flip", _same(*view, *crop));
+    // modify packed data and write back
+    uint8_t *p = (uint8_t *)view->contiguous_data();
+    for (int i = 0; i < crop->data_size(); i++)
+        p[i] = ~p[i];
+    view->sync_contiguous_data();
+    p = (uint8_t *)crop->data();
+    for (int i = 0; i < crop->data_size(); i++)
+        p[i] = ~p[i];
+    errors += _result("sync_contiguous_data", _same(*view, *crop));
+    errors += _result("outside view", _same_outside(img, *origin, x, y, w, h));
+    delete view;
+    delete crop;
+    delete origin;
+    return errors;
+}
+
+int _main(int argc, char *argv[])
+{
+    int errors = 0;
+    for (auto format : {image::FMT_RGB888, image::FMT_GRAYSCALE})
+    {
+        log::info("format %s", image::fmt_names[format].c_str());
+        errors += test_new_image(format);
+        errors += test_in_place(format);
+    }
+    if (errors)
+    {
+        log::error("Image view test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("Image view test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
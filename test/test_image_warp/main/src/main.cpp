@@ -0,0 +1,315 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_image_warp.hpp"
+#include "main.h"
+#include <math.h>
+
+using namespace maix;
+
+static int _result(const std::string &name, bool ok)
+{
+    if (ok)
+        log::info("%s: ok", name.c_str());
+    else
+        log::error("%s: failed", name.c_str());
+    return ok ? 0 : 1;
+}
+
+static int _channels(image::Format format)
+{
+    if (format == image::FMT_GRAYSCALE || format == image::FMT_YVU420SP)
+        return 1;
+    return (int)image::fmt_size[format];
+}
+
+// smooth content, so small sub pixel differences only make small value differences
+static image::Image *_smooth_image(int w, int h, image::Format format)
+{
+    image::Image *img = new image::Image(w, h, format);
+    uint8_t *p = (uint8_t *)img->data();
+    int ch = _channels(format);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w * ch; x++)
+            p[y * img->stride() + x] = (uint8_t)(128 + 100 * sin((x / ch) * 0.05 + (x % ch)) * cos(y * 0.07));
+    if (format == image::FMT_YVU420SP)
+    {
+        uint8_t *uv = p + w * h;
+        for (int y = 0; y < h / 2; y++)
+            for (int x = 0; x < w; x++)
+                uv[y * w + x] = (uint8_t)(128 + 60 * cos(x * 0.04 + (x & 1)) * sin(y * 0.09));
+    }
+    return img;
+}
+
+static void _invert(const std::vector<float> &matrix, double *inv)
+{
+    double m[9] = {0, 0, 0, 0, 0, 0, 0, 0, 1};
+    for (size_t i = 0; i < matrix.size(); i++)
+        m[i] = matrix[i];
+    double det = m[0] * (m[4] * m[8] - m[5] * m[7]) - m[1] * (m[3] * m[8] - m[5] * m[6]) + m[2] * (m[3] * m[7] - m[4] * m[6]);
+    inv[0] = (m[4] * m[8] - m[5] * m[7]) / det;
+    inv[1] = (m[2] * m[7] - m[1] * m[8]) / det;
+    inv[2] = (m[1] * m[5] - m[2] * m[4]) / det;
+    inv[3] = (m[5] * m[6] - m[3] * m[8]) / det;
+    inv[4] = (m[0] * m[8] - m[2] * m[6]) / det;
+    inv[5] = (m[2] * m[3] - m[0] * m[5]) / det;
+    inv[6] = (m[3] * m[7] - m[4] * m[6]) / det;
+    inv[7] = (m[1] * m[6] - m[0] * m[7]) / det;
+    inv[8] = (m[0] * m[4] - m[1] * m[3]) / det;
+}
+
+static void _map(const double *inv, double x, double y, double &sx, double &sy)
+{
+    double w = inv[6] * x + inv[7] * y + inv[8];
+    sx = (inv[0] * x + inv[1] * y + inv[2]) / w;
+    sy = (inv[3] * x + inv[4] * y + inv[5]) / w;
+}
+
+// double precision bilinear, only for points inside of source
+static int _bilinear(const uint8_t *src, int stride, int ch, int c, double sx, double sy)
+{
+    int x0 = (int)floor(sx), y0 = (int)floor(sy);
+    double fx = sx - x0, fy = sy - y0;
+    const uint8_t *p0 = src + y0 * stride + x0 * ch + c;
+    const uint8_t *p1 = p0 + stride;
+    return (int)lrint(p0[0] * (1 - fx) * (1 - fy) + p0[ch] * fx * (1 - fy) + p1[0] * (1 - fx) * fy + p1[ch] * fx * fy);
+}
+
+static bool _inside(double sx, double sy, int w, int h)
+{
+    return sx >= 0 && sy >= 0 && sx < w - 1 && sy < h - 1;
+}
+
+// max difference of inside pixels between warp result and double reference, -1 if outside pixels are not bg
+static int _diff_reference(image::Image &src, image::Image &dst, const std::vector<float> &matrix)
+{
+    double inv[9];
+    _invert(matrix, inv);
+    int ch = _channels(src.format());
+    int max_diff = 0;
+    for (int y = 0; y < dst.height(); y++)
+    {
+        for (int x = 0; x < dst.width(); x++)
+        {
+            double sx, sy;
+            _map(inv, x, y, sx, sy);
+            const uint8_t *d = (uint8_t *)dst.data() + y * dst.stride() + x * ch;
+            if (_inside(sx, sy, src.width(), src.height()))
+            {
+                for (int c = 0; c < ch; c++)
+                    max_diff = std::max(max_diff, abs(_bilinear((uint8_t *)src.data(), src.stride(), ch, c, sx, sy) - d[c]));
+            }
+            else if (sx < -1 || sy < -1 || sx > src.width() || sy > src.height())
+            {
+                for (int c = 0; c < std::min(ch, 3); c++)
+                    if (d[c] != 0)
+                        return -1;
+            }
+        }
+    }
+    return max_diff;
+}
+
+// max difference of pixels map inside of source between two images
+static int _diff_inside(image::Image &a, image::Image &b, const std::vector<float> &matrix, int src_w, int src_h)
+{
+    double inv[9];
+    _invert(matrix, inv);
+    int ch = _channels(a.format());
+    int max_diff = 0;
+    for (int y = 0; y < a.height(); y++)
+    {
+        for (int x = 0; x < a.width(); x++)
+        {
+            double sx, sy;
+            _map(inv, x, y, sx, sy);
+            if (!_inside(sx, sy, src_w, src_h))
+                continue;
+            const uint8_t *pa = (uint8_t *)a.data() + y * a.stride() + x * ch;
+            const uint8_t *pb = (uint8_t *)b.data() + y * b.stride() + x * ch;
+            for (int c = 0; c < ch; c++)
+                max_diff = std::max(max_diff, abs(pa[c] - pb[c]));
+        }
+    }
+    return max_diff;
+}
+
+static int test_reference()
+{
+    int errors = 0;
+    const int sw = 320, sh = 240, dw = 200, dh = 160;
+    double a = 0.3;
+    std::vector<float> affine = {(float)(1.2 * cos(a)), (float)(-1.2 * sin(a)), -20.f, (float)(1.2 * sin(a)), (float)(1.2 * cos(a)), -60.f};
+    std::vector<float> perspective = {0.9f, 0.1f, -10.f, -0.05f, 1.1f, -5.f, 0.0004f, 0.0008f, 1.f};
+    image::Format formats[] = {image::FMT_GRAYSCALE, image::FMT_RGB888, image::FMT_BGRA8888};
+    for (int i = 0; i < 2; i++)
+    {
+        std::vector<float> &matrix = i ? perspective : affine;
+        for (auto format : formats)
+        {
+            image::Image *src = _smooth_image(sw, sh, format);
+            image::Warp warp(matrix, sw, sh, dw, dh);
+            image::Image *dst = warp.apply(*src);
+            int diff = _diff_reference(*src, *dst, matrix);
+            errors += _result(std::string(i ? "perspective " : "affine ") + image::fmt_names[format] + " max diff " + std::to_string(diff), diff >= 0 && diff <= 1);
+            delete dst;
+            delete src;
+        }
+    }
+    return errors;
+}
+
+// NV21 luma and chroma planes are the same as double reference
+static int test_yuv()
+{
+    const int sw = 320, sh = 240, dw = 200, dh = 160;
+    std::vector<float> matrix = {1.1f, 0.2f, -30.f, -0.15f, 0.9f, 10.f};
+    image::Image *src = _smooth_image(sw, sh, image::FMT_YVU420SP);
+    image::Warp warp(matrix, sw, sh, dw, dh);
+    image::Image *dst = warp.apply(*src);
+    int diff = _diff_reference(*src, *dst, matrix);
+
+    // chroma plane sample at chroma sample center
+    double inv[9];
+    _invert(matrix, inv);
+    uint8_t *uv = (uint8_t *)src->data() + sw * sh;
+    uint8_t *duv = (uint8_t *)dst->data() + dw * dh;
+    int diff_uv = 0;
+    for (int y = 0; y < dh / 2; y++)
+    {
+        for (int x = 0; x < dw / 2; x++)
+        {
+            double sx, sy;
+            _map(inv, 2 * x + 0.5, 2 * y + 0.5, sx, sy);
+            sx = (sx - 0.5) / 2;
+            sy = (sy - 0.5) / 2;
+            if (!_inside(sx, sy, sw / 2, sh / 2))
+                continue;
+            for (int c = 0; c < 2; c++)
+                diff_uv = std::max(diff_uv, abs(_bilinear(uv, sw, 2, c, sx, sy) - duv[y * dw + x * 2 + c]));
+        }
+    }
+    delete dst;
+    delete src;
+    return _result("YVU420SP max diff " + std::to_string(diff) + ", uv " + std::to_string(diff_uv), diff >= 0 && diff <= 1 && diff_uv <= 1);
+}
+
+// integer translation with nearest is pixel exact
+static int test_nearest()
+{
+    const int sw = 320, sh = 240, dw = 200, dh = 160;
+    image::Image *src = _smooth_image(sw, sh, image::FMT_RGB888);
+    image::Warp warp({1, 0, -10.4f, 0, 1, -3.6f}, sw, sh, dw, dh, image::ResizeMethod::NEAREST);
+    image::Image *dst = warp.apply(*src);
+    image::Image *crop = src->crop(10, 4, dw, dh);
+    bool same = memcmp(dst->data(), crop->data(), dst->data_size()) == 0;
+    delete crop;
+    delete dst;
+    delete src;
+    return _result("nearest translate", same);
+}
+
+// apply into a view with invalid bg keeps pixels map to outside, and inside is the same as new image
+static int test_transparent()
+{
+    const int sw = 320, sh = 240, dw = 200, dh = 160;
+    std::vector<float> matrix = {1.3f, 0.1f, -40.f, -0.1f, 1.3f, -30.f};
+    image::Image *src = _smooth_image(sw, sh, image::FMT_RGB888);
+    image::Warp warp(matrix, sw, sh, dw, dh);
+    image::Warp transparent(matrix, sw, sh, dw, dh, image::ResizeMethod::BILINEAR, image::COLOR_INVALID);
+    image::Image *dst = warp.apply(*src);
+    image::Image big(dw + 10, dh, image::FMT_RGB888, image::COLOR_WHITE);
+    image::Image *view = big.view(5, 0, dw, dh);
+    transparent.apply(*src, view);
+
+    double inv[9];
+    _invert(matrix, inv);
+    bool ok = _diff_inside(*dst, *view, matrix, sw, sh) == 0;
+    for (int y = 0; y < dh && ok; y++)
+    {
+        for (int x = 0; x < dw; x++)
+        {
+            double sx, sy;
+            _map(inv, x, y, sx, sy);
+            if ((sx < -1 || sy < -1 || sx > sw || sy > sh) && view->get_pixel(x, y, true) != std::vector<uint32_t>{255, 255, 255})
+                ok = false;
+        }
+    }
+    ok = ok && big.get_pixel(2, 10, true) == std::vector<uint32_t>{255, 255, 255} && big.get_pixel(dw + 7, 10, true) == std::vector<uint32_t>{255, 255, 255};
+    delete view;
+    delete dst;
+    delete src;
+    return _result("transparent bg into view", ok);
+}
+
+// the same as Image.affine, Image.perspective and Image.rotate(OpenCV) which Warp replaced,
+// both use 5 bits sub pixel, only fixed point rounding differs
+static int test_opencv()
+{
+    int errors = 0;
+    const int sw = 320, sh = 240, dw = 256, dh = 192;
+    image::Format formats[] = {image::FMT_GRAYSCALE, image::FMT_RGB888};
+    for (auto format : formats)
+    {
+        image::Image *src = _smooth_image(sw, sh, format);
+
+        std::vector<int> src_tri = {10, 20, 300, 30, 40, 220};
+        std::vector<int> dst_tri = {0, 0, 250, 20, 30, 180};
+        std::vector<float> matrix = image::Warp::affine_matrix(src_tri, dst_tri);
+        image::Image *old = src->affine(src_tri, dst_tri, dw, dh);
+        image::Image *dst = image::Warp(matrix, sw, sh, dw, dh).apply(*src);
+        int diff = _diff_inside(*old, *dst, matrix, sw, sh);
+        errors += _result(std::string("affine vs Image.affine ") + image::fmt_names[format] + " max diff " + std::to_string(diff), diff <= 2);
+        delete old;
+        delete dst;
+
+        std::vector<int> src_quad = {20, 10, 300, 30, 310, 230, 5, 200};
+        std::vector<int> dst_quad = {0, 0, dw, 0, dw, dh, 0, dh};
+        matrix = image::Warp::perspective_matrix(src_quad, dst_quad);
+        old = src->perspective(src_quad, dst_quad, dw, dh);
+        dst = image::Warp(matrix, sw, sh, dw, dh).apply(*src);
+        diff = _diff_inside(*old, *dst, matrix, sw, sh);
+        errors += _result(std::string("perspective vs Image.perspective ") + image::fmt_names[format] + " max diff " + std::to_string(diff), diff <= 2);
+        delete old;
+        delete dst;
+
+        matrix = image::Warp::rotate_matrix(30, sw, sh, dw, dh);
+        old = src->rotate(30, dw, dh);
+        dst = image::Warp(matrix, sw, sh, dw, dh).apply(*src);
+        diff = _diff_inside(*old, *dst, matrix, sw, sh);
+        errors += _result(std::string("rotate vs Image.rotate ") + image::fmt_names[format] + " max diff " + std::to_string(diff), diff <= 2);
+        delete old;
+        delete dst;
+
+        delete src;
+    }
+    return errors;
+}
+
+int _main(int argc, char *argv[])
+{
+    int errors = 0;
+    errors += test_reference();
+    errors += test_yuv();
+    errors += test_nearest();
+    errors += test_transparent();
+    errors += test_opencv();
+    if (errors)
+    {
+        log::error("Image warp test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("Image warp test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,139 @@
+#include "maix_basic.hpp"
+#include "maix_nn_embedding_index.hpp"
+#include "main.h"
+#include <random>
+
+using namespace maix;
+
+// cosine similarity of FaceRecognizer _feature_compare before EmbeddingIndex, without mapping to [0, 1]
+static float _cosine_ref(const float *ftr0, const float *ftr1, int len)
+{
+    double sumcorr = 0;
+    double sumftr0 = 0;
+    double sumftr1 = 0;
+
+    for (int i = 0; i < len; i++)
+    {
+        sumftr0 += ftr0[i] * ftr0[i];
+        sumftr1 += ftr1[i] * ftr1[i];
+        sumcorr += ftr0[i] * ftr1[i];
+    }
+    return sumcorr / sqrt(sumftr0 * sumftr1);
+}
+
+// brute force top k, sorted by similarity from high to low, index ascending if similarity equal
+static std::vector<std::pair<int, float>> _search_ref(std::vector<std::vector<float>> &db, std::vector<float> &query, int k)
+{
+    std::vector<std::pair<int, float>> res;
+    for (size_t i = 0; i < db.size(); i++)
+        res.push_back({(int)i, _cosine_ref(db[i].data(), query.data(), query.size())});
+    std::stable_sort(res.begin(), res.end(), [](const std::pair<int, float> &a, const std::pair<int, float> &b)
+                     { return a.second > b.second; });
+    res.resize(std::min((int)res.size(), k));
+    return res;
+}
+
+// compare top k of index with brute force, indexes must be the same if similarities differ more than max_err
+static int _check(nn::EmbeddingIndex &index, std::vector<std::vector<float>> &db, std::vector<std::vector<float>> &queries,
+                  int k, int nprobe, float max_err, const char *name)
+{
+    int errors = 0;
+    float err = 0;
+    for (auto &query : queries)
+    {
+        std::vector<std::pair<int, float>> res = index.search(query, k, nprobe);
+        std::vector<std::pair<int, float>> ref = _search_ref(db, query, k);
+        if (res.size() != ref.size())
+        {
+            ++errors;
+            continue;
+        }
+        for (size_t i = 0; i < res.size(); i++)
+        {
+            float e = fabsf(res[i].second - _cosine_ref(db[res[i].first].data(), query.data(), query.size()));
+            err = std::max(err, e);
+            if (e > max_err || (res[i].first != ref[i].first && fabsf(res[i].second - ref[i].second) > 2 * max_err))
+            {
+                if (errors++ < 5)
+                    log::error("%s: result %d is %d %f, expected %d %f", name, (int)i, res[i].first, res[i].second, ref[i].first, ref[i].second);
+            }
+        }
+    }
+    log::info("%s: %d queries, max similarity error %e, %d errors", name, (int)queries.size(), err, errors);
+    return errors;
+}
+
+int _main(int argc, char *argv[])
+{
+    const int num = 2000, dim = 128, query_num = 20, k = 5;
+    const char *path = "/tmp/test_embedding_index.bin";
+    std::mt19937 gen(1);
+    std::normal_distribution<float> dist(0, 1);
+    std::vector<std::vector<float>> db(num, std::vector<float>(dim)), queries(query_num, std::vector<float>(dim));
+    for (auto &v : db)
+        for (auto &x : v)
+            x = dist(gen);
+    // queries near some embeddings, like faces of the same person
+    for (int q = 0; q < query_num; q++)
+        for (int d = 0; d < dim; d++)
+            queries[q][d] = db[q * 97 % num][d] + 0.5f * dist(gen);
+
+    int errors = 0;
+    const float max_errs[] = {1e-5f, 1e-3f, 1e-2f};
+    const char *names[] = {"float32", "float16", "int8"};
+    for (int dtype = 0; dtype < 3; dtype++)
+    {
+        std::string name = names[dtype];
+        nn::EmbeddingIndex index(dim, (nn::EmbeddingDType)dtype);
+        for (auto &v : db)
+            index.add(v);
+        errors += _check(index, db, queries, k, 0, max_errs[dtype], (name + " exact").c_str());
+        // IVF search all clusters is exact
+        index.build_ivf();
+        errors += _check(index, db, queries, k, index.nlist(), max_errs[dtype], (name + " ivf all").c_str());
+        // saved and loaded index get the same result
+        if (index.save(path) != err::ERR_NONE)
+        {
+            log::error("%s save failed", name.c_str());
+            ++errors;
+            continue;
+        }
+        for (bool mmap : {true, false})
+        {
+            nn::EmbeddingIndex loaded;
+            if (loaded.load(path, mmap) != err::ERR_NONE || loaded.size() != num || loaded.dim() != dim || loaded.nlist() != index.nlist())
+            {
+                log::error("%s load failed", name.c_str());
+                ++errors;
+                continue;
+            }
+            int diff = 0;
+            for (auto &query : queries)
+                diff += index.search(query, k, 4) != loaded.search(query, k, 4);
+            // modify mmap index copies it to memory, order is kept after remove
+            loaded.remove(5);
+            diff += loaded.size() != num - 1 || loaded.get(5) != index.get(6);
+            log::info("%s loaded %s: %s", name.c_str(), mmap ? "with mmap" : "without mmap", diff ? "different" : "same");
+            errors += diff;
+        }
+    }
+    fs::remove(path);
+    if (errors)
+    {
+        log::error("EmbeddingIndex test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("EmbeddingIndex test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,229 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_nn.hpp"
+#include "main.h"
+#include <math.h>
+#include <random>
+
+using namespace maix;
+
+static int _result(const std::string &name, bool ok)
+{
+    if (ok)
+        log::info("%s: ok", name.c_str());
+    else
+        log::error("%s: failed", name.c_str());
+    return ok ? 0 : 1;
+}
+
+// compare every output tensor, float outputs of batched run may differ from single run in last bits
+static bool _same(tensor::Tensors *a, tensor::Tensors *b)
+{
+    if (!a || !b)
+        return false;
+    auto ia = a->begin(), ib = b->begin();
+    for (; ia != a->end() && ib != b->end(); ++ia, ++ib)
+    {
+        tensor::Tensor *ta = ia->second, *tb = ib->second;
+        if (ia->first != ib->first || ta->shape() != tb->shape() || ta->dtype() != tb->dtype())
+        {
+            log::error("output %s shape or dtype not match", ia->first.c_str());
+            return false;
+        }
+        if (ta->dtype() != tensor::DType::FLOAT32)
+        {
+            if (memcmp(ta->data(), tb->data(), (size_t)ta->size_int() * tensor::dtype_size[ta->dtype()]) != 0)
+            {
+                log::error("output %s data not match", ia->first.c_str());
+                return false;
+            }
+            continue;
+        }
+        float *pa = (float *)ta->data(), *pb = (float *)tb->data();
+        for (int i = 0; i < ta->size_int(); i++)
+        {
+            if (fabsf(pa[i] - pb[i]) > 1e-4f * fmaxf(1.0f, fabsf(pa[i])))
+            {
+                log::error("output %s[%d] %f != %f", ia->first.c_str(), i, pa[i], pb[i]);
+                return false;
+            }
+        }
+    }
+    return ia == a->end() && ib == b->end();
+}
+
+static image::Image *_image(nn::NN &model, int w, int h, uint32_t seed)
+{
+    nn::LayerInfo info = model.inputs_info()[0];
+    int c = info.layout == nn::Layout::NCHW ? info.shape[1] : info.shape[3];
+    image::Image *img = new image::Image(w, h, c == 1 ? image::FMT_GRAYSCALE : image::FMT_RGB888);
+    std::mt19937 rng(seed);
+    uint8_t *p = (uint8_t *)img->data();
+    for (int i = 0; i < img->data_size(); i++)
+        p[i] = rng() & 0xff;
+    return img;
+}
+
+static image::Size _input_size(nn::NN &model)
+{
+    nn::LayerInfo info = model.inputs_info()[0];
+    if (info.layout == nn::Layout::NCHW)
+        return image::Size(info.shape[3], info.shape[2]);
+    return image::Size(info.shape[2], info.shape[1]);
+}
+
+static bool _same_list(std::vector<tensor::Tensors *> &res, std::vector<tensor::Tensors *> &ref)
+{
+    bool same = res.size() == ref.size();
+    for (size_t i = 0; same && i < res.size(); i++)
+        same = _same(ref[i], res[i]);
+    return same;
+}
+
+static void _free_list(std::vector<tensor::Tensors *> &list)
+{
+    for (auto t : list)
+        delete t;
+    list.clear();
+}
+
+static int test_images(nn::NN &model, nn::NN &dual)
+{
+    int errors = 0;
+    image::Size size = _input_size(model);
+    // input size and images need resize
+    std::vector<image::Image *> imgs;
+    for (int i = 0; i < 5; i++)
+        imgs.push_back(i % 2 ? _image(model, size.width() * 2, size.height() * 2, i) : _image(model, size.width(), size.height(), i));
+    std::vector<tensor::Tensors *> ref;
+    for (auto img : imgs)
+        ref.push_back(model.forward_image(*img, {}, {}, image::Fit::FIT_FILL, true));
+
+    std::vector<tensor::Tensors *> res = model.forward_batch(imgs);
+    errors += _result("batch images", _same_list(res, ref));
+    _free_list(res);
+
+    // not copied, results of all images should still be kept
+    res = model.forward_batch(imgs, {}, {}, image::Fit::FIT_FILL, {}, false);
+    errors += _result("batch images not copy", _same_list(res, ref));
+    _free_list(res);
+
+    std::vector<image::Image *> one = {imgs[1]};
+    res = model.forward_batch(one);
+    errors += _result("batch one image", res.size() == 1 && _same(ref[1], res[0]));
+    _free_list(res);
+
+    // input forwarded before batch is running in background
+    tensor::Tensors *out = dual.forward_image(*imgs[4]);
+    delete out;
+    res = dual.forward_batch(imgs);
+    errors += _result("batch images dual buff", _same_list(res, ref));
+    _free_list(res);
+    // result of the input before batch(or the extra run in forward_batch) is dropped, then returns result of the previous input
+    out = dual.forward_image(*imgs[0]);
+    errors += _result("dual buff after batch not ready", out == nullptr);
+    delete out;
+    out = dual.forward_image(*imgs[2]);
+    errors += _result("dual buff after batch", _same(ref[0], out));
+    delete out;
+
+    _free_list(ref);
+    for (auto img : imgs)
+        delete img;
+    return errors;
+}
+
+static int test_rois(nn::NN &model, nn::NN &dual)
+{
+    int errors = 0;
+    image::Size size = _input_size(model);
+    int w = size.width() * 3, h = size.height() * 2;
+    image::Image *img = _image(model, w, h, 10);
+    std::vector<int> rois = {0, 0, size.width(), size.height(),
+                             w / 3, h / 4, size.width() * 2, size.height(),
+                             w - size.width() / 2, h - size.height() / 2, size.width() / 2, size.height() / 2};
+    std::vector<tensor::Tensors *> ref;
+    for (size_t i = 0; i < rois.size(); i += 4)
+    {
+        image::Image *crop = img->crop(rois[i], rois[i + 1], rois[i + 2], rois[i + 3]);
+        ref.push_back(model.forward_image(*crop, {}, {}, image::Fit::FIT_FILL, true));
+        delete crop;
+    }
+    std::vector<image::Image *> imgs = {img};
+    std::vector<tensor::Tensors *> res = model.forward_batch(imgs, {}, {}, image::Fit::FIT_FILL, rois);
+    errors += _result("batch rois", _same_list(res, ref));
+    _free_list(res);
+    res = dual.forward_batch(imgs, {}, {}, image::Fit::FIT_FILL, rois);
+    errors += _result("batch rois dual buff", _same_list(res, ref));
+    _free_list(res);
+    res = dual.forward_batch(imgs, {}, {}, image::Fit::FIT_FILL, rois, false);
+    errors += _result("batch rois dual buff not copy", _same_list(res, ref));
+    _free_list(res);
+
+    // one roi for every image
+    std::vector<image::Image *> imgs3 = {img, img, img};
+    res = model.forward_batch(imgs3, {}, {}, image::Fit::FIT_FILL, rois);
+    errors += _result("batch rois of images", _same_list(res, ref));
+    _free_list(res);
+
+    _free_list(ref);
+    delete img;
+    return errors;
+}
+
+static int test_args(nn::NN &model)
+{
+    int errors = 0;
+    image::Size size = _input_size(model);
+    image::Image *img = _image(model, size.width(), size.height(), 20);
+    auto throws = [&](std::vector<image::Image *> imgs, std::vector<int> rois) {
+        try
+        {
+            std::vector<tensor::Tensors *> res = model.forward_batch(imgs, {}, {}, image::Fit::FIT_FILL, rois);
+            _free_list(res);
+        }
+        catch (err::Exception &e)
+        {
+            return e.code() == err::ERR_ARGS;
+        }
+        return false;
+    };
+    errors += _result("no image", throws({}, {}));
+    errors += _result("roi not 4 values", throws({img}, {0, 0, 1}));
+    errors += _result("roi number not match", throws({img, img}, {0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1}));
+    delete img;
+    return errors;
+}
+
+int _main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        log::error("Usage: %s model.mud", argv[0]);
+        return -1;
+    }
+    nn::NN model(argv[1], false);
+    nn::NN dual(argv[1], true);
+    int errors = 0;
+    errors += test_images(model, dual);
+    errors += test_rois(model, dual);
+    errors += test_args(model);
+    if (errors)
+    {
+        log::error("NN forward batch test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("NN forward batch test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,141 @@
+#include "maix_basic.hpp"
+#include "maix_nn_nms.hpp"
+#include "main.h"
+#include <random>
+
+using namespace maix;
+
+static float _iou(const nn::Object &a, const nn::Object &b)
+{
+    float w = std::min(a.x + a.w, b.x + b.w) - std::max(a.x, b.x);
+    float h = std::min(a.y + a.h, b.y + b.h) - std::max(a.y, b.y);
+    float inter = std::max(w, 0.f) * std::max(h, 0.f);
+    return inter / (a.w * a.h + b.w * b.h - inter);
+}
+
+// brute force greedy NMS of YOLO decoders before nn::NMS, O(n^2)
+static std::vector<int> _nms_ref(nn::Objects &objs, float iou_th, bool class_agnostic)
+{
+    std::vector<int> order(objs.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&objs](int a, int b)
+                     { return objs.at(a).score > objs.at(b).score; });
+    std::vector<uint8_t> removed(objs.size(), 0);
+    std::vector<int> keep;
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        if (removed[order[i]])
+            continue;
+        nn::Object &a = objs.at(order[i]);
+        keep.push_back(order[i]);
+        for (size_t j = i + 1; j < order.size(); j++)
+        {
+            nn::Object &b = objs.at(order[j]);
+            if (!removed[order[j]] && (class_agnostic || a.class_id == b.class_id) && _iou(a, b) > iou_th)
+                removed[order[j]] = 1;
+        }
+    }
+    return keep;
+}
+
+static void _random_objs(nn::Objects &objs, int n, int class_num, uint32_t seed)
+{
+    std::mt19937 gen(seed);
+    // distinct scores, so order is the same for all implementations
+    std::vector<float> scores(n);
+    for (int i = 0; i < n; i++)
+        scores[i] = (i + 1) / (float)(n + 1);
+    std::shuffle(scores.begin(), scores.end(), gen);
+    for (int i = 0; i < n; i++)
+        objs.add(gen() % 600, gen() % 600, 10 + gen() % 80, 10 + gen() % 80, gen() % class_num, scores[i]);
+}
+
+static int test_hard(bool class_agnostic)
+{
+    int errors = 0;
+    nn::NMS nms(nn::NMSMethod::NMS_HARD, 0.5, class_agnostic);
+    std::vector<int> keep;
+    for (int n : {1, 5, 40, 300, 3000})
+    {
+        nn::Objects objs;
+        _random_objs(objs, n, 3, n);
+        std::vector<int> ref = _nms_ref(objs, 0.45, class_agnostic);
+        std::vector<int> res = nms.run(objs, 0.45);
+        // reused output vector gets the same result
+        keep.assign(3, -1);
+        nms.run(objs, keep, 0.45);
+        bool same = res == ref && keep == ref;
+        log::info("hard NMS%s: %d boxes, kept %d, reference kept %d, %s", class_agnostic ? " class agnostic" : "",
+                  n, (int)res.size(), (int)ref.size(), same ? "same" : "different");
+        errors += !same;
+    }
+    return errors;
+}
+
+static int test_rotated()
+{
+    nn::NMS nms;
+    float x[2] = {0, 0}, y[2] = {0, 0}, w[2] = {100, 100}, h[2] = {10, 10}, scores[2] = {0.9, 0.8};
+    // cross: bounding boxes overlap, rotated boxes overlap only in center
+    float cross[2] = {0, 0.5};
+    int kept_cross = (int)nms.run(2, x, y, w, h, scores, nullptr, cross, 0.3).size();
+    // the same rotated box
+    float same[2] = {0.25, 0.25};
+    int kept_same = (int)nms.run(2, x, y, w, h, scores, nullptr, same, 0.3).size();
+    log::info("rotated NMS: cross boxes kept %d, same boxes kept %d", kept_cross, kept_same);
+    return (kept_cross == 2 && kept_same == 1) ? 0 : 1;
+}
+
+static int test_soft()
+{
+    int errors = 0;
+    for (auto method : {nn::NMSMethod::NMS_SOFT, nn::NMSMethod::NMS_MATRIX})
+    {
+        nn::NMS nms(method, 0.5);
+        // not overlapped boxes keep their scores
+        nn::Objects objs;
+        for (int i = 0; i < 10; i++)
+            objs.add(i * 50, 0, 40, 40, 0, 0.1f * (i + 1) - 0.05f);
+        std::vector<int> keep = nms.run(objs, 0.45, 0.01);
+        bool ok = keep.size() == 10;
+        for (int i = 0; ok && i < 10; i++)
+            ok = keep[i] == 9 - i && fabsf(objs.at(9 - i).score - (0.1f * (10 - i) - 0.05f)) < 1e-6f;
+        // overlapped box score is decayed, not removed
+        nn::Objects objs2;
+        objs2.add(0, 0, 100, 100, 0, 0.9);
+        objs2.add(5, 5, 100, 100, 0, 0.8);
+        keep = nms.run(objs2, 0.45, 0.01);
+        ok = ok && keep.size() == 2 && objs2.at(1).score < 0.8f && objs2.at(0).score == 0.9f;
+        log::info("%s NMS: %s", method == nn::NMSMethod::NMS_SOFT ? "soft" : "matrix", ok ? "ok" : "failed");
+        errors += !ok;
+    }
+    return errors;
+}
+
+int _main(int argc, char *argv[])
+{
+    int errors = 0;
+    errors += test_hard(false);
+    errors += test_hard(true);
+    errors += test_rotated();
+    errors += test_soft();
+    if (errors)
+    {
+        log::error("NMS test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("NMS test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
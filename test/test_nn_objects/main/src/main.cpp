@@ -0,0 +1,113 @@
+#include "maix_basic.hpp"
+#include "maix_nn_object.hpp"
+#include "main.h"
+
+using namespace maix;
+
+static bool _obj_equal(nn::Object &obj, int i)
+{
+    std::vector<int> points(i % 4 * 2, i);
+    return obj.x == i && obj.y == i * 2 && obj.w == 10 + i && obj.h == 20 + i && obj.class_id == i % 3 &&
+           obj.score == i / 100.0f && obj.points == points && obj.angle == -1 && obj.seg_mask == NULL;
+}
+
+static void _add(nn::Objects &objs, int n)
+{
+    for (int i = 0; i < n; i++)
+        objs.add(i, i * 2, 10 + i, 20 + i, i % 3, i / 100.0f, std::vector<int>(i % 4 * 2, i));
+}
+
+// objects of reused Objects are the same as a new Objects
+static int test_reuse()
+{
+    int errors = 0;
+    nn::Objects objs;
+    for (int n : {100, 10, 200, 0, 65})
+    {
+        objs.clear();
+        _add(objs, n);
+        int wrong = objs.size() == (size_t)n ? 0 : 1;
+        for (int i = 0; i < (int)objs.size(); i++)
+            wrong += !_obj_equal(objs[i], i);
+        log::info("reuse: %d objects, %s", n, wrong ? "different" : "same");
+        errors += wrong;
+    }
+    // remove keeps order like before, removed object is reused by add
+    objs.clear();
+    _add(objs, 10);
+    objs.remove(3);
+    objs.remove(0);
+    bool ok = objs.remove(8) == err::ERR_ARGS && objs.size() == 8;
+    int expected[] = {1, 2, 4, 5, 6, 7, 8, 9};
+    for (int i = 0; ok && i < 8; i++)
+        ok = _obj_equal(objs[i], expected[i]);
+    nn::Object &obj = objs.add(objs[0]);
+    ok = ok && objs.size() == 9 && _obj_equal(obj, 1) && &obj != &objs[0];
+    log::info("remove: %s", ok ? "ok" : "failed");
+    return errors + !ok;
+}
+
+// masks are w x h grayscale images, writing one mask doesn't change others
+static int test_mask()
+{
+    int errors = 0;
+    nn::Objects objs;
+    for (int frame = 0; frame < 3; frame++)
+    {
+        objs.clear();
+        _add(objs, 20);
+        for (int i = 0; i < 20; i++)
+        {
+            int w = 17 + i * 13 + frame, h = 9 + i * 7;
+            image::Image *mask = objs.new_mask(objs[i], w, h);
+            if (mask != objs[i].seg_mask || mask->width() != w || mask->height() != h || mask->format() != image::FMT_GRAYSCALE)
+            {
+                log::error("mask %d of frame %d: %dx%d, expected %dx%d", i, frame, mask->width(), mask->height(), w, h);
+                ++errors;
+                continue;
+            }
+            memset(mask->data(), i + frame, w * h);
+        }
+        for (int i = 0; i < 20; i++)
+        {
+            image::Image *mask = objs[i].seg_mask;
+            uint8_t *data = (uint8_t *)mask->data();
+            for (int k = 0; k < mask->width() * mask->height(); k++)
+            {
+                if (data[k] != i + frame)
+                {
+                    log::error("mask %d of frame %d changed at %d: %d", i, frame, k, data[k]);
+                    ++errors;
+                    break;
+                }
+            }
+        }
+    }
+    log::info("mask: %d errors", errors);
+    return errors;
+}
+
+int _main(int argc, char *argv[])
+{
+    int errors = 0;
+    errors += test_reuse();
+    errors += test_mask();
+    if (errors)
+    {
+        log::error("nn Objects test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("nn Objects test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,208 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_nn.hpp"
+#include "main.h"
+#include <math.h>
+#include <random>
+
+using namespace maix;
+
+static int _result(const std::string &name, bool ok)
+{
+    if (ok)
+        log::info("%s: ok", name.c_str());
+    else
+        log::error("%s: failed", name.c_str());
+    return ok ? 0 : 1;
+}
+
+// compare every output tensor's shape, dtype and data
+static bool _same(tensor::Tensors *a, tensor::Tensors *b)
+{
+    if (!a || !b)
+        return false;
+    auto ia = a->begin(), ib = b->begin();
+    for (; ia != a->end() && ib != b->end(); ++ia, ++ib)
+    {
+        tensor::Tensor *ta = ia->second, *tb = ib->second;
+        if (ia->first != ib->first || ta->shape() != tb->shape() || ta->dtype() != tb->dtype())
+        {
+            log::error("output %s shape or dtype not match", ia->first.c_str());
+            return false;
+        }
+        if (memcmp(ta->data(), tb->data(), (size_t)ta->size_int() * tensor::dtype_size[ta->dtype()]) != 0)
+        {
+            log::error("output %s data not match", ia->first.c_str());
+            return false;
+        }
+    }
+    return ia == a->end() && ib == b->end();
+}
+
+static image::Image *_input_image(nn::NN &model, uint32_t seed)
+{
+    nn::LayerInfo info = model.inputs_info()[0];
+    bool nchw = info.layout == nn::Layout::NCHW;
+    int w = nchw ? info.shape[3] : info.shape[2];
+    int h = nchw ? info.shape[2] : info.shape[1];
+    int c = nchw ? info.shape[1] : info.shape[3];
+    image::Image *img = new image::Image(w, h, c == 1 ? image::FMT_GRAYSCALE : image::FMT_RGB888);
+    std::mt19937 rng(seed);
+    uint8_t *p = (uint8_t *)img->data();
+    for (int i = 0; i < img->data_size(); i++)
+        p[i] = rng() & 0xff;
+    return img;
+}
+
+static int test_info(nn::NN &model)
+{
+    int errors = 0;
+    std::vector<nn::LayerInfo> inputs = model.inputs_info();
+    std::vector<nn::LayerInfo> outputs = model.outputs_info();
+    for (auto &i : inputs)
+        log::info("input %s", i.to_str().c_str());
+    for (auto &o : outputs)
+        log::info("output %s", o.to_str().c_str());
+    errors += _result("layers info", !inputs.empty() && !outputs.empty() && inputs[0].shape.size() == 4);
+    return errors;
+}
+
+static int test_forward_image(nn::NN &model)
+{
+    int errors = 0;
+    std::vector<image::Image *> imgs = {_input_image(model, 1), _input_image(model, 2), _input_image(model, 3)};
+    bool same = true, stable = true;
+    for (auto img : imgs)
+    {
+        tensor::Tensors *copied = model.forward_image(*img, {}, {}, image::Fit::FIT_FILL, true);
+        tensor::Tensors *copied2 = model.forward_image(*img, {}, {}, image::Fit::FIT_FILL, true);
+        stable = stable && _same(copied, copied2);
+        // result not copied point to model's buffers, valid until next forward
+        tensor::Tensors *not_copied = model.forward_image(*img, {}, {}, image::Fit::FIT_FILL, false);
+        same = same && _same(copied, not_copied);
+        delete copied;
+        delete copied2;
+        delete not_copied;
+    }
+    errors += _result("forward image repeat", stable);
+    errors += _result("forward image not copy", same);
+
+    // input is converted to model layout, hwc can only be asked for NHWC model
+    bool nchw = model.inputs_info()[0].layout == nn::Layout::NCHW;
+    bool chw_ok = false;
+    try
+    {
+        tensor::Tensors *hwc = model.forward_image(*imgs[0], {}, {}, image::Fit::FIT_FILL, true, false, false);
+        tensor::Tensors *copied = model.forward_image(*imgs[0], {}, {}, image::Fit::FIT_FILL, true);
+        chw_ok = !nchw && _same(copied, hwc);
+        delete hwc;
+        delete copied;
+    }
+    catch (err::Exception &e)
+    {
+        chw_ok = nchw && e.code() == err::ERR_ARGS;
+    }
+    errors += _result("forward image chw false", chw_ok);
+    for (auto img : imgs)
+        delete img;
+    return errors;
+}
+
+static int test_forward_tensors(nn::NN &model)
+{
+    int errors = 0;
+    std::vector<nn::LayerInfo> inputs_info = model.inputs_info();
+    tensor::Tensors inputs;
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    for (auto &info : inputs_info)
+    {
+        if (info.dtype != tensor::DType::FLOAT32)
+        {
+            log::info("input %s is not float32, skip forward tensors test", info.name.c_str());
+            return 0;
+        }
+        tensor::Tensor *t = new tensor::Tensor(info.shape, info.dtype);
+        float *p = (float *)t->data();
+        for (int i = 0; i < t->size_int(); i++)
+            p[i] = dist(rng);
+        inputs.add_tensor(info.name, t, false, true);
+    }
+    tensor::Tensors *copied = model.forward(inputs, true);
+    tensor::Tensors *not_copied = model.forward(inputs, false);
+    errors += _result("forward tensors not copy", _same(copied, not_copied));
+    delete not_copied;
+    tensor::Tensors outputs;
+    err::Err e = model.forward(inputs, outputs, true);
+    errors += _result("forward tensors to outputs", e == err::ERR_NONE && _same(copied, &outputs));
+    delete copied;
+    return errors;
+}
+
+static int test_dual_buff(const std::string &model_path, nn::NN &model)
+{
+    int errors = 0;
+    nn::NN dual(model_path, true);
+    std::vector<image::Image *> imgs = {_input_image(model, 5), _input_image(model, 6), _input_image(model, 7)};
+    std::vector<tensor::Tensors *> ref;
+    for (auto img : imgs)
+        ref.push_back(model.forward_image(*img, {}, {}, image::Fit::FIT_FILL, true));
+
+    // not wait, first forward is not ready, then every forward returns result of the previous input
+    tensor::Tensors *out0 = dual.forward_image(*imgs[0], {}, {}, image::Fit::FIT_FILL, true);
+    errors += _result("dual buff first not ready", out0 == nullptr);
+    delete out0;
+    bool same = true;
+    for (int i = 1; i < 3; i++)
+    {
+        tensor::Tensors *out = dual.forward_image(*imgs[i], {}, {}, image::Fit::FIT_FILL, true);
+        same = same && _same(ref[i - 1], out);
+        delete out;
+    }
+    errors += _result("dual buff previous result", same);
+
+    // wait, returns result of this input
+    tensor::Tensors *out = dual.forward_image(*imgs[1], {}, {}, image::Fit::FIT_FILL, true, true);
+    errors += _result("dual buff wait", _same(ref[1], out));
+    delete out;
+
+    for (auto r : ref)
+        delete r;
+    for (auto img : imgs)
+        delete img;
+    return errors;
+}
+
+int _main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        log::error("Usage: %s model.mud(or model.onnx)", argv[0]);
+        return -1;
+    }
+    std::string model_path = argv[1];
+    nn::NN model(model_path, false);
+    int errors = 0;
+    errors += test_info(model);
+    errors += test_forward_image(model);
+    errors += test_forward_tensors(model);
+    errors += test_dual_buff(model_path, model);
+    if (errors)
+    {
+        log::error("NN ONNX test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("NN ONNX test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,229 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_nn_pipeline.hpp"
+#include "main.h"
+#include <atomic>
+#include <mutex>
+#include <map>
+
+using namespace maix;
+
+static const int FRAMES = 60;
+
+static int _result(const std::string &name, bool ok)
+{
+    if (ok)
+        log::info("%s: ok", name.c_str());
+    else
+        log::error("%s: failed", name.c_str());
+    return ok ? 0 : 1;
+}
+
+// capture fills image from frame id, fails every 4th call to check id reuse
+static bool _capture(nn::PipelineFrame &f, int &calls)
+{
+    if (f.id >= FRAMES)
+    {
+        time::sleep_ms(1);
+        return false;
+    }
+    if (++calls % 4 == 0)
+        return false;
+    f.img = new image::Image(16, 8, image::FMT_GRAYSCALE);
+    uint8_t *p = (uint8_t *)f.img->data();
+    for (int i = 0; i < 16 * 8; i++)
+        p[i] = (uint8_t)((f.id * 7 + i * 3) & 0xff);
+    return true;
+}
+
+// find columns brighter than 128 as objects
+static bool _process(nn::PipelineFrame &f)
+{
+    f.objs = new nn::Objects();
+    uint8_t *p = (uint8_t *)f.img->data();
+    for (int x = 0; x < 16; x++)
+    {
+        int sum = 0;
+        for (int y = 0; y < 8; y++)
+            sum += p[y * 16 + x];
+        if (sum / 8 > 128)
+            f.objs->add(x, 0, 1, 8, (int)(f.id % 3), sum / 2040.0f);
+    }
+    return true;
+}
+
+static bool _decode(nn::PipelineFrame &f, int slow_ms)
+{
+    if (slow_ms)
+        time::sleep_ms(slow_ms);
+    // drop frames without object
+    return f.objs->size() > 0;
+}
+
+static std::string _summary(nn::PipelineFrame &f)
+{
+    std::string s = std::to_string(f.id) + ":";
+    for (size_t i = 0; i < f.objs->size(); i++)
+    {
+        nn::Object &o = f.objs->at(i);
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%d,%d,%.4f;", o.x, o.class_id, o.score);
+        s += buf;
+    }
+    return s;
+}
+
+// run stages one by one on every id, return summary of frames reach sink
+static std::map<uint64_t, std::string> _sequential()
+{
+    std::map<uint64_t, std::string> res;
+    int calls = 0;
+    uint64_t id = 0;
+    while (id < FRAMES)
+    {
+        nn::PipelineFrame f(id);
+        if (!_capture(f, calls))
+            continue;
+        ++id;
+        if (!_process(f) || !_decode(f, 0))
+            continue;
+        res[f.id] = _summary(f);
+    }
+    return res;
+}
+
+static int test_pipeline(bool drop_oldest, int slow_ms)
+{
+    int errors = 0;
+    std::string mode = drop_oldest ? "drop oldest" : "block";
+    std::map<uint64_t, std::string> ref = _sequential();
+    std::map<uint64_t, std::string> res;
+    std::mutex lock;
+    std::atomic<int> order_err{0};
+    int calls = 0;
+    uint64_t last = 0;
+    bool first = true;
+
+    nn::Pipeline p(2, drop_oldest);
+    p.add_stage([&](nn::PipelineFrame &f) { return _capture(f, calls); }, "capture");
+    p.add_stage(_process, "process");
+    p.add_stage([slow_ms](nn::PipelineFrame &f) { return _decode(f, slow_ms); }, "decode");
+    p.add_stage([&](nn::PipelineFrame &f) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!first && f.id <= last)
+            order_err++;
+        first = false;
+        last = f.id;
+        res[f.id] = _summary(f);
+        return true;
+    });
+    errors += _result(mode + " stages", p.stages() == 4);
+    std::vector<std::string> names = p.stage_names();
+    errors += _result(mode + " stage names", names.size() == 4 && names[0] == "capture" && names[1] == "process" && names[2] == "decode" && names[3] == "stage3");
+    errors += _result(mode + " start", p.start() == err::ERR_NONE && p.running());
+    errors += _result(mode + " start twice", p.start() == err::ERR_NOT_PERMIT);
+    errors += _result(mode + " add stage when running", [&]() {
+        try
+        {
+            p.add_stage(_process);
+        }
+        catch (err::Exception &e)
+        {
+            return e.code() == err::ERR_NOT_PERMIT;
+        }
+        return false;
+    }());
+
+    // wait all frames finished or dropped
+    uint64_t t = time::ticks_ms();
+    uint64_t total = 0;
+    while (time::ticks_ms() - t < 5000)
+    {
+        std::vector<uint64_t> dropped = p.dropped();
+        total = p.finished();
+        for (auto d : dropped)
+            total += d;
+        if (total >= FRAMES)
+            break;
+        time::sleep_ms(10);
+    }
+    std::vector<uint64_t> dropped = p.dropped();
+    std::vector<float> stage_time = p.stage_time();
+    p.stop();
+    errors += _result(mode + " stop", !p.running());
+
+    log::info("%s: finished %llu, dropped %llu %llu %llu %llu, decode %.2fms", mode.c_str(), (unsigned long long)p.finished(),
+              (unsigned long long)dropped[0], (unsigned long long)dropped[1], (unsigned long long)dropped[2], (unsigned long long)dropped[3], stage_time[2]);
+    errors += _result(mode + " all frames accounted", total == FRAMES);
+    errors += _result(mode + " order", order_err == 0);
+    errors += _result(mode + " finished count", p.finished() == res.size());
+    // source never drops, decode drops frames without object
+    errors += _result(mode + " capture dropped", dropped[0] == 0);
+    bool same = true;
+    for (auto &r : res)
+    {
+        auto it = ref.find(r.first);
+        if (it == ref.end() || it->second != r.second)
+        {
+            log::error("frame %llu: %s != %s", (unsigned long long)r.first, r.second.c_str(), it == ref.end() ? "dropped" : it->second.c_str());
+            same = false;
+        }
+    }
+    errors += _result(mode + " same as sequential", same);
+    if (!drop_oldest)
+    {
+        // block mode never drops a frame in queue, only frames decode rejected
+        errors += _result(mode + " all frames", res == ref);
+        errors += _result(mode + " queue dropped", dropped[1] == 0 && dropped[3] == 0 && dropped[2] == FRAMES - ref.size());
+    }
+    else
+    {
+        errors += _result(mode + " some frames dropped", res.size() < ref.size());
+    }
+    return errors;
+}
+
+static int test_args()
+{
+    int errors = 0;
+    errors += _result("queue size 0", [&]() {
+        try
+        {
+            nn::Pipeline p(0);
+        }
+        catch (err::Exception &e)
+        {
+            return e.code() == err::ERR_ARGS;
+        }
+        return false;
+    }());
+    nn::Pipeline p;
+    errors += _result("start without stage", p.start() == err::ERR_ARGS && !p.running());
+    return errors;
+}
+
+int _main(int argc, char *argv[])
+{
+    int errors = 0;
+    errors += test_pipeline(false, 5);
+    errors += test_pipeline(true, 5);
+    errors += test_args();
+    if (errors)
+    {
+        log::error("NN pipeline test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("NN pipeline test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,233 @@
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_nn.hpp"
+#include "maix_nn_self_learn_classifier.hpp"
+#include "main.h"
+#include <math.h>
+#include <random>
+
+using namespace maix;
+
+static const int CLASS_NUM = 3;
+static const int SAMPLE_PER_CLASS = 4;
+
+static int _result(const std::string &name, bool ok)
+{
+    if (ok)
+        log::info("%s: ok", name.c_str());
+    else
+        log::error("%s: failed", name.c_str());
+    return ok ? 0 : 1;
+}
+
+static bool _near(double a, double b)
+{
+    return fabs(a - b) <= 1e-4 * fmax(1.0, fabs(b));
+}
+
+// class c color with noise, samples are brighter or darker than class image
+static image::Image *_image(nn::SelfLearnClassifier &classifier, int c, int seed)
+{
+    static const uint8_t colors[CLASS_NUM][3] = {{200, 40, 40}, {40, 200, 40}, {40, 40, 200}};
+    image::Image *img = new image::Image(classifier.input_width(), classifier.input_height(), classifier.input_format());
+    std::mt19937 rng(seed);
+    int shift = seed % 5 * 8 - 16;
+    uint8_t *p = (uint8_t *)img->data();
+    int ch = image::fmt_size[img->format()];
+    for (int i = 0; i < img->width() * img->height(); i++)
+    {
+        for (int k = 0; k < ch; k++)
+        {
+            int v = colors[c][img->format() == image::FMT_BGR888 ? 2 - k : k] + shift + (int)(rng() % 32) - 16;
+            p[i * ch + k] = (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+        }
+    }
+    return img;
+}
+
+// feature is the first output of model, same as SelfLearnClassifier
+static std::vector<double> _feature(nn::NN &model, nn::SelfLearnClassifier &classifier, image::Image &img)
+{
+    tensor::Tensors *outs = model.forward_image(img, classifier.mean, classifier.scale, image::FIT_COVER, true);
+    tensor::Tensor *t = outs->begin()->second;
+    float *p = (float *)t->data();
+    std::vector<double> feature(p, p + t->size_int());
+    delete outs;
+    return feature;
+}
+
+static double _distance(const std::vector<double> &a, const std::vector<double> &b)
+{
+    double sum = 0;
+    for (size_t i = 0; i < a.size(); i++)
+        sum += (a[i] - b[i]) * (a[i] - b[i]);
+    return sqrt(sum);
+}
+
+// every sample is assigned to the nearest class, class feature is mean of its first feature and assigned samples
+static int _learn_ref(std::vector<std::vector<double>> &classes, const std::vector<std::vector<double>> &samples)
+{
+    std::vector<std::vector<double>> anchors = classes;
+    std::vector<int> assign(samples.size(), -1);
+    int epoch = 0;
+    while (epoch < 100)
+    {
+        int changed = 0;
+        for (size_t i = 0; i < samples.size(); i++)
+        {
+            int best = 0;
+            for (size_t c = 1; c < classes.size(); c++)
+            {
+                if (_distance(samples[i], classes[c]) < _distance(samples[i], classes[best]))
+                    best = (int)c;
+            }
+            if (assign[i] != best)
+            {
+                assign[i] = best;
+                changed++;
+            }
+        }
+        if (changed == 0)
+            break;
+        ++epoch;
+        for (size_t c = 0; c < classes.size(); c++)
+        {
+            classes[c] = anchors[c];
+            int count = 1;
+            for (size_t i = 0; i < samples.size(); i++)
+            {
+                if (assign[i] != (int)c)
+                    continue;
+                for (size_t k = 0; k < classes[c].size(); k++)
+                    classes[c][k] += samples[i][k];
+                ++count;
+            }
+            for (auto &v : classes[c])
+                v /= count;
+        }
+    }
+    return epoch;
+}
+
+// classify result should be distances to every class sorted from small to large
+static bool _check_classify(nn::SelfLearnClassifier &classifier, image::Image &img, const std::vector<double> &feature, const std::vector<std::vector<double>> &classes)
+{
+    std::vector<std::pair<int, float>> *res = classifier.classify(img);
+    bool ok = res->size() == classes.size();
+    for (size_t i = 0; ok && i < res->size(); i++)
+    {
+        int idx = (*res)[i].first;
+        double dis = _distance(feature, classes[idx]);
+        ok = idx >= 0 && idx < (int)classes.size() && _near((*res)[i].second, dis) && (i == 0 || (*res)[i - 1].second <= (*res)[i].second);
+        if (!ok)
+            log::error("class %d distance %f, expected %f", idx, (*res)[i].second, dis);
+    }
+    delete res;
+    return ok;
+}
+
+static bool _same_classify(nn::SelfLearnClassifier &a, nn::SelfLearnClassifier &b, image::Image &img)
+{
+    std::vector<std::pair<int, float>> *ra = a.classify(img);
+    std::vector<std::pair<int, float>> *rb = b.classify(img);
+    bool same = *ra == *rb;
+    delete ra;
+    delete rb;
+    return same;
+}
+
+int _main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        log::error("Usage: %s model.mud", argv[0]);
+        return -1;
+    }
+    std::string model_path = argv[1];
+    std::string save_path = "/tmp/test_nn_self_learn_classifier.bin";
+    int errors = 0;
+    nn::SelfLearnClassifier classifier(model_path);
+    nn::NN model(model_path, false);
+
+    std::vector<image::Image *> class_imgs, sample_imgs;
+    std::vector<std::vector<double>> classes, samples;
+    for (int c = 0; c < CLASS_NUM; c++)
+    {
+        class_imgs.push_back(_image(classifier, c, c * 100));
+        classes.push_back(_feature(model, classifier, *class_imgs.back()));
+        classifier.add_class(*class_imgs.back());
+        for (int i = 1; i <= SAMPLE_PER_CLASS; i++)
+        {
+            sample_imgs.push_back(_image(classifier, c, c * 100 + i));
+            samples.push_back(_feature(model, classifier, *sample_imgs.back()));
+            classifier.add_sample(*sample_imgs.back());
+        }
+    }
+    errors += _result("class and sample num", classifier.class_num() == CLASS_NUM && classifier.sample_num() == CLASS_NUM * SAMPLE_PER_CLASS);
+
+    bool ok = true;
+    for (size_t i = 0; i < sample_imgs.size(); i++)
+        ok = _check_classify(classifier, *sample_imgs[i], samples[i], classes) && ok;
+    errors += _result("classify", ok);
+
+    int epoch = classifier.learn();
+    int epoch_ref = _learn_ref(classes, samples);
+    errors += _result("learn epoch", epoch == epoch_ref && epoch > 0);
+    ok = true;
+    for (size_t i = 0; i < sample_imgs.size(); i++)
+        ok = _check_classify(classifier, *sample_imgs[i], samples[i], classes) && ok;
+    errors += _result("classify after learn", ok);
+    // learn again starts from class images, not from learned features
+    int epoch2 = classifier.learn();
+    ok = epoch2 == epoch;
+    for (size_t i = 0; i < sample_imgs.size(); i++)
+        ok = _check_classify(classifier, *sample_imgs[i], samples[i], classes) && ok;
+    errors += _result("learn again", ok);
+
+    // save and load
+    std::vector<std::string> labels = {"red", "green", "blue"};
+    errors += _result("save labels not match", classifier.save(save_path, {"red"}) == err::ERR_ARGS);
+    errors += _result("save", classifier.save(save_path, labels) == err::ERR_NONE);
+    nn::SelfLearnClassifier loaded(model_path);
+    std::vector<std::string> loaded_labels = loaded.load(save_path);
+    errors += _result("load", loaded_labels == labels && loaded.class_num() == CLASS_NUM && loaded.sample_num() == CLASS_NUM * SAMPLE_PER_CLASS);
+    ok = true;
+    for (auto img : sample_imgs)
+        ok = ok && _same_classify(classifier, loaded, *img);
+    errors += _result("classify after load", ok);
+
+    // remove class
+    errors += _result("rm class", classifier.rm_class(1) == err::ERR_NONE && classifier.class_num() == CLASS_NUM - 1 && classifier.rm_class(CLASS_NUM) == err::ERR_ARGS);
+    classes.erase(classes.begin() + 1);
+    ok = true;
+    for (size_t i = 0; i < sample_imgs.size(); i++)
+        ok = _check_classify(classifier, *sample_imgs[i], samples[i], classes) && ok;
+    errors += _result("classify after rm class", ok);
+
+    classifier.clear();
+    errors += _result("save empty", classifier.save(save_path) == err::ERR_ARGS);
+    fs::remove(save_path);
+
+    for (auto img : class_imgs)
+        delete img;
+    for (auto img : sample_imgs)
+        delete img;
+    if (errors)
+    {
+        log::error("SelfLearnClassifier test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("SelfLearnClassifier test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
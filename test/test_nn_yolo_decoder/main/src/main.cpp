@@ -0,0 +1,372 @@
+#include "maix_basic.hpp"
+#include "maix_nn_yolo_decoder.hpp"
+#include "main.h"
+#include <random>
+
+using namespace maix;
+
+// scalar sigmoid of YOLO11 before SIMD decoding
+static float _sigmoid_ref(float x)
+{
+    return 1.0f / (1.0f + expf(-x));
+}
+
+static void _fill(std::vector<float> &data, float min, float max, uint32_t seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> dist(min, max);
+    for (auto &v : data)
+        v = dist(gen);
+}
+
+// anchors of w x h input, stride 8, 16, 32
+struct Anchor
+{
+    int idx;
+    int x, y;
+    int stride;
+};
+
+static std::vector<Anchor> _anchors(int w, int h)
+{
+    std::vector<Anchor> anchors;
+    const int strides[3] = {8, 16, 32};
+    int idx = 0;
+    for (int s : strides)
+    {
+        for (int y = 0; y < h / s; y++)
+        {
+            for (int x = 0; x < w / s; x++)
+                anchors.push_back(Anchor{idx++, x, y, s});
+        }
+    }
+    return anchors;
+}
+
+static int test_sigmoid()
+{
+    std::vector<float> src(1027);
+    _fill(src, -20, 20, 1);
+    src[0] = 0;
+    src[1] = -100;
+    src[2] = 100;
+    src[3] = -87.5f;
+    src[4] = 88.5f;
+    std::vector<float> dst(src.size());
+    nn::yolo::sigmoid(src.data(), dst.data(), (int)src.size());
+    float max_err = 0;
+    for (size_t i = 0; i < src.size(); i++)
+        max_err = std::max(max_err, fabsf(dst[i] - _sigmoid_ref(src[i])));
+    log::info("sigmoid: %d values, max error %e", (int)src.size(), max_err);
+    return max_err < 1e-6f ? 0 : 1;
+}
+
+// compare nn::yolo::filter_chw and filter_hwc with the scalar strided argmax of every anchor of YOLO decoders before
+static int test_filter(bool chw)
+{
+    const int anchor_num = 8400, class_num = 80, stride = chw ? anchor_num + 3 : class_num + 1;
+    std::vector<float> scores((size_t)(chw ? class_num : anchor_num) * stride);
+    std::mt19937 gen(7);
+    std::normal_distribution<float> dist(-6, 2);
+    for (auto &v : scores)
+        v = dist(gen);
+    // equal max scores, the first class is selected
+    scores[chw ? 5 * stride + 1 : stride + 5] = 10;
+    scores[chw ? 9 * stride + 1 : stride + 9] = 10;
+    float th = nn::yolo::logit(0.5f);
+    std::vector<int> anchors, class_ids;
+    std::vector<float> max_scores;
+    // old values are cleared
+    anchors.assign(3, -1);
+    if (chw)
+        nn::yolo::filter_chw(scores.data(), anchor_num, class_num, stride, th, anchors, class_ids, max_scores);
+    else
+        nn::yolo::filter_hwc(scores.data(), anchor_num, class_num, stride, th, anchors, class_ids, max_scores);
+    std::vector<int> ref_anchors, ref_class_ids;
+    std::vector<float> ref_scores;
+    for (int a = 0; a < anchor_num; a++)
+    {
+        int best = 0;
+        for (int c = 1; c < class_num; c++)
+        {
+            if (scores[chw ? (size_t)c * stride + a : (size_t)a * stride + c] > scores[chw ? (size_t)best * stride + a : (size_t)a * stride + best])
+                best = c;
+        }
+        float score = scores[chw ? (size_t)best * stride + a : (size_t)a * stride + best];
+        if (score > th)
+        {
+            ref_anchors.push_back(a);
+            ref_class_ids.push_back(best);
+            ref_scores.push_back(score);
+        }
+    }
+    bool same = anchors == ref_anchors && class_ids == ref_class_ids && max_scores == ref_scores;
+    log::info("filter %s: %d anchors, %d passed, reference %d passed, %s", chw ? "CHW" : "HWC", anchor_num,
+              (int)anchors.size(), (int)ref_anchors.size(), same ? "same" : "different");
+    return same ? 0 : 1;
+}
+
+// compare nn::yolo::dfl with the scalar softmax expectation of YOLO decoders before
+static int test_dfl()
+{
+    const int reg_max = 16, n = 100;
+    std::vector<float> src(reg_max * n);
+    _fill(src, -8, 8, 8);
+    float max_err = 0;
+    for (int step : {1, n})
+    {
+        for (int i = 0; i < n; i++)
+        {
+            const float *p = src.data() + (step == 1 ? i * reg_max : i);
+            float max_v = p[0];
+            for (int j = 1; j < reg_max; j++)
+                max_v = std::max(max_v, p[j * step]);
+            float sum = 0, res = 0;
+            for (int j = 0; j < reg_max; j++)
+            {
+                float e = expf(p[j * step] - max_v);
+                sum += e;
+                res += e * j;
+            }
+            max_err = std::max(max_err, fabsf(nn::yolo::dfl(p, reg_max, step) - res / sum));
+        }
+    }
+    log::info("dfl: max error %e", max_err);
+    return max_err < 1e-4f ? 0 : 1;
+}
+
+// compare nn::yolo::keypoints with the scalar decoding of YOLO11 _decode_keypoints
+static int test_keypoints(bool chw)
+{
+    const int keypoint_num = 17;
+    const float keypoint_th = 0.5f;
+    std::vector<Anchor> anchors = _anchors(320, 320);
+    int anchor_num = (int)anchors.size();
+    std::vector<float> data((size_t)anchor_num * keypoint_num * 3);
+    _fill(data, -2, 2, 2);
+    int channels = keypoint_num * 3;
+    int kp_step = chw ? 3 * anchor_num : 3;
+    int ch_step = chw ? anchor_num : 1;
+    float vis_th = nn::yolo::logit(keypoint_th);
+    std::vector<int> out(keypoint_num * 2);
+    int errors = 0, checked = 0, visible = 0;
+    for (const Anchor &a : anchors)
+    {
+        const float *p = data.data() + (chw ? a.idx : (size_t)a.idx * channels);
+        nn::yolo::keypoints(p, keypoint_num, kp_step, ch_step, a.x, a.y, a.stride, vis_th, out.data());
+        for (int k = 0; k < keypoint_num; k++)
+        {
+            const float *kp = p + (size_t)k * kp_step;
+            float score = _sigmoid_ref(kp[2 * ch_step]);
+            int x = -1, y = -1;
+            if (score > keypoint_th)
+            {
+                x = (kp[0] * 2.0 + a.x) * a.stride;
+                y = (kp[ch_step] * 2.0 + a.y) * a.stride;
+                ++visible;
+            }
+            ++checked;
+            // score at threshold may be rounded to the other side, float and double truncation may differ by 1
+            if (fabsf(score - keypoint_th) < 1e-6f)
+                continue;
+            if (abs(out[k * 2] - x) > 1 || abs(out[k * 2 + 1] - y) > 1 || (x < 0) != (out[k * 2] < 0))
+            {
+                if (errors++ < 5)
+                    log::error("keypoint %d of anchor %d: (%d, %d), expected (%d, %d)", k, a.idx, out[k * 2], out[k * 2 + 1], x, y);
+            }
+        }
+    }
+    log::info("keypoints %s: %d keypoints, %d visible, %d errors", chw ? "CHW" : "HWC", checked, visible, errors);
+    return errors;
+}
+
+// compare OBB angles decoded by nn::yolo::sigmoid with scalar decoding of YOLO11, and rotated box center of them
+static int test_obb_angle()
+{
+    std::vector<Anchor> anchors = _anchors(320, 320);
+    int anchor_num = (int)anchors.size();
+    std::vector<float> angle_raw(anchor_num), dis(anchor_num * 4);
+    _fill(angle_raw, -6, 6, 3);
+    _fill(dis, 0, 8, 4);
+    std::vector<float> angles(angle_raw);
+    nn::yolo::sigmoid(angles.data(), angles.data(), anchor_num);
+    float max_angle_err = 0, max_pos_err = 0;
+    for (const Anchor &a : anchors)
+    {
+        float ref = _sigmoid_ref(angle_raw[a.idx]) - 0.25f;
+        float angle = angles[a.idx] - 0.25f;
+        max_angle_err = std::max(max_angle_err, fabsf(angle - ref));
+        const float *d = dis.data() + a.idx * 4;
+        float xf = (d[2] - d[0]) / 2;
+        float yf = (d[3] - d[1]) / 2;
+        float x_ref = ((xf * cosf(ref * M_PI) - yf * sinf(ref * M_PI)) + a.x + 0.5f) * a.stride;
+        float y_ref = ((xf * sinf(ref * M_PI) + yf * cosf(ref * M_PI)) + a.y + 0.5f) * a.stride;
+        float x = ((xf * cosf(angle * M_PI) - yf * sinf(angle * M_PI)) + a.x + 0.5f) * a.stride;
+        float y = ((xf * sinf(angle * M_PI) + yf * cosf(angle * M_PI)) + a.y + 0.5f) * a.stride;
+        max_pos_err = std::max(max_pos_err, std::max(fabsf(x - x_ref), fabsf(y - y_ref)));
+    }
+    log::info("obb angle: %d anchors, max angle error %e, max center error %e pixel", anchor_num, max_angle_err, max_pos_err);
+    return (max_angle_err < 1e-6f && max_pos_err < 1e-3f) ? 0 : 1;
+}
+
+// compare nn::yolo::seg_logits and seg_mask with the scalar mask decoding of YOLO11 _decode_seg_points,
+// dot product of coefficients and prototypes of every pixel in box ROI, then sigmoid * 255, no resize
+static int test_seg(bool chw)
+{
+    const int mask_num = 32, proto_w = 40, proto_h = 40;
+    std::vector<float> protos((size_t)mask_num * proto_w * proto_h), coeffs(mask_num);
+    _fill(protos, -1, 1, 5);
+    _fill(coeffs, -1, 1, 6);
+    const int rois[][4] = {{0, 0, 40, 40}, {3, 5, 17, 9}, {20, 31, 1, 9}, {39, 0, 1, 1}};
+    int errors = 0;
+    float max_err = 0;
+    for (auto &roi : rois)
+    {
+        int x = roi[0], y = roi[1], w = roi[2], h = roi[3];
+        std::vector<float> logits(w * h), ref(w * h);
+        nn::yolo::seg_logits(protos.data(), proto_w, proto_h, mask_num, chw, coeffs.data(), 1, x, y, w, h, logits.data());
+        for (int j = 0; j < h; j++)
+        {
+            for (int i = 0; i < w; i++)
+            {
+                float sum = 0;
+                for (int n = 0; n < mask_num; n++)
+                {
+                    size_t idx = chw ? (size_t)n * proto_w * proto_h + (y + j) * proto_w + x + i
+                                     : ((size_t)(y + j) * proto_w + x + i) * mask_num + n;
+                    sum += coeffs[n] * protos[idx];
+                }
+                ref[j * w + i] = sum;
+                max_err = std::max(max_err, fabsf(logits[j * w + i] - sum));
+            }
+        }
+        // grayscale, same size
+        std::vector<uint8_t> gray(w * h);
+        nn::yolo::seg_mask(logits.data(), w, h, gray.data(), w, h);
+        for (int i = 0; i < w * h; i++)
+        {
+            if (abs(gray[i] - (int)(uint8_t)(_sigmoid_ref(ref[i]) * 255)) > 1)
+            {
+                if (errors++ < 5)
+                    log::error("seg gray pixel %d of roi (%d, %d, %d, %d): %d, expected %d", i, x, y, w, h, gray[i], (int)(uint8_t)(_sigmoid_ref(ref[i]) * 255));
+            }
+        }
+        // bitmap, upsampled 3x with nearest neighbor, row is padded to 32 bits
+        int dst_w = w * 3, dst_h = h * 3;
+        int row_bytes = (dst_w + 31) / 32 * 4;
+        std::vector<uint8_t> bits(row_bytes * dst_h);
+        nn::yolo::seg_mask(logits.data(), w, h, bits.data(), dst_w, dst_h, 0.5f);
+        for (int j = 0; j < dst_h; j++)
+        {
+            for (int i = 0; i < dst_w; i++)
+            {
+                float prob = _sigmoid_ref(ref[(j / 3) * w + i / 3]);
+                if (fabsf(prob - 0.5f) < 1e-5f)
+                    continue;
+                int bit = (bits[j * row_bytes + i / 8] >> (i % 8)) & 1;
+                if (bit != (prob > 0.5f))
+                {
+                    if (errors++ < 5)
+                        log::error("seg bitmap pixel (%d, %d) of roi (%d, %d, %d, %d): %d, prob %f", i, j, x, y, w, h, bit, prob);
+                }
+            }
+        }
+    }
+    log::info("seg %s: max logit error %e, %d errors", chw ? "CHW" : "HWC", max_err, errors);
+    return errors + (max_err < 1e-4f ? 0 : 1);
+}
+
+// source position of output pixel, nearest same as image::Image::resize, bilinear same as cv::resize INTER_LINEAR
+static void _map_ref(int i, int src, int dst, bool bilinear, int &p0, int &p1, double &f)
+{
+    double scale = (double)src / dst;
+    if (!bilinear)
+    {
+        p0 = p1 = std::min((int)floor(i * scale), src - 1);
+        f = 0;
+        return;
+    }
+    double v = std::max((i + 0.5) * scale - 0.5, 0.0);
+    p0 = std::min((int)v, src - 1);
+    p1 = std::min(p0 + 1, src - 1);
+    f = v - p0;
+}
+
+static int test_seg_resize()
+{
+    const int src_w = 13, src_h = 7;
+    const int sizes[][2] = {{13, 7}, {40, 21}, {5, 3}, {64, 1}};
+    std::vector<float> logits(src_w * src_h);
+    _fill(logits, -4, 4, 7);
+    int errors = 0;
+    for (auto &size : sizes)
+    {
+        int dst_w = size[0], dst_h = size[1];
+        int row_bytes = (dst_w + 31) / 32 * 4;
+        for (int bilinear = 0; bilinear < 2; bilinear++)
+        {
+            std::vector<uint8_t> gray(dst_w * dst_h), bits(row_bytes * dst_h);
+            nn::yolo::seg_mask(logits.data(), src_w, src_h, gray.data(), dst_w, dst_h, -1, bilinear);
+            nn::yolo::seg_mask(logits.data(), src_w, src_h, bits.data(), dst_w, dst_h, 0.3f, bilinear);
+            for (int j = 0; j < dst_h; j++)
+            {
+                int y0, y1, x0, x1;
+                double fy, fx;
+                _map_ref(j, src_h, dst_h, bilinear, y0, y1, fy);
+                for (int i = 0; i < dst_w; i++)
+                {
+                    _map_ref(i, src_w, dst_w, bilinear, x0, x1, fx);
+                    const float *r0 = logits.data() + y0 * src_w, *r1 = logits.data() + y1 * src_w;
+                    // grayscale interpolates probabilities, as resizing the sigmoid mask image
+                    double p00 = _sigmoid_ref(r0[x0]), p01 = _sigmoid_ref(r0[x1]), p10 = _sigmoid_ref(r1[x0]), p11 = _sigmoid_ref(r1[x1]);
+                    double top = p00 + (p01 - p00) * fx, bottom = p10 + (p11 - p10) * fx;
+                    int expected = (int)((top + (bottom - top) * fy) * 255);
+                    // bitmap interpolates logits and compares with logit of threshold
+                    double ltop = r0[x0] + (r0[x1] - r0[x0]) * fx, lbottom = r1[x0] + (r1[x1] - r1[x0]) * fx;
+                    double logit = ltop + (lbottom - ltop) * fy, th_logit = ::log(0.3 / 0.7);
+                    int bit = (bits[j * row_bytes + i / 8] >> (i % 8)) & 1;
+                    bool gray_ok = abs(gray[j * dst_w + i] - expected) <= 1;
+                    bool bit_ok = fabs(logit - th_logit) < 1e-4 || bit == (logit > th_logit);
+                    if ((!gray_ok || !bit_ok) && errors++ < 5)
+                        log::error("seg resize %dx%d %s pixel (%d, %d): gray %d expected %d, bit %d logit %f", dst_w, dst_h, bilinear ? "bilinear" : "nearest",
+                                   i, j, gray[j * dst_w + i], expected, bit, logit);
+                }
+            }
+        }
+    }
+    log::info("seg resize: %d errors", errors);
+    return errors;
+}
+
+int _main(int argc, char *argv[])
+{
+    int errors = 0;
+    errors += test_sigmoid();
+    errors += test_filter(true);
+    errors += test_filter(false);
+    errors += test_dfl();
+    errors += test_keypoints(true);
+    errors += test_keypoints(false);
+    errors += test_obb_angle();
+    errors += test_seg(true);
+    errors += test_seg(false);
+    errors += test_seg_resize();
+    if (errors)
+    {
+        log::error("yolo decoder test failed, %d errors", errors);
+        return 1;
+    }
+    log::info("yolo decoder test passed");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}